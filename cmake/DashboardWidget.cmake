@@ -94,6 +94,7 @@ function(add_dashboard_widget widget_name)
             config_codec   # config.h calls config_codec::limits from validate()
             qt_helpers     # several widget headers derive from CachedPaintWidget
             zenoh_pub_sub  # the widget header usually holds a subscription
+            dashboard_subscriptions  # ...which joins the per-key hub
             Qt6::Widgets   # the widget header is a QWidget subclass
             ${DW_PUBLIC_LIBS}
         PRIVATE
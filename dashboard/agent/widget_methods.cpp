@@ -1,6 +1,7 @@
 #include "dashboard/widget_methods.h"
 
 #include "config_codec/config_json.h"
+#include "dashboard/subscription_hub.h"
 #include "editor/widget_registry.h"
 
 #include <algorithm>
@@ -281,6 +282,35 @@ void registerWidgetMethods(AgentServer& server, ConfigApplier applier)
             return out;
         });
 
+    // --------------------------------------------------- widget.subscriptions
+    server.registerMethod(
+        "widget.subscriptions",
+        [](const json& /* params */) -> MethodResult
+        {
+            const SubscriptionHub::Stats stats = SubscriptionHub::instance().stats();
+
+            json keys = json::array();
+            for (const SubscriptionHub::KeyStats& key : stats.keys)
+            {
+                json entry = json::object();
+                entry["key"] = key.key;
+                entry["schemas"] = key.schemas;
+                entry["expressions"] = key.expressions;
+                entry["samples"] = key.samples;
+                keys.push_back(std::move(entry));
+            }
+
+            // The headline numbers first: the hub exists to make `subscriptions`
+            // smaller than `bindings`, and this is where that is visible.
+            json out = json::object();
+            out["bindings"] = stats.bindings;
+            out["subscriptions"] = stats.subscriptions;
+            out["subscriptions_saved"] = stats.subscriptions_saved;
+            out["decodes_saved"] = stats.decodes_saved;
+            out["keys"] = std::move(keys);
+            return out;
+        });
+
     // ------------------------------------------------------ widget.set_config
     if (applier)
     {
@@ -0,0 +1,265 @@
+#include "dashboard/subscription_hub.h"
+
+#include "pub_sub/expression_binding_list.h"
+#include "pub_sub/raw_subscriber.h"
+
+#include <reflection/reflection.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <utility>
+
+namespace dashboard {
+
+namespace
+{
+
+// One expression bound to a key, and where its value goes.
+//
+// Held by shared_ptr from the key's binding list and from whatever snapshot a
+// running callback loaded, so releasing it mid-sample is safe: the callback
+// finishes with the copy it already has.
+struct Binding
+{
+    SubscriptionHub::Handle handle = SubscriptionHub::kInvalidHandle;
+    pub_sub::schema_type_t schema_type{};
+    std::string expression;
+    SubscriptionHub::Sink sink;
+};
+
+// Every binding on a key, one evaluator set per schema among them -- the same
+// list scope's live source keeps, sinks in place of sample buffers.
+using BindingList = pub_sub::ExpressionBindingList<Binding>;
+
+// One zenoh subscription, plus everything bound to its key.
+struct KeySubscription
+{
+    // Copy-on-write, exactly as in scope's KeySubscription: the mutex covers a
+    // shared_ptr copy on the RX thread and an assignment on the GUI thread,
+    // never a decode.
+    mutable std::mutex bindings_mutex;
+    std::shared_ptr<const BindingList> bindings;
+
+    std::atomic<std::uint64_t> samples{0};
+
+    std::shared_ptr<const BindingList> snapshot() const
+    {
+        const std::lock_guard<std::mutex> guard(bindings_mutex);
+        return bindings;
+    }
+
+    void publish(std::shared_ptr<const BindingList> updated)
+    {
+        const std::lock_guard<std::mutex> guard(bindings_mutex);
+        bindings = std::move(updated);
+    }
+
+    // Declared last so it is destroyed FIRST: zenoh's undeclare joins in-flight
+    // callbacks, so once this is gone nothing can still be reading `bindings`.
+    std::unique_ptr<pub_sub::RawSubscriber> subscriber;
+};
+
+// Evaluates every group on the key against one sample and feeds the sinks.
+void deliver(const KeySubscription& subscription, std::span<const std::uint8_t> payload,
+             std::string_view schema_name)
+{
+    const std::shared_ptr<const BindingList> bindings = subscription.snapshot();
+    if (!bindings || bindings->empty())
+    {
+        return;
+    }
+
+    // nullopt means this sample was unusable for that expression, and the list
+    // skips it; its widget keeps showing the last good value.
+    bindings->evaluate(payload, schema_name,
+                       [](const Binding& binding, double value) { binding.sink(value); });
+}
+
+}  // namespace
+
+struct SubscriptionHub::Impl
+{
+    // std::map: the sample callback holds a pointer to the KeySubscription, so
+    // nodes must not move.
+    std::map<std::string, std::unique_ptr<KeySubscription>> by_key;
+
+    // Handle -> the key it was bound on, so release() knows where to look.
+    std::map<Handle, std::string> handle_keys;
+
+    Handle next_handle = 1;  // 0 is kInvalidHandle.
+
+    // The one subscription for this key, opening it if this is the first
+    // binding. Null when zenoh refused the key expression.
+    KeySubscription* ensureSubscription(const std::string& key);
+};
+
+SubscriptionHub& SubscriptionHub::instance()
+{
+    static SubscriptionHub* const hub = new SubscriptionHub;
+    return *hub;
+}
+
+SubscriptionHub::SubscriptionHub() : impl_(std::make_unique<Impl>())
+{
+}
+
+SubscriptionHub::~SubscriptionHub() = default;
+
+KeySubscription* SubscriptionHub::Impl::ensureSubscription(const std::string& key)
+{
+    auto found = by_key.find(key);
+    if (found != by_key.end())
+    {
+        return found->second.get();
+    }
+
+    auto subscription = std::make_unique<KeySubscription>();
+    subscription->publish(std::make_shared<const BindingList>());
+
+    KeySubscription* const raw = subscription.get();
+    subscription->subscriber = std::make_unique<pub_sub::RawSubscriber>(
+        key, [raw](std::span<const std::uint8_t> payload, std::string_view schema_name) {
+            raw->samples.fetch_add(1, std::memory_order_relaxed);
+            deliver(*raw, payload, schema_name);
+        });
+
+    if (!subscription->subscriber->isValid())
+    {
+        SPDLOG_ERROR("Failed to subscribe to '{}'.", key);
+        return nullptr;
+    }
+
+    return by_key.emplace(key, std::move(subscription)).first->second.get();
+}
+
+SubscriptionHub::Handle SubscriptionHub::bind(pub_sub::schema_type_t schema_type,
+                                              const std::string& expression,
+                                              const std::string& zenoh_key, Sink sink,
+                                              const std::string& log_context)
+{
+    if (zenoh_key.empty() || expression.empty() || !sink)
+    {
+        SPDLOG_ERROR("{}: refusing to bind with an empty key, expression or sink.", log_context);
+        return kInvalidHandle;
+    }
+
+    auto binding = std::make_shared<Binding>();
+    binding->handle = impl_->next_handle;
+    binding->schema_type = schema_type;
+    binding->expression = expression;
+    binding->sink = std::move(sink);
+
+    // Compiled into the key's sets BEFORE anything is subscribed, so a bad
+    // expression leaves no subscription behind.
+    std::vector<std::shared_ptr<Binding>> bindings;
+    const auto existing = impl_->by_key.find(zenoh_key);
+    if (existing != impl_->by_key.end())
+    {
+        bindings = existing->second->snapshot()->all();
+    }
+    bindings.push_back(binding);
+
+    std::shared_ptr<const BindingList> updated = BindingList::build(bindings, zenoh_key);
+    if (!updated)
+    {
+        return kInvalidHandle;
+    }
+
+    KeySubscription* const subscription = impl_->ensureSubscription(zenoh_key);
+    if (subscription == nullptr)
+    {
+        return kInvalidHandle;
+    }
+
+    ++impl_->next_handle;
+    subscription->publish(std::move(updated));
+    impl_->handle_keys.emplace(binding->handle, zenoh_key);
+
+    SPDLOG_DEBUG("{}: bound '{}' on '{}' ({}), {} binding(s) on the key.", log_context, expression,
+                 zenoh_key, reflection::enum_to_string(schema_type), bindings.size());
+    return binding->handle;
+}
+
+void SubscriptionHub::release(Handle handle)
+{
+    const auto entry = impl_->handle_keys.find(handle);
+    if (entry == impl_->handle_keys.end())
+    {
+        return;
+    }
+
+    const std::string key = entry->second;
+    impl_->handle_keys.erase(entry);
+
+    const auto found = impl_->by_key.find(key);
+    if (found == impl_->by_key.end())
+    {
+        return;
+    }
+
+    KeySubscription* const subscription = found->second.get();
+    std::vector<std::shared_ptr<Binding>> remaining = subscription->snapshot()->all();
+    remaining.erase(std::remove_if(remaining.begin(), remaining.end(),
+                                   [handle](const std::shared_ptr<Binding>& binding)
+                                   { return binding->handle == handle; }),
+                    remaining.end());
+
+    if (remaining.empty())
+    {
+        // Runs ~KeySubscription, which tears the subscriber down first and
+        // joins any callback still running.
+        impl_->by_key.erase(found);
+        return;
+    }
+
+    // Every survivor compiled when it was bound, so this recompiles what is
+    // known to compile.
+    if (std::shared_ptr<const BindingList> updated = BindingList::build(remaining, key))
+    {
+        subscription->publish(std::move(updated));
+    }
+}
+
+SubscriptionHub::Stats SubscriptionHub::stats() const
+{
+    Stats stats;
+    for (const auto& [key, subscription] : impl_->by_key)
+    {
+        const std::shared_ptr<const BindingList> bindings = subscription->snapshot();
+
+        KeyStats key_stats;
+        key_stats.key = key;
+        key_stats.samples = subscription->samples.load(std::memory_order_relaxed);
+
+        std::size_t on_key = 0;
+        for (const BindingList::Group& group : bindings->groups())
+        {
+            key_stats.schemas.emplace_back(reflection::enum_to_string(group.schema_type));
+            for (const std::shared_ptr<Binding>& binding : group.bindings)
+            {
+                key_stats.expressions.push_back(binding->expression);
+            }
+            on_key += group.bindings.size();
+        }
+
+        stats.bindings += on_key;
+        ++stats.subscriptions;
+
+        // A sample is decoded once per group, where it used to be once per
+        // binding. Approximate across rebinds -- the bindings counted are
+        // today's, the samples are since the key was subscribed -- which is
+        // fine for a number whose job is to show the order of magnitude.
+        stats.decodes_saved += key_stats.samples * (on_key - bindings->groups().size());
+        stats.keys.push_back(std::move(key_stats));
+    }
+    stats.subscriptions_saved = stats.bindings - stats.subscriptions;
+    return stats;
+}
+
+}  // namespace dashboard
@@ -0,0 +1,180 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//
+// The mailbox between a zenoh RX thread and the GUI: a reader never sees half a
+// store, never sees a value with another store's stamp, and never sees time go
+// backwards.
+//
+// A torn read here is not a crash. It is a gauge that shows a value for a frame
+// with the wrong staleness next to it, or a version that says nothing changed
+// when something did -- the kind of bug that only ever shows on the car. So the
+// threaded tests below hammer it with every value carrying its own check.
+//
+// No zenoh and no Qt here, so it runs everywhere and cannot skip itself.
+
+#include "dashboard/latest_value.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+int failures = 0;
+int checks = 0;
+
+void expect(bool condition, const std::string& what)
+{
+    ++checks;
+    if (!condition)
+    {
+        ++failures;
+        std::fprintf(stderr, "FAIL: %s\n", what.c_str());
+    }
+}
+
+using Clock = dashboard::LatestValue<double>::Clock;
+
+// A stamp a reader can check the value against: value i is stored at i ns.
+Clock::time_point stampFor(double value)
+{
+    return Clock::time_point(std::chrono::nanoseconds(static_cast<std::int64_t>(value)));
+}
+
+void testAnEmptyMailboxHasVersionZero()
+{
+    const dashboard::LatestValue<double> latest;
+    const auto snapshot = latest.load();
+    expect(snapshot.version == 0, "nothing stored is version 0");
+    expect(latest.version() == 0, "version() agrees with load() on an empty mailbox");
+    expect(snapshot.value == 0.0, "an empty mailbox holds the default value");
+}
+
+void testTheNewestStoreWins()
+{
+    dashboard::LatestValue<double> latest;
+    latest.store(1.0, stampFor(1.0));
+    latest.store(2.0, stampFor(2.0));
+    latest.store(3.0, stampFor(3.0));
+
+    const auto snapshot = latest.load();
+    expect(snapshot.value == 3.0, "the last value stored is the one read");
+    expect(snapshot.stamp == stampFor(3.0), "the stamp is the last value's, not an earlier one");
+    expect(snapshot.version == 3, "every store counts one version");
+}
+
+void testReadingDoesNotConsume()
+{
+    // The GUI keeps its own "delivered" version; a read must not reset the
+    // mailbox, or sinceLastSample() would go back to "never" after a frame.
+    dashboard::LatestValue<int> latest;
+    latest.store(42, Clock::now());
+    const auto first = latest.load();
+    const auto second = latest.load();
+    expect(first.version == second.version && second.value == 42,
+           "reading twice with nothing stored between sees the same value");
+}
+
+void testAReaderNeverSeesATornStore()
+{
+    constexpr int kTotal = 500000;
+    dashboard::LatestValue<double> latest;
+    std::atomic<bool> writer_done{false};
+
+    std::thread writer([&]() {
+        for (int i = 1; i <= kTotal; ++i)
+        {
+            const auto value = static_cast<double>(i);
+            latest.store(value, stampFor(value));
+        }
+        writer_done.store(true, std::memory_order_release);
+    });
+
+    bool paired = true;
+    bool monotonic = true;
+    std::uint64_t last_version = 0;
+    double last_value = 0.0;
+    int reads = 0;
+    while (!writer_done.load(std::memory_order_acquire))
+    {
+        const auto snapshot = latest.load();
+        ++reads;
+        if (snapshot.version == 0)
+        {
+            continue;
+        }
+        if (snapshot.stamp != stampFor(snapshot.value) ||
+            snapshot.version != static_cast<std::uint64_t>(snapshot.value))
+        {
+            paired = false;
+        }
+        if (snapshot.version < last_version || snapshot.value < last_value)
+        {
+            monotonic = false;
+        }
+        last_version = snapshot.version;
+        last_value = snapshot.value;
+    }
+    writer.join();
+
+    const auto last = latest.load();
+    expect(paired, "every value read comes with its own stamp and version");
+    expect(monotonic, "a reader never sees an older store after a newer one");
+    expect(last.value == kTotal && last.version == kTotal,
+           "the final store is visible once the writer is done");
+    expect(reads > 0, "the reader ran while the writer did");
+}
+
+void testTwoWritersNeverInterleave()
+{
+    // zenoh does not promise one RX thread per subscription, so two stores can
+    // race. Each writer's values carry their own stamp; a value from one with
+    // the other's stamp means the two interleaved inside the critical section.
+    constexpr int kEach = 200000;
+    dashboard::LatestValue<double> latest;
+    std::atomic<int> writers_done{0};
+
+    const auto write = [&](double offset) {
+        for (int i = 1; i <= kEach; ++i)
+        {
+            const double value = offset + static_cast<double>(i);
+            latest.store(value, stampFor(value));
+        }
+        writers_done.fetch_add(1, std::memory_order_release);
+    };
+    std::thread low(write, 0.0);
+    std::thread high(write, 1.0e7);
+
+    bool paired = true;
+    while (writers_done.load(std::memory_order_acquire) < 2)
+    {
+        const auto snapshot = latest.load();
+        if (snapshot.version != 0 && snapshot.stamp != stampFor(snapshot.value))
+        {
+            paired = false;
+        }
+    }
+    low.join();
+    high.join();
+
+    expect(paired, "two writers never leave one's value with the other's stamp");
+    expect(latest.version() == 2 * kEach, "no store from either writer is lost from the count");
+}
+
+}  // namespace
+
+int main()
+{
+    testAnEmptyMailboxHasVersionZero();
+    testTheNewestStoreWins();
+    testReadingDoesNotConsume();
+    testAReaderNeverSeesATornStore();
+    testTwoWritersNeverInterleave();
+
+    std::fprintf(stderr, "%d checks, %d failures\n", checks, failures);
+    return failures == 0 ? 0 : 1;
+}
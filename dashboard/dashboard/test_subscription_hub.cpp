@@ -0,0 +1,194 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//
+// The per-key hub every widget subscription goes through: several expressions
+// on one key are one zenoh subscription, each still gets its own value, and
+// the subscription goes away with the last of them.
+//
+// The claim that matters is the count. A hub that quietly opened a subscription
+// per binding would still deliver every value correctly -- it would just be the
+// old cost under a new name -- so the stats are asserted alongside the values.
+//
+// Binding opens a zenoh subscription, so this is a `net` test and skips itself
+// where no session can be opened.
+
+#include "dashboard/subscription_hub.h"
+
+#include "pub_sub/session_manager.h"
+#include "pub_sub/zenoh_publisher.h"
+
+#include "engine_rpm.capnp.h"
+
+#include <spdlog/spdlog.h>
+
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace
+{
+
+int failures = 0;
+int checks = 0;
+
+void expect(bool condition, const std::string& what)
+{
+    ++checks;
+    if (!condition)
+    {
+        ++failures;
+        std::fprintf(stderr, "FAIL: %s\n", what.c_str());
+    }
+}
+
+bool waitFor(const std::function<bool()>& predicate,
+             std::chrono::milliseconds timeout = std::chrono::milliseconds(5000))
+{
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+        if (predicate())
+        {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    return predicate();
+}
+
+// The latest value a sink was handed, NaN until it has been handed one.
+struct Latest
+{
+    std::shared_ptr<std::atomic<double>> value =
+        std::make_shared<std::atomic<double>>(std::nan(""));
+
+    dashboard::SubscriptionHub::Sink sink() const
+    {
+        return [value = value](double v) { value->store(v); };
+    }
+
+    bool is(double expected) const { return std::abs(value->load() - expected) < 1e-3; }
+};
+
+}  // namespace
+
+int main()
+{
+    spdlog::set_level(spdlog::level::off);
+
+    if (!pub_sub::SessionManager::getOrCreate())
+    {
+        std::fprintf(stderr, "WARNING: no zenoh session available; skipping.\n");
+        return 0;
+    }
+
+    // Per process, so two runs on one bus cannot feed each other.
+    const std::string prefix = "test/hub/" + std::to_string(::getpid());
+    const std::string rpm_key = prefix + "/rpm";
+    const std::string other_key = prefix + "/other";
+    const auto schema = pub_sub::schema_type_t::EngineRpm;
+
+    dashboard::SubscriptionHub hub;
+
+    // ------------------------------------------------------- one key, shared
+
+    Latest rpm;
+    Latest krpm;
+    Latest oil;
+    Latest elsewhere;
+    const auto h_rpm = hub.bind(schema, "rpm", rpm_key, rpm.sink(), "rpm");
+    const auto h_krpm = hub.bind(schema, "rpm / 1000.0", rpm_key, krpm.sink(), "krpm");
+    const auto h_oil = hub.bind(schema, "oilPressurePsi", rpm_key, oil.sink(), "oil");
+    const auto h_elsewhere = hub.bind(schema, "rpm", other_key, elsewhere.sink(), "other");
+
+    expect(h_rpm != dashboard::SubscriptionHub::kInvalidHandle &&
+               h_krpm != dashboard::SubscriptionHub::kInvalidHandle &&
+               h_oil != dashboard::SubscriptionHub::kInvalidHandle &&
+               h_elsewhere != dashboard::SubscriptionHub::kInvalidHandle,
+           "valid expressions bind");
+
+    auto stats = hub.stats();
+    expect(stats.bindings == 4, "four bindings are counted");
+    expect(stats.subscriptions == 2, "three bindings on one key share one subscription");
+    expect(stats.subscriptions_saved == 2, "the saving is reported");
+
+    // -------------------------------------------------- a bad binding is a no
+
+    Latest never;
+    expect(hub.bind(schema, "no_such_field", rpm_key, never.sink(), "bad") ==
+               dashboard::SubscriptionHub::kInvalidHandle,
+           "an expression over a field the schema lacks is refused");
+    expect(hub.bind(schema, "no_such_field", prefix + "/fresh", never.sink(), "bad") ==
+               dashboard::SubscriptionHub::kInvalidHandle,
+           "and refused on a fresh key too");
+    stats = hub.stats();
+    expect(stats.bindings == 4 && stats.subscriptions == 2,
+           "a refused binding leaves no binding and no subscription behind");
+
+    // ----------------------------------------------- every binding its value
+
+    {
+        pub_sub::ZenohPublisher<EngineRpm> publisher(rpm_key);
+        expect(publisher.isValid(), "the publisher came up");
+
+        // zenoh keeps nothing for a late subscriber, so publish until it lands.
+        expect(waitFor([&] {
+                   publisher.fields().setRpm(4500);
+                   publisher.fields().setOilPressurePsi(55.5f);
+                   publisher.put();
+                   return rpm.is(4500.0) && krpm.is(4.5) && oil.is(55.5);
+               }),
+               "each expression on the shared key gets its own value from one sample");
+        expect(std::isnan(elsewhere.value->load()),
+               "a binding on another key sees nothing published here");
+
+        stats = hub.stats();
+        bool counted = false;
+        for (const auto& key : stats.keys)
+        {
+            if (key.key == rpm_key)
+            {
+                counted = key.samples > 0 && key.expressions.size() == 3 &&
+                          key.schemas.size() == 1 && key.schemas.front() == "EngineRpm";
+            }
+        }
+        expect(counted, "the key's stats list its expressions, its schema and its samples");
+        expect(stats.decodes_saved >= 2, "two decodes are saved on every sample of the key");
+
+        // ------------------------------------------------------ release
+
+        hub.release(h_krpm);
+        stats = hub.stats();
+        expect(stats.bindings == 3 && stats.subscriptions == 2,
+               "releasing one of several bindings keeps the key subscribed");
+
+        expect(waitFor([&] {
+                   publisher.fields().setRpm(6100);
+                   publisher.put();
+                   return rpm.is(6100.0);
+               }),
+               "the survivors keep receiving after a release");
+        expect(krpm.is(4.5), "a released binding receives nothing more");
+    }
+
+    hub.release(h_rpm);
+    hub.release(h_oil);
+    stats = hub.stats();
+    expect(stats.subscriptions == 1 && stats.bindings == 1,
+           "releasing the last binding on a key drops its subscription");
+
+    hub.release(h_elsewhere);
+    hub.release(h_elsewhere);
+    stats = hub.stats();
+    expect(stats.subscriptions == 0 && stats.bindings == 0,
+           "an empty hub holds nothing, and a second release is harmless");
+
+    std::fprintf(stderr, "%d checks, %d failures\n", checks, failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -1,40 +1,40 @@
 #ifndef DASHBOARD_EXPRESSION_SUBSCRIPTION_H_
 #define DASHBOARD_EXPRESSION_SUBSCRIPTION_H_
 
+#include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <functional>
 #include <memory>
-#include <mutex>
 #include <optional>
 #include <string>
+#include <type_traits>
 #include <utility>
 
-#include <QObject>
-#include <QTimer>
+#include <QWidget>
 
 #include <spdlog/spdlog.h>
 
-// The lean header, not pub_sub/zenoh_subscriber.h: this is what every widget
-// reaches the bus through, so what it drags in is paid for across the whole
-// dashboard. ZenohTypedSubscriber lives in the other one and needs capnp in its
-// header; nothing here does.
-#include "pub_sub/expression_subscriber.h"
+#include "dashboard/frame_scheduler.h"
+#include "dashboard/latest_value.h"
+#include "dashboard/subscription_hub.h"
+// For convertResult() only. Lean: exprtk and capnp are behind its Impl, and
+// this is what every widget reaches the bus through, so what it drags in is
+// paid for across the whole dashboard.
+#include "pub_sub/expression_evaluator.h"
 #include "reflection/reflection.h"
 
 namespace dashboard {
 
-// How often a subscription hands its latest value to the GUI. A gauge cannot
-// show more than the display refresh, so ~60 Hz is the most that can possibly
-// be useful; anything faster is work nobody sees.
-inline constexpr std::chrono::milliseconds kDeliveryInterval{16};
-
 // A zenoh expression subscription whose samples are *coalesced* before they
 // reach the widget.
 //
-// The zenoh thread writes each evaluated value into a one-slot mailbox; a
-// GUI-thread timer takes whatever is in the slot and delivers it. A value that
-// is overwritten before the next tick is simply never shown, which is the
-// correct thing to do with a stale reading.
+// The zenoh thread writes each evaluated value into a one-slot mailbox; the
+// window's next frame takes whatever is in the slot and delivers it. A value
+// that is overwritten before then is simply never shown, which is the correct
+// thing to do with a stale reading. When the frame comes is FrameScheduler's
+// business: once per display refresh, for every subscription in the window at
+// once, and not at all while nothing arrives.
 //
 // The old shape posted one QMetaCallEvent per sample, per subscription, with no
 // bound and no coalescing. That is fine while the GUI keeps up and unbounded
@@ -45,39 +45,69 @@ inline constexpr std::chrono::milliseconds kDeliveryInterval{16};
 // Bounding the queue at one entry per subscription makes the failure mode
 // "drops old readings", which is what a gauge wants.
 //
-// Not copyable or movable: the zenoh callback captures `this`, so the address
-// has to stay put. Construct it through makeExpressionSubscription().
+// The bus side is SubscriptionHub's: every subscription on a key shares one
+// zenoh subscription and one decode per sample, so four widgets showing engine
+// speed cost what one did.
+//
+// Construct and destroy it on the GUI thread. Not copyable or movable, since
+// the frame scheduler's drain captures `this`. Construct it through
+// makeExpressionSubscription().
 template <typename T>
 class ExpressionSubscription
 {
   public:
+    // `owner` is the widget `deliver` draws into; its window's frame is when
+    // values are delivered. Null delivers as soon as the GUI thread gets to it.
+    // `log_context` names the widget in anything logged.
     ExpressionSubscription(pub_sub::schema_type_t schema_type,
                            const std::string& expression,
                            const std::string& zenoh_key,
                            std::function<void(T)> deliver,
-                           std::chrono::milliseconds interval = kDeliveryInterval)
-        : deliver_{std::move(deliver)}
+                           QWidget* owner = nullptr,
+                           std::string log_context = {})
+        : deliver_{std::move(deliver)},
+          scheduler_{FrameScheduler::instance()},
+          mailbox_{std::make_shared<Mailbox>()}
     {
-        subscriber_ = std::make_unique<pub_sub::ZenohExpressionSubscriber>(schema_type, expression, zenoh_key);
-        if (!subscriber_->isValid())
+        mailbox_->log_context = log_context.empty() ? zenoh_key : std::move(log_context);
+        mailbox_->expression = expression;
+
+        // Runs on the zenoh RX thread. Two stores and a flag: no lock, no
+        // allocation, and no Qt call except the one event per frame that
+        // wake() posts for every subscription together.
+        //
+        // It owns what it writes to, rather than reaching through `this`: the
+        // hub may still be running it for a moment after release() -- see
+        // SubscriptionHub::Sink -- and by then this object may be gone.
+        FrameScheduler* const scheduler = &scheduler_;
+        handle_ = SubscriptionHub::instance().bind(
+            schema_type, expression, zenoh_key,
+            [mailbox = mailbox_, scheduler](double result)
+            {
+                const std::optional<T> value = pub_sub::convertResult<T>(result);
+                if (!value)
+                {
+                    mailbox->warnOutOfRange(result);
+                    return;
+                }
+                mailbox->latest.store(*value, LatestValue<T>::Clock::now());
+                scheduler->wake();
+            },
+            mailbox_->log_context);
+
+        if (isValid())
         {
-            return;
+            frame_id_ = scheduler_.add(owner, [this]() { drain(); });
         }
+    }
 
-        // Runs on the zenoh RX thread. It takes a short mutex and nothing else:
-        // no allocation, no Qt call, no event posted.
-        subscriber_->setResultCallback<T>([this](T value)
+    ~ExpressionSubscription()
+    {
+        SubscriptionHub::instance().release(handle_);
+        if (frame_id_)
         {
-            const std::lock_guard<std::mutex> lock(mutex_);
-            pending_ = value;
-            last_sample_ = std::chrono::steady_clock::now();
-        });
-
-        // The timer is a plain member, so it belongs to the thread that
-        // constructed this -- the GUI thread -- and it is also the connection's
-        // context object, so the connection dies with it.
-        QObject::connect(&timer_, &QTimer::timeout, &timer_, [this]() { drain(); });
-        timer_.start(interval);
+            scheduler_.remove(*frame_id_);
+        }
     }
 
     ExpressionSubscription(const ExpressionSubscription&) = delete;
@@ -85,7 +115,9 @@ class ExpressionSubscription
     ExpressionSubscription(ExpressionSubscription&&) = delete;
     ExpressionSubscription& operator=(ExpressionSubscription&&) = delete;
 
-    bool isValid() const { return subscriber_ && subscriber_->isValid(); }
+    // False when the expression did not compile against the schema or the key
+    // could not be subscribed; the hub has logged which.
+    bool isValid() const { return handle_ != SubscriptionHub::kInvalidHandle; }
 
     // How long since this subscription last produced a usable value, or nullopt
     // if it never has.
@@ -102,41 +134,57 @@ class ExpressionSubscription
     // adding the streams, not baked in here.
     std::optional<std::chrono::steady_clock::duration> sinceLastSample() const
     {
-        const std::lock_guard<std::mutex> lock(mutex_);
-        if (!last_sample_)
+        const auto latest = mailbox_->latest.load();
+        if (latest.version == 0)
         {
             return std::nullopt;
         }
-        return std::chrono::steady_clock::now() - *last_sample_;
+        return std::chrono::steady_clock::now() - latest.stamp;
     }
 
   private:
-    void drain()
+    // Everything the RX thread writes, shared with the hub's sink.
+    struct Mailbox
     {
-        std::optional<T> value;
+        LatestValue<T> latest;
+        std::string log_context;
+        std::string expression;
+        std::atomic<bool> range_warned{false};
+
+        // Latched, as ExpressionEvaluator's is: a value that does not fit T
+        // tends to keep not fitting, at the sample rate.
+        void warnOutOfRange(double value)
         {
-            const std::lock_guard<std::mutex> lock(mutex_);
-            value.swap(pending_);
+            if (range_warned.exchange(true, std::memory_order_relaxed))
+            {
+                return;
+            }
+            SPDLOG_WARN("{}: expression '{}' produced {}, which does not fit the configured type; "
+                        "ignoring these samples (further occurrences not logged).",
+                        log_context, expression, value);
         }
+    };
 
-        // Nothing arrived since the last tick: an idle subscription costs a
-        // mutex acquire and no repaint.
-        if (value)
+    void drain()
+    {
+        // Nothing arrived since the last frame: an idle subscription costs one
+        // atomic load and no repaint.
+        if (mailbox_->latest.version() == delivered_version_)
         {
-            deliver_(*value);
+            return;
         }
+
+        const auto latest = mailbox_->latest.load();
+        delivered_version_ = latest.version;
+        deliver_(latest.value);
     }
 
-    mutable std::mutex mutex_;
-    std::optional<T> pending_;
-    std::optional<std::chrono::steady_clock::time_point> last_sample_;
     std::function<void(T)> deliver_;
-    QTimer timer_;
-
-    // Declared last so it is destroyed FIRST. zenoh's undeclare joins in-flight
-    // callbacks, so by the time the members above are destroyed no callback can
-    // still be writing to them.
-    std::unique_ptr<pub_sub::ZenohExpressionSubscriber> subscriber_;
+    FrameScheduler& scheduler_;
+    std::shared_ptr<Mailbox> mailbox_;
+    std::uint64_t delivered_version_ = 0;  // GUI thread only.
+    SubscriptionHub::Handle handle_ = SubscriptionHub::kInvalidHandle;
+    std::optional<FrameScheduler::Id> frame_id_;
 };
 
 template <typename T>
@@ -156,12 +204,21 @@ ExpressionSubscriptionPtr<T> makeExpressionSubscription(
     Setter setter,
     const char* log_context)
 {
+    // Paced by the receiver's window when the receiver is a widget, which is
+    // every receiver in the tree today.
+    QWidget* owner = nullptr;
+    if constexpr (std::is_base_of_v<QWidget, Receiver>)
+    {
+        owner = receiver;
+    }
+
     ExpressionSubscriptionPtr<T> subscription;
     try
     {
         subscription = std::make_unique<ExpressionSubscription<T>>(
             schema_type, expression, zenoh_key,
-            [receiver, setter](T value) { std::invoke(setter, receiver, value); });
+            [receiver, setter](T value) { std::invoke(setter, receiver, value); }, owner,
+            log_context);
     }
     catch (const std::exception& e)
     {
@@ -0,0 +1,198 @@
+#ifndef DASHBOARD_FRAME_SCHEDULER_H_
+#define DASHBOARD_FRAME_SCHEDULER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include <QEvent>
+#include <QMetaObject>
+#include <QObject>
+#include <QPointer>
+#include <QWidget>
+#include <QWindow>
+
+namespace dashboard {
+
+// Hands every subscription's latest value to the GUI once per displayed frame,
+// all of a window's subscriptions in one pass.
+//
+// WHY. Each ExpressionSubscription used to own a 16 ms QTimer. Thirty widgets
+// meant thirty timers, each waking the GUI thread on its own schedule, none of
+// them in step with the display: a gauge updated just after a vsync waited a
+// whole frame to be seen, its neighbour updated just before did not, and the
+// panel moved unevenly even when every signal was smooth. On the embedded
+// target each of those wakeups is also CPU that a static dashboard should not
+// be spending.
+//
+// HOW. A subscription registers a drain with the widget that shows it. When a
+// sample arrives the RX thread calls wake(), which posts at most one event to
+// the GUI thread no matter how many samples or subscriptions are behind it.
+// That event asks each window with a registered widget for its next frame via
+// QWindow::requestUpdate(), which the platform paces to the display's refresh
+// -- the vsync on eglfs, a refresh-rate timer elsewhere. When the window's
+// UpdateRequest arrives every drain for that window runs, back to back, and
+// the update() calls they make land in the same backing-store sync, so the
+// window repaints once with every widget current.
+//
+// The UpdateRequest is watched, not taken: the filter returns false and Qt's
+// own handling of it goes ahead as before.
+//
+// A widget with no window to pace against -- not yet shown, hidden, or not a
+// widget at all -- is drained straight from the posted event instead, which is
+// no worse than the timer was.
+//
+// An idle dashboard costs nothing: no timers at all, and no event until a
+// sample arrives.
+//
+// GUI thread only, except wake().
+class FrameScheduler : public QObject
+{
+  public:
+    using Id = std::uint64_t;
+
+    // The scheduler for this process, made on first use. Never destroyed: a
+    // subscription's RX thread may call wake() until that subscription is gone,
+    // and nothing orders the last of those against static destruction.
+    static FrameScheduler& instance()
+    {
+        static FrameScheduler* const scheduler = new FrameScheduler;
+        return *scheduler;
+    }
+
+    // `drain` runs on the GUI thread, in `owner`'s window's frame, whenever
+    // wake() has been called since. It must be cheap when nothing has arrived:
+    // every drain for the window runs, not only those whose value changed.
+    // `owner` may be null.
+    Id add(QWidget* owner, std::function<void()> drain)
+    {
+        const Id id = next_id_++;
+        entries_.emplace(id, Entry{owner, std::move(drain)});
+        return id;
+    }
+
+    // After this returns the drain will not run again.
+    void remove(Id id) { entries_.erase(id); }
+
+    // Any thread. Something has been stored that a drain should pick up.
+    void wake()
+    {
+        if (!wake_posted_.exchange(true, std::memory_order_acq_rel))
+        {
+            QMetaObject::invokeMethod(this, [this]() { requestFrames(); }, Qt::QueuedConnection);
+        }
+    }
+
+    std::size_t size() const { return entries_.size(); }
+
+  protected:
+    bool eventFilter(QObject* watched, QEvent* event) override
+    {
+        if (event->type() == QEvent::UpdateRequest)
+        {
+            drainWindow(static_cast<QWindow*>(watched));
+        }
+        return false;
+    }
+
+  private:
+    struct Entry
+    {
+        QPointer<QWidget> owner;
+        std::function<void()> drain;
+    };
+
+    FrameScheduler() = default;
+
+    // The window whose frame `entry` is drained in, or null to drain now.
+    static QWindow* paceableWindow(const Entry& entry)
+    {
+        if (entry.owner.isNull())
+        {
+            return nullptr;
+        }
+        QWindow* window = entry.owner->window()->windowHandle();
+        return window != nullptr && window->isExposed() ? window : nullptr;
+    }
+
+    void requestFrames()
+    {
+        // Cleared before anything is looked at, so a sample stored from here on
+        // posts again rather than being left for a frame nobody asked for.
+        wake_posted_.store(false, std::memory_order_release);
+
+        std::set<QWindow*> windows;
+        std::vector<Id> now;
+        for (const auto& [id, entry] : entries_)
+        {
+            if (QWindow* window = paceableWindow(entry))
+            {
+                windows.insert(window);
+            }
+            else
+            {
+                now.push_back(id);
+            }
+        }
+
+        for (QWindow* window : windows)
+        {
+            watch(window);
+            window->requestUpdate();
+        }
+        run(now);
+    }
+
+    void drainWindow(QWindow* window)
+    {
+        std::vector<Id> due;
+        for (const auto& [id, entry] : entries_)
+        {
+            if (paceableWindow(entry) == window)
+            {
+                due.push_back(id);
+            }
+        }
+        run(due);
+    }
+
+    // By id, looked up again for each: a drain delivers into a widget, and
+    // nothing stops a widget from tearing down a subscription in its setter.
+    void run(const std::vector<Id>& ids)
+    {
+        for (const Id id : ids)
+        {
+            const auto it = entries_.find(id);
+            if (it != entries_.end())
+            {
+                it->second.drain();
+            }
+        }
+    }
+
+    void watch(QWindow* window)
+    {
+        if (!watched_.insert(window).second)
+        {
+            return;
+        }
+        window->installEventFilter(this);
+        // A later window could be allocated at the same address.
+        QObject::connect(window, &QObject::destroyed, this,
+                         [this, window]() { watched_.erase(window); });
+    }
+
+    std::map<Id, Entry> entries_;
+    Id next_id_ = 1;
+    std::set<QWindow*> watched_;
+    std::atomic<bool> wake_posted_{false};
+};
+
+}  // namespace dashboard
+
+#endif  // DASHBOARD_FRAME_SCHEDULER_H_
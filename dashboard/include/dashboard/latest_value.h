@@ -0,0 +1,127 @@
+#ifndef DASHBOARD_LATEST_VALUE_H_
+#define DASHBOARD_LATEST_VALUE_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <type_traits>
+
+namespace dashboard {
+
+// A one-value mailbox between the thread samples arrive on and the GUI thread,
+// as a seqlock: the writer bumps a sequence number to odd, stores, and bumps it
+// back to even; a reader retries until it sees the same even number on both
+// sides of its loads.
+//
+// WHY NOT A MUTEX. It used to be one, held for a store on the zenoh RX thread
+// and for a swap on the GUI thread. Short, but still a lock the GUI can hold
+// while the bus waits, and with every widget on one frame clock the GUI takes
+// all of them back to back at the top of each frame -- exactly when the bus is
+// most likely to be mid-store. Here the reader never writes anything the writer
+// looks at, so a GUI thread stalled mid-read costs the bus nothing.
+//
+// WHY NOT A QUEUE. The GUI wants the newest reading and nothing else; a value
+// overwritten before the next frame is a stale reading nobody should see.
+//
+// The value and its stamp are read together, so sinceLastSample() can never
+// pair a new value with the previous sample's time. Each is its own relaxed
+// atomic rather than plain memory: a reader that overlaps a store and then
+// retries is still a data race on plain members, even if it throws the result
+// away.
+//
+// More than one writer is allowed -- zenoh does not promise one RX thread per
+// subscription -- at the cost of a compare-exchange instead of a store.
+template <typename T>
+class LatestValue
+{
+    static_assert(std::is_trivially_copyable_v<T>, "the value is copied out under a retry loop");
+    static_assert(std::atomic<T>::is_always_lock_free,
+                  "a locking atomic would put the mutex back on the RX thread");
+
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Snapshot
+    {
+        T value{};
+        Clock::time_point stamp{};
+
+        // How many values have been stored; 0 means none ever has, and `value`
+        // is the default. Compare two snapshots' versions to tell whether
+        // anything arrived in between.
+        std::uint64_t version = 0;
+    };
+
+    LatestValue() = default;
+
+    LatestValue(const LatestValue&) = delete;
+    LatestValue& operator=(const LatestValue&) = delete;
+
+    // Any thread. Never blocks on a reader; waits only for another writer's
+    // two stores.
+    void store(T value, Clock::time_point stamp)
+    {
+        std::uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            if ((sequence & 1u) != 0u)
+            {
+                sequence = sequence_.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (sequence_.compare_exchange_weak(sequence, sequence + 1,
+                                                std::memory_order_acquire,
+                                                std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+
+        // Orders the odd sequence number before the stores below, so a reader
+        // that sees any of them also sees the sequence it must retry on.
+        std::atomic_thread_fence(std::memory_order_release);
+        value_.store(value, std::memory_order_relaxed);
+        stamp_.store(stamp.time_since_epoch().count(), std::memory_order_relaxed);
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+    // Any thread. Never blocks the writer; retries while one is mid-store.
+    Snapshot load() const
+    {
+        for (;;)
+        {
+            const std::uint64_t before = sequence_.load(std::memory_order_acquire);
+            if ((before & 1u) != 0u)
+            {
+                continue;
+            }
+
+            Snapshot snapshot;
+            snapshot.value = value_.load(std::memory_order_relaxed);
+            snapshot.stamp =
+                Clock::time_point(Clock::duration(stamp_.load(std::memory_order_relaxed)));
+
+            // Orders the loads above before the re-check, so a store that
+            // overlapped them is seen as a changed sequence number.
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == before)
+            {
+                snapshot.version = before / 2;
+                return snapshot;
+            }
+        }
+    }
+
+    // Any thread. Cheaper than load() when only "has anything arrived" matters.
+    std::uint64_t version() const { return sequence_.load(std::memory_order_acquire) / 2; }
+
+  private:
+    // Even when quiescent, odd while a store is in progress.
+    std::atomic<std::uint64_t> sequence_{0};
+    std::atomic<T> value_{};
+    std::atomic<Clock::rep> stamp_{0};
+};
+
+}  // namespace dashboard
+
+#endif  // DASHBOARD_LATEST_VALUE_H_
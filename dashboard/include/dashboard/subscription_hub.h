@@ -0,0 +1,107 @@
+#ifndef DASHBOARD_SUBSCRIPTION_HUB_H_
+#define DASHBOARD_SUBSCRIPTION_HUB_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "pub_sub/schema_registry.h"
+
+namespace dashboard {
+
+// Every widget's expression subscriptions, multiplexed onto one zenoh
+// subscription per key.
+//
+// Each ExpressionSubscription used to own a ZenohExpressionSubscriber, so a key
+// bound by a tachometer, a sparkline, a value readout and a shift light was four
+// subscriptions, four copies of every sample off the wire and four capnp decodes
+// of the same bytes. Here the key is subscribed once with a pub_sub::RawSubscriber
+// and every expression bound to it, grouped by the schema it decodes against,
+// is evaluated by one ExpressionEvaluatorSet -- one decode per sample per
+// schema, whatever the number of widgets.
+//
+// The same shape as scope's LiveZenohSource, for the same reasons: the binding
+// list is rebuilt whole on bind and release and swapped in under a mutex held
+// for one pointer copy, so the RX thread never waits on a GUI-thread compile
+// and never sees a half-edited list. A rebuild recompiles every set on the key,
+// which the dashboard pays once per widget at startup and not per sample.
+//
+// GUI thread only, bind() and release() included. Sinks run on the RX thread.
+class SubscriptionHub
+{
+  public:
+    using Handle = std::uint64_t;
+    static constexpr Handle kInvalidHandle = 0;
+
+    // Runs on a zenoh RX thread, once per sample that produced a usable number.
+    // Must not block and must not throw. It may still be running briefly after
+    // release() returns -- anything it touches should be owned by the sink.
+    using Sink = std::function<void(double)>;
+
+    // What the hub is doing, for agent_control's widget.subscriptions.
+    struct KeyStats
+    {
+        std::string key;
+
+        // Registry names, one per group; more than one is a config mistake the
+        // sets will have logged.
+        std::vector<std::string> schemas;
+
+        std::vector<std::string> expressions;
+
+        // Samples delivered on this key since it was subscribed.
+        std::uint64_t samples = 0;
+    };
+
+    struct Stats
+    {
+        std::size_t bindings = 0;
+
+        // Zenoh subscriptions actually declared: one per key.
+        std::size_t subscriptions = 0;
+
+        // What one subscription per binding would have declared on top.
+        std::size_t subscriptions_saved = 0;
+
+        // Capnp decodes not done because bindings share a key and schema,
+        // counted from each key's samples since it was subscribed.
+        std::uint64_t decodes_saved = 0;
+
+        std::vector<KeyStats> keys;
+    };
+
+    // Made on first use and never destroyed, for the reason FrameScheduler
+    // gives: teardown order against static destruction is nobody's to promise.
+    static SubscriptionHub& instance();
+
+    SubscriptionHub();
+    ~SubscriptionHub();
+
+    SubscriptionHub(const SubscriptionHub&) = delete;
+    SubscriptionHub& operator=(const SubscriptionHub&) = delete;
+
+    // Compiles `expression` against `schema_type` alongside everything already
+    // on `zenoh_key`, then joins -- or opens -- the key's subscription.
+    // kInvalidHandle, with the reason logged under `log_context`, when the
+    // expression does not compile or the key cannot be subscribed; nothing is
+    // left subscribed on its behalf.
+    Handle bind(pub_sub::schema_type_t schema_type, const std::string& expression,
+                const std::string& zenoh_key, Sink sink, const std::string& log_context);
+
+    // The last release on a key drops its subscription, joining any callback
+    // still running. Unknown handles are ignored.
+    void release(Handle handle);
+
+    Stats stats() const;
+
+  private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace dashboard
+
+#endif  // DASHBOARD_SUBSCRIPTION_HUB_H_
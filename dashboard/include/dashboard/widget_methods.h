@@ -23,8 +23,9 @@ namespace dashboard::agent
 // UNSUPPORTED_IN_APP error rather than a silent no-op.
 using ConfigApplier = std::function<bool(QWidget* target, const widget_config_t& config)>;
 
-// Registers widget.describe_config, widget.get_config and widget.set_config.
-// Pass a null applier to register the two read-only methods only.
+// Registers widget.describe_config, widget.get_config, widget.set_config and
+// widget.subscriptions -- what the per-key SubscriptionHub is sharing. Pass a
+// null applier to register the read-only methods only.
 void registerWidgetMethods(agent_control::AgentServer& server, ConfigApplier applier);
 
 // Resolves an addressed widget to the dashboard widget carrying the config.
@@ -0,0 +1,728 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "map/disk_tile_cache.h"
+
+#include "config_codec/config_json.h"
+
+#include <spdlog/spdlog.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <functional>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace map_widget
+{
+namespace
+{
+
+// "MTIL" read as a little-endian word. A file from a big-endian machine fails
+// this check rather than loading byte-swapped.
+constexpr std::uint32_t kMagic = 0x4c49544dU;
+
+constexpr const char* kExtension = ".mtile";
+constexpr const char* kTemporary = ".tmp";
+
+// What a file costs against the budget. Rounded up to a block, because that is
+// what it costs the filesystem: an absent tile is a header of a couple of
+// hundred bytes and still takes a whole block, and there are a lot of them.
+constexpr std::uint64_t kBlock = 4096;
+
+std::uint64_t onDisk(std::uint64_t size)
+{
+    return ((size + kBlock - 1) / kBlock) * kBlock;
+}
+
+// The fixed part of every file. Written and read as raw bytes, so every field
+// is fixed-width and the struct has no padding the compiler chose.
+struct Header
+{
+    std::uint32_t magic { kMagic };
+    std::uint32_t version { DiskTileCache::kFormatVersion };
+    std::uint64_t styleHash { 0 };
+    std::uint32_t x { 0 };
+    std::uint32_t y { 0 };
+    std::uint8_t z { 0 };
+    std::uint8_t absent { 0 };
+    // Which form the geometry sections are in -- see TileGeometry::packed.
+    // Both flags rather than one, because a tile past 65 536 vertices packs
+    // its vertices and keeps 32-bit indices.
+    std::uint8_t packedVertices { 0 };
+    std::uint8_t shortIndices { 0 };
+    std::uint32_t vertexCount { 0 };
+    std::uint32_t indexCount { 0 };
+    std::uint32_t roadCount { 0 };
+    std::uint32_t labelCount { 0 };
+    // UTF-16 code units across every label's text.
+    std::uint32_t textUnits { 0 };
+    std::array<std::uint32_t, kMapLayerCount + 1> layerStart {};
+    std::array<std::uint32_t, kMapLayerCount + 1> layerIndexStart {};
+};
+static_assert(std::is_trivially_copyable_v<Header>);
+static_assert(sizeof(Header) % 8 == 0, "sections after the header must stay 8-aligned");
+
+// LabelCandidate without the QString: the text lives in one UTF-16 section at
+// the end of the file, and this says where.
+struct DiskLabel
+{
+    double x { 0.0 };
+    double y { 0.0 };
+    double spanLocal { 0.0 };
+    std::int32_t priority { 0 };
+    std::uint32_t magnitude { 0 };
+    std::uint32_t textOffset { 0 };
+    std::uint32_t textLength { 0 };
+    std::uint8_t kind { 0 };
+    std::uint8_t oneLabelPerName { 0 };
+    std::array<std::uint8_t, 6> reserved {};
+};
+static_assert(std::is_trivially_copyable_v<DiskLabel>);
+static_assert(sizeof(DiskLabel) == 48);
+
+static_assert(std::is_trivially_copyable_v<MapVertex>);
+static_assert(std::is_trivially_copyable_v<PackedVertex>);
+static_assert(std::is_trivially_copyable_v<FeatureRange>);
+static_assert(sizeof(FeatureRange) == 16, "FeatureRange is written as it is laid out");
+
+constexpr std::size_t align8(std::size_t offset)
+{
+    return (offset + 7) & ~std::size_t(7);
+}
+
+// Where each section starts, from the header's counts alone. The writer and
+// the reader both go through this, so they cannot disagree about the layout.
+struct Layout
+{
+    std::size_t vertices { 0 };
+    std::size_t indices { 0 };
+    std::size_t roads { 0 };
+    std::size_t labels { 0 };
+    std::size_t text { 0 };
+    std::size_t total { 0 };
+};
+
+Layout layoutFor(const Header& header)
+{
+    Layout layout;
+    const std::size_t vertexSize =
+        header.packedVertices != 0 ? sizeof(PackedVertex) : sizeof(MapVertex);
+    const std::size_t indexSize =
+        header.shortIndices != 0 ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+    layout.vertices = sizeof(Header);
+    layout.indices = align8(layout.vertices + (std::size_t(header.vertexCount) * vertexSize));
+    layout.roads = align8(layout.indices + (std::size_t(header.indexCount) * indexSize));
+    layout.labels = align8(layout.roads + (std::size_t(header.roadCount) * sizeof(FeatureRange)));
+    layout.text = align8(layout.labels + (std::size_t(header.labelCount) * sizeof(DiskLabel)));
+    layout.total = layout.text + (std::size_t(header.textUnits) * sizeof(char16_t));
+    return layout;
+}
+
+// Tileset names come from a layout file and become a directory. Anything that
+// could climb out of the root, or mean something to a shell, is escaped as `_`
+// and two hex digits -- '_' itself included, so the mapping is one-to-one: "a.b"
+// is "a_2eb" and "a_b" is "a_5fb". Replacing them all with '_' gave those two
+// one directory, and since nothing on a load says which tileset a file came
+// from, each drew the other's tiles. The empty name is "_", which no escape can
+// produce.
+std::string safeName(const std::string& tileset)
+{
+    if (tileset.empty())
+    {
+        return "_";
+    }
+    static constexpr char kDigits[] = "0123456789abcdef";
+    std::string out;
+    out.reserve(tileset.size());
+    for (const char c : tileset)
+    {
+        const bool plain =
+            (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-';
+        if (plain)
+        {
+            out += c;
+            continue;
+        }
+        const auto byte = static_cast<std::uint8_t>(c);
+        out += '_';
+        out += kDigits[byte >> 4];
+        out += kDigits[byte & 0xf];
+    }
+    return out;
+}
+
+std::string hex(std::uint64_t value)
+{
+    static constexpr char kDigits[] = "0123456789abcdef";
+    std::string out(16, '0');
+    for (int i = 15; i >= 0; --i)
+    {
+        out[static_cast<std::size_t>(i)] = kDigits[value & 0xf];
+        value >>= 4;
+    }
+    return out;
+}
+
+// A read-only mapping of one file, unmapped on the way out.
+class Mapping
+{
+  public:
+    explicit Mapping(const std::filesystem::path& path)
+    {
+        mFd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (mFd < 0)
+        {
+            return;
+        }
+        struct stat info {};
+        if (::fstat(mFd, &info) != 0 || info.st_size <= 0)
+        {
+            return;
+        }
+        mSize = static_cast<std::size_t>(info.st_size);
+        void* at = ::mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, mFd, 0);
+        if (at == MAP_FAILED)
+        {
+            mSize = 0;
+            return;
+        }
+        mData = static_cast<const std::uint8_t*>(at);
+    }
+
+    ~Mapping()
+    {
+        if (mData != nullptr)
+        {
+            ::munmap(const_cast<std::uint8_t*>(mData), mSize);
+        }
+        if (mFd >= 0)
+        {
+            ::close(mFd);
+        }
+    }
+
+    Mapping(const Mapping&) = delete;
+    Mapping& operator=(const Mapping&) = delete;
+
+    bool opened() const { return mFd >= 0; }
+    const std::uint8_t* data() const { return mData; }
+    std::size_t size() const { return mSize; }
+
+    // Marks the file as just used, which is what the budget's LRU runs on. The
+    // modification time rather than the access time, because relatime and
+    // noatime mounts -- the default on anything with flash -- do not keep the
+    // latter.
+    void touch() const
+    {
+        if (mFd >= 0)
+        {
+            ::futimens(mFd, nullptr);
+        }
+    }
+
+  private:
+    int mFd { -1 };
+    const std::uint8_t* mData { nullptr };
+    std::size_t mSize { 0 };
+};
+
+template <typename T>
+void copySection(const std::uint8_t* base, std::size_t offset, std::uint32_t count,
+                 std::vector<T>& out)
+{
+    out.resize(count);
+    if (count != 0)
+    {
+        std::memcpy(out.data(), base + offset, std::size_t(count) * sizeof(T));
+    }
+}
+
+// The inverse, and as careful about an empty vector: its data() may be null,
+// and memcpy from null is undefined even for zero bytes.
+template <typename T>
+void writeSection(std::uint8_t* at, const std::vector<T>& from)
+{
+    if (!from.empty())
+    {
+        std::memcpy(at, from.data(), from.size() * sizeof(T));
+    }
+}
+
+// The checks that stand between a damaged file and the GPU. Every one of them
+// is about something that would otherwise be an out-of-bounds read on the
+// upload or the draw -- not about whether the triangles look right.
+template <typename Index>
+bool tablesAgree(const Header& header, const std::vector<Index>& indices,
+                 const std::vector<FeatureRange>& roads)
+{
+    if (header.layerStart.front() != 0 || header.layerIndexStart.front() != 0 ||
+        header.layerStart.back() != header.vertexCount ||
+        header.layerIndexStart.back() != header.indexCount)
+    {
+        return false;
+    }
+    for (std::size_t i = 0; i < kMapLayerCount; ++i)
+    {
+        if (header.layerStart[i] > header.layerStart[i + 1] ||
+            header.layerIndexStart[i] > header.layerIndexStart[i + 1])
+        {
+            return false;
+        }
+    }
+    const bool indicesInRange = std::all_of(indices.begin(), indices.end(), [&](Index i) {
+        return std::uint32_t(i) < header.vertexCount;
+    });
+    if (!indicesInRange)
+    {
+        return false;
+    }
+    return std::all_of(roads.begin(), roads.end(), [&](const FeatureRange& range) {
+        return std::uint64_t(range.indexStart) + range.indexCount <= header.indexCount;
+    });
+}
+
+std::vector<std::uint8_t> serialise(const Header& header, const TileGeometry* geometry,
+                                    const LabelSet* labels)
+{
+    const Layout layout = layoutFor(header);
+    std::vector<std::uint8_t> out(layout.total, 0);
+    std::memcpy(out.data(), &header, sizeof(Header));
+
+    if (geometry != nullptr)
+    {
+        // Whichever form is live; the other is empty, and the header's flags
+        // say which one this is.
+        writeSection(out.data() + layout.vertices, geometry->vertices);
+        writeSection(out.data() + layout.vertices, geometry->packed);
+        writeSection(out.data() + layout.indices, geometry->indices);
+        writeSection(out.data() + layout.indices, geometry->indices16);
+        writeSection(out.data() + layout.roads, geometry->roads);
+    }
+
+    if (labels != nullptr)
+    {
+        std::uint32_t text = 0;
+        for (std::size_t i = 0; i < labels->size(); ++i)
+        {
+            const LabelCandidate& candidate = (*labels)[i];
+            DiskLabel label;
+            label.x = candidate.x;
+            label.y = candidate.y;
+            label.spanLocal = candidate.spanLocal;
+            label.priority = candidate.priority;
+            label.magnitude = candidate.magnitude;
+            label.textOffset = text;
+            label.textLength = static_cast<std::uint32_t>(candidate.text.size());
+            label.kind = static_cast<std::uint8_t>(candidate.kind);
+            label.oneLabelPerName = candidate.oneLabelPerName ? 1 : 0;
+            std::memcpy(out.data() + layout.labels + (i * sizeof(DiskLabel)), &label,
+                        sizeof(DiskLabel));
+            std::memcpy(out.data() + layout.text + (std::size_t(text) * sizeof(char16_t)),
+                        candidate.text.constData(),
+                        std::size_t(label.textLength) * sizeof(char16_t));
+            text += label.textLength;
+        }
+    }
+
+    return out;
+}
+
+// Write `bytes` to `path` through a temporary in the same directory, so the
+// rename that publishes it is atomic. The temporary's name carries the thread,
+// because two workers can tessellate the same tile at once when a batch is
+// re-requested after a timeout.
+//
+// The rename is atomic for readers, but not against a power cut on its own: a
+// filesystem may commit the rename before the data it points at, and a car's
+// supply does get cut mid-write. So the temporary is flushed before it is
+// renamed, and the directory after, which is what lets the header promise a
+// stray temporary rather than a torn tile. Both fsyncs are paid on a decode
+// worker, once per tile tessellated -- not on a load.
+bool writeAtomically(const std::filesystem::path& path, const std::vector<std::uint8_t>& bytes)
+{
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+    if (error)
+    {
+        return false;
+    }
+
+    std::filesystem::path temporary = path;
+    temporary += "." + hex(std::hash<std::thread::id> {}(std::this_thread::get_id())) + kTemporary;
+
+    const int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        return false;
+    }
+    std::size_t written = 0;
+    while (written < bytes.size())
+    {
+        const ssize_t n = ::write(fd, bytes.data() + written, bytes.size() - written);
+        if (n <= 0)
+        {
+            break;
+        }
+        written += static_cast<std::size_t>(n);
+    }
+    const bool complete = written == bytes.size() && ::fsync(fd) == 0;
+    ::close(fd);
+
+    if (!complete || std::rename(temporary.c_str(), path.c_str()) != 0)
+    {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+
+    // The tile is in place either way; what this decides is whether it is
+    // still there after a power cut. Reported as a failed write if not, so the
+    // counter says the directory is not keeping what it is given.
+    const int directory = ::open(path.parent_path().c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (directory < 0)
+    {
+        return false;
+    }
+    const bool durable = ::fsync(directory) == 0;
+    ::close(directory);
+    return durable;
+}
+
+} // namespace
+
+std::uint64_t styleHash(const MapStyle_t& style)
+{
+    // FNV-1a over the style's JSON, which is the reflected struct field by
+    // field -- every field, including ones added after this was written.
+    const std::string text = config_codec::toJson(style).dump();
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const char c : text)
+    {
+        hash ^= static_cast<std::uint8_t>(c);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+DiskTileCache::DiskTileCache(std::filesystem::path root, std::uint64_t maxBytes,
+                             std::uint64_t styleHash) :
+    mRoot(std::move(root)),
+    mMaxBytes(maxBytes),
+    mStyleHash(styleHash)
+{
+    std::error_code error;
+    std::filesystem::create_directories(mRoot, error);
+    if (error)
+    {
+        SPDLOG_WARN("[map] disk tile cache {}: {}", mRoot.string(), error.message());
+        return;
+    }
+
+    std::uint64_t bytes = 0;
+    for (auto it = std::filesystem::recursive_directory_iterator(mRoot, error);
+         !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+    {
+        if (!it->is_regular_file(error))
+        {
+            continue;
+        }
+        if (it->path().extension() == kTemporary)
+        {
+            std::filesystem::remove(it->path(), error);
+            continue;
+        }
+        if (it->path().extension() == kExtension)
+        {
+            bytes += onDisk(it->file_size(error));
+        }
+    }
+    mBytes.store(bytes);
+
+    if (bytes > mMaxBytes)
+    {
+        prune();
+    }
+}
+
+std::filesystem::path DiskTileCache::pathFor(const std::string& tileset, const TileId& id) const
+{
+    return mRoot / safeName(tileset) / hex(mStyleHash) / std::to_string(id.z) /
+           std::to_string(id.x) / (std::to_string(id.y) + kExtension);
+}
+
+std::optional<DiskTileCache::Hit> DiskTileCache::load(const std::string& tileset,
+                                                      const TileId& id)
+{
+    const std::filesystem::path path = pathFor(tileset, id);
+    const Mapping mapping(path);
+    if (!mapping.opened())
+    {
+        mMisses.fetch_add(1, std::memory_order_relaxed);
+        return std::nullopt;
+    }
+
+    const auto reject = [&](const char* why) -> std::optional<Hit> {
+        SPDLOG_WARN("[map] disk tile cache: dropping {}: {}", path.string(), why);
+        std::error_code error;
+        const std::uint64_t size = std::filesystem::file_size(path, error);
+        if (!error && std::filesystem::remove(path, error))
+        {
+            mBytes.fetch_sub(std::min(mBytes.load(), onDisk(size)));
+        }
+        mRejected.fetch_add(1, std::memory_order_relaxed);
+        mMisses.fetch_add(1, std::memory_order_relaxed);
+        return std::nullopt;
+    };
+
+    if (mapping.data() == nullptr || mapping.size() < sizeof(Header))
+    {
+        return reject("shorter than its header");
+    }
+
+    Header header;
+    std::memcpy(&header, mapping.data(), sizeof(Header));
+    if (header.magic != kMagic || header.version != kFormatVersion)
+    {
+        return reject("written by a different format version");
+    }
+    // Cannot happen through pathFor(), which puts both in the path -- but a
+    // file copied in by hand would be drawn in the wrong place without it.
+    if (header.styleHash != mStyleHash || header.z != id.z || header.x != id.x ||
+        header.y != id.y)
+    {
+        return reject("header names a different tile or style");
+    }
+    const Layout layout = layoutFor(header);
+    if (layout.total != mapping.size())
+    {
+        return reject("size does not match its counts");
+    }
+
+    const std::uint8_t* base = mapping.data();
+
+    auto geometry = std::make_shared<TileGeometry>();
+    auto labels = std::make_shared<LabelSet>();
+
+    if (header.absent == 0)
+    {
+        if (header.packedVertices != 0)
+        {
+            copySection(base, layout.vertices, header.vertexCount, geometry->packed);
+            // A paint past the palette's ceiling would index past the end of
+            // the renderer's uniform array.
+            const bool paintsInRange = std::all_of(
+                geometry->packed.begin(), geometry->packed.end(),
+                [](const PackedVertex& v) { return (v.attributes >> 24) < kMaxPaints; });
+            if (!paintsInRange)
+            {
+                return reject("paint out of range");
+            }
+        }
+        else
+        {
+            copySection(base, layout.vertices, header.vertexCount, geometry->vertices);
+        }
+        if (header.shortIndices != 0)
+        {
+            copySection(base, layout.indices, header.indexCount, geometry->indices16);
+        }
+        else
+        {
+            copySection(base, layout.indices, header.indexCount, geometry->indices);
+        }
+        copySection(base, layout.roads, header.roadCount, geometry->roads);
+        geometry->layerStart = header.layerStart;
+        geometry->layerIndexStart = header.layerIndexStart;
+        const bool agree = header.shortIndices != 0
+                               ? tablesAgree(header, geometry->indices16, geometry->roads)
+                               : tablesAgree(header, geometry->indices, geometry->roads);
+        if (!agree)
+        {
+            return reject("layer table or indices out of range");
+        }
+
+        labels->reserve(header.labelCount);
+        const auto* text = reinterpret_cast<const QChar*>(base + layout.text);
+        for (std::uint32_t i = 0; i < header.labelCount; ++i)
+        {
+            DiskLabel label;
+            std::memcpy(&label, base + layout.labels + (std::size_t(i) * sizeof(DiskLabel)),
+                        sizeof(DiskLabel));
+            if (std::uint64_t(label.textOffset) + label.textLength > header.textUnits ||
+                label.kind > static_cast<std::uint8_t>(LabelKind::Road))
+            {
+                return reject("label out of range");
+            }
+            LabelCandidate candidate;
+            candidate.text = QString(text + label.textOffset, qsizetype(label.textLength));
+            candidate.x = label.x;
+            candidate.y = label.y;
+            candidate.spanLocal = label.spanLocal;
+            candidate.priority = label.priority;
+            candidate.magnitude = label.magnitude;
+            candidate.kind = static_cast<LabelKind>(label.kind);
+            candidate.oneLabelPerName = label.oneLabelPerName != 0;
+            labels->push_back(std::move(candidate));
+        }
+    }
+
+    mapping.touch();
+    mHits.fetch_add(1, std::memory_order_relaxed);
+    return Hit { CachedTile { std::move(labels), std::move(geometry) }, header.absent != 0 };
+}
+
+bool DiskTileCache::store(const std::string& tileset, const TileId& id, const CachedTile& tile,
+                          bool absent)
+{
+    const TileGeometry* geometry = absent ? nullptr : tile.geometry.get();
+    const LabelSet* labels = absent ? nullptr : tile.labels.get();
+    if (!absent && geometry == nullptr)
+    {
+        return false;
+    }
+
+    Header header;
+    header.styleHash = mStyleHash;
+    header.z = id.z;
+    header.x = id.x;
+    header.y = id.y;
+    header.absent = absent ? 1 : 0;
+    if (geometry != nullptr)
+    {
+        header.vertexCount = static_cast<std::uint32_t>(geometry->vertexCount());
+        header.indexCount = static_cast<std::uint32_t>(geometry->indexCount());
+        header.packedVertices = geometry->isPacked() ? 1 : 0;
+        header.shortIndices = geometry->indices16.empty() ? 0 : 1;
+        header.roadCount = static_cast<std::uint32_t>(geometry->roads.size());
+        header.layerStart = geometry->layerStart;
+        header.layerIndexStart = geometry->layerIndexStart;
+    }
+    if (labels != nullptr)
+    {
+        header.labelCount = static_cast<std::uint32_t>(labels->size());
+        for (const LabelCandidate& candidate : *labels)
+        {
+            header.textUnits += static_cast<std::uint32_t>(candidate.text.size());
+        }
+    }
+
+    const std::filesystem::path path = pathFor(tileset, id);
+    std::error_code error;
+    const std::uint64_t replaced = std::filesystem::exists(path, error)
+                                       ? onDisk(std::filesystem::file_size(path, error))
+                                       : 0;
+
+    const std::vector<std::uint8_t> bytes = serialise(header, geometry, labels);
+    if (!writeAtomically(path, bytes))
+    {
+        // Once per failure is too loud for a full disk, which fails every
+        // write; the counter says how many, the first says why.
+        if (mWriteFailures.fetch_add(1, std::memory_order_relaxed) == 0)
+        {
+            SPDLOG_WARN("[map] disk tile cache: could not write {}", path.string());
+        }
+        return false;
+    }
+    mWrites.fetch_add(1, std::memory_order_relaxed);
+
+    // Approximate under concurrent writers, which is fine for a budget; prune()
+    // walks the directory and replaces it with the real figure.
+    mBytes.fetch_add(onDisk(bytes.size()));
+    mBytes.fetch_sub(std::min(mBytes.load(), replaced));
+    if (mBytes.load() > mMaxBytes)
+    {
+        prune();
+    }
+    return true;
+}
+
+void DiskTileCache::prune()
+{
+    const std::unique_lock<std::mutex> lock(mPruneMutex, std::try_to_lock);
+    if (!lock.owns_lock())
+    {
+        return;
+    }
+
+    struct File
+    {
+        std::filesystem::path path;
+        std::filesystem::file_time_type used;
+        std::uint64_t bytes { 0 };
+    };
+    std::vector<File> files;
+    std::uint64_t total = 0;
+
+    std::error_code error;
+    for (auto it = std::filesystem::recursive_directory_iterator(mRoot, error);
+         !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+    {
+        if (!it->is_regular_file(error) || it->path().extension() != kExtension)
+        {
+            continue;
+        }
+        File file { it->path(), it->last_write_time(error), onDisk(it->file_size(error)) };
+        total += file.bytes;
+        files.push_back(std::move(file));
+    }
+
+    std::sort(files.begin(), files.end(),
+              [](const File& a, const File& b) { return a.used < b.used; });
+
+    const std::uint64_t target = mMaxBytes - (mMaxBytes / 4);
+    for (const File& file : files)
+    {
+        if (total <= target)
+        {
+            break;
+        }
+        if (std::filesystem::remove(file.path, error))
+        {
+            total -= file.bytes;
+            mPruned.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // The walk is the truth; what the counter drifted to in between is not.
+    mBytes.store(total);
+}
+
+void DiskTileCache::clear(const std::string& tileset)
+{
+    std::error_code error;
+    std::filesystem::remove_all(mRoot / safeName(tileset), error);
+
+    std::uint64_t total = 0;
+    for (auto it = std::filesystem::recursive_directory_iterator(mRoot, error);
+         !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+    {
+        if (it->is_regular_file(error) && it->path().extension() == kExtension)
+        {
+            total += onDisk(it->file_size(error));
+        }
+    }
+    mBytes.store(total);
+}
+
+DiskTileCacheStats DiskTileCache::stats() const
+{
+    DiskTileCacheStats out;
+    out.hits = mHits.load(std::memory_order_relaxed);
+    out.misses = mMisses.load(std::memory_order_relaxed);
+    out.rejected = mRejected.load(std::memory_order_relaxed);
+    out.writes = mWrites.load(std::memory_order_relaxed);
+    out.writeFailures = mWriteFailures.load(std::memory_order_relaxed);
+    out.pruned = mPruned.load(std::memory_order_relaxed);
+    out.bytes = mBytes.load();
+    out.maxBytes = mMaxBytes;
+    return out;
+}
+
+} // namespace map_widget
@@ -23,6 +23,8 @@
 #include "mapFrag_qsb.h"
 #include "mapHighlightVert_qsb.h"
 #include "mapHighlightFrag_qsb.h"
+#include "mapPackedVert_qsb.h"
+#include "mapHighlightPackedVert_qsb.h"
 
 namespace map_widget
 {
@@ -34,6 +36,10 @@ namespace
 // the 64 KB uniform buffer limit the stricter backends impose.
 constexpr quint32 kUniformBlockSize = 96;
 
+// map_packed.vert's `paints` block: a vec4 colour per paint, then the widths
+// four to a vec4. std140 would pad a float[64] out to a vec4 per element.
+constexpr quint32 kPaletteBlockSize = quint32((kMaxPaints + (kMaxPaints / 4)) * 4 * sizeof(float));
+
 // Refuse absurd viewports rather than trying to allocate for them.
 constexpr int kMaxDimension = 8192;
 
@@ -182,14 +188,31 @@ bool GpuRenderer::initialise()
         return false;
     }
 
-    mSrb.reset(mRhi->newShaderResourceBindings());
+    mPaletteBuffer.reset(mRhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer,
+                                         kPaletteBlockSize));
+    if (!mPaletteBuffer->create())
+    {
+        SPDLOG_ERROR("[map] GPU palette buffer could not be created");
+        return false;
+    }
+
     // Dynamic offset: one uniform block per TILE, selected per draw call. The
     // alternative -- a matrix per vertex, or one buffer per tile -- is either
     // more bandwidth or more objects for the same result.
-    mSrb->setBindings({ QRhiShaderResourceBinding::uniformBufferWithDynamicOffset(
-        0, QRhiShaderResourceBinding::VertexStage | QRhiShaderResourceBinding::FragmentStage,
-        mUniformBuffer.get(), kUniformBlockSize) });
-    if (!mSrb->create())
+    const QRhiShaderResourceBinding perTile =
+        QRhiShaderResourceBinding::uniformBufferWithDynamicOffset(
+            0, QRhiShaderResourceBinding::VertexStage | QRhiShaderResourceBinding::FragmentStage,
+            mUniformBuffer.get(), kUniformBlockSize);
+
+    mSrb.reset(mRhi->newShaderResourceBindings());
+    mSrb->setBindings({ perTile });
+    // The packed pipelines add the palette, which is one block for the whole
+    // frame -- it is the style, not the tile.
+    mPackedSrb.reset(mRhi->newShaderResourceBindings());
+    mPackedSrb->setBindings({ perTile, QRhiShaderResourceBinding::uniformBuffer(
+                                           1, QRhiShaderResourceBinding::VertexStage,
+                                           mPaletteBuffer.get()) });
+    if (!mSrb->create() || !mPackedSrb->create())
     {
         SPDLOG_ERROR("[map] GPU shader resource bindings could not be created");
         return false;
@@ -220,6 +243,8 @@ bool GpuRenderer::ensureTarget(const QSize& size)
     // descriptor, which references the target.
     mPipeline.reset();
     mHighlightPipeline.reset();
+    mPackedPipeline.reset();
+    mPackedHighlightPipeline.reset();
     mTarget.reset();
     mPass.reset();
     mResolve.reset();
@@ -277,11 +302,19 @@ bool GpuRenderer::ensureTarget(const QSize& size)
         { 0, 3, QRhiVertexInputAttribute::Float4, offsetof(MapVertex, r) },
     });
 
-    // Both pipelines are the same in everything but their shader stages: same
-    // blend, same vertex buffer, same shader resource bindings, and no culling
-    // -- MVT ring winding says exterior-or-hole, not front-or-back, and earcut
-    // emits whatever order the ear clipping produced.
-    const auto makePipeline = [&](QShader vert, QShader frag) {
+    // Both words of a PackedVertex as one integer attribute; the shader does
+    // the unpacking. See map_packed.vert for why not a format per field.
+    QRhiVertexInputLayout packedLayout;
+    packedLayout.setBindings({ { sizeof(PackedVertex) } });
+    packedLayout.setAttributes({ { 0, 0, QRhiVertexInputAttribute::UInt2, 0 } });
+
+    // Every pipeline is the same in everything but its shader stages and the
+    // vertex format those read: same blend, no culling -- MVT ring winding
+    // says exterior-or-hole, not front-or-back, and earcut emits whatever
+    // order the ear clipping produced.
+    const auto makePipeline = [&](QShader vert, QShader frag,
+                                  const QRhiVertexInputLayout& inputLayout,
+                                  QRhiShaderResourceBindings* bindings) {
         std::unique_ptr<QRhiGraphicsPipeline> pipeline(mRhi->newGraphicsPipeline());
         pipeline->setTargetBlends({ blend });
         pipeline->setTopology(QRhiGraphicsPipeline::Triangles);
@@ -289,8 +322,8 @@ bool GpuRenderer::ensureTarget(const QSize& size)
         pipeline->setSampleCount(mSampleCount);
         pipeline->setShaderStages({ { QRhiShaderStage::Vertex, std::move(vert) },
                                     { QRhiShaderStage::Fragment, std::move(frag) } });
-        pipeline->setVertexInputLayout(layout);
-        pipeline->setShaderResourceBindings(mSrb.get());
+        pipeline->setVertexInputLayout(inputLayout);
+        pipeline->setShaderResourceBindings(bindings);
         pipeline->setRenderPassDescriptor(mPass.get());
         if (!pipeline->create())
         {
@@ -300,7 +333,8 @@ bool GpuRenderer::ensureTarget(const QSize& size)
     };
 
     mPipeline = makePipeline(loadShader(map_shaders::mapVert, map_shaders::mapVertSize),
-                             loadShader(map_shaders::mapFrag, map_shaders::mapFragSize));
+                             loadShader(map_shaders::mapFrag, map_shaders::mapFragSize), layout,
+                             mSrb.get());
     if (!mPipeline)
     {
         SPDLOG_ERROR("[map] GPU pipeline could not be created");
@@ -313,13 +347,30 @@ bool GpuRenderer::ensureTarget(const QSize& size)
     // the same per-tile uniform slot as the base pass.
     mHighlightPipeline =
         makePipeline(loadShader(map_shaders::mapHighlightVert, map_shaders::mapHighlightVertSize),
-                     loadShader(map_shaders::mapHighlightFrag, map_shaders::mapHighlightFragSize));
+                     loadShader(map_shaders::mapHighlightFrag, map_shaders::mapHighlightFragSize),
+                     layout, mSrb.get());
     if (!mHighlightPipeline)
     {
         SPDLOG_ERROR("[map] GPU highlight pipeline could not be created");
         return false;
     }
 
+    // The same two again for PackedVertex. Same fragment stages: the packing
+    // is entirely a vertex-stage matter.
+    mPackedPipeline =
+        makePipeline(loadShader(map_shaders::mapPackedVert, map_shaders::mapPackedVertSize),
+                     loadShader(map_shaders::mapFrag, map_shaders::mapFragSize), packedLayout,
+                     mPackedSrb.get());
+    mPackedHighlightPipeline = makePipeline(
+        loadShader(map_shaders::mapHighlightPackedVert, map_shaders::mapHighlightPackedVertSize),
+        loadShader(map_shaders::mapHighlightFrag, map_shaders::mapHighlightFragSize),
+        packedLayout, mPackedSrb.get());
+    if (!mPackedPipeline || !mPackedHighlightPipeline)
+    {
+        SPDLOG_ERROR("[map] GPU packed-vertex pipelines could not be created");
+        return false;
+    }
+
     mSize = size;
     return true;
 }
@@ -350,9 +401,7 @@ bool GpuRenderer::batchesChanged(std::span<const GpuBatch> batches) const
     return false;
 }
 
-bool GpuRenderer::prepareUpload(std::span<const GpuBatch> batches,
-                                std::vector<MapVertex>& flat,
-                                std::vector<std::uint32_t>& flatIndices)
+bool GpuRenderer::prepareUpload(std::span<const GpuBatch> batches, const PaintPalette& palette)
 {
     mTileBaseVertex.clear();
     mTileBaseIndex.clear();
@@ -361,6 +410,13 @@ bool GpuRenderer::prepareUpload(std::span<const GpuBatch> batches,
 
     std::uint32_t total = 0;
     std::uint32_t totalIndices = 0;
+    // One format per frame, because one frame is one vertex buffer and one
+    // pipeline per pass. Packed unless some tile is not -- a tile that would
+    // not pack, or geometry built by hand -- in which case the packed tiles
+    // are unpacked on the way up rather than the frame drawn twice over.
+    // Tiles with nothing in them have no say.
+    bool packed = true;
+    bool shortIndices = true;
     for (const GpuBatch& batch : batches)
     {
         mTileBaseVertex.push_back(total);
@@ -370,22 +426,28 @@ bool GpuRenderer::prepareUpload(std::span<const GpuBatch> batches,
         // Null is a normal state -- a tile that has been asked for but has not
         // arrived. It still takes a slot, so the base-vertex and uniform indices
         // stay aligned with `batches`.
-        total += batch.geometry
-                     ? static_cast<std::uint32_t>(batch.geometry->vertices.size())
-                     : 0U;
-        totalIndices += batch.geometry
-                            ? static_cast<std::uint32_t>(batch.geometry->indices.size())
-                            : 0U;
+        if (!batch.geometry)
+        {
+            continue;
+        }
+        const TileGeometry& geometry = *batch.geometry;
+        total += static_cast<std::uint32_t>(geometry.vertexCount());
+        totalIndices += static_cast<std::uint32_t>(geometry.indexCount());
+        packed = packed && (geometry.vertexCount() == 0 || geometry.isPacked());
+        shortIndices = shortIndices && geometry.indices.empty();
     }
     mUploadedVertexCount = total;
     mUploadedIndexCount = totalIndices;
+    mUploadedPacked = packed;
+    mUploadedShortIndices = shortIndices;
 
     if (total == 0 || totalIndices == 0)
     {
         return true;
     }
 
-    const quint32 needBytes = quint32(total * sizeof(MapVertex));
+    const quint32 needBytes =
+        quint32(total * (packed ? sizeof(PackedVertex) : sizeof(MapVertex)));
     if (!mVertexBuffer || needBytes > mVertexCapacity)
     {
         // Grow with headroom so a pan that adds one tile does not reallocate a
@@ -400,7 +462,8 @@ bool GpuRenderer::prepareUpload(std::span<const GpuBatch> batches,
         mVertexCapacity = capacity;
     }
 
-    const quint32 needIndexBytes = quint32(totalIndices * sizeof(std::uint32_t));
+    const quint32 needIndexBytes =
+        quint32(totalIndices * (shortIndices ? sizeof(std::uint16_t) : sizeof(std::uint32_t)));
     if (!mIndexBuffer || needIndexBytes > mIndexCapacity)
     {
         const quint32 capacity = needIndexBytes + (needIndexBytes / 2);
@@ -413,23 +476,65 @@ bool GpuRenderer::prepareUpload(std::span<const GpuBatch> batches,
         mIndexCapacity = capacity;
     }
 
-    flat.clear();
-    flat.reserve(total);
-    flatIndices.clear();
-    flatIndices.reserve(totalIndices);
+    mFlatScratch.clear();
+    mPackedScratch.clear();
+    mFlatIndexScratch.clear();
+    mShortIndexScratch.clear();
+    if (packed)
+    {
+        mPackedScratch.reserve(total);
+    }
+    else
+    {
+        mFlatScratch.reserve(total);
+    }
+    if (shortIndices)
+    {
+        mShortIndexScratch.reserve(totalIndices);
+    }
+    else
+    {
+        mFlatIndexScratch.reserve(totalIndices);
+    }
+
     for (const GpuBatch& batch : batches)
     {
         if (!batch.geometry)
         {
             continue;
         }
-        flat.insert(flat.end(), batch.geometry->vertices.begin(), batch.geometry->vertices.end());
+        const TileGeometry& geometry = *batch.geometry;
+        if (packed)
+        {
+            mPackedScratch.insert(mPackedScratch.end(), geometry.packed.begin(),
+                                  geometry.packed.end());
+        }
+        else
+        {
+            mFlatScratch.insert(mFlatScratch.end(), geometry.vertices.begin(),
+                                geometry.vertices.end());
+            for (const PackedVertex& vertex : geometry.packed)
+            {
+                mFlatScratch.push_back(unpackVertex(vertex, palette));
+            }
+        }
         // Copied VERBATIM: they are tile-local, and drawIndexed() is handed the
         // tile's base vertex to add. Rewriting them here would make a tile's
         // indices depend on where in the batch it landed, which is exactly what
-        // batchesChanged() relies on NOT being true.
-        flatIndices.insert(flatIndices.end(), batch.geometry->indices.begin(),
-                           batch.geometry->indices.end());
+        // batchesChanged() relies on NOT being true. Widening a 16-bit tile
+        // into a 32-bit frame changes the width and not the value.
+        if (shortIndices)
+        {
+            mShortIndexScratch.insert(mShortIndexScratch.end(), geometry.indices16.begin(),
+                                      geometry.indices16.end());
+        }
+        else
+        {
+            mFlatIndexScratch.insert(mFlatIndexScratch.end(), geometry.indices.begin(),
+                                     geometry.indices.end());
+            mFlatIndexScratch.insert(mFlatIndexScratch.end(), geometry.indices16.begin(),
+                                     geometry.indices16.end());
+        }
     }
 
     return true;
@@ -552,19 +657,22 @@ const QImage& GpuRenderer::render(const Projection& projection,
         key.alphas.push_back(quantizeAlpha(batch.alpha));
     }
 
+    // Built on a miss only, and not part of the key: like the rest of the
+    // style it is fixed for the renderer's life -- see FrameKey.
+    const PaintPalette palette = paintPalette(style);
+
     // Prepared, not submitted. The vertices ride in the same resource update
     // batch as the uniforms below -- uploading them used to open and close an
     // offscreen frame of its own, so a frame that brought in a new tile cost
     // two submissions and two GPU waits instead of one.
-    std::vector<MapVertex>& flat = mFlatScratch;
-    std::vector<std::uint32_t>& flatIndices = mFlatIndexScratch;
-    flat.clear();
-    flatIndices.clear();
     const bool uploading = batchesChanged(batches);
-    if (uploading && !prepareUpload(batches, flat, flatIndices))
+    if (uploading && !prepareUpload(batches, palette))
     {
         return kNull;
     }
+    const std::size_t vertexSize = mUploadedPacked ? sizeof(PackedVertex) : sizeof(MapVertex);
+    const std::size_t indexSize =
+        mUploadedShortIndices ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
 
     // Per-tile uniforms. A camera move rewrites these 80 bytes per tile and
     // nothing else -- the vertex buffer is untouched, which is the entire
@@ -634,15 +742,36 @@ const QImage& GpuRenderer::render(const Projection& projection,
     }
 
     QRhiResourceUpdateBatch* updates = mRhi->nextResourceUpdateBatch();
-    if (uploading && !flat.empty() && !flatIndices.empty())
+    if (uploading && mUploadedVertexCount > 0 && mUploadedIndexCount > 0)
     {
+        const void* vertices = mUploadedPacked ? static_cast<const void*>(mPackedScratch.data())
+                                               : static_cast<const void*>(mFlatScratch.data());
+        const void* indices = mUploadedShortIndices
+                                  ? static_cast<const void*>(mShortIndexScratch.data())
+                                  : static_cast<const void*>(mFlatIndexScratch.data());
         updates->uploadStaticBuffer(mVertexBuffer.get(), 0,
-                                    quint32(flat.size() * sizeof(MapVertex)), flat.data());
+                                    quint32(mUploadedVertexCount * vertexSize), vertices);
         updates->uploadStaticBuffer(mIndexBuffer.get(), 0,
-                                    quint32(flatIndices.size() * sizeof(std::uint32_t)),
-                                    flatIndices.data());
+                                    quint32(mUploadedIndexCount * indexSize), indices);
         ++mStats.uploads;
     }
+    if (mUploadedPacked)
+    {
+        // Every drawn frame rather than on change: 1.25 KB, against the
+        // uniform blocks above that are rewritten per tile anyway, and no
+        // state to get wrong.
+        std::vector<float>& block = mPaletteScratch;
+        block.assign(kPaletteBlockSize / sizeof(float), 0.0f);
+        for (std::size_t i = 0; i < palette.size() && i < kMaxPaints; ++i)
+        {
+            block[(i * 4) + 0] = palette[i].r;
+            block[(i * 4) + 1] = palette[i].g;
+            block[(i * 4) + 2] = palette[i].b;
+            block[(i * 4) + 3] = palette[i].a;
+            block[(kMaxPaints * 4) + i] = palette[i].halfPx;
+        }
+        updates->updateDynamicBuffer(mPaletteBuffer.get(), 0, kPaletteBlockSize, block.data());
+    }
     if (!batches.empty())
     {
         updates->updateDynamicBuffer(mUniformBuffer.get(), 0,
@@ -654,15 +783,17 @@ const QImage& GpuRenderer::render(const Projection& projection,
     int draws = 0;
     if (!batches.empty() && mUploadedVertexCount > 0 && mUploadedIndexCount > 0)
     {
-        cb->setGraphicsPipeline(mPipeline.get());
+        QRhiShaderResourceBindings* bindings = mUploadedPacked ? mPackedSrb.get() : mSrb.get();
+        cb->setGraphicsPipeline(mUploadedPacked ? mPackedPipeline.get() : mPipeline.get());
         cb->setViewport({ 0.0f, 0.0f, float(size.width()), float(size.height()) });
         const QRhiCommandBuffer::VertexInput vertexInput(mVertexBuffer.get(), 0);
-        // 32-bit indices. A single tile stays far under 65 536 vertices, but the
-        // buffer is SHARED across every tile in the frame and the index is into
-        // that -- so 16-bit would cap a frame at 65 536 vertices in total, which
-        // is one dense z14 tile.
+        // 16-bit indices whenever every tile has them. The buffer is shared
+        // across the frame, but the indices in it are TILE-LOCAL -- each draw
+        // adds its tile's base vertex -- so it is a tile, not the frame, that
+        // has to stay under 65 536 vertices.
         cb->setVertexInput(0, 1, &vertexInput, mIndexBuffer.get(), 0,
-                           QRhiCommandBuffer::IndexUInt32);
+                           mUploadedShortIndices ? QRhiCommandBuffer::IndexUInt16
+                                                 : QRhiCommandBuffer::IndexUInt32);
 
         // Layer-major across tiles. See the header.
         for (std::size_t li = 0; li < kMapLayerCount; ++li)
@@ -690,7 +821,7 @@ const QImage& GpuRenderer::render(const Projection& projection,
                 }
                 const QRhiCommandBuffer::DynamicOffset offset(
                     0, quint32(mUniformStride * ti));
-                cb->setShaderResources(mSrb.get(), 1, &offset);
+                cb->setShaderResources(bindings, 1, &offset);
                 // The tile's base vertex is the LAST argument, not folded into
                 // the indices: that is what lets a tile's geometry be uploaded
                 // unchanged wherever it lands in the shared buffer.
@@ -709,7 +840,8 @@ const QImage& GpuRenderer::render(const Projection& projection,
         // off the road it is meant to be on.
         if (!highlight.empty())
         {
-            cb->setGraphicsPipeline(mHighlightPipeline.get());
+            cb->setGraphicsPipeline(mUploadedPacked ? mPackedHighlightPipeline.get()
+                                                    : mHighlightPipeline.get());
             for (std::size_t ti = 0; ti < batches.size(); ++ti)
             {
                 if (!batches[ti].geometry || batches[ti].geometry->roads.empty())
@@ -724,7 +856,7 @@ const QImage& GpuRenderer::render(const Projection& projection,
                     geometry.forEachRoadRange(osmWayId, [&](const FeatureRange& range) {
                         if (!bound)
                         {
-                            cb->setShaderResources(mSrb.get(), 1, &offset);
+                            cb->setShaderResources(bindings, 1, &offset);
                             bound = true;
                         }
                         cb->drawIndexed(range.indexCount, 1,
@@ -777,6 +909,9 @@ const QImage& GpuRenderer::render(const Projection& projection,
     mStats.tiles = int(batches.size());
     mStats.vertices = mUploadedVertexCount;
     mStats.indices = mUploadedIndexCount;
+    mStats.vertexBytes = std::uint64_t(mUploadedVertexCount) * vertexSize;
+    mStats.indexBytes = std::uint64_t(mUploadedIndexCount) * indexSize;
+    mStats.packed = mUploadedPacked;
     mStats.lastFrameMs = double(timer.nsecsElapsed()) / 1.0e6;
     return mFrame;
 }
@@ -46,6 +46,13 @@ REFLECT_STRUCT(MapConfig_t,
         "Tile Zenoh Key", "Service key map_server answers tile requests on"),
     (uint16_t, request_timeout_ms, 4000,
         "Request Timeout (ms)", "How long to wait for a tile before giving up on it"),
+    // Off unless a layout names a directory, because where a head unit may
+    // write -- and how much of its flash it can spare -- is a property of the
+    // install, not of the widget. See map/disk_tile_cache.h.
+    (std::string, disk_cache_dir, "",
+        "Disk Cache Directory", "Absolute path to keep tessellated tiles in across restarts, e.g. /var/cache/dashboard/map. Delete it after rebuilding an archive. Empty keeps tiles in memory only"),
+    (uint32_t, disk_cache_mb, 512,
+        "Disk Cache Size (MB)", "How much the disk cache may hold before the least recently drawn tiles are removed"),
     // uint16_t, not uint8_t, and that is not arbitrary. yaml-cpp treats
     // `unsigned char` as a CHARACTER type: a zoom of 14 is written as the
     // unprintable byte 0x0E and read back as a bad conversion, which throws out
@@ -157,6 +164,8 @@ inline std::vector<std::string> validate(MapConfig_t& config)
                                             "highlight_extra_width", notes);
     config_codec::limits::clampInto<uint16_t>(config.tile_fade_ms, 0u, 1000u, "tile_fade_ms",
                                               notes);
+    config_codec::limits::clampInto<uint32_t>(config.disk_cache_mb, 16u, 65536u, "disk_cache_mb",
+                                              notes);
 
     // An inverted camera range would refuse every zoom -- clamp(z, 17, 0) has
     // no answer that satisfies both ends -- so the wheel would do nothing and
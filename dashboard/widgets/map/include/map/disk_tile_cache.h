@@ -0,0 +1,158 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//
+// Tessellated tiles on disk, behind the in-memory cache.
+//
+// TileCache keeps at most TileCache::kMaxTiles tiles, and fewer under its byte
+// budget, and a head unit draws the same few hundred square kilometres every day. Every cold start, and every pan back over ground
+// the memory cache has let go, paid the whole pipeline again for tiles it had
+// already drawn: a round trip to map_server, gunzip, mvt::decode and ~1.9 ms of
+// tessellation per tile. The result of all that is a function of the archive,
+// the tile and the style, and only the style can change under a running
+// dashboard -- so it is worth keeping.
+//
+// ONE FILE PER TILE, holding exactly what the paint pass reads: the vertex and
+// index buffers, the layer table, the road ranges and the label candidates.
+// The layout is fixed-width sections behind a fixed header, so a load is an
+// mmap, a bounds check and a memcpy per section. There is no decoder to run and
+// nothing to parse; the copy is there only because TileGeometry owns its
+// vectors, and a borrowed mapping would have to outlive the GPU upload.
+//
+// Keyed by tileset, tile and a hash of the style, in the PATH:
+//
+//     <root>/<tileset>/<style hash>/<z>/<x>/<y>.mtile
+//
+// with the tileset escaped one-to-one into a directory name, so two tilesets
+// never share one. A style edit simply stops finding the old entries, and the
+// budget ages them out, rather than anything having to invalidate them.
+//
+// What it CANNOT see is an archive rebuilt under the same tileset name: the
+// tile bytes are never fetched on a hit, so there is nothing to compare, and
+// the old tessellation is drawn until the budget evicts it. After rebuilding
+// an archive, delete its directory here. The same goes for a change to
+// tessellate() that alters its output for the same input -- that one bumps
+// kFormatVersion instead.
+//
+// Thread-safe. load() runs on the GUI thread and store() on the decode
+// workers; every file is written to a temporary name, flushed, and renamed
+// into place, and the directory flushed after, so a reader sees a whole file or
+// none, and a power cut mid-write leaves a stray temporary rather than a torn
+// tile.
+#ifndef MAP_DISK_TILE_CACHE_H
+#define MAP_DISK_TILE_CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include "map/projection.h"
+#include "map/style.h"
+#include "map/tile_cache.h"
+
+namespace map_widget
+{
+
+// Everything about the style that reaches the tessellator, as one number.
+//
+// Taken over the whole reflected struct rather than over the fields the
+// tessellator happens to read today. A field missed here is a cache that draws
+// the old colour after a style edit and recovers only when the budget gets
+// round to it -- and the cost of including one that does not matter is one
+// wasted tessellation per tile.
+std::uint64_t styleHash(const MapStyle_t& style);
+
+struct DiskTileCacheStats
+{
+    std::uint64_t hits { 0 };
+    std::uint64_t misses { 0 };
+    // Files that were there but could not be used: the wrong version, the wrong
+    // style, truncated, or with an index pointing past its vertices. Deleted on
+    // sight. A number that climbs means something is writing this directory
+    // that should not be.
+    std::uint64_t rejected { 0 };
+    std::uint64_t writes { 0 };
+    std::uint64_t writeFailures { 0 };
+    // Files removed to hold the budget.
+    std::uint64_t pruned { 0 };
+    std::uint64_t bytes { 0 };
+    std::uint64_t maxBytes { 0 };
+};
+
+class DiskTileCache
+{
+  public:
+    // Bumped whenever the file layout OR the tessellator's output for a given
+    // tile and style changes. It is part of every header, so an old file is
+    // rejected and rewritten rather than drawn wrong.
+    //
+    // 2: geometry may be packed (PackedVertex, 16-bit indices), flagged in the
+    // header.
+    static constexpr std::uint32_t kFormatVersion = 2;
+
+    // What one load found.
+    struct Hit
+    {
+        CachedTile tile;
+        // "The archive has nothing here", remembered on disk like anything
+        // else -- most of the pyramid is empty, and a cold start over the
+        // ocean is otherwise a request for every tile of it.
+        bool absent { false };
+    };
+
+    // Creates `root` if need be, then walks it once to learn what is already
+    // there and trims it to the budget. A leftover temporary from a write that
+    // never finished is removed here.
+    //
+    // `styleHash` is fixed for the object's life, like the style of the
+    // TileSource that uses it (see map/tile_source.h).
+    DiskTileCache(std::filesystem::path root, std::uint64_t maxBytes, std::uint64_t styleHash);
+
+    DiskTileCache(const DiskTileCache&) = delete;
+    DiskTileCache& operator=(const DiskTileCache&) = delete;
+
+    // The tile, or nothing if it is not on disk for this style. A file that
+    // fails any check is deleted and reported as a miss.
+    std::optional<Hit> load(const std::string& tileset, const TileId& id);
+
+    // Write `tile` for later. `absent` stores the absence rather than the
+    // geometry. False if the write failed, which the caller can ignore: the
+    // tile is still in memory, it is just not kept past it.
+    bool store(const std::string& tileset, const TileId& id, const CachedTile& tile, bool absent);
+
+    // Everything under one tileset, every style. For a bench that wants a cold
+    // start, and for the archive-rebuilt case above.
+    void clear(const std::string& tileset);
+
+    DiskTileCacheStats stats() const;
+
+    const std::filesystem::path& root() const { return mRoot; }
+
+  private:
+    std::filesystem::path pathFor(const std::string& tileset, const TileId& id) const;
+    // Delete least-recently-used files until the total is back under three
+    // quarters of the budget. The slack is so one write over the line does not
+    // walk the directory again on the next.
+    void prune();
+
+    const std::filesystem::path mRoot;
+    const std::uint64_t mMaxBytes;
+    const std::uint64_t mStyleHash;
+
+    std::atomic<std::uint64_t> mBytes { 0 };
+    std::atomic<std::uint64_t> mHits { 0 };
+    std::atomic<std::uint64_t> mMisses { 0 };
+    std::atomic<std::uint64_t> mRejected { 0 };
+    std::atomic<std::uint64_t> mWrites { 0 };
+    std::atomic<std::uint64_t> mWriteFailures { 0 };
+    std::atomic<std::uint64_t> mPruned { 0 };
+
+    // Held only while pruning, and only tried for: a worker that finds another
+    // one already pruning leaves it to that one.
+    std::mutex mPruneMutex;
+};
+
+} // namespace map_widget
+
+#endif // MAP_DISK_TILE_CACHE_H
@@ -166,6 +166,12 @@ class GpuRenderer
         // Indices uploaded for the frame. Three per triangle, and no longer the
         // same number as `vertices` -- which is the point of indexing.
         std::uint32_t indices { 0 };
+        // What those occupy on the GPU, and what every upload of them costs the
+        // bus. Eight bytes a vertex and two an index when the frame is packed;
+        // a frame with one float tile in it is drawn -- and sized -- as floats.
+        std::uint64_t vertexBytes { 0 };
+        std::uint64_t indexBytes { 0 };
+        bool packed { false };
         // Wall clock for the last render() including readback. endOffscreenFrame
         // waits for the GPU, so this is a real number rather than a submission
         // time.
@@ -196,12 +202,14 @@ class GpuRenderer
     bool ensureTarget(const QSize& size);
     // True when `batches` differ from what is already on the GPU.
     bool batchesChanged(std::span<const GpuBatch> batches) const;
-    // Works out the per-tile offsets, grows the vertex buffer if it must, and
-    // flattens the geometry into `flat`. Does NOT submit: the caller puts the
-    // upload in the same resource update batch as the frame's uniforms, so a
-    // frame that brings in a new tile is still one submission.
-    bool prepareUpload(std::span<const GpuBatch> batches, std::vector<MapVertex>& flat,
-                       std::vector<std::uint32_t>& flatIndices);
+    // Works out the per-tile offsets and the frame's vertex and index formats,
+    // grows the buffers if it must, and flattens the geometry into the scratch
+    // vectors below. Does NOT submit: the caller puts the upload in the same
+    // resource update batch as the frame's uniforms, so a frame that brings in
+    // a new tile is still one submission.
+    //
+    // `palette` is only read to unpack a packed tile into a float frame.
+    bool prepareUpload(std::span<const GpuBatch> batches, const PaintPalette& palette);
 
 #if MAP_HAS_VULKAN
     // Declared BEFORE mRhi so it outlives it: members are destroyed in reverse
@@ -222,10 +230,19 @@ class GpuRenderer
     // Same everything but the fragment stage: draws the map's own geometry in
     // one colour, for the route and the road the vehicle is on.
     std::unique_ptr<QRhiGraphicsPipeline> mHighlightPipeline;
+    // The same two for PackedVertex: another vertex stage and input layout,
+    // and bindings with the paint palette added. A frame draws with one pair
+    // or the other, never both -- see prepareUpload().
+    std::unique_ptr<QRhiGraphicsPipeline> mPackedPipeline;
+    std::unique_ptr<QRhiGraphicsPipeline> mPackedHighlightPipeline;
     std::unique_ptr<QRhiShaderResourceBindings> mSrb;
+    std::unique_ptr<QRhiShaderResourceBindings> mPackedSrb;
     std::unique_ptr<QRhiBuffer> mVertexBuffer;
     std::unique_ptr<QRhiBuffer> mIndexBuffer;
     std::unique_ptr<QRhiBuffer> mUniformBuffer;
+    // paintPalette() for the packed pipelines. Allocated once, at its fixed
+    // size, for the same reason as the uniform buffer.
+    std::unique_ptr<QRhiBuffer> mPaletteBuffer;
 
     QSize mSize;
     int mSampleCount { 1 };
@@ -247,6 +264,10 @@ class GpuRenderer
     std::vector<std::uint32_t> mTileBaseIndex;
     std::uint32_t mUploadedVertexCount { 0 };
     std::uint32_t mUploadedIndexCount { 0 };
+    // The formats of what is on the GPU, decided per upload: packed only if
+    // every tile is, 16-bit only if every tile's indices are.
+    bool mUploadedPacked { false };
+    bool mUploadedShortIndices { false };
     quint32 mVertexCapacity { 0 };
     quint32 mIndexCapacity { 0 };
 
@@ -318,8 +339,11 @@ class GpuRenderer
     // Scratch reused across frames -- cleared or overwritten each render,
     // capacity kept, so a steady repaint allocates nothing here.
     std::vector<MapVertex> mFlatScratch;
+    std::vector<PackedVertex> mPackedScratch;
     std::vector<std::uint32_t> mFlatIndexScratch;
+    std::vector<std::uint16_t> mShortIndexScratch;
     std::vector<char> mUniformScratch;
+    std::vector<float> mPaletteScratch;
 };
 
 } // namespace map_widget
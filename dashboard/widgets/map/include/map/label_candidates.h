@@ -15,6 +15,7 @@
 #include <QString>
 
 #include "mvt/tile.h"
+#include "mvt/view.h"
 
 namespace map_widget
 {
@@ -57,8 +58,15 @@ struct LabelCandidate
 
 using LabelSet = std::vector<LabelCandidate>;
 
-// Everything label-worthy in one decoded tile. Runs on the decode worker,
-// off the GUI thread; QString is a value type and crosses safely.
+// Everything label-worthy in one tile. Runs on the decode worker, off the GUI
+// thread; QString is a value type and crosses safely.
+//
+// Reads only the label layers, and only the geometry of features that carry a
+// name. As tessellate(): geometry that does not decode is skipped and
+// flag()ged on `tile`.
+LabelSet extractLabels(mvt::TileView& tile);
+
+// A decoded tile, by way of its encoding, for tests and tiles built in code.
 LabelSet extractLabels(const mvt::Tile& tile);
 
 } // namespace map_widget
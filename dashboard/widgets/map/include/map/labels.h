@@ -33,6 +33,7 @@
 #include <QString>
 
 #include "mvt/tile.h"
+#include "mvt/view.h"
 
 #include "map/label_candidates.h"
 
@@ -78,14 +79,16 @@ struct LabelRank
 // and a large town should outrank a small city rather than lose to it on a tag
 // whose meaning shifts between countries. Falls back to `placePriority()` for
 // an archive built before `rank` was written.
-LabelRank placeRank(const mvt::Layer& layer, const mvt::Feature& feature);
+template <typename Layer, typename Feature>
+LabelRank placeRank(const Layer& layer, const Feature& feature);
 
 // The rank of one feature of the tracks overlay's `track_label` layer.
 //
 // Sits between a town and a city, and orders circuits among themselves by the
 // length-derived rank map_build writes, so that where two collide the bigger
 // circuit keeps its name.
-LabelRank trackRank(const mvt::Layer& layer, const mvt::Feature& feature);
+template <typename Layer, typename Feature>
+LabelRank trackRank(const Layer& layer, const Feature& feature);
 
 // The rank of one feature of the basemap's `transportation_name` layer.
 //
@@ -93,7 +96,12 @@ LabelRank trackRank(const mvt::Layer& layer, const mvt::Feature& feature);
 // town off the map, but at the zooms road labels appear at it is worth more
 // than the name of a junction three miles away. Ordered among roads by
 // roadPriority(), so the bigger road keeps its name.
-LabelRank roadRank(const mvt::Layer& layer, const mvt::Feature& feature);
+//
+// All three are defined in labels.cpp for exactly two pairs: mvt::LayerView and
+// mvt::FeatureView, which the label pass reads, and mvt::Layer and
+// mvt::Feature, which a test builds by hand.
+template <typename Layer, typename Feature>
+LabelRank roadRank(const Layer& layer, const Feature& feature);
 
 struct LabelStats
 {
@@ -23,18 +23,22 @@
 #include <algorithm>
 #include <array>
 #include <cstdint>
+#include <optional>
 #include <string_view>
+#include <variant>
 #include <vector>
 
 #include "mvt/tile.h"
+#include "mvt/view.h"
 
 #include "map/style.h"
 
 namespace map_widget
 {
 
-// What the vertex shader consumes. Kept to 36 bytes and one layout so the whole
-// map is a single pipeline; anything that varies per layer is baked in here.
+// What tessellate() writes, and what map.vert consumes. Everything about a
+// vertex in plain floats, which is the form worth testing against; a tile is
+// KEPT as PackedVertex below, a quarter of the size.
 struct MapVertex
 {
     float x { 0.f }, y { 0.f };      // tile-local, [0,1] across the tile
@@ -44,6 +48,52 @@ struct MapVertex
 };
 static_assert(sizeof(MapVertex) == 9 * sizeof(float));
 
+// MapVertex in eight bytes, which is what a tile is kept and uploaded as once
+// packGeometry() has run over it.
+//
+// Of the 36 bytes above, twenty are colour and width -- and those are not
+// really per vertex: every vertex of a layer carries the same values, except on
+// the bridge and boundary layers, which pick one of a handful per feature.
+// So a vertex carries an INDEX into the style's paint palette (paintPalette()
+// below), and the palette rides a uniform. Positions are tile-local, so 16 bits
+// cover them exactly; a normal is a direction and a mitre length, and a byte
+// each is well under a pixel at any width the style allows.
+//
+// Two words rather than a struct of bytes, so the layout is fixed by the
+// shifts below and not by whatever the compiler does with bit-fields:
+//
+//     position    x (int16, low half) | y (int16, high half)
+//     attributes  nx (snorm8) | ny (snorm8) << 8 | mitre (unorm8) << 16 | paint << 24
+//
+// map_packed.vert takes these apart again.
+struct PackedVertex
+{
+    std::uint32_t position { 0 };
+    std::uint32_t attributes { 0 };
+};
+static_assert(sizeof(PackedVertex) == 8);
+
+// Position units per tile. 8192 makes an extent-4096 coordinate an exact
+// integer, and leaves int16 room for the tile's clip buffer and then some:
+// [-4, 4) tiles either way, where the tiler's buffer is a few percent of one.
+inline constexpr float kPackedPositionScale = 8192.0f;
+
+// One entry of the paint palette: what MapVertex carries per vertex and a
+// PackedVertex carries by index.
+struct Paint
+{
+    float r { 0.f }, g { 0.f }, b { 0.f }, a { 1.f };
+    float halfPx { 0.f };
+
+    bool operator==(const Paint&) const = default;
+};
+
+// The palette's ceiling, fixed because the renderer's uniform block is. A
+// style produces under thirty entries -- see paintPalette().
+inline constexpr std::size_t kMaxPaints = 64;
+
+using PaintPalette = std::vector<Paint>;
+
 // The draw order, and therefore the map. There is no depth buffer and no
 // sorting: moving a row here moves what covers what.
 //
@@ -188,6 +238,13 @@ struct TileGeometry
     // z14 tile was ~24k vertices at 36 bytes; this is where that goes.
     std::vector<std::uint32_t> indices;
 
+    // The same two buffers after packGeometry(), which leaves `vertices` and
+    // (for any tile under 65 536 vertices, i.e. all of them in practice)
+    // `indices` EMPTY in their favour. Counts and offsets below are the same
+    // in either form; vertexCount() and indexCount() read whichever is live.
+    std::vector<PackedVertex> packed;
+    std::vector<std::uint16_t> indices16;
+
     // Vertices for layer i occupy [layerStart[i], layerStart[i+1]), and the
     // indices that draw it [layerIndexStart[i], layerIndexStart[i+1]).
     std::array<std::uint32_t, kMapLayerCount + 1> layerStart {};
@@ -230,7 +287,14 @@ struct TileGeometry
         return layerIndexStart[i + 1] - layerIndexStart[i];
     }
 
-    bool empty() const { return indices.empty(); }
+    std::size_t vertexCount() const { return vertices.size() + packed.size(); }
+    std::size_t indexCount() const { return indices.size() + indices16.size(); }
+
+    // True when the vertices are PackedVertex. An empty tile is neither form,
+    // and says false.
+    bool isPacked() const { return !packed.empty(); }
+
+    bool empty() const { return indexCount() == 0; }
 };
 
 // Read a number out of an MVT attribute. The tiler writes rank, population
@@ -238,11 +302,64 @@ struct TileGeometry
 // double encoding by value, so both have to be accepted -- reading only one
 // of them yields a silent zero. Shared between the tessellator and the label
 // pass, which were once two byte-identical copies of it.
-std::optional<double> attributeNumber(const mvt::Layer& layer, const mvt::Feature& feature,
-                                      std::string_view key);
+//
+// A template over mvt::Layer and mvt::LayerView, whose values are the same
+// variant but for the string. attributeRef, not attribute: this runs per
+// feature and the by-value read costs an allocation for every string-typed
+// attribute it touches on the way past.
+template <typename Layer, typename Feature>
+std::optional<double> attributeNumber(const Layer& layer, const Feature& feature,
+                                      std::string_view key)
+{
+    const auto* value = layer.attributeRef(feature, key);
+    if (value == nullptr)
+    {
+        return std::nullopt;
+    }
+    if (const auto* d = std::get_if<double>(value))
+    {
+        return *d;
+    }
+    if (const auto* i = std::get_if<std::int64_t>(value))
+    {
+        return double(*i);
+    }
+    return std::nullopt;
+}
 
+// Read straight out of the tile bytes: a layer is indexed only if some layer
+// of the style draws from it, and a feature's geometry is decoded only if it
+// will be drawn. Geometry that does not decode is skipped and flag()ged on
+// `tile`, so check tile.error() afterwards to treat the tile as bad.
+TileGeometry tessellate(mvt::TileView& tile, const MapStyle_t& style);
+
+// A decoded tile, by way of its encoding -- for tests and for tiles built in
+// code. The served path never decodes to mvt::Tile at all.
 TileGeometry tessellate(const mvt::Tile& tile, const MapStyle_t& style);
 
+// Every colour and width tessellate() can write for this style, in a fixed
+// order: each layer's own, then the bridge casing per road layer, then the
+// boundary ladder. Bridge DECKS need no entries of their own -- they borrow
+// their road layer's colour and width exactly, which is the point of them.
+//
+// The order depends only on the code, never on the style's values, so a
+// palette built from one style indexes the same way as one built from another.
+PaintPalette paintPalette(const MapStyle_t& style);
+
+// Rewrite `geometry` in place into PackedVertex and, where it fits, 16-bit
+// indices, freeing the float buffers -- a quarter of the memory for the same
+// triangles. Every vertex's colour and width must be in `palette` exactly,
+// which anything tessellate() wrote against the same style is.
+//
+// False, and `geometry` untouched, if any vertex cannot be represented: a paint
+// not in the palette, a position more than four tiles out, a normal that is not
+// a mitre of [1, 4]. The float form still draws, so the caller need do nothing.
+bool packGeometry(TileGeometry& geometry, const PaintPalette& palette);
+
+// One packed vertex back in the float form, as the shader reads it. For a
+// frame that mixes the two forms, and for tests.
+MapVertex unpackVertex(const PackedVertex& vertex, const PaintPalette& palette);
+
 // How much of the baked-in width to actually use at this zoom. Applied in the
 // shader as a uniform, so zooming never invalidates a tessellation.
 float widthScaleForZoom(double zoom);
@@ -64,7 +64,12 @@ class TileCache
     // which is ~865 kB of MapVertex before the decoded features are counted --
     // call it 1.5 MB for downtown. 256 of those is nearly 400 MB, which is what
     // the count bound alone was quietly permitting.
-    static constexpr std::size_t kMaxTiles = 256;
+    //
+    // Packed (see PackedVertex), the same tile is ~24k x 8 bytes of vertices
+    // and 16-bit indices, ~0.4 MB with its labels -- so the budget now holds
+    // some 300 downtown tiles where it held 85, and the count is raised to
+    // match. At 256 it would have become the bound that bit first again.
+    static constexpr std::size_t kMaxTiles = 1024;
     static constexpr std::size_t kMaxBytes = 128u * 1024u * 1024u;
 
     // ...but the byte bound may not evict below this many tiles.
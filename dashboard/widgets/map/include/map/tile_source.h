@@ -26,6 +26,11 @@
 // change rebuilds the child (editor/selection_frame.h), so the style handed in
 // at construction is the style for this TileSource's whole life. If that ever
 // stops being true, the geometry cache needs a style revision to invalidate on.
+//
+// Optionally there is a second tier on disk (map/disk_tile_cache.h): a tile not
+// in memory is looked for there before it is asked for, and every tile that is
+// decoded here is written there. The disk tier does carry the style, in its
+// key, because unlike this object it outlives a config change.
 #ifndef MAP_TILE_SOURCE_H
 #define MAP_TILE_SOURCE_H
 
@@ -44,6 +49,7 @@
 
 #include "mvt/tile.h"
 
+#include "map/disk_tile_cache.h"
 #include "map/projection.h"
 #include "map/tile_cache.h"
 #include "map/tile_workers.h"
@@ -83,6 +89,9 @@ struct TileSourceStats
     // number climbing every frame means the viewport is permanently larger than
     // one request, which is the difference between "filling in" and "stuck".
     std::uint64_t deferred { 0 };
+    // Of decoded and absent, how many came off the disk tier rather than from
+    // map_server. Zero with no disk tier configured.
+    std::uint64_t fromDisk { 0 };
     std::size_t cached { 0 };
     // What those tiles weigh, decoded and tessellated. The count alone does not
     // say: an empty ocean tile and a city tile differ by three orders of
@@ -101,8 +110,13 @@ class TileSource
     //
     // `style` is copied and is fixed for this object's lifetime -- see the
     // header comment.
+    //
+    // `disk` is the optional second tier, shared between every source of one
+    // widget -- each keeps its own tileset's entries in it. Null for none. Its
+    // style hash must be this style's.
     TileSource(std::string tilesetName, std::string tileKey, std::uint64_t timeoutMs,
-               MapStyle_t style, std::function<void()> onTilesReady);
+               MapStyle_t style, std::function<void()> onTilesReady,
+               std::shared_ptr<DiskTileCache> disk = nullptr);
     ~TileSource();
 
     TileSource(const TileSource&) = delete;
@@ -214,12 +228,20 @@ class TileSource
     void deliverResult(const TileId& id, Outcome outcome, std::span<const std::uint8_t> bytes);
     // Mark every tile of a batch failed -- the request itself did not land.
     void failBatch(const std::vector<TileId>& ids);
+    // Serve what it can of `ask` from the disk tier, on the GUI thread, and
+    // return what is left for map_server. See the definition for the cap.
+    std::vector<TileId> loadFromDisk(std::vector<TileId> ask);
 
     std::string mTileset;
     // Read from zenoh threads during tessellation and never written after
     // construction, so no lock.
     MapStyle_t mStyle;
+    // What every tile is packed against (see packGeometry()). From mStyle, and
+    // fixed with it.
+    PaintPalette mPalette;
     std::function<void()> mOnTilesReady;
+    // Thread-safe on its own; read on the GUI thread, written on the workers.
+    std::shared_ptr<DiskTileCache> mDisk;
 
     // Decode and tessellation, spread across threads.
     //
@@ -6,6 +6,8 @@
 // the same one that decides whose name survives a collision.
 #include "map/tessellator.h"
 
+#include "mvt/encode.h"
+
 #include "qt_helpers/widget_colors.h"
 
 #include <QColor>
@@ -23,6 +25,8 @@
 #include <array>
 #include <cmath>
 #include <optional>
+#include <span>
+#include <string>
 #include <variant>
 
 namespace map_widget
@@ -73,7 +77,7 @@ enum class LabelGeometry
 struct LabelLayerSpec
 {
     const char* sourceLayer;
-    LabelRank (*priority)(const mvt::Layer&, const mvt::Feature&);
+    LabelRank (*priority)(const mvt::LayerView&, const mvt::FeatureView&);
     LabelGeometry geometry { LabelGeometry::Point };
     // Whether this layer draws at all, at this camera zoom. Null means always
     // -- which is right for places, whose own archive minzoom is the only
@@ -95,10 +99,12 @@ bool roadLabelsEnabled(const MapStyle_t& style, double zoom)
 }
 
 constexpr std::array<LabelLayerSpec, 3> kLabelLayers { {
-    { "place", placeRank, LabelGeometry::Point, nullptr, false, LabelKind::Place },
-    { "track_label", trackRank, LabelGeometry::Point, nullptr, false, LabelKind::Track },
-    { "transportation_name", roadRank, LabelGeometry::Line, roadLabelsEnabled,
-      /*oneLabelPerName=*/true, LabelKind::Road },
+    { "place", placeRank<mvt::LayerView, mvt::FeatureView>, LabelGeometry::Point, nullptr, false,
+      LabelKind::Place },
+    { "track_label", trackRank<mvt::LayerView, mvt::FeatureView>, LabelGeometry::Point, nullptr,
+      false, LabelKind::Track },
+    { "transportation_name", roadRank<mvt::LayerView, mvt::FeatureView>, LabelGeometry::Line,
+      roadLabelsEnabled, /*oneLabelPerName=*/true, LabelKind::Road },
 } };
 
 // A road too short on screen to hold any name at all is rejected before a
@@ -111,9 +117,10 @@ constexpr double kShortestWorthNaming = 24.0;
 // for this tile. Gathered rather than placed even so: a label's position
 // depends on which labels were already accepted, and the order tiles arrive
 // in is decode order, which is not an order anybody chose.
-void extractLayerLabels(const mvt::Tile& tile, const LabelLayerSpec& spec, LabelSet& out)
+void extractLayerLabels(mvt::TileView& tile, const LabelLayerSpec& spec, mvt::Rings& rings,
+                        LabelSet& out)
 {
-    const mvt::Layer* layer = tile.layer(spec.sourceLayer);
+    const mvt::LayerView* layer = tile.layer(spec.sourceLayer);
     if (layer == nullptr || layer->extent == 0)
     {
         return;
@@ -125,31 +132,47 @@ void extractLayerLabels(const mvt::Tile& tile, const LabelLayerSpec& spec, Label
     const double inv = 1.0 / double(layer->extent);
     const bool wantLine = spec.geometry == LabelGeometry::Line;
 
-    for (const mvt::Feature& feature : layer->features)
+    for (const mvt::FeatureView& feature : layer->features)
     {
         const bool isPoint = feature.type == mvt::GeomType::Point;
         const bool isLine = feature.type == mvt::GeomType::LineString;
-        if (feature.rings.empty() || (wantLine ? !isLine : !isPoint))
+        if (feature.geometry.empty() || (wantLine ? !isLine : !isPoint))
+        {
+            continue;
+        }
+
+        // The name BEFORE the geometry: most of transportation_name's
+        // features in a dense tile are unnamed service roads, and a feature
+        // with nothing to say never has its geometry read.
+        //
+        // name:latin, not name. This archive's tilemaker config emits only
+        // the latin field, and reading `name` returns an empty string for
+        // every place -- a map with no labels and no error anywhere.
+        // map_build writes BOTH spellings for exactly this reason.
+        std::string text = layer->attributeText(feature, "name:latin");
+        if (text.empty() && wantLine)
+        {
+            // A numbered route with no name still has something to say, and
+            // map_build emits it into this layer for exactly that reason.
+            text = layer->attributeText(feature, "ref");
+        }
+        if (text.empty())
         {
             continue;
         }
 
         if (!wantLine)
         {
-            if (feature.rings.front().empty())
-            {
-                continue;
-            }
-            const mvt::Point at = feature.rings.front().front();
-            // name:latin, not name. This archive's tilemaker config emits only
-            // the latin field, and reading `name` returns an empty string for
-            // every place -- a map with no labels and no error anywhere.
-            // map_build writes BOTH spellings for exactly this reason.
-            const std::string text = layer->attributeText(feature, "name:latin");
-            if (text.empty())
+            // A point label is its first point, so that is all that is read:
+            // one step of the cursor, not a Rings.
+            mvt::GeometryCursor cursor = feature.cursor();
+            auto first = cursor.next();
+            if (!first)
             {
+                tile.flag(first.error());
                 continue;
             }
+            const mvt::Point at = first->point;
             const LabelRank rank = spec.priority(*layer, feature);
             out.push_back(LabelCandidate { QString::fromStdString(text), double(at.x) * inv,
                                            double(at.y) * inv, 0.0, rank.tier, rank.magnitude,
@@ -157,6 +180,12 @@ void extractLayerLabels(const mvt::Tile& tile, const LabelLayerSpec& spec, Label
             continue;
         }
 
+        if (auto decoded = feature.rings(rings); !decoded)
+        {
+            tile.flag(decoded.error());
+            continue;
+        }
+
         // A line label goes at the MIDDLE OF THE LONGEST PART.
         //
         // The longest part rather than the first: MVT clips a road into as
@@ -175,7 +204,7 @@ void extractLayerLabels(const mvt::Tile& tile, const LabelLayerSpec& spec, Label
         mvt::Point bestAnchorLocal {};
         bool haveAnchor = false;
 
-        for (const auto& ring : feature.rings)
+        for (const std::span<const mvt::Point> ring : rings)
         {
             if (ring.size() < 2)
             {
@@ -223,18 +252,6 @@ void extractLayerLabels(const mvt::Tile& tile, const LabelLayerSpec& spec, Label
             continue;
         }
 
-        std::string text = layer->attributeText(feature, "name:latin");
-        if (text.empty())
-        {
-            // A numbered route with no name still has something to say, and
-            // map_build emits it into this layer for exactly that reason.
-            text = layer->attributeText(feature, "ref");
-        }
-        if (text.empty())
-        {
-            continue;
-        }
-
         const LabelRank rank = spec.priority(*layer, feature);
         out.push_back(LabelCandidate { QString::fromStdString(text),
                                        double(bestAnchorLocal.x) * inv,
@@ -246,20 +263,38 @@ void extractLayerLabels(const mvt::Tile& tile, const LabelLayerSpec& spec, Label
 
 } // namespace
 
-LabelSet extractLabels(const mvt::Tile& tile)
+LabelSet extractLabels(mvt::TileView& tile)
 {
     LabelSet out;
+    mvt::Rings rings;
     // All three layers, unconditionally: the show_* toggles and zoom floors
     // are the CAMERA's business and are applied per frame in paintLabels().
     // Extracting everything keeps the worker style-free, so a style edit
     // never needs a re-extract.
     for (const LabelLayerSpec& spec : kLabelLayers)
     {
-        extractLayerLabels(tile, spec, out);
+        extractLayerLabels(tile, spec, rings, out);
     }
     return out;
 }
 
+LabelSet extractLabels(const mvt::Tile& tile)
+{
+    // As tessellate(const mvt::Tile&): through the encoding, so a test reads
+    // the same code a served tile does.
+    auto bytes = mvt::encode(tile);
+    if (!bytes)
+    {
+        return {};
+    }
+    auto view = mvt::TileView::open(*bytes);
+    if (!view)
+    {
+        return {};
+    }
+    return extractLabels(*view);
+}
+
 // map_rules writes a `rank` on every label point, LOW meaning important:
 // country 0, state 1, city 2, town 3, village 4, hamlet 5, suburb 6,
 // neighbourhood 7, locality 8 (libs/map_rules/src/classification.cpp).
@@ -275,7 +310,8 @@ int tierForRank(std::int64_t rank)
     return kPlaceTierStep * int(kMaxPlaceRank - std::clamp(rank, std::int64_t { 0 }, kMaxPlaceRank));
 }
 
-LabelRank placeRank(const mvt::Layer& layer, const mvt::Feature& feature)
+template <typename Layer, typename Feature>
+LabelRank placeRank(const Layer& layer, const Feature& feature)
 {
     LabelRank out;
 
@@ -314,7 +350,8 @@ LabelRank placeRank(const mvt::Layer& layer, const mvt::Feature& feature)
     return out;
 }
 
-LabelRank trackRank(const mvt::Layer& layer, const mvt::Feature& feature)
+template <typename Layer, typename Feature>
+LabelRank trackRank(const Layer& layer, const Feature& feature)
 {
     // Between a town and a city, which is the HALF step the doubled tier scale
     // exists to express. A circuit is a landmark worth seeing from a distance,
@@ -336,7 +373,8 @@ LabelRank trackRank(const mvt::Layer& layer, const mvt::Feature& feature)
     return out;
 }
 
-LabelRank roadRank(const mvt::Layer& layer, const mvt::Feature& feature)
+template <typename Layer, typename Feature>
+LabelRank roadRank(const Layer& layer, const Feature& feature)
 {
     // Between a neighbourhood and a locality.
     //
@@ -355,6 +393,15 @@ LabelRank roadRank(const mvt::Layer& layer, const mvt::Feature& feature)
     return out;
 }
 
+// The two pairs labels.h promises: views for the label pass, decoded layers for
+// the tests that build one by hand.
+template LabelRank placeRank(const mvt::LayerView&, const mvt::FeatureView&);
+template LabelRank trackRank(const mvt::LayerView&, const mvt::FeatureView&);
+template LabelRank roadRank(const mvt::LayerView&, const mvt::FeatureView&);
+template LabelRank placeRank(const mvt::Layer&, const mvt::Feature&);
+template LabelRank trackRank(const mvt::Layer&, const mvt::Feature&);
+template LabelRank roadRank(const mvt::Layer&, const mvt::Feature&);
+
 // The fallback for an archive whose label points carry no `rank`. Kept in step
 // with map_rules' own table (classification.cpp) so that the two agree about
 // which is the bigger place, and expressed through tierForRank() rather than as
@@ -13,11 +13,25 @@
 //
 //   map_bench --tiles ~/Documents/map_data/socal.mbtiles
 //   map_bench --tiles ... --width 2560 --height 1440 --dpr 2
+//   map_bench --tiles ... --disk-cache /tmp/map_bench_cache
+//
+// The `decode` line reads every tile of the corridor in full twice, once with
+// mvt::decode() and once through mvt::TileView, and reports time and heap
+// allocations per tile for each. The widget reads through the views; the line
+// is there so the reason it does stays a number rather than a claim.
+//
+// --disk-cache loads the corridor twice: COLD, through the whole decode and
+// tessellate pipeline with every tile written to the disk tier as the widget
+// writes it, and then WARM, from that tier alone. The two load lines are the
+// cold start and the warm start of a head unit. The bench keys its entries
+// under a tileset of its own and clears only those, so pointing it at the
+// dashboard's cache directory does not cost the dashboard its tiles.
 //
 // The number to watch is `uploads`: it should climb only when the visible tile
 // SET changes. If it tracks the frame count, something is invalidating the
 // vertex cache every frame and the whole tessellate-once design is off.
 
+#include "map/disk_tile_cache.h"
 #include "map/gpu_renderer.h"
 #include "map/labels.h"
 #include "map/projection.h"
@@ -26,6 +40,7 @@
 #include "mbtiles/archive.h"
 #include "mvt/decode.h"
 #include "mvt/gzip.h"
+#include "mvt/view.h"
 
 #include <QGuiApplication>
 #include <QImage>
@@ -36,12 +51,15 @@
 #include <spdlog/spdlog.h>
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cmath>
 #include <numbers>
 #include <cstdlib>
 #include <deque>
 #include <memory>
+#include <new>
+#include <span>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -49,6 +67,35 @@
 namespace
 {
 
+// Every heap allocation in the process, for the decode line. Relaxed: it is a
+// count read between passes on one thread, not a synchronisation point.
+std::atomic<std::uint64_t> gAllocations { 0 };
+
+} // namespace
+
+void* operator new(std::size_t size)
+{
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* at = std::malloc(size == 0 ? 1 : size))
+    {
+        return at;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* at) noexcept
+{
+    std::free(at);
+}
+
+void operator delete(void* at, std::size_t) noexcept
+{
+    std::free(at);
+}
+
+namespace
+{
+
 using map_widget::Camera;
 using map_widget::Coordinate;
 using map_widget::GpuBatch;
@@ -124,6 +171,56 @@ class Timer
     std::chrono::steady_clock::time_point mStart;
 };
 
+// Everything decode() reads, read through the views instead: every layer
+// indexed, every feature's rings decoded, into one Rings for the whole tile.
+// The points are counted so the read cannot be optimised away, and so a
+// disagreement with decode() shows up as a different number.
+std::size_t pointsThroughViews(std::span<const std::uint8_t> bytes)
+{
+    auto view = mvt::TileView::open(bytes);
+    if (!view)
+    {
+        return 0;
+    }
+    std::size_t points = 0;
+    mvt::Rings rings;
+    for (std::size_t i = 0; i < view->layerCount(); ++i)
+    {
+        const mvt::LayerView* layer = view->layer(view->layerName(i));
+        if (layer == nullptr)
+        {
+            continue;
+        }
+        for (const mvt::FeatureView& feature : layer->features)
+        {
+            if (feature.rings(rings))
+            {
+                for (const std::span<const mvt::Point> ring : rings)
+                {
+                    points += ring.size();
+                }
+            }
+        }
+    }
+    return points;
+}
+
+std::size_t pointsIn(const mvt::Tile& tile)
+{
+    std::size_t points = 0;
+    for (const mvt::Layer& layer : tile.layers)
+    {
+        for (const mvt::Feature& feature : layer.features)
+        {
+            for (const auto& ring : feature.rings)
+            {
+                points += ring.size();
+            }
+        }
+    }
+    return points;
+}
+
 std::string argumentAfter(int argc, char** argv, const std::string& flag,
                           const std::string& fallback)
 {
@@ -207,44 +304,155 @@ int main(int argc, char** argv)
     const auto centreX = static_cast<std::int64_t>(centre.x * side);
     const auto centreY = static_cast<std::int64_t>(centre.y * side);
 
+    std::vector<TileId> corridor;
+    for (std::int64_t dy = -3; dy <= 3; ++dy)
+    {
+        for (std::int64_t dx = -3; dx <= 12; ++dx)
+        {
+            corridor.push_back(TileId { z, static_cast<std::uint32_t>(centreX + dx),
+                                        static_cast<std::uint32_t>(centreY + dy) });
+        }
+    }
+
+    // The disk tier, when asked for, cleared of the bench's own entries so the
+    // first pass really is cold.
+    const std::string diskPath = argumentAfter(argc, argv, "--disk-cache", "");
+    constexpr const char* kBenchTileset = "map_bench";
+    std::unique_ptr<map_widget::DiskTileCache> disk;
+    if (!diskPath.empty())
+    {
+        disk = std::make_unique<map_widget::DiskTileCache>(diskPath, std::uint64_t(1) << 30,
+                                                           map_widget::styleHash(style));
+        disk->clear(kBenchTileset);
+    }
+
     std::size_t decoded = 0;
     std::size_t absent = 0;
     std::uint64_t vertices = 0;
+    // What the corridor's geometry weighs in each form, so the packing's
+    // saving is a measured number. Float is tessellate()'s output, packed is
+    // what TileSource caches and uploads.
+    std::uint64_t floatBytes = 0;
+    std::uint64_t packedBytes = 0;
+    const map_widget::PaintPalette palette = map_widget::paintPalette(style);
     const Timer loadTimer;
-    for (std::int64_t dy = -3; dy <= 3; ++dy)
+    for (const TileId& id : corridor)
     {
-        for (std::int64_t dx = -3; dx <= 12; ++dx)
+        auto blob = archive->tile(id.z, id.x, id.y);
+        if (!blob || !blob->has_value())
         {
-            const TileId id { z, static_cast<std::uint32_t>(centreX + dx),
-                              static_cast<std::uint32_t>(centreY + dy) };
-            auto blob = archive->tile(id.z, id.x, id.y);
-            if (!blob || !blob->has_value())
+            if (disk && blob)
             {
-                ++absent;
-                continue;
+                disk->store(kBenchTileset, id, map_widget::CachedTile {}, true);
             }
-            auto raw = mvt::inflateIfCompressed((*blob)->data);
-            if (!raw)
+            ++absent;
+            continue;
+        }
+        auto raw = mvt::inflateIfCompressed((*blob)->data);
+        if (!raw)
+        {
+            ++absent;
+            continue;
+        }
+        // Read in place, as TileSource does.
+        auto tile = mvt::TileView::open(*raw);
+        if (!tile)
+        {
+            ++absent;
+            continue;
+        }
+        // Packed inside the timed loop, as TileSource does on its worker.
+        TileGeometry tessellated = map_widget::tessellate(*tile, style);
+        floatBytes += (tessellated.vertices.size() * sizeof(map_widget::MapVertex)) +
+                      (tessellated.indices.size() * sizeof(std::uint32_t));
+        map_widget::packGeometry(tessellated, palette);
+        packedBytes += (tessellated.vertexCount() * (tessellated.isPacked()
+                                                         ? sizeof(map_widget::PackedVertex)
+                                                         : sizeof(map_widget::MapVertex))) +
+                       (tessellated.indices16.size() * sizeof(std::uint16_t)) +
+                       (tessellated.indices.size() * sizeof(std::uint32_t));
+        auto geometry = std::make_shared<const TileGeometry>(std::move(tessellated));
+        auto labels =
+            std::make_shared<const map_widget::LabelSet>(map_widget::extractLabels(*tile));
+        vertices += geometry->vertexCount();
+        // Inside the timed loop, because the widget writes on the same worker
+        // that tessellated: the cold start pays for the write.
+        if (disk)
+        {
+            disk->store(kBenchTileset, id, map_widget::CachedTile { labels, geometry }, false);
+        }
+        cache.emplace(id, Cached { std::move(labels), std::move(geometry) });
+        ++decoded;
+    }
+    const double loadMs = loadTimer.ms();
+
+    // The warm start: the same corridor off the disk tier alone, replacing what
+    // the cold pass built, so the frame loop below draws what the disk gave
+    // back and a layout the tier got wrong shows up as a different picture.
+    double warmMs = 0.0;
+    std::size_t warmHits = 0;
+    if (disk)
+    {
+        cache.clear();
+        const Timer warmTimer;
+        for (const TileId& id : corridor)
+        {
+            auto hit = disk->load(kBenchTileset, id);
+            if (!hit)
             {
-                ++absent;
                 continue;
             }
-            auto tile = mvt::decode(*raw);
-            if (!tile)
+            ++warmHits;
+            if (!hit->absent)
             {
-                ++absent;
-                continue;
+                cache.emplace(id, Cached { hit->tile.labels, hit->tile.geometry });
             }
-            auto geometry =
-                std::make_shared<const TileGeometry>(map_widget::tessellate(*tile, style));
-            auto labels =
-                std::make_shared<const map_widget::LabelSet>(map_widget::extractLabels(*tile));
-            vertices += geometry->vertices.size();
-            cache.emplace(id, Cached { std::move(labels), std::move(geometry) });
-            ++decoded;
         }
+        warmMs = warmTimer.ms();
     }
-    const double loadMs = loadTimer.ms();
+
+    // decode() against the views, tile by tile over the same corridor. Outside
+    // the load timer, and with nothing else running: the allocation counter is
+    // the whole process's.
+    double decodeMs = 0.0;
+    double viewMs = 0.0;
+    std::uint64_t decodeAllocations = 0;
+    std::uint64_t viewAllocations = 0;
+    std::size_t compared = 0;
+    std::size_t disagreed = 0;
+    for (const TileId& id : corridor)
+    {
+        auto blob = archive->tile(id.z, id.x, id.y);
+        if (!blob || !blob->has_value())
+        {
+            continue;
+        }
+        auto raw = mvt::inflateIfCompressed((*blob)->data);
+        if (!raw)
+        {
+            continue;
+        }
+
+        std::uint64_t before = gAllocations.load(std::memory_order_relaxed);
+        const Timer decodeTimer;
+        auto tile = mvt::decode(*raw);
+        decodeMs += decodeTimer.ms();
+        decodeAllocations += gAllocations.load(std::memory_order_relaxed) - before;
+        if (!tile)
+        {
+            continue;
+        }
+
+        before = gAllocations.load(std::memory_order_relaxed);
+        const Timer viewTimer;
+        const std::size_t points = pointsThroughViews(*raw);
+        viewMs += viewTimer.ms();
+        viewAllocations += gAllocations.load(std::memory_order_relaxed) - before;
+
+        disagreed += (points != pointsIn(*tile)) ? 1 : 0;
+        ++compared;
+    }
+    const double perTile = 1.0 / double(std::max<std::size_t>(compared, 1));
 
     SPDLOG_INFO("");
     SPDLOG_INFO("archive    {}", tilesPath);
@@ -254,6 +462,23 @@ int main(int argc, char** argv)
                 gpu->stats().sampleCount);
     SPDLOG_INFO("tiles      {} decoded, {} absent, {} vertices, {:.0f} ms to load+tessellate",
                 decoded, absent, vertices, loadMs);
+    SPDLOG_INFO("geometry   {:.1f} MB as floats, {:.1f} MB packed ({:.1f}x)",
+                double(floatBytes) / (1024.0 * 1024.0), double(packedBytes) / (1024.0 * 1024.0),
+                double(floatBytes) / double(std::max<std::uint64_t>(packedBytes, 1)));
+    SPDLOG_INFO("decode     decode() {:.3f} ms and {:.0f} allocations per tile, views {:.3f} ms "
+                "and {:.0f} ({} tiles{})",
+                decodeMs * perTile, double(decodeAllocations) * perTile, viewMs * perTile,
+                double(viewAllocations) * perTile, compared,
+                disagreed == 0 ? "" : fmt::format(", {} DISAGREE", disagreed));
+    if (disk)
+    {
+        const map_widget::DiskTileCacheStats diskStats = disk->stats();
+        SPDLOG_INFO("disk       cold {:.0f} ms ({:.2f} ms/tile, writes included), "
+                    "warm {:.0f} ms ({:.2f} ms/tile) for {} of {} tiles, {:.1f} MB on disk",
+                    loadMs, loadMs / double(corridor.size()), warmMs,
+                    warmMs / double(std::max<std::size_t>(warmHits, 1)), warmHits,
+                    corridor.size(), double(diskStats.bytes) / (1024.0 * 1024.0));
+    }
     SPDLOG_INFO("");
 
     if (decoded == 0)
@@ -421,6 +646,10 @@ int main(int argc, char** argv)
     SPDLOG_INFO("");
     SPDLOG_INFO("  uploads {} over {} frames   ({} draw calls, {} vertices resident)",
                 stats.uploads, frames, stats.drawCalls, stats.vertices);
+    // What each of those uploads moved across the bus, and in which form.
+    SPDLOG_INFO("  per upload {:.2f} MB vertices + {:.2f} MB indices ({})",
+                double(stats.vertexBytes) / (1024.0 * 1024.0),
+                double(stats.indexBytes) / (1024.0 * 1024.0), stats.packed ? "packed" : "floats");
     // The camera moves every frame here, so this must stay 0. Anything else
     // means the frame memo's key is missing an input.
     SPDLOG_INFO("  frames reused {} (expected 0: the camera moves every frame)", stats.reused);
@@ -162,9 +162,20 @@ MapWidget::MapWidget(const config_t& config, QWidget* parent) :
             Qt::QueuedConnection);
     };
 
+    // One disk tier for every source, keyed inside by tileset. Made here rather
+    // than per source so one budget covers the base and its overlays -- the
+    // sources own it between them, and it goes when the last of them does.
+    std::shared_ptr<map_widget::DiskTileCache> disk;
+    if (!mConfig.disk_cache_dir.empty())
+    {
+        disk = std::make_shared<map_widget::DiskTileCache>(
+            mConfig.disk_cache_dir, std::uint64_t(mConfig.disk_cache_mb) * 1024u * 1024u,
+            map_widget::styleHash(mConfig.style));
+    }
+
     mSources.push_back(std::make_unique<map_widget::TileSource>(
         mConfig.tileset, mConfig.tile_zenoh_key, mConfig.request_timeout_ms, mConfig.style,
-        onArrival));
+        onArrival, disk));
     for (const std::string& overlay : mConfig.overlay_tilesets)
     {
         if (overlay.empty() || overlay == mConfig.tileset)
@@ -175,7 +186,7 @@ MapWidget::MapWidget(const config_t& config, QWidget* parent) :
         }
         mSources.push_back(std::make_unique<map_widget::TileSource>(
             overlay, mConfig.tile_zenoh_key, mConfig.request_timeout_ms, mConfig.style,
-            onArrival));
+            onArrival, disk));
     }
 
     if (!mConfig.position_zenoh_key.empty())
@@ -1063,7 +1074,9 @@ void MapWidget::paintDiagnostic(QPainter& painter)
         // the wrong file.
         const map_widget::TileSourceStats sourceStats = mSources.front()->stats();
 
-        if (sourceStats.requested == 0)
+        // Counting the disk tier too: a warm start can fill the screen without
+        // asking map_server for anything.
+        if (sourceStats.requested == 0 && sourceStats.fromDisk == 0)
         {
             message = QStringLiteral("No tiles requested");
         }
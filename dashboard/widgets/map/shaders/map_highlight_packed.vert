@@ -0,0 +1,49 @@
+#version 450
+
+// map_highlight.vert for PackedVertex: the unpacking of map_packed.vert, the
+// widening of map_highlight.vert. See both.
+layout(location = 0) in uvec2 packedIn;
+
+layout(location = 0) out vec4 vcol;
+
+layout(std140, binding = 0) uniform buf {
+    mat4 mvp;
+    float pxPerLocal;
+    float widthScale;
+    float fadeAlpha;
+    float extraHalfPx;
+    vec4 highlight;
+};
+
+layout(std140, binding = 1) uniform paints {
+    vec4 paintColour[64];
+    vec4 paintHalfPx[16];
+};
+
+const float kPositionScale = 8192.0;
+const float kMitreLimit = 4.0;
+
+const float kMinHalfPx = 0.5;
+
+void main() {
+    vec2 pos = vec2(float(int(packedIn.x << 16) >> 16), float(int(packedIn.x) >> 16)) /
+               kPositionScale;
+
+    int nxi = int(packedIn.y << 24) >> 24;
+    int nyi = int(packedIn.y << 16) >> 24;
+    vec2 nrm = vec2(0.0);
+    if (nxi != 0 || nyi != 0) {
+        float mitre = 1.0 + float((packedIn.y >> 16) & 0xffu) * ((kMitreLimit - 1.0) / 255.0);
+        nrm = normalize(max(vec2(nxi, nyi) / 127.0, vec2(-1.0))) * mitre;
+    }
+
+    int paint = min(int(packedIn.y >> 24), 63);
+    float halfPx = paintHalfPx[paint >> 2][paint & 3];
+
+    float screenHalf = halfPx * widthScale;
+    float drawnHalf = max(screenHalf + extraHalfPx, kMinHalfPx);
+
+    vec2 p = pos + nrm * (drawnHalf / max(pxPerLocal, 1e-6));
+    vcol = paintColour[paint];
+    gl_Position = mvp * vec4(p, 0.0, 1.0);
+}
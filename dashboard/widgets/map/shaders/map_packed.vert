@@ -0,0 +1,66 @@
+#version 450
+
+// map.vert for PackedVertex (map/tessellator.h): the same expansion, the same
+// hairline fade, from eight bytes a vertex instead of thirty-six. Colour and
+// width come out of the style's paint palette by index rather than riding every
+// vertex, and the position and normal are unpacked here.
+//
+// One uvec2 rather than a byte-sized attribute per field. The small integer
+// formats are where the backends differ most, and two 32-bit words are read the
+// same everywhere -- GLSL 330 included.
+layout(location = 0) in uvec2 packedIn;
+
+layout(location = 0) out vec4 vcol;
+
+layout(std140, binding = 0) uniform buf {
+    mat4 mvp;
+    float pxPerLocal;
+    float widthScale;
+    float fadeAlpha;
+    float extraHalfPx;
+    vec4 highlight;
+};
+
+// paintPalette(), as GpuRenderer lays it out. The widths are packed four to a
+// vec4 because std140 pads a float array to one vec4 per element.
+layout(std140, binding = 1) uniform paints {
+    vec4 paintColour[64];
+    vec4 paintHalfPx[16];
+};
+
+// Must match kPackedPositionScale and kMitreLimit in tessellator.{h,cpp}.
+const float kPositionScale = 8192.0;
+const float kMitreLimit = 4.0;
+
+const float kMinHalfPx = 0.5;
+
+void main() {
+    // Sign-extended by shifting the half up to the top and arithmetic-shifting
+    // it back down, which is bitfieldExtract() in a form GLSL 330 accepts.
+    vec2 pos = vec2(float(int(packedIn.x << 16) >> 16), float(int(packedIn.x) >> 16)) /
+               kPositionScale;
+
+    int nxi = int(packedIn.y << 24) >> 24;
+    int nyi = int(packedIn.y << 16) >> 24;
+    vec2 nrm = vec2(0.0);
+    // A fill has no normal at all, and must keep having none: the fade below
+    // tells a fill from a line by its width, and the width is zero only here.
+    if (nxi != 0 || nyi != 0) {
+        float mitre = 1.0 + float((packedIn.y >> 16) & 0xffu) * ((kMitreLimit - 1.0) / 255.0);
+        nrm = normalize(max(vec2(nxi, nyi) / 127.0, vec2(-1.0))) * mitre;
+    }
+
+    // Clamped, so a damaged index reads the last entry rather than past the end.
+    int paint = min(int(packedIn.y >> 24), 63);
+    vec4 col = paintColour[paint];
+    float halfPx = paintHalfPx[paint >> 2][paint & 3];
+
+    // From here on, map.vert line for line -- see there for why.
+    float screenHalf = halfPx * widthScale;
+    float drawnHalf = max(screenHalf, kMinHalfPx);
+    float fade = screenHalf > 0.0 ? screenHalf / drawnHalf : 1.0;
+
+    vec2 p = pos + nrm * (drawnHalf / max(pxPerLocal, 1e-6));
+    vcol = vec4(col.rgb, col.a * fade * fadeAlpha);
+    gl_Position = mvp * vec4(p, 0.0, 1.0);
+}
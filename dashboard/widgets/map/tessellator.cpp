@@ -2,6 +2,8 @@
 
 #include "map/tessellator.h"
 
+#include "mvt/encode.h"
+
 // earcut.hpp shadows its own members in a dozen places, which our -Werror
 // rejects. Silenced for the header alone rather than for the file: -Wshadow
 // still applies to everything below, and rather than by marking the include
@@ -80,11 +82,11 @@ Colour toRgba(const helpers::Color& colour)
     return { hex(1, 2), hex(3, 2), hex(5, 2), 1.f };
 }
 
-bool isRunway(const mvt::Layer& layer, const mvt::Feature& feature)
+bool isRunway(const mvt::LayerView& layer, const mvt::FeatureView& feature)
 {
     return layer.attributeTextView(feature, "class") == "runway";
 }
-bool isNotRunway(const mvt::Layer& layer, const mvt::Feature& feature)
+bool isNotRunway(const mvt::LayerView& layer, const mvt::FeatureView& feature)
 {
     return !isRunway(layer, feature);
 }
@@ -92,24 +94,25 @@ bool isNotRunway(const mvt::Layer& layer, const mvt::Feature& feature)
 // `brunnel` is OpenMapTiles' word for grade separation, and absent means at
 // grade -- which is the overwhelming majority of roads, so the key is only
 // written where it says something.
-bool isBridge(const mvt::Layer& layer, const mvt::Feature& feature)
+bool isBridge(const mvt::LayerView& layer, const mvt::FeatureView& feature)
 {
     return layer.attributeTextView(feature, "brunnel") == "bridge";
 }
-bool isNotBridge(const mvt::Layer& layer, const mvt::Feature& feature)
+bool isNotBridge(const mvt::LayerView& layer, const mvt::FeatureView& feature)
 {
     return !isBridge(layer, feature);
 }
 
 // Defined below, next to the layer colour and width they borrow from.
-Colour bridgeColour(const mvt::Layer& layer, const mvt::Feature& feature, const MapStyle_t& style);
-Colour bridgeCasingColour(const mvt::Layer& layer, const mvt::Feature& feature,
+Colour bridgeColour(const mvt::LayerView& layer, const mvt::FeatureView& feature,
+                    const MapStyle_t& style);
+Colour bridgeCasingColour(const mvt::LayerView& layer, const mvt::FeatureView& feature,
                           const MapStyle_t& style);
-float bridgeHalfWidth(const mvt::Layer& layer, const mvt::Feature& feature,
+float bridgeHalfWidth(const mvt::LayerView& layer, const mvt::FeatureView& feature,
                       const MapStyle_t& style);
-float bridgeCasingHalfWidth(const mvt::Layer& layer, const mvt::Feature& feature,
+float bridgeCasingHalfWidth(const mvt::LayerView& layer, const mvt::FeatureView& feature,
                             const MapStyle_t& style);
-float boundaryHalfWidth(const mvt::Layer& layer, const mvt::Feature& feature,
+float boundaryHalfWidth(const mvt::LayerView& layer, const mvt::FeatureView& feature,
                         const MapStyle_t& style);
 
 struct LayerSpec
@@ -125,7 +128,7 @@ struct LayerSpec
     // predicate is sometimes a NEGATION ("every aeroway line that is not a
     // runway") and sometimes reads a different key entirely ("every road that
     // is not on a bridge").
-    bool (*featureFilter)(const mvt::Layer&, const mvt::Feature&) { nullptr };
+    bool (*featureFilter)(const mvt::LayerView&, const mvt::FeatureView&) { nullptr };
     // Half-width and colour per FEATURE, overriding the layer's own. Null means
     // every feature in the layer looks the same, which is true of most.
     //
@@ -133,8 +136,10 @@ struct LayerSpec
     // already per-vertex, which is exactly what they are for -- so a layer
     // whose features differ needs no extra draw call and no extra layer. That
     // is what lets the two bridge layers carry roads of every class.
-    float (*featureHalfWidth)(const mvt::Layer&, const mvt::Feature&, const MapStyle_t&) { nullptr };
-    Colour (*featureColour)(const mvt::Layer&, const mvt::Feature&, const MapStyle_t&) { nullptr };
+    float (*featureHalfWidth)(const mvt::LayerView&, const mvt::FeatureView&,
+                              const MapStyle_t&) { nullptr };
+    Colour (*featureColour)(const mvt::LayerView&, const mvt::FeatureView&,
+                            const MapStyle_t&) { nullptr };
 
     // The layer's whole relationship to the style, as pointers to the style's
     // own members. These five used to be five parallel switches over MapLayer
@@ -268,7 +273,12 @@ Colour colourFor(MapLayer layer, const MapStyle_t& style)
 // knob still sets the weight of the whole set and setting it to zero still hides
 // all of them. The ladder is deliberately shallow: a county line thinner than
 // about a third of a country line stops being visible at all against landcover.
-float boundaryHalfWidth(const mvt::Layer& layer, const mvt::Feature& feature,
+//
+// One table for this and for paintPalette(), which has to reproduce the
+// products to the bit for a packed vertex to find its entry.
+constexpr std::array<float, 3> kBoundaryFractions { 0.70f, 0.50f, 0.38f };
+
+float boundaryHalfWidth(const mvt::LayerView& layer, const mvt::FeatureView& feature,
                         const MapStyle_t& style)
 {
     const float full = float(style.widths.boundary);
@@ -280,20 +290,22 @@ float boundaryHalfWidth(const mvt::Layer& layer, const mvt::Feature& feature,
         return full;
     }
 
-    if (*level <= 2.0) return full;            // country
-    if (*level <= 4.0) return full * 0.70f;    // state or province
-    if (*level <= 6.0) return full * 0.50f;    // county
-    return full * 0.38f;                       // city and below
+    if (*level <= 2.0) return full;                              // country
+    if (*level <= 4.0) return full * kBoundaryFractions[0];      // state or province
+    if (*level <= 6.0) return full * kBoundaryFractions[1];      // county
+    return full * kBoundaryFractions[2];                         // city and below
 }
 
 // A bridge is the same road, drawn higher up: its colour and width are its own
 // class's, borrowed rather than restated so the two cannot drift apart.
-Colour bridgeColour(const mvt::Layer& layer, const mvt::Feature& feature, const MapStyle_t& style)
+Colour bridgeColour(const mvt::LayerView& layer, const mvt::FeatureView& feature,
+                    const MapStyle_t& style)
 {
     return colourFor(roadLayerFor(roadPriority(layer.attributeTextView(feature, "class"))), style);
 }
 
-float bridgeHalfWidth(const mvt::Layer& layer, const mvt::Feature& feature, const MapStyle_t& style)
+float bridgeHalfWidth(const mvt::LayerView& layer, const mvt::FeatureView& feature,
+                      const MapStyle_t& style)
 {
     return halfWidthFor(roadLayerFor(roadPriority(layer.attributeTextView(feature, "class"))), style);
 }
@@ -301,7 +313,7 @@ float bridgeHalfWidth(const mvt::Layer& layer, const mvt::Feature& feature, cons
 // The casing is what separates the deck from whatever it crosses. One colour
 // for every class -- a bridge edge is a shadow, not a road -- and a fixed extra
 // width either side, so a wide road gets the same visual lip as a narrow one.
-Colour bridgeCasingColour(const mvt::Layer& layer, const mvt::Feature& feature,
+Colour bridgeCasingColour(const mvt::LayerView& layer, const mvt::FeatureView& feature,
                           const MapStyle_t& style)
 {
     (void)layer;
@@ -309,22 +321,28 @@ Colour bridgeCasingColour(const mvt::Layer& layer, const mvt::Feature& feature,
     return toRgba(style.bridge_casing);
 }
 
-float bridgeCasingHalfWidth(const mvt::Layer& layer, const mvt::Feature& feature,
-                            const MapStyle_t& style)
+// Shared with paintPalette() for the same reason as kBoundaryFractions.
+float casingAround(float fill, const MapStyle_t& style)
 {
-    const float fill = bridgeHalfWidth(layer, feature, style);
     // A zero-width road stays hidden on its bridge too, rather than showing as
     // a casing with nothing in it.
     return fill > 0.0f ? fill + float(style.widths.bridge_casing) : 0.0f;
 }
 
+float bridgeCasingHalfWidth(const mvt::LayerView& layer, const mvt::FeatureView& feature,
+                            const MapStyle_t& style)
+{
+    return casingAround(bridgeHalfWidth(layer, feature, style), style);
+}
+
 bool layerEnabled(MapLayer layer, const MapStyle_t& style)
 {
     const LayerSpec& spec = specFor(layer);
     return spec.enabled == nullptr || style.*(spec.enabled);
 }
 
-bool accepts(const LayerSpec& spec, const mvt::Layer& layer, const mvt::Feature& feature)
+bool accepts(const LayerSpec& spec, const mvt::LayerView& layer,
+             const mvt::FeatureView& feature)
 {
     if (spec.featureFilter != nullptr && !spec.featureFilter(layer, feature))
     {
@@ -349,7 +367,7 @@ bool accepts(const LayerSpec& spec, const mvt::Layer& layer, const mvt::Feature&
 constexpr float kMitreLimit = 4.0f;
 
 void emitPolyline(std::vector<MapVertex>& out, std::vector<std::uint32_t>& indices,
-                  const std::vector<mvt::Point>& ring, float sc, float halfPx, const Colour& c)
+                  std::span<const mvt::Point> ring, float sc, float halfPx, const Colour& c)
 {
     if (ring.size() < 2)
     {
@@ -508,28 +526,6 @@ void emitPolygon(std::vector<MapVertex>& out, std::vector<std::uint32_t>& indice
 
 } // namespace
 
-// Declared in tessellator.h; see the comment there. attributeRef, not
-// attribute: this runs per feature and the by-value read costs an allocation
-// for every string-typed attribute it touches on the way past.
-std::optional<double> attributeNumber(const mvt::Layer& layer, const mvt::Feature& feature,
-                                      std::string_view key)
-{
-    const mvt::Value* value = layer.attributeRef(feature, key);
-    if (value == nullptr)
-    {
-        return std::nullopt;
-    }
-    if (const auto* d = std::get_if<double>(value))
-    {
-        return *d;
-    }
-    if (const auto* i = std::get_if<std::int64_t>(value))
-    {
-        return double(*i);
-    }
-    return std::nullopt;
-}
-
 std::uint64_t nextSerial()
 {
     static std::atomic<std::uint64_t> counter { 1 };
@@ -599,7 +595,7 @@ float widthScaleForZoom(double zoom)
     return float(0.15 + (0.85 * t));
 }
 
-TileGeometry tessellate(const mvt::Tile& tile, const MapStyle_t& style)
+TileGeometry tessellate(mvt::TileView& tile, const MapStyle_t& style)
 {
     TileGeometry out;
     // A z14 city tile is ~70k vertices once expanded; reserving saves a dozen
@@ -609,6 +605,9 @@ TileGeometry tessellate(const mvt::Tile& tile, const MapStyle_t& style)
 
     // Reused across every polygon in the tile: cleared, never reallocated.
     std::vector<std::span<const mvt::Point>> polygon;
+    // And every feature's rings decode into this one buffer, which stops
+    // growing a few features into the tile. See mvt::Rings.
+    mvt::Rings rings;
 
     for (std::size_t li = 0; li < kMapLayerCount; ++li)
     {
@@ -621,7 +620,9 @@ TileGeometry tessellate(const mvt::Tile& tile, const MapStyle_t& style)
             continue;
         }
 
-        const mvt::Layer* layer = tile.layer(spec.sourceLayer);
+        // Indexed here, on first ask, so a layer every spec skips -- buildings
+        // with the style's buildings off, say -- is never parsed at all.
+        const mvt::LayerView* layer = tile.layer(spec.sourceLayer);
         if (layer == nullptr || layer->extent == 0)
         {
             continue;
@@ -650,13 +651,29 @@ TileGeometry tessellate(const mvt::Tile& tile, const MapStyle_t& style)
         // are the only thing whose ranges are worth recording. See FeatureRange.
         const bool trackRanges = std::string_view(spec.sourceLayer) == "transportation";
 
-        for (const mvt::Feature& feature : layer->features)
+        for (const mvt::FeatureView& feature : layer->features)
         {
             if (!accepts(spec, *layer, feature))
             {
                 continue;
             }
 
+            // The geometry is read only for a feature this layer will draw: a
+            // point, or a polygon in a line layer, is passed over as bytes. One
+            // that does not decode is skipped and reported on the tile, which
+            // is how the caller still learns the tile was bad.
+            const bool draws = spec.fill ? feature.type == mvt::GeomType::Polygon
+                                         : feature.type == mvt::GeomType::LineString;
+            if (!draws)
+            {
+                continue;
+            }
+            if (auto decoded = feature.rings(rings); !decoded)
+            {
+                tile.flag(decoded.error());
+                continue;
+            }
+
             const auto rangeStart = static_cast<std::uint32_t>(out.indices.size());
 
             switch (feature.type)
@@ -676,7 +693,7 @@ TileGeometry tessellate(const mvt::Tile& tile, const MapStyle_t& style)
                     // reads the rings, and nth<> already teaches it to read an
                     // mvt::Point directly, so a span is all it needs.
                     polygon.clear();
-                    for (const auto& ring : feature.rings)
+                    for (const std::span<const mvt::Point> ring : rings)
                     {
                         if (ring.size() < 3)
                         {
@@ -687,7 +704,7 @@ TileGeometry tessellate(const mvt::Tile& tile, const MapStyle_t& style)
                             emitPolygon(out.vertices, out.indices, polygon, sc, colour);
                             polygon.clear();
                         }
-                        polygon.emplace_back(ring.data(), ring.size());
+                        polygon.push_back(ring);
                     }
                     if (!polygon.empty())
                     {
@@ -718,7 +735,7 @@ TileGeometry tessellate(const mvt::Tile& tile, const MapStyle_t& style)
                     const Colour featureColour =
                         spec.featureColour != nullptr ? spec.featureColour(*layer, feature, style)
                                                       : colour;
-                    for (const auto& ring : feature.rings)
+                    for (const std::span<const mvt::Point> ring : rings)
                     {
                         emitPolyline(out.vertices, out.indices, ring, sc, featureHalfPx,
                                      featureColour);
@@ -756,4 +773,192 @@ TileGeometry tessellate(const mvt::Tile& tile, const MapStyle_t& style)
     return out;
 }
 
+TileGeometry tessellate(const mvt::Tile& tile, const MapStyle_t& style)
+{
+    // Through the wire format rather than a second walk over the decoded tree,
+    // so a hand-built tile exercises exactly the code a served one does. A
+    // tile that will not encode is one nothing could have served; it draws as
+    // nothing.
+    auto bytes = mvt::encode(tile);
+    if (!bytes)
+    {
+        return TileGeometry {};
+    }
+    auto view = mvt::TileView::open(*bytes);
+    if (!view)
+    {
+        return TileGeometry {};
+    }
+    return tessellate(*view, style);
+}
+
+PaintPalette paintPalette(const MapStyle_t& style)
+{
+    PaintPalette palette;
+    palette.reserve(kMapLayerCount + 5 + kBoundaryFractions.size());
+
+    // Each layer as its LayerSpec paints it, which is every vertex of a layer
+    // with no per-feature hook -- and every bridge deck, whose hooks return
+    // exactly its road layer's row.
+    for (std::size_t li = 0; li < kMapLayerCount; ++li)
+    {
+        const auto layer = static_cast<MapLayer>(li);
+        const Colour c = colourFor(layer, style);
+        palette.push_back(Paint { c.r, c.g, c.b, c.a, halfWidthFor(layer, style) });
+    }
+
+    // A bridge casing per road layer: one colour, the road's width plus the lip.
+    const Colour casing = toRgba(style.bridge_casing);
+    for (int priority = 1; priority <= 5; ++priority)
+    {
+        const float fill = halfWidthFor(roadLayerFor(priority), style);
+        palette.push_back(Paint { casing.r, casing.g, casing.b, casing.a,
+                                  casingAround(fill, style) });
+    }
+
+    // The boundary ladder below a country line, which is the layer's own row.
+    const Colour boundary = colourFor(MapLayer::Boundary, style);
+    const float full = float(style.widths.boundary);
+    for (const float fraction : kBoundaryFractions)
+    {
+        palette.push_back(
+            Paint { boundary.r, boundary.g, boundary.b, boundary.a, full * fraction });
+    }
+
+    return palette;
+}
+
+namespace
+{
+
+// A mitre length in [1, kMitreLimit] as a byte, and back. Both ends exact, so an
+// unmitred normal -- most of them -- comes back at exactly unit length.
+constexpr float kMitreStep = (kMitreLimit - 1.0f) / 255.0f;
+
+std::uint32_t snorm8(float value)
+{
+    const long q = std::lround(std::clamp(value, -1.0f, 1.0f) * 127.0f);
+    return static_cast<std::uint32_t>(static_cast<std::uint8_t>(static_cast<std::int8_t>(q)));
+}
+
+float fromSnorm8(std::uint32_t byte)
+{
+    const auto signedByte = static_cast<std::int8_t>(static_cast<std::uint8_t>(byte & 0xffU));
+    return std::max(float(signedByte) / 127.0f, -1.0f);
+}
+
+} // namespace
+
+bool packGeometry(TileGeometry& geometry, const PaintPalette& palette)
+{
+    if (geometry.isPacked() || geometry.vertices.empty() || palette.empty() ||
+        palette.size() > kMaxPaints)
+    {
+        return false;
+    }
+
+    std::vector<PackedVertex> packed(geometry.vertices.size());
+    // A layer is one paint, and most layers are long runs of it, so the entry
+    // the last vertex matched is nearly always the one this vertex wants.
+    std::size_t paint = 0;
+    for (std::size_t i = 0; i < geometry.vertices.size(); ++i)
+    {
+        const MapVertex& v = geometry.vertices[i];
+
+        const float qx = std::round(v.x * kPackedPositionScale);
+        const float qy = std::round(v.y * kPackedPositionScale);
+        // Written so a NaN fails too.
+        if (!(qx >= -32768.0f && qx <= 32767.0f && qy >= -32768.0f && qy <= 32767.0f))
+        {
+            return false;
+        }
+
+        const Paint wanted { v.r, v.g, v.b, v.a, v.halfPx };
+        if (!(palette[paint] == wanted))
+        {
+            const auto found = std::find(palette.begin(), palette.end(), wanted);
+            if (found == palette.end())
+            {
+                return false;
+            }
+            paint = static_cast<std::size_t>(found - palette.begin());
+        }
+
+        // Fills carry no normal at all, and keep it: the shader tells a fill
+        // from a line by exactly that.
+        std::uint32_t normal = 0;
+        const float length = std::sqrt((v.nx * v.nx) + (v.ny * v.ny));
+        if (length > 0.0f)
+        {
+            if (length < 1.0f - 1e-3f || length > kMitreLimit + 1e-3f)
+            {
+                return false;
+            }
+            const float mitre = std::clamp(length, 1.0f, kMitreLimit);
+            const auto mitreByte =
+                static_cast<std::uint32_t>(std::lround((mitre - 1.0f) / kMitreStep));
+            normal = snorm8(v.nx / length) | (snorm8(v.ny / length) << 8) | (mitreByte << 16);
+        }
+
+        packed[i].position = static_cast<std::uint32_t>(static_cast<std::uint16_t>(
+                                 static_cast<std::int16_t>(qx))) |
+                             (static_cast<std::uint32_t>(static_cast<std::uint16_t>(
+                                  static_cast<std::int16_t>(qy)))
+                              << 16);
+        packed[i].attributes = normal | (static_cast<std::uint32_t>(paint) << 24);
+    }
+
+    // 16-bit indices whenever the tile's vertices fit them. They are tile-local
+    // -- the renderer adds the base vertex per draw -- so it is the TILE that
+    // has to fit, not the frame.
+    if (geometry.vertices.size() <= 65536)
+    {
+        geometry.indices16.resize(geometry.indices.size());
+        std::transform(geometry.indices.begin(), geometry.indices.end(),
+                       geometry.indices16.begin(),
+                       [](std::uint32_t index) { return static_cast<std::uint16_t>(index); });
+        std::vector<std::uint32_t>().swap(geometry.indices);
+    }
+    else
+    {
+        geometry.indices.shrink_to_fit();
+    }
+
+    // Swapped out rather than cleared: clear() keeps the capacity, and
+    // tessellate() reserves a megabyte of it up front.
+    geometry.packed = std::move(packed);
+    std::vector<MapVertex>().swap(geometry.vertices);
+    geometry.roads.shrink_to_fit();
+    return true;
+}
+
+MapVertex unpackVertex(const PackedVertex& vertex, const PaintPalette& palette)
+{
+    MapVertex out;
+    out.x = float(static_cast<std::int16_t>(vertex.position & 0xffffU)) / kPackedPositionScale;
+    out.y = float(static_cast<std::int16_t>(vertex.position >> 16)) / kPackedPositionScale;
+
+    const float dx = fromSnorm8(vertex.attributes);
+    const float dy = fromSnorm8(vertex.attributes >> 8);
+    const float length = std::sqrt((dx * dx) + (dy * dy));
+    if (length > 0.0f)
+    {
+        const float mitre = 1.0f + (float((vertex.attributes >> 16) & 0xffU) * kMitreStep);
+        out.nx = (dx / length) * mitre;
+        out.ny = (dy / length) * mitre;
+    }
+
+    const std::size_t paint = vertex.attributes >> 24;
+    if (paint < palette.size())
+    {
+        const Paint& p = palette[paint];
+        out.r = p.r;
+        out.g = p.g;
+        out.b = p.b;
+        out.a = p.a;
+        out.halfPx = p.halfPx;
+    }
+    return out;
+}
+
 } // namespace map_widget
@@ -0,0 +1,368 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//
+// The disk tier behind the tile cache.
+//
+// Everything it gets wrong is drawn: a field dropped on the way to disk is a
+// road in the wrong colour or a label missing from one tile; a file from
+// another style is yesterday's map; a damaged file that loads is an index past
+// the end of a vertex buffer, which the GPU does not report. So the checks are
+// round trips and refusals, against a real directory.
+
+#include "map/disk_tile_cache.h"
+
+#include <spdlog/spdlog.h>
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+int failures = 0;
+
+void check(bool condition, const std::string& what)
+{
+    if (!condition)
+    {
+        SPDLOG_ERROR("FAIL: {}", what);
+        ++failures;
+    }
+}
+
+using map_widget::CachedTile;
+using map_widget::DiskTileCache;
+using map_widget::TileId;
+
+namespace fs = std::filesystem;
+
+constexpr std::uint64_t kStyle = 0x5ca1ab1eULL;
+const TileId kIrvine { 14, 2828, 6562 };
+
+// A fresh directory per test, so one test's files cannot satisfy another's.
+fs::path scratch(const std::string& name)
+{
+    const fs::path path = fs::temp_directory_path() /
+                          ("map_test_disk_tile_cache_" + std::to_string(::getpid())) / name;
+    fs::remove_all(path);
+    return path;
+}
+
+// Two layers' worth of triangles, a road range and two labels, one of them
+// outside the BMP -- enough that a section written at the wrong offset or a
+// string cut at the wrong length comes back visibly different.
+CachedTile sampleTile()
+{
+    auto geometry = std::make_shared<map_widget::TileGeometry>();
+    for (int i = 0; i < 6; ++i)
+    {
+        map_widget::MapVertex vertex;
+        vertex.x = float(i) * 0.1f;
+        vertex.y = 1.0f - (float(i) * 0.1f);
+        vertex.halfPx = float(i);
+        vertex.r = 0.25f;
+        geometry->vertices.push_back(vertex);
+    }
+    geometry->indices = { 0, 1, 2, 3, 4, 5 };
+    geometry->layerStart.fill(6);
+    geometry->layerIndexStart.fill(6);
+    geometry->layerStart[0] = 0;
+    geometry->layerIndexStart[0] = 0;
+    const auto water = static_cast<std::size_t>(map_widget::MapLayer::Water);
+    for (std::size_t i = 1; i <= water; ++i)
+    {
+        geometry->layerStart[i] = 3;
+        geometry->layerIndexStart[i] = 3;
+    }
+    geometry->roads.push_back(map_widget::FeatureRange { 4242, 3, 3 });
+
+    auto labels = std::make_shared<map_widget::LabelSet>();
+    map_widget::LabelCandidate place;
+    place.text = QString::fromUtf8("Irvine");
+    place.x = 0.5;
+    place.y = 0.25;
+    place.priority = 3;
+    place.magnitude = 307670;
+    labels->push_back(place);
+    map_widget::LabelCandidate road;
+    road.text = QString::fromUtf8("Jamboree Rd \xF0\x9F\x9A\x97");
+    road.spanLocal = 0.75;
+    road.kind = map_widget::LabelKind::Road;
+    road.oneLabelPerName = true;
+    labels->push_back(road);
+
+    return CachedTile { std::move(labels), std::move(geometry) };
+}
+
+// ============================================================================
+
+void test_a_tile_comes_back_as_it_went_in()
+{
+    DiskTileCache cache(scratch("round_trip"), 1 << 20, kStyle);
+    const CachedTile tile = sampleTile();
+    check(cache.store("socal", kIrvine, tile, false), "the tile is written");
+
+    const auto hit = cache.load("socal", kIrvine);
+    check(hit.has_value() && !hit->absent, "and read back, as a tile");
+    if (!hit)
+    {
+        return;
+    }
+    const map_widget::TileGeometry& in = *tile.geometry;
+    const map_widget::TileGeometry& out = *hit->tile.geometry;
+    check(out.vertices.size() == in.vertices.size() &&
+              std::memcmp(out.vertices.data(), in.vertices.data(),
+                          in.vertices.size() * sizeof(map_widget::MapVertex)) == 0,
+          "vertices byte for byte");
+    check(out.indices == in.indices, "indices");
+    check(out.layerStart == in.layerStart && out.layerIndexStart == in.layerIndexStart,
+          "the layer table");
+    check(out.layerIndexCount(map_widget::MapLayer::Landcover) == 3 &&
+              out.layerIndexCount(map_widget::MapLayer::Motorway) == 0,
+          "so each layer draws what it drew before");
+    int ranges = 0;
+    out.forEachRoadRange(4242, [&](const map_widget::FeatureRange& range) {
+        ranges += (range.indexStart == 3 && range.indexCount == 3) ? 1 : 0;
+    });
+    check(ranges == 1, "the road range the highlight joins on");
+    check(out.serial != in.serial,
+          "a fresh serial, so the renderer uploads it rather than trusting an old buffer");
+
+    const map_widget::LabelSet& labels = *hit->tile.labels;
+    check(labels.size() == 2, "both labels");
+    if (labels.size() == 2)
+    {
+        check(labels[0].text == QString::fromUtf8("Irvine") && labels[0].x == 0.5 &&
+                  labels[0].y == 0.25 && labels[0].priority == 3 &&
+                  labels[0].magnitude == 307670 &&
+                  labels[0].kind == map_widget::LabelKind::Place,
+              "a place label, field for field");
+        check(labels[1].text == (*tile.labels)[1].text && labels[1].spanLocal == 0.75 &&
+                  labels[1].kind == map_widget::LabelKind::Road && labels[1].oneLabelPerName,
+              "a road label, surrogate pair and all");
+    }
+
+    const auto stats = cache.stats();
+    check(stats.writes == 1 && stats.hits == 1 && stats.bytes > 0, "the counters saw it");
+}
+
+void test_absence_is_kept_too()
+{
+    DiskTileCache cache(scratch("absent"), 1 << 20, kStyle);
+    const TileId ocean { 14, 2700, 6600 };
+    cache.store("socal", ocean, CachedTile {}, true);
+
+    const auto hit = cache.load("socal", ocean);
+    check(hit.has_value() && hit->absent, "an absent tile is remembered as absent");
+    check(hit && hit->tile && hit->tile.geometry->empty() && hit->tile.labels->empty(),
+          "and comes back as the empty tile the memory cache holds for absence");
+}
+
+void test_another_style_or_tileset_is_a_miss()
+{
+    const fs::path root = scratch("keys");
+    {
+        DiskTileCache cache(root, 1 << 20, kStyle);
+        cache.store("socal", kIrvine, sampleTile(), false);
+        check(!cache.load("tracks", kIrvine).has_value(),
+              "one coordinate in two tilesets is two tiles");
+        check(!cache.load("socal", TileId { 14, 2828, 6563 }).has_value(),
+              "a neighbouring tile is not this one");
+
+        // Both used to become the directory "a_b".
+        cache.store("a.b", kIrvine, sampleTile(), false);
+        check(!cache.load("a_b", kIrvine).has_value(),
+              "tilesets that differ only where the directory name escapes are two tilesets");
+        cache.clear("a_b");
+        check(cache.load("a.b", kIrvine).has_value(), "and clearing one leaves the other");
+    }
+
+    DiskTileCache restyled(root, 1 << 20, kStyle + 1);
+    check(!restyled.load("socal", kIrvine).has_value(),
+          "a style edit does not draw the old style's triangles");
+    check(restyled.stats().rejected == 0, "and is a plain miss, not a damaged file");
+
+    DiskTileCache again(root, 1 << 20, kStyle);
+    check(again.load("socal", kIrvine).has_value(), "the original style still finds its tile");
+}
+
+void test_a_damaged_file_is_refused_and_removed()
+{
+    const fs::path root = scratch("damaged");
+    DiskTileCache cache(root, 1 << 20, kStyle);
+    cache.store("socal", kIrvine, sampleTile(), false);
+
+    fs::path file;
+    for (const auto& entry : fs::recursive_directory_iterator(root))
+    {
+        if (entry.path().extension() == ".mtile")
+        {
+            file = entry.path();
+        }
+    }
+    check(!file.empty(), "the tile is on disk as one file");
+
+    // Cut short, as a power cut on a filesystem without ordered writes would.
+    fs::resize_file(file, fs::file_size(file) - 8);
+    check(!cache.load("socal", kIrvine).has_value(), "a truncated file does not load");
+    check(!fs::exists(file), "and is deleted rather than refused on every paint");
+    check(cache.stats().rejected == 1, "and counted");
+
+    // Whole, but an index pointing past the vertices: exactly the damage that
+    // would reach the GPU if the reader trusted the file.
+    cache.store("socal", kIrvine, sampleTile(), false);
+    {
+        std::fstream bytes(file, std::ios::in | std::ios::out | std::ios::binary);
+        // The index section follows the 216-byte header and six 36-byte
+        // vertices, rounded up to 8: offset 432.
+        const std::uint32_t wild = 1000;
+        bytes.seekp(432);
+        bytes.write(reinterpret_cast<const char*>(&wild), sizeof(wild));
+    }
+    check(!cache.load("socal", kIrvine).has_value(), "an out-of-range index does not load");
+    check(cache.stats().rejected == 2, "and is counted as damage too");
+}
+
+// The form a TileSource actually keeps. It has to come back in that form -- a
+// reader that took the packed section for floats would upload a quarter of a
+// tile's worth of garbage -- and a paint index past the palette is refused like
+// any other out-of-range index.
+void test_a_packed_tile_comes_back_packed()
+{
+    const fs::path root = scratch("packed");
+    DiskTileCache cache(root, 1 << 20, kStyle);
+
+    // sampleTile()'s vertices are one colour at six widths: six paints.
+    map_widget::PaintPalette palette;
+    for (int i = 0; i < 6; ++i)
+    {
+        palette.push_back(map_widget::Paint { 0.25f, 0.f, 0.f, 1.f, float(i) });
+    }
+    CachedTile tile = sampleTile();
+    auto geometry = std::make_shared<map_widget::TileGeometry>(*tile.geometry);
+    check(map_widget::packGeometry(*geometry, palette), "the sample tile packs");
+    tile.geometry = geometry;
+
+    check(cache.store("socal", kIrvine, tile, false), "the packed tile is written");
+    const auto hit = cache.load("socal", kIrvine);
+    check(hit.has_value() && hit->tile.geometry->isPacked(), "and read back packed");
+    if (!hit)
+    {
+        return;
+    }
+    const map_widget::TileGeometry& out = *hit->tile.geometry;
+    check(out.vertices.empty() && out.indices.empty() &&
+              out.packed.size() == geometry->packed.size() &&
+              std::memcmp(out.packed.data(), geometry->packed.data(),
+                          geometry->packed.size() * sizeof(map_widget::PackedVertex)) == 0 &&
+              out.indices16 == geometry->indices16,
+          "vertices and 16-bit indices byte for byte");
+
+    fs::path file;
+    for (const auto& entry : fs::recursive_directory_iterator(root))
+    {
+        if (entry.path().extension() == ".mtile")
+        {
+            file = entry.path();
+        }
+    }
+    {
+        std::fstream bytes(file, std::ios::in | std::ios::out | std::ios::binary);
+        // The first vertex's paint: the top byte of its second word, just past
+        // the 216-byte header.
+        const char wild = char(0xff);
+        bytes.seekp(216 + 7);
+        bytes.write(&wild, 1);
+    }
+    check(!cache.load("socal", kIrvine).has_value(), "a paint past the palette does not load");
+    check(cache.stats().rejected == 1, "and is counted as damage");
+}
+
+void test_the_budget_holds_and_the_least_recent_goes()
+{
+    // Each sample tile is one 4 KiB block on the budget; six fit, and a prune
+    // goes down to three quarters, so four are left.
+    const fs::path root = scratch("budget");
+    DiskTileCache cache(root, 6 * 4096, kStyle);
+
+    const auto tile = [](std::uint32_t x) { return TileId { 14, x, 6562 }; };
+    for (std::uint32_t x = 0; x < 6; ++x)
+    {
+        cache.store("socal", tile(x), sampleTile(), false);
+        // Written an hour apart, oldest first. The filesystem's timestamps are
+        // too coarse to order six writes made in a microsecond.
+        for (const auto& entry : fs::recursive_directory_iterator(root))
+        {
+            if (entry.path().filename() == "6562.mtile" &&
+                entry.path().parent_path().filename() == std::to_string(x))
+            {
+                fs::last_write_time(entry.path(), fs::file_time_type::clock::now() -
+                                                      std::chrono::hours(6 - x));
+            }
+        }
+    }
+    check(cache.stats().pruned == 0 && cache.stats().bytes == 6 * 4096,
+          "six tiles fill the budget exactly");
+
+    // Read the oldest, which makes it the newest.
+    check(cache.load("socal", tile(0)).has_value(), "the oldest tile is drawn again");
+    cache.store("socal", tile(6), sampleTile(), false);
+
+    const auto stats = cache.stats();
+    check(stats.bytes <= stats.maxBytes, "the budget holds");
+    check(stats.pruned == 3, "down to three quarters of it, not one tile under");
+    check(cache.load("socal", tile(0)).has_value(), "the tile just drawn survives");
+    check(!cache.load("socal", tile(1)).has_value() && !cache.load("socal", tile(2)).has_value(),
+          "the least recently used go first");
+    check(cache.load("socal", tile(6)).has_value(), "and the one just written is kept");
+
+    DiskTileCache reopened(root, 6 * 4096, kStyle);
+    check(reopened.stats().bytes == stats.bytes, "a restart learns the same total from disk");
+    reopened.clear("socal");
+    check(reopened.stats().bytes == 0 && !reopened.load("socal", tile(0)).has_value(),
+          "clear() empties a tileset");
+}
+
+void test_the_style_hash_sees_every_field()
+{
+    MapStyle_t style;
+    const std::uint64_t base = map_widget::styleHash(style);
+    check(base == map_widget::styleHash(MapStyle_t {}), "the hash is stable for one style");
+
+    MapStyle_t wider = style;
+    wider.widths.motorway += 0.5;
+    check(map_widget::styleHash(wider) != base, "a width change is a different style");
+}
+
+} // namespace
+
+int main()
+{
+    spdlog::set_level(spdlog::level::info);
+    spdlog::set_pattern("[%^%l%$] %v");
+
+    test_a_tile_comes_back_as_it_went_in();
+    test_absence_is_kept_too();
+    test_another_style_or_tileset_is_a_miss();
+    test_a_damaged_file_is_refused_and_removed();
+    test_a_packed_tile_comes_back_packed();
+    test_the_budget_holds_and_the_least_recent_goes();
+    test_the_style_hash_sees_every_field();
+
+    fs::remove_all(fs::temp_directory_path() /
+                   ("map_test_disk_tile_cache_" + std::to_string(::getpid())));
+
+    if (failures != 0)
+    {
+        SPDLOG_ERROR("{} check(s) failed", failures);
+        return 1;
+    }
+
+    SPDLOG_INFO("all disk tile cache checks passed");
+    return 0;
+}
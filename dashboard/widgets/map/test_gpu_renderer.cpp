@@ -1223,6 +1223,159 @@ void test_an_overpass_draws_over_the_road_it_crosses()
     check(sawMotorway, "the motorway still draws either side of the overpass");
 }
 
+// ============================================================================
+// Packed vertices
+// ============================================================================
+
+// A tile with a bit of everything the packing has to carry: a fill, a road
+// with a corner for the mitre, and a bridge whose casing is a per-feature
+// paint rather than a layer's.
+mvt::Tile packingTile(std::int32_t crossX, std::int32_t crossY)
+{
+    mvt::Layer water;
+    water.name = "water";
+    water.extent = 4096;
+    mvt::Feature lake;
+    lake.type = mvt::GeomType::Polygon;
+    lake.rings.push_back({ { crossX - 600, crossY - 500 },
+                           { crossX - 100, crossY - 500 },
+                           { crossX - 100, crossY - 100 },
+                           { crossX - 600, crossY - 100 } });
+    water.features.push_back(std::move(lake));
+
+    mvt::Layer roads;
+    roads.name = "transportation";
+    roads.extent = 4096;
+    roads.keys = { "class", "brunnel" };
+    roads.values = { mvt::Value(std::in_place_type<std::string>, "motorway"),
+                     mvt::Value(std::in_place_type<std::string>, "minor"),
+                     mvt::Value(std::in_place_type<std::string>, "bridge"),
+                     mvt::Value(std::in_place_type<std::string>, "primary") };
+
+    mvt::Feature motorway;
+    motorway.type = mvt::GeomType::LineString;
+    motorway.rings.push_back({ { 0, crossY }, { 4096, crossY } });
+    motorway.tags = { 0, 0 };
+    roads.features.push_back(std::move(motorway));
+
+    mvt::Feature bridge;
+    bridge.type = mvt::GeomType::LineString;
+    bridge.rings.push_back({ { crossX, 0 }, { crossX, 4096 } });
+    bridge.tags = { 0, 1, 1, 2 };
+    roads.features.push_back(std::move(bridge));
+
+    // A dog-leg, so there is a joint whose mitre is not 1.
+    mvt::Feature bend;
+    bend.type = mvt::GeomType::LineString;
+    bend.rings.push_back({ { crossX + 200, crossY + 500 },
+                           { crossX + 500, crossY + 200 },
+                           { crossX + 900, crossY + 500 } });
+    bend.tags = { 0, 3 };
+    roads.features.push_back(std::move(bend));
+
+    mvt::Tile tile;
+    tile.layers.push_back(std::move(water));
+    tile.layers.push_back(std::move(roads));
+    return tile;
+}
+
+// The packed form is a storage decision, not a look. Drawn from eight bytes a
+// vertex, the same tile must land on the same pixels as it does from
+// thirty-six -- to within the quantisation, which at z14 is a sixteenth of a
+// pixel in position and well under a degree in direction.
+void test_a_packed_tile_draws_the_same_pixels()
+{
+    auto renderer = GpuRenderer::create();
+    if (!renderer)
+    {
+        return;
+    }
+
+    MapStyle_t style;
+    style.road_width_scale = 2.0;
+    const QColor background(0x16, 0x18, 0x1d);
+
+    const Projection projection(Camera { Coordinate { kIrvineLat, kIrvineLon }, 14.0, 0.0 },
+                                kWidth, kHeight);
+    const TileId id = centreTile(projection);
+    const auto origin = projection.tileOrigin(id);
+    const double tileSize = projection.tileScreenSize(id.z);
+    const auto crossX = std::int32_t(std::lround(((kWidth / 2.0) - origin.x) / tileSize * 4096.0));
+    const auto crossY =
+        std::int32_t(std::lround(((kHeight / 2.0) - origin.y) / tileSize * 4096.0));
+    const mvt::Tile tile = packingTile(crossX, crossY);
+
+    // Tessellated twice rather than copied: a copy would carry the same
+    // serial, and the renderer would rightly decide it had nothing to upload.
+    const auto floats = std::make_shared<const TileGeometry>(map_widget::tessellate(tile, style));
+    TileGeometry packedGeometry = map_widget::tessellate(tile, style);
+    check(map_widget::packGeometry(packedGeometry, map_widget::paintPalette(style)),
+          "the tile packs");
+    const auto packed = std::make_shared<const TileGeometry>(std::move(packedGeometry));
+
+    const QImage& floatFrame =
+        renderer->render(projection, { GpuBatch { id, floats } }, style, background);
+    if (floatFrame.isNull())
+    {
+        return;
+    }
+    const QImage expected = floatFrame.copy();
+    const GpuRenderer::Stats floatStats = renderer->stats();
+    check(!floatStats.packed, "float geometry draws as floats");
+
+    const QImage& packedFrame =
+        renderer->render(projection, { GpuBatch { id, packed } }, style, background);
+    const GpuRenderer::Stats packedStats = renderer->stats();
+    check(packedStats.packed, "packed geometry draws packed");
+    check(packedStats.vertices == floatStats.vertices && packedStats.indices == floatStats.indices,
+          "the same vertices and indices either way");
+    check(packedStats.vertexBytes * 4 < floatStats.vertexBytes,
+          "and under a quarter of the vertex bytes, " + std::to_string(packedStats.vertexBytes) +
+              " against " + std::to_string(floatStats.vertexBytes));
+    check(packedStats.indexBytes * 2 == floatStats.indexBytes, "and half the index bytes");
+
+    // Pixel for pixel, allowing for an edge pixel's coverage to move by the
+    // quantisation. A wrong paint, a lost normal or a misread sign is not an
+    // edge effect -- it is a whole road or fill of pixels.
+    const auto differing = [&](const QImage& frame) {
+        int count = 0;
+        int ink = 0;
+        for (int y = 0; y < frame.height(); ++y)
+        {
+            for (int x = 0; x < frame.width(); ++x)
+            {
+                const QColor want = expected.pixelColor(x, y);
+                ink += near(want, background, 6) ? 0 : 1;
+                count += near(frame.pixelColor(x, y), want, 24) ? 0 : 1;
+            }
+        }
+        check(ink > frame.width() * 10, "the reference frame has something on it");
+        return count;
+    };
+    const int packedDiff = differing(packedFrame);
+    check(packedDiff < (kWidth * kHeight) / 500,
+          "the packed tile draws the float tile's pixels, " + std::to_string(packedDiff) +
+              " differ");
+
+    // A frame with one float tile in it is drawn as floats, the packed tile
+    // unpacked on the way up -- and it must still look the same.
+    auto tiles = projection.visibleTiles(14, 0);
+    projection.sortCentreOutward(tiles);
+    if (tiles.size() < 2)
+    {
+        return;
+    }
+    const QImage& mixedFrame = renderer->render(
+        projection,
+        { GpuBatch { id, packed },
+          GpuBatch { tiles[1], fullTileQuad(MapLayer::Water, 1.0f, 0.0f, 0.0f) } },
+        style, background);
+    check(!renderer->stats().packed, "a mixed frame falls back to floats");
+    const QColor centre = mixedFrame.pixelColor(kWidth / 2, kHeight / 2);
+    check(near(centre, expected.pixelColor(kWidth / 2, kHeight / 2)),
+          "and the packed tile in it still draws its own pixels, got " + describe(centre));
+}
+
 void test_many_tiles_still_render()
 {
     // Every tile carries its own uniform block at a dynamic offset, and the
@@ -1585,6 +1738,7 @@ int main(int argc, char** argv)
     test_the_highlight_widens_by_extra_half_px();
     test_a_changed_highlight_invalidates_the_memo();
     test_an_overpass_draws_over_the_road_it_crosses();
+    test_a_packed_tile_draws_the_same_pixels();
     test_each_tile_draws_its_own_vertices();
     test_many_tiles_still_render();
     test_a_tile_with_no_geometry_is_harmless();
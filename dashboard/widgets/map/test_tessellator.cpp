@@ -16,6 +16,7 @@
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
 #include <memory>
@@ -718,12 +719,10 @@ void test_a_boundary_without_admin_level_keeps_full_weight()
 // This matters beyond the upload: TileCache is bounded by BYTES, so geometry at
 // under half the size is more than twice the tiles held for the same budget --
 // which is what keeps a pan back over ground already visited from re-fetching.
-void test_indexing_shrinks_a_tile_worth_of_geometry()
+// A tile-ish mix: a long winding road and a many-sided lake, which are the two
+// shapes the archive is mostly made of.
+mvt::Tile mixedTile()
 {
-    const MapStyle_t style;
-
-    // A tile-ish mix: a long winding road and a many-sided lake, which are the
-    // two shapes the archive is mostly made of.
     std::vector<mvt::Point> road;
     for (int i = 0; i < 200; ++i)
     {
@@ -754,8 +753,13 @@ void test_indexing_shrinks_a_tile_worth_of_geometry()
     mvt::Tile tile;
     tile.layers.push_back(std::move(roads));
     tile.layers.push_back(std::move(water));
+    return tile;
+}
 
-    const auto geometry = tessellate(tile, style);
+void test_indexing_shrinks_a_tile_worth_of_geometry()
+{
+    const MapStyle_t style;
+    const auto geometry = tessellate(mixedTile(), style);
     check(!geometry.indices.empty(), "the mixed tile produces geometry");
 
     const std::size_t indexed =
@@ -877,6 +881,114 @@ void test_an_archive_without_brunnel_draws_everything_at_grade()
     check(geometry.layerIndexCount(MapLayer::RoadBridge) == 0, "and nothing lands on the bridge layer");
 }
 
+// ============================================================================
+// Packing
+// ============================================================================
+
+// Everything the shader reads, read back out of the packed form. Positions and
+// paints must come back EXACTLY -- a position off by a unit is a seam between
+// tiles, a paint off by one is a road in the wrong colour -- and a normal to
+// within its byte, which is a hundredth of the line's width.
+void test_packing_keeps_every_vertex_the_shader_reads()
+{
+    const MapStyle_t style;
+    const map_widget::PaintPalette palette = map_widget::paintPalette(style);
+    const auto before = tessellate(mixedTile(), style);
+    auto after = tessellate(mixedTile(), style);
+
+    check(map_widget::packGeometry(after, palette), "a tessellated tile packs against its style");
+    check(after.isPacked() && after.vertices.empty() && after.indices.empty(),
+          "and gives up its float buffers for the packed ones");
+    check(after.vertexCount() == before.vertexCount() &&
+              after.indexCount() == before.indexCount() &&
+              after.layerStart == before.layerStart &&
+              after.layerIndexStart == before.layerIndexStart,
+          "the same counts and the same layer table");
+
+    bool indicesSame = after.indices16.size() == before.indices.size();
+    for (std::size_t i = 0; indicesSame && i < before.indices.size(); ++i)
+    {
+        indicesSame = after.indices16[i] == before.indices[i];
+    }
+    check(indicesSame, "the same triangles, in 16 bits");
+
+    float worstPosition = 0.0f;
+    float worstNormal = 0.0f;
+    bool paintsExact = true;
+    for (std::size_t i = 0; i < before.vertices.size(); ++i)
+    {
+        const MapVertex& want = before.vertices[i];
+        const MapVertex got = map_widget::unpackVertex(after.packed[i], palette);
+        worstPosition = std::max({ worstPosition, std::abs(got.x - want.x),
+                                   std::abs(got.y - want.y) });
+        worstNormal = std::max({ worstNormal, std::abs(got.nx - want.nx),
+                                 std::abs(got.ny - want.ny) });
+        paintsExact = paintsExact && got.r == want.r && got.g == want.g && got.b == want.b &&
+                      got.a == want.a && got.halfPx == want.halfPx;
+    }
+    check(worstPosition == 0.0f, "an extent-4096 position survives exactly");
+    check(worstNormal < 0.03f, "a normal survives to within its byte, off by " +
+                                   std::to_string(worstNormal));
+    check(paintsExact, "every colour and width comes back from the palette bit for bit");
+}
+
+// The point of it. The float tile also carries tessellate()'s up-front reserve,
+// which is what the cache was weighing; a packed tile is sized exactly.
+void test_packing_quarters_a_tile_worth_of_geometry()
+{
+    const MapStyle_t style;
+    auto geometry = tessellate(mixedTile(), style);
+    const std::size_t exact = (geometry.vertices.size() * sizeof(MapVertex)) +
+                              (geometry.indices.size() * sizeof(std::uint32_t));
+    map_widget::packGeometry(geometry, map_widget::paintPalette(style));
+    const std::size_t packed = (geometry.packed.capacity() * sizeof(map_widget::PackedVertex)) +
+                               (geometry.indices16.capacity() * sizeof(std::uint16_t));
+
+    check(packed * 3 < exact, "packing takes the tile under a third, reserve aside: " +
+                                  std::to_string(packed) + " bytes against " +
+                                  std::to_string(exact));
+}
+
+// Every per-feature paint the bridge and boundary hooks can pick is in the
+// palette. One that is not leaves its tile in floats -- correct, but four
+// times the size, which nothing would report.
+void test_every_paint_the_style_writes_is_in_its_palette()
+{
+    const MapStyle_t style;
+    const map_widget::PaintPalette palette = map_widget::paintPalette(style);
+    check(palette.size() <= map_widget::kMaxPaints, "the palette fits the renderer's block");
+
+    for (const char* className : { "motorway", "primary", "secondary", "minor", "rail" })
+    {
+        auto bridge = tessellate(
+            roadTileBrunnel(className, "bridge", { { 0, 2048 }, { 4096, 2048 } }), style);
+        check(map_widget::packGeometry(bridge, palette),
+              std::string("a ") + className + " bridge and its casing pack");
+    }
+    for (const std::int64_t level : { 2, 4, 6, 8 })
+    {
+        auto border = tessellate(boundaryTile(level), style);
+        check(map_widget::packGeometry(border, palette),
+              "an admin_level " + std::to_string(level) + " border packs");
+    }
+}
+
+// What cannot be packed is left alone rather than approximated: the float form
+// still draws.
+void test_what_does_not_fit_the_palette_stays_in_floats()
+{
+    const MapStyle_t style;
+    auto geometry = tessellate(roadTile("primary", { { 0, 2048 }, { 4096, 2048 } }), style);
+    geometry.vertices.front().r += 0.001f;
+    const std::size_t vertices = geometry.vertices.size();
+
+    check(!map_widget::packGeometry(geometry, map_widget::paintPalette(style)),
+          "a colour the style never wrote does not pack");
+    check(!geometry.isPacked() && geometry.vertices.size() == vertices &&
+              !geometry.indices.empty(),
+          "and the tile is left exactly as it was");
+}
+
 int main()
 {
     spdlog::set_level(spdlog::level::info);
@@ -922,6 +1034,11 @@ int main()
     test_width_scale_tapers_with_zoom();
     test_an_empty_tile_yields_nothing_but_valid_offsets();
 
+    test_packing_keeps_every_vertex_the_shader_reads();
+    test_packing_quarters_a_tile_worth_of_geometry();
+    test_every_paint_the_style_writes_is_in_its_palette();
+    test_what_does_not_fit_the_palette_stays_in_floats();
+
     if (failures != 0)
     {
         SPDLOG_ERROR("{} check(s) failed", failures);
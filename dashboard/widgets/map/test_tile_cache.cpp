@@ -241,6 +241,39 @@ void test_clear_forgets_everything_including_the_weight()
     check(cache.nextEviction() == nullptr, "with nothing queued to evict");
 }
 
+// The budget is only as good as the weighing. A packed tile has to be charged
+// for what it holds -- nothing, and the cache grows without bound; the float
+// price, and the packing buys no extra tiles at all.
+void test_a_packed_tile_weighs_what_it_holds()
+{
+    constexpr std::size_t kVertices = 24000;
+    auto geometry = std::make_shared<map_widget::TileGeometry>();
+    geometry->vertices.resize(kVertices);
+    geometry->indices.resize(kVertices * 3);
+    for (std::size_t i = 0; i < geometry->indices.size(); ++i)
+    {
+        geometry->indices[i] = static_cast<std::uint32_t>(i % kVertices);
+    }
+    geometry->layerStart.fill(static_cast<std::uint32_t>(kVertices));
+    geometry->layerStart[0] = 0;
+    geometry->layerIndexStart.fill(static_cast<std::uint32_t>(kVertices * 3));
+    geometry->layerIndexStart[0] = 0;
+
+    CachedTile tile;
+    tile.labels = std::make_shared<map_widget::LabelSet>();
+    tile.geometry = geometry;
+    const std::size_t floats = map_widget::approximateBytes(tile);
+
+    // A default MapVertex is a black fill, which this one-entry palette holds.
+    check(map_widget::packGeometry(*geometry, { map_widget::Paint {} }), "the tile packs");
+    const std::size_t packed = map_widget::approximateBytes(tile);
+
+    check(packed * 3 < floats, "a packed tile weighs under a third of the float one: " +
+                                   std::to_string(packed) + " against " + std::to_string(floats));
+    check(packed > kVertices * sizeof(map_widget::PackedVertex),
+          "and is still charged for every vertex and index it keeps");
+}
+
 } // namespace
 
 int main()
@@ -259,6 +292,7 @@ int main()
 
     test_replacing_a_tile_does_not_leak_its_weight();
     test_clear_forgets_everything_including_the_weight();
+    test_a_packed_tile_weighs_what_it_holds();
 
     if (failures != 0)
     {
@@ -15,8 +15,16 @@ std::size_t approximateBytes(const CachedTile& tile)
 
     if (tile.geometry)
     {
+        // Every buffer, in whichever form it is. Counting only the float
+        // vertices undercharged a float tile by its indices -- a third of it --
+        // and would charge a packed one nothing at all.
+        const TileGeometry& geometry = *tile.geometry;
         bytes += sizeof(TileGeometry);
-        bytes += tile.geometry->vertices.capacity() * sizeof(MapVertex);
+        bytes += geometry.vertices.capacity() * sizeof(MapVertex);
+        bytes += geometry.packed.capacity() * sizeof(PackedVertex);
+        bytes += geometry.indices.capacity() * sizeof(std::uint32_t);
+        bytes += geometry.indices16.capacity() * sizeof(std::uint16_t);
+        bytes += geometry.roads.capacity() * sizeof(FeatureRange);
     }
 
     if (tile.labels)
@@ -87,7 +95,7 @@ bool TileCache::drawable(const TileId& id)
     // INDICES, not vertices: since the geometry is indexed, the indices are
     // what a draw call consumes. A tile with vertices and no indices draws
     // nothing, and offering it as a stand-in would spend a draw slot on it.
-    return tile != nullptr && tile->geometry && !tile->geometry->indices.empty();
+    return tile != nullptr && tile->geometry && !tile->geometry->empty();
 }
 
 const TileId* TileCache::nextEviction() const
@@ -4,8 +4,8 @@
 
 #include "map/labels.h"
 
-#include "mvt/decode.h"
 #include "mvt/gzip.h"
+#include "mvt/view.h"
 
 #include "pub_sub/zenoh_async_client.h"
 
@@ -32,6 +32,18 @@ namespace
 // from where the driver is looking.
 constexpr std::size_t kMaxTilesPerRequest = 64;
 
+// How many tiles one request() may take off the disk tier.
+//
+// The disk tier is read on the GUI thread, inside the paint that asked, because
+// a hit is an mmap and a copy -- a fraction of a millisecond for a dense tile --
+// and handing it to a thread would cost a mailbox round trip to save that. But
+// a cold start asks for the whole viewport at once, and sixty-odd downtown
+// tiles in one paint is a visible hitch. Past this many, the rest wait: every
+// hit posts a drain, the drain repaints, and the repaint's request() takes the
+// next few, so a warm viewport fills in over a handful of frames rather than
+// stalling one.
+constexpr std::size_t kMaxDiskLoadsPerRequest = 16;
+
 // How long to wait before asking again for a tile whose request FAILED, and
 // the ceiling the doubling stops at. The first wait is deliberately short: the
 // common failure is map_server not being up yet when the dashboard starts, and
@@ -54,10 +66,13 @@ using Client = pub_sub::ZenohAsyncClient<::MapTileRequest, ::MapTileResponse>;
 } // namespace
 
 TileSource::TileSource(std::string tilesetName, std::string tileKey, std::uint64_t timeoutMs,
-                       MapStyle_t style, std::function<void()> onTilesReady) :
+                       MapStyle_t style, std::function<void()> onTilesReady,
+                       std::shared_ptr<DiskTileCache> disk) :
     mTileset(std::move(tilesetName)),
     mStyle(std::move(style)),
+    mPalette(paintPalette(mStyle)),
     mOnTilesReady(std::move(onTilesReady)),
+    mDisk(std::move(disk)),
     mClient(std::make_unique<Client>(std::move(tileKey), timeoutMs))
 {
 }
@@ -130,7 +145,11 @@ void TileSource::request(const std::vector<TileId>& wanted)
             }
             ask.push_back(id);
         }
-        mStats.requested += ask.size();
+    }
+
+    if (mDisk && !ask.empty())
+    {
+        ask = loadFromDisk(std::move(ask));
     }
 
     if (ask.empty())
@@ -138,6 +157,11 @@ void TileSource::request(const std::vector<TileId>& wanted)
         return;
     }
 
+    {
+        const std::lock_guard<std::mutex> guard(mMutex);
+        mStats.requested += ask.size();
+    }
+
     const bool sent = mClient->request(
         [this, &ask](::MapTileRequest::Builder& builder) {
             builder.setTileset(mTileset);
@@ -314,10 +338,15 @@ void TileSource::deliverResult(const TileId& id, Outcome outcome,
             // The normal answer for most of the pyramid. Cached as an empty
             // tile so it is not asked for again every frame -- an absent tile
             // re-requested forever is a steady stream of queries for nothing.
-            deliver(id,
-                    CachedTile { std::make_shared<const LabelSet>(),
-                                 std::make_shared<const TileGeometry>() },
-                    true, false);
+            {
+                CachedTile empty { std::make_shared<const LabelSet>(),
+                                   std::make_shared<const TileGeometry>() };
+                if (mDisk)
+                {
+                    mDisk->store(mTileset, id, empty, true);
+                }
+                deliver(id, std::move(empty), true, false);
+            }
             return;
 
         case Outcome::Failed:
@@ -336,7 +365,9 @@ void TileSource::deliverResult(const TileId& id, Outcome outcome,
         return;
     }
 
-    auto tile = mvt::decode(*raw);
+    // Opened in place, not decoded: the tessellator and the label pass read
+    // through views into `raw`, which therefore outlives both. See mvt/view.h.
+    auto tile = mvt::TileView::open(*raw);
     if (!tile)
     {
         SPDLOG_ERROR("[map] tile {}/{}/{}: {}", id.z, id.x, id.y, mvt::to_string(tile.error()));
@@ -348,12 +379,85 @@ void TileSource::deliverResult(const TileId& id, Outcome outcome,
     // GUI thread when the tile is first drawn. Both are the expensive steps
     // and both results are reused every frame; doing them on arrival means
     // the frame that shows a new tile costs the same as the frame before it.
-    // The decoded tile itself dies right here -- the cache keeps only what
-    // the paint pass actually reads.
-    auto geometry = std::make_shared<const TileGeometry>(tessellate(*tile, mStyle));
-    auto labels = std::make_shared<const LabelSet>(extractLabels(*tile));
+    // The tile bytes die right here -- the cache keeps only what the paint
+    // pass actually reads.
+    //
+    // Packed before anything keeps it: the cache, the disk tier and the GPU
+    // all hold the eight-byte form. A tile that will not pack stays in floats
+    // and draws the same -- see packGeometry().
+    TileGeometry tessellated = tessellate(*tile, mStyle);
+    LabelSet extracted = extractLabels(*tile);
+
+    // Whatever the two passes read and could not parse. decode() would have
+    // refused this tile before either ran; the views only find out on the way
+    // through, and the answer is the same -- a bad tile is not cached, on disk
+    // least of all, where it would outlive the fix.
+    if (tile->error())
+    {
+        SPDLOG_ERROR("[map] tile {}/{}/{}: {}", id.z, id.x, id.y, mvt::to_string(*tile->error()));
+        deliver(id, CachedTile {}, false, true);
+        return;
+    }
+
+    packGeometry(tessellated, mPalette);
+    auto geometry = std::make_shared<const TileGeometry>(std::move(tessellated));
+    auto labels = std::make_shared<const LabelSet>(std::move(extracted));
+    CachedTile cached { std::move(labels), std::move(geometry) };
+
+    // Here, on the worker, while the tile is hot: a write is a few hundred
+    // kilobytes at worst and this thread has just spent two milliseconds
+    // tessellating. A failed write costs nothing but the next cold start.
+    if (mDisk)
+    {
+        mDisk->store(mTileset, id, cached, false);
+    }
+
+    deliver(id, std::move(cached), false, false);
+}
+
+std::vector<TileId> TileSource::loadFromDisk(std::vector<TileId> ask)
+{
+    // Everything in `ask` is already marked in flight, which is what stops the
+    // next paint asking again while this one is loading it.
+    std::vector<TileId> remote;
+    remote.reserve(ask.size());
+
+    std::size_t loaded = 0;
+    std::size_t next = 0;
+    for (; next < ask.size() && loaded < kMaxDiskLoadsPerRequest; ++next)
+    {
+        const TileId& id = ask[next];
+        auto hit = mDisk->load(mTileset, id);
+        if (!hit)
+        {
+            remote.push_back(id);
+            continue;
+        }
+        ++loaded;
+        {
+            const std::lock_guard<std::mutex> guard(mMutex);
+            ++mStats.fromDisk;
+        }
+        // Into the mailbox like a reply, so the cache is still only ever
+        // written by drain() and the eviction policy sees nothing new.
+        deliver(id, std::move(hit->tile), hit->absent, false);
+    }
+
+    if (next < ask.size())
+    {
+        // Over the cap, and not yet looked for on disk. Sending these to the
+        // server would refetch tiles that are very likely a few frames from
+        // being loaded locally, so they go back to not being in flight and
+        // the repaint the hits above have already posted asks for them again.
+        const std::lock_guard<std::mutex> guard(mMutex);
+        for (; next < ask.size(); ++next)
+        {
+            mInFlight.erase(ask[next]);
+            ++mStats.deferred;
+        }
+    }
 
-    deliver(id, CachedTile { std::move(labels), std::move(geometry) }, false, false);
+    return remote;
 }
 
 void TileSource::failBatch(const std::vector<TileId>& ids)
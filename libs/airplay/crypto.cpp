@@ -406,24 +406,34 @@ Bytes chachaSeal(const Bytes& key, const Bytes& nonce, const Bytes& plaintext, c
 std::optional<Bytes> chachaOpen(const Bytes& key, const Bytes& nonce, const Bytes& ciphertext_with_tag,
                                 const Bytes& aad)
 {
-    if (key.size() != kChachaKeySize || nonce.size() != kChachaNonceSize ||
-        ciphertext_with_tag.size() < kChachaTagSize)
+    Bytes out = ciphertext_with_tag;
+    if (!chachaOpenInPlace(key, nonce, out, aad))
     {
-        SPDLOG_ERROR("[airplay] chachaOpen: bad sizes (key {} bytes, nonce {} bytes, input {} bytes)", key.size(),
-                     nonce.size(), ciphertext_with_tag.size());
         return std::nullopt;
     }
+    out.resize(out.size() - kChachaTagSize);
+    return out;
+}
 
-    const size_t body = ciphertext_with_tag.size() - kChachaTagSize;
+bool chachaOpenInPlace(const Bytes& key, const Bytes& nonce, std::span<uint8_t> sealed,
+                       std::span<const uint8_t> aad)
+{
+    if (key.size() != kChachaKeySize || nonce.size() != kChachaNonceSize || sealed.size() < kChachaTagSize)
+    {
+        SPDLOG_ERROR("[airplay] chachaOpen: bad sizes (key {} bytes, nonce {} bytes, input {} bytes)", key.size(),
+                     nonce.size(), sealed.size());
+        return false;
+    }
+
+    const size_t body = sealed.size() - kChachaTagSize;
 
     CipherCtxPtr ctx(EVP_CIPHER_CTX_new());
     if (!ctx || EVP_DecryptInit_ex(ctx.get(), EVP_chacha20_poly1305(), nullptr, nullptr, nullptr) != 1 ||
         EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_AEAD_SET_IVLEN, static_cast<int>(kChachaNonceSize), nullptr) != 1 ||
         EVP_DecryptInit_ex(ctx.get(), nullptr, nullptr, key.data(), nonce.data()) != 1)
     {
-        SPDLOG_ERROR("[airplay] chachaOpen: init failed (input {} bytes, aad {} bytes)", ciphertext_with_tag.size(),
-                     aad.size());
-        return std::nullopt;
+        SPDLOG_ERROR("[airplay] chachaOpen: init failed (input {} bytes, aad {} bytes)", sealed.size(), aad.size());
+        return false;
     }
 
     int length = 0;
@@ -431,33 +441,37 @@ std::optional<Bytes> chachaOpen(const Bytes& key, const Bytes& nonce, const Byte
         EVP_DecryptUpdate(ctx.get(), nullptr, &length, aad.data(), static_cast<int>(aad.size())) != 1)
     {
         SPDLOG_ERROR("[airplay] chachaOpen: aad update failed ({} bytes)", aad.size());
-        return std::nullopt;
+        return false;
     }
 
-    Bytes out(body);
+    // Output over input. OpenSSL allows exactly this much overlap for a stream
+    // cipher -- the same pointer, not a shifted one -- and ChaCha20 is one.
     if (body > 0 &&
-        EVP_DecryptUpdate(ctx.get(), out.data(), &length, ciphertext_with_tag.data(), static_cast<int>(body)) != 1)
+        EVP_DecryptUpdate(ctx.get(), sealed.data(), &length, sealed.data(), static_cast<int>(body)) != 1)
     {
         SPDLOG_ERROR("[airplay] chachaOpen: decrypt failed ({} bytes)", body);
-        return std::nullopt;
+        return false;
     }
 
-    // EVP_CTRL_AEAD_SET_TAG wants a mutable pointer even though it only reads.
-    Bytes tag(ciphertext_with_tag.begin() + static_cast<ptrdiff_t>(body), ciphertext_with_tag.end());
-    if (EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_AEAD_SET_TAG, static_cast<int>(kChachaTagSize), tag.data()) != 1)
+    // The tag sits after the body and decryption never touches it, so it can
+    // be handed over where it is. EVP_CTRL_AEAD_SET_TAG only reads it.
+    if (EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_AEAD_SET_TAG, static_cast<int>(kChachaTagSize),
+                            sealed.data() + body) != 1)
     {
         SPDLOG_ERROR("[airplay] chachaOpen: tag install failed");
-        return std::nullopt;
+        return false;
     }
 
+    // ChaCha20-Poly1305 finalises with no output; the pointer only has to be
+    // somewhere it would be legal to write.
     int final_length = 0;
-    if (EVP_DecryptFinal_ex(ctx.get(), out.data() + body, &final_length) != 1)
+    if (EVP_DecryptFinal_ex(ctx.get(), sealed.data() + body, &final_length) != 1)
     {
         SPDLOG_ERROR("[airplay] chachaOpen: authentication failed ({} bytes ciphertext, {} bytes aad)", body,
                      aad.size());
-        return std::nullopt;
+        return false;
     }
-    return out;
+    return true;
 }
 
 Bytes nonce64(uint64_t counter)
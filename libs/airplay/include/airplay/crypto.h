@@ -5,6 +5,7 @@
 
 #include <cstdint>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -56,6 +57,13 @@ Bytes chachaSeal(const Bytes& key, const Bytes& nonce, const Bytes& plaintext, c
 // Returns nullopt when authentication fails.
 std::optional<Bytes> chachaOpen(const Bytes& key, const Bytes& nonce, const Bytes& ciphertext_with_tag,
                                 const Bytes& aad = {});
+// The same, decrypting over the ciphertext rather than into a new buffer: on
+// success the first sealed.size() - 16 bytes of `sealed` are the plaintext. For
+// the screen stream, where a frame can be megabytes and a second buffer per
+// frame is nothing but a copy. On failure the contents are unauthenticated and
+// must be discarded.
+bool chachaOpenInPlace(const Bytes& key, const Bytes& nonce, std::span<uint8_t> sealed,
+                       std::span<const uint8_t> aad = {});
 
 // 12-byte nonce: 4 zero bytes followed by the little-endian counter.
 Bytes nonce64(uint64_t counter);
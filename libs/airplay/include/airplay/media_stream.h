@@ -22,6 +22,9 @@
 #include <atomic>
 #include <cstdint>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -30,10 +33,40 @@ namespace airplay
 
 using Bytes = std::vector<uint8_t>;
 
+// Receive buffers for the screen stream, recycled rather than allocated per
+// frame. A buffer is handed out by shared handle and goes back to the pool when
+// the last handle to it is dropped -- normally as soon as the packet handler
+// returns, but later if the handler kept one, and from whichever thread that
+// happens on. A buffer still held when the pool has enough spare is freed
+// instead, so a consumer that keeps frames costs memory, never correctness.
+class BufferPool
+{
+  public:
+    // Exactly `size` bytes. The contents are whatever the buffer last held.
+    std::shared_ptr<Bytes> acquire(size_t size);
+
+  private:
+    struct State
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<Bytes>> spare;
+    };
+
+    // Shared with every outstanding handle's deleter, so a buffer released
+    // after the pool itself is gone still has somewhere to go.
+    std::shared_ptr<State> state_ = std::make_shared<State>();
+};
+
 // Decoded media handed up for publishing.
 struct VideoPacket
 {
-    Bytes data;  // Annex-B
+    // Annex-B, a view into `buffer`. For a frame that is the receive buffer the
+    // frame arrived in -- decrypted and rewritten where it lay -- so copying a
+    // packet copies a handle, never the bytes.
+    std::span<const uint8_t> data;
+    // What keeps `data` alive. Hold this, not `data`, to keep a frame past the
+    // handler call.
+    std::shared_ptr<const Bytes> buffer;
     uint64_t timestamp = 0;
     bool keyframe = false;
     // True for the codec parameter sets rather than a frame. zenoh has no
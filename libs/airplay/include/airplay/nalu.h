@@ -5,6 +5,7 @@
 
 #include <cstdint>
 #include <optional>
+#include <span>
 #include <vector>
 
 namespace airplay::nalu
@@ -26,6 +27,14 @@ enum class Codec
 // Rewrites a run of length-prefixed NAL units to Annex-B. length_size is 1..4.
 Bytes avccFrameToAnnexB(const Bytes& frame, size_t length_size = 4);
 
+// The same rewrite, in place, for the 4-byte prefix every CarPlay frame uses: a
+// prefix and a start code are both four bytes, so each is overwritten where it
+// stands and the NAL units never move. Returns how many leading bytes of
+// `frame` are now Annex-B -- the same bytes avccFrameToAnnexB() would have
+// returned, so shorter than the frame when it ends in something that cannot be
+// a NAL unit, and 0 when there is none. Past that the contents are unchanged.
+size_t avccFrameToAnnexBInPlace(std::span<uint8_t> frame);
+
 struct Config
 {
     Codec codec = Codec::H264;
@@ -42,7 +51,7 @@ std::optional<Config> configToAnnexB(const Bytes& payload);
 // Keyframe detection for the node layer's isKeyframe flag: IDR (type 5) for
 // H.264, IRAP (types 16..23) for H.265.
 bool avccContainsKeyframe(const Bytes& frame, Codec codec, size_t length_size = 4);
-bool annexBContainsKeyframe(const Bytes& stream, Codec codec);
+bool annexBContainsKeyframe(std::span<const uint8_t> stream, Codec codec);
 
 // True when this single NAL unit header byte (or the first byte of a two-byte
 // H.265 header) marks a keyframe slice.
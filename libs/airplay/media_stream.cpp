@@ -12,6 +12,7 @@
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include <array>
 #include <cerrno>
 #include <chrono>
 #include <cstdio>
@@ -21,6 +22,47 @@
 namespace airplay
 {
 
+namespace
+{
+
+// How many spare receive buffers the pool keeps. The stream thread holds one
+// frame at a time and the handler normally lets go before the next arrives, so
+// one would do; the rest absorb a consumer that holds a frame a little longer.
+// Beyond this a returned buffer is freed, because a spare I-frame buffer is
+// megabytes.
+constexpr size_t kMaxSpareBuffers = 4;
+
+}  // namespace
+
+std::shared_ptr<Bytes> BufferPool::acquire(size_t size)
+{
+    std::unique_ptr<Bytes> buffer;
+    {
+        const std::lock_guard<std::mutex> lock(state_->mutex);
+        if (!state_->spare.empty())
+        {
+            buffer = std::move(state_->spare.back());
+            state_->spare.pop_back();
+        }
+    }
+    if (!buffer)
+    {
+        buffer = std::make_unique<Bytes>();
+    }
+    // Within the capacity a buffer has already grown to, this only moves the
+    // end; the pool settles at the size of the largest frame seen.
+    buffer->resize(size);
+
+    return std::shared_ptr<Bytes>(buffer.release(), [state = state_](Bytes* returned) {
+        std::unique_ptr<Bytes> owned(returned);
+        const std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->spare.size() < kMaxSpareBuffers)
+        {
+            state->spare.push_back(std::move(owned));
+        }
+    });
+}
+
 void runScreenStream(int listen_fd, Bytes key, const std::atomic<bool>& run,
                      const std::function<void(const VideoPacket&)>& on_packet,
                      const std::function<void(int64_t)>& on_keyframe)
@@ -30,6 +72,10 @@ void runScreenStream(int listen_fd, Bytes key, const std::atomic<bool>& run,
     constexpr uint8_t kOpVideoFrame = 0;
     constexpr uint8_t kOpVideoConfig = 1;
 
+    // Outlives every connection, so a reconnecting phone reuses the buffers
+    // the last one grew.
+    BufferPool pool;
+
     while (run.load())
     {
         pollfd listen_pfd{listen_fd, POLLIN, 0};
@@ -44,8 +90,22 @@ void runScreenStream(int listen_fd, Bytes key, const std::atomic<bool>& run,
         }
         SPDLOG_INFO("[video] screen stream connected");
 
-        Bytes buffer;
-        Bytes chunk(65536);
+        // One message at a time, each read straight to where it is used: the
+        // header into a fixed array, the body into a pooled buffer sized from
+        // the header. The body is then decrypted and rewritten to Annex-B in
+        // that same buffer, and handed up by handle.
+        //
+        // This used to accumulate the socket into one growing vector, copy the
+        // body out of it, erase it from the front, decrypt into a new buffer,
+        // copy that, rewrite it into another, and copy that into the packet --
+        // six passes over every frame besides the recv itself, at 60 fps and
+        // megabytes each for an I-frame.
+        std::array<uint8_t, kHeaderLength> header{};
+        size_t header_received = 0;
+        std::shared_ptr<Bytes> body;
+        size_t body_size = 0;
+        size_t body_received = 0;
+
         uint64_t counter = 0;
         uint64_t frames = 0;
         Bytes last_config;  // dedupe the (unchanging) codec-config log
@@ -76,149 +136,178 @@ void runScreenStream(int listen_fd, Bytes key, const std::atomic<bool>& run,
             {
                 continue;
             }
-            const ssize_t n = ::recv(client, chunk.data(), chunk.size(), 0);
-            if (n <= 0)
-            {
-                break;
-            }
-            buffer.insert(buffer.end(), chunk.begin(), chunk.begin() + n);
 
-            while (buffer.size() >= kHeaderLength)
+            // One recv per poll, into whichever half of the message is
+            // outstanding. A blocking recv for the body straight after the
+            // header would stop watching `run` for as long as the phone took
+            // to send it.
+            if (header_received < kHeaderLength)
             {
-                const size_t body_size = static_cast<size_t>(buffer[0]) |
-                                         (static_cast<size_t>(buffer[1]) << 8) |
-                                         (static_cast<size_t>(buffer[2]) << 16) |
-                                         (static_cast<size_t>(buffer[3]) << 24);
+                const ssize_t n = ::recv(client, header.data() + header_received,
+                                         kHeaderLength - header_received, 0);
+                if (n <= 0)
+                {
+                    break;
+                }
+                header_received += static_cast<size_t>(n);
+                if (header_received < kHeaderLength)
+                {
+                    continue;
+                }
+
+                body_size = static_cast<size_t>(header[0]) |
+                            (static_cast<size_t>(header[1]) << 8) |
+                            (static_cast<size_t>(header[2]) << 16) |
+                            (static_cast<size_t>(header[3]) << 24);
                 if (body_size > kMaxBody)
                 {
+                    // Nothing after this can be framed: the next header is at
+                    // an offset this one lied about.
                     SPDLOG_ERROR("[video] implausible body size {}, dropping connection",
                                  body_size);
-                    buffer.clear();
                     break;
                 }
-                if (buffer.size() < kHeaderLength + body_size)
+                body = pool.acquire(body_size);
+                body_received = 0;
+                if (body_size > 0)
+                {
+                    continue;
+                }
+            }
+            else
+            {
+                const ssize_t n = ::recv(client, body->data() + body_received,
+                                         body_size - body_received, 0);
+                if (n <= 0)
                 {
                     break;
                 }
+                body_received += static_cast<size_t>(n);
+                if (body_received < body_size)
+                {
+                    continue;
+                }
+            }
 
-                const Bytes header(buffer.begin(), buffer.begin() + kHeaderLength);
-                const Bytes body(buffer.begin() + kHeaderLength,
-                                 buffer.begin() + kHeaderLength + body_size);
-                buffer.erase(buffer.begin(),
-                             buffer.begin() + static_cast<long>(kHeaderLength + body_size));
-
-                const auto mark_sync_point = [&on_keyframe] {
-                    if (on_keyframe)
-                    {
-                        on_keyframe(
-                            std::chrono::steady_clock::now().time_since_epoch().count());
-                    }
-                };
+            // A whole message. Released at the end of this iteration, back to
+            // the pool unless the handler kept a handle to it.
+            header_received = 0;
+            const std::shared_ptr<Bytes> message = std::move(body);
 
-                const uint8_t opcode = header[4];
-                if (opcode == kOpVideoConfig)
+            const auto mark_sync_point = [&on_keyframe] {
+                if (on_keyframe)
                 {
-                    // A config is a sync point; record it so the keyframe thread
-                    // does not nudge the phone while the stream already produces
-                    // its own. (P-frames must NOT count, or a static screen that
-                    // only sends P-frames would never trigger a nudge.)
-                    mark_sync_point();
-                    const auto config = nalu::configToAnnexB(body);
-                    if (!config)
-                    {
-                        // The phone opens the screen stream with an empty
-                        // opcode-1 message; that is not a failure, and warning
-                        // about it on every connection trains you to ignore
-                        // this line when it does mean something. Log the header
-                        // at debug so the message can still be identified.
-                        if (body.empty())
-                        {
-                            SPDLOG_DEBUG("[video] empty codec config at stream start, header "
-                                         "{:02x} {:02x} {:02x} {:02x} op={:02x} | {:02x} {:02x} "
-                                         "{:02x} {:02x}",
-                                         header[0], header[1], header[2], header[3], header[4],
-                                         header[5], header[6], header[7], header[8]);
-                        }
-                        else
-                        {
-                            SPDLOG_WARN("[video] could not parse the codec config ({} bytes)",
-                                        body.size());
-                        }
-                        continue;
-                    }
-                    if (config->codec != stream_codec && !last_config.empty())
-                    {
-                        SPDLOG_INFO("[video] codec switched to {}",
-                                    config->codec == nalu::Codec::H265 ? "H.265" : "H.264");
-                    }
-                    stream_codec = config->codec;
+                    on_keyframe(std::chrono::steady_clock::now().time_since_epoch().count());
+                }
+            };
 
-                    // The config repeats before every keyframe (~1/s) and never
-                    // changes, so only announce it at INFO when it is new.
-                    if (config->annex_b != last_config)
+            const uint8_t opcode = header[4];
+            if (opcode == kOpVideoConfig)
+            {
+                // A config is a sync point; record it so the keyframe thread
+                // does not nudge the phone while the stream already produces
+                // its own. (P-frames must NOT count, or a static screen that
+                // only sends P-frames would never trigger a nudge.)
+                mark_sync_point();
+                auto config = nalu::configToAnnexB(*message);
+                if (!config)
+                {
+                    // The phone opens the screen stream with an empty
+                    // opcode-1 message; that is not a failure, and warning
+                    // about it on every connection trains you to ignore
+                    // this line when it does mean something. Log the header
+                    // at debug so the message can still be identified.
+                    if (message->empty())
                     {
-                        last_config = config->annex_b;
-                        SPDLOG_INFO("[video] codec config: {} ({} bytes Annex-B)",
-                                    config->codec == nalu::Codec::H265 ? "H.265" : "H.264",
-                                    config->annex_b.size());
+                        SPDLOG_DEBUG("[video] empty codec config at stream start, header "
+                                     "{:02x} {:02x} {:02x} {:02x} op={:02x} | {:02x} {:02x} "
+                                     "{:02x} {:02x}",
+                                     header[0], header[1], header[2], header[3], header[4],
+                                     header[5], header[6], header[7], header[8]);
                     }
                     else
                     {
-                        SPDLOG_DEBUG("[video] codec config (unchanged, {} bytes)",
-                                     config->annex_b.size());
-                    }
-                    if (dump != nullptr)
-                    {
-                        std::fwrite(config->annex_b.data(), 1, config->annex_b.size(), dump);
-                    }
-                    if (on_packet)
-                    {
-                        VideoPacket packet;
-                        packet.data = config->annex_b;
-                        packet.is_config = true;
-                        packet.codec = stream_codec;
-                        on_packet(packet);
+                        SPDLOG_WARN("[video] could not parse the codec config ({} bytes)",
+                                    message->size());
                     }
+                    continue;
                 }
-                else if (opcode == kOpVideoFrame)
+                if (config->codec != stream_codec && !last_config.empty())
                 {
-                    Bytes payload = body;
-                    if (body.size() >= 16)
-                    {
-                        const auto opened =
-                            crypto::chachaOpen(key, crypto::nonce64(counter), body, header);
-                        if (!opened)
-                        {
-                            SPDLOG_WARN("[video] frame {} failed to decrypt", counter);
-                            continue;
-                        }
-                        ++counter;
-                        payload = *opened;
-                    }
+                    SPDLOG_INFO("[video] codec switched to {}",
+                                config->codec == nalu::Codec::H265 ? "H.265" : "H.264");
+                }
+                stream_codec = config->codec;
 
-                    const Bytes annex_b = nalu::avccFrameToAnnexB(payload);
-                    if (dump != nullptr)
-                    {
-                        std::fwrite(annex_b.data(), 1, annex_b.size(), dump);
-                    }
-                    if (++frames == 1)
+                // The config repeats before every keyframe (~1/s) and never
+                // changes, so only announce it at INFO when it is new.
+                if (config->annex_b != last_config)
+                {
+                    last_config = config->annex_b;
+                    SPDLOG_INFO("[video] codec config: {} ({} bytes Annex-B)",
+                                config->codec == nalu::Codec::H265 ? "H.265" : "H.264",
+                                config->annex_b.size());
+                }
+                else
+                {
+                    SPDLOG_DEBUG("[video] codec config (unchanged, {} bytes)",
+                                 config->annex_b.size());
+                }
+                if (dump != nullptr)
+                {
+                    std::fwrite(config->annex_b.data(), 1, config->annex_b.size(), dump);
+                }
+                if (on_packet)
+                {
+                    // A few dozen bytes a second, and a different shape from
+                    // the message it came from, so this is the one packet that
+                    // owns a buffer of its own rather than a pooled one.
+                    auto parameter_sets = std::make_shared<const Bytes>(std::move(config->annex_b));
+                    VideoPacket packet;
+                    packet.data = *parameter_sets;
+                    packet.buffer = std::move(parameter_sets);
+                    packet.is_config = true;
+                    packet.codec = stream_codec;
+                    on_packet(packet);
+                }
+            }
+            else if (opcode == kOpVideoFrame)
+            {
+                std::span<uint8_t> payload(*message);
+                if (payload.size() >= 16)
+                {
+                    if (!crypto::chachaOpenInPlace(key, crypto::nonce64(counter), payload, header))
                     {
-                        SPDLOG_INFO("[video] FIRST FRAME decoded: {} bytes Annex-B",
-                                    annex_b.size());
+                        SPDLOG_WARN("[video] frame {} failed to decrypt", counter);
+                        continue;
                     }
+                    ++counter;
+                    payload = payload.first(payload.size() - 16);  // the tag
+                }
 
-                    if (on_packet)
+                const std::span<const uint8_t> annex_b =
+                    payload.first(nalu::avccFrameToAnnexBInPlace(payload));
+                if (dump != nullptr)
+                {
+                    std::fwrite(annex_b.data(), 1, annex_b.size(), dump);
+                }
+                if (++frames == 1)
+                {
+                    SPDLOG_INFO("[video] FIRST FRAME decoded: {} bytes Annex-B", annex_b.size());
+                }
+
+                if (on_packet)
+                {
+                    VideoPacket packet;
+                    packet.data = annex_b;
+                    packet.buffer = message;
+                    packet.codec = stream_codec;
+                    packet.keyframe = nalu::annexBContainsKeyframe(annex_b, stream_codec);
+                    if (packet.keyframe)
                     {
-                        VideoPacket packet;
-                        packet.data = annex_b;
-                        packet.codec = stream_codec;
-                        packet.keyframe = nalu::annexBContainsKeyframe(annex_b, stream_codec);
-                        if (packet.keyframe)
-                        {
-                            mark_sync_point();  // an in-band keyframe is a sync point too
-                        }
-                        on_packet(packet);
+                        mark_sync_point();  // an in-band keyframe is a sync point too
                     }
+                    on_packet(packet);
                 }
             }
         }
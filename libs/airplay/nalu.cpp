@@ -152,7 +152,7 @@ bool looksLikeAvcC(const Bytes& atom)
 // Walks the length-prefixed NAL units in a frame, calling `visit(ptr, length)`.
 // Stops on the first malformed length, exactly like the TypeScript original.
 template <typename Fn>
-void forEachAvccNalu(const Bytes& frame, size_t length_size, Fn&& visit)
+void forEachAvccNalu(std::span<const uint8_t> frame, size_t length_size, Fn&& visit)
 {
     size_t offset = 0;
     while (offset + length_size <= frame.size())
@@ -194,6 +194,22 @@ Bytes avccFrameToAnnexB(const Bytes& frame, size_t length_size)
     return out;
 }
 
+size_t avccFrameToAnnexBInPlace(std::span<uint8_t> frame)
+{
+    // Every prefix becomes a start code of the same four bytes, so nothing
+    // before or after it moves. The walk reads a length before that prefix is
+    // overwritten, and never looks back at one already rewritten, which is
+    // what makes doing it in the buffer being walked safe.
+    size_t end = 0;
+    forEachAvccNalu(frame, 4,
+                    [&](size_t offset, size_t length)
+                    {
+                        std::memcpy(frame.data() + offset - 4, kStartCode, 4);
+                        end = offset + length;
+                    });
+    return end;
+}
+
 std::optional<Config> configToAnnexB(const Bytes& payload)
 {
     // Smaller than the shortest record either codec can express (avcC needs 9
@@ -287,7 +303,7 @@ bool avccContainsKeyframe(const Bytes& frame, Codec codec, size_t length_size)
     return keyframe;
 }
 
-bool annexBContainsKeyframe(const Bytes& stream, Codec codec)
+bool annexBContainsKeyframe(std::span<const uint8_t> stream, Codec codec)
 {
     // Walk 3- and 4-byte start codes; the byte after one is the NAL header.
     for (size_t i = 0; i + 3 < stream.size(); ++i)
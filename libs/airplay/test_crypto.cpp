@@ -298,6 +298,12 @@ void testChacha()
     expect(no_aad != sealed, "ChaCha20-Poly1305 AAD changes the tag");
     expect(no_aad_open.has_value() && *no_aad_open == plaintext, "ChaCha20-Poly1305 round trip without AAD");
 
+    // In place: the plaintext lands over the ciphertext, tag left behind.
+    Bytes in_place = sealed;
+    expect(airplay::crypto::chachaOpenInPlace(key, nonce, in_place, aad) &&
+               Bytes(in_place.begin(), in_place.end() - 16) == plaintext,
+           "ChaCha20-Poly1305 in-place open round trip");
+
     const QuietLogs quiet;
     Bytes tampered = sealed;
     tampered.back() ^= 0x01;
@@ -308,6 +314,10 @@ void testChacha()
     expect(!chachaOpen(key, nonce, sealed, {}).has_value(), "ChaCha20-Poly1305 rejects missing AAD");
     expect(!chachaOpen(key, nonce64(1), sealed, aad).has_value(), "ChaCha20-Poly1305 rejects the wrong nonce");
     expect(!chachaOpen(key, nonce, fromHex("0011"), aad).has_value(), "ChaCha20-Poly1305 rejects a runt input");
+    tampered = sealed;
+    tampered[0] ^= 0x01;
+    expect(!airplay::crypto::chachaOpenInPlace(key, nonce, tampered, aad),
+           "ChaCha20-Poly1305 in-place open rejects mangled ciphertext");
     expect(chachaSeal(fromHex("00"), nonce, plaintext, aad).empty(), "ChaCha20-Poly1305 rejects a short key");
     expect(chachaSeal(key, fromHex("00"), plaintext, aad).empty(), "ChaCha20-Poly1305 rejects a short nonce");
 }
@@ -181,6 +181,38 @@ void testAvccFrameRewrite()
     expect(avccFrameToAnnexB(frame, 5).empty(), "length prefix size 5 is rejected");
 }
 
+// The in-place rewrite the screen stream uses must leave exactly the bytes the
+// copying one returns at the front of the buffer. The fuzz below holds it to
+// that on mangled frames as well; these are the cases worth naming.
+void testAvccFrameRewriteInPlace()
+{
+    using airplay::nalu::avccFrameToAnnexB;
+    using airplay::nalu::avccFrameToAnnexBInPlace;
+
+    const auto inPlace = [](Bytes frame)
+    {
+        frame.resize(avccFrameToAnnexBInPlace(frame));
+        return frame;
+    };
+
+    const Bytes frame = fromHex(
+        "00000003"
+        "65aabb"
+        "00000004"
+        "41ccddee");
+    expect(inPlace(frame) == avccFrameToAnnexB(frame), "in place matches the copy (two NAL units)");
+
+    // Stops where the copy stops, and leaves the rest of the buffer alone.
+    Bytes trailing = fromHex("0000000267aa" "000000ff41");
+    const size_t end = avccFrameToAnnexBInPlace(trailing);
+    expect(end == 6, "in place stops at a length that overruns the buffer");
+    expect(toHex(trailing) == "0000000167aa" "000000ff41", "bytes past the end are untouched");
+
+    expect(avccFrameToAnnexBInPlace({}) == 0, "in place: empty frame yields nothing");
+    Bytes zero = fromHex("00000000");
+    expect(avccFrameToAnnexBInPlace(zero) == 0, "in place: zero-length NAL unit yields nothing");
+}
+
 void testConfigToAnnexB()
 {
     using airplay::nalu::configToAnnexB;
@@ -417,6 +449,14 @@ void testMutationFuzz()
         // Only the absence of a crash matters; any outcome is legal.
         results += airplay::nalu::configToAnnexB(mutated).has_value() ? 1 : 0;
         results += airplay::nalu::avccFrameToAnnexB(mutated, 1 + (next() % 4)).size();
+
+        const Bytes copied = airplay::nalu::avccFrameToAnnexB(mutated);
+        Bytes rewritten = mutated;
+        rewritten.resize(airplay::nalu::avccFrameToAnnexBInPlace(rewritten));
+        if (rewritten != copied)
+        {
+            expect(false, "in-place Annex-B rewrite matches the copy on a mutated frame");
+        }
         results += airplay::nalu::avccContainsKeyframe(mutated, Codec::H264) ? 1 : 0;
         results += airplay::nalu::annexBContainsKeyframe(mutated, Codec::H265) ? 1 : 0;
     }
@@ -430,6 +470,7 @@ int main()
     spdlog::set_level(spdlog::level::info);
 
     testAvccFrameRewrite();
+    testAvccFrameRewriteInPlace();
     testConfigToAnnexB();
     testKeyframeDetection();
     testConfigCodecDrivesKeyframeDetection();
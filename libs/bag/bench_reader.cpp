@@ -0,0 +1,255 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//
+// What a small-window read of a large recording costs when it is asked again
+// and again, uncached and cached.
+//
+// NOT a test -- it asserts nothing and always exits 0. It exists because the
+// claim ReaderOptions::cached makes -- a scope scrubbing over the same stretch
+// of a multi-gigabyte recording pays for each chunk once, not once per
+// query -- is a claim about time, and only a measurement shows it.
+// test_roundtrip is what shows the answers are the same.
+//
+// Writes its own recording unless given one, then runs the same sequence of
+// windows through both readers: a scrub that wanders back and forth around the
+// middle of the recording, each window read twice in a row the way a rebind
+// re-reads what is already on screen.
+//
+//   bag_bench_reader
+//   bag_bench_reader --gigabytes 4 --queries 400 --window-ms 250
+//   bag_bench_reader --bag /data/drive_0412 --cache-mb 512
+//
+// What each column means:
+//
+//   median, p95   wall time of one forEach() over the window, visiting every
+//                 message and touching its payload
+//   total         all of the queries
+//   hits/misses   chunks the cached reader found decoded, and decoded
+//
+// Uncached, every query opens the parts it touches, re-reads their summaries
+// and decompresses every chunk in the window, so its time tracks the window.
+// Cached, only a chunk the scrub has not passed over yet is decompressed; a
+// median near zero with misses in the low hundreds is the cache doing its job.
+// Run it on a cold page cache (drop_caches) to see the first pass as the disk
+// sees it.
+
+#include "bag/reader.h"
+#include "bag/writer.h"
+
+#include <spdlog/spdlog.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+constexpr std::uint64_t kBase = 1'785'000'000'000'000'000ull;
+constexpr std::uint64_t kMillis = 1'000'000ull;
+
+std::string argumentAfter(int argc, char** argv, const std::string& flag,
+                          const std::string& fallback)
+{
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (flag == argv[i])
+        {
+            return argv[i + 1];
+        }
+    }
+    return fallback;
+}
+
+// Twenty 100 Hz signals of a couple of hundred bytes and one 30 Hz camera of
+// 64 KB: the shape of a drive with the CAN bus decoded and a video feed. The
+// payloads are half noise so zstd has something to do and the file is still
+// about as big as asked.
+void writeRecording(const std::string& directory, std::uint64_t target_bytes)
+{
+    bag::WriterOptions options;
+    options.name = "bench";
+    options.compression_threads = std::max(1u, std::thread::hardware_concurrency());
+    bag::BagWriter writer(directory, options);
+
+    std::mt19937_64 noise(7);
+    std::vector<std::uint8_t> small(200);
+    std::vector<std::uint8_t> frame(64 * 1024);
+    const auto fill = [&noise](std::vector<std::uint8_t>& payload, std::uint64_t tick)
+    {
+        for (std::size_t i = 0; i < payload.size(); ++i)
+        {
+            payload[i] = (i & 1u) != 0u ? static_cast<std::uint8_t>(noise())
+                                        : static_cast<std::uint8_t>(tick + i / 64);
+        }
+    };
+
+    std::uint64_t written = 0;
+    for (std::uint64_t tick = 0; written < target_bytes; ++tick)
+    {
+        const std::uint64_t t = kBase + tick * kMillis;
+        if (tick % 10 == 0)
+        {
+            for (int signal = 0; signal < 20; ++signal)
+            {
+                fill(small, tick + static_cast<std::uint64_t>(signal));
+                writer.write("vehicle/signal_" + std::to_string(signal), "EngineRpm", small,
+                             t + static_cast<std::uint64_t>(signal) * 1000, std::nullopt, "");
+                written += small.size();
+            }
+        }
+        if (tick % 33 == 0)
+        {
+            fill(frame, tick);
+            writer.write("carplay/video", "CarPlayVideo", frame, t, std::nullopt, "");
+            written += frame.size();
+        }
+    }
+    writer.close();
+}
+
+struct Timing
+{
+    double median_ms = 0;
+    double p95_ms = 0;
+    double total_ms = 0;
+    std::uint64_t messages = 0;
+};
+
+Timing run(bag::BagReader& reader,
+           const std::vector<std::pair<std::uint64_t, std::uint64_t>>& windows)
+{
+    Timing timing;
+    std::vector<double> each;
+    std::uint64_t sink = 0;
+
+    for (const auto& [from, to] : windows)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        reader.forEach(from, to,
+                       [&](const bag::BagMessage& message)
+                       {
+                           ++timing.messages;
+                           sink += message.payload.empty() ? 0 : message.payload.back();
+                           return true;
+                       });
+        each.push_back(std::chrono::duration<double, std::milli>(
+                           std::chrono::steady_clock::now() - start)
+                           .count());
+    }
+
+    std::sort(each.begin(), each.end());
+    for (const double ms : each)
+    {
+        timing.total_ms += ms;
+    }
+    if (!each.empty())
+    {
+        timing.median_ms = each[each.size() / 2];
+        timing.p95_ms = each[each.size() * 95 / 100];
+    }
+
+    // Keeps the optimiser from deciding the payloads were never looked at.
+    SPDLOG_DEBUG("{}", sink);
+    return timing;
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    const double gigabytes =
+        std::max(0.01, std::atof(argumentAfter(argc, argv, "--gigabytes", "2").c_str()));
+    const int queries =
+        std::max(2, std::atoi(argumentAfter(argc, argv, "--queries", "200").c_str()));
+    const int window_ms =
+        std::max(1, std::atoi(argumentAfter(argc, argv, "--window-ms", "500").c_str()));
+    const int cache_mb =
+        std::max(1, std::atoi(argumentAfter(argc, argv, "--cache-mb", "256").c_str()));
+    const std::uint64_t window_ns = static_cast<std::uint64_t>(window_ms) * kMillis;
+    const std::size_t cache_bytes = static_cast<std::size_t>(cache_mb) * 1024 * 1024;
+
+    std::string directory = argumentAfter(argc, argv, "--bag", "");
+    const bool generated = directory.empty();
+    if (generated)
+    {
+        directory = (std::filesystem::temp_directory_path() /
+                     ("redline_bag_bench_" + std::to_string(::getpid())))
+                        .string();
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+
+        SPDLOG_INFO("Writing a {:.1f} GB recording to {}", gigabytes, directory);
+        writeRecording(directory, static_cast<std::uint64_t>(gigabytes * 1024 * 1024 * 1024));
+    }
+
+    bag::BagReader uncached(directory);
+    bag::BagReader cached(directory,
+                          bag::ReaderOptions{.cached = true, .chunk_cache_bytes = cache_bytes});
+    if (!uncached.isValid())
+    {
+        SPDLOG_ERROR("'{}' is not a bag", directory);
+        return 0;
+    }
+
+    const bag::bag_metadata_t& metadata = uncached.metadata();
+    std::uint64_t on_disk = 0;
+    for (const bag::bag_part_t& part : metadata.parts)
+    {
+        on_disk += part.bytes;
+    }
+    SPDLOG_INFO("{} messages in {} parts, {:.2f} GB, {:.0f} s", metadata.message_count,
+                metadata.parts.size(), static_cast<double>(on_disk) / (1024.0 * 1024 * 1024),
+                static_cast<double>(metadata.t_end_ns - metadata.t_begin_ns) / 1e9);
+
+    // The scrub: a random walk of up to two windows either way, starting mid
+    // recording and never leaving it, each window asked for twice.
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> windows;
+    {
+        std::mt19937_64 steps(11);
+        const std::uint64_t span = metadata.t_end_ns - metadata.t_begin_ns;
+        const std::uint64_t last = span > window_ns ? span - window_ns : 0;
+        std::uint64_t at = last / 2;
+        for (int i = 0; i < queries; i += 2)
+        {
+            const auto step = static_cast<std::int64_t>(steps() % (4 * window_ns + 1)) -
+                              static_cast<std::int64_t>(2 * window_ns);
+            at = static_cast<std::uint64_t>(
+                std::clamp<std::int64_t>(static_cast<std::int64_t>(at) + step, 0,
+                                         static_cast<std::int64_t>(last)));
+            const std::uint64_t from = metadata.t_begin_ns + at;
+            windows.emplace_back(from, from + window_ns);
+            windows.emplace_back(from, from + window_ns);
+        }
+    }
+
+    SPDLOG_INFO("{} queries of {} ms, cache {} MB", windows.size(), window_ns / kMillis,
+                cache_bytes / (1024 * 1024));
+
+    const Timing plain = run(uncached, windows);
+    const Timing mapped = run(cached, windows);
+    const bag::ReaderCacheStats stats = cached.cacheStats();
+
+    SPDLOG_INFO("  uncached  median {:8.2f} ms  p95 {:8.2f} ms  total {:9.1f} ms  {} messages",
+                plain.median_ms, plain.p95_ms, plain.total_ms, plain.messages);
+    SPDLOG_INFO("  cached    median {:8.2f} ms  p95 {:8.2f} ms  total {:9.1f} ms  {} messages",
+                mapped.median_ms, mapped.p95_ms, mapped.total_ms, mapped.messages);
+    SPDLOG_INFO("  cache: {} hits, {} misses, {} evictions, {} chunks / {:.0f} MB held, "
+                "{} parts mapped",
+                stats.chunk_hits, stats.chunk_misses, stats.chunk_evictions, stats.cached_chunks,
+                static_cast<double>(stats.cached_bytes) / (1024.0 * 1024), stats.parts_mapped);
+
+    if (generated)
+    {
+        std::error_code error;
+        std::filesystem::remove_all(directory, error);
+    }
+    return 0;
+}
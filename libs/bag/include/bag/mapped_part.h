@@ -0,0 +1,229 @@
+#ifndef BAG_MAPPED_PART_H_
+#define BAG_MAPPED_PART_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bag
+{
+
+// One chunk's records, decompressed, with its messages listed in log_time order.
+//
+// Immutable once built and handed out by shared_ptr, so a reader can keep
+// using a chunk that the cache has since evicted -- the cache drops its
+// reference, the last reader frees it.
+struct DecodedChunk
+{
+    struct Message
+    {
+        std::uint64_t log_time_ns = 0;
+        std::uint64_t publish_time_ns = 0;
+
+        // The payload, as a range of `bytes`.
+        std::uint64_t offset = 0;
+        std::uint64_t size = 0;
+
+        std::uint16_t channel_id = 0;
+    };
+
+    // Empty for an uncompressed chunk, whose records are read straight out of
+    // the mapping.
+    std::vector<std::uint8_t> decompressed;
+
+    // The chunk's records: `decompressed`, or the mapped file.
+    std::span<const std::uint8_t> bytes;
+
+    // Sorted by log_time. Ties keep file order, which is the order mcap's own
+    // reader yields them in.
+    std::vector<Message> messages;
+
+    // What holding this costs, for the cache's budget. Mapped bytes are the
+    // page cache's and not counted.
+    std::size_t footprint() const
+    {
+        return decompressed.capacity() + messages.capacity() * sizeof(Message);
+    }
+};
+
+// A part file mapped read-only, with its summary parsed once.
+//
+// WHY NOT mcap::McapReader. It owns its summary and its decompression buffers
+// per instance and is not safe to share, so reading a part through it means
+// opening, re-parsing the summary and re-decompressing every chunk on every
+// call. For a scope scrubbing back and forth over the same minute of a
+// recording that is all of the cost. This keeps what does not change -- the
+// mapping, the channels, the ChunkIndex -- for the reader's lifetime, and
+// decodes chunks on request so a ChunkCache can keep those too.
+//
+// It reads the records itself, from the spec, as validate.cpp and
+// pipelined_writer.cpp do. Neither shares that code: the validator exists to
+// disagree with a buggy reader, and it cannot if they are the same reader.
+//
+// ONLY A PART WITH A SUMMARY. A torn part has no footer, no ChunkIndex and no
+// channel table, and recovering one is a scan of the data section that
+// mcap's reader already does well -- see reader.cpp. open() returns null for
+// it and BagReader reads that part the old way.
+//
+// Thread-safe: everything is const after open() but the per-channel time
+// indexes, which are built under a lock.
+class MappedPart
+{
+  public:
+    struct Channel
+    {
+        std::string topic;
+
+        // The registry name from the channel metadata, or the Schema record's
+        // name when there is none -- the same rule BagReader applies.
+        std::string schema;
+    };
+
+    // What the ChunkIndex says about one chunk.
+    struct ChunkRef
+    {
+        std::uint64_t start_ns = 0;
+        std::uint64_t end_ns = 0;
+        std::uint64_t offset = 0;  // Of the Chunk record, from the start of the file.
+        std::uint64_t length = 0;  // Of the whole record.
+        std::uint64_t uncompressed_size = 0;
+
+        // Channel id -> offset of that channel's MessageIndex record, sorted by
+        // id. Empty when the writer emitted none.
+        std::vector<std::pair<std::uint16_t, std::uint64_t>> message_indexes;
+    };
+
+    // Where one channel's messages are, by time, without opening a chunk.
+    //
+    // Built from the MessageIndex records that follow each chunk: one entry per
+    // message, its log_time and the ordinal in chunks() of the chunk that holds
+    // it. Those records are uncompressed and small, so a channel at 1 Hz in a
+    // part of video chunks is found by reading a few kilobytes of index rather
+    // than decompressing the gigabytes around it.
+    struct TimeIndex
+    {
+        // Sorted by log_time.
+        std::vector<std::pair<std::uint64_t, std::uint32_t>> entries;
+
+        // Chunks with no MessageIndex to consult -- a writer that emitted none,
+        // or a record that would not parse. Any of them may hold the channel,
+        // so a read must open them if their time range meets its window.
+        std::vector<std::uint32_t> unindexed;
+    };
+
+    // Null when the file cannot be mapped or has no usable summary, with the
+    // reason in `why`.
+    static std::unique_ptr<MappedPart> open(const std::string& path, std::string& why);
+
+    ~MappedPart();
+
+    MappedPart(const MappedPart&) = delete;
+    MappedPart& operator=(const MappedPart&) = delete;
+
+    const std::string& path() const { return path_; }
+
+    // Sorted by start_ns, then offset.
+    const std::vector<ChunkRef>& chunks() const { return chunks_; }
+
+    // Null for an id the summary does not list.
+    const Channel* channel(std::uint16_t id) const;
+
+    const std::map<std::uint16_t, Channel>& channels() const { return channels_; }
+
+    // Built on first request for each channel and kept; never null.
+    std::shared_ptr<const TimeIndex> timeIndex(std::uint16_t channel_id) const;
+
+    // Null, with the reason in `error`, for a chunk whose record is damaged or
+    // whose codec fails.
+    std::shared_ptr<const DecodedChunk> decode(const ChunkRef& chunk, std::string& error) const;
+
+  private:
+    MappedPart() = default;
+
+    bool parseSummary(std::string& why);
+
+    std::string path_;
+    int fd_ = -1;
+    const std::uint8_t* data_ = nullptr;
+    std::size_t size_ = 0;
+
+    std::map<std::uint16_t, Channel> channels_;
+    std::vector<ChunkRef> chunks_;
+
+    mutable std::mutex time_indexes_mutex_;
+    mutable std::map<std::uint16_t, std::shared_ptr<const TimeIndex>> time_indexes_;
+};
+
+// Totals since the cache was made. A snapshot; the fields are not read together
+// atomically.
+struct ChunkCacheStats
+{
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+
+    // Held now, against the budget.
+    std::size_t bytes = 0;
+    std::size_t chunks = 0;
+};
+
+// Decoded chunks, least recently used first out, within a byte budget. Keyed by
+// (part index, chunk offset), which names a chunk for as long as the bag is
+// open -- parts with a summary are never rewritten.
+//
+// Thread-safe. The lock covers the lookup and the list splice only: decoding a
+// miss happens outside it, so two readers that miss the same chunk at once
+// both decode it and the second insert keeps the first. That costs one
+// duplicate decode at the seam between two concurrent ranges, against holding
+// every other reader behind a 4 MB zstd call.
+//
+// A chunk evicted while a reader holds it stays alive until that reader lets
+// go, so the budget can be exceeded by what is being read right now -- never
+// by what is merely remembered.
+class ChunkCache
+{
+  public:
+    using Key = std::pair<std::size_t, std::uint64_t>;
+
+    explicit ChunkCache(std::size_t capacity_bytes);
+
+    ChunkCache(const ChunkCache&) = delete;
+    ChunkCache& operator=(const ChunkCache&) = delete;
+
+    // Null on a miss, and counted as one.
+    std::shared_ptr<const DecodedChunk> find(const Key& key);
+
+    // Returns what the cache now holds for `key`: `chunk`, or the one another
+    // thread inserted first. A chunk bigger than the whole budget is returned
+    // without being kept.
+    std::shared_ptr<const DecodedChunk> insert(const Key& key,
+                                               std::shared_ptr<const DecodedChunk> chunk);
+
+    ChunkCacheStats stats() const;
+
+  private:
+    struct Entry
+    {
+        std::shared_ptr<const DecodedChunk> chunk;
+        std::size_t bytes = 0;
+        std::list<Key>::iterator position;
+    };
+
+    const std::size_t capacity_;
+
+    mutable std::mutex mutex_;
+    std::list<Key> order_;  // Most recently used at the front.
+    std::map<Key, Entry> entries_;
+    ChunkCacheStats stats_;
+};
+
+}  // namespace bag
+
+#endif  // BAG_MAPPED_PART_H_
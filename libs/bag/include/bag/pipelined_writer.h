@@ -0,0 +1,232 @@
+#ifndef BAG_PIPELINED_WRITER_H_
+#define BAG_PIPELINED_WRITER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace bag
+{
+
+// Running totals for the three stages of a PipelinedMcapWriter. Atomics,
+// because the point of them is a progress line printed from a thread that is
+// not the writer's. Accumulated across parts: BagWriter owns one and every part
+// writer adds to it.
+struct StageCounters
+{
+    std::atomic<std::uint64_t> chunks{0};
+    std::atomic<std::uint64_t> uncompressed_bytes{0};
+    std::atomic<std::uint64_t> compressed_bytes{0};
+
+    // Writer thread, inside write(): framing records into the open chunk.
+    std::atomic<std::uint64_t> build_ns{0};
+
+    // Summed over the workers: CRC plus codec, per chunk.
+    std::atomic<std::uint64_t> compress_ns{0};
+
+    // The appending thread: chunk and message index records onto disk.
+    std::atomic<std::uint64_t> append_ns{0};
+
+    // Writer thread, waiting for a chunk slot because every one is still being
+    // compressed or appended. Nonzero means the stages behind the writer are
+    // the limit -- fewer threads than the codec level needs, or a slow disk.
+    std::atomic<std::uint64_t> stall_ns{0};
+};
+
+// One MCAP part, written with its chunks compressed on worker threads.
+//
+// WHY NOT mcap::McapWriter. It compresses each chunk inline, on the thread that
+// called write(), when the chunk fills -- a 4 MB zstd call in the middle of the
+// writer loop, during which the queue in front of it only grows. It has no hook
+// to hand a finished chunk to anyone else. So this writes the records itself,
+// from the spec, the same way validate.cpp reads them.
+//
+// THE LAYOUT IS mcap::McapWriter's, record for record, so nothing downstream
+// can tell which wrote a part: Header; then per chunk a Chunk record followed by
+// one MessageIndex per channel in it; DataEnd; a summary of Schema, Channel,
+// Statistics and ChunkIndex groups, each with a SummaryOffset; Footer with the
+// summary CRC. A Schema and its Channel go into the chunk that carries the
+// channel's first message, as mcap does.
+//
+// THE PIPELINE. The caller's thread frames records into the open chunk. A full
+// chunk is sealed with a sequence number and queued; `threads` workers CRC and
+// compress sealed chunks in any order; one appending thread writes them to the
+// file strictly in sequence, which is the only place file offsets -- and so the
+// ChunkIndex -- are decided. At most `chunks_in_flight` sealed chunks wait at
+// once, and their buffers are reused rather than reallocated. When that many
+// are waiting, write() blocks: backpressure onto the recorder's queue, which is where a
+// recorder that cannot keep up is supposed to shed load.
+//
+// NOT THREAD-SAFE, like BagWriter: one thread calls everything here. The
+// threads it starts are its own.
+class PipelinedMcapWriter
+{
+  public:
+    struct Options
+    {
+        // "none", "lz4" or "zstd".
+        std::string compression = "zstd";
+
+        // The codec's own scale, not WriterOptions' 0-9 one; writer.cpp maps.
+        int level = 1;
+
+        std::uint64_t chunk_bytes = 4ull * 1024 * 1024;
+
+        // Header.library.
+        std::string library;
+
+        unsigned threads = 2;
+
+        // Sealed chunks allowed to be waiting for a worker or for the disk
+        // before write() blocks. Zero means two per thread: one being
+        // compressed and one queued behind it, for every worker.
+        std::size_t chunks_in_flight = 0;
+    };
+
+    explicit PipelinedMcapWriter(StageCounters& counters);
+    ~PipelinedMcapWriter();
+
+    PipelinedMcapWriter(const PipelinedMcapWriter&) = delete;
+    PipelinedMcapWriter& operator=(const PipelinedMcapWriter&) = delete;
+
+    // False when the file cannot be created.
+    bool open(const std::string& path, Options options);
+
+    // Ids start at 1. Nothing is written until a message uses them, so a
+    // registration that is never used leaves no trace in the file.
+    std::uint16_t addSchema(std::string_view name, std::string_view encoding,
+                            std::span<const std::uint8_t> data);
+    std::uint16_t addChannel(std::string_view topic, std::string_view message_encoding,
+                             std::uint16_t schema_id,
+                             const std::map<std::string, std::string>& metadata);
+
+    // False once a write to disk has failed; nothing after that is kept.
+    bool write(std::uint16_t channel_id, std::uint64_t log_time_ns,
+               std::uint64_t publish_time_ns, std::span<const std::uint8_t> data);
+
+    // Seals the last chunk, waits for every chunk to land, and writes the
+    // summary and footer. Safe to call twice.
+    bool close();
+
+    // What the part will be once every chunk written so far has landed: the
+    // bytes already on disk, plus the open chunk and each sealed one still
+    // waiting, as they will compress at the ratio this part's chunks have
+    // shown so far -- uncompressed until one has landed, which can only err
+    // high. This is what BagWriter rolls on. The file's own size lags it by
+    // up to chunks_in_flight chunks, and a part rolled on that overshoots by
+    // as much.
+    std::uint64_t projectedBytes();
+
+  private:
+    struct Chunk
+    {
+        std::uint64_t sequence = 0;
+        std::vector<std::uint8_t> records;
+        std::vector<std::uint8_t> compressed;
+        std::string compression;  // As written: empty for a raw chunk.
+        std::uint32_t crc = 0;
+        std::uint64_t start_ns = 0;
+        std::uint64_t end_ns = 0;
+
+        // channel id -> (log_time, offset into `records`), for the
+        // MessageIndex records that follow the chunk.
+        std::map<std::uint16_t, std::vector<std::pair<std::uint64_t, std::uint64_t>>> index;
+
+        void reset();
+    };
+
+    struct Schema
+    {
+        std::string name;
+        std::string encoding;
+        std::vector<std::uint8_t> data;
+        bool written = false;
+    };
+
+    struct Channel
+    {
+        std::string topic;
+        std::string message_encoding;
+        std::uint16_t schema_id = 0;
+        std::map<std::string, std::string> metadata;
+        std::uint64_t count = 0;
+        bool written = false;
+    };
+
+    // What the summary needs to know about each chunk once it is on disk.
+    struct ChunkEntry
+    {
+        std::uint64_t start_ns = 0;
+        std::uint64_t end_ns = 0;
+        std::uint64_t offset = 0;
+        std::uint64_t length = 0;
+        std::map<std::uint16_t, std::uint64_t> message_index_offsets;
+        std::uint64_t message_index_length = 0;
+        std::string compression;
+        std::uint64_t compressed_size = 0;
+        std::uint64_t uncompressed_size = 0;
+    };
+
+    std::unique_ptr<Chunk> takeChunk();
+    void seal();
+    void compressLoop();
+    void appendLoop();
+    bool append(const Chunk& chunk);
+    bool writeSummary();
+    bool writeBytes(std::span<const std::uint8_t> bytes);
+    void stopThreads();
+
+    StageCounters& counters_;
+    Options options_;
+    std::FILE* file_ = nullptr;
+    std::uint64_t offset_ = 0;  // Appending thread while running, then close().
+    bool closed_ = false;
+
+    std::vector<Schema> schemas_;
+    std::vector<Channel> channels_;
+
+    // The open chunk. Writer thread only.
+    std::unique_ptr<Chunk> building_;
+    std::uint64_t next_sequence_ = 0;
+
+    std::uint64_t message_count_ = 0;
+    std::uint64_t start_ns_ = 0;
+    std::uint64_t end_ns_ = 0;
+
+    // Everything below is shared with the worker and appending threads.
+    std::mutex mutex_;
+    std::condition_variable work_ready_;    // Workers: a chunk to compress.
+    std::condition_variable append_ready_;  // Appender: a chunk has been compressed.
+    std::condition_variable slot_free_;     // Writer: a chunk has been appended.
+    std::deque<std::unique_ptr<Chunk>> to_compress_;
+    std::map<std::uint64_t, std::unique_ptr<Chunk>> compressed_;
+    std::vector<std::unique_ptr<Chunk>> spare_;
+    std::size_t in_flight_ = 0;
+    std::uint64_t next_to_append_ = 0;
+    std::uint64_t pending_records_ = 0;   // Records in sealed chunks not yet on disk.
+    std::uint64_t on_disk_ = 0;           // offset_, as of the last chunk appended.
+    std::uint64_t landed_records_ = 0;    // Records, and what they became on disk,
+    std::uint64_t landed_body_ = 0;       // over the chunks appended so far.
+    bool stopping_ = false;
+    std::atomic<bool> failed_{false};
+
+    std::vector<ChunkEntry> chunk_entries_;  // Appending thread, then close().
+
+    std::vector<std::thread> workers_;
+    std::thread appender_;
+};
+
+}  // namespace bag
+
+#endif  // BAG_PIPELINED_WRITER_H_
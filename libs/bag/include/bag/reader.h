@@ -3,6 +3,7 @@
 
 #include "bag/metadata.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <limits>
@@ -38,6 +39,44 @@ struct BagMessage
     std::uint64_t publish_time_ns = 0;
 };
 
+// How a BagReader reads its parts.
+struct ReaderOptions
+{
+    // Map each part once, keep its parsed summary, and keep decompressed chunks
+    // in a shared LRU -- all across forEach() calls.
+    //
+    // For a reader that asks again and again: a scope scrubbing, re-binding a
+    // signal, redrawing its overview strip. Each of those reads a window that
+    // mostly overlaps the last one, and uncached every one of them re-opens the
+    // parts, re-parses their summaries and re-decompresses every chunk in the
+    // window. Cached, a repeated window decompresses nothing.
+    //
+    // Off by default because a single pass -- `bag play`, `bag info`, an
+    // export -- gains nothing from remembering what it has already passed, and
+    // the cache would hold up to `chunk_cache_bytes` for no one.
+    //
+    // A part with no summary is read exactly as it is uncached: a torn part has
+    // no chunk index to cache, and the fallback scan is the thing that makes it
+    // readable at all.
+    bool cached = false;
+
+    // Decompressed chunks kept, in bytes. Chunks are ~4 MB, so the default holds
+    // some sixty of them -- a few minutes of a busy recording.
+    std::size_t chunk_cache_bytes = 256ull * 1024 * 1024;
+};
+
+// What the cache has done, for a benchmark or a status line. All zero for an
+// uncached reader.
+struct ReaderCacheStats
+{
+    std::size_t parts_mapped = 0;
+    std::uint64_t chunk_hits = 0;
+    std::uint64_t chunk_misses = 0;
+    std::uint64_t chunk_evictions = 0;
+    std::size_t cached_bytes = 0;
+    std::size_t cached_chunks = 0;
+};
+
 // Reads a bag directory as one continuous, time-ordered message stream.
 //
 // The split into parts is invisible here. That is the whole point of the
@@ -48,6 +87,7 @@ class BagReader
 {
   public:
     explicit BagReader(std::string directory);
+    BagReader(std::string directory, ReaderOptions options);
     ~BagReader();
 
     BagReader(const BagReader&) = delete;
@@ -92,6 +132,11 @@ class BagReader
     // whole chunks whose time range falls outside the window, and parts outside
     // it are never opened. A range near the end of a large recording does not
     // pay for the beginning of it.
+    //
+    // Safe to call from several threads at once. Uncached, each call opens its
+    // own mcap::McapReader per part, with its own decompression buffers, and
+    // touches nothing here but the metadata read at construction. Cached, the
+    // calls share the mappings and the chunk cache, both of which lock.
     bool forEach(std::uint64_t start_ns, std::uint64_t end_ns,
                  const std::function<bool(const BagMessage&)>& callback);
 
@@ -100,6 +145,24 @@ class BagReader
         return forEach(0, std::numeric_limits<std::uint64_t>::max(), callback);
     }
 
+    // forEach() for the messages on `topics` only, in the same order. An empty
+    // set matches nothing.
+    //
+    // Not a filter in the callback, which would still decompress every chunk in
+    // the window. A chunk holds every topic that was live while it filled, so a
+    // 1 Hz warning topic shares its chunks with megabytes of video -- but the
+    // MessageIndex records the writer puts after each chunk say which topics a
+    // chunk holds, and when. Uncached, chunks without any of the topics are
+    // skipped. Cached, each topic's index is read once into a per-part time
+    // index, and only chunks holding one of its messages INSIDE the window are
+    // opened: a sparse topic costs a binary search and the chunks its own
+    // messages sit in.
+    bool forEach(std::uint64_t start_ns, std::uint64_t end_ns,
+                 const std::vector<std::string>& topics,
+                 const std::function<bool(const BagMessage&)>& callback);
+
+    ReaderCacheStats cacheStats() const;
+
   private:
     struct Impl;
     std::unique_ptr<Impl> impl_;
@@ -0,0 +1,244 @@
+#ifndef BAG_RING_QUEUE_H_
+#define BAG_RING_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace bag
+{
+
+// Strings a recording sees over and over -- keys, schema names, session ids --
+// stored once and handed out by stable pointer.
+//
+// A recorder sees a few hundred distinct keys at most and millions of messages
+// naming them. Copying three std::strings per message into the queue, as
+// QueuedMessage does, is three allocations on a zenoh RX thread for text that
+// has not changed since the first sample.
+//
+// Lookups of a string already present take no lock: an open-addressed table of
+// atomic pointers, probed in place. Only the first sight of a string takes the
+// mutex to insert it. Nothing is ever removed, so a pointer stays valid for the
+// table's lifetime and the writer thread can read one without coordinating.
+class InternTable
+{
+  public:
+    InternTable();
+    ~InternTable();
+
+    InternTable(const InternTable&) = delete;
+    InternTable& operator=(const InternTable&) = delete;
+
+    // Never null. The same text always yields the same pointer.
+    const std::string* intern(std::string_view text);
+
+  private:
+    // Power of two. Past three quarters full, new strings go to `overflow_`
+    // instead, whose lookups take the mutex -- slower, never wrong.
+    static constexpr std::size_t kSlots = 4096;
+
+    std::unique_ptr<std::atomic<const std::string*>[]> slots_;
+    std::size_t used_ = 0;  // Guarded by mutex_.
+
+    std::mutex mutex_;
+    std::deque<std::string> storage_;  // Stable addresses for every entry.
+    std::unordered_map<std::string_view, const std::string*> overflow_;
+};
+
+// One message as the writer thread sees it. The strings are interned and live
+// as long as the queue; the payload is the writer's own buffer and is valid
+// only for the duration of the pop() callback.
+struct RingMessage
+{
+    std::string_view key;
+    std::string_view schema;
+    std::string_view origin_zid;
+    std::span<const std::uint8_t> payload;
+    std::uint64_t log_time_ns = 0;
+    std::optional<std::uint64_t> publish_time_ns;
+};
+
+// MessageQueue's contract -- bounded, never blocks a producer, drops the
+// OLDEST and counts it, drains fully on stop -- without its mutex or its
+// per-message allocations.
+//
+// WHY IT EXISTS. MessageQueue takes one lock per message from every RX thread
+// and moves a QueuedMessage that was built from three fresh strings and a fresh
+// payload vector. Under CarPlay video plus a fully loaded CAN bus the
+// producers spend their time in the allocator and queued on that lock, and the
+// recorder drops well before the disk is the limit.
+//
+// HOW. A fixed ring of slots, each carrying a sequence number that says whose
+// turn it is (Vyukov's bounded queue). A producer claims a slot with one CAS on
+// the enqueue position, fills it, and publishes it by bumping the slot's
+// sequence; the writer claims from the other end the same way. Nobody holds a
+// lock, and a slow producer delays only its own slot.
+//
+// SLABS. Every slot keeps its payload buffer between uses, so once the ring
+// has gone round once a payload is copied into memory that is already there.
+// The writer does not copy out: it SWAPS the slot's buffer with a spare of its
+// own, hands the slot straight back, and writes from the spare -- which goes
+// into the next slot it takes. So buffers circulate rather than being
+// allocated, and a slot is out of the producers' reach for the length of a
+// swap, not for the length of a disk write. A buffer that grew past
+// kRetainedSlabBytes to hold something large -- a video keyframe -- is freed
+// once written rather than kept, or one burst of keyframes would pin
+// capacity × a megabyte for the rest of the recording.
+//
+// DROPPING THE OLDEST without a lock means a producer that finds the ring full
+// claims the oldest slot the same way the writer would, and discards it. When
+// the ring is full the oldest slot IS the one the producer is waiting for, so
+// one discard makes its room. The case that cannot work is an oldest slot that
+// another producer has claimed and not finished filling, or a race that keeps
+// taking the room away; then THIS message is the one dropped. Every loss is
+// counted.
+class RingQueue
+{
+  public:
+    // Rounded up to a power of two, and at least two.
+    explicit RingQueue(std::size_t capacity);
+
+    RingQueue(const RingQueue&) = delete;
+    RingQueue& operator=(const RingQueue&) = delete;
+
+    // Any thread. Never blocks. Returns false if a message had to be dropped --
+    // the oldest to make room, or, rarely, this one (see above).
+    bool push(std::string_view key, std::string_view schema, std::string_view origin_zid,
+              std::span<const std::uint8_t> payload, std::uint64_t log_time_ns,
+              std::optional<std::uint64_t> publish_time_ns);
+
+    // The writer thread only. Blocks until a message is available and calls
+    // `visit` with it, or returns false when stopped AND drained -- the same
+    // promise MessageQueue::pop() makes, so a writer loop cannot lose what was
+    // queued before stop().
+    template <typename Visit>
+    bool pop(Visit&& visit)
+    {
+        for (;;)
+        {
+            // Read before trying, so a push landing between the try and the
+            // wait changes the value and the wait returns at once.
+            const std::uint32_t seen = signal_.load(std::memory_order_acquire);
+            if (tryPop(visit))
+            {
+                return true;
+            }
+            if (stopped_.load(std::memory_order_acquire))
+            {
+                // One more try: stop() may have raced the last push.
+                return tryPop(visit);
+            }
+
+            // Announce the sleep, then look once more. Both sides are seq_cst,
+            // so either a producer sees `sleeping_` and wakes us, or we see its
+            // bump and do not sleep -- never neither.
+            sleeping_.store(true, std::memory_order_seq_cst);
+            if (signal_.load(std::memory_order_seq_cst) == seen)
+            {
+                signal_.wait(seen, std::memory_order_acquire);
+            }
+            sleeping_.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    void stop();
+
+    std::uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    // A snapshot, for a progress line.
+    std::size_t depth() const;
+
+    std::size_t capacity() const { return mask_ + 1; }
+
+    // Payload buffers larger than this are freed after use instead of kept.
+    static constexpr std::size_t kRetainedSlabBytes = 64 * 1024;
+
+  private:
+    struct Slot
+    {
+        // enqueue position == sequence: free for the producer claiming it.
+        // enqueue position + 1 == sequence: filled, for the consumer.
+        std::atomic<std::size_t> sequence{0};
+
+        const std::string* key = nullptr;
+        const std::string* schema = nullptr;
+        const std::string* origin_zid = nullptr;
+        std::vector<std::uint8_t> payload;
+        std::uint64_t log_time_ns = 0;
+        std::optional<std::uint64_t> publish_time_ns;
+    };
+
+    // Claims the oldest filled slot, or returns null if there is none ready.
+    // Used by the writer to consume and by a producer to discard.
+    Slot* claimOldest(std::size_t& position);
+
+    // Hands a claimed slot back to the producers.
+    void release(Slot& slot, std::size_t position);
+
+    template <typename Visit>
+    bool tryPop(Visit& visit)
+    {
+        std::size_t position = 0;
+        Slot* const slot = claimOldest(position);
+        if (slot == nullptr)
+        {
+            return false;
+        }
+
+        RingMessage message;
+        message.key = *slot->key;
+        message.schema = *slot->schema;
+        message.origin_zid = *slot->origin_zid;
+        message.log_time_ns = slot->log_time_ns;
+        message.publish_time_ns = slot->publish_time_ns;
+
+        // Released BEFORE the visit, which may be a slow disk write. The
+        // strings are interned and outlive the slot; the payload leaves with
+        // the swap.
+        spare_.swap(slot->payload);
+        release(*slot, position);
+
+        message.payload = spare_;
+        visit(message);
+
+        if (spare_.capacity() > kRetainedSlabBytes)
+        {
+            spare_ = {};
+        }
+        return true;
+    }
+
+    std::vector<Slot> slots_;
+    std::size_t mask_;
+
+    // On separate cache lines: every producer writes the first and the writer
+    // writes the second, and sharing one would make each invalidate the other
+    // on every message.
+    alignas(64) std::atomic<std::size_t> enqueue_{0};
+    alignas(64) std::atomic<std::size_t> dequeue_{0};
+
+    // A wake-up is a futex syscall. Producers make one only when the writer
+    // has said it is about to sleep, which under load it never is.
+    alignas(64) std::atomic<std::uint32_t> signal_{0};
+    std::atomic<bool> sleeping_{false};
+    std::atomic<bool> stopped_{false};
+    std::atomic<std::uint64_t> dropped_{0};
+
+    InternTable strings_;
+
+    // The writer's half of the slab exchange. Writer thread only.
+    std::vector<std::uint8_t> spare_;
+};
+
+}  // namespace bag
+
+#endif  // BAG_RING_QUEUE_H_
@@ -29,7 +29,10 @@ struct WriterOptions
     // is unreadable in its entirety.
     std::uint64_t chunk_bytes = 4ull * 1024 * 1024;
 
-    // Roll to a new part past this size. Zero disables size rolling.
+    // Roll to a new part past this size. Zero disables size rolling. Checked
+    // every few hundred messages, so a part runs a little over; chunks still
+    // being compressed by compression_threads count as written, so the
+    // pipeline's depth does not add to that.
     std::uint64_t max_part_bytes = 2ull * 1024 * 1024 * 1024;
 
     // Roll to a new part past this many seconds. Zero disables time rolling.
@@ -41,6 +44,28 @@ struct WriterOptions
 
     // Recorded in metadata.yaml so a file can say what made it.
     std::string recorder = "redline bag";
+
+    // Compress chunks on this many worker threads, with one more appending
+    // them to the file in order, while the writer thread goes on building the
+    // next. Zero keeps mcap's own writer, which compresses each chunk inline
+    // on the writer thread -- fine at the default level, and the reason a
+    // higher one drops messages. See pipelined_writer.h. Parts, rolling,
+    // metadata.yaml and the layout inside each part are the same either way.
+    unsigned compression_threads = 0;
+};
+
+// A snapshot of what the pipelined writer's stages have done, for throughput
+// figures. All zero when compression_threads is zero.
+struct WriterStageStats
+{
+    std::uint64_t chunks = 0;
+    std::uint64_t uncompressed_bytes = 0;
+    std::uint64_t compressed_bytes = 0;
+
+    double build_seconds = 0.0;     // Writer thread, framing records.
+    double compress_seconds = 0.0;  // Summed over the worker threads.
+    double append_seconds = 0.0;    // Appending thread, writing to disk.
+    double stalled_seconds = 0.0;   // Writer thread, waiting for a free chunk.
 };
 
 // Writes a bag directory: metadata.yaml plus rolled .mcap parts.
@@ -99,6 +124,11 @@ class BagWriter
     // The index as it currently stands. Complete only after close().
     const bag_metadata_t& metadata() const;
 
+    // The one call that is safe from another thread: the counters behind it
+    // are atomics, so a progress line can read them while the writer thread
+    // runs.
+    WriterStageStats stageStats() const;
+
   private:
     struct Impl;
     std::unique_ptr<Impl> impl_;
@@ -0,0 +1,577 @@
+#include "bag/mapped_part.h"
+
+#include <lz4frame.h>
+#include <zstd.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+namespace bag
+{
+
+namespace
+{
+
+// ------------------------------------------------------------------ the spec
+//
+// From build/_deps/mcap-src/website/docs/spec/index.md. Only the records a
+// summary-driven read needs; anything else is skipped by its length.
+
+constexpr std::array<std::uint8_t, 8> kMagic{0x89, 'M', 'C', 'A', 'P', 0x30, '\r', '\n'};
+
+enum Op : std::uint8_t
+{
+    kFooter = 0x02,
+    kSchema = 0x03,
+    kChannel = 0x04,
+    kMessage = 0x05,
+    kChunk = 0x06,
+    kMessageIndex = 0x07,
+    kChunkIndex = 0x08,
+    kStatistics = 0x0B,
+};
+
+// Opcode, length, and three fixed fields: summary start, summary offset start,
+// summary CRC.
+constexpr std::size_t kFooterBytes = 1 + 8 + 8 + 8 + 4;
+
+// The most each codec can make of one compressed byte. Not guesses: a zstd RLE
+// block is four bytes standing for up to 128 KiB, and an LZ4 sequence extends a
+// match by at most 255 bytes per byte read. A Chunk claiming more than that of
+// its records came from a corrupt or torn file, and its uncompressed_size must
+// not become an allocation.
+constexpr std::uint64_t kZstdMaxRatio = 128 * 1024 / 4;
+constexpr std::uint64_t kLz4MaxRatio = 255;
+
+// And a ceiling whatever the ratio allows. mcap's writer and ours seal a chunk
+// at chunk_bytes -- 4 MB by default -- so only a single message this large
+// could make one; nothing in a recording is.
+constexpr std::uint64_t kMaxChunkBytes = 1ull << 30;
+
+// Whether `records` bytes of a codec that expands by at most `max_ratio` can
+// decompress to `uncompressed` bytes. Divided rather than multiplied, so a
+// damaged size cannot overflow its way past the check.
+bool plausibleSize(std::uint64_t uncompressed, std::uint64_t records, std::uint64_t max_ratio)
+{
+    return uncompressed <= kMaxChunkBytes && uncompressed / max_ratio <= records;
+}
+
+// A bounds-checked little-endian reader over a byte range. A read past the end
+// sets `bad` and yields zero, so a damaged record is one check at the end of
+// parsing it rather than one per field.
+struct Fields
+{
+    const std::uint8_t* data;
+    std::size_t size;
+    std::size_t at = 0;
+    bool bad = false;
+
+    bool take(std::size_t count)
+    {
+        if (bad || count > size - at)
+        {
+            bad = true;
+            return false;
+        }
+        return true;
+    }
+
+    template <typename T>
+    T little()
+    {
+        if (!take(sizeof(T)))
+        {
+            return 0;
+        }
+        T value = 0;
+        for (std::size_t i = 0; i < sizeof(T); ++i)
+        {
+            value = static_cast<T>(value | (static_cast<T>(data[at + i]) << (8u * i)));
+        }
+        at += sizeof(T);
+        return value;
+    }
+
+    std::string str()
+    {
+        const std::uint32_t length = little<std::uint32_t>();
+        if (!take(length))
+        {
+            return {};
+        }
+        std::string value(reinterpret_cast<const char*>(data + at), length);
+        at += length;
+        return value;
+    }
+
+    void skip(std::uint64_t count)
+    {
+        if (take(count))
+        {
+            at += count;
+        }
+    }
+};
+
+}  // namespace
+
+// ------------------------------------------------------------------ MappedPart
+
+std::unique_ptr<MappedPart> MappedPart::open(const std::string& path, std::string& why)
+{
+    std::unique_ptr<MappedPart> part(new MappedPart());
+    part->path_ = path;
+
+    part->fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (part->fd_ < 0)
+    {
+        why = "cannot open: " + std::string(std::strerror(errno));
+        return nullptr;
+    }
+
+    struct stat info{};
+    if (::fstat(part->fd_, &info) != 0)
+    {
+        why = "cannot stat: " + std::string(std::strerror(errno));
+        return nullptr;
+    }
+    part->size_ = static_cast<std::size_t>(info.st_size);
+    if (part->size_ < 2 * kMagic.size() + kFooterBytes)
+    {
+        why = "too short to hold a footer";
+        return nullptr;
+    }
+
+    void* address = ::mmap(nullptr, part->size_, PROT_READ, MAP_PRIVATE, part->fd_, 0);
+    if (address == MAP_FAILED)
+    {
+        why = "cannot map: " + std::string(std::strerror(errno));
+        return nullptr;
+    }
+    part->data_ = static_cast<const std::uint8_t*>(address);
+
+    if (!part->parseSummary(why))
+    {
+        return nullptr;
+    }
+    return part;
+}
+
+MappedPart::~MappedPart()
+{
+    if (data_ != nullptr)
+    {
+        ::munmap(const_cast<std::uint8_t*>(data_), size_);
+    }
+    if (fd_ >= 0)
+    {
+        ::close(fd_);
+    }
+}
+
+bool MappedPart::parseSummary(std::string& why)
+{
+    if (std::memcmp(data_, kMagic.data(), kMagic.size()) != 0 ||
+        std::memcmp(data_ + size_ - kMagic.size(), kMagic.data(), kMagic.size()) != 0)
+    {
+        // No closing magic is what a killed writer leaves.
+        why = "no MCAP magic at both ends";
+        return false;
+    }
+
+    const std::size_t footer_offset = size_ - kMagic.size() - kFooterBytes;
+    Fields footer{data_ + footer_offset, kFooterBytes};
+    const std::uint8_t footer_op = footer.little<std::uint8_t>();
+    const std::uint64_t footer_length = footer.little<std::uint64_t>();
+    const std::uint64_t summary_start = footer.little<std::uint64_t>();
+    if (footer_op != kFooter || footer_length != kFooterBytes - 9)
+    {
+        why = "no footer";
+        return false;
+    }
+    if (summary_start == 0 || summary_start < kMagic.size() || summary_start > footer_offset)
+    {
+        why = "no summary";
+        return false;
+    }
+
+    std::map<std::uint16_t, std::string> schema_names;
+    std::map<std::uint16_t, std::uint16_t> channel_schemas;
+    bool saw_statistics = false;
+    std::uint64_t statistics_messages = 0;
+
+    Fields summary{data_ + summary_start, footer_offset - summary_start};
+    while (summary.at < summary.size)
+    {
+        const std::uint8_t op = summary.little<std::uint8_t>();
+        const std::uint64_t length = summary.little<std::uint64_t>();
+        if (!summary.take(length))
+        {
+            break;
+        }
+        Fields record{summary.data + summary.at, static_cast<std::size_t>(length)};
+        summary.at += length;
+
+        switch (op)
+        {
+            case kSchema:
+            {
+                const std::uint16_t id = record.little<std::uint16_t>();
+                std::string name = record.str();
+                if (!record.bad)
+                {
+                    schema_names[id] = std::move(name);
+                }
+                break;
+            }
+            case kChannel:
+            {
+                const std::uint16_t id = record.little<std::uint16_t>();
+                const std::uint16_t schema_id = record.little<std::uint16_t>();
+                Channel channel;
+                channel.topic = record.str();
+                (void)record.str();  // message_encoding
+
+                const std::uint32_t metadata_bytes = record.little<std::uint32_t>();
+                const std::size_t metadata_end = record.at + metadata_bytes;
+                while (!record.bad && record.at < metadata_end)
+                {
+                    std::string key = record.str();
+                    std::string value = record.str();
+                    if (key == "redline/schema")
+                    {
+                        channel.schema = std::move(value);
+                    }
+                }
+                if (!record.bad)
+                {
+                    channel_schemas[id] = schema_id;
+                    channels_[id] = std::move(channel);
+                }
+                break;
+            }
+            case kChunkIndex:
+            {
+                ChunkRef chunk;
+                chunk.start_ns = record.little<std::uint64_t>();
+                chunk.end_ns = record.little<std::uint64_t>();
+                chunk.offset = record.little<std::uint64_t>();
+                chunk.length = record.little<std::uint64_t>();
+                const std::uint32_t offsets_bytes = record.little<std::uint32_t>();
+                const std::size_t offsets_end = record.at + offsets_bytes;
+                while (!record.bad && record.at < offsets_end)
+                {
+                    const std::uint16_t channel_id = record.little<std::uint16_t>();
+                    const std::uint64_t offset = record.little<std::uint64_t>();
+                    chunk.message_indexes.emplace_back(channel_id, offset);
+                }
+                std::sort(chunk.message_indexes.begin(), chunk.message_indexes.end());
+                (void)record.little<std::uint64_t>();          // message_index_length
+                (void)record.str();                            // compression
+                (void)record.little<std::uint64_t>();          // compressed_size
+                chunk.uncompressed_size = record.little<std::uint64_t>();
+                if (!record.bad && chunk.offset < size_ && chunk.length <= size_ - chunk.offset)
+                {
+                    chunks_.push_back(chunk);
+                }
+                break;
+            }
+            case kStatistics:
+                statistics_messages = record.little<std::uint64_t>();
+                saw_statistics = !record.bad;
+                break;
+            default:
+                break;
+        }
+    }
+
+    // A summary with no ChunkIndex is either an empty part, which Statistics
+    // says, or an unchunked file this cannot seek in -- mcap's reader can.
+    if (chunks_.empty() && !(saw_statistics && statistics_messages == 0))
+    {
+        why = "no chunk index in the summary";
+        return false;
+    }
+
+    for (auto& [id, channel] : channels_)
+    {
+        if (channel.schema.empty())
+        {
+            if (const auto found = schema_names.find(channel_schemas[id]);
+                found != schema_names.end())
+            {
+                channel.schema = found->second;
+            }
+        }
+    }
+
+    std::sort(chunks_.begin(), chunks_.end(),
+              [](const ChunkRef& a, const ChunkRef& b)
+              { return a.start_ns != b.start_ns ? a.start_ns < b.start_ns : a.offset < b.offset; });
+    return true;
+}
+
+const MappedPart::Channel* MappedPart::channel(std::uint16_t id) const
+{
+    const auto found = channels_.find(id);
+    return found == channels_.end() ? nullptr : &found->second;
+}
+
+std::shared_ptr<const MappedPart::TimeIndex> MappedPart::timeIndex(
+    std::uint16_t channel_id) const
+{
+    // Held while building, so two readers asking for the same channel build
+    // it once. Building reads index records only, never a chunk.
+    const std::lock_guard<std::mutex> guard(time_indexes_mutex_);
+    if (const auto found = time_indexes_.find(channel_id); found != time_indexes_.end())
+    {
+        return found->second;
+    }
+
+    auto index = std::make_shared<TimeIndex>();
+    for (std::size_t ordinal = 0; ordinal < chunks_.size(); ++ordinal)
+    {
+        const ChunkRef& chunk = chunks_[ordinal];
+        const auto chunk_ordinal = static_cast<std::uint32_t>(ordinal);
+        if (chunk.message_indexes.empty())
+        {
+            index->unindexed.push_back(chunk_ordinal);
+            continue;
+        }
+
+        const auto found = std::lower_bound(
+            chunk.message_indexes.begin(), chunk.message_indexes.end(), channel_id,
+            [](const std::pair<std::uint16_t, std::uint64_t>& entry, std::uint16_t id)
+            { return entry.first < id; });
+        if (found == chunk.message_indexes.end() || found->first != channel_id)
+        {
+            continue;  // The writer indexed this chunk, and the channel is not in it.
+        }
+
+        // The record, bounded by its own length so a bad one cannot read into
+        // the next.
+        Fields header{data_, size_,
+                      static_cast<std::size_t>(std::min<std::uint64_t>(found->second, size_))};
+        const std::uint8_t op = header.little<std::uint8_t>();
+        const std::uint64_t length = header.little<std::uint64_t>();
+        Fields record{header.data + header.at, 0};
+        if (header.take(length))
+        {
+            record.size = static_cast<std::size_t>(length);
+        }
+        const std::uint16_t id = record.little<std::uint16_t>();
+        const std::uint32_t entries_bytes = record.little<std::uint32_t>();
+        if (op != kMessageIndex || id != channel_id || header.bad || !record.take(entries_bytes))
+        {
+            index->unindexed.push_back(chunk_ordinal);
+            continue;
+        }
+
+        const std::size_t entries_end = record.at + entries_bytes;
+        while (!record.bad && record.at < entries_end)
+        {
+            const std::uint64_t log_time_ns = record.little<std::uint64_t>();
+            (void)record.little<std::uint64_t>();  // offset into the chunk's records
+            index->entries.emplace_back(log_time_ns, chunk_ordinal);
+        }
+    }
+
+    std::sort(index->entries.begin(), index->entries.end());
+    index->entries.shrink_to_fit();
+
+    time_indexes_.emplace(channel_id, index);
+    return index;
+}
+
+std::shared_ptr<const DecodedChunk> MappedPart::decode(const ChunkRef& ref,
+                                                       std::string& error) const
+{
+    Fields chunk{data_ + ref.offset, static_cast<std::size_t>(ref.length)};
+    const std::uint8_t op = chunk.little<std::uint8_t>();
+    (void)chunk.little<std::uint64_t>();  // record length, which `ref.length` covers
+    (void)chunk.little<std::uint64_t>();  // message_start_time
+    (void)chunk.little<std::uint64_t>();  // message_end_time
+    const std::uint64_t uncompressed_size = chunk.little<std::uint64_t>();
+    (void)chunk.little<std::uint32_t>();  // uncompressed_crc
+    const std::string compression = chunk.str();
+    const std::uint64_t records_size = chunk.little<std::uint64_t>();
+    if (op != kChunk || !chunk.take(records_size))
+    {
+        error = "the ChunkIndex points at something that is not a whole Chunk record";
+        return nullptr;
+    }
+    const std::uint8_t* const records = chunk.data + chunk.at;
+
+    auto decoded = std::make_shared<DecodedChunk>();
+
+    if (compression.empty())
+    {
+        decoded->bytes = std::span<const std::uint8_t>(records, records_size);
+    }
+    else if (compression == "zstd")
+    {
+        if (!plausibleSize(uncompressed_size, records_size, kZstdMaxRatio))
+        {
+            error = "zstd: a chunk of " + std::to_string(records_size) + " bytes claims " +
+                    std::to_string(uncompressed_size) + " uncompressed";
+            return nullptr;
+        }
+        decoded->decompressed.resize(uncompressed_size);
+        const std::size_t produced = ZSTD_decompress(decoded->decompressed.data(),
+                                                     decoded->decompressed.size(), records,
+                                                     records_size);
+        if (ZSTD_isError(produced) || produced != uncompressed_size)
+        {
+            error = std::string("zstd: ") +
+                    (ZSTD_isError(produced) ? ZSTD_getErrorName(produced) : "short chunk");
+            return nullptr;
+        }
+        decoded->bytes = decoded->decompressed;
+    }
+    else if (compression == "lz4")
+    {
+        // FRAME format, as mcap writes it.
+        if (!plausibleSize(uncompressed_size, records_size, kLz4MaxRatio))
+        {
+            error = "lz4: a chunk of " + std::to_string(records_size) + " bytes claims " +
+                    std::to_string(uncompressed_size) + " uncompressed";
+            return nullptr;
+        }
+        LZ4F_dctx* context = nullptr;
+        if (LZ4F_isError(LZ4F_createDecompressionContext(&context, LZ4F_VERSION)))
+        {
+            error = "lz4: could not create a decompression context";
+            return nullptr;
+        }
+        decoded->decompressed.resize(uncompressed_size);
+        std::size_t destination_size = decoded->decompressed.size();
+        std::size_t source_size = records_size;
+        const std::size_t status = LZ4F_decompress(context, decoded->decompressed.data(),
+                                                   &destination_size, records, &source_size,
+                                                   nullptr);
+        LZ4F_freeDecompressionContext(context);
+        if (LZ4F_isError(status) || destination_size != uncompressed_size)
+        {
+            error = std::string("lz4: ") +
+                    (LZ4F_isError(status) ? LZ4F_getErrorName(status) : "short chunk");
+            return nullptr;
+        }
+        decoded->bytes = decoded->decompressed;
+    }
+    else
+    {
+        error = "unknown compression '" + compression + "'";
+        return nullptr;
+    }
+
+    // Index the Message records. Schema and Channel records in the chunk are
+    // the summary's, repeated, and skipped.
+    Fields walk{decoded->bytes.data(), decoded->bytes.size()};
+    while (walk.at < walk.size)
+    {
+        const std::uint8_t record_op = walk.little<std::uint8_t>();
+        const std::uint64_t length = walk.little<std::uint64_t>();
+        if (!walk.take(length))
+        {
+            error = "a record runs past the end of its chunk";
+            return nullptr;
+        }
+
+        if (record_op == kMessage)
+        {
+            Fields message{walk.data + walk.at, static_cast<std::size_t>(length)};
+            DecodedChunk::Message entry;
+            entry.channel_id = message.little<std::uint16_t>();
+            (void)message.little<std::uint32_t>();  // sequence
+            entry.log_time_ns = message.little<std::uint64_t>();
+            entry.publish_time_ns = message.little<std::uint64_t>();
+            if (!message.bad)
+            {
+                entry.offset = walk.at + message.at;
+                entry.size = length - message.at;
+                decoded->messages.push_back(entry);
+            }
+        }
+        walk.at += length;
+    }
+
+    // A chunk interleaves channels, and channels are stamped independently, so
+    // file order is only nearly time order. Sorted once here, not per read.
+    std::stable_sort(decoded->messages.begin(), decoded->messages.end(),
+                     [](const DecodedChunk::Message& a, const DecodedChunk::Message& b)
+                     { return a.log_time_ns < b.log_time_ns; });
+    decoded->messages.shrink_to_fit();
+
+    return decoded;
+}
+
+// ------------------------------------------------------------------ ChunkCache
+
+ChunkCache::ChunkCache(std::size_t capacity_bytes) : capacity_(capacity_bytes) {}
+
+std::shared_ptr<const DecodedChunk> ChunkCache::find(const Key& key)
+{
+    const std::lock_guard<std::mutex> guard(mutex_);
+
+    const auto found = entries_.find(key);
+    if (found == entries_.end())
+    {
+        ++stats_.misses;
+        return nullptr;
+    }
+
+    ++stats_.hits;
+    order_.splice(order_.begin(), order_, found->second.position);
+    return found->second.chunk;
+}
+
+std::shared_ptr<const DecodedChunk> ChunkCache::insert(const Key& key,
+                                                       std::shared_ptr<const DecodedChunk> chunk)
+{
+    const std::size_t bytes = chunk->footprint();
+    if (bytes > capacity_)
+    {
+        return chunk;
+    }
+
+    const std::lock_guard<std::mutex> guard(mutex_);
+
+    if (const auto found = entries_.find(key); found != entries_.end())
+    {
+        order_.splice(order_.begin(), order_, found->second.position);
+        return found->second.chunk;
+    }
+
+    while (!order_.empty() && stats_.bytes + bytes > capacity_)
+    {
+        const auto victim = entries_.find(order_.back());
+        stats_.bytes -= victim->second.bytes;
+        entries_.erase(victim);
+        order_.pop_back();
+        ++stats_.evictions;
+    }
+
+    order_.push_front(key);
+    entries_.emplace(key, Entry{chunk, bytes, order_.begin()});
+    stats_.bytes += bytes;
+    stats_.chunks = entries_.size();
+    return chunk;
+}
+
+ChunkCacheStats ChunkCache::stats() const
+{
+    const std::lock_guard<std::mutex> guard(mutex_);
+    ChunkCacheStats out = stats_;
+    out.chunks = entries_.size();
+    return out;
+}
+
+}  // namespace bag
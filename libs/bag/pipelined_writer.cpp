@@ -0,0 +1,807 @@
+#include "bag/pipelined_writer.h"
+
+#include <lz4frame.h>
+#include <zstd.h>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <limits>
+
+namespace bag
+{
+
+namespace
+{
+
+// ------------------------------------------------------------------ the spec
+//
+// From build/_deps/mcap-src/website/docs/spec/index.md, like validate.cpp's
+// reading of it -- and deliberately NOT sharing that file's helpers. A writer
+// and a validator that agree because they share a bug are what validate.cpp
+// exists to prevent.
+
+constexpr std::array<std::uint8_t, 8> kMagic{0x89, 'M', 'C', 'A', 'P', 0x30, '\r', '\n'};
+
+enum Op : std::uint8_t
+{
+    kHeader = 0x01,
+    kFooter = 0x02,
+    kSchema = 0x03,
+    kChannel = 0x04,
+    kMessage = 0x05,
+    kChunk = 0x06,
+    kMessageIndex = 0x07,
+    kChunkIndex = 0x08,
+    kStatistics = 0x0B,
+    kSummaryOffset = 0x0E,
+    kDataEnd = 0x0F,
+};
+
+// CRC32, IEEE 802.3 reflected, as the spec names it.
+std::uint32_t crc32(std::span<const std::uint8_t> bytes)
+{
+    static const std::array<std::uint32_t, 256> table = []
+    {
+        std::array<std::uint32_t, 256> out{};
+        for (std::uint32_t i = 0; i < 256; ++i)
+        {
+            std::uint32_t r = i;
+            for (int bit = 0; bit < 8; ++bit)
+            {
+                r = ((r & 1u) != 0u) ? (0xEDB88320u ^ (r >> 1u)) : (r >> 1u);
+            }
+            out[i] = r;
+        }
+        return out;
+    }();
+
+    std::uint32_t r = 0xFFFFFFFFu;
+    for (const std::uint8_t byte : bytes)
+    {
+        r = table[(r ^ byte) & 0xFFu] ^ (r >> 8u);
+    }
+    return ~r;
+}
+
+// Little-endian appends onto a byte buffer. Records are framed by opening one
+// with its opcode, appending the fields, and closing it to patch the length in.
+void putU8(std::vector<std::uint8_t>& out, std::uint8_t value)
+{
+    out.push_back(value);
+}
+
+template <typename T>
+void putLittle(std::vector<std::uint8_t>& out, T value)
+{
+    for (std::size_t i = 0; i < sizeof(T); ++i)
+    {
+        out.push_back(static_cast<std::uint8_t>(static_cast<std::uint64_t>(value) >> (8u * i)));
+    }
+}
+
+void putU16(std::vector<std::uint8_t>& out, std::uint16_t value)
+{
+    putLittle(out, value);
+}
+
+void putU32(std::vector<std::uint8_t>& out, std::uint32_t value)
+{
+    putLittle(out, value);
+}
+
+void putU64(std::vector<std::uint8_t>& out, std::uint64_t value)
+{
+    putLittle(out, value);
+}
+
+void patchU32(std::vector<std::uint8_t>& out, std::size_t at, std::uint32_t value)
+{
+    for (std::size_t i = 0; i < 4; ++i)
+    {
+        out[at + i] = static_cast<std::uint8_t>(value >> (8u * i));
+    }
+}
+
+void patchU64(std::vector<std::uint8_t>& out, std::size_t at, std::uint64_t value)
+{
+    for (std::size_t i = 0; i < 8; ++i)
+    {
+        out[at + i] = static_cast<std::uint8_t>(value >> (8u * i));
+    }
+}
+
+void putBytes(std::vector<std::uint8_t>& out, std::span<const std::uint8_t> bytes)
+{
+    out.insert(out.end(), bytes.begin(), bytes.end());
+}
+
+// uint32 length prefix, then the bytes.
+void putString(std::vector<std::uint8_t>& out, std::string_view text)
+{
+    putU32(out, static_cast<std::uint32_t>(text.size()));
+    out.insert(out.end(), text.begin(), text.end());
+}
+
+// Returns where the length goes.
+std::size_t openRecord(std::vector<std::uint8_t>& out, Op op)
+{
+    putU8(out, op);
+    const std::size_t at = out.size();
+    putU64(out, 0);
+    return at;
+}
+
+void closeRecord(std::vector<std::uint8_t>& out, std::size_t at)
+{
+    patchU64(out, at, out.size() - at - 8);
+}
+
+// A Map or Array field: a uint32 byte length, filled in once the entries are.
+std::size_t openSized(std::vector<std::uint8_t>& out)
+{
+    const std::size_t at = out.size();
+    putU32(out, 0);
+    return at;
+}
+
+void closeSized(std::vector<std::uint8_t>& out, std::size_t at)
+{
+    patchU32(out, at, static_cast<std::uint32_t>(out.size() - at - 4));
+}
+
+std::uint64_t nanosSince(std::chrono::steady_clock::time_point start)
+{
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                             start)
+            .count());
+}
+
+// Into `compressed`, setting `compression` to what was actually written: raw
+// only for "none", or if the codec itself fails.
+void compressRecords(std::vector<std::uint8_t>& compressed, std::string& compression,
+                     std::span<const std::uint8_t> records, const std::string& codec, int level,
+                     ZSTD_CCtx* zstd)
+{
+    compression.clear();
+    compressed.clear();
+
+    if (codec == "zstd" && zstd != nullptr)
+    {
+        compressed.resize(ZSTD_compressBound(records.size()));
+        const std::size_t produced = ZSTD_compressCCtx(zstd, compressed.data(), compressed.size(),
+                                                       records.data(), records.size(), level);
+        if (!ZSTD_isError(produced))
+        {
+            compressed.resize(produced);
+            compression = "zstd";
+            return;
+        }
+    }
+    else if (codec == "lz4")
+    {
+        // FRAME format, which is what mcap writes and what every reader of
+        // "lz4" in an MCAP chunk expects.
+        LZ4F_preferences_t preferences{};
+        preferences.compressionLevel = level;
+        compressed.resize(LZ4F_compressFrameBound(records.size(), &preferences));
+        const std::size_t produced =
+            LZ4F_compressFrame(compressed.data(), compressed.size(), records.data(),
+                               records.size(), &preferences);
+        if (!LZ4F_isError(produced))
+        {
+            compressed.resize(produced);
+            compression = "lz4";
+            return;
+        }
+    }
+
+    compressed.clear();
+}
+
+}  // namespace
+
+void PipelinedMcapWriter::Chunk::reset()
+{
+    records.clear();
+    compressed.clear();
+    compression.clear();
+    crc = 0;
+    start_ns = std::numeric_limits<std::uint64_t>::max();
+    end_ns = 0;
+    for (auto& [channel, entries] : index)
+    {
+        entries.clear();
+    }
+}
+
+PipelinedMcapWriter::PipelinedMcapWriter(StageCounters& counters) : counters_(counters) {}
+
+PipelinedMcapWriter::~PipelinedMcapWriter()
+{
+    (void)close();
+}
+
+bool PipelinedMcapWriter::open(const std::string& path, Options options)
+{
+    options_ = std::move(options);
+    options_.threads = std::max(1u, options_.threads);
+    if (options_.chunks_in_flight == 0)
+    {
+        options_.chunks_in_flight = 2 * static_cast<std::size_t>(options_.threads);
+    }
+
+    file_ = std::fopen(path.c_str(), "wb");
+    if (file_ == nullptr)
+    {
+        SPDLOG_ERROR("Could not open '{}' for writing.", path);
+        return false;
+    }
+
+    std::vector<std::uint8_t> head(kMagic.begin(), kMagic.end());
+    const std::size_t at = openRecord(head, kHeader);
+    putString(head, "");  // profile
+    putString(head, options_.library);
+    closeRecord(head, at);
+    if (!writeBytes(head))
+    {
+        failed_.store(true);
+        return false;
+    }
+    on_disk_ = offset_;
+
+    for (unsigned i = 0; i < options_.threads; ++i)
+    {
+        workers_.emplace_back([this] { compressLoop(); });
+    }
+    appender_ = std::thread([this] { appendLoop(); });
+    return true;
+}
+
+std::uint16_t PipelinedMcapWriter::addSchema(std::string_view name, std::string_view encoding,
+                                             std::span<const std::uint8_t> data)
+{
+    Schema schema;
+    schema.name = std::string(name);
+    schema.encoding = std::string(encoding);
+    schema.data.assign(data.begin(), data.end());
+    schemas_.push_back(std::move(schema));
+    return static_cast<std::uint16_t>(schemas_.size());
+}
+
+std::uint16_t PipelinedMcapWriter::addChannel(std::string_view topic,
+                                              std::string_view message_encoding,
+                                              std::uint16_t schema_id,
+                                              const std::map<std::string, std::string>& metadata)
+{
+    Channel channel;
+    channel.topic = std::string(topic);
+    channel.message_encoding = std::string(message_encoding);
+    channel.schema_id = schema_id;
+    channel.metadata = metadata;
+    channels_.push_back(std::move(channel));
+    return static_cast<std::uint16_t>(channels_.size());
+}
+
+bool PipelinedMcapWriter::write(std::uint16_t channel_id, std::uint64_t log_time_ns,
+                                std::uint64_t publish_time_ns, std::span<const std::uint8_t> data)
+{
+    if (file_ == nullptr || closed_ || failed_.load(std::memory_order_relaxed) ||
+        channel_id == 0 || channel_id > channels_.size())
+    {
+        return false;
+    }
+
+    if (!building_)
+    {
+        building_ = takeChunk();
+    }
+
+    const auto started = std::chrono::steady_clock::now();
+    Chunk& chunk = *building_;
+    std::vector<std::uint8_t>& out = chunk.records;
+
+    // First message on this channel in this file: its Schema and Channel go
+    // into the chunk ahead of it, so the chunk can be decoded on its own.
+    Channel& channel = channels_[channel_id - 1];
+    if (!channel.written)
+    {
+        if (channel.schema_id != 0 && !schemas_[channel.schema_id - 1].written)
+        {
+            Schema& schema = schemas_[channel.schema_id - 1];
+            const std::size_t at = openRecord(out, kSchema);
+            putU16(out, channel.schema_id);
+            putString(out, schema.name);
+            putString(out, schema.encoding);
+            putU32(out, static_cast<std::uint32_t>(schema.data.size()));
+            putBytes(out, schema.data);
+            closeRecord(out, at);
+            schema.written = true;
+        }
+
+        const std::size_t at = openRecord(out, kChannel);
+        putU16(out, channel_id);
+        putU16(out, channel.schema_id);
+        putString(out, channel.topic);
+        putString(out, channel.message_encoding);
+        const std::size_t map_at = openSized(out);
+        for (const auto& [key, value] : channel.metadata)
+        {
+            putString(out, key);
+            putString(out, value);
+        }
+        closeSized(out, map_at);
+        closeRecord(out, at);
+        channel.written = true;
+    }
+
+    const std::uint64_t message_offset = out.size();
+    const std::size_t at = openRecord(out, kMessage);
+    putU16(out, channel_id);
+    putU32(out, 0);  // sequence, which mcap leaves at zero too
+    putU64(out, log_time_ns);
+    putU64(out, publish_time_ns);
+    putBytes(out, data);
+    closeRecord(out, at);
+
+    chunk.index[channel_id].emplace_back(log_time_ns, message_offset);
+    chunk.start_ns = std::min(chunk.start_ns, log_time_ns);
+    chunk.end_ns = std::max(chunk.end_ns, log_time_ns);
+
+    if (message_count_ == 0 || log_time_ns < start_ns_)
+    {
+        start_ns_ = log_time_ns;
+    }
+    end_ns_ = std::max(end_ns_, log_time_ns);
+    ++message_count_;
+    ++channel.count;
+
+    if (out.size() >= options_.chunk_bytes)
+    {
+        seal();
+    }
+
+    counters_.build_ns.fetch_add(nanosSince(started), std::memory_order_relaxed);
+    return true;
+}
+
+std::unique_ptr<PipelinedMcapWriter::Chunk> PipelinedMcapWriter::takeChunk()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (in_flight_ >= options_.chunks_in_flight)
+    {
+        const auto started = std::chrono::steady_clock::now();
+        slot_free_.wait(lock,
+                        [&]
+                        {
+                            return in_flight_ < options_.chunks_in_flight ||
+                                   failed_.load(std::memory_order_relaxed);
+                        });
+        counters_.stall_ns.fetch_add(nanosSince(started), std::memory_order_relaxed);
+    }
+
+    std::unique_ptr<Chunk> chunk;
+    if (!spare_.empty())
+    {
+        chunk = std::move(spare_.back());
+        spare_.pop_back();
+    }
+    else
+    {
+        chunk = std::make_unique<Chunk>();
+        chunk->records.reserve(options_.chunk_bytes + options_.chunk_bytes / 8);
+    }
+    lock.unlock();
+
+    chunk->reset();
+    return chunk;
+}
+
+void PipelinedMcapWriter::seal()
+{
+    if (!building_ || building_->records.empty())
+    {
+        return;
+    }
+
+    building_->sequence = next_sequence_++;
+    {
+        const std::lock_guard<std::mutex> guard(mutex_);
+        pending_records_ += building_->records.size();
+        to_compress_.push_back(std::move(building_));
+        ++in_flight_;
+    }
+    work_ready_.notify_one();
+}
+
+void PipelinedMcapWriter::compressLoop()
+{
+    // One context per worker, kept for the part: creating one per chunk costs
+    // more than compressing a small chunk.
+    ZSTD_CCtx* const zstd = options_.compression == "zstd" ? ZSTD_createCCtx() : nullptr;
+
+    for (;;)
+    {
+        std::unique_ptr<Chunk> chunk;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_ready_.wait(lock, [&] { return stopping_ || !to_compress_.empty(); });
+            if (to_compress_.empty())
+            {
+                break;
+            }
+            chunk = std::move(to_compress_.front());
+            to_compress_.pop_front();
+        }
+
+        const auto started = std::chrono::steady_clock::now();
+        chunk->crc = crc32(chunk->records);
+        compressRecords(chunk->compressed, chunk->compression, chunk->records,
+                        options_.compression, options_.level, zstd);
+        counters_.compress_ns.fetch_add(nanosSince(started), std::memory_order_relaxed);
+
+        {
+            const std::lock_guard<std::mutex> guard(mutex_);
+            const std::uint64_t sequence = chunk->sequence;
+            compressed_.emplace(sequence, std::move(chunk));
+        }
+        append_ready_.notify_one();
+    }
+
+    ZSTD_freeCCtx(zstd);
+}
+
+void PipelinedMcapWriter::appendLoop()
+{
+    for (;;)
+    {
+        std::unique_ptr<Chunk> chunk;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            append_ready_.wait(lock,
+                               [&]
+                               {
+                                   return compressed_.count(next_to_append_) != 0 ||
+                                          (stopping_ && in_flight_ == 0);
+                               });
+            const auto found = compressed_.find(next_to_append_);
+            if (found == compressed_.end())
+            {
+                break;
+            }
+            chunk = std::move(found->second);
+            compressed_.erase(found);
+            ++next_to_append_;
+        }
+
+        // After a failure the chunks still come through here, unwritten, so
+        // their slots are freed and a writer waiting on one is released.
+        bool appended = false;
+        if (!failed_.load(std::memory_order_relaxed))
+        {
+            const auto started = std::chrono::steady_clock::now();
+            appended = append(*chunk);
+            if (!appended)
+            {
+                failed_.store(true, std::memory_order_relaxed);
+            }
+            counters_.append_ns.fetch_add(nanosSince(started), std::memory_order_relaxed);
+        }
+
+        {
+            const std::lock_guard<std::mutex> guard(mutex_);
+            pending_records_ -= chunk->records.size();
+            if (appended)
+            {
+                on_disk_ = offset_;
+                landed_records_ += chunk->records.size();
+                landed_body_ += chunk->compression.empty() ? chunk->records.size()
+                                                           : chunk->compressed.size();
+            }
+            spare_.push_back(std::move(chunk));
+            --in_flight_;
+        }
+        slot_free_.notify_one();
+        append_ready_.notify_one();  // In case that was the last one.
+    }
+}
+
+std::uint64_t PipelinedMcapWriter::projectedBytes()
+{
+    const std::uint64_t open = building_ ? building_->records.size() : 0;
+
+    const std::lock_guard<std::mutex> guard(mutex_);
+    if (file_ == nullptr || closed_)
+    {
+        return offset_;
+    }
+    const std::uint64_t waiting = pending_records_ + open;
+    const std::uint64_t expected =
+        landed_records_ == 0
+            ? waiting
+            : static_cast<std::uint64_t>(static_cast<double>(waiting) *
+                                         static_cast<double>(landed_body_) /
+                                         static_cast<double>(landed_records_));
+    return on_disk_ + expected;
+}
+
+bool PipelinedMcapWriter::append(const Chunk& chunk)
+{
+    const bool raw = chunk.compression.empty();
+    const std::span<const std::uint8_t> body =
+        raw ? std::span<const std::uint8_t>(chunk.records) : chunk.compressed;
+
+    ChunkEntry entry;
+    entry.start_ns = chunk.start_ns;
+    entry.end_ns = chunk.end_ns;
+    entry.offset = offset_;
+    entry.compression = chunk.compression;
+    entry.compressed_size = body.size();
+    entry.uncompressed_size = chunk.records.size();
+
+    // The Chunk record's fields, then its records straight from the buffer --
+    // a 4 MB chunk is not copied again just to be framed.
+    std::vector<std::uint8_t> head;
+    const std::size_t at = openRecord(head, kChunk);
+    putU64(head, chunk.start_ns);
+    putU64(head, chunk.end_ns);
+    putU64(head, chunk.records.size());
+    putU32(head, chunk.crc);
+    putString(head, chunk.compression);
+    putU64(head, body.size());
+    patchU64(head, at, head.size() - at - 8 + body.size());
+    entry.length = head.size() + body.size();
+
+    if (!writeBytes(head) || !writeBytes(body))
+    {
+        return false;
+    }
+
+    std::vector<std::uint8_t> indexes;
+    for (const auto& [channel_id, entries] : chunk.index)
+    {
+        if (entries.empty())
+        {
+            continue;
+        }
+        entry.message_index_offsets[channel_id] = offset_ + indexes.size();
+
+        const std::size_t record_at = openRecord(indexes, kMessageIndex);
+        putU16(indexes, channel_id);
+        const std::size_t array_at = openSized(indexes);
+        for (const auto& [log_time_ns, offset] : entries)
+        {
+            putU64(indexes, log_time_ns);
+            putU64(indexes, offset);
+        }
+        closeSized(indexes, array_at);
+        closeRecord(indexes, record_at);
+    }
+    entry.message_index_length = indexes.size();
+
+    if (!writeBytes(indexes))
+    {
+        return false;
+    }
+
+    counters_.chunks.fetch_add(1, std::memory_order_relaxed);
+    counters_.uncompressed_bytes.fetch_add(chunk.records.size(), std::memory_order_relaxed);
+    counters_.compressed_bytes.fetch_add(body.size(), std::memory_order_relaxed);
+
+    chunk_entries_.push_back(std::move(entry));
+    return true;
+}
+
+bool PipelinedMcapWriter::writeSummary()
+{
+    std::vector<std::uint8_t> out;
+
+    const std::size_t data_end_at = openRecord(out, kDataEnd);
+    putU32(out, 0);  // data_section_crc: zero means not computed, as mcap's default.
+    closeRecord(out, data_end_at);
+
+    const std::uint64_t base = offset_;
+    const std::size_t summary_at = out.size();
+
+    struct Group
+    {
+        Op op;
+        std::uint64_t start;
+        std::uint64_t length;
+    };
+    std::vector<Group> groups;
+    const auto group = [&](Op op, std::size_t from)
+    {
+        if (out.size() > from)
+        {
+            groups.push_back({op, base + from, out.size() - from});
+        }
+    };
+
+    // Only what the data section actually carries. Repeating a registration no
+    // message used is the summary-without-data bug validate.cpp was written for.
+    std::size_t from = out.size();
+    for (std::size_t i = 0; i < schemas_.size(); ++i)
+    {
+        const Schema& schema = schemas_[i];
+        if (!schema.written)
+        {
+            continue;
+        }
+        const std::size_t at = openRecord(out, kSchema);
+        putU16(out, static_cast<std::uint16_t>(i + 1));
+        putString(out, schema.name);
+        putString(out, schema.encoding);
+        putU32(out, static_cast<std::uint32_t>(schema.data.size()));
+        putBytes(out, schema.data);
+        closeRecord(out, at);
+    }
+    group(kSchema, from);
+
+    from = out.size();
+    std::uint16_t schema_count = 0;
+    std::uint32_t channel_count = 0;
+    for (const Schema& schema : schemas_)
+    {
+        schema_count += schema.written ? 1 : 0;
+    }
+    for (std::size_t i = 0; i < channels_.size(); ++i)
+    {
+        const Channel& channel = channels_[i];
+        if (!channel.written)
+        {
+            continue;
+        }
+        ++channel_count;
+        const std::size_t at = openRecord(out, kChannel);
+        putU16(out, static_cast<std::uint16_t>(i + 1));
+        putU16(out, channel.schema_id);
+        putString(out, channel.topic);
+        putString(out, channel.message_encoding);
+        const std::size_t map_at = openSized(out);
+        for (const auto& [key, value] : channel.metadata)
+        {
+            putString(out, key);
+            putString(out, value);
+        }
+        closeSized(out, map_at);
+        closeRecord(out, at);
+    }
+    group(kChannel, from);
+
+    from = out.size();
+    {
+        const std::size_t at = openRecord(out, kStatistics);
+        putU64(out, message_count_);
+        putU16(out, schema_count);
+        putU32(out, channel_count);
+        putU32(out, 0);  // attachment_count
+        putU32(out, 0);  // metadata_count
+        putU32(out, static_cast<std::uint32_t>(chunk_entries_.size()));
+        putU64(out, start_ns_);
+        putU64(out, end_ns_);
+        const std::size_t map_at = openSized(out);
+        for (std::size_t i = 0; i < channels_.size(); ++i)
+        {
+            if (channels_[i].count != 0)
+            {
+                putU16(out, static_cast<std::uint16_t>(i + 1));
+                putU64(out, channels_[i].count);
+            }
+        }
+        closeSized(out, map_at);
+        closeRecord(out, at);
+    }
+    group(kStatistics, from);
+
+    from = out.size();
+    for (const ChunkEntry& entry : chunk_entries_)
+    {
+        const std::size_t at = openRecord(out, kChunkIndex);
+        putU64(out, entry.start_ns);
+        putU64(out, entry.end_ns);
+        putU64(out, entry.offset);
+        putU64(out, entry.length);
+        const std::size_t map_at = openSized(out);
+        for (const auto& [channel_id, offset] : entry.message_index_offsets)
+        {
+            putU16(out, channel_id);
+            putU64(out, offset);
+        }
+        closeSized(out, map_at);
+        putU64(out, entry.message_index_length);
+        putString(out, entry.compression);
+        putU64(out, entry.compressed_size);
+        putU64(out, entry.uncompressed_size);
+        closeRecord(out, at);
+    }
+    group(kChunkIndex, from);
+
+    const std::uint64_t summary_offset_start = base + out.size();
+    for (const Group& g : groups)
+    {
+        const std::size_t at = openRecord(out, kSummaryOffset);
+        putU8(out, g.op);
+        putU64(out, g.start);
+        putU64(out, g.length);
+        closeRecord(out, at);
+    }
+
+    // The summary CRC covers everything from the summary's first byte up to
+    // and including the footer's summary_offset_start field -- the footer's
+    // length among it, so that is written outright rather than patched after.
+    putU8(out, kFooter);
+    putU64(out, 8 + 8 + 4);
+    putU64(out, base + summary_at);
+    putU64(out, summary_offset_start);
+    putU32(out, crc32(std::span<const std::uint8_t>(out).subspan(summary_at)));
+
+    out.insert(out.end(), kMagic.begin(), kMagic.end());
+    return writeBytes(out);
+}
+
+bool PipelinedMcapWriter::writeBytes(std::span<const std::uint8_t> bytes)
+{
+    if (!bytes.empty() && std::fwrite(bytes.data(), 1, bytes.size(), file_) != bytes.size())
+    {
+        SPDLOG_ERROR("Write of {} bytes failed.", bytes.size());
+        return false;
+    }
+    offset_ += bytes.size();
+    return true;
+}
+
+void PipelinedMcapWriter::stopThreads()
+{
+    {
+        const std::lock_guard<std::mutex> guard(mutex_);
+        stopping_ = true;
+    }
+    work_ready_.notify_all();
+    append_ready_.notify_all();
+
+    for (std::thread& worker : workers_)
+    {
+        worker.join();
+    }
+    workers_.clear();
+    if (appender_.joinable())
+    {
+        appender_.join();
+    }
+}
+
+bool PipelinedMcapWriter::close()
+{
+    if (closed_)
+    {
+        return !failed_.load();
+    }
+    closed_ = true;
+
+    if (file_ == nullptr)
+    {
+        return false;
+    }
+
+    seal();
+    stopThreads();
+
+    bool ok = !failed_.load() && writeSummary();
+    if (std::fclose(file_) != 0)
+    {
+        ok = false;
+    }
+    file_ = nullptr;
+
+    if (!ok)
+    {
+        failed_.store(true);
+    }
+    return ok;
+}
+
+}  // namespace bag
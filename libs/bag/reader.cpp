@@ -1,16 +1,167 @@
 #include "bag/reader.h"
 
+#include "bag/mapped_part.h"
+
 #include <mcap/reader.hpp>
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <filesystem>
 #include <map>
+#include <mutex>
 #include <system_error>
 
 namespace bag
 {
 
+namespace
+{
+
+// One part through mcap's reader: opened, indexed and read afresh. Every part
+// goes this way uncached, and a part the cached path cannot map -- a torn one,
+// above all -- goes this way either way. False only if the file would not open.
+bool readWithMcap(const std::string& path, std::uint64_t start_ns, std::uint64_t end_ns,
+                  const std::vector<std::string>* topics,
+                  const std::function<bool(const BagMessage&)>& callback, bool& keep_going)
+{
+    mcap::McapReader reader;
+    const mcap::Status status = reader.open(path);
+    if (!status.ok())
+    {
+        SPDLOG_ERROR("Could not open '{}': {}", path, status.message);
+        return false;
+    }
+
+    // Build the seeking indexes, falling back to a sequential scan when the
+    // summary is missing or incomplete.
+    //
+    // THIS LINE IS WHY A CRASHED RECORDING IS READABLE. A part whose writer
+    // was killed has no summary -- no ChunkIndex, no Statistics, no footer.
+    // Without an explicit fallback the reader finds no index, and
+    // readMessages() in LogTimeOrder (which needs chunk indexes to merge
+    // channels) yields NOTHING. Not an error, not a warning: zero messages
+    // from a file with megabytes of perfectly good data in it.
+    //
+    // That is the worst possible failure for this tool. The recording you
+    // most want is the one that ended in a crash, and it would have come
+    // back empty while reporting success.
+    //
+    // The scan costs a pass over the data section, paid only for a part that
+    // actually lacks a summary -- AllowFallbackScan uses the summary when
+    // there is one.
+    const mcap::Status summary = reader.readSummary(
+        mcap::ReadSummaryMethod::AllowFallbackScan,
+        [&](const mcap::Status& problem)
+        { SPDLOG_DEBUG("'{}' while indexing: {}", path, problem.message); });
+
+    mcap::ReadMessageOptions options;
+    options.startTime = start_ns;
+
+    // MCAP's range is half-open at the top and ours is closed, because a
+    // caller asking for "up to t" means "including anything stamped exactly
+    // t". Guarded against overflow: the default end is UINT64_MAX.
+    options.endTime = end_ns == std::numeric_limits<std::uint64_t>::max() ? end_ns
+                                                                         : end_ns + 1;
+
+    // Sorted by log time WHEN THERE IS A MESSAGE INDEX TO SORT BY, and
+    // sequentially otherwise.
+    //
+    // The condition is not `summary.ok()`, and that distinction is the whole
+    // fix. AllowFallbackScan on a torn part SUCCEEDS: it scans the data
+    // section and produces perfectly good ChunkIndex records. What it cannot
+    // produce is MessageIndex records, because those live in the summary
+    // that the crash took with it -- and LogTimeOrder needs them to merge
+    // channels. Asked for it anyway, the reader reports "cannot read MCAP in
+    // time order with no message indexes" through the problem callback and
+    // yields ZERO messages.
+    //
+    // So a status check passes, the read succeeds, and a file with megabytes
+    // of recoverable data comes back empty. That is the worst failure this
+    // tool could have: the recording you most want is the one that ended in
+    // a crash.
+    //
+    // The tradeoff of falling back is real but small: file order is only
+    // APPROXIMATELY time order once several channels interleave within a
+    // chunk. An intact recording gets exact ordering; a damaged one gets its
+    // messages at all, slightly out of order.
+    bool has_message_indexes = false;
+    for (const mcap::ChunkIndex& chunk : reader.chunkIndexes())
+    {
+        if (!chunk.messageIndexOffsets.empty())
+        {
+            has_message_indexes = true;
+            break;
+        }
+    }
+
+    // mcap skips a chunk whose ChunkIndex lists none of the filtered channels
+    // among its message index offsets, so a topic set reads fewer chunks here
+    // too -- just not as few as the cached path, which also knows when within
+    // a chunk each topic's messages are.
+    if (topics != nullptr)
+    {
+        options.topicFilter = [topics](std::string_view topic)
+        { return std::find(topics->begin(), topics->end(), topic) != topics->end(); };
+    }
+
+    options.readOrder = has_message_indexes
+                            ? mcap::ReadMessageOptions::ReadOrder::LogTimeOrder
+                            : mcap::ReadMessageOptions::ReadOrder::FileOrder;
+
+    if (!has_message_indexes)
+    {
+        SPDLOG_WARN("'{}' has no message index -- its writer did not finish{}. Reading it "
+                    "sequentially; messages may be slightly out of time order.",
+                    path, summary.ok() ? "" : (" (" + summary.message + ")"));
+    }
+
+    // The problem list already told the caller about a torn part; here we
+    // just take what is readable and move on rather than aborting the whole
+    // recording for the last few damaged bytes.
+    auto onProblem = [&](const mcap::Status& problem)
+    {
+        SPDLOG_DEBUG("'{}': {}", path, problem.message);
+    };
+
+    keep_going = true;
+    for (const mcap::MessageView& view : reader.readMessages(onProblem, options))
+    {
+        BagMessage message;
+        message.key = view.channel->topic;
+
+        // The registry name from the channel metadata, not the Schema
+        // record's name -- that one is capnp's qualified form, which is
+        // right for a foreign consumer and wrong for us.
+        if (const auto found = view.channel->metadata.find("redline/schema");
+            found != view.channel->metadata.end())
+        {
+            message.schema = found->second;
+        }
+        else if (view.schema)
+        {
+            message.schema = view.schema->name;
+        }
+
+        message.payload = std::span<const std::uint8_t>(
+            reinterpret_cast<const std::uint8_t*>(view.message.data),
+            view.message.dataSize);
+        message.log_time_ns = view.message.logTime;
+        message.publish_time_ns = view.message.publishTime;
+
+        if (!callback(message))
+        {
+            keep_going = false;
+            break;
+        }
+    }
+
+    reader.close();
+    return true;
+}
+
+}  // namespace
+
 struct BagReader::Impl
 {
     std::string directory;
@@ -88,11 +239,305 @@ struct BagReader::Impl
             reader.close();
         }
     }
+
+    // ---------------------------------------------------------- cached mode
+
+    ReaderOptions options;
+
+    // Parallel to metadata.parts. A part is mapped the first time a read
+    // reaches it and stays mapped for the reader's lifetime, so a pointer
+    // handed out here never dangles. `map_tried` keeps a part that cannot be
+    // mapped from being retried -- and its reason logged -- on every call.
+    std::mutex parts_mutex;
+    std::vector<std::unique_ptr<MappedPart>> mapped;
+    std::vector<bool> map_tried;
+
+    std::unique_ptr<ChunkCache> chunk_cache;
+
+    // Null when the part has no summary to drive a read, or cannot be mapped.
+    const MappedPart* mappedPart(std::size_t index, const std::string& path)
+    {
+        const std::lock_guard<std::mutex> guard(parts_mutex);
+        if (!map_tried[index])
+        {
+            map_tried[index] = true;
+
+            std::string why;
+            mapped[index] = MappedPart::open(path, why);
+            if (!mapped[index])
+            {
+                SPDLOG_DEBUG("'{}' is read through mcap, uncached: {}", path, why);
+            }
+        }
+        return mapped[index].get();
+    }
+
+    std::shared_ptr<const DecodedChunk> chunkAt(std::size_t index, const MappedPart& part,
+                                                const MappedPart::ChunkRef& ref)
+    {
+        const ChunkCache::Key key{index, ref.offset};
+        if (std::shared_ptr<const DecodedChunk> hit = chunk_cache->find(key))
+        {
+            return hit;
+        }
+
+        // Decoded outside any lock -- see ChunkCache.
+        std::string error;
+        std::shared_ptr<const DecodedChunk> decoded = part.decode(ref, error);
+        if (!decoded)
+        {
+            // What mcap's reader does with a damaged chunk in an indexed part:
+            // say so and carry on with the rest.
+            SPDLOG_WARN("'{}': skipping the chunk at offset {}: {}", part.path(), ref.offset,
+                        error);
+            return nullptr;
+        }
+        return chunk_cache->insert(key, std::move(decoded));
+    }
+
+    // The cached read of one part: the chunks whose ChunkIndex range meets the
+    // window, merged by log_time. Returns false if the callback stopped it.
+    //
+    // A chunk is brought in only once the merge reaches its start time, so a
+    // window's worth of chunks is held at once only where chunks overlap --
+    // which, with channels stamped independently, they do at the edges.
+    //
+    // With `topics`, only the chunks the topics' time indexes place a message
+    // of theirs in, inside the window -- see MappedPart::TimeIndex.
+    bool readMapped(std::size_t index, const MappedPart& part, std::uint64_t start_ns,
+                    std::uint64_t end_ns, const std::vector<std::string>* topics,
+                    const std::function<bool(const BagMessage&)>& callback)
+    {
+        struct Cursor
+        {
+            std::shared_ptr<const DecodedChunk> chunk;
+            std::uint64_t chunk_offset = 0;
+            std::size_t next = 0;
+
+            const DecodedChunk::Message& head() const { return chunk->messages[next]; }
+        };
+
+        std::vector<Cursor> cursors;
+        std::vector<std::size_t> heap;
+
+        // std::push_heap keeps the LARGEST on top, so this says "a comes after
+        // b". Equal log times go in file order, as mcap's reader yields them.
+        const auto after = [&cursors](std::size_t a, std::size_t b)
+        {
+            const DecodedChunk::Message& ma = cursors[a].head();
+            const DecodedChunk::Message& mb = cursors[b].head();
+            if (ma.log_time_ns != mb.log_time_ns)
+            {
+                return ma.log_time_ns > mb.log_time_ns;
+            }
+            if (cursors[a].chunk_offset != cursors[b].chunk_offset)
+            {
+                return cursors[a].chunk_offset > cursors[b].chunk_offset;
+            }
+            return ma.offset > mb.offset;
+        };
+
+        const std::vector<MappedPart::ChunkRef>& chunks = part.chunks();
+        std::size_t next_chunk = 0;
+
+        // Channel ids, sorted, since channels() is. One topic can have several
+        // -- a publisher that changed schema mid-recording.
+        std::vector<std::uint16_t> wanted;
+
+        // Per chunk ordinal: worth opening. Empty means every chunk is.
+        std::vector<bool> holds;
+
+        if (topics != nullptr)
+        {
+            for (const auto& [id, channel] : part.channels())
+            {
+                if (std::find(topics->begin(), topics->end(), channel.topic) != topics->end())
+                {
+                    wanted.push_back(id);
+                }
+            }
+            if (wanted.empty())
+            {
+                return true;  // None of them was recorded in this part.
+            }
+
+            holds.assign(chunks.size(), false);
+            for (const std::uint16_t id : wanted)
+            {
+                const std::shared_ptr<const MappedPart::TimeIndex> time_index = part.timeIndex(id);
+                const auto& entries = time_index->entries;
+                for (auto entry = std::lower_bound(entries.begin(), entries.end(),
+                                                   std::make_pair(start_ns, std::uint32_t{0}));
+                     entry != entries.end() && entry->first <= end_ns; ++entry)
+                {
+                    holds[entry->second] = true;
+                }
+                for (const std::uint32_t ordinal : time_index->unindexed)
+                {
+                    holds[ordinal] = true;
+                }
+            }
+        }
+
+        // Moves a cursor onto the next message a caller asked for. False once
+        // the chunk has none left inside the window.
+        const auto settle = [&](Cursor& cursor)
+        {
+            const std::vector<DecodedChunk::Message>& messages = cursor.chunk->messages;
+            while (cursor.next < messages.size() && !wanted.empty() &&
+                   !std::binary_search(wanted.begin(), wanted.end(),
+                                       messages[cursor.next].channel_id))
+            {
+                ++cursor.next;
+            }
+            return cursor.next < messages.size() && messages[cursor.next].log_time_ns <= end_ns;
+        };
+
+        for (;;)
+        {
+            // Chunks are sorted by start time, so every one that could hold the
+            // next message in order has started by the head's log time.
+            while (next_chunk < chunks.size())
+            {
+                const MappedPart::ChunkRef& ref = chunks[next_chunk];
+                if (ref.start_ns > end_ns)
+                {
+                    next_chunk = chunks.size();  // Nor does anything after it.
+                    break;
+                }
+                if (!heap.empty() && ref.start_ns > cursors[heap.front()].head().log_time_ns)
+                {
+                    break;
+                }
+                const std::size_t ordinal = next_chunk++;
+
+                if (ref.end_ns < start_ns || (!holds.empty() && !holds[ordinal]))
+                {
+                    continue;
+                }
+
+                std::shared_ptr<const DecodedChunk> chunk = chunkAt(index, part, ref);
+                if (!chunk)
+                {
+                    continue;
+                }
+
+                const auto first = std::lower_bound(
+                    chunk->messages.begin(), chunk->messages.end(), start_ns,
+                    [](const DecodedChunk::Message& message, std::uint64_t t)
+                    { return message.log_time_ns < t; });
+
+                Cursor cursor{std::move(chunk), ref.offset, 0};
+                cursor.next = static_cast<std::size_t>(first - cursor.chunk->messages.begin());
+                if (!settle(cursor))
+                {
+                    continue;
+                }
+
+                cursors.push_back(std::move(cursor));
+                heap.push_back(cursors.size() - 1);
+                std::push_heap(heap.begin(), heap.end(), after);
+            }
+
+            if (heap.empty())
+            {
+                return true;
+            }
+
+            std::pop_heap(heap.begin(), heap.end(), after);
+            Cursor& cursor = cursors[heap.back()];
+            const DecodedChunk::Message& head = cursor.head();
+
+            if (const MappedPart::Channel* channel = part.channel(head.channel_id))
+            {
+                BagMessage message;
+                message.key = channel->topic;
+                message.schema = channel->schema;
+                message.payload = cursor.chunk->bytes.subspan(head.offset, head.size);
+                message.log_time_ns = head.log_time_ns;
+                message.publish_time_ns = head.publish_time_ns;
+
+                if (!callback(message))
+                {
+                    return false;
+                }
+            }
+
+            ++cursor.next;
+            if (settle(cursor))
+            {
+                std::push_heap(heap.begin(), heap.end(), after);
+            }
+            else
+            {
+                cursor.chunk.reset();  // Unpinned: the cache may evict it now.
+                heap.pop_back();
+            }
+        }
+    }
+
+    // Both forEach() overloads. `topics` is null for every topic.
+    bool read(std::uint64_t start_ns, std::uint64_t end_ns,
+              const std::vector<std::string>* topics,
+              const std::function<bool(const BagMessage&)>& callback)
+    {
+        if (topics != nullptr && topics->empty())
+        {
+            return true;
+        }
+
+        for (std::size_t index = 0; index < metadata.parts.size(); ++index)
+        {
+            const bag_part_t& part = metadata.parts[index];
+
+            // Parts do not overlap in time -- the writer rolls, it does not
+            // interleave -- so visiting them in order gives a globally ordered
+            // stream, and one entirely outside the window can be skipped without
+            // opening the file at all. On a multi-gigabyte recording that is the
+            // difference between a seek and a scan.
+            if (part.message_count > 0 && (part.t_end_ns < start_ns || part.t_begin_ns > end_ns))
+            {
+                continue;
+            }
+
+            const std::string path = (std::filesystem::path(directory) / part.path).string();
+
+            std::error_code exists_error;
+            if (!std::filesystem::exists(path, exists_error))
+            {
+                continue;  // Already reported by the constructor.
+            }
+
+            bool keep_going = true;
+            const MappedPart* const mapped = options.cached ? mappedPart(index, path) : nullptr;
+            if (mapped != nullptr)
+            {
+                keep_going = readMapped(index, *mapped, start_ns, end_ns, topics, callback);
+            }
+            else if (!readWithMcap(path, start_ns, end_ns, topics, callback, keep_going))
+            {
+                return false;
+            }
+
+            if (!keep_going)
+            {
+                break;
+            }
+        }
+
+        return true;
+    }
 };
 
-BagReader::BagReader(std::string directory) : impl_(std::make_unique<Impl>())
+BagReader::BagReader(std::string directory) : BagReader(std::move(directory), ReaderOptions{})
+{
+}
+
+BagReader::BagReader(std::string directory, ReaderOptions options) :
+    impl_(std::make_unique<Impl>())
 {
     impl_->directory = std::move(directory);
+    impl_->options = options;
 
     const auto loaded = loadMetadata(impl_->directory);
     if (!loaded)
@@ -102,6 +547,13 @@ BagReader::BagReader(std::string directory) : impl_(std::make_unique<Impl>())
     impl_->metadata = *loaded;
     impl_->valid = true;
 
+    if (impl_->options.cached)
+    {
+        impl_->mapped.resize(impl_->metadata.parts.size());
+        impl_->map_tried.resize(impl_->metadata.parts.size(), false);
+        impl_->chunk_cache = std::make_unique<ChunkCache>(impl_->options.chunk_cache_bytes);
+    }
+
     // Checked up front so a caller sees the whole story before reading rather
     // than discovering it partway through. A missing or incomplete part is not
     // fatal -- see the header.
@@ -152,6 +604,31 @@ const std::vector<std::string>& BagReader::problems() const
     return impl_->problems;
 }
 
+ReaderCacheStats BagReader::cacheStats() const
+{
+    ReaderCacheStats stats;
+    if (!impl_->chunk_cache)
+    {
+        return stats;
+    }
+
+    {
+        const std::lock_guard<std::mutex> guard(impl_->parts_mutex);
+        for (const std::unique_ptr<MappedPart>& part : impl_->mapped)
+        {
+            stats.parts_mapped += part ? 1 : 0;
+        }
+    }
+
+    const ChunkCacheStats chunks = impl_->chunk_cache->stats();
+    stats.chunk_hits = chunks.hits;
+    stats.chunk_misses = chunks.misses;
+    stats.chunk_evictions = chunks.evictions;
+    stats.cached_bytes = chunks.bytes;
+    stats.cached_chunks = chunks.chunks;
+    return stats;
+}
+
 std::span<const std::uint8_t> BagReader::descriptorFor(std::string_view schema_name) const
 {
     impl_->loadDescriptors();
@@ -167,161 +644,14 @@ std::span<const std::uint8_t> BagReader::descriptorFor(std::string_view schema_n
 bool BagReader::forEach(std::uint64_t start_ns, std::uint64_t end_ns,
                         const std::function<bool(const BagMessage&)>& callback)
 {
-    if (!impl_->valid)
-    {
-        return false;
-    }
-
-    for (const bag_part_t& part : impl_->metadata.parts)
-    {
-        // Parts do not overlap in time -- the writer rolls, it does not
-        // interleave -- so visiting them in order gives a globally ordered
-        // stream, and one entirely outside the window can be skipped without
-        // opening the file at all. On a multi-gigabyte recording that is the
-        // difference between a seek and a scan.
-        if (part.message_count > 0 && (part.t_end_ns < start_ns || part.t_begin_ns > end_ns))
-        {
-            continue;
-        }
-
-        const std::string path = (std::filesystem::path(impl_->directory) / part.path).string();
-
-        std::error_code exists_error;
-        if (!std::filesystem::exists(path, exists_error))
-        {
-            continue;  // Already reported by the constructor.
-        }
-
-        mcap::McapReader reader;
-        const mcap::Status status = reader.open(path);
-        if (!status.ok())
-        {
-            SPDLOG_ERROR("Could not open '{}': {}", path, status.message);
-            return false;
-        }
-
-        // Build the seeking indexes, falling back to a sequential scan when the
-        // summary is missing or incomplete.
-        //
-        // THIS LINE IS WHY A CRASHED RECORDING IS READABLE. A part whose writer
-        // was killed has no summary -- no ChunkIndex, no Statistics, no footer.
-        // Without an explicit fallback the reader finds no index, and
-        // readMessages() in LogTimeOrder (which needs chunk indexes to merge
-        // channels) yields NOTHING. Not an error, not a warning: zero messages
-        // from a file with megabytes of perfectly good data in it.
-        //
-        // That is the worst possible failure for this tool. The recording you
-        // most want is the one that ended in a crash, and it would have come
-        // back empty while reporting success.
-        //
-        // The scan costs a pass over the data section, paid only for a part that
-        // actually lacks a summary -- AllowFallbackScan uses the summary when
-        // there is one.
-        const mcap::Status summary = reader.readSummary(
-            mcap::ReadSummaryMethod::AllowFallbackScan,
-            [&](const mcap::Status& problem)
-            { SPDLOG_DEBUG("'{}' while indexing: {}", path, problem.message); });
-
-        mcap::ReadMessageOptions options;
-        options.startTime = start_ns;
-
-        // MCAP's range is half-open at the top and ours is closed, because a
-        // caller asking for "up to t" means "including anything stamped exactly
-        // t". Guarded against overflow: the default end is UINT64_MAX.
-        options.endTime = end_ns == std::numeric_limits<std::uint64_t>::max() ? end_ns
-                                                                             : end_ns + 1;
-
-        // Sorted by log time WHEN THERE IS A MESSAGE INDEX TO SORT BY, and
-        // sequentially otherwise.
-        //
-        // The condition is not `summary.ok()`, and that distinction is the whole
-        // fix. AllowFallbackScan on a torn part SUCCEEDS: it scans the data
-        // section and produces perfectly good ChunkIndex records. What it cannot
-        // produce is MessageIndex records, because those live in the summary
-        // that the crash took with it -- and LogTimeOrder needs them to merge
-        // channels. Asked for it anyway, the reader reports "cannot read MCAP in
-        // time order with no message indexes" through the problem callback and
-        // yields ZERO messages.
-        //
-        // So a status check passes, the read succeeds, and a file with megabytes
-        // of recoverable data comes back empty. That is the worst failure this
-        // tool could have: the recording you most want is the one that ended in
-        // a crash.
-        //
-        // The tradeoff of falling back is real but small: file order is only
-        // APPROXIMATELY time order once several channels interleave within a
-        // chunk. An intact recording gets exact ordering; a damaged one gets its
-        // messages at all, slightly out of order.
-        bool has_message_indexes = false;
-        for (const mcap::ChunkIndex& chunk : reader.chunkIndexes())
-        {
-            if (!chunk.messageIndexOffsets.empty())
-            {
-                has_message_indexes = true;
-                break;
-            }
-        }
-
-        options.readOrder = has_message_indexes
-                                ? mcap::ReadMessageOptions::ReadOrder::LogTimeOrder
-                                : mcap::ReadMessageOptions::ReadOrder::FileOrder;
-
-        if (!has_message_indexes)
-        {
-            SPDLOG_WARN("'{}' has no message index -- its writer did not finish{}. Reading it "
-                        "sequentially; messages may be slightly out of time order.",
-                        path, summary.ok() ? "" : (" (" + summary.message + ")"));
-        }
-
-        // The problem list already told the caller about a torn part; here we
-        // just take what is readable and move on rather than aborting the whole
-        // recording for the last few damaged bytes.
-        auto onProblem = [&](const mcap::Status& problem)
-        {
-            SPDLOG_DEBUG("'{}': {}", path, problem.message);
-        };
-
-        bool keep_going = true;
-        for (const mcap::MessageView& view : reader.readMessages(onProblem, options))
-        {
-            BagMessage message;
-            message.key = view.channel->topic;
-
-            // The registry name from the channel metadata, not the Schema
-            // record's name -- that one is capnp's qualified form, which is
-            // right for a foreign consumer and wrong for us.
-            if (const auto found = view.channel->metadata.find("redline/schema");
-                found != view.channel->metadata.end())
-            {
-                message.schema = found->second;
-            }
-            else if (view.schema)
-            {
-                message.schema = view.schema->name;
-            }
-
-            message.payload = std::span<const std::uint8_t>(
-                reinterpret_cast<const std::uint8_t*>(view.message.data),
-                view.message.dataSize);
-            message.log_time_ns = view.message.logTime;
-            message.publish_time_ns = view.message.publishTime;
-
-            if (!callback(message))
-            {
-                keep_going = false;
-                break;
-            }
-        }
-
-        reader.close();
-
-        if (!keep_going)
-        {
-            break;
-        }
-    }
+    return impl_->valid && impl_->read(start_ns, end_ns, nullptr, callback);
+}
 
-    return true;
+bool BagReader::forEach(std::uint64_t start_ns, std::uint64_t end_ns,
+                        const std::vector<std::string>& topics,
+                        const std::function<bool(const BagMessage&)>& callback)
+{
+    return impl_->valid && impl_->read(start_ns, end_ns, &topics, callback);
 }
 
 }  // namespace bag
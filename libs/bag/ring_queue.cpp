@@ -0,0 +1,231 @@
+#include "bag/ring_queue.h"
+
+#include <algorithm>
+#include <bit>
+#include <functional>
+
+namespace bag
+{
+
+// ------------------------------------------------------------------ InternTable
+
+InternTable::InternTable() : slots_(std::make_unique<std::atomic<const std::string*>[]>(kSlots))
+{
+    for (std::size_t i = 0; i < kSlots; ++i)
+    {
+        slots_[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+InternTable::~InternTable() = default;
+
+const std::string* InternTable::intern(std::string_view text)
+{
+    const std::size_t hash = std::hash<std::string_view>{}(text);
+
+    // The fast path: probe until the string or an empty slot. Acquire pairs
+    // with the release below, so a pointer seen here points at a fully built
+    // string.
+    for (std::size_t probe = 0; probe < kSlots; ++probe)
+    {
+        const std::string* entry =
+            slots_[(hash + probe) & (kSlots - 1)].load(std::memory_order_acquire);
+        if (entry == nullptr)
+        {
+            break;
+        }
+        if (*entry == text)
+        {
+            return entry;
+        }
+    }
+
+    // First sight, or a string that lives in the overflow. Probed again under
+    // the lock, because another thread may have inserted the same text since.
+    const std::lock_guard<std::mutex> guard(mutex_);
+
+    std::size_t empty = kSlots;
+    for (std::size_t probe = 0; probe < kSlots; ++probe)
+    {
+        const std::size_t index = (hash + probe) & (kSlots - 1);
+        const std::string* entry = slots_[index].load(std::memory_order_relaxed);
+        if (entry == nullptr)
+        {
+            empty = index;
+            break;
+        }
+        if (*entry == text)
+        {
+            return entry;
+        }
+    }
+
+    if (const auto found = overflow_.find(text); found != overflow_.end())
+    {
+        return found->second;
+    }
+
+    const std::string& stored = storage_.emplace_back(text);
+
+    // Three quarters full is where open-addressing probes start getting long,
+    // and a long probe here is a long probe on every RX thread for every
+    // message. A recorder that has seen three thousand distinct strings is
+    // unusual enough to take the lock for the rest.
+    if (empty != kSlots && used_ < kSlots / 4 * 3)
+    {
+        ++used_;
+        slots_[empty].store(&stored, std::memory_order_release);
+    }
+    else
+    {
+        overflow_.emplace(stored, &stored);
+    }
+    return &stored;
+}
+
+// -------------------------------------------------------------------- RingQueue
+
+RingQueue::RingQueue(std::size_t capacity) :
+    slots_(std::bit_ceil(std::max<std::size_t>(capacity, 2))),
+    mask_(slots_.size() - 1)
+{
+    for (std::size_t i = 0; i < slots_.size(); ++i)
+    {
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool RingQueue::push(std::string_view key, std::string_view schema, std::string_view origin_zid,
+                     std::span<const std::uint8_t> payload, std::uint64_t log_time_ns,
+                     std::optional<std::uint64_t> publish_time_ns)
+{
+    const std::string* const interned_key = strings_.intern(key);
+    const std::string* const interned_schema = strings_.intern(schema);
+    const std::string* const interned_zid = strings_.intern(origin_zid);
+
+    bool lost = false;
+
+    // Two rounds of discarding at most. Each discard is a real, counted loss,
+    // and a producer that kept discarding while others raced it for the room
+    // would empty the ring rather than make a space in it.
+    for (int round = 0; round < 3; ++round)
+    {
+        std::size_t position = enqueue_.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Slot& slot = slots_[position & mask_];
+            const std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto lag =
+                static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+            if (lag == 0)
+            {
+                if (!enqueue_.compare_exchange_weak(position, position + 1,
+                                                    std::memory_order_relaxed))
+                {
+                    continue;  // Another producer took it; `position` is reloaded.
+                }
+
+                slot.key = interned_key;
+                slot.schema = interned_schema;
+                slot.origin_zid = interned_zid;
+                slot.payload.assign(payload.begin(), payload.end());
+                slot.log_time_ns = log_time_ns;
+                slot.publish_time_ns = publish_time_ns;
+
+                // Release: everything above is visible to the writer that sees
+                // this sequence.
+                slot.sequence.store(position + 1, std::memory_order_release);
+
+                signal_.fetch_add(1, std::memory_order_seq_cst);
+                if (sleeping_.load(std::memory_order_seq_cst))
+                {
+                    signal_.notify_one();
+                }
+                return !lost;
+            }
+
+            if (lag < 0)
+            {
+                break;  // Full: the slot still holds last lap's message.
+            }
+
+            // Another producer claimed this position first.
+            position = enqueue_.load(std::memory_order_relaxed);
+        }
+
+        if (round == 2)
+        {
+            break;
+        }
+
+        // Full. Take the oldest exactly as the writer would, and throw it away.
+        std::size_t oldest = 0;
+        Slot* const victim = claimOldest(oldest);
+        if (victim == nullptr)
+        {
+            break;  // Still being filled by another producer.
+        }
+        if (victim->payload.capacity() > kRetainedSlabBytes)
+        {
+            victim->payload = {};
+        }
+        release(*victim, oldest);
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        lost = true;
+    }
+
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+RingQueue::Slot* RingQueue::claimOldest(std::size_t& position)
+{
+    position = dequeue_.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        Slot& slot = slots_[position & mask_];
+        const std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        const auto lag =
+            static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+
+        if (lag == 0)
+        {
+            if (dequeue_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                return &slot;
+            }
+            continue;
+        }
+
+        if (lag < 0)
+        {
+            return nullptr;  // Empty, or the oldest is still being filled.
+        }
+
+        position = dequeue_.load(std::memory_order_relaxed);
+    }
+}
+
+void RingQueue::release(Slot& slot, std::size_t position)
+{
+    // One lap on: free for whichever producer reaches this position next time
+    // round.
+    slot.sequence.store(position + mask_ + 1, std::memory_order_release);
+}
+
+void RingQueue::stop()
+{
+    stopped_.store(true, std::memory_order_release);
+    signal_.fetch_add(1, std::memory_order_release);
+    signal_.notify_all();
+}
+
+std::size_t RingQueue::depth() const
+{
+    const std::size_t in = enqueue_.load(std::memory_order_relaxed);
+    const std::size_t out = dequeue_.load(std::memory_order_relaxed);
+    return in > out ? std::min(in - out, capacity()) : 0;
+}
+
+}  // namespace bag
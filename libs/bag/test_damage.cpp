@@ -17,6 +17,7 @@
 // path... bad-input handling is where the latent bugs still are."
 
 #include "bag/reader.h"
+#include "bag/validate.h"
 #include "bag/writer.h"
 
 #include <spdlog/spdlog.h>
@@ -154,6 +155,113 @@ void testTruncatedPart()
     expect(ordered, "what is recovered is still in order");
 }
 
+// The same tear through a cached reader. The torn part has no summary to map,
+// so it must take the same fallback scan as above rather than reading as empty.
+void testTruncatedPartCached()
+{
+    const TempDir dir("truncated_cached");
+    constexpr int kCount = 500;
+    writeThenTruncate(dir, kCount, 0.5, 4 * 1024);
+
+    bag::BagReader plain(dir.str());
+    bag::BagReader cached(dir.str(), bag::ReaderOptions{.cached = true});
+
+    const auto count = [](bag::BagReader& reader)
+    {
+        std::size_t seen = 0;
+        reader.forEach(
+            [&](const bag::BagMessage&)
+            {
+                ++seen;
+                return true;
+            });
+        return seen;
+    };
+
+    const std::size_t seen = count(cached);
+    expect(seen > 0 && seen == count(plain),
+           "a cached reader recovers what an uncached one does from a torn part (" +
+               std::to_string(seen) + ")");
+    expect(cached.cacheStats().parts_mapped == 0, "and does not pretend to have mapped it");
+}
+
+// A chunk whose uncompressed_size is garbage -- a flipped bit, or the tail of
+// another record where a torn write left one. The mapped reader sizes its
+// buffer from that field before the codec says a word, so unchecked it is an
+// allocation of whatever the file says. It must be refused as the one damaged
+// chunk it is, and the rest of the part still read.
+void testInflatedChunkSizeIsRefused()
+{
+    const TempDir dir("inflated");
+    constexpr int kCount = 500;
+    {
+        bag::WriterOptions options;
+        options.name = "inflated";
+        options.chunk_bytes = 4 * 1024;
+        bag::BagWriter writer(dir.str(), options);
+        for (int i = 0; i < kCount; ++i)
+        {
+            writer.write("vehicle/engine/rpm", "EngineRpm", payloadFor(i, 256),
+                         kBase + static_cast<std::uint64_t>(i) * 1'000'000ull, std::nullopt, "");
+        }
+        writer.close();
+    }
+
+    // Walk the records after the magic to the first Chunk, and overwrite its
+    // uncompressed_size: opcode (1), length (8), start and end times (16).
+    const std::filesystem::path part = dir.path() / "inflated_0000.mcap";
+    std::fstream file(part, std::ios::in | std::ios::out | std::ios::binary);
+    std::uint64_t at = 8;
+    bool found = false;
+    for (int records = 0; records < 64 && file; ++records)
+    {
+        std::uint8_t head[9] = {};
+        file.seekg(static_cast<std::streamoff>(at));
+        file.read(reinterpret_cast<char*>(head), sizeof(head));
+        if (head[0] == 0x06)
+        {
+            found = true;
+            break;
+        }
+        std::uint64_t length = 0;
+        for (int i = 0; i < 8; ++i)
+        {
+            length |= static_cast<std::uint64_t>(head[1 + i]) << (8 * i);
+        }
+        at += 9 + length;
+    }
+    expect(found, "the part has a Chunk record to damage");
+    if (!found)
+    {
+        return;
+    }
+    const std::uint64_t claimed = 1ull << 40;
+    char bytes[8];
+    for (int i = 0; i < 8; ++i)
+    {
+        bytes[i] = static_cast<char>(claimed >> (8 * i));
+    }
+    file.seekp(static_cast<std::streamoff>(at + 1 + 8 + 16));
+    file.write(bytes, sizeof(bytes));
+    file.close();
+
+    bag::BagReader cached(dir.str(), bag::ReaderOptions{.cached = true});
+    std::size_t seen = 0;
+    const bool completed = cached.forEach(
+        [&](const bag::BagMessage&)
+        {
+            ++seen;
+            return true;
+        });
+    expect(completed, "a cached read of a chunk claiming a terabyte returns");
+    expect(seen > 0 && seen < kCount, "skipping that chunk and reading the others (" +
+                                          std::to_string(seen) + " of " +
+                                          std::to_string(kCount) + ")");
+
+    expect(!bag::validateMcapFile(part.string()).ok(),
+           "and the validator reports it rather than allocating it");
+}
+
 // Truncated so hard there is nothing left but the header. The reader must cope
 // rather than treating "zero messages" as a reason to fail.
 void testSeverelyTruncatedPart()
@@ -309,6 +417,8 @@ int main()
     spdlog::set_level(spdlog::level::off);
 
     testTruncatedPart();
+    testTruncatedPartCached();
+    testInflatedChunkSizeIsRefused();
     testSeverelyTruncatedPart();
     testMissingPart();
     testGarbagePart();
@@ -0,0 +1,397 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//
+// What this tree writes, read back by mcap's own reader.
+//
+// The pipelined writer frames its chunks, message indexes and summary from the
+// spec rather than through mcap::McapWriter; MappedPart parses them from the
+// spec rather than through mcap::McapReader; and validate.cpp checks files
+// against the same spec, read by the same people. A misreading shared by any two
+// -- a field in the wrong order, an offset measured from the wrong byte -- would
+// pass every other test in this directory and fail in Foxglove Studio. Foxglove's
+// reader is the independent opinion, so this asks it.
+//
+// Each case checks that the summary parses WITHOUT the fallback scan, so a
+// summary mcap cannot use is a failure here rather than a silent rescan.
+//
+// No zenoh anywhere: this is file I/O against a temporary directory.
+
+#include "bag/mapped_part.h"
+#include "bag/reader.h"
+#include "bag/writer.h"
+
+#include <mcap/reader.hpp>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+int failures = 0;
+int checks = 0;
+
+void expect(bool condition, const std::string& what)
+{
+    ++checks;
+    if (!condition)
+    {
+        ++failures;
+        std::fprintf(stderr, "FAIL: %s\n", what.c_str());
+    }
+}
+
+class TempDir
+{
+  public:
+    explicit TempDir(const std::string& label)
+    {
+        path_ = std::filesystem::temp_directory_path() /
+                ("redline_bag_test_" + label + "_" + std::to_string(::getpid()));
+        std::filesystem::remove_all(path_);
+        std::filesystem::create_directories(path_);
+    }
+
+    ~TempDir()
+    {
+        std::error_code error;
+        std::filesystem::remove_all(path_, error);
+    }
+
+    std::string str() const { return path_.string(); }
+
+  private:
+    std::filesystem::path path_;
+};
+
+std::vector<std::uint8_t> payloadFor(int index, std::size_t size)
+{
+    std::vector<std::uint8_t> payload(size);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        payload[i] = static_cast<std::uint8_t>((index * 31 + static_cast<int>(i) * 7) & 0xFF);
+    }
+    return payload;
+}
+
+constexpr std::uint64_t kBase = 1'785'000'000'000'000'000ull;
+constexpr int kMessages = 1500;
+
+// Three topics, uneven payloads and some unstamped messages, rolled into
+// several parts. The same input every time, so two recordings of it can be
+// compared message by message.
+void record(const std::string& directory, const std::string& codec, unsigned threads)
+{
+    bag::WriterOptions options;
+    options.name = "interop";
+    options.compression = codec;
+    options.chunk_bytes = 8 * 1024;
+    options.max_part_bytes = codec == "none" ? 64 * 1024 : 8 * 1024;
+    options.compression_threads = threads;
+
+    bag::BagWriter writer(directory, options);
+    const char* keys[] = {"vehicle/engine/rpm", "vehicle/speed_mps", "vehicle/gear"};
+    const char* schemas[] = {"EngineRpm", "VehicleSpeed", "Gear"};
+    for (int i = 0; i < kMessages; ++i)
+    {
+        const std::uint64_t t = kBase + static_cast<std::uint64_t>(i) * 1'000'000ull;
+        writer.write(keys[i % 3], schemas[i % 3], payloadFor(i, 64 + (i % 11) * 40), t,
+                     i % 5 == 0 ? std::nullopt : std::optional<std::uint64_t>(t - 1000),
+                     "abc123");
+    }
+    writer.close();
+}
+
+struct McapMessage
+{
+    std::uint16_t channel_id = 0;
+    std::string topic;
+    std::string schema;
+    std::uint64_t log_time_ns = 0;
+    std::uint64_t publish_time_ns = 0;
+    std::vector<std::byte> payload;
+
+    bool operator==(const McapMessage&) const = default;
+};
+
+// One part as mcap sees it.
+struct McapPart
+{
+    bool opened = false;
+    bool summary_ok = false;
+    std::size_t problems = 0;
+    std::optional<mcap::Statistics> statistics;
+    std::size_t chunks = 0;
+    std::size_t indexed_chunks = 0;
+    std::vector<std::string> codecs;
+    std::vector<McapMessage> messages;
+
+    // By start time, then offset: MappedPart::chunks()' order.
+    std::vector<mcap::ChunkIndex> chunk_indexes;
+
+    // Channel id -> topic, and the registry name from its metadata.
+    std::map<std::uint16_t, std::pair<std::string, std::string>> channels;
+};
+
+std::string registryName(const mcap::Channel& channel)
+{
+    const auto found = channel.metadata.find("redline/schema");
+    return found == channel.metadata.end() ? std::string() : found->second;
+}
+
+McapPart readWithMcap(const std::string& path)
+{
+    McapPart part;
+    mcap::McapReader reader;
+    if (!reader.open(path).ok())
+    {
+        return part;
+    }
+    part.opened = true;
+
+    const auto onProblem = [&](const mcap::Status& problem)
+    {
+        ++part.problems;
+        std::fprintf(stderr, "  %s: %s\n", path.c_str(), problem.message.c_str());
+    };
+
+    part.summary_ok =
+        reader.readSummary(mcap::ReadSummaryMethod::NoFallbackScan, onProblem).ok();
+    part.statistics = reader.statistics();
+    for (const mcap::ChunkIndex& chunk : reader.chunkIndexes())
+    {
+        ++part.chunks;
+        part.indexed_chunks += chunk.messageIndexOffsets.empty() ? 0 : 1;
+        part.codecs.push_back(chunk.compression);
+        part.chunk_indexes.push_back(chunk);
+    }
+    std::sort(part.chunk_indexes.begin(), part.chunk_indexes.end(),
+              [](const mcap::ChunkIndex& lhs, const mcap::ChunkIndex& rhs)
+              {
+                  return lhs.messageStartTime != rhs.messageStartTime
+                             ? lhs.messageStartTime < rhs.messageStartTime
+                             : lhs.chunkStartOffset < rhs.chunkStartOffset;
+              });
+    for (const auto& [id, channel] : reader.channels())
+    {
+        part.channels[id] = {channel->topic, registryName(*channel)};
+    }
+
+    // In log-time order, which mcap can only do from the message indexes: a
+    // part whose indexes it could not follow yields nothing at all here.
+    mcap::ReadMessageOptions options;
+    options.readOrder = mcap::ReadMessageOptions::ReadOrder::LogTimeOrder;
+    for (const mcap::MessageView& view : reader.readMessages(onProblem, options))
+    {
+        McapMessage message;
+        message.channel_id = view.message.channelId;
+        message.topic = view.channel->topic;
+        message.schema = registryName(*view.channel);
+        message.log_time_ns = view.message.logTime;
+        message.publish_time_ns = view.message.publishTime;
+        message.payload.assign(view.message.data, view.message.data + view.message.dataSize);
+        part.messages.push_back(std::move(message));
+    }
+    reader.close();
+    return part;
+}
+
+// ------------------------------------------------- the pipelined writer's parts
+
+// Every part the pipelined writer produces, opened by mcap: a summary it reads
+// without scanning, statistics that agree with the chunks and with metadata.yaml,
+// and a message index for every chunk. Then all of the parts in order against
+// the parts mcap's own writer made from the same input: the same messages, in
+// the same order, with the same bytes. Compared across the whole recording
+// rather than part by part, because the two writers are allowed to roll at
+// slightly different places.
+void testPipelinedPartsReadByMcap(const std::string& codec)
+{
+    const TempDir inline_dir("interop_inline_" + codec);
+    const TempDir pipelined_dir("interop_pipelined_" + codec);
+    record(inline_dir.str(), codec, 0);
+    record(pipelined_dir.str(), codec, 3);
+
+    const auto readAll = [&](const TempDir& dir, bool check)
+    {
+        std::vector<McapMessage> all;
+        const bag::BagReader bag(dir.str());
+        const auto& parts = bag.metadata().parts;
+        if (check)
+        {
+            expect(parts.size() > 1, codec + ": the pipelined recording rolls (" +
+                                         std::to_string(parts.size()) + " parts)");
+        }
+        for (std::size_t i = 0; i < parts.size(); ++i)
+        {
+            McapPart part =
+                readWithMcap((std::filesystem::path(dir.str()) / parts[i].path).string());
+            if (check)
+            {
+                const std::string label = codec + " part " + std::to_string(i);
+                expect(part.opened, label + ": mcap opens it");
+                expect(part.summary_ok && part.problems == 0,
+                       label + ": mcap reads its summary without a fallback scan, and "
+                               "reports nothing");
+                expect(part.statistics.has_value() &&
+                           part.statistics->messageCount == parts[i].message_count &&
+                           part.statistics->messageCount == part.messages.size() &&
+                           part.statistics->chunkCount == part.chunks,
+                       label + ": its Statistics count its messages and its chunks");
+                expect(part.chunks > 0 && part.indexed_chunks == part.chunks,
+                       label + ": every chunk has a ChunkIndex with message indexes");
+
+                bool codecs_named = true;
+                for (const std::string& name : part.codecs)
+                {
+                    codecs_named =
+                        codecs_named && (name.empty() || (codec != "none" && name == codec));
+                }
+                expect(codecs_named, label + ": every chunk names its codec as mcap spells it");
+            }
+            all.insert(all.end(), std::make_move_iterator(part.messages.begin()),
+                       std::make_move_iterator(part.messages.end()));
+        }
+        return all;
+    };
+
+    const std::vector<McapMessage> want = readAll(inline_dir, false);
+    const std::vector<McapMessage> got = readAll(pipelined_dir, true);
+    expect(want.size() == kMessages, codec + ": mcap reads the inline recording whole");
+    expect(got == want, codec + ": and reads the pipelined one identically (" +
+                            std::to_string(got.size()) + " vs " + std::to_string(want.size()) +
+                            " messages)");
+}
+
+// ------------------------------------------------------ MappedPart against mcap
+
+// The cached reader's parse of a part against mcap's, record for record: the
+// same channels under the same ids, the same chunks at the same offsets with
+// the same sizes, and every chunk decoded to the same messages with the same
+// bytes. Over parts from both writers and every codec, so a record only one of
+// them emits is covered.
+void testMappedPartMatchesMcap(const std::string& codec, unsigned threads)
+{
+    const std::string label = codec + (threads == 0 ? " inline" : " pipelined");
+    const TempDir dir("interop_mapped_" + codec + "_" + std::to_string(threads));
+    record(dir.str(), codec, threads);
+
+    const bag::BagReader bag(dir.str());
+    std::size_t parts_compared = 0;
+    std::size_t messages_compared = 0;
+    for (const bag::bag_part_t& entry : bag.metadata().parts)
+    {
+        const std::string path = (std::filesystem::path(dir.str()) / entry.path).string();
+        const std::string part_label = label + " " + entry.path;
+
+        const McapPart want = readWithMcap(path);
+        std::string why;
+        const std::unique_ptr<bag::MappedPart> mapped = bag::MappedPart::open(path, why);
+        expect(mapped != nullptr, part_label + ": MappedPart opens it (" + why + ")");
+        if (mapped == nullptr || !want.summary_ok)
+        {
+            continue;
+        }
+
+        bool channels_agree = mapped->channels().size() == want.channels.size();
+        for (const auto& [id, channel] : mapped->channels())
+        {
+            const auto found = want.channels.find(id);
+            channels_agree = channels_agree && found != want.channels.end() &&
+                             found->second.first == channel.topic &&
+                             found->second.second == channel.schema;
+        }
+        expect(channels_agree, part_label + ": the same channels under the same ids");
+
+        const std::vector<bag::MappedPart::ChunkRef>& chunks = mapped->chunks();
+        bool chunks_agree = chunks.size() == want.chunk_indexes.size();
+        for (std::size_t i = 0; chunks_agree && i < chunks.size(); ++i)
+        {
+            const mcap::ChunkIndex& index = want.chunk_indexes[i];
+            chunks_agree = chunks[i].start_ns == index.messageStartTime &&
+                           chunks[i].end_ns == index.messageEndTime &&
+                           chunks[i].offset == index.chunkStartOffset &&
+                           chunks[i].length == index.chunkLength &&
+                           chunks[i].uncompressed_size == index.uncompressedSize &&
+                           chunks[i].message_indexes.size() == index.messageIndexOffsets.size();
+            for (const auto& [channel, offset] : chunks[i].message_indexes)
+            {
+                const auto found = index.messageIndexOffsets.find(channel);
+                chunks_agree = chunks_agree && found != index.messageIndexOffsets.end() &&
+                               found->second == offset;
+            }
+        }
+        expect(chunks_agree, part_label + ": the same chunks, offsets, sizes and message "
+                                          "index offsets (" +
+                                 std::to_string(chunks.size()) + " vs " +
+                                 std::to_string(want.chunk_indexes.size()) + ")");
+
+        // Every input message has its own log_time, so chunk order then
+        // log_time order within each is the order mcap merges them in.
+        std::vector<McapMessage> got;
+        bool decoded = true;
+        for (const bag::MappedPart::ChunkRef& chunk : chunks)
+        {
+            std::string error;
+            const std::shared_ptr<const bag::DecodedChunk> decoded_chunk =
+                mapped->decode(chunk, error);
+            if (decoded_chunk == nullptr)
+            {
+                std::fprintf(stderr, "  %s: %s\n", path.c_str(), error.c_str());
+                decoded = false;
+                continue;
+            }
+            for (const bag::DecodedChunk::Message& message : decoded_chunk->messages)
+            {
+                const bag::MappedPart::Channel* channel = mapped->channel(message.channel_id);
+                const auto bytes = decoded_chunk->bytes.subspan(message.offset, message.size);
+                McapMessage out;
+                out.channel_id = message.channel_id;
+                out.topic = channel != nullptr ? channel->topic : std::string();
+                out.schema = channel != nullptr ? channel->schema : std::string();
+                out.log_time_ns = message.log_time_ns;
+                out.publish_time_ns = message.publish_time_ns;
+                out.payload.assign(reinterpret_cast<const std::byte*>(bytes.data()),
+                                   reinterpret_cast<const std::byte*>(bytes.data() + bytes.size()));
+                got.push_back(std::move(out));
+            }
+        }
+        expect(decoded, part_label + ": every chunk decodes");
+        expect(got == want.messages,
+               part_label + ": every message matches mcap's, bytes and all (" +
+                   std::to_string(got.size()) + " vs " + std::to_string(want.messages.size()) +
+                   ")");
+
+        ++parts_compared;
+        messages_compared += got.size();
+    }
+    expect(parts_compared > 1 && messages_compared == kMessages,
+           label + ": every part was compared (" + std::to_string(parts_compared) + " parts, " +
+               std::to_string(messages_compared) + " messages)");
+}
+
+}  // namespace
+
+int main()
+{
+    testPipelinedPartsReadByMcap("zstd");
+    testPipelinedPartsReadByMcap("lz4");
+    testPipelinedPartsReadByMcap("none");
+
+    for (const char* codec : {"zstd", "lz4", "none"})
+    {
+        testMappedPartMatchesMcap(codec, 0);
+        testMappedPartMatchesMcap(codec, 3);
+    }
+
+    std::fprintf(stderr, "%d checks, %d failures\n", checks, failures);
+    return failures == 0 ? 0 : 1;
+}
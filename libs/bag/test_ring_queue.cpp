@@ -0,0 +1,402 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//
+// The lock-free recording queue, held to MessageQueue's contract.
+//
+// Everything test_queue.cpp pins for the locked queue is pinned here too --
+// FIFO, oldest-first dropping with an exact count, a stop that drains -- because
+// `bag record --lock-free-queue` swaps one for the other and a recording must
+// not be able to tell which it went through.
+//
+// Plus the case the lock-free queue exists for: many RX threads at once. The
+// stress case runs sixteen producers into a small ring against a writer that
+// keeps up only some of the time, and checks the one property a lossy queue
+// must never lose -- every message pushed is either written or counted as
+// dropped, exactly once, in order per producer, with its bytes intact. It also
+// reports the throughput both queues reach on this machine. Those numbers are
+// printed, not asserted: a loaded CI host would make any threshold flaky.
+
+#include "bag/queue.h"
+#include "bag/ring_queue.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+int failures = 0;
+int checks = 0;
+
+void expect(bool condition, const std::string& what)
+{
+    ++checks;
+    if (!condition)
+    {
+        ++failures;
+        std::fprintf(stderr, "FAIL: %s\n", what.c_str());
+    }
+}
+
+// A payload that says who sent it and in what order, so the writer can check
+// both without trusting anything but the bytes.
+std::vector<std::uint8_t> payloadFor(std::uint32_t producer, std::uint32_t sequence,
+                                     std::size_t size)
+{
+    std::vector<std::uint8_t> payload(std::max<std::size_t>(size, 8));
+    std::memcpy(payload.data(), &producer, 4);
+    std::memcpy(payload.data() + 4, &sequence, 4);
+    for (std::size_t i = 8; i < payload.size(); ++i)
+    {
+        payload[i] = static_cast<std::uint8_t>(producer + sequence + i);
+    }
+    return payload;
+}
+
+bool pushIndex(bag::RingQueue& queue, int index)
+{
+    const std::vector<std::uint8_t> payload(8, static_cast<std::uint8_t>(index & 0xFF));
+    return queue.push("vehicle/engine/rpm", "EngineRpm", "zid", payload,
+                      static_cast<std::uint64_t>(index), std::nullopt);
+}
+
+// ------------------------------------------------------------------ the cases
+
+void testFifoOrder()
+{
+    bag::RingQueue queue(100);
+    expect(queue.capacity() == 128, "capacity rounds up to a power of two");
+
+    for (int i = 0; i < 10; ++i)
+    {
+        expect(pushIndex(queue, i), "push " + std::to_string(i) + " did not drop");
+    }
+
+    bool ordered = true;
+    for (int i = 0; i < 10; ++i)
+    {
+        std::uint64_t seen = ~0ull;
+        const bool got = queue.pop([&](const bag::RingMessage& message)
+                                   { seen = message.log_time_ns; });
+        ordered = ordered && got && seen == static_cast<std::uint64_t>(i);
+    }
+    expect(ordered, "messages come out in the order they went in");
+    expect(queue.dropped() == 0, "nothing was dropped");
+    expect(queue.depth() == 0, "the queue is empty afterwards");
+}
+
+// Over capacity with no writer: the oldest go, the newest stay, and every one
+// that went is counted.
+void testDropsTheOldestAndCounts()
+{
+    bag::RingQueue queue(4);
+
+    int refused = 0;
+    for (int i = 0; i < 10; ++i)
+    {
+        if (!pushIndex(queue, i))
+        {
+            ++refused;
+        }
+    }
+
+    expect(queue.dropped() == 6, "six of ten were dropped (" +
+                                     std::to_string(queue.dropped()) + ")");
+    expect(refused == 6, "and each push that cost a message said so");
+    expect(queue.depth() == 4, "the ring stays at its bound");
+
+    queue.stop();
+    std::vector<std::uint64_t> kept;
+    while (queue.pop([&](const bag::RingMessage& message) { kept.push_back(message.log_time_ns); }))
+    {
+    }
+    expect(kept == std::vector<std::uint64_t>{6, 7, 8, 9},
+           "the NEWEST survive -- a recorder that falls behind keeps what explains now");
+}
+
+void testStopDrainsBeforeEnding()
+{
+    bag::RingQueue queue(64);
+    for (int i = 0; i < 20; ++i)
+    {
+        pushIndex(queue, i);
+    }
+    queue.stop();
+
+    int drained = 0;
+    while (queue.pop([](const bag::RingMessage&) {}))
+    {
+        ++drained;
+    }
+    expect(drained == 20, "everything queued before stop() is still written (" +
+                              std::to_string(drained) + ")");
+}
+
+void testStopWakesAnIdleWriter()
+{
+    bag::RingQueue queue(16);
+    std::atomic<bool> returned{false};
+    std::thread writer(
+        [&]
+        {
+            while (queue.pop([](const bag::RingMessage&) {}))
+            {
+            }
+            returned = true;
+        });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    queue.stop();
+    writer.join();
+    expect(returned, "a writer blocked on an empty queue returns once stopped");
+}
+
+void testStringsAreInternedAndPayloadsIntact()
+{
+    bag::RingQueue queue(16);
+    const std::vector<std::uint8_t> big = payloadFor(1, 2, 200 * 1024);
+
+    queue.push(std::string("vehicle/speed"), std::string("VehicleSpeed"), std::string("abc"), big,
+               1, 77);
+    queue.push(std::string("vehicle/speed"), std::string("VehicleSpeed"), std::string("abc"),
+               payloadFor(1, 3, 16), 2, std::nullopt);
+    queue.stop();
+
+    std::vector<const char*> keys;
+    bool intact = true;
+    while (queue.pop(
+        [&](const bag::RingMessage& message)
+        {
+            keys.push_back(message.key.data());
+            intact = intact && message.key == "vehicle/speed" && message.schema == "VehicleSpeed" &&
+                     message.origin_zid == "abc";
+            if (message.log_time_ns == 1)
+            {
+                intact = intact && std::equal(message.payload.begin(), message.payload.end(),
+                                              big.begin(), big.end()) &&
+                         message.publish_time_ns == 77u;
+            }
+            else
+            {
+                intact = intact && message.payload.size() == 16 && !message.publish_time_ns;
+            }
+        }))
+    {
+    }
+
+    expect(intact, "key, schema, origin, times and payload arrive as pushed, large or small");
+    expect(keys.size() == 2 && keys[0] == keys[1],
+           "the same key from two different strings is one interned copy");
+}
+
+// ------------------------------------------------------------------- the stress
+
+struct StressResult
+{
+    std::uint64_t written = 0;
+    std::uint64_t dropped = 0;
+    double seconds = 0.0;
+    bool consistent = true;
+};
+
+constexpr std::uint32_t kProducers = 16;
+constexpr std::uint32_t kPerProducer = 40000;
+
+// Payload sizes cycle through what a loaded bus carries: CAN frames, then the
+// occasional video frame.
+std::size_t sizeFor(std::uint32_t sequence)
+{
+    return sequence % 97 == 0 ? 20 * 1024 : 24 + (sequence % 5) * 8;
+}
+
+// What both writers do with each message, so the two queues are timed against
+// the same work: decode who sent it, and check it arrived whole, on the right
+// key, and after that producer's previous one. Per-producer order is the only
+// order a multi-producer queue promises.
+class Checker
+{
+  public:
+    explicit Checker(StressResult& result) : result_(result) {}
+
+    void operator()(std::string_view key, std::span<const std::uint8_t> payload)
+    {
+        ++result_.written;
+        std::uint32_t producer = 0;
+        std::uint32_t sequence = 0;
+        if (payload.size() < 8)
+        {
+            result_.consistent = false;
+            return;
+        }
+        std::memcpy(&producer, payload.data(), 4);
+        std::memcpy(&sequence, payload.data() + 4, 4);
+        if (producer >= kProducers || payload.size() != sizeFor(sequence) ||
+            static_cast<std::int64_t>(sequence) <= last_[producer] ||
+            payload.back() != static_cast<std::uint8_t>(producer + sequence + payload.size() - 1) ||
+            key != keys_[producer % 4])
+        {
+            result_.consistent = false;
+        }
+        last_[producer] = sequence;
+    }
+
+  private:
+    StressResult& result_;
+    std::vector<std::int64_t> last_ = std::vector<std::int64_t>(kProducers, -1);
+    const std::string keys_[4] = {"bus/0", "bus/1", "bus/2", "bus/3"};
+};
+
+StressResult stressRing(std::size_t capacity)
+{
+    bag::RingQueue queue(capacity);
+    StressResult result;
+    Checker check(result);
+
+    const auto started = std::chrono::steady_clock::now();
+    std::thread writer(
+        [&]
+        {
+            while (queue.pop([&](const bag::RingMessage& message)
+                             { check(message.key, message.payload); }))
+            {
+            }
+        });
+
+    std::vector<std::thread> producers;
+    for (std::uint32_t p = 0; p < kProducers; ++p)
+    {
+        producers.emplace_back(
+            [&queue, p]
+            {
+                const std::string key = "bus/" + std::to_string(p % 4);
+                for (std::uint32_t s = 0; s < kPerProducer; ++s)
+                {
+                    const std::vector<std::uint8_t> payload = payloadFor(p, s, sizeFor(s));
+                    queue.push(key, "CanFrame", "zid", payload, s, std::nullopt);
+                }
+            });
+    }
+    for (std::thread& producer : producers)
+    {
+        producer.join();
+    }
+    queue.stop();
+    writer.join();
+
+    result.seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    result.dropped = queue.dropped();
+    return result;
+}
+
+StressResult stressLocked(std::size_t capacity)
+{
+    bag::MessageQueue queue(capacity);
+    StressResult result;
+    Checker check(result);
+
+    const auto started = std::chrono::steady_clock::now();
+    std::thread writer(
+        [&]
+        {
+            while (const auto message = queue.pop())
+            {
+                check(message->key, message->payload);
+            }
+        });
+
+    std::vector<std::thread> producers;
+    for (std::uint32_t p = 0; p < kProducers; ++p)
+    {
+        producers.emplace_back(
+            [&queue, p]
+            {
+                const std::string key = "bus/" + std::to_string(p % 4);
+                for (std::uint32_t s = 0; s < kPerProducer; ++s)
+                {
+                    // Built the way record.cpp builds one: three strings and a
+                    // payload copy per message.
+                    const std::vector<std::uint8_t> payload = payloadFor(p, s, sizeFor(s));
+                    bag::QueuedMessage message;
+                    message.key = key;
+                    message.schema = "CanFrame";
+                    message.origin_zid = "zid";
+                    message.payload.assign(payload.begin(), payload.end());
+                    message.log_time_ns = s;
+                    queue.push(std::move(message));
+                }
+            });
+    }
+    for (std::thread& producer : producers)
+    {
+        producer.join();
+    }
+    queue.stop();
+    writer.join();
+
+    result.seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    result.dropped = queue.dropped();
+    return result;
+}
+
+void testManyProducersLoseNothingUncounted()
+{
+    constexpr std::uint64_t kTotal = std::uint64_t{kProducers} * kPerProducer;
+
+    // Small enough that it overflows while sixteen threads hammer it.
+    const StressResult ring = stressRing(1024);
+    expect(ring.consistent,
+           "under contention every written message is intact, on its own key, and in order for "
+           "its producer");
+    expect(ring.written + ring.dropped == kTotal,
+           "written + dropped == pushed, exactly (" + std::to_string(ring.written) + " + " +
+               std::to_string(ring.dropped) + " vs " + std::to_string(kTotal) + ")");
+
+    // Big enough that nothing need be lost.
+    const StressResult roomy = stressRing(1 << 20);
+    expect(roomy.written == kTotal && roomy.dropped == 0,
+           "a ring big enough for the whole run loses nothing");
+
+    const StressResult locked = stressLocked(1024);
+    expect(locked.consistent && locked.written + locked.dropped == kTotal,
+           "the locked queue balances its books too -- the comparison is like for like");
+
+    const auto report = [](const char* name, const StressResult& r)
+    {
+        std::fprintf(stderr, "  %-22s %8.0f msgs/s written, %7llu dropped (%.1f%%)\n", name,
+                     static_cast<double>(r.written) / r.seconds,
+                     static_cast<unsigned long long>(r.dropped),
+                     100.0 * static_cast<double>(r.dropped) / static_cast<double>(kTotal));
+    };
+    std::fprintf(stderr, "%u producers x %u messages:\n", kProducers, kPerProducer);
+    report("RingQueue, 1024 slots", ring);
+    report("MessageQueue, 1024", locked);
+}
+
+}  // namespace
+
+int main()
+{
+    spdlog::set_level(spdlog::level::warn);
+
+    testFifoOrder();
+    testDropsTheOldestAndCounts();
+    testStopDrainsBeforeEnding();
+    testStopWakesAnIdleWriter();
+    testStringsAreInternedAndPayloadsIntact();
+
+    testManyProducersLoseNothingUncounted();
+
+    std::fprintf(stderr, "%d checks, %d failures\n", checks, failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -20,6 +20,7 @@
 //
 // No zenoh anywhere: this is file I/O against a temporary directory.
 
+#include "bag/pipelined_writer.h"
 #include "bag/reader.h"
 #include "bag/validate.h"
 #include "bag/writer.h"
@@ -30,6 +31,8 @@
 
 #include <cstdio>
 #include <filesystem>
+#include <limits>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -317,6 +320,339 @@ void testSplitting()
     expect(contents_match, "no message is altered or duplicated at a seam");
 }
 
+// The pipelined writer against mcap's, on the same input: the same messages in
+// the same order, the same parts and the same index. Compression moving to
+// other threads must not be visible anywhere a reader looks -- including a
+// windowed read, which goes through the chunk indexes it built.
+void testPipelinedMatchesInline()
+{
+    struct Written
+    {
+        std::string key;
+        std::uint64_t log_time_ns = 0;
+        std::uint64_t publish_time_ns = 0;
+        std::vector<std::uint8_t> payload;
+
+        bool operator==(const Written&) const = default;
+    };
+
+    const auto record = [](const TempDir& dir, unsigned threads, bag::WriterStageStats& stats)
+    {
+        bag::WriterOptions options;
+        options.name = "same";
+        options.compression = "zstd";
+        options.chunk_bytes = 8 * 1024;
+        // zstd takes this to ~30 KB, so several parts either way.
+        options.max_part_bytes = 8 * 1024;
+        options.compression_threads = threads;
+
+        bag::BagWriter writer(dir.str(), options);
+        const char* keys[] = {"vehicle/engine/rpm", "vehicle/speed_mps", "vehicle/gear"};
+        const char* schemas[] = {"EngineRpm", "VehicleSpeed", "Gear"};
+        for (int i = 0; i < 1500; ++i)
+        {
+            const std::uint64_t t = kBase + static_cast<std::uint64_t>(i) * 1'000'000ull;
+            writer.write(keys[i % 3], schemas[i % 3], payloadFor(i, 64 + (i % 11) * 40), t,
+                         i % 5 == 0 ? std::nullopt : std::optional<std::uint64_t>(t - 1000),
+                         "abc123");
+        }
+        writer.close();
+        stats = writer.stageStats();
+    };
+
+    const auto readBack = [](const TempDir& dir, std::uint64_t start_ns, std::uint64_t end_ns)
+    {
+        std::vector<Written> out;
+        bag::BagReader reader(dir.str());
+        reader.forEach(start_ns, end_ns,
+                       [&](const bag::BagMessage& message)
+                       {
+                           out.push_back({std::string(message.key), message.log_time_ns,
+                                          message.publish_time_ns,
+                                          {message.payload.begin(), message.payload.end()}});
+                           return true;
+                       });
+        return out;
+    };
+
+    const TempDir inline_dir("inline");
+    const TempDir pipelined_dir("pipelined");
+    bag::WriterStageStats inline_stats;
+    bag::WriterStageStats pipelined_stats;
+    record(inline_dir, 0, inline_stats);
+    record(pipelined_dir, 3, pipelined_stats);
+
+    const std::uint64_t all_end = std::numeric_limits<std::uint64_t>::max();
+    const std::vector<Written> expected = readBack(inline_dir, 0, all_end);
+    const std::vector<Written> got = readBack(pipelined_dir, 0, all_end);
+    expect(expected.size() == 1500, "the inline recording reads back whole");
+    expect(got == expected, "the pipelined recording reads back identical to the inline one");
+
+    const std::uint64_t from = kBase + 700'000'000ull;
+    const std::uint64_t to = kBase + 900'000'000ull;
+    expect(readBack(pipelined_dir, from, to) == readBack(inline_dir, from, to),
+           "and so does a window out of the middle of it");
+
+    bag::BagReader inline_reader(inline_dir.str());
+    bag::BagReader pipelined_reader(pipelined_dir.str());
+    const bag::bag_metadata_t& a = inline_reader.metadata();
+    const bag::bag_metadata_t& b = pipelined_reader.metadata();
+    expect(a.message_count == b.message_count && a.unstamped_messages == b.unstamped_messages &&
+               a.t_begin_ns == b.t_begin_ns && a.t_end_ns == b.t_end_ns,
+           "metadata.yaml counts and times agree");
+    expect(a.topics.size() == b.topics.size(), "and it lists the same topics");
+
+    bool parts_agree = a.parts.size() > 1;
+    for (std::size_t i = 0; parts_agree && i < a.parts.size() && i < b.parts.size(); ++i)
+    {
+        parts_agree = b.parts[i].complete && a.parts[i].path == b.parts[i].path &&
+                      b.parts[i].message_count > 0;
+    }
+    expect(parts_agree, "the pipelined recording rolls into complete, non-empty parts (" +
+                            std::to_string(b.parts.size()) + " vs " +
+                            std::to_string(a.parts.size()) + ")");
+
+    const bag::ValidationReport report = bag::validateBag(pipelined_dir.str());
+    expect(report.ok(), "and it validates against the spec");
+
+    expect(pipelined_stats.chunks == report.chunks && pipelined_stats.uncompressed_bytes > 0 &&
+               pipelined_stats.compressed_bytes < pipelined_stats.uncompressed_bytes,
+           "stage stats count every chunk the file holds, and the bytes shrank");
+    expect(inline_stats.chunks == 0, "the inline writer reports no stage stats");
+}
+
+// What the pipelined writer reports for rolling: never less than what has been
+// handed to it. A part's file only grows when a chunk reaches the appending
+// thread, so rolling on it ignores the open chunk and every sealed one still in
+// the pipeline -- with a deep pipeline, many chunks past max_part_bytes. Raw
+// chunks, so the projection is not an estimate and can be held to the byte.
+void testPipelinedSizeCountsChunksInFlight()
+{
+    const TempDir dir("projected");
+    const std::string path = dir.str() + "/projected.mcap";
+
+    bag::StageCounters counters;
+    bag::PipelinedMcapWriter writer(counters);
+    bag::PipelinedMcapWriter::Options options;
+    options.compression = "none";
+    options.chunk_bytes = 4 * 1024;
+    options.threads = 2;
+    options.chunks_in_flight = 32;
+    expect(writer.open(path, options), "the pipelined writer opens");
+
+    const std::uint16_t schema = writer.addSchema("EngineRpm", "capnproto", {});
+    const std::uint16_t channel = writer.addChannel("vehicle/engine/rpm", "capnproto", schema, {});
+
+    // Every Message record is its opcode and length (9 bytes), channel id (2),
+    // sequence (4), two times (16), then the payload.
+    constexpr std::uint64_t kFraming = 9 + 2 + 4 + 8 + 8;
+    std::uint64_t handed = 0;
+    std::uint64_t projected = 0;
+    bool never_behind = true;
+    for (int i = 0; i < 600; ++i)
+    {
+        const std::vector<std::uint8_t> payload = payloadFor(i, 200);
+        const std::uint64_t t = kBase + static_cast<std::uint64_t>(i) * 1'000'000ull;
+        writer.write(channel, t, t, payload);
+        handed += kFraming + payload.size();
+        projected = writer.projectedBytes();
+        never_behind = never_behind && projected >= handed;
+    }
+    expect(never_behind, "the projected size covers every message written, landed or not");
+
+    expect(writer.close(), "the pipelined writer closes");
+    std::error_code error;
+    const std::uintmax_t size = std::filesystem::file_size(path, error);
+    expect(!error && size >= projected,
+           "and the finished part is no smaller than projected (" + std::to_string(size) +
+               " vs " + std::to_string(projected) + ")");
+}
+
+// The cached reader against the uncached one, on a recording whose channels are
+// stamped out of step so that chunks overlap in time -- the case where merging
+// by log_time is not the same as reading chunk after chunk. Then the cache
+// itself: a window read twice decompresses nothing the second time, and a
+// budget smaller than the window still reads it whole.
+void testCachedReaderMatches()
+{
+    struct Read
+    {
+        std::string key;
+        std::string schema;
+        std::uint64_t log_time_ns = 0;
+        std::vector<std::uint8_t> payload;
+
+        bool operator==(const Read&) const = default;
+    };
+
+    const TempDir dir("cached");
+    {
+        bag::WriterOptions options;
+        options.name = "cached";
+        options.chunk_bytes = 4 * 1024;
+        options.max_part_bytes = 64 * 1024;
+        bag::BagWriter writer(dir.str(), options);
+        for (int i = 0; i < 3000; ++i)
+        {
+            // The speed arrives three milliseconds behind the rpm, and every
+            // seventh pair shares a stamp.
+            const std::uint64_t t = kBase + static_cast<std::uint64_t>(i) * 1'000'000ull;
+            if (i % 2 == 0)
+            {
+                writer.write("vehicle/engine/rpm", "EngineRpm", payloadFor(i, 100), t,
+                             std::nullopt, "");
+            }
+            else
+            {
+                writer.write("vehicle/speed_mps", "VehicleSpeed", payloadFor(i, 60),
+                             i % 7 == 0 ? t - 1'000'000ull : t - 3'000'000ull, std::nullopt, "");
+            }
+        }
+        writer.close();
+    }
+
+    const auto readBack = [](bag::BagReader& reader, std::uint64_t start_ns, std::uint64_t end_ns)
+    {
+        std::vector<Read> out;
+        reader.forEach(start_ns, end_ns,
+                       [&](const bag::BagMessage& message)
+                       {
+                           out.push_back({std::string(message.key), std::string(message.schema),
+                                          message.log_time_ns,
+                                          {message.payload.begin(), message.payload.end()}});
+                           return true;
+                       });
+        return out;
+    };
+
+    bag::BagReader plain(dir.str());
+    bag::BagReader cached(dir.str(), bag::ReaderOptions{.cached = true});
+    expect(plain.metadata().parts.size() > 1, "the recording rolled into several parts");
+
+    const std::uint64_t all_end = std::numeric_limits<std::uint64_t>::max();
+    const std::vector<Read> everything = readBack(plain, 0, all_end);
+    expect(everything.size() == 3000, "the uncached reader reads the whole recording");
+    expect(readBack(cached, 0, all_end) == everything,
+           "the cached reader reads it identically, order included");
+
+    bool windows_agree = true;
+    for (std::uint64_t from = kBase; from < kBase + 3'000'000'000ull; from += 370'000'000ull)
+    {
+        const std::uint64_t to = from + 45'000'000ull;
+        windows_agree = windows_agree && readBack(cached, from, to) == readBack(plain, from, to);
+    }
+    expect(windows_agree, "and so does every window, each bound closed");
+
+    const bag::ReaderCacheStats first = cached.cacheStats();
+    expect(first.parts_mapped == plain.metadata().parts.size() && first.chunk_misses > 0,
+           "every part is mapped once and chunks were decoded");
+
+    const std::uint64_t from = kBase + 1'200'000'000ull;
+    const std::uint64_t to = kBase + 1'300'000'000ull;
+    const std::vector<Read> window = readBack(cached, from, to);
+    const bag::ReaderCacheStats before = cached.cacheStats();
+    expect(readBack(cached, from, to) == window, "a window read twice reads the same");
+    const bag::ReaderCacheStats after = cached.cacheStats();
+    expect(after.chunk_misses == before.chunk_misses && after.chunk_hits > before.chunk_hits,
+           "and the second read decompresses nothing");
+
+    bag::BagReader starved(dir.str(), bag::ReaderOptions{.cached = true, .chunk_cache_bytes = 1});
+    expect(readBack(starved, 0, all_end) == everything,
+           "a cache too small to hold one chunk still reads everything");
+    expect(starved.cacheStats().cached_chunks == 0, "without keeping any of it");
+}
+
+// A topic-filtered read: a sparse topic among a heavy one, through both
+// readers. The answer must be the unfiltered read with everything else taken
+// out -- and, cached, it must have opened only the chunks the sparse topic is
+// actually in.
+void testTopicFilteredRead()
+{
+    const TempDir dir("topics");
+    {
+        bag::WriterOptions options;
+        options.name = "topics";
+        options.chunk_bytes = 16 * 1024;
+        bag::BagWriter writer(dir.str(), options);
+        for (int i = 0; i < 3000; ++i)
+        {
+            const std::uint64_t t = kBase + static_cast<std::uint64_t>(i) * 1'000'000ull;
+            if (i % 250 == 7)
+            {
+                writer.write("vehicle/warnings", "Warning", payloadFor(i, 40), t, std::nullopt,
+                             "");
+            }
+            else
+            {
+                writer.write("carplay/video", "CarPlayVideo", payloadFor(i, 2000), t,
+                             std::nullopt, "");
+            }
+        }
+        writer.close();
+    }
+
+    const auto keys = [](bag::BagReader& reader, std::uint64_t start_ns, std::uint64_t end_ns,
+                         const std::vector<std::string>* topics)
+    {
+        std::vector<std::pair<std::string, std::uint64_t>> out;
+        const auto visit = [&](const bag::BagMessage& message)
+        {
+            out.emplace_back(std::string(message.key), message.log_time_ns);
+            return true;
+        };
+        if (topics != nullptr)
+        {
+            reader.forEach(start_ns, end_ns, *topics, visit);
+        }
+        else
+        {
+            reader.forEach(start_ns, end_ns, visit);
+        }
+        return out;
+    };
+
+    bag::BagReader plain(dir.str());
+    bag::BagReader cached(dir.str(), bag::ReaderOptions{.cached = true});
+
+    const std::uint64_t all_end = std::numeric_limits<std::uint64_t>::max();
+    std::vector<std::pair<std::string, std::uint64_t>> expected;
+    for (const auto& entry : keys(plain, 0, all_end, nullptr))
+    {
+        if (entry.first == "vehicle/warnings")
+        {
+            expected.push_back(entry);
+        }
+    }
+    expect(expected.size() == 12, "the recording holds twelve warnings");
+
+    const std::vector<std::string> warnings{"vehicle/warnings"};
+    expect(keys(plain, 0, all_end, &warnings) == expected,
+           "a topic-filtered read returns exactly that topic, in order");
+    expect(keys(cached, 0, all_end, &warnings) == expected, "and so does a cached one");
+
+    const bag::ReaderCacheStats sparse = cached.cacheStats();
+    expect(sparse.chunk_misses <= expected.size(),
+           "which opened only chunks a warning is in (" + std::to_string(sparse.chunk_misses) +
+               " for " + std::to_string(expected.size()) + " warnings)");
+
+    const std::uint64_t from = kBase + 1'000'000'000ull;
+    const std::uint64_t to = kBase + 1'400'000'000ull;
+    expect(keys(cached, from, to, &warnings) == keys(plain, from, to, &warnings) &&
+               keys(plain, from, to, &warnings).size() == 2,
+           "a window holds just the warnings inside it");
+
+    const std::vector<std::string> none;
+    const std::vector<std::string> unknown{"vehicle/not_recorded"};
+    expect(keys(cached, 0, all_end, &none).empty() && keys(plain, 0, all_end, &none).empty(),
+           "an empty topic set matches nothing");
+    expect(keys(cached, 0, all_end, &unknown).empty() && keys(plain, 0, all_end, &unknown).empty(),
+           "and so does a topic the recording does not have");
+
+    const std::vector<std::string> both{"carplay/video", "vehicle/warnings"};
+    expect(keys(cached, 0, all_end, &both) == keys(plain, 0, all_end, nullptr),
+           "naming every topic is the unfiltered read");
+}
+
 // An in-progress recording is readable, because the index is written on every
 // roll rather than only at close().
 //
@@ -662,6 +998,10 @@ int main()
     testRoundTrip();
     testUnstampedAreCounted();
     testSplitting();
+    testPipelinedMatchesInline();
+    testPipelinedSizeCountsChunksInFlight();
+    testCachedReaderMatches();
+    testTopicFilteredRead();
     testIndexIsWrittenOnRoll();
     testRolledPartsAreSelfConsistent();
     testSeeking();
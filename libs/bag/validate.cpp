@@ -257,6 +257,19 @@ std::vector<std::uint8_t> decompress(const std::string& codec,
         return std::vector<std::uint8_t>(data, data + compressed_size);
     }
 
+    // A damaged uncompressed_size is exactly what this is pointed at, and it
+    // must be a finding rather than an allocation. The ceilings are each
+    // codec's own -- a zstd RLE block is four bytes for up to 128 KiB, an LZ4
+    // sequence at most 255 bytes of match per byte -- and 1 GiB whatever the
+    // codec, well past any chunk a writer seals.
+    const std::uint64_t max_ratio = codec == "zstd" ? 128 * 1024 / 4 : 255;
+    if (uncompressed_size > (1ull << 30) || uncompressed_size / max_ratio > compressed_size)
+    {
+        error = codec + ": " + std::to_string(compressed_size) + " bytes cannot decompress to " +
+                std::to_string(uncompressed_size);
+        return {};
+    }
+
     std::vector<std::uint8_t> out(uncompressed_size);
 
     if (codec == "zstd")
@@ -1,5 +1,6 @@
 #include "bag/writer.h"
 
+#include "bag/pipelined_writer.h"
 #include "bag/validate.h"
 
 #include "pub_sub/schema_registry.h"
@@ -60,6 +61,49 @@ mcap::CompressionLevel levelFromInt(int level)
     }
 }
 
+// The same tiers in each codec's own numbers, for the pipelined writer, which
+// calls the codecs directly rather than through mcap's named levels.
+int codecLevel(const std::string& codec, int level)
+{
+    const mcap::CompressionLevel tier = levelFromInt(level);
+    if (codec == "lz4")
+    {
+        // Negative is lz4's accelerated mode; 3 and up is lz4hc.
+        switch (tier)
+        {
+            case mcap::CompressionLevel::Fastest:
+                return -4;
+            case mcap::CompressionLevel::Fast:
+                return -1;
+            case mcap::CompressionLevel::Slow:
+                return 9;
+            case mcap::CompressionLevel::Slowest:
+                return 12;
+            default:
+                return 0;
+        }
+    }
+
+    switch (tier)
+    {
+        case mcap::CompressionLevel::Fastest:
+            return 1;
+        case mcap::CompressionLevel::Fast:
+            return 2;
+        case mcap::CompressionLevel::Slow:
+            return 9;
+        case mcap::CompressionLevel::Slowest:
+            return 19;
+        default:
+            return 3;
+    }
+}
+
+double seconds(const std::atomic<std::uint64_t>& nanos)
+{
+    return static_cast<double>(nanos.load(std::memory_order_relaxed)) / 1e9;
+}
+
 std::string isoNow()
 {
     const auto now = std::chrono::system_clock::now();
@@ -103,6 +147,15 @@ struct BagWriter::Impl
     // which is exactly the class of bug that ships as "works for us, broken for
     // everyone else". Constructing a new writer makes the reset total.
     std::unique_ptr<mcap::McapWriter> writer;
+
+    // Instead of `writer` when options.compression_threads is set, and fresh
+    // per part for the same reason. Exactly one of the two is open.
+    std::unique_ptr<PipelinedMcapWriter> pipelined;
+
+    // Outlives the part writers, which add to it, so the totals span the
+    // whole recording.
+    StageCounters stage_counters;
+
     std::string part_path;
     std::size_t part_index = 0;
     std::uint64_t part_messages = 0;
@@ -146,6 +199,24 @@ struct BagWriter::Impl
         const std::string name = partName(part_index);
         part_path = (std::filesystem::path(directory) / name).string();
 
+        if (options.compression_threads > 0)
+        {
+            PipelinedMcapWriter::Options pipelined_options;
+            pipelined_options.compression = options.compression;
+            pipelined_options.level = codecLevel(options.compression, options.compression_level);
+            pipelined_options.chunk_bytes = options.chunk_bytes;
+            pipelined_options.library = options.recorder;
+            pipelined_options.threads = options.compression_threads;
+
+            pipelined = std::make_unique<PipelinedMcapWriter>(stage_counters);
+            if (!pipelined->open(part_path, pipelined_options))
+            {
+                return false;
+            }
+            resetPart();
+            return true;
+        }
+
         mcap::McapWriterOptions writer_options("");
         writer_options.compression = codecFromName(options.compression);
         writer_options.compressionLevel = levelFromInt(options.compression_level);
@@ -165,18 +236,30 @@ struct BagWriter::Impl
             return false;
         }
 
+        resetPart();
+        return true;
+    }
+
+    void resetPart()
+    {
         channels.clear();
         schemas.clear();
         part_messages = 0;
         part_t_begin = 0;
         part_t_end = 0;
         part_started = std::chrono::steady_clock::now();
-        return true;
     }
 
     void finishPart()
     {
-        if (writer)
+        if (pipelined)
+        {
+            // Waits for every chunk still being compressed or appended. A
+            // failure shows as `complete: false` below, as it does for mcap.
+            pipelined->close();
+            pipelined.reset();
+        }
+        else if (writer)
         {
             writer->close();
         }
@@ -259,6 +342,14 @@ struct BagWriter::Impl
 
         if (options.max_part_bytes > 0 && (part_messages % kSizeCheckInterval) == 0)
         {
+            // Not file_size() for the pipelined writer: up to chunks_in_flight
+            // chunks are still being compressed or waiting for the disk, and a
+            // part rolled on what has landed would overshoot by all of them.
+            // projectedBytes() counts them in as they will compress.
+            if (pipelined)
+            {
+                return pipelined->projectedBytes() >= options.max_part_bytes;
+            }
             std::error_code error;
             const std::uintmax_t size = std::filesystem::file_size(part_path, error);
             if (!error && size >= options.max_part_bytes)
@@ -314,6 +405,15 @@ struct BagWriter::Impl
             display_name = std::string(pub_sub::schema_display_name(*schema_type));
         }
 
+        if (pipelined)
+        {
+            const mcap::SchemaId id =
+                pipelined->addSchema(display_name, descriptor.empty() ? "" : "capnproto",
+                                     descriptor);
+            schemas.emplace(name, id);
+            return id;
+        }
+
         schema.name = display_name;
         schema.encoding = descriptor.empty() ? "" : "capnproto";
         schema.data.assign(reinterpret_cast<const std::byte*>(descriptor.data()),
@@ -333,6 +433,15 @@ struct BagWriter::Impl
             return found->second;
         }
 
+        if (pipelined)
+        {
+            const mcap::ChannelId id =
+                pipelined->addChannel(topic, "capnproto", schemaIdFor(schema_name),
+                                      {{"redline/schema", std::string(schema_name)}});
+            channels.emplace(topic, id);
+            return id;
+        }
+
         mcap::Channel channel;
         channel.topic = topic;
         channel.messageEncoding = "capnproto";
@@ -410,8 +519,10 @@ bool BagWriter::write(std::string_view key, std::string_view schema_name,
         return false;
     }
 
+    const mcap::ChannelId channel_id = impl_->channelIdFor(key, schema_name);
+
     mcap::Message message;
-    message.channelId = impl_->channelIdFor(key, schema_name);
+    message.channelId = channel_id;
     message.sequence = 0;
     message.logTime = log_time_ns;
 
@@ -433,8 +544,16 @@ bool BagWriter::write(std::string_view key, std::string_view schema_name,
     message.dataSize = payload.size();
     message.data = reinterpret_cast<const std::byte*>(payload.data());
 
-    const mcap::Status status = impl_->writer->write(message);
-    if (!status.ok())
+    if (impl_->pipelined)
+    {
+        if (!impl_->pipelined->write(channel_id, message.logTime, message.publishTime, payload))
+        {
+            SPDLOG_ERROR("Write to '{}' failed.", impl_->part_path);
+            impl_->valid = false;
+            return false;
+        }
+    }
+    else if (const mcap::Status status = impl_->writer->write(message); !status.ok())
     {
         SPDLOG_ERROR("Write to '{}' failed: {}", impl_->part_path, status.message);
         impl_->valid = false;
@@ -520,4 +639,19 @@ const bag_metadata_t& BagWriter::metadata() const
     return impl_->metadata;
 }
 
+WriterStageStats BagWriter::stageStats() const
+{
+    const StageCounters& counters = impl_->stage_counters;
+
+    WriterStageStats stats;
+    stats.chunks = counters.chunks.load(std::memory_order_relaxed);
+    stats.uncompressed_bytes = counters.uncompressed_bytes.load(std::memory_order_relaxed);
+    stats.compressed_bytes = counters.compressed_bytes.load(std::memory_order_relaxed);
+    stats.build_seconds = seconds(counters.build_ns);
+    stats.compress_seconds = seconds(counters.compress_ns);
+    stats.append_seconds = seconds(counters.append_ns);
+    stats.stalled_seconds = seconds(counters.stall_ns);
+    return stats;
+}
+
 }  // namespace bag
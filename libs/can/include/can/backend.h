@@ -34,13 +34,34 @@
 #include "can/channel_id.h"
 #include "can/error.h"
 
+#include <cstdint>
 #include <memory>
+#include <span>
 #include <string>
 #include <vector>
 
 namespace can
 {
 
+// One receive filter. A frame passes when it is in the same format and its
+// identifier agrees with `id` on every bit set in `mask`; the default mask asks
+// for that one identifier exactly. The format is part of the match because an
+// 11-bit 0x123 and a 29-bit 0x123 are different messages.
+//
+// Error frames are not identifiers and are never filtered out -- a channel
+// that only wants two messages still wants to know the bus went off.
+struct RxFilter
+{
+    uint32_t id { 0 };
+    uint32_t mask { 0x1FFFFFFFu };
+    bool extended { false };
+};
+
+// Whether `frame` gets through `filters`. An empty list passes everything. Bits
+// of `id` and `mask` above the frame's format are ignored, which is how the
+// kernel compares them too.
+bool passes(std::span<const RxFilter> filters, const helpers::CanFrame& frame);
+
 // How a channel should be set up at open time. Passing this to open() rather
 // than making the caller configure afterwards means a backend that can only
 // set its bit rate before the interface comes up -- SocketCAN -- does not need
@@ -54,6 +75,12 @@ struct OpenOptions
     // How many frames the backend may buffer before it starts dropping. The
     // default holds about a second of a busy 500 kbit/s bus.
     size_t rxQueueDepth { 8192 };
+    // Only frames that pass one of these are received; empty receives
+    // everything. SocketCAN hands the list to the kernel, so a frame nobody
+    // asked for never reaches this process at all. Every other backend drops
+    // it before it is queued, which costs the adapter's link the same but
+    // keeps what receive() returns identical whichever backend is underneath.
+    std::vector<RxFilter> rxFilters;
 };
 
 class Backend
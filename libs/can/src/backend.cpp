@@ -7,6 +7,23 @@
 namespace can
 {
 
+bool passes(std::span<const RxFilter> filters, const helpers::CanFrame& frame)
+{
+    if (filters.empty() || frame.isError)
+    {
+        return true;
+    }
+    for (const RxFilter& filter : filters)
+    {
+        if (filter.extended == frame.isExtended
+            && ((frame.id ^ filter.id) & filter.mask & frame.id_mask()) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 Backend::~Backend() = default;
 
 Registry::Registry() = default;
@@ -37,6 +54,20 @@ std::vector<ChannelInfo> Registry::enumerate() const
 Result<std::shared_ptr<Channel>> Registry::open(const ChannelId& id,
                                                 const OpenOptions& options) const
 {
+    // Checked here rather than by each backend so that a bad filter fails the
+    // same way on all of them. One wider than its format would silently
+    // match nothing, which on a bus being bridged looks like a dead bus.
+    for (const RxFilter& filter : options.rxFilters)
+    {
+        const uint32_t widest = filter.extended ? 0x1FFFFFFFu : 0x7FFu;
+        if ((filter.id & ~widest) != 0)
+        {
+            return invalid_argument(fmt::format(
+                "receive filter 0x{:X} does not fit an {}-bit identifier", filter.id,
+                filter.extended ? 29 : 11));
+        }
+    }
+
     for (const auto& backend : backends_)
     {
         if (backend->name() == id.backend)
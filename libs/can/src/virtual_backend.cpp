@@ -9,6 +9,7 @@
 #include <deque>
 #include <map>
 #include <mutex>
+#include <vector>
 
 namespace can
 {
@@ -75,6 +76,7 @@ public:
         , bitrate_(options.bitrate)
         , listenOnly_(options.listenOnly)
         , queueDepth_(options.rxQueueDepth)
+        , rxFilters_(options.rxFilters)
     {
         bus_->attach(this);
         if (options.start)
@@ -200,6 +202,12 @@ public:
     // Called by the bus, from whichever thread sent the frame.
     void deliver(const helpers::CanFrame& frame)
     {
+        // Filtered before the queue, as a kernel filter would be: a frame
+        // nobody asked for is not received, so it is not counted either.
+        if (!passes(rxFilters_, frame))
+        {
+            return;
+        }
         {
             std::lock_guard<std::mutex> lock(mutex_);
             if (!running_)
@@ -234,6 +242,7 @@ private:
     bool listenOnly_ { false };
     bool running_ { false };
     size_t queueDepth_ { 8192 };
+    const std::vector<RxFilter> rxFilters_;
     Statistics statistics_ {};
 };
 
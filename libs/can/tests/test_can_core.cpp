@@ -476,6 +476,66 @@ void test_virtual_bus_across_threads()
                       received));
 }
 
+// A filtered channel receives what it asked for and nothing else -- in both
+// formats, with error frames let through regardless -- and a frame it did not
+// ask for is not counted as received.
+void test_virtual_bus_filters()
+{
+    auto registry = make_virtual_only_registry();
+    can::OpenOptions filtered;
+    filtered.rxFilters = {
+        { .id = 0x100, .mask = 0x7F0, .extended = false },
+        { .id = 0x18FF0001, .extended = true },
+    };
+    auto reader = registry.open("virtual:filters", filtered);
+    auto writer = registry.open("virtual:filters", can::OpenOptions {});
+    if (!reader.has_value() || !writer.has_value())
+    {
+        check(false, "both channels open");
+        return;
+    }
+
+    helpers::CanFrame extendedWanted = make_frame(0x18FF0001, { 0x01 });
+    extendedWanted.isExtended = true;
+    helpers::CanFrame extendedOther = make_frame(0x18FF0002, { 0x02 });
+    extendedOther.isExtended = true;
+    // 0x100 in the other format: the same number, a different message.
+    helpers::CanFrame wrongFormat = make_frame(0x100, { 0x03 });
+    wrongFormat.isExtended = true;
+    helpers::CanFrame error = make_frame(0x40, {});
+    error.isError = true;
+
+    for (const helpers::CanFrame& frame :
+         { make_frame(0x100, { 0x04 }), make_frame(0x10F, { 0x05 }), make_frame(0x110, { 0x06 }),
+           extendedWanted, extendedOther, wrongFormat, error })
+    {
+        can::virtual_bus_inject("filters", frame);
+    }
+
+    helpers::CanFrame received[16];
+    auto count = (*reader)->receive(received, can::Duration { 200 });
+    check(count.has_value() && *count == 4,
+          "a filtered channel receives the four frames it asked for and the error frame");
+    if (count.has_value() && *count == 4)
+    {
+        check(received[0].id == 0x100 && received[1].id == 0x10F,
+              "the masked filter passes every identifier in its range");
+        check(received[2].id == 0x18FF0001 && received[2].isExtended,
+              "the exact extended filter passes its one identifier");
+        check(received[3].isError, "and the error frame gets through whatever the filters say");
+    }
+    check((*reader)->statistics().rxFrames == 4, "only what passed is counted as received");
+
+    auto everything = (*writer)->receive(received, can::Duration { 200 });
+    check(everything.has_value() && *everything == 7, "an unfiltered channel still sees all 7");
+
+    can::OpenOptions tooWide;
+    tooWide.rxFilters = { { .id = 0x800, .extended = false } };
+    auto refused = registry.open("virtual:filters", tooWide);
+    check(!refused.has_value() && refused.error().kind == can::Error::Kind::InvalidArgument,
+          "a filter identifier wider than its format is refused at open");
+}
+
 void test_registry_reports_unknown_backends()
 {
     auto registry = make_virtual_only_registry();
@@ -512,6 +572,7 @@ int main()
     test_virtual_buses_are_separate();
     test_virtual_bus_rejects_bad_frames();
     test_virtual_bus_across_threads();
+    test_virtual_bus_filters();
     test_registry_reports_unknown_backends();
 
     if (failures != 0)
@@ -15,6 +15,7 @@
 #include <deque>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 namespace can::motec
 {
@@ -36,6 +37,7 @@ public:
         , options_(motecOptions)
         , bitrate_(options.bitrate)
         , queueDepth_(options.rxQueueDepth)
+        , rxFilters_(options.rxFilters)
         , busHandle_(busHandle)
     {
     }
@@ -342,6 +344,11 @@ private:
         std::lock_guard<std::mutex> lock(queueMutex_);
         for (const auto& record : records)
         {
+            const helpers::CanFrame canFrame = to_can_frame(record);
+            if (!passes(rxFilters_, canFrame))
+            {
+                continue;
+            }
             if (queue_.size() >= queueDepth_)
             {
                 // Oldest first: on a bus being logged, the most recent frames
@@ -350,7 +357,7 @@ private:
                 std::lock_guard<std::mutex> stats(statsMutex_);
                 statistics_.rxDropped++;
             }
-            queue_.push_back(to_can_frame(record));
+            queue_.push_back(canFrame);
 
             std::lock_guard<std::mutex> stats(statsMutex_);
             statistics_.rxFrames++;
@@ -364,6 +371,7 @@ private:
     MotecOptions options_;
     Bitrate bitrate_;
     size_t queueDepth_ { 8192 };
+    const std::vector<RxFilter> rxFilters_;
     uint8_t busHandle_ { 1 };
 
     std::atomic<uint8_t> nextReqid_ { 1 };
@@ -15,6 +15,7 @@
 #include <deque>
 #include <map>
 #include <mutex>
+#include <vector>
 
 namespace can::pcan
 {
@@ -38,6 +39,7 @@ public:
         , bitrate_(options.bitrate)
         , listenOnly_(options.listenOnly)
         , queueDepth_(options.rxQueueDepth)
+        , rxFilters_(options.rxFilters)
     {
         description_ = fmt::format("{} channel {}", device_->description(), localChannel_);
         device_->attach(localChannel_, this);
@@ -247,6 +249,12 @@ public:
             switch (record.type)
             {
             case RecordType::CanRx:
+                // The adapter has already carried it over USB; this only keeps
+                // it out of the queue, the same as every non-kernel backend.
+                if (!passes(rxFilters_, record.frame))
+                {
+                    break;
+                }
                 if (queue_.size() >= queueDepth_)
                 {
                     queue_.pop_front();
@@ -341,6 +349,7 @@ private:
     std::atomic<bool> listenOnly_ { false };
     std::atomic<bool> running_ { false };
     size_t queueDepth_ { 8192 };
+    const std::vector<RxFilter> rxFilters_;
     Statistics statistics_ {};
 };
 
@@ -0,0 +1,513 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//
+// What receive() costs on a SocketCAN interface with a bus's worth of traffic.
+//
+// NOT a test -- it asserts nothing and always exits 0. test_socketcan is what
+// shows the kernel's filters mean what can::passes() means; this shows what
+// the batched read and the filters buy. A second thread writes classic frames
+// onto the interface as fast as it will take them, cycling through 512
+// identifiers, and the reader takes them for --seconds at a time:
+//
+//   * "recvmsg", the way receive() read before recvmmsg: poll(), then one
+//     recvmsg() per frame until EAGAIN, on a bare CAN_RAW socket.
+//   * "recvmmsg", the channel's receive() itself, with no filters and then
+//     once for each --wanted count, keeping that many identifiers.
+//
+//   ip link add dev vcan0 type vcan && ip link set vcan0 up     (as root, once)
+//   can_socketcan_bench_receive --interface vcan0
+//   can_socketcan_bench_receive --interface vcan0 --seconds 10 --wanted 1,8,64
+//
+// A machine with no AF_CAN at all -- a container, most CI -- can still compare
+// the two reads without the CAN stack under them. --socketpair writes the same
+// 16-byte frames into an AF_UNIX datagram pair and reads them both ways, with
+// the channel's batching copied onto a bare descriptor. That is the syscall
+// cost alone; a vcan adds its own per-frame work to both rows.
+//
+//   can_socketcan_bench_receive --socketpair
+//
+// Run it as an ordinary user. A vcan has no bit rate, so open()'s attempt to
+// set one fails; without CAP_NET_ADMIN that is a permission refusal, which
+// open() carries on past, where with it the kernel's "not supported" is not.
+//
+// What each column means:
+//
+//   read       recvmsg (one per frame) or recvmmsg (up to 64 per call)
+//   wanted     identifiers the filters keep, or "all"
+//   sent/s     frames the writer put on the interface, per second
+//   recv/s     frames receive() returned, per second
+//   per call   frames per receive(): how much each poll() found waiting
+//   sys/frame  syscalls per frame received, poll() included -- counted for
+//              the bare reads, and for the channel's from what receive()
+//              returned
+//   cpu        the reading thread's user + system time, as a share of one core
+//   ns/frame   that time per frame received
+//   dropped    Statistics::rxDropped: the socket's own queue overflowing; "-"
+//              for the bare reads, which keep no statistics
+//
+// A filtered row's cpu is the one to read: the frames the filters refuse are
+// dropped before they are queued on the socket, so they cost the reader
+// nothing at all.
+
+#include "can_socketcan/socketcan_backend.h"
+#include "can_socketcan/socketcan_frame.h"
+
+#include "can/backend.h"
+
+#include <spdlog/spdlog.h>
+
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+// What the bridge asks each receive() for.
+constexpr size_t kReceiveSpan = 64;
+// Matches kReceiveBatch and kControlSize in socketcan_backend.cpp.
+constexpr size_t kRecvmmsgBatch = 64;
+constexpr size_t kControlSize = CMSG_SPACE(sizeof(timeval)) + CMSG_SPACE(sizeof(uint32_t));
+constexpr uint32_t kIdentifiers = 512;
+
+std::string argumentAfter(int argc, char** argv, const std::string& flag,
+                          const std::string& fallback)
+{
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (flag == argv[i])
+        {
+            return argv[i + 1];
+        }
+    }
+    return fallback;
+}
+
+// "1,8,64" -> {1, 8, 64}. Empty or unparseable means 8.
+std::vector<uint32_t> wantedCounts(const std::string& list)
+{
+    std::vector<uint32_t> out;
+    size_t at = 0;
+    while (at < list.size())
+    {
+        const size_t comma = std::min(list.find(',', at), list.size());
+        const long value = std::strtol(list.substr(at, comma - at).c_str(), nullptr, 10);
+        if (value > 0)
+        {
+            out.push_back(static_cast<uint32_t>(std::min<long>(value, kIdentifiers)));
+        }
+        at = comma + 1;
+    }
+    if (out.empty())
+    {
+        out = { 8 };
+    }
+    return out;
+}
+
+double threadCpuSeconds()
+{
+    rusage usage {};
+    ::getrusage(RUSAGE_THREAD, &usage);
+    return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)
+        + static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+// A plain CAN_RAW socket, not a Channel: the writer is load, not the thing
+// being measured, and it must not share the channel's statistics. The
+// per-frame reader is one too, set up as open() sets up the channel's.
+int openRaw(const std::string& interface)
+{
+    const int fd = ::socket(PF_CAN, SOCK_RAW | SOCK_CLOEXEC, CAN_RAW);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    ifreq request {};
+    std::strncpy(request.ifr_name, interface.c_str(), IFNAMSIZ - 1);
+    sockaddr_can address {};
+    address.can_family = AF_CAN;
+    if (::ioctl(fd, SIOCGIFINDEX, &request) < 0)
+    {
+        ::close(fd);
+        return -1;
+    }
+    address.can_ifindex = request.ifr_ifindex;
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0)
+    {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// What the channel asks of every socket it reads: a kernel arrival time and
+// the running drop count on each frame.
+void enableReceiveOptions(int fd)
+{
+    const int on = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_TIMESTAMP, &on, sizeof(on));
+    ::setsockopt(fd, SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof(on));
+}
+
+// One receive(): frames taken, and the syscalls that took them.
+struct Drain
+{
+    size_t frames { 0 };
+    uint64_t syscalls { 0 };
+};
+
+// Decodes a frame as receive() does, arrival time included, so the bare reads
+// do the channel's work and not just its syscalls.
+bool decodeInto(std::span<const uint8_t> bytes, msghdr& message, helpers::CanFrame& out)
+{
+    auto frame = can::socketcan::decode_frame(bytes);
+    if (!frame.has_value())
+    {
+        return false;
+    }
+    for (cmsghdr* header = CMSG_FIRSTHDR(&message); header != nullptr;
+         header = CMSG_NXTHDR(&message, header))
+    {
+        if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SO_TIMESTAMP)
+        {
+            timeval stamp {};
+            std::memcpy(&stamp, CMSG_DATA(header), sizeof(stamp));
+            frame->timestampUs = static_cast<uint64_t>(stamp.tv_sec) * 1000000ull
+                + static_cast<uint64_t>(stamp.tv_usec);
+        }
+    }
+    out = *frame;
+    return true;
+}
+
+// poll() for up to `timeoutMs`. False on a timeout or a failure.
+bool waitReadable(int fd, int timeoutMs, Drain& drain)
+{
+    pollfd poller { fd, POLLIN, 0 };
+    ++drain.syscalls;
+    return ::poll(&poller, 1, timeoutMs) > 0;
+}
+
+// receive() before recvmmsg, on a bare descriptor: a syscall per frame, and one
+// more to find the queue empty.
+Drain readPerFrame(int fd, std::span<helpers::CanFrame> out, int timeoutMs)
+{
+    Drain drain;
+    if (!waitReadable(fd, timeoutMs, drain))
+    {
+        return drain;
+    }
+    while (drain.frames < out.size())
+    {
+        std::array<uint8_t, CANFD_MTU> buffer {};
+        std::array<uint8_t, kControlSize> control {};
+        iovec iov { buffer.data(), buffer.size() };
+        msghdr message {};
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+        message.msg_control = control.data();
+        message.msg_controllen = control.size();
+
+        ++drain.syscalls;
+        const ssize_t got = ::recvmsg(fd, &message, MSG_DONTWAIT);
+        if (got < 0)
+        {
+            break;
+        }
+        if (decodeInto(std::span(buffer.data(), static_cast<size_t>(got)), message,
+                       out[drain.frames]))
+        {
+            ++drain.frames;
+        }
+    }
+    return drain;
+}
+
+// receive() as it is, on a bare descriptor: socketcan_backend.cpp's batching,
+// for the socket pair, where no channel can be opened.
+class BatchedReader
+{
+  public:
+    BatchedReader()
+    {
+        for (size_t i = 0; i < kRecvmmsgBatch; ++i)
+        {
+            iov_[i].iov_base = buffers_[i].data();
+            iov_[i].iov_len = buffers_[i].size();
+            messages_[i].msg_hdr.msg_iov = &iov_[i];
+            messages_[i].msg_hdr.msg_iovlen = 1;
+            messages_[i].msg_hdr.msg_control = control_[i].data();
+        }
+    }
+
+    BatchedReader(const BatchedReader&) = delete;
+    BatchedReader& operator=(const BatchedReader&) = delete;
+
+    Drain read(int fd, std::span<helpers::CanFrame> out, int timeoutMs)
+    {
+        Drain drain;
+        if (!waitReadable(fd, timeoutMs, drain))
+        {
+            return drain;
+        }
+        while (drain.frames < out.size())
+        {
+            const size_t want = std::min(out.size() - drain.frames, kRecvmmsgBatch);
+            for (size_t i = 0; i < want; ++i)
+            {
+                messages_[i].msg_hdr.msg_controllen = kControlSize;
+                messages_[i].msg_len = 0;
+            }
+            ++drain.syscalls;
+            const int got = ::recvmmsg(fd, messages_.data(), static_cast<unsigned int>(want),
+                                       MSG_DONTWAIT, nullptr);
+            if (got < 0)
+            {
+                break;
+            }
+            for (size_t i = 0; i < static_cast<size_t>(got); ++i)
+            {
+                if (decodeInto(std::span(buffers_[i].data(), messages_[i].msg_len),
+                               messages_[i].msg_hdr, out[drain.frames]))
+                {
+                    ++drain.frames;
+                }
+            }
+            if (static_cast<size_t>(got) < want)
+            {
+                break;
+            }
+        }
+        return drain;
+    }
+
+  private:
+    std::array<std::array<uint8_t, CANFD_MTU>, kRecvmmsgBatch> buffers_ {};
+    std::array<std::array<uint8_t, kControlSize>, kRecvmmsgBatch> control_ {};
+    std::array<iovec, kRecvmmsgBatch> iov_ {};
+    std::array<mmsghdr, kRecvmmsgBatch> messages_ {};
+};
+
+// One row: `writer` loaded as fast as it will take frames while `receive`
+// drains the other end for `seconds`. Null from `receive` is a failed read,
+// and from `dropped` a reader with no Statistics to ask.
+void measure(const std::string& read, const std::string& wanted, int writer, double seconds,
+             const std::function<std::optional<Drain>(std::span<helpers::CanFrame>)>& receive,
+             const std::function<std::optional<uint64_t>()>& dropped)
+{
+    std::atomic<bool> stop { false };
+    std::atomic<uint64_t> sent { 0 };
+    std::thread load([&] {
+        can_frame frame {};
+        frame.len = 8;
+        uint32_t next = 0;
+        while (!stop.load(std::memory_order_relaxed))
+        {
+            frame.can_id = next++ % kIdentifiers;
+            if (::write(writer, &frame, sizeof(frame)) == sizeof(frame))
+            {
+                sent.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            // ENOBUFS, or EAGAIN on the pair: the queue is full. Wait for
+            // room rather than spinning on the error.
+            pollfd room { writer, POLLOUT, 0 };
+            ::poll(&room, 1, 10);
+        }
+    });
+
+    std::vector<helpers::CanFrame> buffer(kReceiveSpan);
+    uint64_t received = 0;
+    uint64_t calls = 0;
+    uint64_t syscalls = 0;
+    const double cpuBefore = threadCpuSeconds();
+    const auto start = std::chrono::steady_clock::now();
+    const auto end = start + std::chrono::duration<double>(seconds);
+    while (std::chrono::steady_clock::now() < end)
+    {
+        const std::optional<Drain> drain = receive(buffer);
+        if (!drain.has_value())
+        {
+            break;
+        }
+        ++calls;
+        received += drain->frames;
+        syscalls += drain->syscalls;
+    }
+    const double elapsed =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double cpu = threadCpuSeconds() - cpuBefore;
+
+    stop = true;
+    load.join();
+
+    const std::optional<uint64_t> lost = dropped();
+    SPDLOG_INFO("{:>8} {:>7} {:>10.0f} {:>10.0f} {:>9.1f} {:>10.3f} {:>5.1f}% {:>9.0f} {:>8}",
+                read, wanted, double(sent.load()) / elapsed, double(received) / elapsed,
+                calls != 0 ? double(received) / double(calls) : 0.0,
+                received != 0 ? double(syscalls) / double(received) : 0.0,
+                100.0 * cpu / elapsed, received != 0 ? cpu * 1e9 / double(received) : 0.0,
+                lost.has_value() ? std::to_string(*lost) : std::string("-"));
+}
+
+// Both reads against an AF_UNIX datagram pair. See the top of the file.
+void measureSocketPair(double seconds)
+{
+    SPDLOG_INFO("AF_UNIX datagram pair: {} identifiers written, {:.1f} s per row", kIdentifiers,
+                seconds);
+    SPDLOG_INFO("{:>8} {:>7} {:>10} {:>10} {:>9} {:>10} {:>6} {:>9} {:>8}", "read", "wanted",
+                "sent/s", "recv/s", "per call", "sys/frame", "cpu", "ns/frame", "dropped");
+
+    BatchedReader batched;
+    for (const bool perFrame : { true, false })
+    {
+        int pair[2] = { -1, -1 };
+        if (::socketpair(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, pair) < 0)
+        {
+            SPDLOG_ERROR("cannot open a socket pair: {}", std::strerror(errno));
+            return;
+        }
+        enableReceiveOptions(pair[0]);
+        const int reader = pair[0];
+        measure(
+            perFrame ? "recvmsg" : "recvmmsg", "all", pair[1], seconds,
+            [&](std::span<helpers::CanFrame> out) -> std::optional<Drain> {
+                return perFrame ? readPerFrame(reader, out, 100) : batched.read(reader, out, 100);
+            },
+            [] { return std::optional<uint64_t> {}; });
+        ::close(pair[0]);
+        ::close(pair[1]);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    spdlog::set_pattern("%v");
+
+    const std::string secondsText = argumentAfter(argc, argv, "--seconds", "5");
+    const double seconds = std::max(0.5, std::strtod(secondsText.c_str(), nullptr));
+
+    const std::string interface = argumentAfter(argc, argv, "--interface", "");
+    if (interface.empty())
+    {
+        if (std::find(argv + 1, argv + argc, std::string("--socketpair")) != argv + argc)
+        {
+            measureSocketPair(seconds);
+            return 0;
+        }
+        SPDLOG_ERROR("usage: can_socketcan_bench_receive --interface <vcan> [--seconds 5] "
+                     "[--wanted 1,8,64]\n"
+                     "       can_socketcan_bench_receive --socketpair [--seconds 5]");
+        return 0;
+    }
+
+    auto backend = can::socketcan::make_socketcan_backend();
+
+    // -1 is the per-frame read; 0 the channel with no filters.
+    std::vector<int> rows = { -1, 0 };
+    for (const uint32_t wanted : wantedCounts(argumentAfter(argc, argv, "--wanted", "")))
+    {
+        rows.push_back(static_cast<int>(wanted));
+    }
+
+    SPDLOG_INFO("{}: {} identifiers written, {:.1f} s per row", interface, kIdentifiers,
+                seconds);
+    SPDLOG_INFO("{:>8} {:>7} {:>10} {:>10} {:>9} {:>10} {:>6} {:>9} {:>8}", "read", "wanted",
+                "sent/s", "recv/s", "per call", "sys/frame", "cpu", "ns/frame", "dropped");
+
+    for (const int wanted : rows)
+    {
+        const int writer = openRaw(interface);
+        if (writer < 0)
+        {
+            SPDLOG_ERROR("cannot open a writer on {}: {}", interface, std::strerror(errno));
+            return 0;
+        }
+
+        if (wanted < 0)
+        {
+            const int reader = openRaw(interface);
+            if (reader < 0)
+            {
+                SPDLOG_ERROR("cannot open a reader on {}: {}", interface, std::strerror(errno));
+                ::close(writer);
+                return 0;
+            }
+            enableReceiveOptions(reader);
+            measure(
+                "recvmsg", "all", writer, seconds,
+                [&](std::span<helpers::CanFrame> out) -> std::optional<Drain> {
+                    return readPerFrame(reader, out, 100);
+                },
+                [] { return std::optional<uint64_t> {}; });
+            ::close(reader);
+            ::close(writer);
+            continue;
+        }
+
+        can::OpenOptions options;
+        options.bitrate.nominalBps = 500000;
+        // Every wanted identifier exactly, spread across the 512 written so
+        // the ones refused are interleaved with the ones kept.
+        for (int i = 0; i < wanted; ++i)
+        {
+            options.rxFilters.push_back(
+                { .id = static_cast<uint32_t>(i) * (kIdentifiers / static_cast<uint32_t>(wanted)),
+                  .extended = false });
+        }
+
+        auto channel = backend->open(can::ChannelId { "socketcan", interface, 0 }, options);
+        if (!channel.has_value())
+        {
+            SPDLOG_ERROR("cannot open {}: {}", interface, channel.error().message);
+            ::close(writer);
+            return 0;
+        }
+
+        measure(
+            "recvmmsg", wanted == 0 ? std::string("all") : std::to_string(wanted), writer, seconds,
+            [&](std::span<helpers::CanFrame> out) -> std::optional<Drain> {
+                auto got = (*channel)->receive(out, can::Duration { 100 });
+                if (!got.has_value())
+                {
+                    SPDLOG_ERROR("receive failed: {}", got.error().message);
+                    return std::nullopt;
+                }
+                // One poll(), then recvmmsg() until a short batch or a full
+                // span. A full span ends on its last full batch; anything
+                // else ends on the short one. Nothing at all is a poll() that
+                // timed out.
+                Drain drain { *got, 1 };
+                if (*got != 0)
+                {
+                    drain.syscalls += *got == kReceiveSpan ? kReceiveSpan / kRecvmmsgBatch
+                                                           : *got / kRecvmmsgBatch + 1;
+                }
+                return drain;
+            },
+            [&] { return std::optional<uint64_t> { (*channel)->statistics().rxDropped }; });
+        ::close(writer);
+    }
+    return 0;
+}
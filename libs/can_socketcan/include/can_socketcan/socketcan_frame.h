@@ -20,6 +20,7 @@
 #ifndef CAN_SOCKETCAN_FRAME_H
 #define CAN_SOCKETCAN_FRAME_H
 
+#include "can/backend.h"
 #include "can/error.h"
 
 #include "helpers/can_frame.h"
@@ -53,6 +54,23 @@ Result<size_t> encode_frame(const helpers::CanFrame& frame, std::span<uint8_t> o
 // Reads whichever layout `bytes` holds, deciding by its length.
 Result<helpers::CanFrame> decode_frame(std::span<const uint8_t> bytes);
 
+// `struct can_filter`, which CAN_RAW_FILTER takes an array of. The kernel
+// passes a frame when (its id word & canMask) == (canId & canMask), and the id
+// word it compares is the one above -- flags and all. So the EFF bit has to be
+// in the mask of every filter or a 29-bit frame matches an 11-bit filter with
+// the same low bits, and it must stay out of RTR's place or a filter would
+// only pass data frames, which RxFilter does not ask for.
+struct KernelFilter
+{
+    uint32_t canId { 0 };
+    uint32_t canMask { 0 };
+};
+
+// CAN_RAW_FILTER_MAX. The kernel refuses a longer list outright.
+inline constexpr size_t kMaxKernelFilters = 512;
+
+KernelFilter to_kernel_filter(const RxFilter& filter);
+
 } // namespace can::socketcan
 
 #endif // CAN_SOCKETCAN_FRAME_H
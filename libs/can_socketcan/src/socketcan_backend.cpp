@@ -7,8 +7,11 @@
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <mutex>
+#include <vector>
 
 #if defined(__linux__)
 #include <linux/can.h>
@@ -58,6 +61,17 @@ namespace
 // from the kernel's headers directly now, so there is nothing left to compare.
 static_assert(kClassicFrameSize == sizeof(struct can_frame), "can_frame has changed size");
 static_assert(kFdFrameSize == sizeof(struct canfd_frame), "canfd_frame has changed size");
+static_assert(sizeof(KernelFilter) == sizeof(struct can_filter), "can_filter has changed size");
+static_assert(kMaxKernelFilters == CAN_RAW_FILTER_MAX, "CAN_RAW_FILTER_MAX has changed");
+
+// Frames taken per recvmmsg. Enough that a full bus at 500 kbit/s -- about
+// 4000 frames a second, so 400 between two 100 ms polls -- drains in a handful
+// of calls, and small enough that the buffers behind it are a few kilobytes.
+constexpr size_t kReceiveBatch = 64;
+
+// Room for both control messages a frame can carry: its arrival time and the
+// socket's drop count.
+constexpr size_t kControlSize = CMSG_SPACE(sizeof(timeval)) + CMSG_SPACE(sizeof(uint32_t));
 
 Error from_errno(int code, std::string what)
 {
@@ -246,6 +260,16 @@ public:
         , bitrate_(options.bitrate)
         , listenOnly_(options.listenOnly)
     {
+        // Pointed once, here, because the channel never moves: it only ever
+        // lives behind the shared_ptr open() hands out.
+        for (size_t i = 0; i < kReceiveBatch; ++i)
+        {
+            rxIov_[i].iov_base = rxBuffers_[i].data();
+            rxIov_[i].iov_len = rxBuffers_[i].size();
+            rxMessages_[i].msg_hdr.msg_iov = &rxIov_[i];
+            rxMessages_[i].msg_hdr.msg_iovlen = 1;
+            rxMessages_[i].msg_hdr.msg_control = rxControl_[i].data();
+        }
     }
 
     ~SocketCanChannel() override
@@ -486,23 +510,33 @@ public:
         // through CanBridgeChannelStatus, which is where a hole in the capture
         // should be visible anyway.
         uint64_t undecodable = 0;
-
+        // Frames the kernel threw away because this socket's queue was full,
+        // from the running count SO_RXQ_OVFL attaches to each frame.
+        uint64_t overflowed = 0;
+
+        // ONE SYSCALL PER BATCH, NOT PER FRAME. recvmsg() a frame at a time was
+        // a syscall for every frame on the bus plus one more to find the queue
+        // empty; recvmmsg() takes up to kReceiveBatch at once into buffers
+        // that live as long as the channel, and a short batch is itself the
+        // news that the queue is drained, so the trailing EAGAIN is gone too.
+        // The buffers are members rather than locals because only one thread
+        // is ever in receive() -- see channel.h.
+        //
+        // can_socketcan_bench_receive --socketpair, on one core: 1.02-1.03
+        // syscalls a frame became 0.17-0.20. Reader CPU a frame did not move
+        // beyond the run-to-run noise there, so a vcan has the last word.
         while (count < out.size())
         {
-            std::array<uint8_t, kFdFrameSize> buffer {};
-            std::array<uint8_t, 64> control {};
-
-            iovec iov {};
-            iov.iov_base = buffer.data();
-            iov.iov_len = buffer.size();
-
-            msghdr message {};
-            message.msg_iov = &iov;
-            message.msg_iovlen = 1;
-            message.msg_control = control.data();
-            message.msg_controllen = control.size();
+            const size_t want = std::min(out.size() - count, kReceiveBatch);
+            for (size_t i = 0; i < want; ++i)
+            {
+                // The kernel writes back how much of each it used.
+                rxMessages_[i].msg_hdr.msg_controllen = kControlSize;
+                rxMessages_[i].msg_len = 0;
+            }
 
-            const ssize_t got = ::recvmsg(fd_, &message, MSG_DONTWAIT);
+            const int got = ::recvmmsg(fd_, rxMessages_.data(), static_cast<unsigned int>(want),
+                                       MSG_DONTWAIT, nullptr);
             if (got < 0)
             {
                 if (errno == EAGAIN || errno == EWOULDBLOCK)
@@ -516,40 +550,63 @@ public:
                 return std::unexpected(from_errno(errno, "cannot receive"));
             }
 
-            auto frame = decode_frame(std::span(buffer.data(), static_cast<size_t>(got)));
-            if (!frame.has_value())
+            for (size_t i = 0; i < static_cast<size_t>(got); ++i)
             {
-                ++undecodable;
-                continue;
-            }
+                msghdr& message = rxMessages_[i].msg_hdr;
+                auto frame = decode_frame(std::span(rxBuffers_[i].data(), rxMessages_[i].msg_len));
+                if (!frame.has_value())
+                {
+                    ++undecodable;
+                    continue;
+                }
 
-            // The kernel timestamps on arrival, which is closer to the wire
-            // than anything measured after the read returns.
-            for (cmsghdr* header = CMSG_FIRSTHDR(&message); header != nullptr;
-                 header = CMSG_NXTHDR(&message, header))
-            {
-                if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SO_TIMESTAMP)
+                for (cmsghdr* header = CMSG_FIRSTHDR(&message); header != nullptr;
+                     header = CMSG_NXTHDR(&message, header))
                 {
-                    timeval stamp {};
-                    std::memcpy(&stamp, CMSG_DATA(header), sizeof(stamp));
-                    frame->timestampUs = static_cast<uint64_t>(stamp.tv_sec) * 1000000ull
-                        + static_cast<uint64_t>(stamp.tv_usec);
+                    if (header->cmsg_level != SOL_SOCKET)
+                    {
+                        continue;
+                    }
+                    // The kernel timestamps on arrival, which is closer to the
+                    // wire than anything measured after the read returns.
+                    if (header->cmsg_type == SO_TIMESTAMP)
+                    {
+                        timeval stamp {};
+                        std::memcpy(&stamp, CMSG_DATA(header), sizeof(stamp));
+                        frame->timestampUs = static_cast<uint64_t>(stamp.tv_sec) * 1000000ull
+                            + static_cast<uint64_t>(stamp.tv_usec);
+                    }
+                    // The socket's drops so far, as of this frame. A 32-bit
+                    // running count, so the difference is taken modulo 2^32.
+                    else if (header->cmsg_type == SO_RXQ_OVFL)
+                    {
+                        uint32_t drops = 0;
+                        std::memcpy(&drops, CMSG_DATA(header), sizeof(drops));
+                        overflowed += drops - kernelDrops_;
+                        kernelDrops_ = drops;
+                    }
                 }
-            }
 
-            if (frame->isError)
-            {
-                ++errorFrames;
-                // An error frame's identifier carries the error class bits.
-                // This is the fallback for a kernel whose link reply has no
-                // xstats block; statistics() prefers the kernel's count.
-                if ((frame->id & CAN_ERR_BUSOFF) != 0)
+                if (frame->isError)
                 {
-                    ++busOffs;
+                    ++errorFrames;
+                    // An error frame's identifier carries the error class
+                    // bits. This is the fallback for a kernel whose link reply
+                    // has no xstats block; statistics() prefers the kernel's
+                    // count.
+                    if ((frame->id & CAN_ERR_BUSOFF) != 0)
+                    {
+                        ++busOffs;
+                    }
                 }
+                rxBytes += frame->len;
+                out[count++] = *frame;
+            }
+
+            if (static_cast<size_t>(got) < want)
+            {
+                break;
             }
-            rxBytes += frame->len;
-            out[count++] = *frame;
         }
 
         {
@@ -558,7 +615,7 @@ public:
             statistics_.rxBytes += rxBytes;
             statistics_.errorFrames += errorFrames;
             statistics_.busOffCount += busOffs;
-            statistics_.rxDropped += undecodable;
+            statistics_.rxDropped += undecodable + overflowed;
         }
 
         return count;
@@ -701,6 +758,14 @@ private:
     bool fdFrames_ { false };
     Statistics statistics_ {};
 
+    // receive()'s batch, and the last drop count the kernel reported. Touched
+    // by the receiving thread only.
+    std::array<std::array<uint8_t, kFdFrameSize>, kReceiveBatch> rxBuffers_ {};
+    std::array<std::array<uint8_t, kControlSize>, kReceiveBatch> rxControl_ {};
+    std::array<iovec, kReceiveBatch> rxIov_ {};
+    std::array<mmsghdr, kReceiveBatch> rxMessages_ {};
+    uint32_t kernelDrops_ { 0 };
+
     // Separate from stateMutex_ on purpose: statistics() does a netlink round
     // trip under that one, and the receive loop must not wait on a syscall to
     // record a frame it already has.
@@ -848,6 +913,45 @@ public:
                          std::strerror(errno));
         }
 
+        // FILTERS GO TO THE KERNEL. A frame no filter passes is dropped in
+        // softirq context and never queued on this socket, so a bridge that
+        // wants six identifiers off a bus carrying four hundred pays for six.
+        // Not best-effort: a refusal would hand the caller every frame on the
+        // bus while it believes it asked for a few. An empty list is not sent
+        // at all -- to the kernel, zero filters means receive nothing.
+        if (!options.rxFilters.empty())
+        {
+            if (options.rxFilters.size() > kMaxKernelFilters)
+            {
+                return invalid_argument(fmt::format(
+                    "{} receive filters for '{}'; the kernel takes at most {}",
+                    options.rxFilters.size(), id.device, kMaxKernelFilters));
+            }
+            std::vector<can_filter> filters;
+            filters.reserve(options.rxFilters.size());
+            for (const RxFilter& filter : options.rxFilters)
+            {
+                const KernelFilter kernel = to_kernel_filter(filter);
+                filters.push_back(can_filter { kernel.canId, kernel.canMask });
+            }
+            const auto bytes = static_cast<socklen_t>(filters.size() * sizeof(can_filter));
+            if (::setsockopt(fd, SOL_CAN_RAW, CAN_RAW_FILTER, filters.data(), bytes) < 0)
+            {
+                return std::unexpected(from_errno(
+                    errno, fmt::format("'{}' refused its receive filters", id.device)));
+            }
+        }
+
+        // The socket's drop count on every frame, which is the only way to
+        // learn the kernel discarded any: a full receive queue drops silently.
+        // Best-effort, because losing it costs the count and not the frames.
+        const int overflow = 1;
+        if (::setsockopt(fd, SOL_SOCKET, SO_RXQ_OVFL, &overflow, sizeof(overflow)) < 0)
+        {
+            SPDLOG_DEBUG("[socketcan] {} will not report queue overflows: {}", id.device,
+                         std::strerror(errno));
+        }
+
         // Kernel arrival timestamps. Best-effort: losing them costs accuracy
         // in the log, not correctness.
         const int stamp = 1;
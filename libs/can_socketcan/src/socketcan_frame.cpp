@@ -150,4 +150,13 @@ Result<helpers::CanFrame> decode_frame(std::span<const uint8_t> bytes)
     return frame;
 }
 
+KernelFilter to_kernel_filter(const RxFilter& filter)
+{
+    const uint32_t width = filter.extended ? kEffMask : kSffMask;
+    KernelFilter out;
+    out.canId = (filter.id & width) | (filter.extended ? kEffFlag : 0u);
+    out.canMask = (filter.mask & width) | kEffFlag;
+    return out;
+}
+
 } // namespace can::socketcan
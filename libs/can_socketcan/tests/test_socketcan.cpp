@@ -128,6 +128,70 @@ void test_extended_identifier()
           "an 11-bit frame does not set the EFF flag");
 }
 
+// The kernel's comparison, applied to the identifier word encode_frame() puts
+// on the wire, has to agree with can::passes() on every frame -- otherwise the
+// same filter list means one thing on SocketCAN and another on every other
+// backend. Both formats, RTR, and identifiers that differ only in the format.
+void test_kernel_filters_match_the_library()
+{
+    const std::vector<can::RxFilter> filters = {
+        { .id = 0x123, .mask = 0x7FF, .extended = false },
+        { .id = 0x400, .mask = 0x700, .extended = false },
+        { .id = 0x18FF0000, .mask = 0x1FFF0000, .extended = true },
+    };
+
+    struct Case
+    {
+        uint32_t id;
+        bool extended;
+        bool remote;
+    };
+    const Case cases[] = {
+        { 0x123, false, false }, { 0x123, false, true },  { 0x123, true, false },
+        { 0x124, false, false }, { 0x400, false, false }, { 0x4FF, false, false },
+        { 0x500, false, false }, { 0x400, true, false },  { 0x18FF1234, true, false },
+        { 0x18FE1234, true, false }, { 0x18FF1234 & 0x7FF, false, false },
+    };
+
+    size_t agreed = 0;
+    for (const Case& c : cases)
+    {
+        helpers::CanFrame frame {};
+        frame.id = c.id;
+        frame.isExtended = c.extended;
+        frame.isRTR = c.remote;
+
+        std::array<uint8_t, can::socketcan::kFdFrameSize> buffer {};
+        if (!can::socketcan::encode_frame(frame, buffer).has_value())
+        {
+            check(false, fmt::format("0x{:X} encodes", c.id));
+            continue;
+        }
+        const uint32_t word = get_u32(buffer, 0);
+
+        bool kernel = false;
+        for (const can::RxFilter& filter : filters)
+        {
+            const can::socketcan::KernelFilter k = can::socketcan::to_kernel_filter(filter);
+            kernel = kernel || (word & k.canMask) == (k.canId & k.canMask);
+        }
+        agreed += kernel == can::passes(filters, frame) ? 1 : 0;
+    }
+    check(agreed == std::size(cases), fmt::format("the kernel's filter agrees with the library's "
+                                                  "on every frame ({} of {})",
+                                                  agreed, std::size(cases)));
+
+    // The two that are easiest to get wrong, spelt out.
+    const auto standard = can::socketcan::to_kernel_filter({ .id = 0x123, .extended = false });
+    check(standard.canMask == (0x7FFu | can::socketcan::kEffFlag),
+          "an exact 11-bit filter compares the format bit and the 11 identifier bits");
+    check((standard.canMask & can::socketcan::kRtrFlag) == 0,
+          "and not the RTR bit, so remote frames for that identifier still pass");
+    const auto extended = can::socketcan::to_kernel_filter({ .id = 0x123, .extended = true });
+    check(extended.canId == (0x123u | can::socketcan::kEffFlag),
+          "an extended filter asks for the EFF flag to be set");
+}
+
 void test_error_frames()
 {
     // The kernel reports bus conditions as frames with the ERR bit set. A
@@ -775,6 +839,7 @@ int main()
     test_fd_frames();
     test_remote_frames();
     test_bad_reads_are_rejected();
+    test_kernel_filters_match_the_library();
 
     test_interface_name_validation();
     test_link_request_structure();
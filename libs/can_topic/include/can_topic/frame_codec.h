@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//
+// CAN frames on a zenoh topic: helpers::CanFrame to and from the CanFrame and
+// CanFrameBatch schemas.
+//
+// Every node that touches a CAN topic used to carry its own copy of the field
+// loop below, and they had drifted -- some dropped `extended`, some the
+// timestamp, all of them clamped the payload slightly differently. Batching
+// would have meant a second loop in each. So the conversion lives here once,
+// and both shapes of payload come out of forEachFrame() looking the same.
+//
+// No zenoh in this header. A payload is bytes plus the schema name the
+// publisher stamped on it, which is exactly what pub_sub::RawSubscriber and a
+// bag record hand over, so the same call serves a live subscriber and a
+// recording.
+#ifndef CAN_TOPIC_FRAME_CODEC_H
+#define CAN_TOPIC_FRAME_CODEC_H
+
+#include "can_frame.capnp.h"
+
+#include "helpers/can_frame.h"
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace can_topic
+{
+
+// The schema names a CAN payload is published under, as they appear after the
+// ';' of the encoding.
+inline constexpr std::string_view kFrameSchema = "CanFrame";
+inline constexpr std::string_view kBatchSchema = "CanFrameBatch";
+
+// Fills `builder` from `frame`. `channel` is written as-is, so pass an empty
+// one for a frame going into a batch -- the batch carries it once.
+void toMessage(const helpers::CanFrame& frame, std::string_view channel,
+               ::CanFrame::Builder builder);
+
+// The frame a message describes. The payload is clamped to what was actually
+// supplied: a publisher that set `len` past the end of `data` gets the shorter
+// length rather than a frame padded with bytes nobody sent.
+helpers::CanFrame fromMessage(::CanFrame::Reader message);
+
+// Fills `builder` with `frames`, in order, under one channel name.
+void toBatch(std::span<const helpers::CanFrame> frames, std::string_view channel,
+             ::CanFrameBatch::Builder builder);
+
+// Called once per frame. `channel` is the frame's own, or the batch's when the
+// frame came out of one; it is a view over the payload, valid for the call.
+using FrameVisitor = std::function<void(const helpers::CanFrame& frame, std::string_view channel)>;
+
+// Every frame in `payload`, which is a CanFrame or a CanFrameBatch according to
+// `schema_name`.
+//
+// Returns how many frames were visited, or nullopt when the payload is neither
+// schema, is not a whole number of capnp words, or is damaged -- in which case
+// the frames ahead of the damage have already been visited.
+//
+// An empty schema name is read as CanFrame, because that is what a publisher
+// that predates schema stamping sent -- and on a CAN topic it is the only thing
+// it can have sent.
+std::optional<size_t> forEachFrame(std::span<const std::uint8_t> payload,
+                                   std::string_view schema_name, const FrameVisitor& visit);
+
+// One frame as a standalone CanFrame payload -- the bytes a ZenohPublisher
+// would have put. For a consumer that has to turn a batch back into the
+// per-frame shape, which is what `bag record --unbatch-can` does.
+std::vector<std::uint8_t> encodeFrame(const helpers::CanFrame& frame, std::string_view channel);
+
+} // namespace can_topic
+
+#endif // CAN_TOPIC_FRAME_CODEC_H
@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//
+// A CAN topic, one frame at a time, whichever shape the publisher chose.
+//
+// can_bridge publishes per-frame CanFrame messages on `rx_key` and, when asked,
+// CanFrameBatch messages on `rx_batch_key`. A consumer that only wants frames
+// should not have to care which of the two it was pointed at, so this
+// subscribes to whatever key it is given and hands every frame to the handler
+// one by one -- a batch of forty arrives as forty calls, in order.
+//
+// Built on pub_sub::RawSubscriber rather than ZenohTypedSubscriber because the
+// schema name is the only thing that tells the two shapes apart, and the typed
+// subscriber never looks at it.
+#ifndef CAN_TOPIC_FRAME_SUBSCRIBER_H
+#define CAN_TOPIC_FRAME_SUBSCRIBER_H
+
+#include "helpers/can_frame.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace pub_sub
+{
+class RawSubscriber;
+}
+
+namespace can_topic
+{
+
+class FrameSubscriber
+{
+public:
+    // Runs on a zenoh RX thread, once per frame. Must not block. `channel` is
+    // a view valid for the call only.
+    using Handler = std::function<void(const helpers::CanFrame& frame, std::string_view channel)>;
+
+    FrameSubscriber(const std::string& key, Handler on_frame);
+
+    // Undeclares the subscription and joins any in-flight callback, so what
+    // the handler captures must outlive this -- declare it last.
+    ~FrameSubscriber();
+
+    FrameSubscriber(const FrameSubscriber&) = delete;
+    FrameSubscriber& operator=(const FrameSubscriber&) = delete;
+
+    bool isValid() const;
+
+    // Frames delivered, and payloads refused because they were not a CAN
+    // payload at all -- a misconfigured key is the usual cause, and it is
+    // logged once rather than once per sample.
+    uint64_t frames() const { return frames_.load(std::memory_order_relaxed); }
+    uint64_t rejected() const { return rejected_.load(std::memory_order_relaxed); }
+
+private:
+    Handler onFrame_;
+    std::atomic<uint64_t> frames_ { 0 };
+    std::atomic<uint64_t> rejected_ { 0 };
+    std::atomic<bool> warned_ { false };
+
+    // Last, so it is undeclared before the state its callback touches.
+    std::unique_ptr<pub_sub::RawSubscriber> subscriber_;
+};
+
+} // namespace can_topic
+
+#endif // CAN_TOPIC_FRAME_SUBSCRIBER_H
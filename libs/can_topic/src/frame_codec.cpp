@@ -0,0 +1,135 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "can_topic/frame_codec.h"
+
+#include "pub_sub/capnp_payload.h"
+
+#include <capnp/message.h>
+#include <capnp/serialize.h>
+
+#include <algorithm>
+
+namespace can_topic
+{
+
+void toMessage(const helpers::CanFrame& frame, std::string_view channel,
+               ::CanFrame::Builder builder)
+{
+    builder.setId(frame.id);
+    builder.setLen(frame.len);
+    builder.setExtended(frame.isExtended);
+    builder.setRtr(frame.isRTR);
+    builder.setFd(frame.isFD);
+    builder.setBrs(frame.isBRS);
+    builder.setEsi(frame.isESI);
+    builder.setError(frame.isError);
+    builder.setTimestampUs(frame.timestampUs);
+    if (!channel.empty())
+    {
+        builder.setChannel(capnp::Text::Reader(channel.data(), channel.size()));
+    }
+
+    const size_t n = std::min<size_t>(frame.data.size(), frame.len);
+    auto data = builder.initData(static_cast<unsigned>(n));
+    for (size_t i = 0; i < n; ++i)
+    {
+        data.set(static_cast<unsigned>(i), frame.data[i]);
+    }
+}
+
+helpers::CanFrame fromMessage(::CanFrame::Reader message)
+{
+    helpers::CanFrame frame;
+    frame.id = message.getId();
+    frame.isExtended = message.getExtended();
+    frame.isRTR = message.getRtr();
+    frame.isFD = message.getFd();
+    frame.isBRS = message.getBrs();
+    frame.isESI = message.getEsi();
+    frame.isError = message.getError();
+    frame.timestampUs = message.getTimestampUs();
+
+    const auto data = message.getData();
+    const size_t n = std::min<size_t>(frame.data.size(),
+                                      std::min<size_t>(message.getLen(), data.size()));
+    for (size_t i = 0; i < n; ++i)
+    {
+        frame.data[i] = data[static_cast<unsigned>(i)];
+    }
+    frame.len = static_cast<uint8_t>(n);
+    return frame;
+}
+
+void toBatch(std::span<const helpers::CanFrame> frames, std::string_view channel,
+             ::CanFrameBatch::Builder builder)
+{
+    if (!channel.empty())
+    {
+        builder.setChannel(capnp::Text::Reader(channel.data(), channel.size()));
+    }
+
+    auto list = builder.initFrames(static_cast<unsigned>(frames.size()));
+    for (size_t i = 0; i < frames.size(); ++i)
+    {
+        toMessage(frames[i], {}, list[static_cast<unsigned>(i)]);
+    }
+}
+
+std::optional<size_t> forEachFrame(std::span<const std::uint8_t> payload,
+                                   std::string_view schema_name, const FrameVisitor& visit)
+{
+    const bool single = schema_name.empty() || schema_name == kFrameSchema;
+    if (!single && schema_name != kBatchSchema)
+    {
+        return std::nullopt;
+    }
+
+    const pub_sub::WordAlignedPayload aligned(
+        reinterpret_cast<const kj::byte*>(payload.data()), payload.size());
+    if (aligned.empty())
+    {
+        return std::nullopt;
+    }
+
+    // capnp checks pointers lazily, so a damaged message throws from whichever
+    // getter first walks into the damage rather than from the constructor.
+    try
+    {
+        capnp::FlatArrayMessageReader reader(aligned.words());
+
+        if (single)
+        {
+            const auto message = reader.getRoot<::CanFrame>();
+            const auto channel = message.getChannel();
+            visit(fromMessage(message), std::string_view(channel.cStr(), channel.size()));
+            return 1;
+        }
+
+        const auto batch = reader.getRoot<::CanFrameBatch>();
+        const auto channel = batch.getChannel();
+        const std::string_view channelView(channel.cStr(), channel.size());
+
+        const auto frames = batch.getFrames();
+        for (const auto message : frames)
+        {
+            visit(fromMessage(message), channelView);
+        }
+        return frames.size();
+    }
+    catch (const kj::Exception&)
+    {
+        return std::nullopt;
+    }
+}
+
+std::vector<std::uint8_t> encodeFrame(const helpers::CanFrame& frame, std::string_view channel)
+{
+    capnp::MallocMessageBuilder message;
+    toMessage(frame, channel, message.initRoot<::CanFrame>());
+
+    const kj::Array<capnp::word> words = capnp::messageToFlatArray(message);
+    const auto bytes = words.asBytes();
+    return std::vector<std::uint8_t>(bytes.begin(), bytes.end());
+}
+
+} // namespace can_topic
@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "can_topic/frame_subscriber.h"
+
+#include "can_topic/frame_codec.h"
+
+#include "pub_sub/raw_subscriber.h"
+
+#include <spdlog/spdlog.h>
+
+namespace can_topic
+{
+
+FrameSubscriber::FrameSubscriber(const std::string& key, Handler on_frame)
+    : onFrame_(std::move(on_frame))
+{
+    subscriber_ = std::make_unique<pub_sub::RawSubscriber>(
+        key, pub_sub::RawSubscriber::Handler(
+                 [this, key](std::span<const std::uint8_t> payload,
+                             std::string_view schema_name)
+                 {
+                     const auto visited = forEachFrame(
+                         payload, schema_name,
+                         [this](const helpers::CanFrame& frame, std::string_view channel)
+                         { onFrame_(frame, channel); });
+
+                     if (!visited.has_value())
+                     {
+                         rejected_.fetch_add(1, std::memory_order_relaxed);
+                         if (!warned_.exchange(true))
+                         {
+                             SPDLOG_WARN("'{}' carried a '{}' payload of {} bytes, which is "
+                                         "neither a CanFrame nor a CanFrameBatch; ignoring it "
+                                         "and any more like it",
+                                         key, schema_name, payload.size());
+                         }
+                         return;
+                     }
+                     frames_.fetch_add(*visited, std::memory_order_relaxed);
+                 }));
+}
+
+FrameSubscriber::~FrameSubscriber() = default;
+
+bool FrameSubscriber::isValid() const
+{
+    return subscriber_ && subscriber_->isValid();
+}
+
+} // namespace can_topic
@@ -0,0 +1,241 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//
+// CAN frames to and from their two wire shapes.
+//
+// What is pinned is that a batch and the same frames sent one at a time are
+// indistinguishable to a consumer -- same frames, same order, same flags, same
+// channel -- and that a payload which is neither is refused rather than read as
+// a frame whose fields are all zero.
+
+#include "can_topic/frame_codec.h"
+
+#include <capnp/message.h>
+#include <capnp/serialize.h>
+#include <spdlog/spdlog.h>
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+int failures = 0;
+
+void expect(bool condition, const std::string& what)
+{
+    if (!condition)
+    {
+        SPDLOG_ERROR("FAIL: {}", what);
+        ++failures;
+    }
+}
+
+helpers::CanFrame make_frame(uint32_t id, uint8_t len, uint8_t seed)
+{
+    helpers::CanFrame frame;
+    frame.id = id;
+    frame.len = len;
+    for (uint8_t i = 0; i < len; ++i)
+    {
+        frame.data[i] = static_cast<uint8_t>(seed + i);
+    }
+    frame.timestampUs = 1000u * id;
+    return frame;
+}
+
+bool same(const helpers::CanFrame& a, const helpers::CanFrame& b)
+{
+    if (a.id != b.id || a.len != b.len || a.isExtended != b.isExtended || a.isFD != b.isFD
+        || a.isRTR != b.isRTR || a.isBRS != b.isBRS || a.isESI != b.isESI
+        || a.isError != b.isError || a.timestampUs != b.timestampUs)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < a.len; ++i)
+    {
+        if (a.data[i] != b.data[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<std::uint8_t> bytes_of(capnp::MallocMessageBuilder& message)
+{
+    const kj::Array<capnp::word> words = capnp::messageToFlatArray(message);
+    const auto bytes = words.asBytes();
+    return std::vector<std::uint8_t>(bytes.begin(), bytes.end());
+}
+
+void test_single_frame_round_trip()
+{
+    helpers::CanFrame frame = make_frame(0x18FF1234, 8, 0x10);
+    frame.isExtended = true;
+    frame.isError = false;
+
+    const auto payload = can_topic::encodeFrame(frame, "chassis");
+
+    std::vector<helpers::CanFrame> seen;
+    std::string channel;
+    const auto count = can_topic::forEachFrame(
+        payload, can_topic::kFrameSchema,
+        [&](const helpers::CanFrame& f, std::string_view c)
+        {
+            seen.push_back(f);
+            channel = std::string(c);
+        });
+
+    expect(count == 1u, "single: one frame visited");
+    expect(seen.size() == 1 && same(seen[0], frame), "single: and it is the frame sent");
+    expect(channel == "chassis", "single: with its channel");
+}
+
+void test_fd_flags_survive()
+{
+    helpers::CanFrame frame = make_frame(0x123, 64, 0);
+    frame.isFD = true;
+    frame.isBRS = true;
+    frame.isESI = true;
+
+    std::vector<helpers::CanFrame> seen;
+    can_topic::forEachFrame(can_topic::encodeFrame(frame, ""), can_topic::kFrameSchema,
+                            [&](const helpers::CanFrame& f, std::string_view) { seen.push_back(f); });
+
+    expect(seen.size() == 1 && same(seen[0], frame),
+           "fd: a 64-byte frame keeps its payload and its FD, BRS and ESI flags");
+}
+
+void test_batch_matches_frames()
+{
+    std::vector<helpers::CanFrame> frames;
+    for (uint32_t i = 0; i < 40; ++i)
+    {
+        frames.push_back(make_frame(0x600 + i, static_cast<uint8_t>(i % 9), static_cast<uint8_t>(i)));
+    }
+    frames[3].isRTR = true;
+    frames[7].isError = true;
+
+    capnp::MallocMessageBuilder message;
+    can_topic::toBatch(frames, "can0", message.initRoot<::CanFrameBatch>());
+    const auto payload = bytes_of(message);
+
+    std::vector<helpers::CanFrame> seen;
+    bool channelsAgree = true;
+    const auto count = can_topic::forEachFrame(
+        payload, can_topic::kBatchSchema,
+        [&](const helpers::CanFrame& f, std::string_view c)
+        {
+            seen.push_back(f);
+            channelsAgree = channelsAgree && c == "can0";
+        });
+
+    expect(count == frames.size(), "batch: every frame visited");
+    bool inOrder = seen.size() == frames.size();
+    for (size_t i = 0; inOrder && i < frames.size(); ++i)
+    {
+        inOrder = same(seen[i], frames[i]);
+    }
+    expect(inOrder, "batch: in the order they were packed, each one intact");
+    expect(channelsAgree, "batch: each frame reports the batch's channel");
+
+    // And the batch is smaller than the same frames sent one at a time, which
+    // is the point of it -- each standalone message repeats the segment table
+    // and root pointer, and each one is a separate put.
+    size_t separate = 0;
+    for (const auto& frame : frames)
+    {
+        separate += can_topic::encodeFrame(frame, "can0").size();
+    }
+    expect(payload.size() < separate, "batch: fewer bytes than the frames sent separately");
+}
+
+void test_empty_batch()
+{
+    capnp::MallocMessageBuilder message;
+    can_topic::toBatch({}, "can0", message.initRoot<::CanFrameBatch>());
+
+    size_t calls = 0;
+    const auto count = can_topic::forEachFrame(bytes_of(message), can_topic::kBatchSchema,
+                                               [&](const helpers::CanFrame&, std::string_view)
+                                               { ++calls; });
+    expect(count == 0u && calls == 0, "empty batch: accepted, and visits nothing");
+}
+
+void test_unstamped_is_a_frame()
+{
+    const helpers::CanFrame frame = make_frame(0x7E8, 3, 0x40);
+
+    size_t calls = 0;
+    const auto count = can_topic::forEachFrame(can_topic::encodeFrame(frame, ""), "",
+                                               [&](const helpers::CanFrame& f, std::string_view)
+                                               {
+                                                   ++calls;
+                                                   expect(same(f, frame),
+                                                          "unstamped: decoded as a CanFrame");
+                                               });
+    expect(count == 1u && calls == 1,
+           "unstamped: a payload with no schema name on a CAN topic is a CanFrame");
+}
+
+void test_refusals()
+{
+    const auto payload = can_topic::encodeFrame(make_frame(0x100, 8, 0), "");
+
+    size_t calls = 0;
+    const can_topic::FrameVisitor count_calls
+        = [&](const helpers::CanFrame&, std::string_view) { ++calls; };
+
+    expect(!can_topic::forEachFrame(payload, "EngineRpm", count_calls).has_value(),
+           "refused: a payload stamped with another schema");
+
+    std::vector<std::uint8_t> partial(payload.begin(), payload.end() - 3);
+    expect(!can_topic::forEachFrame(partial, can_topic::kFrameSchema, count_calls).has_value(),
+           "refused: a payload that is not a whole number of words");
+
+    expect(!can_topic::forEachFrame({}, can_topic::kBatchSchema, count_calls).has_value(),
+           "refused: an empty payload");
+
+    expect(calls == 0, "refused: and none of them reached the visitor");
+}
+
+void test_overlong_len_is_clamped()
+{
+    // A publisher that claims eight bytes and supplies two.
+    capnp::MallocMessageBuilder message;
+    auto builder = message.initRoot<::CanFrame>();
+    builder.setId(0x321);
+    builder.setLen(8);
+    auto data = builder.initData(2);
+    data.set(0, 0xAA);
+    data.set(1, 0xBB);
+
+    const auto frame = can_topic::fromMessage(builder.asReader());
+    expect(frame.len == 2, "clamp: len is what was supplied, not what was claimed");
+    expect(frame.data[0] == 0xAA && frame.data[1] == 0xBB && frame.data[2] == 0,
+           "clamp: and nothing past it is invented");
+}
+
+} // namespace
+
+int main()
+{
+    spdlog::set_level(spdlog::level::warn);
+
+    test_single_frame_round_trip();
+    test_fd_flags_survive();
+    test_batch_matches_frames();
+    test_empty_batch();
+    test_unstamped_is_a_frame();
+    test_refusals();
+    test_overlong_len_is_clamped();
+
+    if (failures == 0)
+    {
+        SPDLOG_INFO("can_topic codec tests passed");
+        return EXIT_SUCCESS;
+    }
+    SPDLOG_ERROR("{} check(s) failed", failures);
+    return EXIT_FAILURE;
+}
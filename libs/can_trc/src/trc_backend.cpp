@@ -13,6 +13,7 @@
 #include <mutex>
 #include <optional>
 #include <string>
+#include <vector>
 
 namespace can::trc
 {
@@ -30,12 +31,13 @@ class TrcChannel : public Channel
 {
 public:
     TrcChannel(ChannelId id, std::string path, ReplayOptions options, Bitrate bitrate,
-               bool listenOnly)
+               bool listenOnly, std::vector<RxFilter> rxFilters)
         : id_ { std::move(id) }
         , path_ { std::move(path) }
         , options_ { options }
         , bitrate_ { bitrate }
         , listenOnly_ { listenOnly }
+        , rxFilters_ { std::move(rxFilters) }
         , description_ { fmt::format("TRC replay of {}", path_) }
     {
     }
@@ -286,6 +288,14 @@ private:
             }
             lastOffsetUs_ = value.offsetUs;
 
+            // After the loop bookkeeping, which has to see every record the
+            // pass covers, and before pacing, so a filtered-out record costs
+            // no wait.
+            if (!passes(rxFilters_, value.frame))
+            {
+                continue;
+            }
+
             value.frame.timestampUs = replayEpochUs_ + (value.offsetUs - firstOffsetUs_);
             pending_ = std::move(value);
             return true;
@@ -309,6 +319,7 @@ private:
     ReplayOptions options_;
     Bitrate bitrate_;
     bool listenOnly_ { false };
+    const std::vector<RxFilter> rxFilters_;
     std::string description_;
 
     mutable std::mutex mutex_;
@@ -364,7 +375,7 @@ public:
         }
 
         auto channel = std::make_shared<TrcChannel>(id, id.device, options_, options.bitrate,
-                                                    options.listenOnly);
+                                                    options.listenOnly, options.rxFilters);
         if (options.start)
         {
             auto started = channel->start();
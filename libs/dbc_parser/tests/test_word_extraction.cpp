@@ -0,0 +1,155 @@
+// The word path in the generated extract_bits()/insert_bits() against the
+// bitwise walk it replaced, signal by signal, over every DBC we generate code
+// for -- the synthetic sweep and the vendor files under dbcs/.
+//
+// Nothing here pins a decoded value, which is why the vendor files are fair
+// game where test_golden's rule keeps them out: the only claim is that the two
+// paths agree, and that stays true whatever a vendor file is edited to say. A
+// signal added to one is simply one more signal checked.
+//
+// Both directions are compared. Insertion starts from a buffer of noise rather
+// than zeroes, so a word store that clobbered a neighbour's bits in a shared
+// byte shows up as a difference.
+
+#include "dbc_test_features.h"
+#include "dbc_test_layout.h"
+#include "dbc_test_scaling.h"
+
+#include "dbc_megasquirt_dash_data.h"
+#include "dbc_megasquirt_realtime_data.h"
+#include "dbc_motec_e888_rev1.h"
+#include "dbc_motec_ltc_rev1.h"
+#include "dbc_motec_m1_rev3.h"
+#include "dbc_motec_pdm_generic_output.h"
+#include "dbc_msel_master_relay.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+
+// Enough to hit every bit of every signal both ways many times over; a frame
+// is at most 64 bytes, so this stays well under a second for all of them.
+constexpr int kRoundsPerSignal = 256;
+
+struct Tally
+{
+    size_t signals = 0;
+    int failures = 0;
+};
+
+template <typename Message, typename Sig>
+void compareSignal(std::mt19937_64 &rng, Tally &tally, std::string_view database)
+{
+    tally.signals += 1;
+
+    std::vector<uint8_t> frame(Message::dlc);
+    std::vector<uint8_t> viaWord(Message::dlc);
+    std::vector<uint8_t> viaBits(Message::dlc);
+
+    for (int round = 0; round < kRoundsPerSignal; ++round)
+    {
+        for (auto &byte : frame)
+        {
+            byte = static_cast<uint8_t>(rng());
+        }
+
+        const uint64_t word = Message::template extract_bits<Sig>(frame);
+        const uint64_t bits = Message::template extract_bits_bitwise<Sig>(frame);
+        if (word != bits)
+        {
+            std::fprintf(stderr, "FAIL: %.*s %.*s.%.*s extract: word %#llx, bitwise %#llx\n",
+                         static_cast<int>(database.size()), database.data(),
+                         static_cast<int>(Message::name.size()), Message::name.data(),
+                         static_cast<int>(Sig::name.size()), Sig::name.data(),
+                         static_cast<unsigned long long>(word),
+                         static_cast<unsigned long long>(bits));
+            tally.failures += 1;
+            return;
+        }
+
+        // Wider than the signal on purpose: both paths must ignore the excess.
+        const uint64_t raw = rng();
+        viaWord = frame;
+        viaBits = frame;
+        Message::template insert_bits<Sig>(viaWord, raw);
+        Message::template insert_bits_bitwise<Sig>(viaBits, raw);
+        if (viaWord != viaBits)
+        {
+            std::fprintf(stderr, "FAIL: %.*s %.*s.%.*s insert of %#llx differs\n",
+                         static_cast<int>(database.size()), database.data(),
+                         static_cast<int>(Message::name.size()), Message::name.data(),
+                         static_cast<int>(Sig::name.size()), Sig::name.data(),
+                         static_cast<unsigned long long>(raw));
+            tally.failures += 1;
+            return;
+        }
+    }
+}
+
+template <typename Database>
+int compareDatabase()
+{
+    // Seeded per database, so a failure reproduces exactly and adding a
+    // database does not change the payloads another one sees.
+    std::mt19937_64 rng(std::hash<std::string_view>{}(Database::name));
+    Tally tally;
+    size_t messages = 0;
+
+    Database db;
+    for (const uint32_t id : Database::message_ids)
+    {
+        messages += 1;
+        db.visit_message(static_cast<typename Database::Messages>(id),
+                         [&](auto &message)
+                         {
+                             using Message = std::remove_cvref_t<decltype(message)>;
+                             message.visit(
+                                 [&](auto &, auto sig)
+                                 {
+                                     compareSignal<Message, decltype(sig)>(rng, tally,
+                                                                           Database::name);
+                                 });
+                         });
+    }
+
+    std::printf("%.*s: %zu messages, %zu signals, %d failures\n",
+                static_cast<int>(Database::name.size()), Database::name.data(), messages,
+                tally.signals, tally.failures);
+    return tally.failures;
+}
+
+} // namespace
+
+int main()
+{
+    int failures = 0;
+
+    failures += compareDatabase<dbc_test_layout::dbc_test_layout_t>();
+    failures += compareDatabase<dbc_test_scaling::dbc_test_scaling_t>();
+    failures += compareDatabase<dbc_test_features::dbc_test_features_t>();
+
+    failures += compareDatabase<dbc_megasquirt_dash_data::dbc_megasquirt_dash_data_t>();
+    failures += compareDatabase<dbc_megasquirt_realtime_data::dbc_megasquirt_realtime_data_t>();
+    failures += compareDatabase<dbc_motec_e888_rev1::dbc_motec_e888_rev1_t>();
+    failures += compareDatabase<dbc_motec_ltc_rev1::dbc_motec_ltc_rev1_t>();
+    failures += compareDatabase<dbc_motec_m1_rev3::dbc_motec_m1_rev3_t>();
+    failures += compareDatabase<dbc_motec_pdm_generic_output::dbc_motec_pdm_generic_output_t>();
+    failures += compareDatabase<dbc_msel_master_relay::dbc_msel_master_relay_t>();
+
+    if (failures != 0)
+    {
+        std::fprintf(stderr, "\n%d signal(s) where the word path and the bitwise walk disagree\n",
+                     failures);
+        return 1;
+    }
+
+    return 0;
+}
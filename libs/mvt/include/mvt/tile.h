@@ -25,7 +25,9 @@
 #define MVT_TILE_H
 
 #include <cstdint>
+#include <initializer_list>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
 #include <variant>
@@ -128,9 +130,23 @@ struct Tile
 // positive is an exterior ring, negative is a hole. Returned undoubled-and-
 // unhalved because the halving is pure loss for a sign test, and because the
 // doubled value stays an exact integer.
-std::int64_t signedArea2(const std::vector<Point>& ring);
+//
+// Over a span, so a ring decoded into mvt::Rings (mvt/view.h) is tested where it
+// lies. A std::vector<Point> converts; the initializer_list overloads are for a
+// ring written out inline, which a span cannot be built from.
+std::int64_t signedArea2(std::span<const Point> ring);
+
+inline std::int64_t signedArea2(std::initializer_list<Point> ring)
+{
+    return signedArea2(std::span<const Point>(ring.begin(), ring.size()));
+}
+
+inline bool isExteriorRing(std::span<const Point> ring)
+{
+    return signedArea2(ring) > 0;
+}
 
-inline bool isExteriorRing(const std::vector<Point>& ring)
+inline bool isExteriorRing(std::initializer_list<Point> ring)
 {
     return signedArea2(ring) > 0;
 }
@@ -0,0 +1,273 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//
+// A vector tile read in place, a layer and a feature at a time.
+//
+// decode() builds the whole tree up front: every layer, every feature, a vector
+// per ring and a std::string per value, whether or not anything reads them. The
+// widget reads a fraction -- the tessellator skips layers the style or the zoom
+// switches off, the label pass reads four layers and ignores the geometry of
+// most features in them -- and a sample of its tile-load path was dominated by
+// the allocator rather than by anything that parses. These views are the other
+// trade: nothing is decoded until it is asked for, and what is decoded points
+// back into the caller's bytes rather than copying out of them.
+//
+//   * TileView::open() finds the layers and their names, and nothing else.
+//   * TileView::layer() indexes one layer on first ask: its keys and values,
+//     ONCE, as views, and a small record per feature. The geometry of every
+//     feature is still bytes.
+//   * A feature's geometry is walked with a GeometryCursor, which allocates
+//     nothing, or decoded into a Rings the caller reuses from one feature to
+//     the next -- so a warm tessellation of a tile allocates per layer, not
+//     per ring.
+//
+// EVERYTHING HERE BORROWS THE BUFFER. A view outlives the bytes it was opened
+// on exactly as long as a string_view outlives its string; keep the inflated
+// tile alive for as long as anything reads through a view of it.
+//
+// Errors move with the work. open() refuses a buffer whose top level does not
+// parse, but a layer nobody asks for is never read, so a malformed one costs
+// nothing -- where decode() would have refused the whole tile for it. What is
+// read and found broken is recorded on the TileView (see error()), so a caller
+// can still treat the tile as bad.
+//
+// The same traps as decode.h, with the same answers: extent per layer with a
+// default of 4096, a cursor that persists across geometry commands, unknown
+// fields skipped, tag indices checked against the layer's tables before any
+// lookup can trust them.
+#ifndef MVT_VIEW_H
+#define MVT_VIEW_H
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "mvt/error.h"
+#include "mvt/reader.h"
+#include "mvt/tile.h"
+
+namespace mvt
+{
+
+// mvt::Value with the string left in the buffer. Same alternatives in the same
+// order, so code that asks std::get_if<double> of one reads the other.
+using ValueView = std::variant<std::monostate, std::string_view, double, std::int64_t, bool>;
+
+std::string valueToString(const ValueView& value);
+
+// One step of a feature's geometry: a point reached by MoveTo or LineTo, or a
+// ClosePath (whose point is where the cursor already was).
+struct GeometryStep
+{
+    enum class Command : std::uint8_t
+    {
+        MoveTo,
+        LineTo,
+        ClosePath,
+    };
+
+    Command command { Command::MoveTo };
+    Point point;
+};
+
+// The command stream, one point at a time, without allocating.
+//
+// This is the part of the format that is easy to get wrong, and it is written
+// once: decode() builds its rings from this too. The cursor PERSISTS across
+// commands -- every parameter is a delta from the last point of any command,
+// not of this one -- and a count of N repeats the command N times, which for
+// a MoveTo means N separate parts.
+class GeometryCursor
+{
+  public:
+    explicit GeometryCursor(std::span<const std::uint8_t> bytes) : mReader(bytes) {}
+
+    bool done() const { return mRepeats == 0 && mReader.done(); }
+
+    // The next step. Only call when !done().
+    Result<GeometryStep> next();
+
+    // Points still to come from the command that produced the last step. A
+    // consumer that builds a ring can reserve for them in one go.
+    std::uint64_t repeats() const { return mRepeats; }
+    std::size_t remainingBytes() const { return mReader.remaining(); }
+
+    // Where in the geometry bytes the current command began, for an error
+    // message that has to say where.
+    std::size_t commandOffset() const { return mCommandAt; }
+
+  private:
+    Reader mReader;
+    std::uint32_t mCommand { 0 };
+    std::uint64_t mRepeats { 0 };
+    // int64 so a run of deltas can be checked for leaving int32 before it is
+    // narrowed, rather than overflowing -- see decode.h.
+    std::int64_t mX { 0 };
+    std::int64_t mY { 0 };
+    std::size_t mTotal { 0 };
+    std::size_t mCommandAt { 0 };
+};
+
+// A feature's rings, as spans over one flat buffer that the CALLER keeps.
+//
+// The point of it is reuse. A tessellator that declares one of these outside
+// its feature loop decodes every ring of every feature into the same two
+// vectors, which stop growing after the first few features of a tile -- where
+// vector<vector<Point>> was an allocation per ring, per feature, per tile.
+class Rings
+{
+  public:
+    class Iterator
+    {
+      public:
+        Iterator(const Rings* rings, std::size_t at) : mRings(rings), mAt(at) {}
+        std::span<const Point> operator*() const { return (*mRings)[mAt]; }
+        Iterator& operator++()
+        {
+            ++mAt;
+            return *this;
+        }
+        friend bool operator==(const Iterator&, const Iterator&) = default;
+
+      private:
+        const Rings* mRings;
+        std::size_t mAt;
+    };
+
+    std::size_t size() const { return mEnds.size(); }
+    bool empty() const { return mEnds.empty(); }
+
+    std::span<const Point> operator[](std::size_t i) const
+    {
+        const std::uint32_t begin = (i == 0) ? 0U : mEnds[i - 1];
+        return { mPoints.data() + begin, mEnds[i] - begin };
+    }
+    std::span<const Point> front() const { return (*this)[0]; }
+
+    Iterator begin() const { return { this, 0 }; }
+    Iterator end() const { return { this, mEnds.size() }; }
+
+    // Forget the rings and keep the storage.
+    void clear()
+    {
+        mPoints.clear();
+        mEnds.clear();
+    }
+
+  private:
+    friend struct FeatureView;
+
+    std::vector<Point> mPoints;
+    // One past each ring's last point, in mPoints.
+    std::vector<std::uint32_t> mEnds;
+};
+
+// One feature, as indexed by its layer. Its geometry is still the wire bytes;
+// its tags are in the layer's table (LayerView::tags).
+struct FeatureView
+{
+    std::uint64_t id { 0 };
+    bool hasId { false };
+    GeomType type { GeomType::Unknown };
+
+    std::span<const std::uint8_t> geometry;
+
+    std::uint32_t tagStart { 0 };
+    std::uint32_t tagCount { 0 };
+
+    GeometryCursor cursor() const { return GeometryCursor(geometry); }
+
+    // Every ring, into `out`, replacing what it held. The same rules as
+    // decode(): a MoveTo starts a part, ClosePath closes one without repeating
+    // its first point, and a polygon ring under three points is malformed.
+    Result<void> rings(Rings& out) const;
+};
+
+// One layer: its tables decoded once, its features indexed, nothing else.
+//
+// The members mirror mvt::Layer, and so does the lookup API, so code that read
+// a decoded tile reads a view with the types changed and little else.
+struct LayerView
+{
+    std::string_view name;
+    std::uint32_t version { 1 };
+    // Per layer, default 4096. See mvt/tile.h.
+    std::uint32_t extent { 4096 };
+
+    // Interned: every feature's tags index these, so a tile with thousands of
+    // `class: minor` roads holds the word once -- and as a view, not a copy.
+    std::vector<std::string_view> keys;
+    std::vector<ValueView> values;
+    std::vector<FeatureView> features;
+
+    // Read a layer message. Validates what Layer validation does -- extent,
+    // whole tag pairs, tag indices in range -- and decodes no geometry.
+    static Result<LayerView> index(std::span<const std::uint8_t> bytes);
+
+    // The feature's (key, value) index pairs.
+    std::span<const std::uint32_t> tags(const FeatureView& feature) const
+    {
+        return std::span<const std::uint32_t>(mTags).subspan(feature.tagStart, feature.tagCount);
+    }
+
+    // As mvt::Layer's: a pointer into `values`, null when the feature does
+    // not carry the key.
+    const ValueView* attributeRef(const FeatureView& feature, std::string_view key) const;
+
+    // A string attribute, or empty -- see Layer::attributeTextView. Points
+    // into the tile buffer, so it allocates nothing and lives as long as that.
+    std::string_view attributeTextView(const FeatureView& feature, std::string_view key) const;
+
+    // Any attribute as text, copied. For the places that keep the string.
+    std::string attributeText(const FeatureView& feature, std::string_view key) const;
+
+  private:
+    // Every feature's tags, back to back. One table rather than a vector per
+    // feature, which would be the allocation per feature this exists to avoid.
+    std::vector<std::uint32_t> mTags;
+};
+
+class TileView
+{
+  public:
+    // Find the layers. An empty buffer is an empty tile; a still-compressed
+    // one is refused by name, as decode() does.
+    static Result<TileView> open(std::span<const std::uint8_t> bytes);
+
+    std::size_t layerCount() const { return mLayers.size(); }
+    std::string_view layerName(std::size_t i) const { return mLayers[i].name; }
+
+    // The named layer, indexed on the first ask and kept. Null when the tile
+    // has no such layer -- or has one that does not parse, which is recorded
+    // in error() rather than returned, so a caller walking the layers it wants
+    // needs one null check rather than two.
+    //
+    // Not const, and not thread-safe: the first ask writes the index. A tile
+    // is read by the one worker that inflated it.
+    const LayerView* layer(std::string_view name);
+
+    // The first thing found malformed while reading through this view -- by
+    // layer(), or by a consumer that met a feature it could not decode and
+    // said so with flag(). Empty when everything read so far was sound.
+    const std::optional<Error>& error() const { return mError; }
+    void flag(Error error);
+
+  private:
+    struct Entry
+    {
+        std::string_view name;
+        std::span<const std::uint8_t> bytes;
+        std::optional<LayerView> indexed;
+        bool tried { false };
+    };
+
+    std::vector<Entry> mLayers;
+    std::optional<Error> mError;
+};
+
+} // namespace mvt
+
+#endif // MVT_VIEW_H
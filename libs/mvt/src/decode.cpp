@@ -4,9 +4,9 @@
 #include <algorithm>
 
 #include "mvt/reader.h"
+#include "mvt/view.h"
+#include "wire.h"
 
-#include <cstring>
-#include <limits>
 #include <utility>
 
 namespace mvt
@@ -14,273 +14,41 @@ namespace mvt
 namespace
 {
 
-// Field numbers from the vector_tile.proto (MVT 2.1). Written out rather than
-// left as literals at the switch sites, because a wrong number does not fail --
-// it reads a different field and yields a tile that is merely wrong.
-namespace tile_field
-{
-constexpr std::uint32_t kLayer = 3;
-}
-
-namespace layer_field
-{
-constexpr std::uint32_t kName = 1;
-constexpr std::uint32_t kFeature = 2;
-constexpr std::uint32_t kKey = 3;
-constexpr std::uint32_t kValue = 4;
-constexpr std::uint32_t kExtent = 5;
-// 15, not 6. The spec puts version last on purpose so it survives a reader
-// that stops early, and the gap is the single most likely thing to mistype.
-constexpr std::uint32_t kVersion = 15;
-}
-
-namespace feature_field
-{
-constexpr std::uint32_t kId = 1;
-constexpr std::uint32_t kTags = 2;
-constexpr std::uint32_t kType = 3;
-constexpr std::uint32_t kGeometry = 4;
-}
-
-namespace value_field
-{
-constexpr std::uint32_t kString = 1;
-constexpr std::uint32_t kFloat = 2;
-constexpr std::uint32_t kDouble = 3;
-constexpr std::uint32_t kInt64 = 4;
-constexpr std::uint32_t kUint64 = 5;
-constexpr std::uint32_t kSint64 = 6;
-constexpr std::uint32_t kBool = 7;
-}
-
-// Geometry command ids.
-constexpr std::uint32_t kMoveTo = 1;
-constexpr std::uint32_t kLineTo = 2;
-constexpr std::uint32_t kClosePath = 7;
-
-// A tile with more geometry than this is not a tile we can have produced, and
-// decoding it would let a malformed length allocate without bound. The largest
-// tile in the SoCal archive is ~300 kB; a million points is far above anything
-// real and far below anything dangerous.
-constexpr std::size_t kMaxPointsPerFeature = 1'000'000;
-
-Result<Value> decodeValue(Reader reader)
-{
-    Value out;
-
-    while (!reader.done())
-    {
-        auto field = reader.field();
-        if (!field)
-        {
-            return std::unexpected(field.error());
-        }
-
-        switch (field->number)
-        {
-            case value_field::kString:
-            {
-                auto text = reader.text();
-                if (!text)
-                {
-                    return std::unexpected(text.error());
-                }
-                out = std::string(*text);
-                break;
-            }
-
-            case value_field::kFloat:
-            {
-                auto raw = reader.fixed32();
-                if (!raw)
-                {
-                    return std::unexpected(raw.error());
-                }
-                float value = 0.0F;
-                static_assert(sizeof(value) == sizeof(std::uint32_t));
-                std::memcpy(&value, &*raw, sizeof(value));
-                out = static_cast<double>(value);
-                break;
-            }
-
-            case value_field::kDouble:
-            {
-                auto raw = reader.fixed64();
-                if (!raw)
-                {
-                    return std::unexpected(raw.error());
-                }
-                double value = 0.0;
-                static_assert(sizeof(value) == sizeof(std::uint64_t));
-                std::memcpy(&value, &*raw, sizeof(value));
-                out = value;
-                break;
-            }
-
-            case value_field::kInt64:
-            case value_field::kUint64:
-            {
-                auto raw = reader.varint();
-                if (!raw)
-                {
-                    return std::unexpected(raw.error());
-                }
-                out = static_cast<std::int64_t>(*raw);
-                break;
-            }
-
-            case value_field::kSint64:
-            {
-                auto raw = reader.zigzag();
-                if (!raw)
-                {
-                    return std::unexpected(raw.error());
-                }
-                out = *raw;
-                break;
-            }
-
-            case value_field::kBool:
-            {
-                auto raw = reader.varint();
-                if (!raw)
-                {
-                    return std::unexpected(raw.error());
-                }
-                out = (*raw != 0);
-                break;
-            }
-
-            default:
-            {
-                // Unknown fields are SKIPPED, not rejected. That is the
-                // forward-compatibility rule in the spec, and a decoder that
-                // errors here breaks on the next revision of a format it would
-                // otherwise have read perfectly well.
-                auto skipped = reader.skip(field->wire);
-                if (!skipped)
-                {
-                    return std::unexpected(skipped.error());
-                }
-                break;
-            }
-        }
-    }
-
-    return out;
-}
-
 // The geometry command stream: the one genuinely unusual part of the format.
 //
 // A packed uint32 array where each "command integer" is (id | count << 3),
 // followed by count * (2 for MoveTo/LineTo, 0 for ClosePath) zigzag varints.
 // Coordinates are DELTAS from the previous point, and the cursor persists
 // across commands -- so a decoder that resets it per command produces geometry
-// collapsed onto the origin.
-Result<std::vector<std::vector<Point>>> decodeGeometry(Reader reader, GeomType type)
+// collapsed onto the origin. GeometryCursor (mvt/view.h) owns all of that; this
+// only decides where one ring ends.
+Result<std::vector<std::vector<Point>>> decodeGeometry(std::span<const std::uint8_t> bytes,
+                                                       GeomType type)
 {
     std::vector<std::vector<Point>> rings;
     std::vector<Point> current;
 
-    std::int64_t cursorX = 0;
-    std::int64_t cursorY = 0;
-    std::size_t totalPoints = 0;
-
-    while (!reader.done())
+    GeometryCursor cursor(bytes);
+    while (!cursor.done())
     {
-        const std::size_t at = reader.offset();
-
-        auto command = reader.varint();
-        if (!command)
-        {
-            return std::unexpected(command.error());
-        }
-
-        const std::uint32_t id = static_cast<std::uint32_t>(*command) & 0x07U;
-        const std::uint64_t count = *command >> 3;
-
-        if (id == kClosePath)
-        {
-            // ClosePath takes a count but no parameters, and the spec fixes the
-            // count at 1. The ring is closed implicitly -- the first point is
-            // NOT repeated, which is why signedArea2 wraps with a modulo.
-            if (count != 1)
-            {
-                return malformed("ClosePath with count " + std::to_string(count), at);
-            }
-            if (current.empty())
-            {
-                return malformed("ClosePath with no open ring", at);
-            }
-            rings.push_back(std::move(current));
-            current.clear();
-            continue;
-        }
-
-        if (id != kMoveTo && id != kLineTo)
+        auto step = cursor.next();
+        if (!step)
         {
-            return malformed("geometry command id " + std::to_string(id), at);
+            return std::unexpected(step.error());
         }
 
-        if (count == 0)
+        switch (step->command)
         {
-            return malformed("geometry command with zero count", at);
-        }
-
-        totalPoints += static_cast<std::size_t>(count);
-        if (totalPoints > kMaxPointsPerFeature)
-        {
-            return malformed("feature claims more than " +
-                                 std::to_string(kMaxPointsPerFeature) + " points",
-                             at);
-        }
-
-        // RESERVE, because this is where the decoder spends its time. A sample
-        // of the widget's tile-load path showed the allocator -- malloc, free,
-        // memset -- outweighing every parsing symbol in it: the points of a
-        // ring were being appended one at a time into a vector that regrew as
-        // it went, once per ring, once per feature, once per tile.
-        //
-        // Bounded twice over, because `count` comes off disk: the cumulative
-        // check above caps it at kMaxPointsPerFeature, and each point costs at
-        // least two bytes of varint, so a truncated tile claiming a huge count
-        // cannot make us reserve more than the bytes that are actually left.
-        // Only for LineTo -- a MoveTo may flush and start a new ring per point.
-        if (id == kLineTo)
-        {
-            const std::size_t possible = std::min<std::size_t>(
-                static_cast<std::size_t>(count), reader.remaining() / 2U);
-            current.reserve(current.size() + possible);
-        }
-
-        for (std::uint64_t i = 0; i < count; ++i)
-        {
-            auto dx = reader.zigzag();
-            if (!dx)
-            {
-                return std::unexpected(dx.error());
-            }
-            auto dy = reader.zigzag();
-            if (!dy)
-            {
-                return std::unexpected(dy.error());
-            }
-
-            // Accumulated in int64 and range-checked before narrowing. The
-            // deltas are attacker-controlled in the sense that they come off
-            // disk, and int32 overflow here is UB rather than a wrong pixel.
-            cursorX += *dx;
-            cursorY += *dy;
-            if (cursorX < std::numeric_limits<std::int32_t>::min() ||
-                cursorX > std::numeric_limits<std::int32_t>::max() ||
-                cursorY < std::numeric_limits<std::int32_t>::min() ||
-                cursorY > std::numeric_limits<std::int32_t>::max())
-            {
-                return malformed("geometry cursor left int32 range", at);
-            }
+            case GeometryStep::Command::ClosePath:
+                if (current.empty())
+                {
+                    return malformed("ClosePath with no open ring", cursor.commandOffset());
+                }
+                rings.push_back(std::move(current));
+                current.clear();
+                break;
 
-            if (id == kMoveTo)
-            {
+            case GeometryStep::Command::MoveTo:
                 // A MoveTo begins a new part. For a MultiPoint the count is
                 // greater than one and every point is its own part, which is
                 // why the flush happens per point rather than per command.
@@ -289,10 +57,30 @@ Result<std::vector<std::vector<Point>>> decodeGeometry(Reader reader, GeomType t
                     rings.push_back(std::move(current));
                     current.clear();
                 }
-            }
+                current.push_back(step->point);
+                break;
 
-            current.push_back(Point { static_cast<std::int32_t>(cursorX),
-                                      static_cast<std::int32_t>(cursorY) });
+            case GeometryStep::Command::LineTo:
+                // RESERVE, because this is where the decoder spends its time. A
+                // sample of the widget's tile-load path showed the allocator --
+                // malloc, free, memset -- outweighing every parsing symbol in
+                // it: the points of a ring were being appended one at a time
+                // into a vector that regrew as it went, once per ring, once per
+                // feature, once per tile.
+                //
+                // Once per command, for the rest of its points -- bounded by
+                // the bytes actually left, since each point costs at least two,
+                // so a truncated tile claiming a huge count cannot make us
+                // reserve more than it could hold. The cursor has already
+                // capped the count at kMaxPointsPerFeature.
+                if (current.size() == current.capacity())
+                {
+                    const std::size_t possible = std::min<std::size_t>(
+                        static_cast<std::size_t>(cursor.repeats()), cursor.remainingBytes() / 2U);
+                    current.reserve(current.size() + 1 + possible);
+                }
+                current.push_back(step->point);
+                break;
         }
     }
 
@@ -333,7 +121,7 @@ Result<Feature> decodeFeature(Reader reader)
 
         switch (field->number)
         {
-            case feature_field::kId:
+            case wire::feature_field::kId:
             {
                 auto id = reader.varint();
                 if (!id)
@@ -345,7 +133,7 @@ Result<Feature> decodeFeature(Reader reader)
                 break;
             }
 
-            case feature_field::kTags:
+            case wire::feature_field::kTags:
             {
                 // Packed repeated uint32. It may also legally appear unpacked,
                 // one varint per tag -- which is what the wire type says, so
@@ -379,7 +167,7 @@ Result<Feature> decodeFeature(Reader reader)
                 break;
             }
 
-            case feature_field::kType:
+            case wire::feature_field::kType:
             {
                 auto type = reader.varint();
                 if (!type)
@@ -400,7 +188,7 @@ Result<Feature> decodeFeature(Reader reader)
                 break;
             }
 
-            case feature_field::kGeometry:
+            case wire::feature_field::kGeometry:
             {
                 auto packed = reader.bytes();
                 if (!packed)
@@ -437,7 +225,7 @@ Result<Feature> decodeFeature(Reader reader)
     // decoded here rather than in the loop.
     if (!geometry.empty())
     {
-        auto rings = decodeGeometry(Reader(geometry), feature.type);
+        auto rings = decodeGeometry(geometry, feature.type);
         if (!rings)
         {
             return std::unexpected(rings.error());
@@ -463,7 +251,7 @@ Result<Layer> decodeLayer(Reader reader)
 
         switch (field->number)
         {
-            case layer_field::kName:
+            case wire::layer_field::kName:
             {
                 auto name = reader.text();
                 if (!name)
@@ -474,7 +262,7 @@ Result<Layer> decodeLayer(Reader reader)
                 break;
             }
 
-            case layer_field::kFeature:
+            case wire::layer_field::kFeature:
             {
                 auto sub = reader.sub();
                 if (!sub)
@@ -490,7 +278,7 @@ Result<Layer> decodeLayer(Reader reader)
                 break;
             }
 
-            case layer_field::kKey:
+            case wire::layer_field::kKey:
             {
                 auto key = reader.text();
                 if (!key)
@@ -501,14 +289,14 @@ Result<Layer> decodeLayer(Reader reader)
                 break;
             }
 
-            case layer_field::kValue:
+            case wire::layer_field::kValue:
             {
                 auto sub = reader.sub();
                 if (!sub)
                 {
                     return std::unexpected(sub.error());
                 }
-                auto value = decodeValue(*sub);
+                auto value = wire::decodeValue<Value, std::string>(*sub);
                 if (!value)
                 {
                     return std::unexpected(value.error());
@@ -517,7 +305,7 @@ Result<Layer> decodeLayer(Reader reader)
                 break;
             }
 
-            case layer_field::kExtent:
+            case wire::layer_field::kExtent:
             {
                 auto extent = reader.varint();
                 if (!extent)
@@ -536,7 +324,7 @@ Result<Layer> decodeLayer(Reader reader)
                 break;
             }
 
-            case layer_field::kVersion:
+            case wire::layer_field::kVersion:
             {
                 auto version = reader.varint();
                 if (!version)
@@ -630,7 +418,7 @@ Result<Tile> decode(std::span<const std::uint8_t> bytes)
             return std::unexpected(field.error());
         }
 
-        if (field->number == tile_field::kLayer)
+        if (field->number == wire::tile_field::kLayer)
         {
             auto sub = reader.sub();
             if (!sub)
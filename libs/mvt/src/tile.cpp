@@ -113,7 +113,7 @@ const Layer* Tile::layer(std::string_view name) const
     return (found == layers.end()) ? nullptr : &*found;
 }
 
-std::int64_t signedArea2(const std::vector<Point>& ring)
+std::int64_t signedArea2(std::span<const Point> ring)
 {
     if (ring.size() < 3)
     {
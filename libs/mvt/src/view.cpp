@@ -0,0 +1,555 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "mvt/view.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include "mvt/decode.h"
+#include "wire.h"
+
+namespace mvt
+{
+
+std::string valueToString(const ValueView& value)
+{
+    if (const auto* text = std::get_if<std::string_view>(&value))
+    {
+        return std::string(*text);
+    }
+    if (const auto* number = std::get_if<double>(&value))
+    {
+        return std::to_string(*number);
+    }
+    if (const auto* integer = std::get_if<std::int64_t>(&value))
+    {
+        return std::to_string(*integer);
+    }
+    if (const auto* flag = std::get_if<bool>(&value))
+    {
+        return *flag ? "true" : "false";
+    }
+    return {};
+}
+
+Result<GeometryStep> GeometryCursor::next()
+{
+    if (mRepeats == 0)
+    {
+        mCommandAt = mReader.offset();
+
+        auto command = mReader.varint();
+        if (!command)
+        {
+            return std::unexpected(command.error());
+        }
+
+        const std::uint32_t id = static_cast<std::uint32_t>(*command) & 0x07U;
+        const std::uint64_t count = *command >> 3;
+
+        if (id == wire::kClosePath)
+        {
+            // ClosePath takes a count but no parameters, and the spec fixes the
+            // count at 1. The ring is closed implicitly -- the first point is
+            // NOT repeated, which is why signedArea2 wraps with a modulo.
+            if (count != 1)
+            {
+                return malformed("ClosePath with count " + std::to_string(count), mCommandAt);
+            }
+            return GeometryStep { GeometryStep::Command::ClosePath,
+                                  Point { static_cast<std::int32_t>(mX),
+                                          static_cast<std::int32_t>(mY) } };
+        }
+
+        if (id != wire::kMoveTo && id != wire::kLineTo)
+        {
+            return malformed("geometry command id " + std::to_string(id), mCommandAt);
+        }
+
+        if (count == 0)
+        {
+            return malformed("geometry command with zero count", mCommandAt);
+        }
+
+        mTotal += static_cast<std::size_t>(count);
+        if (mTotal > wire::kMaxPointsPerFeature)
+        {
+            return malformed("feature claims more than " +
+                                 std::to_string(wire::kMaxPointsPerFeature) + " points",
+                             mCommandAt);
+        }
+
+        mCommand = id;
+        mRepeats = count;
+    }
+
+    auto dx = mReader.zigzag();
+    if (!dx)
+    {
+        return std::unexpected(dx.error());
+    }
+    auto dy = mReader.zigzag();
+    if (!dy)
+    {
+        return std::unexpected(dy.error());
+    }
+
+    // Accumulated in int64 and range-checked before narrowing. The deltas are
+    // attacker-controlled in the sense that they come off disk, and int32
+    // overflow here is UB rather than a wrong pixel.
+    mX += *dx;
+    mY += *dy;
+    if (mX < std::numeric_limits<std::int32_t>::min() ||
+        mX > std::numeric_limits<std::int32_t>::max() ||
+        mY < std::numeric_limits<std::int32_t>::min() ||
+        mY > std::numeric_limits<std::int32_t>::max())
+    {
+        return malformed("geometry cursor left int32 range", mCommandAt);
+    }
+
+    --mRepeats;
+    return GeometryStep {
+        mCommand == wire::kMoveTo ? GeometryStep::Command::MoveTo : GeometryStep::Command::LineTo,
+        Point { static_cast<std::int32_t>(mX), static_cast<std::int32_t>(mY) }
+    };
+}
+
+Result<void> FeatureView::rings(Rings& out) const
+{
+    out.clear();
+
+    // Where the open ring began in out.mPoints. Open while it is short of the
+    // end of the buffer.
+    std::size_t ringStart = 0;
+    const auto closeRing = [&] {
+        out.mEnds.push_back(static_cast<std::uint32_t>(out.mPoints.size()));
+        ringStart = out.mPoints.size();
+    };
+
+    GeometryCursor walk = cursor();
+    while (!walk.done())
+    {
+        auto step = walk.next();
+        if (!step)
+        {
+            return std::unexpected(step.error());
+        }
+
+        switch (step->command)
+        {
+            case GeometryStep::Command::ClosePath:
+                if (out.mPoints.size() == ringStart)
+                {
+                    return malformed("ClosePath with no open ring", walk.commandOffset());
+                }
+                closeRing();
+                break;
+
+            case GeometryStep::Command::MoveTo:
+                // Per point, not per command: a MultiPoint's one MoveTo with a
+                // count of N is N parts.
+                if (out.mPoints.size() != ringStart)
+                {
+                    closeRing();
+                }
+                out.mPoints.push_back(step->point);
+                break;
+
+            case GeometryStep::Command::LineTo:
+                out.mPoints.push_back(step->point);
+                break;
+        }
+    }
+
+    if (out.mPoints.size() != ringStart)
+    {
+        closeRing();
+    }
+
+    // As decode(): an unclosed or degenerate polygon ring means the stream was
+    // cut, and filling it would fill to somewhere arbitrary.
+    if (type == GeomType::Polygon)
+    {
+        for (const std::span<const Point> ring : out)
+        {
+            if (ring.size() < 3)
+            {
+                return malformed("polygon ring with " + std::to_string(ring.size()) + " points");
+            }
+        }
+    }
+
+    return {};
+}
+
+Result<LayerView> LayerView::index(std::span<const std::uint8_t> bytes)
+{
+    LayerView layer;
+    Reader reader(bytes);
+
+    while (!reader.done())
+    {
+        auto field = reader.field();
+        if (!field)
+        {
+            return std::unexpected(field.error());
+        }
+
+        switch (field->number)
+        {
+            case wire::layer_field::kName:
+            {
+                auto name = reader.text();
+                if (!name)
+                {
+                    return std::unexpected(name.error());
+                }
+                layer.name = *name;
+                break;
+            }
+
+            case wire::layer_field::kFeature:
+            {
+                auto sub = reader.sub();
+                if (!sub)
+                {
+                    return std::unexpected(sub.error());
+                }
+
+                // The record only: id, type, where the tags went in the
+                // layer's table, and a span of the geometry bytes. Decoding the
+                // geometry here would be decode() again.
+                FeatureView feature;
+                feature.tagStart = static_cast<std::uint32_t>(layer.mTags.size());
+                while (!sub->done())
+                {
+                    auto inner = sub->field();
+                    if (!inner)
+                    {
+                        return std::unexpected(inner.error());
+                    }
+
+                    switch (inner->number)
+                    {
+                        case wire::feature_field::kId:
+                        {
+                            auto id = sub->varint();
+                            if (!id)
+                            {
+                                return std::unexpected(id.error());
+                            }
+                            feature.id = *id;
+                            feature.hasId = true;
+                            break;
+                        }
+
+                        case wire::feature_field::kTags:
+                        {
+                            // Packed or not, as decode() allows.
+                            if (inner->wire == WireType::LengthDelimited)
+                            {
+                                auto packed = sub->sub();
+                                if (!packed)
+                                {
+                                    return std::unexpected(packed.error());
+                                }
+                                while (!packed->done())
+                                {
+                                    auto tag = packed->varint();
+                                    if (!tag)
+                                    {
+                                        return std::unexpected(tag.error());
+                                    }
+                                    layer.mTags.push_back(static_cast<std::uint32_t>(*tag));
+                                }
+                            }
+                            else
+                            {
+                                auto tag = sub->varint();
+                                if (!tag)
+                                {
+                                    return std::unexpected(tag.error());
+                                }
+                                layer.mTags.push_back(static_cast<std::uint32_t>(*tag));
+                            }
+                            break;
+                        }
+
+                        case wire::feature_field::kType:
+                        {
+                            auto type = sub->varint();
+                            if (!type)
+                            {
+                                return std::unexpected(type.error());
+                            }
+                            feature.type = (*type > static_cast<std::uint64_t>(GeomType::Polygon))
+                                               ? GeomType::Unknown
+                                               : static_cast<GeomType>(*type);
+                            break;
+                        }
+
+                        case wire::feature_field::kGeometry:
+                        {
+                            auto packed = sub->bytes();
+                            if (!packed)
+                            {
+                                return std::unexpected(packed.error());
+                            }
+                            feature.geometry = *packed;
+                            break;
+                        }
+
+                        default:
+                        {
+                            auto skipped = sub->skip(inner->wire);
+                            if (!skipped)
+                            {
+                                return std::unexpected(skipped.error());
+                            }
+                            break;
+                        }
+                    }
+                }
+
+                feature.tagCount =
+                    static_cast<std::uint32_t>(layer.mTags.size()) - feature.tagStart;
+                if ((feature.tagCount % 2) != 0)
+                {
+                    return malformed("feature has " + std::to_string(feature.tagCount) +
+                                     " tags, which is not a whole number of pairs");
+                }
+                layer.features.push_back(feature);
+                break;
+            }
+
+            case wire::layer_field::kKey:
+            {
+                auto key = reader.text();
+                if (!key)
+                {
+                    return std::unexpected(key.error());
+                }
+                layer.keys.push_back(*key);
+                break;
+            }
+
+            case wire::layer_field::kValue:
+            {
+                auto sub = reader.sub();
+                if (!sub)
+                {
+                    return std::unexpected(sub.error());
+                }
+                auto value = wire::decodeValue<ValueView, std::string_view>(*sub);
+                if (!value)
+                {
+                    return std::unexpected(value.error());
+                }
+                layer.values.push_back(*value);
+                break;
+            }
+
+            case wire::layer_field::kExtent:
+            {
+                auto extent = reader.varint();
+                if (!extent)
+                {
+                    return std::unexpected(extent.error());
+                }
+                if (*extent == 0 || *extent > 0xFFFFFFFFULL)
+                {
+                    return malformed("layer extent " + std::to_string(*extent));
+                }
+                layer.extent = static_cast<std::uint32_t>(*extent);
+                break;
+            }
+
+            case wire::layer_field::kVersion:
+            {
+                auto version = reader.varint();
+                if (!version)
+                {
+                    return std::unexpected(version.error());
+                }
+                layer.version = static_cast<std::uint32_t>(*version);
+                break;
+            }
+
+            default:
+            {
+                auto skipped = reader.skip(field->wire);
+                if (!skipped)
+                {
+                    return std::unexpected(skipped.error());
+                }
+                break;
+            }
+        }
+    }
+
+    // Checked once, here, for the same reason decode() does: every lookup after
+    // this indexes the tables with these without looking.
+    for (std::size_t i = 0; i + 1 < layer.mTags.size(); i += 2)
+    {
+        if (layer.mTags[i] >= layer.keys.size())
+        {
+            return malformed("tag key index " + std::to_string(layer.mTags[i]) + " past " +
+                             std::to_string(layer.keys.size()) + " keys");
+        }
+        if (layer.mTags[i + 1] >= layer.values.size())
+        {
+            return malformed("tag value index " + std::to_string(layer.mTags[i + 1]) + " past " +
+                             std::to_string(layer.values.size()) + " values");
+        }
+    }
+
+    return layer;
+}
+
+const ValueView* LayerView::attributeRef(const FeatureView& feature, std::string_view key) const
+{
+    // The key's index once, then a walk of the feature's pairs -- see
+    // Layer::attributeRef for why that way round.
+    const auto found = std::find(keys.begin(), keys.end(), key);
+    if (found == keys.end())
+    {
+        return nullptr;
+    }
+    const auto wanted = static_cast<std::uint32_t>(std::distance(keys.begin(), found));
+
+    const std::span<const std::uint32_t> pairs = tags(feature);
+    for (std::size_t i = 0; i + 1 < pairs.size(); i += 2)
+    {
+        if (pairs[i] == wanted)
+        {
+            return &values[pairs[i + 1]];
+        }
+    }
+    return nullptr;
+}
+
+std::string_view LayerView::attributeTextView(const FeatureView& feature,
+                                              std::string_view key) const
+{
+    const ValueView* found = attributeRef(feature, key);
+    if (found == nullptr)
+    {
+        return {};
+    }
+    const auto* text = std::get_if<std::string_view>(found);
+    return (text == nullptr) ? std::string_view {} : *text;
+}
+
+std::string LayerView::attributeText(const FeatureView& feature, std::string_view key) const
+{
+    const ValueView* found = attributeRef(feature, key);
+    return (found == nullptr) ? std::string {} : valueToString(*found);
+}
+
+Result<TileView> TileView::open(std::span<const std::uint8_t> bytes)
+{
+    TileView tile;
+    if (bytes.empty())
+    {
+        return tile;
+    }
+
+    if (looksCompressed(bytes))
+    {
+        return malformed("input is still compressed; inflate it first (see mvt/gzip.h)");
+    }
+
+    Reader reader(bytes);
+    while (!reader.done())
+    {
+        auto field = reader.field();
+        if (!field)
+        {
+            return std::unexpected(field.error());
+        }
+
+        if (field->number != wire::tile_field::kLayer)
+        {
+            auto skipped = reader.skip(field->wire);
+            if (!skipped)
+            {
+                return std::unexpected(skipped.error());
+            }
+            continue;
+        }
+
+        auto layerBytes = reader.bytes();
+        if (!layerBytes)
+        {
+            return std::unexpected(layerBytes.error());
+        }
+
+        // The name and nothing else. Features are stepped over by their
+        // length prefix, which is the whole cost of finding a layer.
+        Entry entry;
+        entry.bytes = *layerBytes;
+        Reader layer(*layerBytes);
+        while (!layer.done())
+        {
+            auto inner = layer.field();
+            if (!inner)
+            {
+                return std::unexpected(inner.error());
+            }
+            if (inner->number == wire::layer_field::kName)
+            {
+                auto name = layer.text();
+                if (!name)
+                {
+                    return std::unexpected(name.error());
+                }
+                entry.name = *name;
+                continue;
+            }
+            auto skipped = layer.skip(inner->wire);
+            if (!skipped)
+            {
+                return std::unexpected(skipped.error());
+            }
+        }
+        tile.mLayers.push_back(std::move(entry));
+    }
+
+    return tile;
+}
+
+const LayerView* TileView::layer(std::string_view name)
+{
+    // The first layer of that name, as Tile::layer answers.
+    const auto found = std::find_if(mLayers.begin(), mLayers.end(),
+                                    [name](const Entry& entry) { return entry.name == name; });
+    if (found == mLayers.end())
+    {
+        return nullptr;
+    }
+
+    if (!found->tried)
+    {
+        found->tried = true;
+        auto indexed = LayerView::index(found->bytes);
+        if (indexed)
+        {
+            found->indexed = std::move(*indexed);
+        }
+        else
+        {
+            flag(std::move(indexed.error()));
+        }
+    }
+    return found->indexed ? &*found->indexed : nullptr;
+}
+
+void TileView::flag(Error error)
+{
+    if (!mError)
+    {
+        mError = std::move(error);
+    }
+}
+
+} // namespace mvt
@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//
+// What decode.cpp and view.cpp both read off the wire, written down once.
+//
+// Private to the library. The two decoders differ in what they BUILD -- an
+// owning Tile against views into the caller's bytes -- and not in how a field
+// number or a value message is read, so the field table and the value decoder
+// live here rather than being restated in each and left to drift.
+#ifndef MVT_SRC_WIRE_H
+#define MVT_SRC_WIRE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#include "mvt/reader.h"
+
+namespace mvt::wire
+{
+
+// Field numbers from the vector_tile.proto (MVT 2.1). Written out rather than
+// left as literals at the switch sites, because a wrong number does not fail --
+// it reads a different field and yields a tile that is merely wrong.
+namespace tile_field
+{
+constexpr std::uint32_t kLayer = 3;
+}
+
+namespace layer_field
+{
+constexpr std::uint32_t kName = 1;
+constexpr std::uint32_t kFeature = 2;
+constexpr std::uint32_t kKey = 3;
+constexpr std::uint32_t kValue = 4;
+constexpr std::uint32_t kExtent = 5;
+// 15, not 6. The spec puts version last on purpose so it survives a reader
+// that stops early, and the gap is the single most likely thing to mistype.
+constexpr std::uint32_t kVersion = 15;
+}
+
+namespace feature_field
+{
+constexpr std::uint32_t kId = 1;
+constexpr std::uint32_t kTags = 2;
+constexpr std::uint32_t kType = 3;
+constexpr std::uint32_t kGeometry = 4;
+}
+
+namespace value_field
+{
+constexpr std::uint32_t kString = 1;
+constexpr std::uint32_t kFloat = 2;
+constexpr std::uint32_t kDouble = 3;
+constexpr std::uint32_t kInt64 = 4;
+constexpr std::uint32_t kUint64 = 5;
+constexpr std::uint32_t kSint64 = 6;
+constexpr std::uint32_t kBool = 7;
+}
+
+// Geometry command ids.
+constexpr std::uint32_t kMoveTo = 1;
+constexpr std::uint32_t kLineTo = 2;
+constexpr std::uint32_t kClosePath = 7;
+
+// A tile with more geometry than this is not a tile we can have produced, and
+// decoding it would let a malformed length allocate without bound. The largest
+// tile in the SoCal archive is ~300 kB; a million points is far above anything
+// real and far below anything dangerous.
+constexpr std::size_t kMaxPointsPerFeature = 1'000'000;
+
+// One Value message, into either variant: mvt::Value copies the string out,
+// mvt::ValueView keeps a view of it. Everything else about the two is the same
+// four alternatives, so the string is the only thing `V` decides.
+template <typename V, typename Text>
+Result<V> decodeValue(Reader reader)
+{
+    V out;
+
+    while (!reader.done())
+    {
+        auto field = reader.field();
+        if (!field)
+        {
+            return std::unexpected(field.error());
+        }
+
+        switch (field->number)
+        {
+            case value_field::kString:
+            {
+                auto text = reader.text();
+                if (!text)
+                {
+                    return std::unexpected(text.error());
+                }
+                out = Text(*text);
+                break;
+            }
+
+            case value_field::kFloat:
+            {
+                auto raw = reader.fixed32();
+                if (!raw)
+                {
+                    return std::unexpected(raw.error());
+                }
+                float value = 0.0F;
+                static_assert(sizeof(value) == sizeof(std::uint32_t));
+                std::memcpy(&value, &*raw, sizeof(value));
+                out = static_cast<double>(value);
+                break;
+            }
+
+            case value_field::kDouble:
+            {
+                auto raw = reader.fixed64();
+                if (!raw)
+                {
+                    return std::unexpected(raw.error());
+                }
+                double value = 0.0;
+                static_assert(sizeof(value) == sizeof(std::uint64_t));
+                std::memcpy(&value, &*raw, sizeof(value));
+                out = value;
+                break;
+            }
+
+            case value_field::kInt64:
+            case value_field::kUint64:
+            {
+                auto raw = reader.varint();
+                if (!raw)
+                {
+                    return std::unexpected(raw.error());
+                }
+                out = static_cast<std::int64_t>(*raw);
+                break;
+            }
+
+            case value_field::kSint64:
+            {
+                auto raw = reader.zigzag();
+                if (!raw)
+                {
+                    return std::unexpected(raw.error());
+                }
+                out = *raw;
+                break;
+            }
+
+            case value_field::kBool:
+            {
+                auto raw = reader.varint();
+                if (!raw)
+                {
+                    return std::unexpected(raw.error());
+                }
+                out = (*raw != 0);
+                break;
+            }
+
+            default:
+            {
+                // Unknown fields are SKIPPED, not rejected. That is the
+                // forward-compatibility rule in the spec, and a decoder that
+                // errors here breaks on the next revision of a format it would
+                // otherwise have read perfectly well.
+                auto skipped = reader.skip(field->wire);
+                if (!skipped)
+                {
+                    return std::unexpected(skipped.error());
+                }
+                break;
+            }
+        }
+    }
+
+    return out;
+}
+
+} // namespace mvt::wire
+
+#endif // MVT_SRC_WIRE_H
@@ -0,0 +1,440 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//
+// Reading a vector tile in place.
+//
+// Two promises to keep. The views must say what decode() says -- the same
+// layers, attributes and rings, the same refusals -- because the widget
+// switched to them and a disagreement is a map that is subtly different rather
+// than one that fails. And they must be lazy where they claim to be: a layer
+// nobody asks for is never parsed, and a geometry walk does not allocate,
+// which is counted here rather than assumed.
+//
+// Bytes come from tile_builder.h, as in test_decode.cpp, so neither decoder is
+// checked against itself.
+
+#include "mvt/decode.h"
+#include "mvt/view.h"
+
+#include "tile_builder.h"
+
+#include <spdlog/spdlog.h>
+
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+// Every allocation in the process, so a test can say "none happened here". Not
+// atomic: these tests run on one thread.
+std::size_t allocations = 0;
+
+} // namespace
+
+void* operator new(std::size_t size)
+{
+    ++allocations;
+    if (void* at = std::malloc(size == 0 ? 1 : size))
+    {
+        return at;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* at) noexcept
+{
+    std::free(at);
+}
+
+void operator delete(void* at, std::size_t) noexcept
+{
+    std::free(at);
+}
+
+namespace
+{
+
+int failures = 0;
+
+void check(bool condition, const std::string& what)
+{
+    if (!condition)
+    {
+        SPDLOG_ERROR("FAIL: {}", what);
+        ++failures;
+    }
+}
+
+using mvt_test::FeatureSpec;
+using mvt_test::Geometry;
+using mvt_test::LayerBuilder;
+using mvt_test::tileOf;
+
+// A road, a lake with an island, and a town: one of each geometry type, with
+// the attributes the widget switches on.
+mvt_test::Bytes sampleTile()
+{
+    const auto roads = LayerBuilder("transportation")
+                           .extent(4096)
+                           .key("class")
+                           .key("oneway")
+                           .stringValue("motorway")
+                           .boolValue(true)
+                           .feature(FeatureSpec {
+                               .type = 2,
+                               .geometry = Geometry().moveTo({ { 10, 20 } })
+                                               .lineTo({ { 30, 40 }, { 50, 20 } })
+                                               .moveTo({ { 100, 100 } })
+                                               .lineTo({ { 120, 90 } })
+                                               .bytes(),
+                               .tags = { 0, 0, 1, 1 },
+                               .id = 7,
+                               .hasId = true,
+                           })
+                           .bytes();
+
+    // Exterior clockwise (y down), hole counter-clockwise.
+    const auto water = LayerBuilder("water")
+                           .extent(512)
+                           .feature(FeatureSpec {
+                               .type = 3,
+                               .geometry = Geometry()
+                                               .moveTo({ { 0, 0 } })
+                                               .lineTo({ { 100, 0 }, { 100, 100 }, { 0, 100 } })
+                                               .closePath()
+                                               .moveTo({ { 25, 25 } })
+                                               .lineTo({ { 25, 75 }, { 75, 75 }, { 75, 25 } })
+                                               .closePath()
+                                               .bytes(),
+                           })
+                           .bytes();
+
+    const auto places = LayerBuilder("place")
+                            .key("name")
+                            .key("rank")
+                            .key("population")
+                            .stringValue("Irvine")
+                            .sintValue(8)
+                            .doubleValue(307670.0)
+                            .feature(FeatureSpec {
+                                .type = 1,
+                                .geometry = Geometry().moveTo({ { 2048, 2048 } }).bytes(),
+                                .tags = { 0, 0, 1, 1, 2, 2 },
+                            })
+                            .bytes();
+
+    return tileOf({ roads, water, places });
+}
+
+// ============================================================================
+// Agreement with decode()
+// ============================================================================
+
+void test_a_view_reads_what_decode_reads()
+{
+    const auto bytes = sampleTile();
+    auto decoded = mvt::decode(bytes);
+    auto view = mvt::TileView::open(bytes);
+    check(decoded.has_value() && view.has_value(), "both decoders accept the tile");
+    if (!decoded || !view)
+    {
+        return;
+    }
+
+    check(view->layerCount() == decoded->layers.size(), "the same number of layers");
+
+    mvt::Rings rings;
+    for (const mvt::Layer& layer : decoded->layers)
+    {
+        const mvt::LayerView* viewed = view->layer(layer.name);
+        check(viewed != nullptr, "the view finds layer " + layer.name);
+        if (viewed == nullptr)
+        {
+            continue;
+        }
+        check(viewed->name == layer.name, "with its name");
+        check(viewed->extent == layer.extent, layer.name + " has the same extent");
+        check(viewed->keys.size() == layer.keys.size() &&
+                  viewed->values.size() == layer.values.size(),
+              layer.name + " has the same tables");
+        check(viewed->features.size() == layer.features.size(),
+              layer.name + " has the same features");
+        if (viewed->features.size() != layer.features.size())
+        {
+            continue;
+        }
+
+        for (std::size_t f = 0; f < layer.features.size(); ++f)
+        {
+            const mvt::Feature& feature = layer.features[f];
+            const mvt::FeatureView& seen = viewed->features[f];
+            check(seen.type == feature.type && seen.hasId == feature.hasId &&
+                      seen.id == feature.id,
+                  layer.name + " feature " + std::to_string(f) + " has the same header");
+
+            for (const std::string& key : layer.keys)
+            {
+                check(viewed->attributeText(seen, key) == layer.attributeText(feature, key),
+                      layer.name + " attribute " + key + " reads the same");
+            }
+
+            check(seen.rings(rings).has_value(), "its geometry decodes");
+            check(rings.size() == feature.rings.size(),
+                  layer.name + " feature " + std::to_string(f) + " has the same rings");
+            for (std::size_t r = 0; r < rings.size() && r < feature.rings.size(); ++r)
+            {
+                const auto ring = rings[r];
+                check(std::vector<mvt::Point>(ring.begin(), ring.end()) == feature.rings[r],
+                      layer.name + " ring " + std::to_string(r) + " has the same points");
+                check(mvt::isExteriorRing(ring) == mvt::isExteriorRing(feature.rings[r]),
+                      "and the same winding");
+            }
+        }
+    }
+}
+
+void test_strings_are_views_into_the_buffer()
+{
+    // The point of the exercise: a key or a string value is the bytes it was
+    // written as, not a copy. A view that copied would still pass the test
+    // above -- and would be decode() with extra steps.
+    const auto bytes = sampleTile();
+    auto view = mvt::TileView::open(bytes);
+    const mvt::LayerView* roads = view ? view->layer("transportation") : nullptr;
+    check(roads != nullptr, "the road layer indexes");
+    if (roads == nullptr || roads->features.empty())
+    {
+        return;
+    }
+
+    const std::string_view motorway = roads->attributeTextView(roads->features[0], "class");
+    const auto* begin = reinterpret_cast<const char*>(bytes.data());
+    check(motorway == "motorway", "the class reads");
+    check(motorway.data() >= begin && motorway.data() < begin + bytes.size(),
+          "and points into the tile, not at a copy of it");
+    check(roads->attributeTextView(roads->features[0], "oneway").empty(),
+          "a bool attribute is not text");
+    check(roads->attributeText(roads->features[0], "oneway") == "true",
+          "but converts to it like a decoded one");
+}
+
+void test_unpacked_tags_read_too()
+{
+    const auto bytes = tileOf({ LayerBuilder("l")
+                                    .key("class")
+                                    .stringValue("river")
+                                    .feature(FeatureSpec {
+                                        .type = 2,
+                                        .geometry = Geometry().moveTo({ { 0, 0 } })
+                                                        .lineTo({ { 4, 4 } })
+                                                        .bytes(),
+                                        .tags = { 0, 0 },
+                                        .unpackedTags = true,
+                                    })
+                                    .bytes() });
+
+    auto view = mvt::TileView::open(bytes);
+    const mvt::LayerView* layer = view ? view->layer("l") : nullptr;
+    check(layer != nullptr && layer->features.size() == 1, "a layer with unpacked tags indexes");
+    if (layer != nullptr && !layer->features.empty())
+    {
+        check(layer->attributeTextView(layer->features[0], "class") == "river",
+              "and its tags resolve");
+    }
+}
+
+// ============================================================================
+// Laziness
+// ============================================================================
+
+void test_a_layer_nobody_reads_is_never_parsed()
+{
+    // A good layer, and one whose feature points past its value table. decode()
+    // refuses the whole tile for the second; the view does not look at it until
+    // asked, and when asked says so.
+    const auto good = LayerBuilder("good")
+                          .feature(FeatureSpec {
+                              .type = 1,
+                              .geometry = Geometry().moveTo({ { 1, 1 } }).bytes(),
+                          })
+                          .bytes();
+    const auto bad = LayerBuilder("bad")
+                         .key("class")
+                         .stringValue("road")
+                         .feature(FeatureSpec {
+                             .type = 1,
+                             .geometry = Geometry().moveTo({ { 1, 1 } }).bytes(),
+                             .tags = { 0, 9 },
+                         })
+                         .bytes();
+    const auto bytes = tileOf({ good, bad });
+
+    check(!mvt::decode(bytes).has_value(), "decode() refuses the tile outright");
+
+    auto view = mvt::TileView::open(bytes);
+    check(view.has_value(), "the view opens it");
+    if (!view)
+    {
+        return;
+    }
+    check(view->layer("good") != nullptr, "reads the good layer");
+    check(!view->error().has_value(), "and has found nothing wrong yet");
+
+    check(view->layer("bad") == nullptr, "the bad layer is not handed out");
+    check(view->error().has_value(), "and the tile now says why");
+    check(view->layer("absent") == nullptr, "an absent layer is simply absent");
+}
+
+void test_walking_geometry_allocates_nothing()
+{
+    const auto bytes = sampleTile();
+    auto view = mvt::TileView::open(bytes);
+    const mvt::LayerView* water = view ? view->layer("water") : nullptr;
+    const mvt::LayerView* roads = view ? view->layer("transportation") : nullptr;
+    check(water != nullptr && roads != nullptr, "the layers index");
+    if (water == nullptr || roads == nullptr)
+    {
+        return;
+    }
+
+    // The cursor: no allocation at all, and the cursor persists across
+    // commands, so the second part starts where the test wrote it rather than
+    // at a delta from the origin.
+    const std::size_t before = allocations;
+    mvt::GeometryCursor cursor = roads->features[0].cursor();
+    std::vector<mvt::GeometryStep> steps;
+    steps.reserve(8);
+    const std::size_t afterReserve = allocations;
+    while (!cursor.done())
+    {
+        auto step = cursor.next();
+        if (!step)
+        {
+            break;
+        }
+        steps.push_back(*step);
+    }
+    // Read before check(), whose message is a std::string built first.
+    const std::size_t afterWalk = allocations;
+    check(afterWalk == afterReserve, "walking a geometry allocates nothing");
+    check(afterReserve - before == 1, "(the only allocation was the test's own vector)");
+    check(steps.size() == 5, "five steps, got " + std::to_string(steps.size()));
+    if (steps.size() == 5)
+    {
+        check(steps[3].command == mvt::GeometryStep::Command::MoveTo &&
+                  steps[3].point == mvt::Point { 100, 100 },
+              "the second part starts where it was written");
+    }
+
+    // Rings: warm once, then a feature of no more points decodes into the same
+    // storage without touching the allocator.
+    mvt::Rings rings;
+    check(water->features[0].rings(rings).has_value(), "the lake decodes");
+    const std::size_t warm = allocations;
+    const bool road = roads->features[0].rings(rings).has_value();
+    const bool lake = water->features[0].rings(rings).has_value();
+    const std::size_t afterReuse = allocations;
+    check(road && lake, "the road and the lake again decode into the same rings");
+    check(afterReuse == warm, "reusing a warm Rings allocates nothing");
+    check(rings.size() == 2 && rings[0].size() == 4 && rings[1].size() == 4,
+          "and the lake is still an exterior and a hole");
+}
+
+// ============================================================================
+// Refusals
+// ============================================================================
+
+void test_malformed_geometry_is_refused_when_read()
+{
+    const auto rings = [](const mvt_test::Bytes& geometry, std::uint32_t type) {
+        const auto bytes =
+            tileOf({ LayerBuilder("l")
+                         .feature(FeatureSpec { .type = type, .geometry = geometry })
+                         .bytes() });
+        auto view = mvt::TileView::open(bytes);
+        const mvt::LayerView* layer = view ? view->layer("l") : nullptr;
+        mvt::Rings out;
+        return layer != nullptr && !layer->features.empty() &&
+               layer->features[0].rings(out).has_value();
+    };
+
+    check(!rings(Geometry().rawCommand(3, 1).rawDelta(1, 1).bytes(), 2),
+          "an unknown geometry command is refused");
+    check(!rings(Geometry().moveTo({ { 0, 0 } }).rawCommand(7, 2).bytes(), 2),
+          "ClosePath with a count other than 1 is refused");
+    check(!rings(Geometry().rawCommand(7, 1).bytes(), 2), "ClosePath with no open ring is refused");
+    check(!rings(Geometry().rawCommand(1, 0).bytes(), 2), "a zero count is refused");
+    check(!rings(Geometry().rawCommand(1, 2).rawDelta(5, 5).bytes(), 2),
+          "parameters cut short are refused");
+    check(!rings(Geometry().moveTo({ { 0, 0 } }).lineTo({ { 10, 10 } }).closePath().bytes(), 3),
+          "a two-point polygon ring is refused");
+    check(rings(Geometry().moveTo({ { 0, 0 } }).lineTo({ { 10, 10 } }).bytes(), 2),
+          "while the same two points as a line are fine");
+}
+
+void test_bad_structure_is_refused_where_decode_refuses_it()
+{
+    const auto oddTags = tileOf({ LayerBuilder("l")
+                                      .key("class")
+                                      .stringValue("road")
+                                      .feature(FeatureSpec {
+                                          .type = 1,
+                                          .geometry = Geometry().moveTo({ { 1, 1 } }).bytes(),
+                                          .tags = { 0 },
+                                      })
+                                      .bytes() });
+    auto view = mvt::TileView::open(oddTags);
+    check(view.has_value() && view->layer("l") == nullptr && view->error().has_value(),
+          "an odd tag count is refused when the layer is read");
+
+    const auto zeroExtent = tileOf({ LayerBuilder("l").extent(0).bytes() });
+    view = mvt::TileView::open(zeroExtent);
+    check(view.has_value() && view->layer("l") == nullptr, "a zero extent is refused");
+
+    const auto defaulted = tileOf({ LayerBuilder("l").withoutExtent().bytes() });
+    view = mvt::TileView::open(defaulted);
+    const mvt::LayerView* layer = view ? view->layer("l") : nullptr;
+    check(layer != nullptr && layer->extent == 4096, "an absent extent is 4096");
+
+    const std::vector<std::uint8_t> gzip { 0x1F, 0x8B, 0x08, 0x00 };
+    auto compressed = mvt::TileView::open(gzip);
+    check(!compressed.has_value() &&
+              compressed.error().message.find("compressed") != std::string::npos,
+          "a still-compressed tile says so");
+
+    auto empty = mvt::TileView::open({});
+    check(empty.has_value() && empty->layerCount() == 0, "an empty buffer is an empty tile");
+
+    auto cut = sampleTile();
+    cut.resize(cut.size() / 2);
+    check(!mvt::TileView::open(cut).has_value(), "a truncated tile does not open");
+}
+
+} // namespace
+
+int main()
+{
+    spdlog::set_level(spdlog::level::info);
+    spdlog::set_pattern("[%^%l%$] %v");
+
+    test_a_view_reads_what_decode_reads();
+    test_strings_are_views_into_the_buffer();
+    test_unpacked_tags_read_too();
+
+    test_a_layer_nobody_reads_is_never_parsed();
+    test_walking_geometry_allocates_nothing();
+
+    test_malformed_geometry_is_refused_when_read();
+    test_bad_structure_is_refused_where_decode_refuses_it();
+
+    if (failures != 0)
+    {
+        SPDLOG_ERROR("{} check(s) failed", failures);
+        return 1;
+    }
+
+    SPDLOG_INFO("all vector tile view checks passed");
+    return 0;
+}
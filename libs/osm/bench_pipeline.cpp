@@ -0,0 +1,260 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//
+// How fast a real PBF goes through readDataBlocks(), at each thread count, and
+// through the sequential loop it replaced.
+//
+// NOT a test -- it asserts nothing and always exits 0. test_block_pipeline is
+// what shows the answer does not depend on the thread count; this shows what
+// the thread count buys. Each run is the shape of map_build's heaviest pass:
+// every block inflated and decoded on the workers, node coordinates summed
+// there, and the ordered stage doing no more than counting, so the number is
+// the reader's ceiling rather than the extract's.
+//
+//   osm_bench_pipeline --pbf socal-260813.osm.pbf
+//   osm_bench_pipeline --pbf planet.osm.pbf --threads 1,2,4,8,16 --runs 5
+//
+// What each column means:
+//
+//   threads   workers inflating and decoding; "serial" is BlobIterator,
+//             inflateBlob and decodeDataBlock on this thread, the way every
+//             extract pass read before the pipeline
+//   seconds   wall time for the whole file, the fastest of --runs (default 3)
+//   blobs/s   data blobs framed, decoded and handed back in order, per second
+//   MB/s      compressed bytes through, per second
+//   speedup   against the serial row, so one thread shows what the pipeline
+//             itself costs
+//
+// The fastest run rather than the mean, because the first one is as much the
+// page cache filling as it is decoding, and a loaded machine only ever adds.
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "osm/blob.h"
+#include "osm/block_pipeline.h"
+
+namespace
+{
+
+std::string argumentAfter(int argc, char** argv, const std::string& flag,
+                          const std::string& fallback)
+{
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (flag == argv[i])
+        {
+            return argv[i + 1];
+        }
+    }
+    return fallback;
+}
+
+// "1,2,4" -> {1, 2, 4}. Empty means powers of two up to the core count, and
+// the core count itself if it is not one.
+std::vector<std::size_t> threadCounts(const std::string& list)
+{
+    std::vector<std::size_t> out;
+    std::size_t at = 0;
+    while (at < list.size())
+    {
+        const std::size_t comma = std::min(list.find(',', at), list.size());
+        const long value = std::strtol(list.substr(at, comma - at).c_str(), nullptr, 10);
+        if (value > 0)
+        {
+            out.push_back(static_cast<std::size_t>(value));
+        }
+        at = comma + 1;
+    }
+    if (!out.empty())
+    {
+        return out;
+    }
+
+    const std::size_t cores = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    for (std::size_t n = 1; n < cores; n *= 2)
+    {
+        out.push_back(n);
+    }
+    out.push_back(cores);
+    return out;
+}
+
+// What one pass over the file came to. The checksum and node count are
+// compared across rows, so a thread count that lost a block would show.
+struct Pass
+{
+    double seconds { 0.0 };
+    std::uint64_t blobs { 0 };
+    std::uint64_t compressedBytes { 0 };
+    std::uint64_t nodes { 0 };
+    std::int64_t checksum { 0 };
+};
+
+osm::Result<Pass> readSerially(std::span<const std::uint8_t> file)
+{
+    const auto started = std::chrono::steady_clock::now();
+    Pass pass;
+    std::vector<std::uint8_t> buffer;
+    osm::BlobIterator it(file);
+    while (!it.done())
+    {
+        auto blob = it.next();
+        if (!blob)
+        {
+            return std::unexpected(blob.error());
+        }
+        if (blob->kind != osm::BlobKind::Data)
+        {
+            continue;
+        }
+        if (auto ok = osm::inflateBlob(*blob, buffer); !ok)
+        {
+            return std::unexpected(ok.error());
+        }
+        auto block = osm::decodeDataBlock(buffer, blob->offset);
+        if (!block)
+        {
+            return std::unexpected(block.error());
+        }
+        for (const osm::Node& node : block->nodes())
+        {
+            pass.checksum += node.lat ^ node.lon;
+        }
+        pass.nodes += block->nodes().size();
+        pass.compressedBytes += blob->message.size();
+        ++pass.blobs;
+    }
+    pass.seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return pass;
+}
+
+osm::Result<Pass> readPipelined(std::span<const std::uint8_t> file, std::size_t threads)
+{
+    // Summed on the workers so the decode cannot be optimised away.
+    std::atomic<std::int64_t> checksum { 0 };
+    Pass pass;
+
+    osm::PipelineOptions options;
+    options.threads = threads;
+    auto stats = osm::readDataBlocks(
+        file, options, nullptr,
+        [&checksum](const osm::Block& block, std::size_t) -> osm::Result<void> {
+            std::int64_t sum = 0;
+            for (const osm::Node& node : block.nodes())
+            {
+                sum += node.lat ^ node.lon;
+            }
+            checksum.fetch_add(sum, std::memory_order_relaxed);
+            return {};
+        },
+        [&pass](const osm::Block& block, std::size_t) -> osm::Result<void> {
+            pass.nodes += block.nodes().size();
+            return {};
+        });
+    if (!stats)
+    {
+        return std::unexpected(stats.error());
+    }
+    pass.seconds = stats->seconds;
+    pass.blobs = stats->blobs;
+    pass.compressedBytes = stats->compressedBytes;
+    pass.checksum = checksum.load();
+    return pass;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    spdlog::set_pattern("%v");
+
+    const std::string path = argumentAfter(argc, argv, "--pbf", "");
+    if (path.empty())
+    {
+        SPDLOG_ERROR("usage: osm_bench_pipeline --pbf <file> [--threads 1,2,4] [--runs 3]");
+        return 0;
+    }
+
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    struct stat info {};
+    if (fd < 0 || ::fstat(fd, &info) != 0)
+    {
+        SPDLOG_ERROR("cannot open {}", path);
+        return 0;
+    }
+    const auto size = static_cast<std::size_t>(info.st_size);
+    void* address = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address == MAP_FAILED)
+    {
+        SPDLOG_ERROR("cannot map {}", path);
+        ::close(fd);
+        return 0;
+    }
+    const std::span<const std::uint8_t> file(static_cast<const std::uint8_t*>(address), size);
+
+    SPDLOG_INFO("{}: {:.1f} MB, {} cores", path, double(size) / 1e6,
+                std::thread::hardware_concurrency());
+    SPDLOG_INFO("{:>8} {:>9} {:>10} {:>8} {:>8}", "threads", "seconds", "blobs/s", "MB/s",
+                "speedup");
+
+    const long runs = std::max(std::strtol(argumentAfter(argc, argv, "--runs", "3").c_str(),
+                                           nullptr, 10),
+                               1L);
+
+    // Zero in the list is the serial loop, first so every row is against it.
+    std::vector<std::size_t> rows { 0 };
+    for (const std::size_t threads : threadCounts(argumentAfter(argc, argv, "--threads", "")))
+    {
+        rows.push_back(threads);
+    }
+
+    double baseline = 0.0;
+    for (const std::size_t threads : rows)
+    {
+        Pass best;
+        for (long run = 0; run < runs; ++run)
+        {
+            auto pass = threads == 0 ? readSerially(file) : readPipelined(file, threads);
+            if (!pass)
+            {
+                SPDLOG_ERROR("{}", osm::to_string(pass.error()));
+                ::munmap(address, size);
+                ::close(fd);
+                return 0;
+            }
+            if (run == 0 || pass->seconds < best.seconds)
+            {
+                best = *pass;
+            }
+        }
+
+        if (baseline == 0.0)
+        {
+            baseline = best.seconds;
+        }
+        SPDLOG_INFO("{:>8} {:>9.2f} {:>10.0f} {:>8.1f} {:>7.2f}x   ({} nodes, checksum {:x})",
+                    threads == 0 ? std::string("serial") : std::to_string(threads), best.seconds,
+                    double(best.blobs) / best.seconds,
+                    double(best.compressedBytes) / 1e6 / best.seconds, baseline / best.seconds,
+                    best.nodes, static_cast<std::uint64_t>(best.checksum));
+    }
+
+    ::munmap(address, size);
+    ::close(fd);
+    return 0;
+}
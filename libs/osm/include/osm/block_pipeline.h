@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//
+// Every data block of a PBF, decoded on every core and handed back in order.
+//
+// This is the loop blob.h was split from block.h to allow. A PBF blob is an
+// independent zlib stream and a block depends on nothing outside itself, so:
+//
+//   * The FRAMING walk stays on the caller's thread. It is cheap and strictly
+//     sequential -- each blob starts where the last one ended.
+//   * Inflating, peeking and decoding run on a pool, one blob per worker.
+//   * A decoded block goes first to `parallel`, on the worker that decoded it
+//     and in no particular order, and then to `ordered`, on the CALLER's
+//     thread in file order.
+//
+// That split is the whole API. Anything that depends on order -- OrderCheck,
+// a counter numbered on first sight, a sink that wants ways before the
+// relations that name them -- goes in `ordered` and needs no locking at all.
+// Anything that needs only the block and a thread-safe target, like
+// NodeStore::markReferenced, goes in `parallel` and scales with the cores.
+//
+// At most `threads * blocksPerThread` blocks are in flight at once, decoded or
+// not, which is what bounds memory: a decoded block is a few megabytes, and a
+// slow `ordered` must not let the workers decode the whole file ahead of it.
+//
+// ERRORS COME BACK IN FILE ORDER. A block that fails to inflate or decode, or
+// whose stage fails, is not reported until every block before it has been
+// through `ordered` -- so the error returned is the one a sequential reader
+// would have returned, at the same offset, whatever the thread count. The first
+// error stops the read; blocks decoded past it are dropped unseen.
+#ifndef OSM_BLOCK_PIPELINE_H
+#define OSM_BLOCK_PIPELINE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+
+#include "osm/block.h"
+#include "osm/error.h"
+
+namespace osm
+{
+
+struct PipelineOptions
+{
+    // Workers inflating and decoding. Zero is one per core.
+    std::size_t threads { 0 };
+    // Blocks in flight per worker. More than one keeps a worker busy while
+    // `ordered` drains; more than a few only helps when block costs are very
+    // uneven, and each costs a decoded block of memory.
+    std::size_t blocksPerThread { 4 };
+};
+
+struct PipelineStats
+{
+    // What `threads` resolved to.
+    std::size_t threads { 0 };
+    // Data blobs framed, and of those how many the filter let through to be
+    // decoded. The rest were inflated and peeked only.
+    std::uint64_t blobs { 0 };
+    std::uint64_t decoded { 0 };
+    // Blob messages as stored, before inflating.
+    std::uint64_t compressedBytes { 0 };
+    double seconds { 0.0 };
+
+    double blobsPerSecond() const { return seconds > 0.0 ? double(blobs) / seconds : 0.0; }
+};
+
+// Whether to decode a block, from its peeked contents. Runs on a worker. A null
+// filter decodes everything without peeking.
+using BlockFilter = std::function<bool(const BlockContents&)>;
+
+// One stage's look at a decoded block. `offset` is its blob's, for errors.
+using BlockStage = std::function<Result<void>(const Block& block, std::size_t offset)>;
+
+// Read every OSMData blob of `file` -- the header and unknown blob types are
+// stepped over, so check the header first as before. Either stage may be null.
+//
+// `parallel` runs on several workers at once and must be safe to; `ordered`
+// runs on the calling thread, one block at a time, and sees every block after
+// its `parallel` stage has finished.
+Result<PipelineStats> readDataBlocks(std::span<const std::uint8_t> file,
+                                     const PipelineOptions& options, const BlockFilter& filter,
+                                     const BlockStage& parallel, const BlockStage& ordered);
+
+} // namespace osm
+
+#endif // OSM_BLOCK_PIPELINE_H
@@ -32,13 +32,33 @@
 // sequential merge. Nothing here needs it, but the way-reference consumer in
 // map_build is a callback for exactly that reason -- it could be redirected to a
 // spill file without touching this.
+//
+// THREADS. Both passes are called from every core of map_build's block
+// pipeline (osm/block_pipeline.h), so marking and setting are safe to call
+// concurrently -- each against itself, never one against the other, with
+// finalise() between them as before:
+//
+//   - Marking sets bits with an atomic OR, under a SHARED lock that exists
+//     only so that growing the bitset, which moves it, can wait for the
+//     markers to leave. Growth is geometric, so the exclusive side is taken a
+//     few dozen times in a continental pass. Mark a block's ids as one span:
+//     the lock and the counters are paid per call, not per id.
+//   - Setting writes the two Coords at the id's rank. Distinct ids have
+//     distinct ranks, so concurrent setters touch disjoint slots and need
+//     nothing but the bitset and rank index, which are read-only by then.
+//     A file that carried the same node twice, in two blocks decoded at once,
+//     would count it twice in `resolved` and keep either coordinate. Ids are
+//     unique per type in anything an OSM tool writes.
 #ifndef OSM_NODE_STORE_H
 #define OSM_NODE_STORE_H
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <limits>
 #include <optional>
+#include <shared_mutex>
+#include <span>
 #include <utility>
 #include <vector>
 
@@ -60,7 +80,11 @@ class NodeStore
     // bitset grows to fit -- SIZED FROM THE FILE, never from a constant. The id
     // space grows by ~0.5-1e9 a year, and a hardcoded ceiling silently truncates
     // the top of it, which presents as the newest edits missing.
+    //
+    // Thread-safe; see THREADS above. The span form is the one to call from a
+    // block loop.
     void markReferenced(std::int64_t id);
+    void markReferenced(std::span<const std::int64_t> ids);
 
     // Build the rank index and allocate the coordinate array. Call once,
     // between the passes. Every coordinate starts as kNoCoord.
@@ -68,9 +92,16 @@ class NodeStore
 
     // PASS B. Record a coordinate. Ids that were never marked are ignored --
     // most of a file's nodes are not part of any way.
+    //
+    // Thread-safe once finalised; see THREADS above. The span form takes a
+    // whole block's nodes and counts them once.
     void set(std::int64_t id, Coord lat, Coord lon);
+    void set(std::span<const Node> nodes);
 
     bool finalised() const { return mFinalised; }
+
+    // Not while something is marking: a read of the bitset does not take the
+    // lock that growing it does.
     bool referenced(std::int64_t id) const;
 
     // The coordinate, or nothing if this id was never referenced or never seen
@@ -98,18 +129,31 @@ class NodeStore
 
     Stats stats() const;
 
+    NodeStore() = default;
+    NodeStore(const NodeStore&) = delete;
+    NodeStore& operator=(const NodeStore&) = delete;
+
   private:
     std::uint64_t rank(std::uint64_t id) const;
 
+    // Set the bits for `ids`, all of whose words exist. Called holding
+    // mGrowth shared. Returns how many were not already set.
+    std::uint64_t markExisting(std::span<const std::int64_t> ids);
+
+    // Write one coordinate; true if the slot was empty until now.
+    bool store(std::int64_t id, Coord lat, Coord lon);
+
+    // Shared by markers, exclusive to resize mBits. See THREADS above.
+    std::shared_mutex mGrowth;
     std::vector<std::uint64_t> mBits;
     // Cumulative set bits before each superblock. Empty until finalise().
     std::vector<std::uint64_t> mRank;
     // Two Coords per referenced node, indexed by rank.
     std::vector<Coord> mCoords;
 
-    std::int64_t mMaxId { -1 };
-    std::uint64_t mReferenced { 0 };
-    std::uint64_t mResolved { 0 };
+    std::atomic<std::int64_t> mMaxId { -1 };
+    std::atomic<std::uint64_t> mReferenced { 0 };
+    std::atomic<std::uint64_t> mResolved { 0 };
     bool mFinalised { false };
 };
 
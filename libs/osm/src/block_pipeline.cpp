@@ -0,0 +1,273 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "osm/block_pipeline.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "osm/blob.h"
+
+namespace osm
+{
+namespace
+{
+
+// One blob on its way through. Slots are a ring indexed by sequence number, so
+// a slot is reused only once `ordered` is done with the blob that held it.
+//
+// Written by the framer before the blob is queued, by one worker between
+// dequeuing and `ready`, and by the caller after `ready`. The mutex hand-offs
+// between those are what order the writes; nothing here is touched by two
+// threads without one of them in between.
+struct Slot
+{
+    Blob blob;
+    bool ready { false };
+    // Empty with no error when the filter passed over it.
+    std::optional<Block> block;
+    std::optional<Error> error;
+};
+
+class Pipeline
+{
+  public:
+    Pipeline(std::size_t threads, std::size_t window, const BlockFilter& filter,
+             const BlockStage& parallel)
+        : mSlots(window), mFilter(filter), mParallel(parallel)
+    {
+        mWorkers.reserve(threads);
+        for (std::size_t i = 0; i < threads; ++i)
+        {
+            mWorkers.emplace_back([this] { work(); });
+        }
+    }
+
+    // Abandons whatever is queued and joins. Every way out of readDataBlocks
+    // comes through here, which is what lets it return from the middle.
+    ~Pipeline()
+    {
+        {
+            std::lock_guard lock(mMutex);
+            mStopping = true;
+        }
+        mWork.notify_all();
+        for (std::thread& worker : mWorkers)
+        {
+            worker.join();
+        }
+    }
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    std::size_t window() const { return mSlots.size(); }
+
+    // Caller's thread. The slot for `sequence` must be free.
+    void submit(std::uint64_t sequence, Blob blob)
+    {
+        Slot& slot = mSlots[sequence % mSlots.size()];
+        slot.blob = std::move(blob);
+        {
+            std::lock_guard lock(mMutex);
+            mQueue.push_back(sequence);
+        }
+        mWork.notify_one();
+    }
+
+    // Caller's thread. Waits for `sequence` and frees its slot.
+    Slot take(std::uint64_t sequence)
+    {
+        Slot& slot = mSlots[sequence % mSlots.size()];
+        std::unique_lock lock(mMutex);
+        mDone.wait(lock, [&] { return slot.ready; });
+        Slot out = std::move(slot);
+        slot = Slot {};
+        return out;
+    }
+
+    std::uint64_t decoded() const
+    {
+        std::lock_guard lock(mMutex);
+        return mDecoded;
+    }
+
+  private:
+    void work()
+    {
+        // Per worker, and reused for every blob it inflates -- see
+        // inflateBlob() for why a fresh buffer per block is the wrong default.
+        std::vector<std::uint8_t> buffer;
+
+        while (true)
+        {
+            std::uint64_t sequence = 0;
+            {
+                std::unique_lock lock(mMutex);
+                mWork.wait(lock, [&] { return mStopping || !mQueue.empty(); });
+                if (mStopping)
+                {
+                    return;
+                }
+                sequence = mQueue.front();
+                mQueue.pop_front();
+            }
+
+            Slot& slot = mSlots[sequence % mSlots.size()];
+            const bool decodedOne = run(slot, buffer);
+
+            {
+                std::lock_guard lock(mMutex);
+                slot.ready = true;
+                mDecoded += decodedOne ? 1 : 0;
+            }
+            // All, not one: the caller waits on one particular slot, and the
+            // worker that finishes it need not be the one it would wake.
+            mDone.notify_all();
+        }
+    }
+
+    // Inflate, peek, decode and stage one blob into its slot. True if it was
+    // decoded rather than filtered out or failed.
+    bool run(Slot& slot, std::vector<std::uint8_t>& buffer) const
+    {
+        const std::size_t offset = slot.blob.offset;
+        if (auto ok = inflateBlob(slot.blob, buffer); !ok)
+        {
+            slot.error = ok.error();
+            return false;
+        }
+
+        if (mFilter)
+        {
+            auto contents = peekDataBlock(buffer, offset);
+            if (!contents)
+            {
+                slot.error = contents.error();
+                return false;
+            }
+            if (!mFilter(*contents))
+            {
+                return false;
+            }
+        }
+
+        auto block = decodeDataBlock(buffer, offset);
+        if (!block)
+        {
+            slot.error = block.error();
+            return false;
+        }
+
+        if (mParallel)
+        {
+            if (auto ok = mParallel(*block, offset); !ok)
+            {
+                slot.error = ok.error();
+                return false;
+            }
+        }
+
+        slot.block = std::move(*block);
+        return true;
+    }
+
+    std::vector<Slot> mSlots;
+    const BlockFilter& mFilter;
+    const BlockStage& mParallel;
+
+    mutable std::mutex mMutex;
+    std::condition_variable mWork;
+    std::condition_variable mDone;
+    std::deque<std::uint64_t> mQueue;
+    std::uint64_t mDecoded { 0 };
+    bool mStopping { false };
+
+    // Last, so every member above exists before a worker can touch it.
+    std::vector<std::thread> mWorkers;
+};
+
+} // namespace
+
+Result<PipelineStats> readDataBlocks(std::span<const std::uint8_t> file,
+                                     const PipelineOptions& options, const BlockFilter& filter,
+                                     const BlockStage& parallel, const BlockStage& ordered)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    PipelineStats stats;
+    stats.threads = options.threads != 0
+                        ? options.threads
+                        : std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    const std::size_t window = stats.threads * std::max<std::size_t>(options.blocksPerThread, 1);
+
+    Pipeline pipeline(stats.threads, window, filter, parallel);
+
+    BlobIterator it(file);
+    std::uint64_t framed = 0;
+    std::uint64_t consumed = 0;
+    // A framing error is reported where it happened IN THE FILE: after every
+    // blob framed before it has been consumed, like any other error.
+    std::optional<Error> framingError;
+
+    while (true)
+    {
+        // Keep the window full. Framing is a few varints per blob, so doing it
+        // here rather than on a thread of its own costs the consumer nothing
+        // worth a thread.
+        while (!framingError && !it.done() && framed - consumed < pipeline.window())
+        {
+            auto blob = it.next();
+            if (!blob)
+            {
+                framingError = blob.error();
+                break;
+            }
+            if (blob->kind != BlobKind::Data)
+            {
+                continue;
+            }
+            stats.compressedBytes += blob->message.size();
+            pipeline.submit(framed, std::move(*blob));
+            ++framed;
+        }
+
+        if (consumed == framed)
+        {
+            break;
+        }
+
+        Slot slot = pipeline.take(consumed);
+        ++consumed;
+
+        if (slot.error)
+        {
+            return std::unexpected(std::move(*slot.error));
+        }
+        if (slot.block && ordered)
+        {
+            if (auto ok = ordered(*slot.block, slot.blob.offset); !ok)
+            {
+                return std::unexpected(ok.error());
+            }
+        }
+    }
+
+    if (framingError)
+    {
+        return std::unexpected(std::move(*framingError));
+    }
+
+    stats.blobs = framed;
+    stats.decoded = pipeline.decoded();
+    stats.seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+} // namespace osm
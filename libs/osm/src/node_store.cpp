@@ -2,7 +2,10 @@
 #include "osm/node_store.h"
 
 #include <algorithm>
+#include <atomic>
 #include <bit>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
 
 namespace osm
@@ -15,38 +18,98 @@ namespace
 constexpr std::size_t kWordsPerSuperblock =
     static_cast<std::size_t>(NodeStore::kSuperblockBits / 64);
 
+// std::atomic_ref has no const form before C++26. A relaxed load writes
+// nothing, so casting the const away to make one is sound.
+Coord loadCoord(const Coord& slot)
+{
+    return std::atomic_ref<Coord>(const_cast<Coord&>(slot)).load(std::memory_order_relaxed);
+}
+
 } // namespace
 
 void NodeStore::markReferenced(std::int64_t id)
 {
-    if (id < 0)
+    markReferenced(std::span<const std::int64_t>(&id, 1));
+}
+
+void NodeStore::markReferenced(std::span<const std::int64_t> ids)
+{
+    // Negative ids exist only in editor scratch files, never in a published
+    // extract. Ignored rather than refused: one is not worth failing a
+    // continental build over, and the way that references it will be dropped
+    // by the missing-coordinate path anyway.
+    std::int64_t highest = -1;
+    for (const std::int64_t id : ids)
+    {
+        highest = std::max(highest, id);
+    }
+    if (highest < 0)
     {
-        // Negative ids exist only in editor scratch files, never in a published
-        // extract. Ignored rather than refused: one is not worth failing a
-        // continental build over, and the way that references it will be
-        // dropped by the missing-coordinate path anyway.
         return;
     }
+    const std::size_t lastWord = static_cast<std::size_t>(static_cast<std::uint64_t>(highest) / 64);
 
-    const auto uid = static_cast<std::uint64_t>(id);
-    const std::size_t word = static_cast<std::size_t>(uid / 64);
-
-    if (word >= mBits.size())
+    std::uint64_t fresh = 0;
+    bool marked = false;
+    {
+        std::shared_lock lock(mGrowth);
+        if (lastWord < mBits.size())
+        {
+            fresh = markExisting(ids);
+            marked = true;
+        }
+    }
+    if (!marked)
     {
         // Grown to fit what the file actually contains. Geometric growth so a
-        // file whose ids climb steadily does not re-allocate per block.
-        const std::size_t wanted = word + 1;
-        mBits.resize(std::max(wanted, mBits.size() + mBits.size() / 2 + 1), 0);
+        // file whose ids climb steadily does not re-allocate per block -- and
+        // so the exclusive lock is rare. Re-checked under it: another marker
+        // may have grown the bitset while this one waited.
+        {
+            std::unique_lock lock(mGrowth);
+            if (lastWord >= mBits.size())
+            {
+                const std::size_t wanted = lastWord + 1;
+                mBits.resize(std::max(wanted, mBits.size() + mBits.size() / 2 + 1), 0);
+            }
+        }
+        std::shared_lock lock(mGrowth);
+        fresh = markExisting(ids);
     }
 
-    const std::uint64_t mask = std::uint64_t { 1 } << (uid % 64);
-    if ((mBits[word] & mask) == 0)
+    mReferenced.fetch_add(fresh, std::memory_order_relaxed);
+    std::int64_t seen = mMaxId.load(std::memory_order_relaxed);
+    while (seen < highest &&
+           !mMaxId.compare_exchange_weak(seen, highest, std::memory_order_relaxed))
     {
-        mBits[word] |= mask;
-        ++mReferenced;
     }
+}
 
-    mMaxId = std::max(mMaxId, id);
+std::uint64_t NodeStore::markExisting(std::span<const std::int64_t> ids)
+{
+    std::uint64_t fresh = 0;
+    for (const std::int64_t id : ids)
+    {
+        if (id < 0)
+        {
+            continue;
+        }
+        const auto uid = static_cast<std::uint64_t>(id);
+        const std::uint64_t mask = std::uint64_t { 1 } << (uid % 64);
+        std::atomic_ref<std::uint64_t> word(mBits[static_cast<std::size_t>(uid / 64)]);
+        // A plain load first: a way's refs repeat (every closed ring, every
+        // junction shared with the previous way), and an OR on a bit already
+        // set would still take the cache line exclusive.
+        if ((word.load(std::memory_order_relaxed) & mask) != 0)
+        {
+            continue;
+        }
+        if ((word.fetch_or(mask, std::memory_order_relaxed) & mask) == 0)
+        {
+            ++fresh;
+        }
+    }
+    return fresh;
 }
 
 Result<void> NodeStore::finalise()
@@ -73,16 +136,17 @@ Result<void> NodeStore::finalise()
     }
     mRank[superblocks] = running;
 
-    if (running != mReferenced)
+    const std::uint64_t referenced = mReferenced.load(std::memory_order_relaxed);
+    if (running != referenced)
     {
         return malformed("rank index counted " + std::to_string(running) + " referenced nodes, " +
-                         "the bitset says " + std::to_string(mReferenced));
+                         "the bitset says " + std::to_string(referenced));
     }
 
     // Two Coords per node, both kNoCoord. Filling with a sentinel rather than
     // zero is what makes an unresolved reference a checkable condition instead
     // of a plausible position off the coast of Africa.
-    mCoords.assign(static_cast<std::size_t>(mReferenced) * 2, kNoCoord);
+    mCoords.assign(static_cast<std::size_t>(referenced) * 2, kNoCoord);
     mFinalised = true;
     return {};
 }
@@ -118,20 +182,50 @@ bool NodeStore::referenced(std::int64_t id) const
     return (mBits[word] & (std::uint64_t { 1 } << (uid % 64))) != 0;
 }
 
+bool NodeStore::store(std::int64_t id, Coord lat, Coord lon)
+{
+    if (!referenced(id))
+    {
+        return false;
+    }
+
+    // Relaxed atomics rather than plain stores so that the one case where two
+    // setters could meet -- the same id in two blocks, see THREADS -- is a
+    // wrong count rather than undefined behaviour. On every platform this
+    // builds for they compile to the same moves.
+    const std::size_t index = static_cast<std::size_t>(rank(static_cast<std::uint64_t>(id)));
+    std::atomic_ref<Coord> latSlot(mCoords[index * 2]);
+    std::atomic_ref<Coord> lonSlot(mCoords[index * 2 + 1]);
+    const bool fresh = latSlot.load(std::memory_order_relaxed) == kNoCoord;
+    latSlot.store(lat, std::memory_order_relaxed);
+    lonSlot.store(lon, std::memory_order_relaxed);
+    return fresh;
+}
+
 void NodeStore::set(std::int64_t id, Coord lat, Coord lon)
 {
-    if (!mFinalised || !referenced(id))
+    if (!mFinalised)
     {
         return;
     }
+    if (store(id, lat, lon))
+    {
+        mResolved.fetch_add(1, std::memory_order_relaxed);
+    }
+}
 
-    const std::size_t index = static_cast<std::size_t>(rank(static_cast<std::uint64_t>(id)));
-    if (mCoords[index * 2] == kNoCoord)
+void NodeStore::set(std::span<const Node> nodes)
+{
+    if (!mFinalised)
+    {
+        return;
+    }
+    std::uint64_t fresh = 0;
+    for (const Node& node : nodes)
     {
-        ++mResolved;
+        fresh += store(node.id, node.lat, node.lon) ? 1 : 0;
     }
-    mCoords[index * 2] = lat;
-    mCoords[index * 2 + 1] = lon;
+    mResolved.fetch_add(fresh, std::memory_order_relaxed);
 }
 
 std::optional<std::pair<Coord, Coord>> NodeStore::get(std::int64_t id) const
@@ -141,9 +235,11 @@ std::optional<std::pair<Coord, Coord>> NodeStore::get(std::int64_t id) const
         return std::nullopt;
     }
 
+    // Read while later blocks are still being set (see THREADS), so through
+    // the same atomics the setters write with.
     const std::size_t index = static_cast<std::size_t>(rank(static_cast<std::uint64_t>(id)));
-    const Coord lat = mCoords[index * 2];
-    const Coord lon = mCoords[index * 2 + 1];
+    const Coord lat = loadCoord(mCoords[index * 2]);
+    const Coord lon = loadCoord(mCoords[index * 2 + 1]);
     if (!hasCoord(lat) || !hasCoord(lon))
     {
         return std::nullopt;
@@ -154,9 +250,9 @@ std::optional<std::pair<Coord, Coord>> NodeStore::get(std::int64_t id) const
 NodeStore::Stats NodeStore::stats() const
 {
     Stats out;
-    out.referenced = mReferenced;
-    out.resolved = mResolved;
-    out.maxId = mMaxId;
+    out.referenced = mReferenced.load(std::memory_order_relaxed);
+    out.resolved = mResolved.load(std::memory_order_relaxed);
+    out.maxId = mMaxId.load(std::memory_order_relaxed);
     out.bytes = static_cast<std::uint64_t>(mBits.size()) * 8 +
                 static_cast<std::uint64_t>(mRank.size()) * 8 +
                 static_cast<std::uint64_t>(mCoords.size()) * sizeof(Coord);
@@ -0,0 +1,352 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//
+// The pipelined reader: every core decoding, the caller still seeing file order.
+//
+// What can go wrong here does not crash either. A block handed to `ordered` out
+// of turn trips OrderCheck on a perfectly sorted file -- or worse, does not, and
+// numbers the ways in whatever order the workers happened to finish. An error
+// reported from whichever worker failed first names a different byte on every
+// run. So every case runs at one thread and at several, and the answer has to
+// be the same.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "osm/block_pipeline.h"
+#include "osm/node_store.h"
+#include "pbf_builder.h"
+
+namespace
+{
+
+using osm_test::Bytes;
+
+int failures = 0;
+
+void check(bool condition, const std::string& what)
+{
+    if (!condition)
+    {
+        SPDLOG_ERROR("FAIL: {}", what);
+        ++failures;
+    }
+}
+
+constexpr std::size_t kThreadCounts[] = { 1, 2, 8 };
+
+// Enough blocks that eight workers with four in flight each wrap the window
+// several times over.
+constexpr int kBlocks = 200;
+
+void append(Bytes& file, const Bytes& piece)
+{
+    file.insert(file.end(), piece.begin(), piece.end());
+}
+
+// A header, then `kBlocks` data blocks. Block i holds one node with id i*10
+// when i is even and one way with id i referencing its neighbours' nodes when
+// it is odd -- so the filter has something to choose between, and the first id
+// in each block says which block it is.
+Bytes sampleFile()
+{
+    Bytes file;
+    append(file, osm_test::framed("OSMHeader", osm_test::rawBlob(osm_test::headerBlock({}))));
+
+    for (int i = 0; i < kBlocks; ++i)
+    {
+        osm_test::GroupSpec group;
+        if (i % 2 == 0)
+        {
+            group.dense.push_back({ i * 10, 336865966 + i, -1178557874 - i, {} });
+        }
+        else
+        {
+            group.ways.push_back({ i, { (i - 1) * 10, (i + 1) * 10 }, {} });
+        }
+
+        osm_test::PrimitiveBlockSpec spec;
+        spec.groups.push_back(group);
+        append(file,
+               osm_test::framed("OSMData", osm_test::zlibBlob(osm_test::primitiveBlock(spec))));
+    }
+    return file;
+}
+
+// The id a sampleFile() block was built around.
+std::int64_t firstId(const osm::Block& block)
+{
+    if (!block.nodes().empty())
+    {
+        return block.nodes().front().id / 10;
+    }
+    if (!block.ways().empty())
+    {
+        return block.ways().front().id;
+    }
+    return -1;
+}
+
+osm::PipelineOptions withThreads(std::size_t threads)
+{
+    osm::PipelineOptions options;
+    options.threads = threads;
+    return options;
+}
+
+void test_ordered_sees_file_order_at_every_thread_count()
+{
+    const Bytes file = sampleFile();
+
+    for (const std::size_t threads : kThreadCounts)
+    {
+        const std::string at = " (" + std::to_string(threads) + " threads)";
+
+        std::vector<std::int64_t> seen;
+        std::vector<std::size_t> offsets;
+        std::atomic<int> parallelCalls { 0 };
+
+        auto stats = osm::readDataBlocks(
+            file, withThreads(threads), nullptr,
+            [&](const osm::Block&, std::size_t) -> osm::Result<void> {
+                ++parallelCalls;
+                return {};
+            },
+            [&](const osm::Block& block, std::size_t offset) -> osm::Result<void> {
+                seen.push_back(firstId(block));
+                offsets.push_back(offset);
+                return {};
+            });
+
+        check(stats.has_value(), "the file reads" + at);
+        if (!stats)
+        {
+            SPDLOG_ERROR("  {}", osm::to_string(stats.error()));
+            continue;
+        }
+
+        check(stats->threads == threads, "with the thread count asked for" + at);
+        check(stats->blobs == kBlocks, "framing every data blob but not the header" + at);
+        check(stats->decoded == kBlocks, "and decoding all of them" + at);
+        check(parallelCalls == kBlocks, "the parallel stage sees every block" + at);
+
+        bool inOrder = seen.size() == kBlocks;
+        for (std::size_t i = 0; inOrder && i < seen.size(); ++i)
+        {
+            inOrder = seen[i] == static_cast<std::int64_t>(i);
+        }
+        check(inOrder, "and the ordered stage sees them in file order" + at);
+        check(std::is_sorted(offsets.begin(), offsets.end()), "at rising offsets" + at);
+    }
+}
+
+void test_the_filter_skips_decoding()
+{
+    const Bytes file = sampleFile();
+
+    for (const std::size_t threads : kThreadCounts)
+    {
+        const std::string at = " (" + std::to_string(threads) + " threads)";
+
+        std::vector<std::int64_t> seen;
+        auto stats = osm::readDataBlocks(
+            file, withThreads(threads),
+            [](const osm::BlockContents& contents) { return contents.hasWays; }, nullptr,
+            [&](const osm::Block& block, std::size_t) -> osm::Result<void> {
+                seen.push_back(firstId(block));
+                return {};
+            });
+
+        check(stats.has_value(), "a filtered read succeeds" + at);
+        if (!stats)
+        {
+            continue;
+        }
+
+        check(stats->blobs == kBlocks, "still framing every blob" + at);
+        check(stats->decoded == kBlocks / 2, "but decoding only the way blocks" + at);
+
+        bool onlyWays = seen.size() == kBlocks / 2;
+        for (std::size_t i = 0; onlyWays && i < seen.size(); ++i)
+        {
+            onlyWays = seen[i] == static_cast<std::int64_t>(2 * i + 1);
+        }
+        check(onlyWays, "and handing on only those, in order" + at);
+    }
+}
+
+// Block `kBad` is a zlib stream that does not inflate. Every worker count must
+// report it at ITS offset, having handed every block before it to `ordered` and
+// none after.
+void test_an_error_is_reported_in_file_order()
+{
+    constexpr int kBad = 57;
+
+    Bytes file;
+    append(file, osm_test::framed("OSMHeader", osm_test::rawBlob(osm_test::headerBlock({}))));
+    std::size_t badOffset = 0;
+    for (int i = 0; i < kBlocks; ++i)
+    {
+        if (i == kBad)
+        {
+            badOffset = file.size();
+            Bytes garbage;
+            osm_test::putVarintField(garbage, 2, 64);  // Blob.raw_size
+            osm_test::putLengthDelimited(garbage, 3, Bytes(16, 0xAB));  // Blob.zlib_data
+            append(file, osm_test::framed("OSMData", garbage));
+            continue;
+        }
+
+        osm_test::GroupSpec group;
+        group.dense.push_back({ i * 10, 0, 0, {} });
+        osm_test::PrimitiveBlockSpec spec;
+        spec.groups.push_back(group);
+        append(file,
+               osm_test::framed("OSMData", osm_test::zlibBlob(osm_test::primitiveBlock(spec))));
+    }
+
+    for (const std::size_t threads : kThreadCounts)
+    {
+        const std::string at = " (" + std::to_string(threads) + " threads)";
+
+        int consumed = 0;
+        auto stats = osm::readDataBlocks(file, withThreads(threads), nullptr, nullptr,
+                                         [&](const osm::Block&, std::size_t) -> osm::Result<void> {
+                                             ++consumed;
+                                             return {};
+                                         });
+
+        check(!stats.has_value(), "a block that will not inflate fails the read" + at);
+        if (stats)
+        {
+            continue;
+        }
+        check(stats.error().kind == osm::Error::Kind::Decompress, "as a zlib failure" + at);
+        check(stats.error().offset == badOffset, "at that blob's offset" + at);
+        check(consumed == kBad, "after every block before it, and none after" + at);
+    }
+}
+
+// A failing stage stops the read with its own error, from either side.
+void test_a_stage_error_stops_the_read()
+{
+    const Bytes file = sampleFile();
+
+    for (const std::size_t threads : kThreadCounts)
+    {
+        const std::string at = " (" + std::to_string(threads) + " threads)";
+
+        int consumed = 0;
+        auto fromParallel = osm::readDataBlocks(
+            file, withThreads(threads), nullptr,
+            [](const osm::Block& block, std::size_t offset) -> osm::Result<void> {
+                if (firstId(block) == 120)
+                {
+                    return osm::malformed("refused in parallel", offset);
+                }
+                return {};
+            },
+            [&](const osm::Block&, std::size_t) -> osm::Result<void> {
+                ++consumed;
+                return {};
+            });
+        check(!fromParallel.has_value() && fromParallel.error().message == "refused in parallel",
+              "a parallel stage's error is returned" + at);
+        check(consumed == 120, "once the blocks before it are consumed" + at);
+
+        consumed = 0;
+        auto fromOrdered = osm::readDataBlocks(
+            file, withThreads(threads), nullptr, nullptr,
+            [&](const osm::Block& block, std::size_t offset) -> osm::Result<void> {
+                ++consumed;
+                if (firstId(block) == 30)
+                {
+                    return osm::out_of_order("refused in order", offset);
+                }
+                return {};
+            });
+        check(!fromOrdered.has_value() && fromOrdered.error().kind == osm::Error::Kind::OutOfOrder,
+              "an ordered stage's error is returned" + at);
+        check(consumed == 31, "and nothing is consumed after it" + at);
+    }
+}
+
+// The use map_build puts it to: pass A marks from the workers, pass B fills
+// from them, and the store comes out the same as a serial build's.
+void test_node_store_passes_from_the_workers()
+{
+    const Bytes file = sampleFile();
+
+    for (const std::size_t threads : kThreadCounts)
+    {
+        const std::string at = " (" + std::to_string(threads) + " threads)";
+
+        osm::NodeStore store;
+        auto passA = osm::readDataBlocks(
+            file, withThreads(threads),
+            [](const osm::BlockContents& contents) { return contents.hasWays; },
+            [&](const osm::Block& block, std::size_t) -> osm::Result<void> {
+                for (const osm::Way& way : block.ways())
+                {
+                    store.markReferenced(block.refs(way));
+                }
+                return {};
+            },
+            nullptr);
+        check(passA.has_value(), "pass A runs on the workers" + at);
+        check(store.finalise().has_value(), "and the store finalises" + at);
+
+        auto passB = osm::readDataBlocks(
+            file, withThreads(threads), nullptr,
+            [&](const osm::Block& block, std::size_t) -> osm::Result<void> {
+                store.set(block.nodes());
+                return {};
+            },
+            nullptr);
+        check(passB.has_value(), "pass B runs on the workers" + at);
+
+        // Odd block i references nodes (i-1)*10 and (i+1)*10: every even
+        // block's node except the one past the end, which is absent.
+        const osm::NodeStore::Stats stats = store.stats();
+        check(stats.referenced == kBlocks / 2 + 1, "every referenced node is marked once" + at);
+        check(stats.resolved == kBlocks / 2, "and every one in the file resolves" + at);
+
+        bool all = true;
+        for (int i = 0; i < kBlocks; i += 2)
+        {
+            auto coord = store.get(std::int64_t { i } * 10);
+            all = all && coord.has_value() && coord->first == 336865966 + i &&
+                  coord->second == -1178557874 - i;
+        }
+        check(all, "with the coordinate its own block gave it" + at);
+        check(!store.get(std::int64_t { kBlocks } * 10).has_value(),
+              "and the one past the end is absent" + at);
+    }
+}
+
+} // namespace
+
+int main()
+{
+    spdlog::set_level(spdlog::level::info);
+    spdlog::set_pattern("[%^%l%$] %v");
+
+    test_ordered_sees_file_order_at_every_thread_count();
+    test_the_filter_skips_decoding();
+    test_an_error_is_reported_in_file_order();
+    test_a_stage_error_stops_the_read();
+    test_node_store_passes_from_the_workers();
+
+    if (failures != 0)
+    {
+        SPDLOG_ERROR("{} check(s) failed", failures);
+        return 1;
+    }
+
+    SPDLOG_INFO("all block pipeline checks passed");
+    return 0;
+}
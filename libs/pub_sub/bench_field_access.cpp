@@ -0,0 +1,217 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//
+// What reading a sample's fields costs, per schema, through the direct
+// data-section path and through capnp's dynamic API.
+//
+// NOT a test -- it asserts nothing and always exits 0. It exists because
+// FieldAccess::Direct is a claim about time: that a field whose offset the
+// schema fixes is cheaper to read as a load than as a DynamicStruct::get(). Only
+// a measurement shows how much, and for which shapes of message.
+// test_expression_evaluator is what shows the two read the same values.
+//
+// For every schema in the registry, binds every plain numeric field -- and, for
+// a $fixedLength list, its last element and its sum -- into one
+// ExpressionEvaluatorSet per path, then evaluates a filled message through each
+// set over and over. Both sets decode the same bytes and run the same exprtk
+// expressions, so the difference between the columns is field access alone.
+//
+//   pub_sub_bench_field_access
+//   pub_sub_bench_field_access --iterations 200000
+//
+// What each column means:
+//
+//   fields    expressions bound, one per field (two per list)
+//   direct    ns per sample, FieldAccess::Direct
+//   dynamic   ns per sample, FieldAccess::Dynamic -- what every sample cost
+//             before the direct path existed
+//   speedup   dynamic / direct
+
+#include "pub_sub/capnp_json.h"
+#include "pub_sub/expression_evaluator.h"
+#include "pub_sub/schema_registry.h"
+#include "reflection/reflection.h"
+
+#include <capnp/dynamic.h>
+#include <capnp/message.h>
+#include <capnp/serialize.h>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+int argumentAfter(int argc, char** argv, const std::string& flag, int fallback)
+{
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (flag == argv[i])
+        {
+            return std::atoi(argv[i + 1]);
+        }
+    }
+    return fallback;
+}
+
+// Something other than the default for one element or field of `type`, or VOID
+// for a type no expression can read.
+capnp::DynamicValue::Reader sampleValue(capnp::Type type, unsigned seed)
+{
+    if (type.isBool())
+    {
+        return seed % 2 == 1;
+    }
+    if (type.isInt8() || type.isInt16() || type.isInt32() || type.isInt64())
+    {
+        return -static_cast<std::int64_t>(seed % 100) - 1;
+    }
+    if (type.isUInt8() || type.isUInt16() || type.isUInt32() || type.isUInt64())
+    {
+        return static_cast<std::uint64_t>(seed % 200) + 1;
+    }
+    if (type.isFloat32() || type.isFloat64())
+    {
+        return 0.25 * seed + 0.5;
+    }
+    if (type.isEnum())
+    {
+        const auto enumerants = type.asEnum().getEnumerants();
+        return capnp::DynamicEnum(enumerants[seed % enumerants.size()]);
+    }
+    return capnp::VOID;
+}
+
+bool readable(capnp::Type type)
+{
+    return sampleValue(type, 1).getType() != capnp::DynamicValue::VOID;
+}
+
+struct Workload
+{
+    std::vector<std::string> expressions;
+    std::vector<std::uint8_t> payload;
+};
+
+// Every bindable field of `schema`, and a message with all of them set.
+Workload workloadFor(capnp::StructSchema schema)
+{
+    Workload workload;
+    capnp::MallocMessageBuilder message;
+    auto root = message.initRoot<capnp::DynamicStruct>(schema);
+
+    for (auto field : schema.getNonUnionFields())
+    {
+        const std::string name = field.getProto().getName().cStr();
+        const auto type = field.getType();
+        if (type.isList())
+        {
+            const auto length = pub_sub::fixedListLength(field);
+            const auto element = type.asList().getElementType();
+            if (!length || *length == 0 || !readable(element))
+            {
+                continue;
+            }
+            auto list = root.init(field, *length).as<capnp::DynamicList>();
+            for (unsigned i = 0; i < *length; ++i)
+            {
+                list.set(i, sampleValue(element, 3 + i));
+            }
+            workload.expressions.push_back(name + "[" + std::to_string(*length - 1) + "]");
+            workload.expressions.push_back("sum(" + name + ")");
+        }
+        else if (readable(type))
+        {
+            root.set(field, sampleValue(type, 3 + field.getIndex()));
+            workload.expressions.push_back(name);
+        }
+    }
+
+    const kj::Array<capnp::word> words = capnp::messageToFlatArray(message);
+    const kj::ArrayPtr<const kj::byte> bytes = words.asBytes();
+    workload.payload.assign(bytes.begin(), bytes.end());
+    return workload;
+}
+
+// ns per sample over `iterations` evaluations, after a short warm-up.
+double timePerSample(pub_sub::ExpressionEvaluatorSet& set, const std::vector<std::uint8_t>& payload,
+                     int iterations, double& sink)
+{
+    std::vector<std::optional<double>> results(set.size());
+    for (int i = 0; i < iterations / 10 + 1; ++i)
+    {
+        set.evaluateToDouble(payload, results);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        set.evaluateToDouble(payload, results);
+        sink += results.empty() || !results.front() ? 0.0 : *results.front();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    const int iterations = std::max(1, argumentAfter(argc, argv, "--iterations", 50000));
+
+    SPDLOG_INFO("{:<40} {:>6} {:>10} {:>10} {:>8}", "schema", "fields", "direct", "dynamic",
+                "speedup");
+
+    double sink = 0.0;
+    double total_direct = 0.0;
+    double total_dynamic = 0.0;
+    for (const pub_sub::schema_type_t type :
+         reflection::enum_traits<pub_sub::schema_type_t>::values())
+    {
+        const auto schema = pub_sub::get_schema(type);
+        if (!schema || !schema->getProto().isStruct())
+        {
+            continue;
+        }
+
+        const Workload workload = workloadFor(schema->asStruct());
+        if (workload.expressions.empty())
+        {
+            continue;
+        }
+
+        const std::string name(reflection::enum_to_string(type));
+        // Quiet while compiling: a field named like an exprtk function fails to
+        // compile on both paths alike, and its error is noise here.
+        spdlog::set_level(spdlog::level::off);
+        pub_sub::ExpressionEvaluatorSet direct(type, workload.expressions, name,
+                                               pub_sub::FieldAccess::Direct);
+        pub_sub::ExpressionEvaluatorSet dynamic(type, workload.expressions, name,
+                                                pub_sub::FieldAccess::Dynamic);
+        spdlog::set_level(spdlog::level::info);
+
+        const double direct_ns = timePerSample(direct, workload.payload, iterations, sink);
+        const double dynamic_ns = timePerSample(dynamic, workload.payload, iterations, sink);
+        total_direct += direct_ns;
+        total_dynamic += dynamic_ns;
+
+        SPDLOG_INFO("{:<40} {:>6} {:>8.1f}ns {:>8.1f}ns {:>7.2f}x", name,
+                    workload.expressions.size(), direct_ns, dynamic_ns, dynamic_ns / direct_ns);
+    }
+
+    if (total_direct > 0.0)
+    {
+        SPDLOG_INFO("{:<40} {:>6} {:>8.1f}ns {:>8.1f}ns {:>7.2f}x", "all schemas, summed", "",
+                    total_direct, total_dynamic, total_dynamic / total_direct);
+    }
+
+    // Keeps the optimiser from deciding the results were never looked at.
+    SPDLOG_DEBUG("{}", sink);
+    return 0;
+}
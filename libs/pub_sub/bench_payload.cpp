@@ -0,0 +1,348 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//
+// What a payload costs to move between two processes, by size and by where the
+// publisher's buffer came from.
+//
+// NOT a test -- it asserts nothing and always exits 0. It exists because the
+// SHM threshold in session_manager.cpp, and every per-publisher override of it,
+// is a measured decision, and this is the measurement.
+//
+// Each case runs a real publisher and a real subscriber in two forked processes
+// on one host, which is the only arrangement in which shared memory does
+// anything. Sizes are the three that matter in this tree: a median CarPlay
+// video frame, a large keyframe, and a downtown map tile reply. Each size runs
+// twice:
+//
+//   heap   the payload is built on the heap, and zenoh copies it into its SHM
+//          pool if it is over the transport threshold -- how everything was
+//          published before PayloadBuffer
+//   shm    the payload is built straight into the SHM pool, whatever its size
+//
+//   pub_sub_bench_payload
+//   pub_sub_bench_payload --count 200
+//
+// What each column means:
+//
+//   latency   publish to subscriber callback, from a steady_clock stamp the
+//             publisher writes into ptsUsec. Both processes read the same
+//             CLOCK_MONOTONIC, so no clock offset is involved.
+//   pub/sub   user+system CPU per message in each process, from getrusage().
+//   in-pool   whether the publisher's buffer for this size actually came from
+//             the pool. "no" under `shm` means the build has no SHM provider or
+//             the pool could not be mapped, and the row measures the heap.
+//   aligned   samples the subscriber could decode in place. A misaligned one
+//             is copied by WordAlignedPayload before capnp can read it.
+
+#include "pub_sub/capnp_payload.h"
+#include "pub_sub/detail/payload_buffer.h"
+#include "pub_sub/raw_subscriber.h"
+#include "pub_sub/zenoh_publisher.h"
+
+#include "carplay_video.capnp.h"
+
+#include <capnp/serialize.h>
+
+#include <spdlog/spdlog.h>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+struct Case
+{
+    const char* name;
+    std::size_t bytes;
+    // Between puts. Slow enough that the subscriber is never the bottleneck,
+    // because what is being measured is one message's cost, not throughput.
+    std::chrono::microseconds interval;
+};
+
+constexpr Case kCases[] = {
+    {"15 KB", 15 * 1024, std::chrono::microseconds(2000)},
+    {"180 KB", 180 * 1024, std::chrono::microseconds(5000)},
+    {"9 MB", 9 * 1024 * 1024, std::chrono::microseconds(40000)},
+};
+
+// What each child reports back to the parent over a pipe. Plain data, so a
+// single write() and read() carry it.
+struct SubscriberResult
+{
+    std::uint64_t received = 0;
+    std::uint64_t aligned = 0;
+    std::uint64_t cpu_usec = 0;
+    double latency_median_usec = 0;
+    double latency_p99_usec = 0;
+};
+
+struct PublisherResult
+{
+    std::uint64_t sent = 0;
+    std::uint64_t cpu_usec = 0;
+    bool in_pool = false;
+};
+
+std::uint64_t cpuMicros()
+{
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    const auto micros = [](const timeval& tv) {
+        return static_cast<std::uint64_t>(tv.tv_sec) * 1000000u +
+               static_cast<std::uint64_t>(tv.tv_usec);
+    };
+    return micros(usage.ru_utime) + micros(usage.ru_stime);
+}
+
+std::uint64_t steadyMicros()
+{
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                          std::chrono::steady_clock::now().time_since_epoch())
+                                          .count());
+}
+
+double percentile(std::vector<double>& values, double p)
+{
+    if (values.empty())
+    {
+        return 0.0;
+    }
+    const auto index = static_cast<std::size_t>(p * static_cast<double>(values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(index),
+                     values.end());
+    return values[index];
+}
+
+// The subscriber child. Signals `ready_fd` once declared, then takes samples
+// until it has `count` or the bus goes quiet.
+SubscriberResult runSubscriber(const std::string& key, std::uint64_t count, int ready_fd)
+{
+    std::mutex mutex;
+    std::vector<double> latencies;
+    latencies.reserve(count);
+    std::atomic<std::uint64_t> aligned{0};
+    std::atomic<std::uint64_t> last_arrival{0};
+
+    std::uint64_t cpu_before = 0;
+    {
+        pub_sub::RawSubscriber subscriber(
+            key, pub_sub::RawSubscriber::Handler(
+                     [&](std::span<const std::uint8_t> payload, std::string_view)
+                     {
+                         const std::uint64_t now = steadyMicros();
+
+                         // Decode the way every real consumer does, so the
+                         // cost of a misaligned payload is in the numbers.
+                         if (reinterpret_cast<std::uintptr_t>(payload.data()) %
+                                 sizeof(capnp::word) ==
+                             0)
+                         {
+                             aligned.fetch_add(1, std::memory_order_relaxed);
+                         }
+                         const pub_sub::WordAlignedPayload words(payload);
+                         if (words.empty())
+                         {
+                             return;
+                         }
+                         capnp::ReaderOptions options;
+                         options.traversalLimitInWords = std::numeric_limits<std::uint64_t>::max();
+                         capnp::FlatArrayMessageReader reader(words.words(), options);
+                         const auto video = reader.getRoot<CarPlayVideo>();
+
+                         const std::lock_guard<std::mutex> lock(mutex);
+                         latencies.push_back(static_cast<double>(now - video.getPtsUsec()));
+                         last_arrival.store(now, std::memory_order_relaxed);
+                     }));
+
+        cpu_before = cpuMicros();
+        const char ready = 1;
+        (void)!write(ready_fd, &ready, 1);
+
+        // Done when everything arrived, or nothing has for two seconds after
+        // something did; zenoh promises no delivery, so a lost sample must not
+        // hang the benchmark.
+        const auto start = std::chrono::steady_clock::now();
+        while (true)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            std::uint64_t got = 0;
+            {
+                const std::lock_guard<std::mutex> lock(mutex);
+                got = latencies.size();
+            }
+            if (got >= count)
+            {
+                break;
+            }
+            const std::uint64_t last = last_arrival.load(std::memory_order_relaxed);
+            if (last != 0 && steadyMicros() - last > 2000000)
+            {
+                break;
+            }
+            if (last == 0 && std::chrono::steady_clock::now() - start > std::chrono::seconds(10))
+            {
+                break;
+            }
+        }
+    }
+
+    SubscriberResult result;
+    result.cpu_usec = cpuMicros() - cpu_before;
+    result.received = latencies.size();
+    result.aligned = aligned.load();
+    result.latency_median_usec = percentile(latencies, 0.5);
+    result.latency_p99_usec = percentile(latencies, 0.99);
+    return result;
+}
+
+// The publisher child. Waits for `ready_fd`, then for the pair to match, then
+// puts `count` messages of `bytes` each.
+PublisherResult runPublisher(const std::string& key, const Case& c, std::uint64_t count,
+                             std::size_t shm_min_bytes, int ready_fd)
+{
+    char ready = 0;
+    (void)!read(ready_fd, &ready, 1);
+
+    PublisherResult result;
+    result.in_pool = pub_sub::detail::PayloadBuffer::allocate(c.bytes, shm_min_bytes)
+                         .inSharedMemory();
+
+    pub_sub::ZenohPublisher<CarPlayVideo> pub(key);
+    pub.setSharedMemoryMinBytes(shm_min_bytes);
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));  // let the pair match
+
+    const std::uint64_t cpu_before = cpuMicros();
+    for (std::uint64_t seq = 0; seq < count; ++seq)
+    {
+        auto& fields = pub.fields();
+        fields.setSeq(static_cast<std::uint32_t>(seq));
+        fields.setCodec(CarPlayVideo::Codec::H264);
+        auto data = fields.initData(static_cast<unsigned>(c.bytes));
+        std::memset(data.begin(), static_cast<int>(seq & 0xFF), data.size());
+        // Stamped last, so building the message is not counted as transport.
+        fields.setPtsUsec(steadyMicros());
+        pub.put();
+        ++result.sent;
+        std::this_thread::sleep_for(c.interval);
+    }
+    result.cpu_usec = cpuMicros() - cpu_before;
+    return result;
+}
+
+template <typename Result>
+bool readResult(int fd, Result& out)
+{
+    return read(fd, &out, sizeof(out)) == static_cast<ssize_t>(sizeof(out));
+}
+
+template <typename Result>
+void writeResult(int fd, const Result& result)
+{
+    (void)!write(fd, &result, sizeof(result));
+}
+
+// Runs one case in two fresh processes. The parent never opens a session: a
+// process that has started zenoh's runtime threads cannot safely fork another
+// that uses it.
+void runCase(const Case& c, const char* mode, std::size_t shm_min_bytes, std::uint64_t count)
+{
+    const std::string key = std::string("bench/pub_sub/payload/") + mode + "/" +
+                            std::to_string(c.bytes);
+
+    int ready[2];
+    int sub_out[2];
+    int pub_out[2];
+    if (pipe(ready) != 0 || pipe(sub_out) != 0 || pipe(pub_out) != 0)
+    {
+        SPDLOG_ERROR("pipe() failed: {}", std::strerror(errno));
+        return;
+    }
+
+    const pid_t sub_pid = fork();
+    if (sub_pid == 0)
+    {
+        writeResult(sub_out[1], runSubscriber(key, count, ready[1]));
+        _exit(0);
+    }
+
+    const pid_t pub_pid = fork();
+    if (pub_pid == 0)
+    {
+        writeResult(pub_out[1], runPublisher(key, c, count, shm_min_bytes, ready[0]));
+        _exit(0);
+    }
+
+    close(ready[0]);
+    close(ready[1]);
+    close(sub_out[1]);
+    close(pub_out[1]);
+
+    PublisherResult pub;
+    SubscriberResult sub;
+    const bool have_pub = readResult(pub_out[0], pub);
+    const bool have_sub = readResult(sub_out[0], sub);
+    close(pub_out[0]);
+    close(sub_out[0]);
+    waitpid(pub_pid, nullptr, 0);
+    waitpid(sub_pid, nullptr, 0);
+
+    if (!have_pub || !have_sub || sub.received == 0)
+    {
+        SPDLOG_INFO("  {:<7} {:<5} no samples arrived -- is a zenoh session possible here?",
+                    c.name, mode);
+        return;
+    }
+
+    SPDLOG_INFO("  {:<7} {:<5} latency median {:8.1f} us  p99 {:8.1f} us   "
+                "pub {:7.1f} us/msg   sub {:7.1f} us/msg   in-pool {:<3}   "
+                "aligned {}/{}",
+                c.name, mode, sub.latency_median_usec, sub.latency_p99_usec,
+                static_cast<double>(pub.cpu_usec) / static_cast<double>(pub.sent),
+                static_cast<double>(sub.cpu_usec) / static_cast<double>(sub.received),
+                pub.in_pool ? "yes" : "no", sub.aligned, sub.received);
+}
+
+std::string argumentAfter(int argc, char** argv, const std::string& flag,
+                          const std::string& fallback)
+{
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (flag == argv[i])
+        {
+            return argv[i + 1];
+        }
+    }
+    return fallback;
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    const auto count =
+        static_cast<std::uint64_t>(std::atoll(argumentAfter(argc, argv, "--count", "500").c_str()));
+
+    SPDLOG_INFO("{} messages per case, publisher and subscriber in separate processes", count);
+    for (const Case& c : kCases)
+    {
+        // heap: nothing comes from the pool, so a large payload takes the
+        // transport's copy-into-SHM path exactly as it did before PayloadBuffer.
+        runCase(c, "heap", std::numeric_limits<std::size_t>::max(), count);
+        runCase(c, "shm", 0, count);
+    }
+    return 0;
+}
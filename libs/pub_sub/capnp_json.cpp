@@ -292,7 +292,7 @@ void setField(capnp::DynamicStruct::Builder builder, capnp::StructSchema::Field
 
 }  // namespace
 
-json capnpToJson(const std::vector<std::uint8_t>& bytes, capnp::Schema schema)
+json capnpToJson(std::span<const std::uint8_t> bytes, capnp::Schema schema)
 {
     // This used to copy into a word-aligned buffer unconditionally, which was
     // safe but paid for a heap allocation on every sample. WordAlignedPayload
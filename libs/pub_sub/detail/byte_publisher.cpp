@@ -44,6 +44,9 @@ struct BytePublisher::Impl
     // encoding stamped on every sample: they are derived from the same two
     // arguments.
     std::optional<zenoh::LivelinessToken> advertisement;
+
+    // See setSharedMemoryMinBytes().
+    std::size_t shm_min_bytes = kSharedMemoryMinBytes;
 };
 
 BytePublisher::BytePublisher(std::string_view keyexpr, std::string_view schema_name) :
@@ -116,27 +119,21 @@ std::string_view BytePublisher::keyexpr() const
 
 void BytePublisher::put(kj::Array<capnp::word> payload)
 {
-    if (impl_->publisher == nullptr)
+    put(PayloadBuffer(kj::mv(payload)));
+}
+
+PayloadBuffer BytePublisher::allocate(std::size_t bytes) const
+{
+    return PayloadBuffer::allocate(bytes, impl_->shm_min_bytes);
+}
+
+void BytePublisher::put(PayloadBuffer payload)
+{
+    if (impl_->publisher == nullptr || payload.empty())
     {
         return;
     }
 
-    // Zero-copy handover. The owning kj::Array moves into a shared_ptr that the
-    // deleter lambda captures; zenoh stores that callable and invokes it when it
-    // is done with the payload, which destroys the lambda, the shared_ptr, and
-    // finally the buffer -- at the right time rather than at the end of this
-    // function. The uint8_t* the deleter is handed is ignored: it only ever
-    // aliases memory the captured array owns.
-    auto owner = std::make_shared<kj::Array<capnp::word>>(kj::mv(payload));
-    const auto bytes = owner->asBytes();
-    auto* const ptr = reinterpret_cast<std::uint8_t*>(const_cast<kj::byte*>(bytes.begin()));
-    const std::size_t len = bytes.size();
-
-    auto deleter = [owner = std::move(owner)](std::uint8_t*) noexcept {
-        // Nothing to do: `owner` is destroyed with this lambda, freeing the
-        // buffer.
-    };
-
     auto opts = zenoh::Publisher::PutOptions::create_default();
     opts.encoding.emplace(kCapnpEncodingMime);
     // set_schema() takes a string_view, so this makes no temporary.
@@ -144,7 +141,9 @@ void BytePublisher::put(kj::Array<capnp::word> payload)
 
     try
     {
-        impl_->publisher->put(zenoh::Bytes(ptr, len, std::move(deleter)), std::move(opts));
+        // Ownership goes with it -- see intoZenohBytes(). zenoh may hold the
+        // payload long after this returns.
+        impl_->publisher->put(intoZenohBytes(std::move(payload)), std::move(opts));
     }
     catch (const std::exception& e)
     {
@@ -152,6 +151,16 @@ void BytePublisher::put(kj::Array<capnp::word> payload)
     }
 }
 
+void BytePublisher::setSharedMemoryMinBytes(std::size_t bytes)
+{
+    impl_->shm_min_bytes = bytes;
+}
+
+std::size_t BytePublisher::sharedMemoryMinBytes() const
+{
+    return impl_->shm_min_bytes;
+}
+
 bool BytePublisher::hasSubscribers() const
 {
     if (impl_->publisher == nullptr)
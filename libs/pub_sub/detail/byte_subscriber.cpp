@@ -11,7 +11,9 @@
 #include <spdlog/spdlog.h>
 
 #include <memory>
+#include <span>
 #include <utility>
+#include <vector>
 
 namespace pub_sub::detail
 {
@@ -123,7 +125,25 @@ ByteSubscriber::ByteSubscriber(const std::string& keyexpr, Handler on_sample) :
                             return;
                         }
                         const ZenohSampleMeta meta(sample);
-                        impl->handler(sample.get_payload().as_vector(), meta);
+
+                        // In place whenever zenoh holds the payload in one
+                        // piece, which is every SHM payload and nearly every
+                        // other. This used to be as_vector() for every sample:
+                        // a heap allocation and a full copy, per message, to
+                        // produce bytes identical to the ones already there.
+                        // Only a payload zenoh holds in several pieces is
+                        // joined, which is the same single copy as before.
+                        const zenoh::Bytes& payload = sample.get_payload();
+                        auto slices = payload.slice_iter();
+                        const auto first = slices.next();
+                        if (first.has_value() && !slices.next().has_value())
+                        {
+                            impl->handler(std::span<const std::uint8_t>(first->data, first->len),
+                                          meta);
+                            return;
+                        }
+                        const std::vector<std::uint8_t> joined = payload.as_vector();
+                        impl->handler(joined, meta);
                     }
                     catch (const std::exception& e)
                     {
@@ -0,0 +1,189 @@
+#include "pub_sub/detail/payload_buffer.h"
+
+#include <zenoh.hxx>
+
+#include <spdlog/spdlog.h>
+
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <variant>
+
+// zenoh-c only declares its SHM provider API when it was built with both the
+// `shared-memory` and `unstable` cargo features -- see third_party/zenoh-c.cmake.
+// Without them every buffer is a heap buffer and the rest of this file is the
+// same as before it existed.
+#if defined(Z_FEATURE_SHARED_MEMORY) && defined(Z_FEATURE_UNSTABLE_API)
+#define PUB_SUB_HAVE_SHM_PROVIDER 1
+#else
+#define PUB_SUB_HAVE_SHM_PROVIDER 0
+#endif
+
+namespace pub_sub::detail
+{
+
+namespace
+{
+
+#if PUB_SUB_HAVE_SHM_PROVIDER
+
+// How much shared memory the process maps for outgoing payloads. It has to hold
+// everything in flight at once -- a buffer is only returned to the pool once
+// every subscriber has let go of it -- and the largest single thing put through
+// it is a 9.4 MB tile reply, so this is a few of those. An exhausted pool is not
+// an error: allocate() falls back to the heap and the transport copies, which is
+// where every payload was before.
+constexpr std::size_t kPoolBytes = 32 * 1024 * 1024;
+
+// 2^3 = 8 bytes: a capnp word, so a reader can take the buffer as it is.
+const zenoh::AllocAlignment kWordAlignment{3};
+
+// Created on the first buffer big enough to want it, and never torn down: the
+// buffers it hands out are owned by zenoh payloads that may outlive anything
+// else in the process, and must never outlive the provider they came from.
+zenoh::PosixShmProvider* provider()
+{
+    static std::once_flag once;
+    static zenoh::PosixShmProvider* instance = nullptr;
+    std::call_once(once, [] {
+        try
+        {
+            instance = new zenoh::PosixShmProvider(zenoh::MemoryLayout(kPoolBytes, kWordAlignment));
+            SPDLOG_DEBUG("Mapped a {} MB SHM pool for outgoing payloads", kPoolBytes >> 20);
+        }
+        catch (const std::exception& e)
+        {
+            // No /dev/shm, or a limit on it. Said once, because every large
+            // payload for the life of the process is about to take the heap
+            // path instead.
+            SPDLOG_WARN("No SHM pool for outgoing payloads ({}); large payloads will be copied "
+                        "by the transport instead",
+                        e.what());
+        }
+    });
+    return instance;
+}
+
+#endif
+
+std::size_t roundUpToWords(std::size_t bytes)
+{
+    return (bytes + sizeof(capnp::word) - 1) / sizeof(capnp::word);
+}
+
+}  // namespace
+
+struct PayloadBuffer::Impl
+{
+    // Exactly one of these holds the payload.
+    kj::Array<capnp::word> heap;
+#if PUB_SUB_HAVE_SHM_PROVIDER
+    std::optional<zenoh::ZShmMut> shm;
+#endif
+
+    std::span<std::uint8_t> bytes;
+};
+
+PayloadBuffer::PayloadBuffer(std::unique_ptr<Impl> impl) : impl_(std::move(impl)) {}
+
+PayloadBuffer::PayloadBuffer(kj::Array<capnp::word> words) : impl_(std::make_unique<Impl>())
+{
+    impl_->bytes = std::span<std::uint8_t>(reinterpret_cast<std::uint8_t*>(words.begin()),
+                                           words.size() * sizeof(capnp::word));
+    impl_->heap = kj::mv(words);
+}
+
+PayloadBuffer::PayloadBuffer(PayloadBuffer&&) noexcept = default;
+PayloadBuffer& PayloadBuffer::operator=(PayloadBuffer&&) noexcept = default;
+PayloadBuffer::~PayloadBuffer() = default;
+
+PayloadBuffer PayloadBuffer::allocate(std::size_t bytes, std::size_t shm_min_bytes)
+{
+    const std::size_t words = roundUpToWords(bytes);
+
+#if PUB_SUB_HAVE_SHM_PROVIDER
+    if (bytes >= shm_min_bytes && words != 0)
+    {
+        if (zenoh::PosixShmProvider* const pool = provider())
+        {
+            // Non-blocking on purpose. A publisher waiting for subscribers to
+            // release pool memory would make a slow reader stall the bus; the
+            // heap costs one extra copy and never waits.
+            auto result = pool->alloc_gc_defrag(words * sizeof(capnp::word), kWordAlignment);
+            if (auto* const shm = std::get_if<zenoh::ZShmMut>(&result))
+            {
+                auto impl = std::make_unique<Impl>();
+                impl->bytes = std::span<std::uint8_t>(shm->data(), words * sizeof(capnp::word));
+                impl->shm.emplace(std::move(*shm));
+                return PayloadBuffer(std::move(impl));
+            }
+        }
+    }
+#else
+    (void)shm_min_bytes;
+#endif
+
+    // capnp requires the padding of a short final word to be zero, and a heap
+    // array is not; the rest the caller overwrites.
+    kj::Array<capnp::word> heap = kj::heapArray<capnp::word>(words);
+    if (words != 0)
+    {
+        std::memset(heap.end() - 1, 0, sizeof(capnp::word));
+    }
+    return PayloadBuffer(kj::mv(heap));
+}
+
+std::span<std::uint8_t> PayloadBuffer::bytes() const
+{
+    return impl_ ? impl_->bytes : std::span<std::uint8_t>{};
+}
+
+bool PayloadBuffer::empty() const
+{
+    return bytes().empty();
+}
+
+bool PayloadBuffer::inSharedMemory() const
+{
+#if PUB_SUB_HAVE_SHM_PROVIDER
+    return impl_ && impl_->shm.has_value();
+#else
+    return false;
+#endif
+}
+
+zenoh::Bytes intoZenohBytes(PayloadBuffer&& buffer)
+{
+    std::unique_ptr<PayloadBuffer::Impl> impl = std::move(buffer.impl_);
+    if (!impl)
+    {
+        return zenoh::Bytes();
+    }
+
+#if PUB_SUB_HAVE_SHM_PROVIDER
+    if (impl->shm.has_value())
+    {
+        // The buffer goes as itself. zenoh sends a reference to the pool to a
+        // subscriber on this host and the bytes to anyone further away, and
+        // the chunk returns to the pool once every holder has dropped it.
+        return zenoh::Bytes(std::move(*impl->shm));
+    }
+#endif
+
+    // Zero-copy handover of a heap array. The Impl moves into a shared_ptr that
+    // the deleter captures; zenoh stores that callable and invokes it when it
+    // is done with the payload, which destroys the lambda, the shared_ptr, and
+    // finally the buffer -- at the right time rather than at the end of this
+    // function. The uint8_t* the deleter is handed is ignored: it only ever
+    // aliases memory the captured array owns.
+    const std::span<std::uint8_t> bytes = impl->bytes;
+    auto owner = std::shared_ptr<PayloadBuffer::Impl>(std::move(impl));
+    auto deleter = [owner = std::move(owner)](std::uint8_t*) noexcept {
+        // Nothing to do: `owner` is destroyed with this lambda, freeing the
+        // buffer.
+    };
+    return zenoh::Bytes(bytes.data(), bytes.size(), std::move(deleter));
+}
+
+}  // namespace pub_sub::detail
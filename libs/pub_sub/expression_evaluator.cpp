@@ -6,6 +6,7 @@
 #include "pub_sub/capnp_payload.h"
 #include "reflection/reflection.h"
 
+#include <capnp/any.h>
 #include <capnp/dynamic.h>
 #include <capnp/schema.h>
 #include <capnp/serialize.h>
@@ -16,7 +17,9 @@
 #include <spdlog/spdlog.h>
 
 #include <algorithm>
+#include <bit>
 #include <cmath>
+#include <cstring>
 #include <map>
 #include <optional>
 #include <string>
@@ -109,9 +112,302 @@ double numericFrom(const capnp::DynamicValue::Reader& value, capnp::DynamicValue
     return 0.0;
 }
 
-}  // namespace
+// How extract() reads one value: the width and meaning of the bits at a place
+// in the struct that the schema fixes, so no per-sample lookup is needed.
+//
+// WHY NOT DynamicStruct::get() for everything. It is correct for every field
+// there is, and it pays for that on every read: the field's schema node, a
+// union check, a type switch, a DynamicValue boxed and unboxed -- per variable,
+// per sample. A primitive field of a struct has none of that variability. Its
+// offset in the data section and its type are properties of the SCHEMA, known
+// when the expression is compiled, so reading it is a bounds check and a load.
+//
+// `Dynamic` is the fallback, for a field whose place is a property of the
+// MESSAGE: a member of an unnamed union, which is only there when the
+// discriminant says so.
+enum class Access : std::uint8_t
+{
+    Dynamic,
+    Bool,
+    Int8,
+    Int16,
+    Int32,
+    Int64,
+    UInt8,
+    UInt16,
+    UInt32,
+    UInt64,
+    Float32,
+    Float64,
+};
 
-struct ExpressionEvaluator::Impl
+// capnp's wire format is little-endian, and the direct path loads it with
+// memcpy. On a big-endian host every field takes the dynamic path instead,
+// which byte-swaps properly; nothing in this tree runs on one, but a wrong
+// number is not how that should be discovered.
+constexpr bool kLittleEndianHost = std::endian::native == std::endian::little;
+
+// The direct Access for a primitive type, or Dynamic for anything else. An enum
+// is its ordinal, stored as a UInt16.
+Access directAccessOf(const capnp::Type& type)
+{
+    if (type.isBool())
+    {
+        return Access::Bool;
+    }
+    if (type.isInt8())
+    {
+        return Access::Int8;
+    }
+    if (type.isInt16())
+    {
+        return Access::Int16;
+    }
+    if (type.isInt32())
+    {
+        return Access::Int32;
+    }
+    if (type.isInt64())
+    {
+        return Access::Int64;
+    }
+    if (type.isUInt8())
+    {
+        return Access::UInt8;
+    }
+    if (type.isUInt16() || type.isEnum())
+    {
+        return Access::UInt16;
+    }
+    if (type.isUInt32())
+    {
+        return Access::UInt32;
+    }
+    if (type.isUInt64())
+    {
+        return Access::UInt64;
+    }
+    if (type.isFloat32())
+    {
+        return Access::Float32;
+    }
+    if (type.isFloat64())
+    {
+        return Access::Float64;
+    }
+    return Access::Dynamic;
+}
+
+// A primitive field's default, as the bits capnp XORs the stored value with.
+//
+// capnp stores (value ^ default), so that an all-zero data section reads as
+// every field's default. Every numeric field in schemas/ defaults to zero
+// today, where the XOR is a no-op -- which is exactly why leaving it out would
+// pass every test until the first schema that writes `= 5`.
+std::uint64_t defaultBitsOf(capnp::schema::Value::Reader value)
+{
+    if (value.isBool())
+    {
+        return value.getBool() ? 1u : 0u;
+    }
+    if (value.isInt8())
+    {
+        return static_cast<std::uint8_t>(value.getInt8());
+    }
+    if (value.isInt16())
+    {
+        return static_cast<std::uint16_t>(value.getInt16());
+    }
+    if (value.isInt32())
+    {
+        return static_cast<std::uint32_t>(value.getInt32());
+    }
+    if (value.isInt64())
+    {
+        return static_cast<std::uint64_t>(value.getInt64());
+    }
+    if (value.isUint8())
+    {
+        return value.getUint8();
+    }
+    if (value.isUint16())
+    {
+        return value.getUint16();
+    }
+    if (value.isUint32())
+    {
+        return value.getUint32();
+    }
+    if (value.isUint64())
+    {
+        return value.getUint64();
+    }
+    if (value.isFloat32())
+    {
+        return std::bit_cast<std::uint32_t>(value.getFloat32());
+    }
+    if (value.isFloat64())
+    {
+        return std::bit_cast<std::uint64_t>(value.getFloat64());
+    }
+    if (value.isEnum())
+    {
+        return value.getEnum();
+    }
+    return 0;
+}
+
+// The value at `offset` -- in units of its own width, as capnp numbers slots --
+// with the default XOR'd back out.
+//
+// A data section too short to hold the field reads as the default, exactly as
+// capnp's own accessors do: that is a message from a publisher built against an
+// older schema that did not have the field yet.
+template <typename Bits>
+Bits dataBits(kj::ArrayPtr<const kj::byte> data, std::uint32_t offset, std::uint64_t defaults)
+{
+    Bits raw = 0;
+    const std::size_t at = static_cast<std::size_t>(offset) * sizeof(Bits);
+    if (at + sizeof(Bits) <= data.size())
+    {
+        std::memcpy(&raw, data.begin() + at, sizeof(Bits));
+    }
+    return static_cast<Bits>(raw ^ static_cast<Bits>(defaults));
+}
+
+double directValue(Access access, std::uint32_t offset, std::uint64_t defaults,
+                   kj::ArrayPtr<const kj::byte> data)
+{
+    switch (access)
+    {
+        case Access::Bool:
+        {
+            // Bools are numbered in bits, not bytes.
+            const std::size_t byte = offset / 8;
+            const bool stored = byte < data.size() && ((data[byte] >> (offset % 8)) & 1u) != 0;
+            return stored != (defaults != 0) ? 1.0 : 0.0;
+        }
+        case Access::Int8:
+            return static_cast<std::int8_t>(dataBits<std::uint8_t>(data, offset, defaults));
+        case Access::Int16:
+            return static_cast<std::int16_t>(dataBits<std::uint16_t>(data, offset, defaults));
+        case Access::Int32:
+            return static_cast<std::int32_t>(dataBits<std::uint32_t>(data, offset, defaults));
+        case Access::Int64:
+            return static_cast<double>(
+                static_cast<std::int64_t>(dataBits<std::uint64_t>(data, offset, defaults)));
+        case Access::UInt8:
+            return dataBits<std::uint8_t>(data, offset, defaults);
+        case Access::UInt16:
+            return dataBits<std::uint16_t>(data, offset, defaults);
+        case Access::UInt32:
+            return dataBits<std::uint32_t>(data, offset, defaults);
+        case Access::UInt64:
+            return static_cast<double>(dataBits<std::uint64_t>(data, offset, defaults));
+        case Access::Float32:
+            return std::bit_cast<float>(dataBits<std::uint32_t>(data, offset, defaults));
+        case Access::Float64:
+            return std::bit_cast<double>(dataBits<std::uint64_t>(data, offset, defaults));
+        case Access::Dynamic:
+            break;
+    }
+
+    // Unreachable: extract() sends a Dynamic field the other way.
+    return 0.0;
+}
+
+// Fills `out` from a list of T when the list has out.size() elements. Returns
+// the list's real length either way, for the caller to judge and report.
+template <typename T>
+std::size_t readList(capnp::AnyPointer::Reader pointer, std::vector<double>& out)
+{
+    const auto list = pointer.getAs<capnp::List<T>>();
+    if (list.size() == out.size())
+    {
+        for (unsigned i = 0; i < list.size(); ++i)
+        {
+            out[i] = static_cast<double>(list[i]);
+        }
+    }
+    return list.size();
+}
+
+std::size_t directList(Access access, capnp::AnyPointer::Reader pointer, std::vector<double>& out)
+{
+    switch (access)
+    {
+        case Access::Bool:
+            return readList<bool>(pointer, out);
+        case Access::Int8:
+            return readList<std::int8_t>(pointer, out);
+        case Access::Int16:
+            return readList<std::int16_t>(pointer, out);
+        case Access::Int32:
+            return readList<std::int32_t>(pointer, out);
+        case Access::Int64:
+            return readList<std::int64_t>(pointer, out);
+        case Access::UInt8:
+            return readList<std::uint8_t>(pointer, out);
+        case Access::UInt16:
+            // A list of enums is a list of 16-bit ordinals on the wire.
+            return readList<std::uint16_t>(pointer, out);
+        case Access::UInt32:
+            return readList<std::uint32_t>(pointer, out);
+        case Access::UInt64:
+            return readList<std::uint64_t>(pointer, out);
+        case Access::Float32:
+            return readList<float>(pointer, out);
+        case Access::Float64:
+            return readList<double>(pointer, out);
+        case Access::Dynamic:
+            break;
+    }
+    return 0;
+}
+
+// Compares the schema a consumer was configured for against the one a
+// publisher stamped on a sample. Shared by the single evaluator and the set,
+// which latch it themselves.
+void reportSchemaMismatch(std::string_view encoding, schema_type_t schema_type,
+                          const std::string& log_context)
+{
+    const std::string_view published = schemaNameFromEncoding(encoding);
+    const std::string_view configured =
+        reflection::enum_traits<pub_sub::schema_type_t>::to_string(schema_type);
+
+    if (published == configured)
+    {
+        return;
+    }
+
+    // An empty schema half means the publisher set a MIME type but no schema
+    // (or is not one of ours at all). Not necessarily wrong, so say less.
+    if (published.empty() || published == encoding)
+    {
+        SPDLOG_DEBUG("Key '{}' carries encoding '{}', which names no schema; "
+                     "decoding as the configured '{}'",
+                     log_context, encoding, configured);
+        return;
+    }
+
+    // capnp will decode the payload against whatever schema it is handed --
+    // field offsets simply land on different bytes -- so a wrong schema in
+    // config produces a plausible but meaningless number rather than an error.
+    // This is the only place that mismatch is detectable.
+    SPDLOG_ERROR("Key '{}' is published as '{}' but is configured as '{}'. The value will be "
+                 "decoded against the configured schema and will be wrong; fix schema_type in "
+                 "the config.",
+                 log_context, published, configured);
+}
+
+// The decoded values of every field some expressions read, and the code that
+// fills them from a payload.
+//
+// One of these per ExpressionEvaluator, and ONE per ExpressionEvaluatorSet
+// however many members it has -- which is the whole point of the set. The
+// expressions compiled against it bind their variables to its slots by address;
+// the table neither knows nor cares how many of them there are.
+struct FieldTable
 {
     // Pre-computed field access, so a sample costs no schema lookups.
     struct FieldCache
@@ -119,8 +415,14 @@ struct ExpressionEvaluator::Impl
         capnp::StructSchema::Field field;
         capnp::DynamicValue::Type expected_type;
 
-        // Where extractFieldValues() writes this field's value: straight into the
-        // `variables` node that exprtk's symbol table is bound to.
+        // Where the value is, when the schema fixes that; see Access. Dynamic
+        // reads `field` through the dynamic API as `expected_type`.
+        Access access = Access::Dynamic;
+        std::uint32_t offset = 0;
+        std::uint64_t default_bits = 0;
+
+        // Where extract() writes this field's value: straight into the
+        // `variables` node that exprtk's symbol tables are bound to.
         //
         // This used to be `variables[name] = value`, which walked a
         // std::map<std::string, double> and string-compared its way down the tree
@@ -150,6 +452,11 @@ struct ExpressionEvaluator::Impl
         // What the ELEMENTS decode as. The list itself is not one of these.
         capnp::DynamicValue::Type element_type;
 
+        // How the elements are read, and which pointer of the struct's pointer
+        // section holds the list. Dynamic goes through `field` instead.
+        Access access = Access::Dynamic;
+        std::uint32_t pointer = 0;
+
         std::string name;
 
         // Into `vectors`, whose nodes std::map never moves -- the same stability
@@ -157,46 +464,221 @@ struct ExpressionEvaluator::Impl
         // data(), so this is re-registered whenever the vector is resized.
         std::vector<double>* data;
 
+        // Whether the last sample's list had the declared length. Per list, so
+        // a set withholds a value only from the members that read this one.
+        bool matched = true;
     };
 
-    schema_type_t schema_type;
-    std::string expression;
+    // What resolve() found out about one field, before anything is bound.
+    struct Resolved
+    {
+        std::string name;
+        capnp::StructSchema::Field field;
+        capnp::DynamicValue::Type type;  // Of the elements, for a list.
+        std::optional<std::uint32_t> length;  // Set for a list, and only for one.
+
+        // See FieldCache. For a list, `offset` is its pointer index and the
+        // access is its elements'.
+        Access access = Access::Dynamic;
+        std::uint32_t offset = 0;
+        std::uint64_t default_bits = 0;
+    };
+
+    schema_type_t schema_type{};
     std::string log_context;
     capnp::Schema schema{};
-    bool is_valid = false;
+    bool has_schema = false;
 
-    // Bound by address into symbol_table; see FieldCache::slot.
-    std::map<std::string, double> variables;
+    // Every field through the dynamic API, as before Access existed. Only for
+    // measuring the difference and for testing that there is none in the
+    // answers; see FieldAccess.
+    bool dynamic_only = false;
 
-    // The same names as `variables`, as a flat list for variableNames(). Built
-    // once, because handing out a vector built on demand would mean returning a
-    // reference to a temporary.
-    std::vector<std::string> variable_names;
+    // Whether any bound field takes the dynamic path, so a sample that has none
+    // does not build a DynamicStruct reader it never uses.
+    bool needs_dynamic = false;
 
-    exprtk::symbol_table<double> symbol_table;
-    exprtk::expression<double> compiled_expression;
-    exprtk::parser<double> parser;
-
-    std::vector<FieldCache> field_cache;
+    // Bound by address into every symbol table compiled against this; see
+    // FieldCache::slot.
+    std::map<std::string, double> variables;
 
-    // Bound by address into symbol_table as exprtk vectors; see ListCache.
+    // Bound by address as exprtk vectors; see ListCache.
     std::map<std::string, std::vector<double>> vectors;
-    std::vector<ListCache> list_cache;
-
-    bool length_mismatch_warned = false;
 
-    // schema_type comes from config -- it is what this consumer *expects* on this
-    // key, not what is actually being published there. The publisher stamps the
-    // truth on every sample, so check the two agree. Latched so a mismatch is
-    // reported once rather than at the sample rate.
-    bool schema_checked = false;
+    std::vector<FieldCache> field_cache;
+    std::vector<ListCache> list_cache;
 
-    // Latches for the other once-per-binding complaints. A malformed publisher
+    // Latches for the once-per-table complaints. A malformed publisher
     // produces bad samples at the sample rate, and an unlatched warning at
     // 100 Hz churns the rotating log files and costs real CPU.
+    bool length_mismatch_warned = false;
     bool payload_size_warned = false;
-    bool non_finite_warned = false;
-    bool range_warned = false;
+
+    void open(schema_type_t type, std::string context)
+    {
+        schema_type = type;
+        log_context = std::move(context);
+
+        const auto found = get_schema(type);
+        if (!found)
+        {
+            SPDLOG_ERROR("Schema '{}' not found in registry",
+                         reflection::enum_traits<pub_sub::schema_type_t>::to_string(type));
+            return;
+        }
+        schema = *found;
+        has_schema = true;
+    }
+
+    // How `name` would be bound, or nullopt -- having said why -- when an
+    // expression can never turn it into a number. Binds nothing, so an
+    // expression with one bad variable leaves no slot behind for its good ones.
+    std::optional<Resolved> resolve(const std::string& name, const std::string& expression) const
+    {
+        if (!schema.getProto().isStruct())
+        {
+            SPDLOG_ERROR("Schema is not a struct, cannot build field cache");
+            return std::nullopt;
+        }
+
+        const auto field = schema.asStruct().getFieldByName(name.c_str());
+        const auto field_type = field.getType();
+
+        if (field_type.isList())
+        {
+            const auto element_type = numericTypeOf(field_type.asList().getElementType());
+
+            // A List(Text) or a List(SomeStruct) is no more a number than a
+            // bare Text field is, and saying so here rather than per sample is
+            // the same argument the scalar case makes below.
+            if (element_type == capnp::DynamicValue::UNKNOWN)
+            {
+                SPDLOG_ERROR("Field '{}' of schema '{}' is a list whose elements are not "
+                             "numeric, so expression '{}' cannot be evaluated against it.",
+                             name, reflection::enum_to_string(schema_type), expression);
+                return std::nullopt;
+            }
+
+            // A LIST MUST DECLARE ITS LENGTH TO BE BINDABLE.
+            //
+            // capnp gives no length, so without the annotation there is
+            // nothing to compile an index against and nothing a picker can
+            // offer. The alternative -- discover the length from the first
+            // message and recompile whenever it changes -- worked, and its
+            // cost was a recompile per message for a list that genuinely
+            // varies. CanFrame.data is List(UInt8) of 1..64 bytes on the
+            // highest-rate topic in the tree, so that cost lands exactly
+            // where it can least be afforded.
+            //
+            // Requiring the annotation makes the length a fact known at
+            // construction: the expression compiles once, exprtk
+            // range-checks every literal index against the real count, and
+            // sum()/avg() are correct by construction. See
+            // schemas/annotations.capnp.
+            const auto declared = fixedListLength(field);
+            if (!declared)
+            {
+                SPDLOG_ERROR("Field '{}' of schema '{}' is a list with no declared length, so "
+                             "expression '{}' cannot be compiled against it. Annotate the "
+                             "field with $fixedLength(N) if its count is fixed; a genuinely "
+                             "variable list is not plottable element by element.",
+                             name, reflection::enum_to_string(schema_type), expression);
+                return std::nullopt;
+            }
+
+            Resolved resolved{name, field, element_type, declared};
+            place(resolved);
+            return resolved;
+        }
+
+        const capnp::DynamicValue::Type expected_type = numericTypeOf(field_type);
+
+        // A field the expression can never turn into a number is a config
+        // error, and it is knowable right here rather than once per sample
+        // forever. Previously this warned from extractFieldValues at the sample
+        // rate and substituted 0.0, so the gauge read a confident, permanent
+        // zero while the log filled up. Treat it like an unknown variable.
+        if (expected_type == capnp::DynamicValue::UNKNOWN)
+        {
+            SPDLOG_ERROR("Field '{}' of schema '{}' is not numeric, so expression '{}' cannot "
+                         "be evaluated against it.",
+                         name, reflection::enum_to_string(schema_type), expression);
+            return std::nullopt;
+        }
+
+        Resolved resolved{name, field, expected_type, std::nullopt};
+        place(resolved);
+        return resolved;
+    }
+
+    // Where a resolved field lives, if the schema alone says. Leaves it Dynamic
+    // for a member of an unnamed union -- there only while the discriminant
+    // says so -- and for a list with a default of its own, which a null pointer
+    // would have to be replaced by.
+    void place(Resolved& resolved) const
+    {
+        const auto proto = resolved.field.getProto();
+        if (dynamic_only || !kLittleEndianHost || !proto.isSlot() ||
+            proto.getDiscriminantValue() != capnp::schema::Field::NO_DISCRIMINANT)
+        {
+            return;
+        }
+
+        const auto slot = proto.getSlot();
+        const auto type = resolved.field.getType();
+        if (resolved.length)
+        {
+            if (!slot.getHadExplicitDefault())
+            {
+                resolved.access = directAccessOf(type.asList().getElementType());
+                resolved.offset = slot.getOffset();
+            }
+            return;
+        }
+
+        resolved.access = directAccessOf(type);
+        resolved.offset = slot.getOffset();
+        resolved.default_bits = defaultBitsOf(slot.getDefaultValue());
+    }
+
+    // Gives a resolved field its slot, unless an earlier expression already
+    // did: a field two expressions read is decoded once.
+    void bind(const Resolved& resolved)
+    {
+        if (resolved.length)
+        {
+            if (vectors.contains(resolved.name))
+            {
+                return;
+            }
+            vectors[resolved.name].assign(*resolved.length, 0.0);
+            list_cache.push_back({resolved.field, resolved.type, resolved.access,
+                                  resolved.offset, resolved.name, &vectors.at(resolved.name)});
+            needs_dynamic = needs_dynamic || resolved.access == Access::Dynamic;
+            return;
+        }
+
+        if (variables.contains(resolved.name))
+        {
+            return;
+        }
+        field_cache.push_back({resolved.field, resolved.type, resolved.access, resolved.offset,
+                               resolved.default_bits, &variables[resolved.name]});
+        needs_dynamic = needs_dynamic || resolved.access == Access::Dynamic;
+    }
+
+    // Into list_cache; only meaningful for a name bind() made a vector.
+    std::size_t listIndex(const std::string& name) const
+    {
+        for (std::size_t i = 0; i < list_cache.size(); ++i)
+        {
+            if (list_cache[i].name == name)
+            {
+                return i;
+            }
+        }
+        return list_cache.size();
+    }
 
     void reportLengthMismatch(const std::string& name, std::size_t declared, std::size_t actual)
     {
@@ -212,24 +694,31 @@ struct ExpressionEvaluator::Impl
                      log_context, name, declared, actual);
     }
 
-    // False when this sample cannot be turned into values, which the caller
-    // reports as "no reading" rather than as a number.
-    bool extractFieldValues(capnp::DynamicStruct::Reader reader)
+    void extract(capnp::MessageReader& message)
     {
-        for (const auto& cached : field_cache)
+        // The same root two ways. AnyStruct is a view of the raw sections and
+        // costs a pointer check; the dynamic reader is only made when some
+        // field needs the schema to find it.
+        const auto root = message.getRoot<capnp::AnyStruct>();
+        const kj::ArrayPtr<const kj::byte> data = root.getDataSection();
+        const auto pointers = root.getPointerSection();
+
+        capnp::DynamicStruct::Reader reader;
+        if (needs_dynamic)
         {
-            *cached.slot = numericFrom(reader.get(cached.field), cached.expected_type);
+            reader = message.getRoot<capnp::DynamicStruct>(schema.asStruct());
         }
 
-        if (list_cache.empty())
+        for (const auto& cached : field_cache)
         {
-            return true;
+            *cached.slot =
+                cached.access == Access::Dynamic
+                    ? numericFrom(reader.get(cached.field), cached.expected_type)
+                    : directValue(cached.access, cached.offset, cached.default_bits, data);
         }
 
-        for (const ListCache& cached : list_cache)
+        for (ListCache& cached : list_cache)
         {
-            auto list = reader.get(cached.field).as<capnp::DynamicList>();
-
             // THE LENGTH IS SETTLED AT CONSTRUCTION, so this is a check rather
             // than a resize. The expression was compiled against the declared
             // length and every literal index in it was range-checked against
@@ -239,10 +728,29 @@ struct ExpressionEvaluator::Impl
             //
             // This is also what keeps a variable-length list from recompiling
             // the expression per message. Nothing here allocates or compiles.
-            if (list.size() != cached.data->size())
+            if (cached.access != Access::Dynamic)
+            {
+                // A pointer past the end of the section is a null pointer, as
+                // capnp reads it: an empty list, which then fails the length
+                // check like any other short one.
+                const capnp::AnyPointer::Reader pointer =
+                    cached.pointer < pointers.size() ? pointers[cached.pointer]
+                                                     : capnp::AnyPointer::Reader();
+                const std::size_t size = directList(cached.access, pointer, *cached.data);
+                cached.matched = size == cached.data->size();
+                if (!cached.matched)
+                {
+                    reportLengthMismatch(cached.name, cached.data->size(), size);
+                }
+                continue;
+            }
+
+            auto list = reader.get(cached.field).as<capnp::DynamicList>();
+            cached.matched = list.size() == cached.data->size();
+            if (!cached.matched)
             {
                 reportLengthMismatch(cached.name, cached.data->size(), list.size());
-                return false;
+                continue;
             }
 
             for (std::size_t i = 0; i < cached.data->size(); ++i)
@@ -251,253 +759,248 @@ struct ExpressionEvaluator::Impl
                                                 cached.element_type);
             }
         }
-
-        return true;
     }
 
-    void extractVariables()
+    // Fills every slot from one payload. False when the payload yields nothing
+    // at all, having already logged whatever needed logging.
+    bool decode(std::span<const std::uint8_t> payload)
     {
-        std::vector<std::string> variable_list;
-        if (exprtk::collect_variables(expression, symbol_table, variable_list))
+        // capnp reads whole 8-byte words. A payload that is not a multiple of
+        // sizeof(word) used to be silently truncated, and anything under one
+        // word decoded as an empty message -- every field its default, no
+        // warning, a gauge reading zero. Say so instead.
+        const WordAlignedPayload aligned(reinterpret_cast<const kj::byte*>(payload.data()),
+                                         payload.size());
+        if (aligned.empty())
         {
-            for (const auto& var : variable_list)
+            if (!payload_size_warned)
             {
-                variables[var] = 0.0;
+                payload_size_warned = true;
+                SPDLOG_WARN("Key '{}': payload of {} bytes is not a whole number of {}-byte "
+                            "capnp words; ignoring these samples (further occurrences not "
+                            "logged).",
+                            log_context, payload.size(), sizeof(capnp::word));
             }
+            return false;
+        }
+
+        try
+        {
+            capnp::FlatArrayMessageReader message_reader(aligned.words());
+            extract(message_reader);
+            return true;
         }
-        else
+        catch (const std::exception& e)
         {
-            SPDLOG_ERROR("Failed to extract variables from expression '{}'", expression);
-            is_valid = false;
-            variables.clear();
+            SPDLOG_ERROR("Expression evaluation failed: {}", e.what());
+            return false;
         }
     }
+};
 
-    void validateVariablesAgainstSchema()
+// One expression compiled against a FieldTable.
+//
+// Owns its exprtk symbol table, whose variables are the TABLE's slots: several
+// of these over one table read the same decoded values without copying them.
+// Non-movable in practice -- exprtk keeps pointers into the table -- so it is
+// held by unique_ptr or inside a heap-allocated Impl.
+struct CompiledExpression
+{
+    std::string expression;
+    bool is_valid = false;
+
+    // The schema field names the expression reads, sorted, once each.
+    std::vector<std::string> variable_names;
+
+    // Into the table's list_cache: the lists this reads, each of which must
+    // have matched its declared length for this to have a value.
+    std::vector<std::size_t> lists;
+
+    exprtk::symbol_table<double> symbol_table;
+    exprtk::expression<double> compiled_expression;
+
+    bool non_finite_warned = false;
+
+    void compile(FieldTable& table)
     {
-        const auto fields = schemaFieldNames(schema);
-        for (const auto& [var, unused] : variables)
+        if (expression.empty())
+        {
+            SPDLOG_ERROR("Expression is empty (context '{}')", table.log_context);
+            return;
+        }
+        if (!table.has_schema)
+        {
+            return;
+        }
+
+        symbol_table.add_function("mph_to_mps", &mph_to_mps<double>);
+        symbol_table.add_function("mps_to_mph", &mps_to_mph<double>);
+        symbol_table.add_function("psi_to_bar", &psi_to_bar<double>);
+        symbol_table.add_function("bar_to_psi", &bar_to_psi<double>);
+        symbol_table.add_function("celsius_to_fahrenheit", &celsius_to_fahrenheit<double>);
+        symbol_table.add_function("fahrenheit_to_celsius", &fahrenheit_to_celsius<double>);
+
+        if (!exprtk::collect_variables(expression, symbol_table, variable_names))
+        {
+            SPDLOG_ERROR("Failed to extract variables from expression '{}'", expression);
+            variable_names.clear();
+            return;
+        }
+
+        // Sorted, because variableNames() promises it and callers compare.
+        std::sort(variable_names.begin(), variable_names.end());
+        variable_names.erase(std::unique(variable_names.begin(), variable_names.end()),
+                             variable_names.end());
+
+        bool resolvable = true;
+        const auto fields = schemaFieldNames(table.schema);
+        for (const std::string& var : variable_names)
         {
             if (fields.find(var) == fields.end())
             {
                 SPDLOG_ERROR("Variable '{}' not found in schema '{}'", var,
                              reflection::enum_traits<pub_sub::schema_type_t>::to_string(
-                                 schema_type));
-                is_valid = false;
+                                 table.schema_type));
+                resolvable = false;
             }
         }
-    }
-
-    void buildFieldCache()
-    {
-        field_cache.clear();
-        list_cache.clear();
-
-        if (!schema.getProto().isStruct())
+        if (!resolvable)
         {
-            SPDLOG_ERROR("Schema is not a struct, cannot build field cache");
             return;
         }
 
-        auto struct_schema = schema.asStruct();
-
-        // Names that turn out to be lists move out of `variables` and into
-        // `vectors`, so collect them first rather than mutating while iterating.
-        std::vector<std::string> list_names;
-
-        for (const auto& [var_name, unused] : variables)
+        // Every variable is checked before any is bound, and all of them
+        // reported, so one bad field costs the table nothing and the log names
+        // every problem at once.
+        std::vector<FieldTable::Resolved> resolved;
+        for (const std::string& var : variable_names)
         {
-            auto field = struct_schema.getFieldByName(var_name.c_str());
-            const auto field_type = field.getType();
-
-            if (field_type.isList())
+            if (auto found = table.resolve(var, expression))
             {
-                const auto element_type =
-                    numericTypeOf(field_type.asList().getElementType());
-
-                // A List(Text) or a List(SomeStruct) is no more a number than a
-                // bare Text field is, and saying so here rather than per sample is
-                // the same argument the scalar case makes below.
-                if (element_type == capnp::DynamicValue::UNKNOWN)
-                {
-                    SPDLOG_ERROR("Field '{}' of schema '{}' is a list whose elements are not "
-                                 "numeric, so expression '{}' cannot be evaluated against it.",
-                                 var_name, reflection::enum_to_string(schema_type), expression);
-                    is_valid = false;
-                    continue;
-                }
-
-                list_names.push_back(var_name);
-
-                // A LIST MUST DECLARE ITS LENGTH TO BE BINDABLE.
-                //
-                // capnp gives no length, so without the annotation there is
-                // nothing to compile an index against and nothing a picker can
-                // offer. The alternative -- discover the length from the first
-                // message and recompile whenever it changes -- worked, and its
-                // cost was a recompile per message for a list that genuinely
-                // varies. CanFrame.data is List(UInt8) of 1..64 bytes on the
-                // highest-rate topic in the tree, so that cost lands exactly
-                // where it can least be afforded.
-                //
-                // Requiring the annotation makes the length a fact known at
-                // construction: the expression compiles once, exprtk
-                // range-checks every literal index against the real count, and
-                // sum()/avg() are correct by construction. See
-                // schemas/annotations.capnp.
-                const auto declared = fixedListLength(field);
-                if (!declared)
-                {
-                    SPDLOG_ERROR("Field '{}' of schema '{}' is a list with no declared length, so "
-                                 "expression '{}' cannot be compiled against it. Annotate the "
-                                 "field with $fixedLength(N) if its count is fixed; a genuinely "
-                                 "variable list is not plottable element by element.",
-                                 var_name, reflection::enum_to_string(schema_type), expression);
-                    is_valid = false;
-                    continue;
-                }
-
-                list_names.push_back(var_name);
-                vectors[var_name].assign(*declared, 0.0);
-                list_cache.push_back({field, element_type, var_name, &vectors.at(var_name)});
-                continue;
+                resolved.push_back(std::move(*found));
             }
-
-            const capnp::DynamicValue::Type expected_type = numericTypeOf(field_type);
-
-            // A field the expression can never turn into a number is a config
-            // error, and it is knowable right here rather than once per sample
-            // forever. Previously this warned from extractFieldValues at the sample
-            // rate and substituted 0.0, so the gauge read a confident, permanent
-            // zero while the log filled up. Treat it like an unknown variable.
-            if (expected_type == capnp::DynamicValue::UNKNOWN)
+            else
             {
-                SPDLOG_ERROR("Field '{}' of schema '{}' is not numeric, so expression '{}' cannot "
-                             "be evaluated against it.",
-                             var_name, reflection::enum_to_string(schema_type), expression);
-                is_valid = false;
-                continue;
+                resolvable = false;
             }
-
-            // `variables` was filled by extractVariables() before we got here, so
-            // the entry exists and taking its address is safe; add_variable() binds
-            // exprtk to the same one.
-            field_cache.push_back({field, expected_type, &variables.at(var_name)});
+        }
+        if (!resolvable)
+        {
+            return;
         }
 
-        // A list is bound as a vector, so it must NOT also be registered as a
-        // scalar of the same name -- exprtk would take the first registration and
+        // A list is bound as a vector ONLY -- registering it as a scalar of the
+        // same name too would let exprtk take the first registration, and
         // `values[3]` would fail to parse against a plain double.
-        for (const std::string& name : list_names)
+        for (const FieldTable::Resolved& field : resolved)
         {
-            variables.erase(name);
+            table.bind(field);
+            if (field.length)
+            {
+                std::vector<double>& data = table.vectors.at(field.name);
+                symbol_table.add_vector(field.name, data.data(), data.size());
+                lists.push_back(table.listIndex(field.name));
+            }
+            else
+            {
+                symbol_table.add_variable(field.name, table.variables.at(field.name));
+            }
         }
-    }
-};
-
-ExpressionEvaluator::ExpressionEvaluator(schema_type_t schema_type,
-                                         const std::string& expression,
-                                         std::string log_context) :
-    impl_(std::make_unique<Impl>())
-{
-    impl_->schema_type = schema_type;
-    impl_->expression = expression;
-    impl_->log_context = log_context.empty() ? expression : std::move(log_context);
 
-    // Assume valid until proven otherwise.
-    impl_->is_valid = true;
-
-    if (impl_->expression.empty())
-    {
-        SPDLOG_ERROR("Expression is empty (context '{}')", impl_->log_context);
-        impl_->is_valid = false;
-        return;
-    }
+        symbol_table.add_constants();
 
-    const auto schema = get_schema(schema_type);
-    if (!schema)
-    {
-        SPDLOG_ERROR("Schema '{}' not found in registry",
-                     reflection::enum_traits<pub_sub::schema_type_t>::to_string(schema_type));
-        impl_->is_valid = false;
-        return;
+        // Sized from the schema, so this compile is the only one: exprtk
+        // range-checks every literal index against the declared count, and an
+        // index the stream cannot reach is a construction error rather than a
+        // binding that quietly drops every sample.
+        compiled_expression.register_symbol_table(symbol_table);
+        exprtk::parser<double> parser;
+        is_valid = parser.compile(expression, compiled_expression);
     }
-    impl_->schema = *schema;
 
-    impl_->symbol_table.add_function("mph_to_mps", &mph_to_mps<double>);
-    impl_->symbol_table.add_function("mps_to_mph", &mps_to_mph<double>);
-    impl_->symbol_table.add_function("psi_to_bar", &psi_to_bar<double>);
-    impl_->symbol_table.add_function("bar_to_psi", &bar_to_psi<double>);
-    impl_->symbol_table.add_function("celsius_to_fahrenheit", &celsius_to_fahrenheit<double>);
-    impl_->symbol_table.add_function("fahrenheit_to_celsius", &fahrenheit_to_celsius<double>);
-
-    impl_->extractVariables();
-    impl_->validateVariablesAgainstSchema();
-
-    if (impl_->is_valid)
+    // Against whatever the table last decoded.
+    std::optional<double> value(const FieldTable& table)
     {
-        impl_->buildFieldCache();
-
-        for (auto& [var, value] : impl_->variables)
+        // A list this expression reads did not have its declared length.
+        // Already reported once, by name and length.
+        for (const std::size_t list : lists)
         {
-            impl_->symbol_table.add_variable(var, value);
+            if (!table.list_cache[list].matched)
+            {
+                return std::nullopt;
+            }
         }
 
-        // Sized from the schema, so this compile is the only one: exprtk
-        // range-checks every literal index against the declared count, and an
-        // index the stream cannot reach is a construction error rather than a
-        // binding that quietly drops every sample.
-        for (auto& [var, data] : impl_->vectors)
+        const double result = compiled_expression.value();
+
+        // exprtk does plain IEEE division, so `x/0` is inf and `0/0` is NaN, with
+        // no throw and no flag. Both then poison whatever they touch:
+        // static_cast<int>(NaN) is undefined behaviour, and std::clamp passes NaN
+        // straight through to painter.rotate(). Stop it at the boundary.
+        if (!std::isfinite(result))
         {
-            impl_->symbol_table.add_vector(var, data.data(), data.size());
+            if (!non_finite_warned)
+            {
+                non_finite_warned = true;
+                SPDLOG_WARN("Key '{}': expression '{}' evaluated to {}; ignoring these samples "
+                            "(further occurrences not logged).",
+                            table.log_context, expression, result);
+            }
+            return std::nullopt;
         }
 
-        impl_->symbol_table.add_constants();
-
-        impl_->compiled_expression.register_symbol_table(impl_->symbol_table);
-        impl_->is_valid = impl_->parser.compile(impl_->expression, impl_->compiled_expression);
+        return result;
     }
+};
 
-    // Both halves: a list field is a field the expression reads, and
-    // variableNames() promises the fields it reads. buildFieldCache() moves list
-    // names out of `variables` and into `vectors` -- they must not be registered
-    // twice with exprtk -- so reading only the first would silently under-report
-    // exactly the bindings that are hardest to reason about.
-    //
-    // std::map iterates in sorted key order; merging two sorted ranges keeps the
-    // ordering guarantee the header makes.
-    impl_->variable_names.reserve(impl_->variables.size() + impl_->vectors.size());
-    for (const auto& [var, unused] : impl_->variables)
-    {
-        impl_->variable_names.push_back(var);
-    }
-    for (const auto& [var, unused] : impl_->vectors)
-    {
-        impl_->variable_names.push_back(var);
-    }
-    std::sort(impl_->variable_names.begin(), impl_->variable_names.end());
+}  // namespace
+
+// ------------------------------------------------------------ ExpressionEvaluator
+
+struct ExpressionEvaluator::Impl
+{
+    FieldTable table;
+    CompiledExpression compiled;
+
+    // schema_type comes from config -- it is what this consumer *expects* on this
+    // key, not what is actually being published there. The publisher stamps the
+    // truth on every sample, so check the two agree. Latched so a mismatch is
+    // reported once rather than at the sample rate.
+    bool schema_checked = false;
+
+    bool range_warned = false;
+};
+
+ExpressionEvaluator::ExpressionEvaluator(schema_type_t schema_type,
+                                         const std::string& expression,
+                                         std::string log_context) :
+    impl_(std::make_unique<Impl>())
+{
+    impl_->compiled.expression = expression;
+    impl_->table.open(schema_type, log_context.empty() ? expression : std::move(log_context));
+    impl_->compiled.compile(impl_->table);
 }
 
 ExpressionEvaluator::~ExpressionEvaluator() = default;
 
 bool ExpressionEvaluator::isValid() const
 {
-    return impl_->is_valid;
+    return impl_->compiled.is_valid;
 }
 
 schema_type_t ExpressionEvaluator::getSchemaType() const
 {
-    return impl_->schema_type;
+    return impl_->table.schema_type;
 }
 
 const std::string& ExpressionEvaluator::getExpression() const
 {
-    return impl_->expression;
+    return impl_->compiled.expression;
 }
 
 const std::vector<std::string>& ExpressionEvaluator::variableNames() const
 {
-    return impl_->variable_names;
+    return impl_->compiled.variable_names;
 }
 
 void ExpressionEvaluator::checkPublishedSchema(std::string_view encoding)
@@ -507,111 +1010,150 @@ void ExpressionEvaluator::checkPublishedSchema(std::string_view encoding)
         return;
     }
     impl_->schema_checked = true;
+    reportSchemaMismatch(encoding, impl_->table.schema_type, impl_->table.log_context);
+}
 
-    const std::string_view published = schemaNameFromEncoding(encoding);
-    const std::string_view configured =
-        reflection::enum_traits<pub_sub::schema_type_t>::to_string(impl_->schema_type);
+std::optional<double> ExpressionEvaluator::evaluateToDouble(
+    std::span<const std::uint8_t> payload)
+{
+    if (!impl_->compiled.is_valid)
+    {
+        SPDLOG_ERROR("Expression is not valid, cannot evaluate.");
+        return std::nullopt;
+    }
 
-    if (published == configured)
+    if (!impl_->table.decode(payload))
     {
-        return;
+        return std::nullopt;
     }
+    return impl_->compiled.value(impl_->table);
+}
 
-    // An empty schema half means the publisher set a MIME type but no schema
-    // (or is not one of ours at all). Not necessarily wrong, so say less.
-    if (published.empty() || published == encoding)
+void ExpressionEvaluator::warnOutOfRange(double value)
+{
+    if (impl_->range_warned)
     {
-        SPDLOG_DEBUG("Key '{}' carries encoding '{}', which names no schema; "
-                     "decoding as the configured '{}'",
-                     impl_->log_context, encoding, configured);
         return;
     }
-
-    // capnp will decode the payload against whatever schema it is handed --
-    // field offsets simply land on different bytes -- so a wrong schema in
-    // config produces a plausible but meaningless number rather than an error.
-    // This is the only place that mismatch is detectable.
-    SPDLOG_ERROR("Key '{}' is published as '{}' but is configured as '{}'. The value will be "
-                 "decoded against the configured schema and will be wrong; fix schema_type in "
-                 "the config.",
-                 impl_->log_context, published, configured);
+    impl_->range_warned = true;
+    SPDLOG_WARN("Key '{}': expression '{}' produced {}, which does not fit the configured type; "
+                "ignoring these samples (further occurrences not logged).",
+                impl_->table.log_context, impl_->compiled.expression, value);
 }
 
-std::optional<double> ExpressionEvaluator::evaluateToDouble(
-    std::span<const std::uint8_t> payload)
+// --------------------------------------------------------- ExpressionEvaluatorSet
+
+struct ExpressionEvaluatorSet::Impl
 {
-    if (!impl_->is_valid)
+    // ONE table for every member. This is the set.
+    FieldTable table;
+
+    // By pointer: each member's symbol table is bound into `table`, and exprtk
+    // is not a library whose objects one moves around after compiling.
+    std::vector<std::unique_ptr<CompiledExpression>> members;
+
+    // The members worth evaluating, so an invalid one costs nothing per sample.
+    std::vector<std::size_t> valid;
+
+    std::vector<std::string> field_names;
+
+    bool schema_checked = false;
+};
+
+ExpressionEvaluatorSet::ExpressionEvaluatorSet(schema_type_t schema_type,
+                                               const std::vector<std::string>& expressions,
+                                               std::string log_context,
+                                               FieldAccess access) :
+    impl_(std::make_unique<Impl>())
+{
+    if (log_context.empty())
     {
-        SPDLOG_ERROR("Expression is not valid, cannot evaluate.");
-        return std::nullopt;
+        log_context = std::string(reflection::enum_to_string(schema_type));
     }
+    impl_->table.open(schema_type, std::move(log_context));
+    impl_->table.dynamic_only = access == FieldAccess::Dynamic;
 
-    // capnp reads whole 8-byte words. A payload that is not a multiple of
-    // sizeof(word) used to be silently truncated, and anything under one word
-    // decoded as an empty message -- every field its default, no warning, a gauge
-    // reading zero. Say so instead.
-    const WordAlignedPayload aligned(reinterpret_cast<const kj::byte*>(payload.data()),
-                                     payload.size());
-    if (aligned.empty())
+    impl_->members.reserve(expressions.size());
+    for (const std::string& expression : expressions)
     {
-        if (!impl_->payload_size_warned)
+        auto member = std::make_unique<CompiledExpression>();
+        member->expression = expression;
+        member->compile(impl_->table);
+        if (member->is_valid)
         {
-            impl_->payload_size_warned = true;
-            SPDLOG_WARN("Key '{}': payload of {} bytes is not a whole number of {}-byte capnp "
-                        "words; ignoring these samples (further occurrences not logged).",
-                        impl_->log_context, payload.size(), sizeof(capnp::word));
+            impl_->valid.push_back(impl_->members.size());
+            impl_->field_names.insert(impl_->field_names.end(), member->variable_names.begin(),
+                                      member->variable_names.end());
         }
-        return std::nullopt;
+        impl_->members.push_back(std::move(member));
     }
 
-    try
-    {
-        capnp::FlatArrayMessageReader message_reader(aligned.words());
-        if (!impl_->extractFieldValues(
-                message_reader.getRoot<capnp::DynamicStruct>(impl_->schema.asStruct())))
-        {
-            // A list this expression indexes past the end of. Already reported
-            // once, by name and length.
-            return std::nullopt;
-        }
+    std::sort(impl_->field_names.begin(), impl_->field_names.end());
+    impl_->field_names.erase(std::unique(impl_->field_names.begin(), impl_->field_names.end()),
+                             impl_->field_names.end());
+}
 
-        const double result = impl_->compiled_expression.value();
+ExpressionEvaluatorSet::~ExpressionEvaluatorSet() = default;
 
-        // exprtk does plain IEEE division, so `x/0` is inf and `0/0` is NaN, with
-        // no throw and no flag. Both then poison whatever they touch:
-        // static_cast<int>(NaN) is undefined behaviour, and std::clamp passes NaN
-        // straight through to painter.rotate(). Stop it at the boundary.
-        if (!std::isfinite(result))
-        {
-            if (!impl_->non_finite_warned)
-            {
-                impl_->non_finite_warned = true;
-                SPDLOG_WARN("Key '{}': expression '{}' evaluated to {}; ignoring these samples "
-                            "(further occurrences not logged).",
-                            impl_->log_context, impl_->expression, result);
-            }
-            return std::nullopt;
-        }
+std::size_t ExpressionEvaluatorSet::size() const
+{
+    return impl_->members.size();
+}
 
-        return result;
-    }
-    catch (const std::exception& e)
+bool ExpressionEvaluatorSet::isValid(std::size_t member) const
+{
+    return impl_->members.at(member)->is_valid;
+}
+
+const std::string& ExpressionEvaluatorSet::getExpression(std::size_t member) const
+{
+    return impl_->members.at(member)->expression;
+}
+
+const std::vector<std::string>& ExpressionEvaluatorSet::variableNames(std::size_t member) const
+{
+    return impl_->members.at(member)->variable_names;
+}
+
+schema_type_t ExpressionEvaluatorSet::getSchemaType() const
+{
+    return impl_->table.schema_type;
+}
+
+const std::vector<std::string>& ExpressionEvaluatorSet::fieldNames() const
+{
+    return impl_->field_names;
+}
+
+void ExpressionEvaluatorSet::checkPublishedSchema(std::string_view encoding)
+{
+    if (impl_->schema_checked)
     {
-        SPDLOG_ERROR("Expression evaluation failed: {}", e.what());
-        return std::nullopt;
+        return;
     }
+    impl_->schema_checked = true;
+    reportSchemaMismatch(encoding, impl_->table.schema_type, impl_->table.log_context);
 }
 
-void ExpressionEvaluator::warnOutOfRange(double value)
+void ExpressionEvaluatorSet::evaluateToDouble(std::span<const std::uint8_t> payload,
+                                              std::span<std::optional<double>> results)
 {
-    if (impl_->range_warned)
+    std::fill(results.begin(), results.end(), std::nullopt);
+
+    // Nothing to evaluate is nothing to decode -- and a set whose every member
+    // failed validation has already said so, once, at construction.
+    if (impl_->valid.empty() || !impl_->table.decode(payload))
     {
         return;
     }
-    impl_->range_warned = true;
-    SPDLOG_WARN("Key '{}': expression '{}' produced {}, which does not fit the configured type; "
-                "ignoring these samples (further occurrences not logged).",
-                impl_->log_context, impl_->expression, value);
+
+    for (const std::size_t member : impl_->valid)
+    {
+        if (member < results.size())
+        {
+            results[member] = impl_->members[member]->value(impl_->table);
+        }
+    }
 }
 
 }  // namespace pub_sub
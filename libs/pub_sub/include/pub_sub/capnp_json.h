@@ -10,6 +10,7 @@
 #include <optional>
 
 #include <cstdint>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -27,7 +28,7 @@ using json = nlohmann::json;
 //
 // Throws kj::Exception on a malformed message, which callers must catch --
 // capnp's readers signal structural damage that way rather than by return value.
-json capnpToJson(const std::vector<std::uint8_t>& bytes, capnp::Schema schema);
+json capnpToJson(std::span<const std::uint8_t> bytes, capnp::Schema schema);
 
 // The reverse: fills `builder` from `value`. Appends a description of every
 // problem to `errors` and returns false if any were found.
@@ -8,6 +8,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <span>
 #include <vector>
 
 namespace pub_sub
@@ -81,8 +82,18 @@ class WordAlignedPayload
     {
     }
 
-    // What zenoh's Bytes::as_vector() hands back, which is how every subscriber
-    // and queryable in this tree receives a payload.
+    // What a subscriber is handed: a view straight into zenoh's buffer. That
+    // buffer is word-aligned when the publisher allocated it from the SHM pool
+    // (see detail::PayloadBuffer) and usually when it is a network receive
+    // buffer, but neither is a promise -- this is the case the copy is for.
+    explicit WordAlignedPayload(std::span<const std::uint8_t> bytes) :
+        WordAlignedPayload(reinterpret_cast<const kj::byte*>(bytes.data()), bytes.size())
+    {
+    }
+
+    // What zenoh's Bytes::as_vector() hands back, which is how the client and
+    // the tools still receive a payload. Exact match, so a vector does not have
+    // to pick between this and the span overload.
     explicit WordAlignedPayload(const std::vector<std::uint8_t>& bytes) :
         WordAlignedPayload(reinterpret_cast<const kj::byte*>(bytes.data()), bytes.size())
     {
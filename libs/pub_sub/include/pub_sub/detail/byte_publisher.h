@@ -1,10 +1,13 @@
 #ifndef PUB_SUB_DETAIL_BYTE_PUBLISHER_H_
 #define PUB_SUB_DETAIL_BYTE_PUBLISHER_H_
 
+#include "pub_sub/detail/payload_buffer.h"
+
 #include <capnp/common.h>
 
 #include <kj/array.h>
 
+#include <cstddef>
 #include <functional>
 #include <memory>
 #include <string_view>
@@ -46,6 +49,22 @@ class BytePublisher
     // this returns, so the caller cannot pool or reuse it.
     void put(kj::Array<capnp::word> payload);
 
+    // The write-once path: allocate() a buffer of the payload's size, write the
+    // payload into it, put() it. At or above sharedMemoryMinBytes() the buffer
+    // is SHM and zenoh sends it as it is; below, it is the heap array the
+    // overload above would have taken. Either way nothing is copied after the
+    // caller's own write.
+    PayloadBuffer allocate(std::size_t bytes) const;
+    void put(PayloadBuffer payload);
+
+    // Where allocate() switches to shared memory. Defaults to the transport's
+    // own threshold, kSharedMemoryMinBytes, so a publisher that never calls this
+    // uses SHM for exactly the payloads zenoh would have copied into it anyway.
+    // Lower it only for a stream measured to gain from it -- the 256 KB default
+    // exists because small payloads measured slower through the pool.
+    void setSharedMemoryMinBytes(std::size_t bytes);
+    std::size_t sharedMemoryMinBytes() const;
+
     bool hasSubscribers() const;
 
     // Fires when the answer to hasSubscribers() changes. Runs on a zenoh thread,
@@ -5,6 +5,7 @@
 #include <functional>
 #include <memory>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -78,7 +79,12 @@ class ByteSubscriber
     // Runs on a zenoh RX thread. Must not throw: the frame above it is Rust, and
     // an exception crossing that boundary aborts the process. ByteSubscriber
     // catches anything that escapes anyway, because "must not" is not "cannot".
-    using Handler = std::function<void(const std::vector<std::uint8_t>& payload,
+    //
+    // `payload` is a view, normally straight into zenoh's receive buffer or SHM
+    // segment, and valid for the duration of the call only -- copy it to keep
+    // it. Its address is not promised to be word-aligned; WordAlignedPayload
+    // takes care of that for capnp.
+    using Handler = std::function<void(std::span<const std::uint8_t> payload,
                                        const SampleMeta& meta)>;
 
     ByteSubscriber(const std::string& keyexpr, Handler on_sample);
@@ -0,0 +1,87 @@
+#ifndef PUB_SUB_DETAIL_PAYLOAD_BUFFER_H_
+#define PUB_SUB_DETAIL_PAYLOAD_BUFFER_H_
+
+#include <capnp/common.h>
+
+#include <kj/array.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+namespace zenoh
+{
+class Bytes;
+}
+
+namespace pub_sub::detail
+{
+
+// The size at which a payload is worth putting in shared memory at all.
+//
+// One number for two mechanisms, so they cannot drift apart: SessionManager
+// hands it to zenoh as the transport's own SHM threshold, and PayloadBuffer uses
+// it to decide whether an outgoing buffer comes from the SHM pool in the first
+// place. See session_manager.cpp for how 256 KB was arrived at.
+inline constexpr std::size_t kSharedMemoryMinBytes = 256 * 1024;
+
+// One outgoing payload, allocated where it is going to be sent from.
+//
+// The point is the copy it removes. A payload built on the heap and put() above
+// the transport's SHM threshold was copied again, by zenoh, into its SHM pool --
+// a 9 MB tile reply written twice to be read once. A PayloadBuffer allocated at
+// or above `shm_min_bytes` comes straight out of a process-wide SHM provider, so
+// the caller writes into the memory the subscriber will read and zenoh passes it
+// on as it is.
+//
+// Below the threshold, and whenever the pool cannot supply one -- exhausted, or a
+// build without zenoh's shared-memory API -- it is an ordinary heap array, which
+// is exactly what publishing cost before. Nothing a caller writes depends on
+// which it got; inSharedMemory() exists for the benchmark and for logging.
+//
+// bytes() is word-aligned in both cases, so a capnp reader in the same process
+// could read it in place, and so can one on the other side of the pool.
+//
+// Single use: the buffer is handed to zenoh by intoZenohBytes() below, after
+// which it is empty.
+class PayloadBuffer
+{
+  public:
+    // `bytes` is rounded up to a whole number of capnp words.
+    static PayloadBuffer allocate(std::size_t bytes,
+                                  std::size_t shm_min_bytes = kSharedMemoryMinBytes);
+
+    // Adopts an array that already holds a payload -- what messageToFlatArray()
+    // returns, or a bag replay read off disk. No copy and no SHM.
+    explicit PayloadBuffer(kj::Array<capnp::word> words);
+
+    PayloadBuffer(PayloadBuffer&&) noexcept;
+    PayloadBuffer& operator=(PayloadBuffer&&) noexcept;
+    PayloadBuffer(const PayloadBuffer&) = delete;
+    PayloadBuffer& operator=(const PayloadBuffer&) = delete;
+    ~PayloadBuffer();
+
+    std::span<std::uint8_t> bytes() const;
+    bool empty() const;
+
+    bool inSharedMemory() const;
+
+  private:
+    friend zenoh::Bytes intoZenohBytes(PayloadBuffer&& buffer);
+
+    struct Impl;
+    explicit PayloadBuffer(std::unique_ptr<Impl> impl);
+
+    std::unique_ptr<Impl> impl_;
+};
+
+// Hands the buffer to zenoh without copying it: an SHM buffer as itself, a heap
+// one with a deleter that frees it once zenoh and every clone of the payload are
+// done. Declared here so this header needs no <zenoh.hxx>; only callers that
+// already include it can use the result.
+zenoh::Bytes intoZenohBytes(PayloadBuffer&& buffer);
+
+}  // namespace pub_sub::detail
+
+#endif  // PUB_SUB_DETAIL_PAYLOAD_BUFFER_H_
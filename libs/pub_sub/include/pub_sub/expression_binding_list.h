@@ -0,0 +1,188 @@
+#ifndef PUB_SUB_EXPRESSION_BINDING_LIST_H_
+#define PUB_SUB_EXPRESSION_BINDING_LIST_H_
+
+#include "pub_sub/capnp_encoding.h"
+#include "pub_sub/expression_evaluator.h"
+#include "pub_sub/schema_registry.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace pub_sub
+{
+
+// Every expression bound to one key, grouped by the schema it decodes against,
+// with ONE ExpressionEvaluatorSet per group -- the binding list behind scope's
+// and the dashboard's one-subscription-per-key. Both used to carry a copy of it.
+//
+//   struct Binding { schema_type_t schema_type; std::string expression; Sink sink; };
+//   auto list = ExpressionBindingList<Binding>::build(bindings, key);
+//   list->evaluate(payload, schema_name,
+//                  [](const Binding& binding, double value) { binding.sink(value); });
+//
+// `Binding` is the consumer's: anything with a `schema_type` and an `expression`,
+// plus wherever its values go. The list holds them by shared_ptr, so a callback
+// already running when one is released keeps it alive to the end.
+//
+// That grouping is what makes thirty fields of a MoTeC topic one capnp decode
+// per sample instead of thirty. Almost always there is exactly one group -- two
+// schemas on one key is a config mistake, and the schema check will say so --
+// but nothing here has to assume it.
+//
+// Built whole and replaced whole on every bind and release: the consumer keeps
+// it behind a copy-on-write shared_ptr<const>, so the sets are recompiled then
+// too. An exprtk compile per bound expression is paid on the GUI thread when
+// someone binds one; the decode it saves is paid on the RX thread at the sample
+// rate.
+//
+// evaluate() may be called from several threads at once. zenoh does not promise
+// one RX thread per subscription, and a set is not thread-safe -- evaluating
+// writes its shared slots -- so each group holds a mutex from the decode to the
+// last delivery. Two samples on one key serialise; different keys never meet.
+template <typename Binding>
+class ExpressionBindingList
+{
+    struct Evaluation;
+
+  public:
+    struct Group
+    {
+        schema_type_t schema_type{};
+
+        // Member i of the group's set is bindings[i]'s expression.
+        std::vector<std::shared_ptr<Binding>> bindings;
+
+        // What evaluate() writes, behind the mutex that guards it. By pointer
+        // because neither the mutex nor the set can be moved into `groups_`.
+        std::unique_ptr<Evaluation> evaluation;
+    };
+
+    // The list for these bindings, with a set compiled for each schema among
+    // them. Null when any expression did not compile; the set has logged why,
+    // against `log_context` (the key).
+    static std::shared_ptr<const ExpressionBindingList> build(
+        const std::vector<std::shared_ptr<Binding>>& bindings, const std::string& log_context)
+    {
+        std::map<schema_type_t, std::vector<std::shared_ptr<Binding>>> by_schema;
+        for (const std::shared_ptr<Binding>& binding : bindings)
+        {
+            by_schema[binding->schema_type].push_back(binding);
+        }
+
+        auto list = std::make_shared<ExpressionBindingList>();
+        for (auto& [schema_type, members] : by_schema)
+        {
+            std::vector<std::string> expressions;
+            expressions.reserve(members.size());
+            for (const std::shared_ptr<Binding>& binding : members)
+            {
+                expressions.push_back(binding->expression);
+            }
+
+            Group group;
+            group.schema_type = schema_type;
+            group.evaluation =
+                std::make_unique<Evaluation>(schema_type, expressions, log_context);
+            for (std::size_t i = 0; i < members.size(); ++i)
+            {
+                if (!group.evaluation->evaluators.isValid(i))
+                {
+                    return nullptr;
+                }
+            }
+            group.bindings = std::move(members);
+            list->groups_.push_back(std::move(group));
+        }
+        return list;
+    }
+
+    bool empty() const { return groups_.empty(); }
+
+    // One per schema among the bindings, for reporting; evaluate() is the only
+    // way to run them.
+    const std::vector<Group>& groups() const { return groups_; }
+
+    // Every binding, in no particular order, for rebuilding from.
+    std::vector<std::shared_ptr<Binding>> all() const
+    {
+        std::vector<std::shared_ptr<Binding>> out;
+        for (const Group& group : groups_)
+        {
+            out.insert(out.end(), group.bindings.begin(), group.bindings.end());
+        }
+        return out;
+    }
+
+    // Evaluates every group against one sample and calls
+    // `deliver(const Binding&, double)` for each value that came out. nullopt
+    // means the sample was unusable for that binding, and it is skipped: a gap
+    // or a held last value is honest where a substituted zero is not.
+    //
+    // `schema_name` is RawSubscriber's schema half, e.g. "MotecM1EngineAir".
+    // `deliver` runs under the group's lock, so it must not re-enter this list.
+    template <typename Deliver>
+    void evaluate(std::span<const std::uint8_t> payload, std::string_view schema_name,
+                  Deliver&& deliver) const
+    {
+        for (const Group& group : groups_)
+        {
+            Evaluation& evaluation = *group.evaluation;
+            const std::lock_guard<std::mutex> lock(evaluation.mutex);
+
+            // Checked once per group, because decoding against the wrong schema
+            // is silent -- field offsets land on different bytes and you get a
+            // plausible number, not an error. The set wants the whole encoding:
+            // a bare name reads as "no schema named", and a mismatch would only
+            // be logged at debug.
+            if (!evaluation.schema_checked)
+            {
+                evaluation.schema_checked = true;
+                std::string encoding(kCapnpEncodingMime);
+                if (!schema_name.empty())
+                {
+                    encoding.append(";").append(schema_name);
+                }
+                evaluation.evaluators.checkPublishedSchema(encoding);
+            }
+
+            evaluation.evaluators.evaluateToDouble(payload, evaluation.results);
+
+            for (std::size_t i = 0; i < group.bindings.size(); ++i)
+            {
+                if (evaluation.results[i])
+                {
+                    deliver(*group.bindings[i], *evaluation.results[i]);
+                }
+            }
+        }
+    }
+
+  private:
+    struct Evaluation
+    {
+        Evaluation(schema_type_t schema_type, const std::vector<std::string>& expressions,
+                   const std::string& log_context)
+            : evaluators(schema_type, expressions, log_context), results(expressions.size())
+        {
+        }
+
+        std::mutex mutex;
+        ExpressionEvaluatorSet evaluators;
+        std::vector<std::optional<double>> results;
+        bool schema_checked = false;
+    };
+
+    std::vector<Group> groups_;
+};
+
+}  // namespace pub_sub
+
+#endif  // PUB_SUB_EXPRESSION_BINDING_LIST_H_
@@ -17,6 +17,36 @@
 namespace pub_sub
 {
 
+// An evaluated double as the type a consumer asked for: anything non-zero is a
+// true bool, an integer is rounded, and nullopt means the rounded value does not
+// fit -- casting a double outside the destination's range is undefined, not
+// saturating.
+//
+// Free, rather than inside ExpressionEvaluator::evaluate(), for a consumer that
+// evaluates through an ExpressionEvaluatorSet and still hands out typed values.
+template <typename T>
+std::optional<T> convertResult(double result)
+{
+    if constexpr (std::is_same_v<T, bool>)
+    {
+        return static_cast<T>(result != 0.0);
+    }
+    else if constexpr (std::is_integral_v<T>)
+    {
+        const double rounded = std::round(result);
+        if (rounded < static_cast<double>(std::numeric_limits<T>::lowest()) ||
+            rounded > static_cast<double>(std::numeric_limits<T>::max()))
+        {
+            return std::nullopt;
+        }
+        return static_cast<T>(rounded);
+    }
+    else
+    {
+        return static_cast<T>(result);
+    }
+}
+
 // "Decode these bytes against this schema and evaluate this expression over its
 // fields" -- with no zenoh in it at all.
 //
@@ -105,28 +135,12 @@ class ExpressionEvaluator
             return std::nullopt;
         }
 
-        if constexpr (std::is_same_v<T, bool>)
-        {
-            // Anything non-zero is true.
-            return static_cast<T>(*result != 0.0);
-        }
-        else if constexpr (std::is_integral_v<T>)
+        const std::optional<T> converted = convertResult<T>(*result);
+        if (!converted)
         {
-            // Round first, then check the value actually fits: casting a double
-            // outside the destination's range is undefined, not saturating.
-            const double rounded = std::round(*result);
-            if (rounded < static_cast<double>(std::numeric_limits<T>::lowest()) ||
-                rounded > static_cast<double>(std::numeric_limits<T>::max()))
-            {
-                warnOutOfRange(rounded);
-                return std::nullopt;
-            }
-            return static_cast<T>(rounded);
-        }
-        else
-        {
-            return static_cast<T>(*result);
+            warnOutOfRange(std::round(*result));
         }
+        return converted;
     }
 
     // The decode-and-evaluate half, out of line because it is what drags in
@@ -154,6 +168,96 @@ class ExpressionEvaluator
     std::unique_ptr<Impl> impl_;
 };
 
+// How a payload's fields reach the expressions that read them.
+//
+// Direct reads a primitive field, or a $fixedLength list of them, straight from
+// the struct's data and pointer sections at an offset the schema fixed when the
+// expression was compiled -- a bounds check and a load per field. Dynamic goes
+// through capnp::DynamicStruct::get() for every field, which is what every field
+// cost before Direct existed. Direct already falls back to it for the rare field
+// whose place is not fixed, a member of an unnamed union.
+//
+// Dynamic is not for production. It is here so pub_sub_bench_field_access can
+// measure the difference and pub_sub_test_expression_evaluator can show there is
+// none in the answers.
+enum class FieldAccess
+{
+    Direct,
+    Dynamic,
+};
+
+// Several expressions over ONE schema, decoded once per payload.
+//
+//   ExpressionEvaluatorSet set(schema_type_t::MotecM1EngineAir,
+//                              {"engineSpeedRpm", "mapKpa", "engineSpeedRpm / 1000.0"},
+//                              "motec/m1/engine_air");
+//   std::vector<std::optional<double>> values(set.size());
+//   set.evaluateToDouble(payload, values);
+//
+// Plotting thirty fields of a MoTeC topic through thirty ExpressionEvaluators
+// costs thirty FlatArrayMessageReaders and thirty walks of the dynamic API per
+// sample, each reading a handful of fields out of the same bytes. This reads the
+// UNION of the fields its members name, once, into one shared table of slots,
+// and then runs every member's compiled expression against that table. A field
+// two members both read is decoded once.
+//
+// Members are fixed at construction. exprtk binds a variable to its slot by
+// address when an expression is compiled, so adding a member later would mean
+// growing the table under expressions already bound to it; a consumer whose
+// set of expressions changes builds a new set, which is what a copy-on-write
+// binding list does anyway.
+//
+// One bad member does not spoil the rest. Each is validated on its own and
+// reports its own isValid(); an invalid member simply always evaluates to
+// nullopt. Likewise a list whose length contradicts the schema withholds a
+// value from the members that read it and no others.
+//
+// Not thread-safe, for the same reason ExpressionEvaluator is not: evaluating
+// writes the shared slots. One set per thread.
+class ExpressionEvaluatorSet
+{
+  public:
+    ExpressionEvaluatorSet(schema_type_t schema_type,
+                           const std::vector<std::string>& expressions,
+                           std::string log_context = {},
+                           FieldAccess access = FieldAccess::Direct);
+    ~ExpressionEvaluatorSet();
+
+    ExpressionEvaluatorSet(const ExpressionEvaluatorSet&) = delete;
+    ExpressionEvaluatorSet& operator=(const ExpressionEvaluatorSet&) = delete;
+    ExpressionEvaluatorSet(ExpressionEvaluatorSet&&) = delete;
+    ExpressionEvaluatorSet& operator=(ExpressionEvaluatorSet&&) = delete;
+
+    // Members, in the order they were given.
+    std::size_t size() const;
+
+    // Per member, meaning exactly what ExpressionEvaluator::isValid() means.
+    bool isValid(std::size_t member) const;
+    const std::string& getExpression(std::size_t member) const;
+    const std::vector<std::string>& variableNames(std::size_t member) const;
+
+    schema_type_t getSchemaType() const;
+
+    // Every field a valid member reads, sorted and once each: what one sample
+    // actually decodes.
+    const std::vector<std::string>& fieldNames() const;
+
+    // As ExpressionEvaluator::checkPublishedSchema(), once for the whole set --
+    // the members share a schema, so they share the answer.
+    void checkPublishedSchema(std::string_view encoding);
+
+    // Decode `payload` once and evaluate every member against it. `results`
+    // must hold size() entries; each is the member's value, or nullopt for the
+    // same reasons ExpressionEvaluator::evaluateToDouble() gives one. A payload
+    // that cannot be decoded at all leaves every entry nullopt.
+    void evaluateToDouble(std::span<const std::uint8_t> payload,
+                          std::span<std::optional<double>> results);
+
+  private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
 }  // namespace pub_sub
 
 #endif  // PUB_SUB_EXPRESSION_EVALUATOR_H_
@@ -8,9 +8,9 @@
 #include <functional>
 #include <memory>
 #include <optional>
+#include <span>
 #include <string>
 #include <utility>
-#include <vector>
 
 namespace pub_sub
 {
@@ -66,7 +66,7 @@ class ZenohExpressionSubscriber
     template <typename T>
     void setResultCallback(std::function<void(T)> callback)
     {
-        setRawCallback([this, cb = std::move(callback)](const std::vector<std::uint8_t>& payload) {
+        setRawCallback([this, cb = std::move(callback)](std::span<const std::uint8_t> payload) {
             try
             {
                 // No value means this sample was unusable (bad payload,
@@ -103,7 +103,7 @@ class ZenohExpressionSubscriber
     // destination -- are precisely what wants testing without a live publisher on
     // the other end of a bus.
     template <typename T>
-    std::optional<T> evaluate(const std::vector<std::uint8_t>& payload)
+    std::optional<T> evaluate(std::span<const std::uint8_t> payload)
     {
         return evaluator_->evaluate<T>(payload);
     }
@@ -111,7 +111,7 @@ class ZenohExpressionSubscriber
   private:
     void reportCallbackThrew();
 
-    void setRawCallback(std::function<void(const std::vector<std::uint8_t>&)> handler);
+    void setRawCallback(std::function<void(std::span<const std::uint8_t>)> handler);
 
     // Declared BEFORE impl_, so it is destroyed AFTER it. impl_ owns the
     // subscription, whose destructor joins in-flight callbacks, and those
@@ -5,9 +5,9 @@
 #include <functional>
 #include <memory>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
-#include <vector>
 
 namespace pub_sub
 {
@@ -37,7 +37,11 @@ class RawSubscriber
     // above is Rust, and an exception crossing that boundary aborts the process.
     // RawSubscriber catches anything that escapes anyway, because "must not" is
     // not "cannot".
-    using Handler = std::function<void(const std::vector<std::uint8_t>& payload,
+    //
+    // `payload` is a view too, usually straight into zenoh's buffer, and valid
+    // for the call only. A consumer that keeps bytes copies exactly the ones it
+    // keeps, rather than every subscriber paying for a copy up front.
+    using Handler = std::function<void(std::span<const std::uint8_t> payload,
                                        std::string_view schema_name)>;
 
     // Everything about a sample except its bytes, resolved eagerly.
@@ -75,7 +79,7 @@ class RawSubscriber
     };
 
     using InfoHandler =
-        std::function<void(const std::vector<std::uint8_t>& payload, const SampleInfo& info)>;
+        std::function<void(std::span<const std::uint8_t> payload, const SampleInfo& info)>;
 
     RawSubscriber(const std::string& keyexpr, Handler on_sample);
 
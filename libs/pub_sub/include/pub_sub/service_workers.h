@@ -0,0 +1,134 @@
+#ifndef PUB_SUB_SERVICE_WORKERS_H_
+#define PUB_SUB_SERVICE_WORKERS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace pub_sub
+{
+
+// Threads for ZenohService handlers that should not run on zenoh's.
+//
+// A ZenohService answers inside the queryable callback, on one of the session's
+// RX threads, which is right for a handler that takes microseconds and wrong for
+// one that does not. map_server's route handler runs a bidirectional Dijkstra
+// and its tile handler can assemble a 64-tile batch; either one parked on an RX
+// thread holds up every other reply and every subscriber delivery on the
+// session behind it, so one slow route made unrelated tiles late.
+//
+// A service built with a pool hands each query to it instead: the RX thread
+// takes a reference to the query and returns, and a worker decodes, runs the
+// handler and replies. What a service may use of the pool is bounded per
+// service by ServiceLimits, so a burst of routes cannot take every worker from
+// the tiles sharing the pool. A query that arrives with the service at its limit
+// and its queue full is refused at once with the busy reply below, rather than
+// queued behind work that will not finish before the caller's timeout anyway.
+//
+// No zenoh in here: the pool runs std::function, and a test can drive it
+// without a session.
+class ServiceWorkerPool
+{
+  public:
+    // `threads` of 0 is taken as 1.
+    explicit ServiceWorkerPool(std::size_t threads);
+
+    // Runs whatever has been posted, then joins. Every service using the pool
+    // must be gone first; ZenohService's destructor waits for its own work, so
+    // declaring the pool before the services is enough.
+    ~ServiceWorkerPool();
+
+    ServiceWorkerPool(const ServiceWorkerPool&) = delete;
+    ServiceWorkerPool& operator=(const ServiceWorkerPool&) = delete;
+
+    std::size_t threads() const;
+
+    // Any thread. Runs `job` on a worker. No bound here -- ServiceLane is what
+    // bounds what reaches this.
+    void post(std::function<void()> job);
+
+  private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+// What one service may take from a pool.
+struct ServiceLimits
+{
+    // Handlers of this service running at once. Requests beyond it wait.
+    std::size_t maxConcurrency { 1 };
+
+    // Requests waiting behind those. One more than this is refused as busy, so
+    // 0 means "run it now or refuse it".
+    std::size_t maxQueued { 16 };
+};
+
+// A service's queue as of one call to ServiceLane::load(). Counters are since
+// the lane was made; times are in microseconds.
+struct ServiceLoad
+{
+    // What the lane was made with, after ServiceLane's adjustments.
+    ServiceLimits limits;
+
+    std::size_t queued { 0 };
+    std::size_t inFlight { 0 };
+    std::size_t peakQueued { 0 };
+
+    std::uint64_t accepted { 0 };
+    std::uint64_t completed { 0 };
+
+    // Refused with the busy reply.
+    std::uint64_t shed { 0 };
+
+    // From arrival to a worker starting on it.
+    std::uint64_t totalWaitUs { 0 };
+    std::uint64_t maxWaitUs { 0 };
+
+    // The handler and the reply, on the worker.
+    std::uint64_t totalRunUs { 0 };
+    std::uint64_t maxRunUs { 0 };
+
+    std::uint64_t meanWaitUs() const { return completed == 0 ? 0 : totalWaitUs / completed; }
+    std::uint64_t meanRunUs() const { return completed == 0 ? 0 : totalRunUs / completed; }
+};
+
+// One service's share of a pool: its limits, its queue and its numbers.
+class ServiceLane
+{
+  public:
+    // `name` is for the log -- the service's key.
+    ServiceLane(std::string name, ServiceWorkerPool& pool, ServiceLimits limits);
+
+    // Drops whatever is still queued -- a dropped query is answered by zenoh
+    // with nothing, which the caller sees as no reply -- and waits for the
+    // handlers already running to finish, so nothing they capture can be
+    // destroyed under them.
+    ~ServiceLane();
+
+    ServiceLane(const ServiceLane&) = delete;
+    ServiceLane& operator=(const ServiceLane&) = delete;
+
+    // Any thread. False when the lane is at its limit and its queue is full, in
+    // which case `job` has not been run and will not be.
+    bool submit(std::function<void()> job);
+
+    ServiceLoad load() const;
+
+  private:
+    struct State;
+    std::shared_ptr<State> state_;
+};
+
+// The error reply a service sends when it sheds a query: a reply_err whose
+// payload is exactly kServiceBusyReply, with kServiceBusyEncoding. Fixed
+// strings rather than a capnp message, because it has to mean the same thing
+// whatever the service's response schema is.
+inline constexpr std::string_view kServiceBusyReply = "busy";
+inline constexpr std::string_view kServiceBusyEncoding = "text/plain;pub_sub.busy";
+
+} // namespace pub_sub
+
+#endif // PUB_SUB_SERVICE_WORKERS_H_
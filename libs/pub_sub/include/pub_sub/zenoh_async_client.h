@@ -19,6 +19,7 @@
 #include "pub_sub/capnp_payload.h"
 #include "pub_sub/zenoh_payload.h"
 #include "pub_sub/schema_registry.h"
+#include "pub_sub/service_workers.h"
 #include "pub_sub/session_manager.h"
 
 #include "spdlog/spdlog.h"
@@ -65,6 +66,10 @@ class ZenohAsyncClient
         Malformed,
         // The get() call itself could not be made.
         Failed,
+        // The service is at its limit and refused the request without running
+        // it -- see pub_sub/service_workers.h. Unlike NoReply this says the
+        // service is there, so asking again later is the right response.
+        Busy,
     };
 
     static const char* to_string(Status status)
@@ -79,6 +84,8 @@ class ZenohAsyncClient
                 return "malformed reply";
             case Status::Failed:
                 return "request failed";
+            case Status::Busy:
+                return "service busy";
         }
         return "unknown";
     }
@@ -155,6 +162,13 @@ class ZenohAsyncClient
                         }
                         if (!reply.is_ok())
                         {
+                            // The only error reply anything in this tree sends
+                            // is the busy one; any other is left to end as
+                            // NoReply, as every error reply used to.
+                            if (reply.get_err().get_payload().as_string() == kServiceBusyReply)
+                            {
+                                state->deliver(Status::Busy, nullptr);
+                            }
                             return;
                         }
 
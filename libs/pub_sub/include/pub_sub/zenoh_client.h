@@ -15,6 +15,7 @@
 #include "pub_sub/capnp_encoding.h"
 #include "pub_sub/capnp_payload.h"
 #include "pub_sub/zenoh_payload.h"
+#include "pub_sub/service_workers.h"
 #include "pub_sub/session_manager.h"
 
 #include "spdlog/spdlog.h"
@@ -99,6 +100,13 @@ class ZenohClient
                         return true;
                     }
                 }
+                else if (reply.get_err().get_payload().as_string() == kServiceBusyReply)
+                {
+                    // Said here rather than left to the "no response" below:
+                    // the service is up and refused this one because of load.
+                    SPDLOG_ERROR("Service on '{}' is busy; try again", mKeyExpr);
+                    return false;
+                }
             }
             else
             {
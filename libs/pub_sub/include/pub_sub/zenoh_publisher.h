@@ -7,9 +7,11 @@
 #include "pub_sub/detail/byte_publisher.h"
 #include "pub_sub/schema_registry.h"
 
+#include <cstdint>
 #include <cstring>
 #include <functional>
 #include <new>
+#include <span>
 #include <string_view>
 #include <utility>
 
@@ -91,19 +93,35 @@ public:
     bool hasSubscribers() const { return mPublisher.hasSubscribers(); }
 
     // Serialise the current message and publish it, then start a fresh one.
+    //
+    // The message is written exactly once, from the builder's segments into the
+    // buffer zenoh sends. That buffer comes from the SHM pool for a large enough
+    // message -- see detail::PayloadBuffer -- which is what used to cost a second
+    // full copy: messageToFlatArray() into the heap, then zenoh's transport from
+    // the heap into its pool.
     void put()
     {
-        kj::Array<capnp::word> words = capnp::messageToFlatArray(mMessage);
-        const size_t flat_words = words.size();
+        const size_t flat_words = capnp::computeSerializedSizeInWords(mMessage);
 
         // Ownership goes with it: zenoh may hold the payload after this returns,
         // which is why the buffer cannot be pooled and this is the one allocation
         // per message that has to stay.
-        mPublisher.put(kj::mv(words));
+        detail::PayloadBuffer payload = mPublisher.allocate(flat_words * sizeof(capnp::word));
+        const std::span<std::uint8_t> bytes = payload.bytes();
+        kj::ArrayOutputStream out(
+            kj::arrayPtr(reinterpret_cast<kj::byte*>(bytes.data()), bytes.size()));
+        capnp::writeMessage(out, mMessage);
+        mPublisher.put(std::move(payload));
 
         rebuildOverScratch(flat_words);
     }
 
+    // Where put() switches to writing into shared memory. See
+    // detail::BytePublisher::setSharedMemoryMinBytes() -- the default is the
+    // transport's own threshold, and lowering it is a measured decision, not a
+    // free one.
+    void setSharedMemoryMinBytes(size_t bytes) { mPublisher.setSharedMemoryMinBytes(bytes); }
+
 private:
     // First-segment size for the message builder, in 8-byte words. Small enough
     // to be free, and grown to fit on the first message that needs more -- see
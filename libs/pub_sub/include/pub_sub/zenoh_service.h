@@ -2,6 +2,7 @@
 #define ZENOH_SERVICE_H_
 
 #include <functional>
+#include <memory>
 #include <optional>
 #include <string>
 
@@ -9,11 +10,15 @@
 #include "pub_sub/session_manager.h"
 #include <capnp/message.h>
 #include <capnp/serialize.h>
+#include <cstdint>
 #include <cstring>
+#include <span>
 
 #include "pub_sub/schema_registry.h"
 #include "pub_sub/capnp_encoding.h"
 #include "pub_sub/capnp_payload.h"
+#include "pub_sub/detail/payload_buffer.h"
+#include "pub_sub/service_workers.h"
 #include "pub_sub/zenoh_payload.h"
 #include "pub_sub/topic_key.h"
 
@@ -33,91 +38,79 @@ class ZenohService
     using ResponseBuilder = typename ResponseT::Builder;
     using Handler = std::function<void(const RequestReader&, ResponseBuilder&)>;
 
+    // Answers on zenoh's thread, inside the queryable callback. Right for a
+    // handler that takes microseconds, which is nearly all of them.
     ZenohService(std::string keyexpr, Handler handler) :
         mKeyExpr(std::move(keyexpr)),
         mHandler(std::move(handler)),
         mSession(pub_sub::SessionManager::getOrCreate())
     {
-        
-        auto on_query = [this](const zenoh::Query& query)
+        declare();
+    }
+
+    // Answers on `pool`, within `limits` -- see pub_sub/service_workers.h. For
+    // a handler slow enough to hold up everything else on the session: a query
+    // that finds the service at its limit and its queue full gets the busy
+    // reply at once. `pool` must outlive the service.
+    ZenohService(std::string keyexpr, Handler handler, ServiceWorkerPool& pool,
+                 ServiceLimits limits) :
+        mKeyExpr(std::move(keyexpr)),
+        mHandler(std::move(handler)),
+        mSession(pub_sub::SessionManager::getOrCreate()),
+        mLane(std::make_unique<ServiceLane>(mKeyExpr, pool, limits))
+    {
+        declare();
+    }
+
+    ~ZenohService()
+    {
+        // The queryable first, which joins any callback still submitting; then
+        // the lane, which waits for the handlers already running. After both,
+        // nothing can call mHandler.
+        if (mQueryable.has_value())
+        {
+            std::move(mQueryable.value()).undeclare();
+            mQueryable.reset();
+        }
+        mLane.reset();
+    }
+
+    ZenohService(const ZenohService&) = delete;
+    ZenohService& operator=(const ZenohService&) = delete;
+    ZenohService(ZenohService&&) noexcept = default;
+    ZenohService& operator=(ZenohService&&) noexcept = delete;
+
+    const std::string& key() const { return mKeyExpr; }
+
+    // The worker queue's numbers; nullopt for a service that answers inline.
+    std::optional<ServiceLoad> load() const
+    {
+        if (!mLane)
         {
-            // Decode request (if any)
-            capnp::MallocMessageBuilder respBuilder;
-            auto resp = respBuilder.template initRoot<ResponseT>();
+            return std::nullopt;
+        }
+        return mLane->load();
+    }
 
-            if (auto payloadRef = query.get_payload())
+private:
+    void declare()
+    {
+        auto on_query = [this](const zenoh::Query& query)
+        {
+            if (!mLane)
             {
-                const auto& bytes = payloadRef->get();
-                // Borrowed from the sample, not copied out of it -- see
-                // pub_sub/zenoh_payload.h. `bytes` outlives the reader below.
-                const ZenohPayload payload(bytes);
-                if (!payload.empty())
-                {
-                    capnp::FlatArrayMessageReader reader(payload.words());
-                    auto req = reader.template getRoot<RequestT>();
-                    // SIZE AND SCHEMA, NEVER THE MESSAGE. This used to log
-                    // req.toString().flatten() -- the whole message as text -- and that
-                    // is not a debug line you can afford on a data path.
-                    //
-                    // spdlog's SPDLOG_LOGGER_CALL expands straight to logger->log(...)
-                    // with no should_log() test, so every argument is evaluated
-                    // whatever the level is, and patches/spdlog_tweakme.patch sets
-                    // SPDLOG_ACTIVE_LEVEL to TRACE so SPDLOG_DEBUG is compiled in
-                    // rather than preprocessed away. capnp's toString() then walks
-                    // every byte of the message to build a string that gets discarded
-                    // at info level. Measured on a 64-tile map reply: ~99% of this
-                    // handler's CPU, and 81.9 ms of an 82 ms request.
-                    //
-                    // Guarding it with should_log() was the other option and is worse:
-                    // it leaves a --debug run stringifying megabytes per request, so
-                    // the one time you turn debugging on is the one time the thing you
-                    // are debugging changes shape. `inspect call` and `inspect echo`
-                    // already decode any message on the bus to JSON on demand, which
-                    // is what this line was reaching for and could never be as good at.
-                    SPDLOG_DEBUG("Service '{}' request {} bytes ('{}')", mKeyExpr, bytes.size(),
-                                 schema_traits<RequestT>::name);
-                    mHandler(req, resp);
-                }
-                else
-                {
-                    // Payload malformed; handler not invoked. Respond with default-constructed response.
-                    SPDLOG_ERROR("Payload malformed for key '{}'", mKeyExpr);
-                }
+                answer(query);
+                return;
             }
-            else
+
+            // A reference of our own, so the query outlives this callback. The
+            // query is finalised -- and the caller's get() completes -- when
+            // the last reference to it goes, which is after the worker's reply.
+            auto held = std::make_shared<zenoh::Query>(query.clone());
+            if (!mLane->submit([this, held]() { answer(*held); }))
             {
-                SPDLOG_ERROR("No payload for key '{}'", mKeyExpr);
+                replyBusy(query);
             }
-
-            // Serialize and reply.
-            //
-            // capnp has already laid the message out contiguously; zenoh is
-            // handed THAT buffer rather than a copy of it. This used to
-            // allocate a second buffer the size of the whole reply and memcpy
-            // into it, which for a map tile is a hundred kilobytes moved to
-            // produce bytes identical to the ones next to it -- on every
-            // request, for every service on the bus.
-            //
-            // The kj::Array is moved onto the heap and released by the
-            // deleter, which zenoh calls once the payload and every clone of
-            // it are done. Nothing here may assume the reply has been sent by
-            // the time reply() returns.
-            auto* held = new kj::Array<capnp::word>(capnp::messageToFlatArray(respBuilder));
-            const std::size_t bytes = held->size() * sizeof(capnp::word);
-
-            // Logged here rather than next to the request, because this is where the
-            // reply's size is known. See the note above on why it is a size and not
-            // the message.
-            SPDLOG_DEBUG("Service '{}' reply {} bytes ('{}')", mKeyExpr, bytes,
-                         schema_traits<ResponseT>::name);
-
-            zenoh::Query::ReplyOptions ropts = zenoh::Query::ReplyOptions::create_default();
-            ropts.encoding.emplace(kCapnpEncodingMime);
-            ropts.encoding->set_schema(std::string(schema_traits<ResponseT>::name));
-            query.reply(mKeyExpr,
-                        zenoh::Bytes(reinterpret_cast<uint8_t*>(held->begin()), bytes,
-                                     [held](uint8_t*) { delete held; }),
-                        std::move(ropts));
         };
 
         auto on_drop = []() {};
@@ -159,29 +152,112 @@ class ZenohService
         }
     }
 
-    ~ZenohService()
+    // Decode, run the handler, reply. On zenoh's thread or a worker's.
+    void answer(const zenoh::Query& query)
     {
-        if (mQueryable.has_value())
+        // Decode request (if any)
+        capnp::MallocMessageBuilder respBuilder;
+        auto resp = respBuilder.template initRoot<ResponseT>();
+
+        if (auto payloadRef = query.get_payload())
         {
-            std::move(mQueryable.value()).undeclare();
-            mQueryable.reset();
+            const auto& bytes = payloadRef->get();
+            // Borrowed from the sample, not copied out of it -- see
+            // pub_sub/zenoh_payload.h. `bytes` outlives the reader below.
+            const ZenohPayload payload(bytes);
+            if (!payload.empty())
+            {
+                capnp::FlatArrayMessageReader reader(payload.words());
+                auto req = reader.template getRoot<RequestT>();
+                // SIZE AND SCHEMA, NEVER THE MESSAGE. This used to log
+                // req.toString().flatten() -- the whole message as text -- and that
+                // is not a debug line you can afford on a data path.
+                //
+                // spdlog's SPDLOG_LOGGER_CALL expands straight to logger->log(...)
+                // with no should_log() test, so every argument is evaluated
+                // whatever the level is, and patches/spdlog_tweakme.patch sets
+                // SPDLOG_ACTIVE_LEVEL to TRACE so SPDLOG_DEBUG is compiled in
+                // rather than preprocessed away. capnp's toString() then walks
+                // every byte of the message to build a string that gets discarded
+                // at info level. Measured on a 64-tile map reply: ~99% of this
+                // handler's CPU, and 81.9 ms of an 82 ms request.
+                //
+                // Guarding it with should_log() was the other option and is worse:
+                // it leaves a --debug run stringifying megabytes per request, so
+                // the one time you turn debugging on is the one time the thing you
+                // are debugging changes shape. `inspect call` and `inspect echo`
+                // already decode any message on the bus to JSON on demand, which
+                // is what this line was reaching for and could never be as good at.
+                SPDLOG_DEBUG("Service '{}' request {} bytes ('{}')", mKeyExpr, bytes.size(),
+                             schema_traits<RequestT>::name);
+                mHandler(req, resp);
+            }
+            else
+            {
+                // Payload malformed; handler not invoked. Respond with
+                // default-constructed response.
+                SPDLOG_ERROR("Payload malformed for key '{}'", mKeyExpr);
+            }
+        }
+        else
+        {
+            SPDLOG_ERROR("No payload for key '{}'", mKeyExpr);
         }
+
+        // Serialize and reply.
+        //
+        // Written once, straight into the buffer zenoh sends, and handed
+        // over without a copy. For a reply at or above the SHM threshold
+        // -- every real map tile batch -- that buffer is shared memory, so
+        // the transport no longer copies a 9 MB reply into its pool after
+        // we have already laid it out once; below, it is a heap array
+        // released by zenoh once the payload and every clone of it are
+        // done. Nothing here may assume the reply has been sent by the time
+        // reply() returns. See detail::PayloadBuffer.
+        const std::size_t bytes =
+            capnp::computeSerializedSizeInWords(respBuilder) * sizeof(capnp::word);
+        detail::PayloadBuffer reply = detail::PayloadBuffer::allocate(bytes);
+        {
+            const std::span<std::uint8_t> out = reply.bytes();
+            kj::ArrayOutputStream stream(
+                kj::arrayPtr(reinterpret_cast<kj::byte*>(out.data()), out.size()));
+            capnp::writeMessage(stream, respBuilder);
+        }
+
+        // Logged here rather than next to the request, because this is where the
+        // reply's size is known. See the note above on why it is a size and not
+        // the message.
+        SPDLOG_DEBUG("Service '{}' reply {} bytes ('{}')", mKeyExpr, bytes,
+                     schema_traits<ResponseT>::name);
+
+        zenoh::Query::ReplyOptions ropts = zenoh::Query::ReplyOptions::create_default();
+        ropts.encoding.emplace(kCapnpEncodingMime);
+        ropts.encoding->set_schema(std::string(schema_traits<ResponseT>::name));
+        query.reply(mKeyExpr, detail::intoZenohBytes(std::move(reply)), std::move(ropts));
     }
 
-    ZenohService(const ZenohService&) = delete;
-    ZenohService& operator=(const ZenohService&) = delete;
-    ZenohService(ZenohService&&) noexcept = default;
-    ZenohService& operator=(ZenohService&&) noexcept = delete;
+    void replyBusy(const zenoh::Query& query)
+    {
+        // An error reply, so no client can mistake it for a response; with a
+        // payload and encoding of its own, so a client that cares can tell it
+        // from any other error. Not logged per query: shedding happens in
+        // bursts, and load() counts it.
+        zenoh::Query::ReplyErrOptions options = zenoh::Query::ReplyErrOptions::create_default();
+        options.encoding.emplace(kServiceBusyEncoding);
+        query.reply_err(zenoh::Bytes(std::string(kServiceBusyReply)), std::move(options));
+    }
 
-private:
     std::string mKeyExpr;
     Handler mHandler;
     std::optional<zenoh::Queryable<void>> mQueryable;
     std::shared_ptr<zenoh::Session> mSession;
 
-    // The liveliness token that makes this service discoverable. See the
-    // constructor; empty when it could not be declared, which is not fatal.
+    // The liveliness token that makes this service discoverable. See
+    // declare(); empty when it could not be declared, which is not fatal.
     std::optional<zenoh::LivelinessToken> mAdvertisement;
+
+    // Null for a service that answers inline.
+    std::unique_ptr<ServiceLane> mLane;
 };
 
 } // namespace pub_sub
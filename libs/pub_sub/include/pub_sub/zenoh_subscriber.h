@@ -20,10 +20,10 @@
 
 #include <cstdint>
 #include <functional>
+#include <span>
 #include <string>
 #include <string_view>
 #include <utility>
-#include <vector>
 
 namespace pub_sub
 {
@@ -32,9 +32,9 @@ namespace pub_sub
 // Reader. For consumers that want the whole message rather than one number out of
 // it.
 //
-// The Reader is only valid for the duration of the callback -- it points into a
-// buffer this owns, which is released as soon as the callback returns. Copy out
-// what you need.
+// The Reader is only valid for the duration of the callback -- it points straight
+// into zenoh's buffer for the sample, which is released as soon as the callback
+// returns. Copy out what you need.
 //
 // The callback runs on a zenoh RX thread. It may throw; the exception is caught
 // and logged rather than crossing back into zenoh.
@@ -50,7 +50,7 @@ class ZenohTypedSubscriber
     ZenohTypedSubscriber(const std::string& zenoh_key, std::function<void(Reader)> on_message) :
         subscriber_(zenoh_key,
                     [cb = std::move(on_message), key = zenoh_key](
-                        const std::vector<std::uint8_t>& bytes, const detail::SampleMeta&) {
+                        std::span<const std::uint8_t> bytes, const detail::SampleMeta&) {
                         // A partial word cannot be a message. capnp would read the
                         // short buffer as one whose fields are all default, so a
                         // damaged packet would look like a healthy one reporting
@@ -32,7 +32,7 @@ RawSubscriber::RawSubscriber(const std::string& keyexpr, Handler on_sample) :
     Impl* const impl = impl_.get();
     impl_->subscriber = std::make_unique<detail::ByteSubscriber>(
         keyexpr,
-        [impl](const std::vector<std::uint8_t>& payload, const detail::SampleMeta& meta) {
+        [impl](std::span<const std::uint8_t> payload, const detail::SampleMeta& meta) {
             if (!impl->handler)
             {
                 return;
@@ -59,7 +59,7 @@ RawSubscriber::RawSubscriber(const std::string& keyexpr, InfoHandler on_sample)
     Impl* const impl = impl_.get();
     impl_->subscriber = std::make_unique<detail::ByteSubscriber>(
         keyexpr,
-        [impl](const std::vector<std::uint8_t>& payload, const detail::SampleMeta& meta) {
+        [impl](std::span<const std::uint8_t> payload, const detail::SampleMeta& meta) {
             if (!impl->info_handler)
             {
                 return;
@@ -0,0 +1,271 @@
+#include "pub_sub/service_workers.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace pub_sub
+{
+
+// ----------------------------------------------------------------------------
+// The pool
+// ----------------------------------------------------------------------------
+
+struct ServiceWorkerPool::Impl
+{
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<std::function<void()>> jobs;
+    bool stopping { false };
+
+    std::vector<std::thread> threads;
+
+    void work()
+    {
+        while (true)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [this]() { return stopping || !jobs.empty(); });
+                if (jobs.empty())
+                {
+                    return;
+                }
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+};
+
+ServiceWorkerPool::ServiceWorkerPool(std::size_t threads) : impl_(std::make_unique<Impl>())
+{
+    const std::size_t count = std::max<std::size_t>(threads, 1);
+    impl_->threads.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        impl_->threads.emplace_back([impl = impl_.get()]() { impl->work(); });
+    }
+}
+
+ServiceWorkerPool::~ServiceWorkerPool()
+{
+    {
+        const std::lock_guard<std::mutex> guard(impl_->mutex);
+        impl_->stopping = true;
+    }
+    impl_->ready.notify_all();
+    for (std::thread& thread : impl_->threads)
+    {
+        thread.join();
+    }
+}
+
+std::size_t ServiceWorkerPool::threads() const
+{
+    return impl_->threads.size();
+}
+
+void ServiceWorkerPool::post(std::function<void()> job)
+{
+    {
+        const std::lock_guard<std::mutex> guard(impl_->mutex);
+        impl_->jobs.push_back(std::move(job));
+    }
+    impl_->ready.notify_one();
+}
+
+// ----------------------------------------------------------------------------
+// One service's lane
+// ----------------------------------------------------------------------------
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+std::uint64_t microseconds(Clock::duration duration)
+{
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+}
+
+// A lane that can never run anything would shed every query with an answer
+// that says "try again", which is a lie.
+ServiceLimits usable(const std::string& name, ServiceLimits limits)
+{
+    if (limits.maxConcurrency == 0)
+    {
+        SPDLOG_WARN("Service '{}': a concurrency limit of 0 is taken as 1", name);
+        limits.maxConcurrency = 1;
+    }
+    return limits;
+}
+
+} // namespace
+
+// Shared with every job the lane has posted, so a worker finishing a job after
+// the lane's destructor has returned still has somewhere to write its numbers.
+struct ServiceLane::State : std::enable_shared_from_this<ServiceLane::State>
+{
+    struct Waiting
+    {
+        std::function<void()> job;
+        Clock::time_point arrived;
+    };
+
+    State(std::string name, ServiceWorkerPool& pool, ServiceLimits limits) :
+        name(std::move(name)),
+        pool(pool),
+        limits(limits)
+    {
+        load.limits = limits;
+    }
+
+    const std::string name;
+    ServiceWorkerPool& pool;
+    const ServiceLimits limits;
+
+    mutable std::mutex mutex;
+    std::condition_variable idle;
+    std::deque<Waiting> queue;
+
+    // queued and inFlight are kept here as the live counts, not computed on
+    // demand, so load() is one copy under the lock.
+    ServiceLoad load;
+
+    // The caller has already counted `waiting` as in flight.
+    void start(Waiting waiting)
+    {
+        pool.post([self = shared_from_this(), waiting = std::move(waiting)]() mutable {
+            self->run(std::move(waiting));
+        });
+    }
+
+    void run(Waiting waiting)
+    {
+        const Clock::time_point started = Clock::now();
+        try
+        {
+            waiting.job();
+        }
+        catch (const std::exception& e)
+        {
+            // On zenoh's thread this would have unwound into Rust. Here it
+            // would take the worker down with it, and with it every service
+            // sharing the pool.
+            SPDLOG_ERROR("Service '{}' handler threw: {}", name, e.what());
+        }
+        catch (...)
+        {
+            SPDLOG_ERROR("Service '{}' handler threw", name);
+        }
+        // Released before the lock is taken: for a ZenohService this is the
+        // query reference, and dropping it is what finalises the query.
+        waiting.job = nullptr;
+        const Clock::time_point finished = Clock::now();
+
+        std::optional<Waiting> next;
+        {
+            const std::lock_guard<std::mutex> guard(mutex);
+            const std::uint64_t wait = microseconds(started - waiting.arrived);
+            const std::uint64_t ran = microseconds(finished - started);
+            ++load.completed;
+            load.totalWaitUs += wait;
+            load.maxWaitUs = std::max(load.maxWaitUs, wait);
+            load.totalRunUs += ran;
+            load.maxRunUs = std::max(load.maxRunUs, ran);
+
+            if (queue.empty())
+            {
+                --load.inFlight;
+            }
+            else
+            {
+                // Keeps its in-flight slot and hands it on. Posted rather than
+                // run here, so another lane's work queued on the pool in the
+                // meantime is not stuck behind this one's whole backlog.
+                next.emplace(std::move(queue.front()));
+                queue.pop_front();
+                --load.queued;
+            }
+        }
+
+        if (next)
+        {
+            start(std::move(*next));
+        }
+        else
+        {
+            idle.notify_all();
+        }
+    }
+};
+
+ServiceLane::ServiceLane(std::string name, ServiceWorkerPool& pool, ServiceLimits limits) :
+    state_(std::make_shared<State>(name, pool, usable(name, limits)))
+{
+}
+
+ServiceLane::~ServiceLane()
+{
+    std::deque<State::Waiting> dropped;
+    {
+        std::unique_lock<std::mutex> lock(state_->mutex);
+        dropped.swap(state_->queue);
+        state_->load.queued = 0;
+        state_->idle.wait(lock, [this]() { return state_->load.inFlight == 0; });
+    }
+    if (!dropped.empty())
+    {
+        SPDLOG_DEBUG("Service '{}' dropped {} queued request(s) on shutdown", state_->name,
+                     dropped.size());
+    }
+}
+
+bool ServiceLane::submit(std::function<void()> job)
+{
+    State::Waiting waiting { std::move(job), Clock::now() };
+    {
+        const std::lock_guard<std::mutex> guard(state_->mutex);
+        if (state_->load.inFlight < state_->limits.maxConcurrency)
+        {
+            ++state_->load.inFlight;
+            ++state_->load.accepted;
+        }
+        else if (state_->queue.size() < state_->limits.maxQueued)
+        {
+            state_->queue.push_back(std::move(waiting));
+            ++state_->load.queued;
+            ++state_->load.accepted;
+            state_->load.peakQueued = std::max(state_->load.peakQueued, state_->load.queued);
+            return true;
+        }
+        else
+        {
+            ++state_->load.shed;
+            return false;
+        }
+    }
+    state_->start(std::move(waiting));
+    return true;
+}
+
+ServiceLoad ServiceLane::load() const
+{
+    const std::lock_guard<std::mutex> guard(state_->mutex);
+    return state_->load;
+}
+
+} // namespace pub_sub
@@ -1,4 +1,5 @@
 #include "pub_sub/session_manager.h"
+#include "pub_sub/detail/payload_buffer.h"
 #include "spdlog/spdlog.h"
 #include <condition_variable>
 #include <cstdlib>
@@ -66,8 +67,13 @@ zenoh::Config SessionManager::buildConfig()
     // This is a threshold and not an on/off switch because the two live on one
     // session -- the dashboard subscribes to video and fetches tiles through the
     // same zenoh session, so the choice has to be made per message size.
+    //
+    // The same number decides which outgoing buffers our own publishers and
+    // services allocate from an SHM pool (detail::PayloadBuffer). Those are
+    // written into shared memory in the first place, so zenoh has nothing left
+    // to copy; this threshold now only catches payloads put from the heap.
     config.insert_json5("transport/shared_memory/transport_optimization/message_size_threshold",
-                        "262144");
+                        std::to_string(detail::kSharedMemoryMinBytes));
 
     // PUB_SUB_NO_DISCOVERY=1 keeps this session off the machine's bus.
     //
@@ -19,6 +19,10 @@
 //     field is default, so "malformed" and "a valid response full of zeros"
 //     are the same bytes unless the length is checked first.
 //
+//   * a service too busy to take the request. That has to arrive as Busy, and
+//     promptly, or a caller under load waits out its whole timeout to learn
+//     what the service knew the moment the query arrived.
+//
 // The client and the service share this process's zenoh session, which is how
 // zenoh routes a local query to a local queryable. That makes this a `net` test:
 // it opens a session.
@@ -271,6 +275,55 @@ void test_destroying_the_client_mid_flight_is_safe()
     check(outcome->status == Client::Status::Ok, "and carries the real answer");
 }
 
+void test_a_full_service_answers_busy()
+{
+    // A pooled service at its limit with nothing allowed to queue. The second
+    // request must come back Busy at once -- not NoReply after the timeout,
+    // which is what a shed query would look like if it were simply dropped.
+    pub_sub::ServiceWorkerPool pool(2);
+    Service service(
+        "test/async_client/busy",
+        [](const CanBridgeSetBitrateRequest::Reader&,
+           CanBridgeSetBitrateResponse::Builder& response) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+            response.setOk(true);
+        },
+        pool, pub_sub::ServiceLimits { 1, 0 });
+
+    Client client("test/async_client/busy", 3000);
+
+    Outcome first;
+    client.request(
+        [](CanBridgeSetBitrateRequest::Builder& request) { request.setChannel("can0"); },
+        [&first](Client::Status status, const CanBridgeSetBitrateResponse::Reader* response) {
+            first.record(status, response);
+        });
+
+    // Until the first is on the worker; the load says when.
+    for (int i = 0; i < 100 && service.load()->inFlight == 0; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    Outcome second;
+    const auto asked = std::chrono::steady_clock::now();
+    client.request(
+        [](CanBridgeSetBitrateRequest::Builder& request) { request.setChannel("can0"); },
+        [&second](Client::Status status, const CanBridgeSetBitrateResponse::Reader* response) {
+            second.record(status, response);
+        });
+
+    check(second.awaitOne(std::chrono::milliseconds(0)), "the refused request called back");
+    check(std::chrono::steady_clock::now() - asked < std::chrono::milliseconds(1500),
+          "and did so well inside the timeout");
+    check(second.status == Client::Status::Busy, "the status is Busy");
+    check(!second.sawResponsePointer, "Busy comes with a null response");
+
+    check(first.awaitOne(), "the request that was accepted is still answered");
+    check(first.status == Client::Status::Ok, "with the real answer");
+    check(service.load()->shed == 1, "the service counted one shed");
+}
+
 } // namespace
 
 int main()
@@ -289,6 +342,7 @@ int main()
     test_two_responders_deliver_one_answer();
     test_overlapping_requests_do_not_share_state();
     test_destroying_the_client_mid_flight_is_safe();
+    test_a_full_service_answers_busy();
 
     pub_sub::SessionManager::shutdown();
 
@@ -1,7 +1,11 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 //
 // ExpressionEvaluator on its own: decode a Cap'n Proto payload against a
-// schema, evaluate an expression over its fields, convert the result.
+// schema, evaluate an expression over its fields, convert the result. And
+// ExpressionEvaluatorSet, which does the same for several expressions with one
+// decode, and has to agree with the single evaluator to the last bit. And
+// ExpressionBindingList, the sets scope and the dashboard keep per key, which
+// has to stay right when zenoh runs one key's callback on two threads at once.
 //
 // This is the same behaviour test_expression_eval.cpp covers through
 // ZenohExpressionSubscriber, and that test stays exactly as it was -- it is the
@@ -17,25 +21,33 @@
 // same channel as a real reading -- so a corrupt packet drove a gauge to zero
 // and looked exactly like a genuine zero.
 
+#include "pub_sub/expression_binding_list.h"
 #include "pub_sub/expression_evaluator.h"
 #include "pub_sub/capnp_json.h"
 #include "pub_sub/schema_registry.h"
+#include "reflection/reflection.h"
 
 #include "carplay_session.capnp.h"
 #include "engine_rpm.capnp.h"
 #include "motec_pdm.capnp.h"
 #include "vehicle_speed.capnp.h"
 
+#include <capnp/dynamic.h>
 #include <capnp/message.h>
 #include <capnp/serialize.h>
 
 #include <spdlog/spdlog.h>
 
+#include <atomic>
 #include <cmath>
 #include <cstdio>
 #include <cstdint>
 #include <limits>
+#include <memory>
+#include <optional>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 namespace
@@ -648,6 +660,373 @@ void testCheckPublishedSchemaToleratesAnything()
     expect(!threw, "the schema check never throws, whatever encoding it is handed");
 }
 
+// ------------------------------------------------- several expressions, one decode
+
+// A PDM input-state message: scalars and a 23-element List(Bool) side by side,
+// which is what it takes to show a bad list spoiling only the members reading it.
+std::vector<uint8_t> pdmInputStatePayload(float battery_volts, unsigned inputs)
+{
+    capnp::MallocMessageBuilder message;
+    auto root = message.initRoot<MotecPdmInputState>();
+    root.setBatteryVolts(battery_volts);
+    auto values = root.initInputs(inputs);
+    for (unsigned i = 0; i < inputs; ++i)
+    {
+        values.set(i, i % 2 == 0);
+    }
+
+    const kj::Array<capnp::word> words = capnp::messageToFlatArray(message);
+    const kj::ArrayPtr<const kj::byte> bytes = words.asBytes();
+    return std::vector<uint8_t>(bytes.begin(), bytes.end());
+}
+
+void testASetAgreesWithItsMembersEvaluatedAlone()
+{
+    // The set is an optimisation, so the only acceptable difference from N
+    // separate evaluators is the cost.
+    const std::vector<std::string> expressions = {"rpm", "oilPressurePsi",
+                                                  "rpm / 100.0 + oilPressurePsi",
+                                                  "psi_to_bar(oilPressurePsi)"};
+    pub_sub::ExpressionEvaluatorSet set(pub_sub::schema_type_t::EngineRpm, expressions,
+                                        "test/engine/rpm");
+    expect(set.size() == expressions.size(), "every expression is a member");
+
+    const std::vector<uint8_t> payload = engineRpmPayload(3000, 12.5f);
+    std::vector<std::optional<double>> results(set.size());
+    set.evaluateToDouble(payload, results);
+
+    for (std::size_t i = 0; i < expressions.size(); ++i)
+    {
+        auto alone = evaluatorFor(expressions[i]);
+        const auto expected = alone.evaluate<double>(payload);
+        expect(set.isValid(i), "member '" + expressions[i] + "' is valid");
+        expect(results[i].has_value() && expected.has_value() &&
+                   std::abs(*results[i] - *expected) < 1e-9,
+               "member '" + expressions[i] + "' reads what it would have read alone");
+    }
+}
+
+void testASetDecodesTheUnionOfItsFieldsOnce()
+{
+    pub_sub::ExpressionEvaluatorSet set(pub_sub::schema_type_t::EngineRpm,
+                                        {"rpm", "rpm * 2", "oilPressurePsi + rpm"},
+                                        "test/engine/rpm");
+    const auto& fields = set.fieldNames();
+    expect(fields.size() == 2 && fields[0] == "oilPressurePsi" && fields[1] == "rpm",
+           "the fields a set decodes are the union of its members', sorted, once each");
+    expect(set.variableNames(1).size() == 1 && set.variableNames(1)[0] == "rpm",
+           "and each member still reports only its own");
+}
+
+void testABadMemberSpoilsNothingElse()
+{
+    // One typo in a thirty-signal panel must cost that one signal, not the
+    // other twenty-nine sharing its decode.
+    pub_sub::ExpressionEvaluatorSet set(pub_sub::schema_type_t::EngineRpm,
+                                        {"rpm", "thisFieldDoesNotExist", "rpm +* 3", ""},
+                                        "test/engine/rpm");
+    expect(set.isValid(0), "the good member is valid");
+    expect(!set.isValid(1) && !set.isValid(2) && !set.isValid(3),
+           "an unknown field, a malformed expression and an empty one are each invalid");
+
+    std::vector<std::optional<double>> results(set.size(), 99.0);
+    set.evaluateToDouble(engineRpmPayload(4000), results);
+    expect(results[0].has_value() && *results[0] == 4000.0, "the good member still evaluates");
+    expect(!results[1] && !results[2] && !results[3],
+           "and an invalid member produces no value rather than whatever was there before");
+}
+
+void testAContradictoryListSkipsOnlyItsReaders()
+{
+    pub_sub::ExpressionEvaluatorSet set(pub_sub::schema_type_t::MotecPdmInputState,
+                                        {"batteryVolts", "inputs[0]", "batteryVolts + inputs[2]"},
+                                        "test/pdm/inputs");
+    expect(set.isValid(0) && set.isValid(1) && set.isValid(2), "every member compiles");
+
+    std::vector<std::optional<double>> results(set.size());
+    set.evaluateToDouble(pdmInputStatePayload(13.5f, 23), results);
+    expect(results[0] && std::abs(*results[0] - 13.5) < 1e-6 && results[1] && *results[1] == 1.0 &&
+               results[2] && std::abs(*results[2] - 14.5) < 1e-6,
+           "a message of the declared length feeds every member");
+
+    set.evaluateToDouble(pdmInputStatePayload(12.0f, 5), results);
+    expect(results[0] && std::abs(*results[0] - 12.0) < 1e-6,
+           "a short list does not cost a member that never reads it");
+    expect(!results[1] && !results[2], "but every member reading it is skipped");
+}
+
+void testAnUndecodablePayloadLeavesEveryMemberEmpty()
+{
+    pub_sub::ExpressionEvaluatorSet set(pub_sub::schema_type_t::EngineRpm,
+                                        {"rpm", "oilPressurePsi"}, "test/engine/rpm");
+
+    std::vector<uint8_t> payload = engineRpmPayload(4000);
+    payload.pop_back();
+
+    std::vector<std::optional<double>> results(set.size(), 1.0);
+    set.evaluateToDouble(payload, results);
+    expect(!results[0] && !results[1], "a payload that is not whole words feeds no member");
+
+    set.evaluateToDouble({}, results);
+    expect(!results[0] && !results[1], "and neither does an empty one");
+}
+
+// ------------------------------------------------------- the binding list
+
+// What scope and the dashboard bind: the list asks nothing more of it.
+struct TestBinding
+{
+    pub_sub::schema_type_t schema_type{};
+    std::string expression;
+};
+
+using TestBindingList = pub_sub::ExpressionBindingList<TestBinding>;
+
+std::shared_ptr<TestBinding> testBinding(pub_sub::schema_type_t schema_type,
+                                         const std::string& expression)
+{
+    return std::make_shared<TestBinding>(TestBinding{schema_type, expression});
+}
+
+void testABindingListGroupsBySchema()
+{
+    const std::vector<std::shared_ptr<TestBinding>> bindings = {
+        testBinding(pub_sub::schema_type_t::EngineRpm, "rpm"),
+        testBinding(pub_sub::schema_type_t::VehicleSpeed, "speedMps"),
+        testBinding(pub_sub::schema_type_t::EngineRpm, "oilPressurePsi"),
+    };
+    const auto list = TestBindingList::build(bindings, "test/engine/rpm");
+    expect(list && list->groups().size() == 2, "one group per schema among the bindings");
+    expect(list && list->all().size() == 3, "and every binding in one of them");
+
+    // Evaluated as one key carrying EngineRpm: the VehicleSpeed group decodes
+    // the same bytes too, so only the EngineRpm bindings are looked at.
+    std::vector<std::pair<std::string, double>> delivered;
+    if (list)
+    {
+        list->evaluate(engineRpmPayload(3000, 12.5f), "EngineRpm",
+                       [&](const TestBinding& binding, double value)
+                       {
+                           if (binding.schema_type == pub_sub::schema_type_t::EngineRpm)
+                           {
+                               delivered.emplace_back(binding.expression, value);
+                           }
+                       });
+    }
+    expect(delivered.size() == 2 && delivered[0].first == "rpm" &&
+               delivered[0].second == 3000.0 && delivered[1].first == "oilPressurePsi" &&
+               std::abs(delivered[1].second - 12.5) < 1e-6,
+           "each value goes to the binding whose expression produced it, in member order");
+}
+
+void testABindingListWithABadExpressionIsNotBuilt()
+{
+    const auto list = TestBindingList::build(
+        {testBinding(pub_sub::schema_type_t::EngineRpm, "rpm"),
+         testBinding(pub_sub::schema_type_t::EngineRpm, "thisFieldDoesNotExist")},
+        "test/engine/rpm");
+    expect(!list, "a binding that does not compile refuses the whole list, so bind() can say so");
+}
+
+void testABindingListEvaluatesFromSeveralThreadsAtOnce()
+{
+    // zenoh may run one key's callback on more than one RX thread. Each sample
+    // must come back with the values IT decoded, not a neighbour's: without the
+    // group's lock, one thread's decode lands in the slots between another's
+    // decode and its read.
+    const auto list = TestBindingList::build(
+        {testBinding(pub_sub::schema_type_t::EngineRpm, "rpm"),
+         testBinding(pub_sub::schema_type_t::EngineRpm, "oilPressurePsi * 1000.0")},
+        "test/engine/rpm");
+    expect(static_cast<bool>(list), "the list builds");
+    if (!list)
+    {
+        return;
+    }
+
+    constexpr int kThreads = 4;
+    constexpr int kSamples = 20000;
+    std::atomic<int> wrong{0};
+    std::atomic<int> delivered{0};
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < kThreads; ++thread)
+    {
+        threads.emplace_back(
+            [&, thread]
+            {
+                // Both fields say which thread the sample came from.
+                const uint32_t rpm = 1000u * static_cast<uint32_t>(thread + 1);
+                const std::vector<uint8_t> payload =
+                    engineRpmPayload(rpm, static_cast<float>(thread + 1));
+                for (int i = 0; i < kSamples; ++i)
+                {
+                    list->evaluate(payload, "EngineRpm",
+                                   [&](const TestBinding&, double value)
+                                   {
+                                       delivered.fetch_add(1, std::memory_order_relaxed);
+                                       if (value != static_cast<double>(rpm))
+                                       {
+                                           wrong.fetch_add(1, std::memory_order_relaxed);
+                                       }
+                                   });
+                }
+            });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    expect(delivered.load() == 2 * kThreads * kSamples, "every sample delivers both values");
+    expect(wrong.load() == 0, "and every value is the one its own sample carried");
+}
+
+// ------------------------------------------------ direct and dynamic agree
+
+// Something other than the default for one element or field of `type`, or a
+// VOID value for a type nothing here sets.
+capnp::DynamicValue::Reader sampleValue(capnp::Type type, unsigned seed)
+{
+    if (type.isBool())
+    {
+        return seed % 2 == 1;
+    }
+    if (type.isInt8() || type.isInt16() || type.isInt32() || type.isInt64())
+    {
+        return -static_cast<int64_t>(seed % 100) - 1;
+    }
+    if (type.isUInt8() || type.isUInt16() || type.isUInt32() || type.isUInt64())
+    {
+        return static_cast<uint64_t>(seed % 200) + 1;
+    }
+    if (type.isFloat32() || type.isFloat64())
+    {
+        return 0.25 * seed + 0.5;
+    }
+    if (type.isEnum())
+    {
+        const auto enumerants = type.asEnum().getEnumerants();
+        return capnp::DynamicEnum(enumerants[seed % enumerants.size()]);
+    }
+    return capnp::VOID;
+}
+
+// A message of `schema` with every plain numeric field and every declared-length
+// list set from `seed` -- or, for seed 0, nothing set, so everything reads as
+// its default.
+std::vector<uint8_t> payloadFor(capnp::StructSchema schema, unsigned seed)
+{
+    capnp::MallocMessageBuilder message;
+    auto root = message.initRoot<capnp::DynamicStruct>(schema);
+    for (auto field : schema.getNonUnionFields())
+    {
+        if (seed == 0)
+        {
+            break;
+        }
+        const auto type = field.getType();
+        if (type.isList())
+        {
+            const auto length = pub_sub::fixedListLength(field);
+            const auto element = type.asList().getElementType();
+            if (!length || sampleValue(element, 1).getType() == capnp::DynamicValue::VOID)
+            {
+                continue;
+            }
+            auto list = root.init(field, *length).as<capnp::DynamicList>();
+            for (unsigned i = 0; i < *length; ++i)
+            {
+                list.set(i, sampleValue(element, seed + i));
+            }
+        }
+        else if (sampleValue(type, seed).getType() != capnp::DynamicValue::VOID)
+        {
+            root.set(field, sampleValue(type, seed + field.getIndex()));
+        }
+    }
+
+    const kj::Array<capnp::word> words = capnp::messageToFlatArray(message);
+    const kj::ArrayPtr<const kj::byte> bytes = words.asBytes();
+    return std::vector<uint8_t>(bytes.begin(), bytes.end());
+}
+
+void testDirectAccessAgreesWithTheDynamicApiOnEverySchema()
+{
+    // Reading fields straight from the data section is only an optimisation if
+    // it reads the SAME values as capnp's own dynamic API, for every field of
+    // every schema on the bus -- including the ones nobody has plotted yet. So
+    // this binds every numeric field of every registered schema both ways and
+    // compares, on filled messages and on an empty one, which is where a
+    // forgotten default or a wrong offset would read as something else.
+    int schemas_compared = 0;
+    for (const pub_sub::schema_type_t type :
+         reflection::enum_traits<pub_sub::schema_type_t>::values())
+    {
+        const auto schema = pub_sub::get_schema(type);
+        if (!schema || !schema->getProto().isStruct())
+        {
+            continue;
+        }
+
+        std::vector<std::string> expressions;
+        for (auto field : schema->asStruct().getNonUnionFields())
+        {
+            const std::string name = field.getProto().getName().cStr();
+            const auto field_type = field.getType();
+            if (field_type.isList())
+            {
+                const auto length = pub_sub::fixedListLength(field);
+                if (length && *length > 0 &&
+                    sampleValue(field_type.asList().getElementType(), 1).getType() !=
+                        capnp::DynamicValue::VOID)
+                {
+                    expressions.push_back(name + "[" + std::to_string(*length - 1) + "]");
+                    expressions.push_back("sum(" + name + ")");
+                }
+            }
+            else if (sampleValue(field_type, 1).getType() != capnp::DynamicValue::VOID)
+            {
+                expressions.push_back(name);
+            }
+        }
+        if (expressions.empty())
+        {
+            continue;
+        }
+
+        const std::string label(reflection::enum_to_string(type));
+        pub_sub::ExpressionEvaluatorSet direct(type, expressions, label,
+                                               pub_sub::FieldAccess::Direct);
+        pub_sub::ExpressionEvaluatorSet dynamic(type, expressions, label,
+                                                pub_sub::FieldAccess::Dynamic);
+
+        bool agreed = true;
+        for (const unsigned seed : {0u, 1u, 7u, 130u})
+        {
+            const std::vector<uint8_t> payload = payloadFor(schema->asStruct(), seed);
+            std::vector<std::optional<double>> a(direct.size());
+            std::vector<std::optional<double>> b(dynamic.size());
+            direct.evaluateToDouble(payload, a);
+            dynamic.evaluateToDouble(payload, b);
+            for (std::size_t i = 0; i < expressions.size(); ++i)
+            {
+                // A field named like an exprtk function or keyword does not
+                // compile either way, which is a different problem.
+                if (!direct.isValid(i))
+                {
+                    agreed = agreed && !dynamic.isValid(i);
+                    continue;
+                }
+                agreed = agreed && a[i].has_value() && a[i] == b[i];
+            }
+        }
+        expect(agreed, label + ": every field reads the same directly as through the dynamic API");
+        ++schemas_compared;
+    }
+
+    expect(schemas_compared > 20, "the comparison covered the registry, not a corner of it");
+}
+
 }  // namespace
 
 int main()
@@ -693,6 +1072,18 @@ int main()
     testSchemaAndExpressionAreReportedBack();
     testCheckPublishedSchemaToleratesAnything();
 
+    testASetAgreesWithItsMembersEvaluatedAlone();
+    testASetDecodesTheUnionOfItsFieldsOnce();
+    testABadMemberSpoilsNothingElse();
+    testAContradictoryListSkipsOnlyItsReaders();
+    testAnUndecodablePayloadLeavesEveryMemberEmpty();
+
+    testABindingListGroupsBySchema();
+    testABindingListWithABadExpressionIsNotBuilt();
+    testABindingListEvaluatesFromSeveralThreadsAtOnce();
+
+    testDirectAccessAgreesWithTheDynamicApiOnEverySchema();
+
     std::fprintf(stderr, "%d checks, %d failures\n", checks, failures);
     return failures == 0 ? 0 : 1;
 }
@@ -133,7 +133,7 @@ std::vector<Captured> publishAndCollect(int count)
     {
         pub_sub::RawSubscriber subscriber(
             "**", pub_sub::RawSubscriber::InfoHandler(
-                      [&collector](const std::vector<std::uint8_t>&,
+                      [&collector](std::span<const std::uint8_t>,
                                    const pub_sub::RawSubscriber::SampleInfo& info)
                       { collector.add(info); }));
 
@@ -0,0 +1,232 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//
+// The worker pool and per-service lanes behind ZenohService's pooled mode.
+//
+// The claims worth pinning are the limits, because getting one wrong looks like
+// a working server until it is loaded: a lane that lets one more handler run
+// than it says starves the service sharing the pool, a queue that takes one
+// more than it says turns a prompt "busy" into a caller's timeout, and a lane
+// destroyed with a handler still running is a use after free in whatever the
+// handler captured.
+//
+// No zenoh: the lane runs std::function, so `unit`.
+
+#include "pub_sub/service_workers.h"
+
+#include <spdlog/spdlog.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace
+{
+
+int failures = 0;
+int checks = 0;
+
+void expect(bool condition, const std::string& what)
+{
+    ++checks;
+    if (!condition)
+    {
+        ++failures;
+        std::fprintf(stderr, "FAIL: %s\n", what.c_str());
+    }
+}
+
+bool waitFor(const std::function<bool()>& predicate,
+             std::chrono::milliseconds timeout = std::chrono::milliseconds(5000))
+{
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+        if (predicate())
+        {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return predicate();
+}
+
+// Holds every job submitted to it until released, so a test can fill a lane
+// and look at it while nothing moves.
+struct Gate
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool open { false };
+
+    std::atomic<int> running { 0 };
+    std::atomic<int> peak { 0 };
+    std::atomic<int> finished { 0 };
+
+    std::function<void()> job()
+    {
+        return [this]() {
+            const int now = running.fetch_add(1) + 1;
+            int seen = peak.load();
+            while (now > seen && !peak.compare_exchange_weak(seen, now))
+            {
+            }
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [this]() { return open; });
+            }
+            running.fetch_sub(1);
+            finished.fetch_add(1);
+        };
+    }
+
+    void release()
+    {
+        {
+            const std::lock_guard<std::mutex> guard(mutex);
+            open = true;
+        }
+        cv.notify_all();
+    }
+};
+
+void testTheLimitsAreExact()
+{
+    pub_sub::ServiceWorkerPool pool(8);
+    Gate gate;
+    pub_sub::ServiceLane lane("test/limits", pool, pub_sub::ServiceLimits { 2, 3 });
+
+    int accepted = 0;
+    for (int i = 0; i < 8; ++i)
+    {
+        accepted += lane.submit(gate.job()) ? 1 : 0;
+    }
+    expect(accepted == 5, "two running and three queued are accepted, and no more");
+    expect(waitFor([&] { return gate.running.load() == 2; }),
+           "both concurrency slots are taken");
+
+    // Long enough for a third handler to start if the lane were going to let it.
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    auto load = lane.load();
+    expect(load.inFlight == 2 && load.queued == 3, "the lane reports two running, three queued");
+    expect(load.shed == 3, "the three refused are counted as shed");
+    expect(load.peakQueued == 3, "the queue's peak is recorded");
+    expect(gate.running.load() == 2, "eight idle workers still run only two of this service");
+
+    gate.release();
+    expect(waitFor([&] { return gate.finished.load() == 5; }), "every accepted job runs");
+    expect(gate.peak.load() == 2, "never more than the limit at once, queue drained or not");
+    expect(waitFor([&] { return lane.load().completed == 5; }), "every job is counted complete");
+
+    load = lane.load();
+    expect(load.inFlight == 0 && load.queued == 0, "an idle lane reports nothing outstanding");
+    expect(load.accepted == 5, "accepted counts what was run, not what was asked");
+    expect(load.maxWaitUs >= load.meanWaitUs() && load.maxRunUs >= load.meanRunUs(),
+           "the maxima bound the means");
+    expect(load.maxRunUs > 0, "time held at the gate is measured as run time");
+}
+
+void testAZeroQueueRunsNowOrRefuses()
+{
+    pub_sub::ServiceWorkerPool pool(2);
+    Gate gate;
+    pub_sub::ServiceLane lane("test/no_queue", pool, pub_sub::ServiceLimits { 1, 0 });
+
+    expect(lane.submit(gate.job()), "the first is run");
+    expect(!lane.submit(gate.job()), "the second is refused rather than queued");
+    gate.release();
+    expect(waitFor([&] { return lane.load().inFlight == 0; }), "the lane goes idle");
+    expect(lane.submit([] {}), "and takes work again once it has");
+}
+
+void testOneLaneCannotStarveAnother()
+{
+    // The case the limits exist for: routes stuck behind a slow graph must not
+    // take the workers the tiles need.
+    pub_sub::ServiceWorkerPool pool(3);
+    Gate routes;
+    pub_sub::ServiceLane slow("test/route", pool, pub_sub::ServiceLimits { 2, 8 });
+    pub_sub::ServiceLane fast("test/tile", pool, pub_sub::ServiceLimits { 2, 8 });
+
+    for (int i = 0; i < 6; ++i)
+    {
+        slow.submit(routes.job());
+    }
+    expect(waitFor([&] { return routes.running.load() == 2; }), "the slow lane fills its limit");
+
+    std::atomic<int> tiles { 0 };
+    for (int i = 0; i < 4; ++i)
+    {
+        fast.submit([&tiles] { tiles.fetch_add(1); });
+    }
+    expect(waitFor([&] { return tiles.load() == 4; }),
+           "the other lane still gets a worker while the slow one is stuck");
+
+    routes.release();
+    expect(waitFor([&] { return routes.finished.load() == 6; }), "the slow lane then drains");
+}
+
+void testDestroyingALaneWaitsForWhatIsRunning()
+{
+    pub_sub::ServiceWorkerPool pool(2);
+    auto alive = std::make_shared<std::atomic<bool>>(true);
+    std::atomic<bool> finishedAfter { false };
+    std::atomic<int> queuedRan { 0 };
+    std::atomic<bool> started { false };
+
+    {
+        pub_sub::ServiceLane lane("test/teardown", pool, pub_sub::ServiceLimits { 1, 4 });
+        lane.submit([&] {
+            started.store(true);
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            finishedAfter.store(alive->load());
+        });
+        for (int i = 0; i < 3; ++i)
+        {
+            lane.submit([&queuedRan] { queuedRan.fetch_add(1); });
+        }
+        waitFor([&] { return started.load(); });
+        // ~ServiceLane here: must wait out the 100 ms job, and drop the rest.
+    }
+    alive->store(false);
+
+    expect(finishedAfter.load(), "the running handler finished before the lane was gone");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    expect(queuedRan.load() == 0, "what was still queued is dropped, not run after the fact");
+}
+
+void testAThrowingHandlerDoesNotTakeThePoolDown()
+{
+    pub_sub::ServiceWorkerPool pool(1);
+    pub_sub::ServiceLane lane("test/throws", pool, pub_sub::ServiceLimits { 1, 4 });
+
+    std::atomic<bool> after { false };
+    lane.submit([] { throw std::runtime_error("handler failure"); });
+    lane.submit([&after] { after.store(true); });
+
+    expect(waitFor([&] { return after.load(); }), "the next job runs on the same worker");
+    expect(waitFor([&] { return lane.load().completed == 2; }),
+           "a job that threw still counts as complete and frees its slot");
+}
+
+}  // namespace
+
+int main()
+{
+    spdlog::set_level(spdlog::level::off);
+
+    testTheLimitsAreExact();
+    testAZeroQueueRunsNowOrRefuses();
+    testOneLaneCannotStarveAnother();
+    testDestroyingALaneWaitsForWhatIsRunning();
+    testAThrowingHandlerDoesNotTakeThePoolDown();
+
+    std::fprintf(stderr, "%d checks, %d failures\n", checks, failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -5,9 +5,9 @@
 #include <spdlog/spdlog.h>
 
 #include <atomic>
+#include <span>
 #include <string>
 #include <utility>
-#include <vector>
 
 namespace pub_sub
 {
@@ -30,7 +30,7 @@ struct ZenohExpressionSubscriber::Impl
     // would close it at the cost of a lock on every sample forever, to serialise
     // against a write that happens once. `handler` is written before the release
     // store and only read after the acquire load, and never reassigned.
-    std::function<void(const std::vector<std::uint8_t>&)> handler;
+    std::function<void(std::span<const std::uint8_t>)> handler;
     std::atomic<bool> handler_ready{false};
 
     bool subscription_valid = false;
@@ -64,7 +64,7 @@ ZenohExpressionSubscriber::ZenohExpressionSubscriber(schema_type_t schema_type,
     Impl* const impl = impl_.get();
     impl_->subscriber = std::make_unique<detail::ByteSubscriber>(
         zenoh_key,
-        [impl](const std::vector<std::uint8_t>& payload, const detail::SampleMeta& meta) {
+        [impl](std::span<const std::uint8_t> payload, const detail::SampleMeta& meta) {
             if (!impl->handler_ready.load(std::memory_order_acquire))
             {
                 return;
@@ -98,7 +98,7 @@ const std::string& ZenohExpressionSubscriber::getExpression() const
 }
 
 void ZenohExpressionSubscriber::setRawCallback(
-    std::function<void(const std::vector<std::uint8_t>&)> handler)
+    std::function<void(std::span<const std::uint8_t>)> handler)
 {
     impl_->handler = std::move(handler);
     // Release: everything written to `handler` above is visible to any zenoh
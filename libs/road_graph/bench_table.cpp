@@ -0,0 +1,189 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//
+// What a travel-time table costs on a real graph, as one table and as pairs.
+//
+// NOT a test -- it asserts nothing and always exits 0. road_graph_test_contraction
+// is what shows every cell of a table is its pair's route; this shows what
+// answering them together buys. Each row is a square table over the same number
+// of sources and destinations, drawn at random (with a fixed seed, so two runs
+// ask the same questions) from the graph's junctions, answered once by
+// findTableVia() and once as findRouteVia() for every pair.
+//
+//   road_graph_bench_table --graph socal.graph
+//   road_graph_bench_table --graph socal.graph --sizes 1,10,100,250 --pairs-up-to 2500
+//
+// The overlay is read from beside the graph, as map_server finds it.
+//
+// What each column means:
+//
+//   size      sources, and as many destinations
+//   table ms  findTableVia() for the whole table
+//   pairs ms  findRouteVia() per pair, or "-" past --pairs-up-to cells
+//   speedup   pairs over table
+//   us/cell   the table's time per cell
+//   settled   nodes the table settled per point: flat as the table grows is
+//             the (N + M) searches; the pairs settle that much per PAIR
+//   buckets   bucket entries per destination, which is the table's memory:
+//             a few hundred bytes each, and flat as the table grows
+//   differ    cells whose duration or reachability the two disagree on, which
+//             should be zero -- a non-zero here is a bug, not a benchmark
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "road_graph/graph.h"
+#include "road_graph/overlay.h"
+
+namespace
+{
+
+std::string argumentAfter(int argc, char** argv, const std::string& flag,
+                          const std::string& fallback)
+{
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (flag == argv[i])
+        {
+            return argv[i + 1];
+        }
+    }
+    return fallback;
+}
+
+// "1,10,100" -> {1, 10, 100}. Empty or unparseable means 1, 10, 50 and 100.
+std::vector<std::size_t> sizes(const std::string& list)
+{
+    std::vector<std::size_t> out;
+    std::size_t at = 0;
+    while (at < list.size())
+    {
+        const std::size_t comma = std::min(list.find(',', at), list.size());
+        const long value = std::strtol(list.substr(at, comma - at).c_str(), nullptr, 10);
+        if (value > 0)
+        {
+            out.push_back(static_cast<std::size_t>(value));
+        }
+        at = comma + 1;
+    }
+    if (out.empty())
+    {
+        out = { 1, 10, 50, 100 };
+    }
+    return out;
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    spdlog::set_pattern("%v");
+
+    const std::string graphPath = argumentAfter(argc, argv, "--graph", "");
+    if (graphPath.empty())
+    {
+        SPDLOG_ERROR("usage: road_graph_bench_table --graph <file> [--sizes 1,10,50,100] "
+                     "[--pairs-up-to 2500]");
+        return 0;
+    }
+    const std::string pairsText = argumentAfter(argc, argv, "--pairs-up-to", "2500");
+    const auto pairsUpTo = static_cast<std::size_t>(std::strtoul(pairsText.c_str(), nullptr, 10));
+
+    auto graph = road_graph::Graph::open(graphPath);
+    if (!graph)
+    {
+        SPDLOG_ERROR("cannot open {}: {}", graphPath, road_graph::to_string(graph.error()));
+        return 0;
+    }
+    auto overlay = road_graph::Overlay::open(graphPath + ".overlay", *graph);
+    if (!overlay)
+    {
+        SPDLOG_ERROR("cannot open {}.overlay: {}", graphPath,
+                     road_graph::to_string(overlay.error()));
+        return 0;
+    }
+
+    // Junctions something can leave from. A node with no outgoing edge is a
+    // row of unreachable cells, which costs nothing and measures nothing.
+    std::vector<road_graph::NodeIndex> usable;
+    for (road_graph::NodeIndex node = 0; node < graph->nodes().size(); ++node)
+    {
+        if (!graph->edgesFrom(node).empty())
+        {
+            usable.push_back(node);
+        }
+    }
+    if (usable.empty())
+    {
+        SPDLOG_ERROR("{}: no node has an outgoing edge", graphPath);
+        return 0;
+    }
+
+    SPDLOG_INFO("{}: {} nodes, {} edges, {} shortcuts", graphPath, graph->nodes().size(),
+                graph->edges().size(), overlay->header().shortcutCount);
+    SPDLOG_INFO("{:>6} {:>10} {:>10} {:>8} {:>8} {:>8} {:>8} {:>7}", "size", "table ms",
+                "pairs ms", "speedup", "us/cell", "settled", "buckets", "differ");
+
+    std::mt19937 random(260813);
+    for (const std::size_t size : sizes(argumentAfter(argc, argv, "--sizes", "")))
+    {
+        std::uniform_int_distribution<std::size_t> pick(0, usable.size() - 1);
+        std::vector<road_graph::NodeIndex> sources(size);
+        std::vector<road_graph::NodeIndex> destinations(size);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            sources[i] = usable[pick(random)];
+            destinations[i] = usable[pick(random)];
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        const road_graph::Table table =
+            road_graph::findTableVia(*graph, *overlay, sources, destinations);
+        const double tableMs = millisecondsSince(start);
+        const std::size_t cells = size * size;
+
+        std::string pairsColumn = "-";
+        std::string speedupColumn = "-";
+        std::size_t differ = 0;
+        if (cells <= pairsUpTo)
+        {
+            const auto pairsStart = std::chrono::steady_clock::now();
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                for (std::size_t j = 0; j < size; ++j)
+                {
+                    const auto route =
+                        road_graph::findRouteVia(*graph, *overlay, sources[i], destinations[j]);
+                    const road_graph::TableCell& cell = table.at(i, j);
+                    if (cell.reachable != route.has_value() ||
+                        (route && std::abs(cell.durationS - route->durationS) > 0.05))
+                    {
+                        ++differ;
+                    }
+                }
+            }
+            const double pairsMs = millisecondsSince(pairsStart);
+            pairsColumn = fmt::format("{:.1f}", pairsMs);
+            speedupColumn = fmt::format("{:.1f}x", pairsMs / tableMs);
+        }
+
+        SPDLOG_INFO("{:>6} {:>10.1f} {:>10} {:>8} {:>8.1f} {:>8} {:>8} {:>7}", size, tableMs,
+                    pairsColumn, speedupColumn, tableMs * 1e3 / double(cells),
+                    table.settled / (2 * size), table.buckets / size,
+                    cells <= pairsUpTo ? std::to_string(differ) : "-");
+    }
+    return 0;
+}
@@ -16,6 +16,7 @@
 #ifndef ROAD_GRAPH_CONTRACTION_H
 #define ROAD_GRAPH_CONTRACTION_H
 
+#include <cstddef>
 #include <cstdint>
 #include <filesystem>
 
@@ -60,6 +61,12 @@ struct ContractionOptions
 
     // Progress line every N contracted nodes. Zero is silent.
     std::uint64_t progressEvery { 250'000 };
+
+    // One contracts a node at a time from a single queue. More contract in
+    // parallel rounds on that many threads, zero being one per core; the
+    // overlay is then the same file at any count above one, but not the
+    // queue's file -- the routes agree, the shortcuts do not.
+    std::size_t threads { 1 };
 };
 
 struct ContractionStats
@@ -70,6 +77,10 @@ struct ContractionStats
     std::uint64_t originalArcs { 0 };
     std::uint64_t shortcuts { 0 };
     std::uint64_t witnessSearches { 0 };
+    // Independent sets contracted, and the threads that contracted them. No
+    // rounds and one thread is the queue.
+    std::uint64_t rounds { 0 };
+    std::size_t threads { 0 };
     double buildSeconds { 0.0 };
     std::uint64_t bytes { 0 };
 };
@@ -13,13 +13,18 @@
 // exists to keep that promise honest: it routes the same pairs both ways and
 // requires the COSTS to match, because a hierarchy that is subtly wrong returns
 // a plausible route quickly rather than failing.
+//
+// The same two upward searches also answer a whole TABLE at once -- see
+// findTableVia() below.
 #ifndef ROAD_GRAPH_OVERLAY_H
 #define ROAD_GRAPH_OVERLAY_H
 
+#include <cstddef>
 #include <cstdint>
 #include <filesystem>
 #include <optional>
 #include <span>
+#include <vector>
 
 #include "road_graph/error.h"
 #include "road_graph/graph.h"
@@ -29,6 +34,8 @@
 namespace road_graph
 {
 
+struct Table;
+
 class Overlay
 {
   public:
@@ -54,7 +61,13 @@ class Overlay
 
     Result<void> bind(const Graph& graph);
 
+    // The cheapest arc from expanded node `u` to `v`, in whichever of the two
+    // search graphs holds it, or null. What unpacking a hop starts from.
+    const OverlayArc* arcBetween(std::uint32_t u, std::uint32_t v) const;
+
     friend std::optional<Route> findRouteVia(const Graph&, const Overlay&, NodeIndex, NodeIndex);
+    friend Table findTableVia(const Graph&, const Overlay&, std::span<const NodeIndex>,
+                              std::span<const NodeIndex>);
 
     void* mMapping { nullptr };
     std::size_t mSize { 0 };
@@ -73,6 +86,62 @@ class Overlay
 std::optional<Route> findRouteVia(const Graph& graph, const Overlay& overlay, NodeIndex from,
                                   NodeIndex to);
 
+// One pair of a table: what the Route findRouteVia() returns between the same
+// two nodes would report, without the route.
+struct TableCell
+{
+    bool reachable { false };
+    double durationS { 0.0 };
+    double distanceM { 0.0 };
+};
+
+// Every source against every destination, row-major.
+struct Table
+{
+    std::size_t sources { 0 };
+    std::size_t destinations { 0 };
+    std::vector<TableCell> cells;
+
+    // Expanded nodes settled over every search. A measure of the work, which
+    // grows with sources + destinations rather than with their product.
+    std::uint64_t settled { 0 };
+
+    // Bucket entries the destinations' searches left, which is what the table
+    // holds while the sources' searches run. Grows with destinations alone.
+    std::uint64_t buckets { 0 };
+
+    const TableCell& at(std::size_t source, std::size_t destination) const
+    {
+        return cells[source * destinations + destination];
+    }
+};
+
+// Travel time and distance from each of `sources` to each of `destinations`,
+// in one upward search per POINT rather than one bidirectional search per PAIR.
+//
+// The backward half of findRouteVia() does not depend on where the route
+// starts, so each destination's is run once and everything it settles is left
+// in a bucket at the node: "destination j is this far from here". A forward
+// search from each source then climbs as it always does, and at every node it
+// settles reads that node's bucket -- each entry is a path to that destination
+// over that node, and the cheapest over all nodes is the shortest path, for the
+// same reason the meeting point of the two-sided query is.
+//
+// Upward searches are small, except in the core: its nodes share one rank, so
+// a search that enters it settles all of it. The destinations' searches
+// therefore stop at the core, bucketing each core node they reach without
+// expanding it, and it is the sources' searches that cross it. Each of those
+// stops once the cheapest node it has left costs as much as the worst cell of
+// its row, since no meeting past that node can improve any cell. A row with an
+// unreachable destination never gets that bound and crosses all of the core.
+// A pair with no path comes back unreachable, and a node paired with itself
+// costs nothing, as findRouteVia() says.
+//
+// Each cell's cost is EXACTLY the pair's findRouteVia() duration. Its distance
+// is that of a shortest path, which is that route's unless two paths tie.
+Table findTableVia(const Graph& graph, const Overlay& overlay, std::span<const NodeIndex> sources,
+                   std::span<const NodeIndex> destinations);
+
 } // namespace road_graph
 
 #endif // ROAD_GRAPH_OVERLAY_H
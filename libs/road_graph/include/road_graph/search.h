@@ -5,9 +5,9 @@
 // Two things live here, and they are different sizes:
 //
 //   boundedDistance() -- how far apart two junctions are, giving up past a
-//   limit. Used by the matcher's transition probability, dozens of times per
-//   GNSS fix, so it must stay small and must NOT expand the whole map when the
-//   answer is "not close".
+//   limit. Used by the matcher's transition probability, one search per beam
+//   candidate per GNSS fix, so it must stay small and must NOT expand the
+//   whole map when the answer is "not close".
 //
 //   findRoute() -- bidirectional A* between two points. Fine to a few hundred
 //   kilometres; a continental query needs the preprocessing overlay that stage
@@ -17,10 +17,9 @@
 
 #include <cstdint>
 #include <optional>
-#include <unordered_map>
+#include <span>
 #include <utility>
 #include <vector>
-#include <vector>
 
 #include "road_graph/graph.h"
 
@@ -35,10 +34,17 @@ namespace road_graph
 // that two roads do not connect.
 // A REUSABLE working set for boundedDistance.
 //
-// The matcher makes up to beamWidth^2 bounded searches per fix, at fix rate.
-// Each one used to build a fresh unordered_map and priority_queue and throw
-// them away; keeping one context means the hash table's buckets and the heap's
-// storage survive between calls.
+// The matcher asks about every (previous candidate, current candidate) pair at
+// fix rate, and the pairs from one previous candidate all start at the same
+// node -- so distances() answers them from ONE search, where asking one pair at
+// a time re-expanded the same few hundred metres once per target.
+//
+// The visited set is a FLAT ARRAY, one slot per junction, stamped with a
+// generation number. Starting a search is bumping the number, not clearing
+// anything, and a lookup is an index rather than a hash. It costs twelve bytes
+// per junction, allocated on the first search and kept -- which was the
+// objection to an array when each call built its own, and is not one for an
+// object that lives as long as the matcher.
 //
 // Not thread safe, deliberately: it is per-caller state. Two threads matching
 // at once hold one each.
@@ -49,11 +55,28 @@ class BoundedSearch
     std::optional<double> distance(const Graph& graph, NodeIndex from, NodeIndex to,
                                    double limitM);
 
+    // ONE search from `from`, settling every node of `targets` it can reach
+    // inside `limitM`. out[i] is what distance(graph, from, targets[i], limitM)
+    // returns; a target may appear more than once. The search stops as soon as
+    // every target is settled or the frontier is past the limit.
+    void distances(const Graph& graph, NodeIndex from, std::span<const NodeIndex> targets,
+                   double limitM, std::vector<std::optional<double>>& out);
+
   private:
-    std::unordered_map<NodeIndex, double> mBest;
+    // A new generation, with the arrays grown to `graph` on first use.
+    void begin(const Graph& graph);
+
+    bool visited(NodeIndex node) const { return mStamp[node] == mGeneration; }
+
+    std::vector<double> mBest;
+    std::vector<std::uint32_t> mStamp;
+    std::uint32_t mGeneration { 0 };
     // A heap kept by hand rather than a priority_queue, which cannot be
     // cleared without discarding its buffer.
     std::vector<std::pair<double, NodeIndex>> mQueue;
+    // Indices into `targets` not yet settled.
+    std::vector<std::size_t> mPending;
+    std::vector<std::optional<double>> mOne;
 };
 
 // One-off form: allocates a context, uses it once, drops it. For callers that
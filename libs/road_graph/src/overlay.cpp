@@ -306,6 +306,26 @@ std::span<const std::uint32_t> Overlay::incomingEdges(NodeIndex node) const
     return mIncomingEdges.subspan(begin, end - begin);
 }
 
+const OverlayArc* Overlay::arcBetween(std::uint32_t u, std::uint32_t v) const
+{
+    const OverlayArc* found = nullptr;
+    for (std::uint32_t i = mUpOffsets[u]; i < mUpOffsets[u + 1]; ++i)
+    {
+        if (mUpArcs[i].target == v && (found == nullptr || mUpArcs[i].costDs < found->costDs))
+        {
+            found = &mUpArcs[i];
+        }
+    }
+    for (std::uint32_t i = mDownOffsets[v]; i < mDownOffsets[v + 1]; ++i)
+    {
+        if (mDownArcs[i].target == u && (found == nullptr || mDownArcs[i].costDs < found->costDs))
+        {
+            found = &mDownArcs[i];
+        }
+    }
+    return found;
+}
+
 std::optional<Route> findRouteVia(const Graph& graph, const Overlay& overlay, NodeIndex from,
                                   NodeIndex to)
 {
@@ -398,29 +418,7 @@ std::optional<Route> findRouteVia(const Graph& graph, const Overlay& overlay, No
     // the node each stands for.
     const auto unpack = [&](std::uint32_t u, std::uint32_t v, auto&& self,
                             std::vector<std::uint32_t>& out) -> void {
-        // Find the arc, in whichever of the two graphs holds it.
-        const OverlayArc* found = nullptr;
-        const std::uint32_t upBegin = overlay.mUpOffsets[u];
-        const std::uint32_t upEnd = overlay.mUpOffsets[u + 1];
-        for (std::uint32_t i = upBegin; i < upEnd; ++i)
-        {
-            if (overlay.mUpArcs[i].target == v &&
-                (found == nullptr || overlay.mUpArcs[i].costDs < found->costDs))
-            {
-                found = &overlay.mUpArcs[i];
-            }
-        }
-        const std::uint32_t downBegin = overlay.mDownOffsets[v];
-        const std::uint32_t downEnd = overlay.mDownOffsets[v + 1];
-        for (std::uint32_t i = downBegin; i < downEnd; ++i)
-        {
-            if (overlay.mDownArcs[i].target == u &&
-                (found == nullptr || overlay.mDownArcs[i].costDs < found->costDs))
-            {
-                found = &overlay.mDownArcs[i];
-            }
-        }
-
+        const OverlayArc* found = overlay.arcBetween(u, v);
         if (found == nullptr || found->middle == kNoMiddle)
         {
             out.push_back(v);
@@ -508,4 +506,254 @@ std::optional<Route> findRouteVia(const Graph& graph, const Overlay& overlay, No
     return route;
 }
 
+Table findTableVia(const Graph& graph, const Overlay& overlay, std::span<const NodeIndex> sources,
+                   std::span<const NodeIndex> destinations)
+{
+    Table table;
+    table.sources = sources.size();
+    table.destinations = destinations.size();
+    table.cells.resize(sources.size() * destinations.size());
+
+    const auto edges = graph.edges();
+    const auto segments = graph.segments();
+
+    // How far a hop runs on the ground, in centimetres: every road the arc
+    // from `u` to `v` unpacks into, counting `v` and not `u` -- the same rule
+    // as its cost. Memoised, because the hops near the top of the hierarchy
+    // are the long shortcuts and every search in the table climbs through
+    // them.
+    std::unordered_map<std::uint64_t, std::uint64_t> hopLengths;
+    const auto hopLength = [&](std::uint32_t u, std::uint32_t v, auto&& self) -> std::uint64_t {
+        const std::uint64_t key = (std::uint64_t { u } << 32) | v;
+        if (auto known = hopLengths.find(key); known != hopLengths.end())
+        {
+            return known->second;
+        }
+        const OverlayArc* arc = overlay.arcBetween(u, v);
+        const std::uint64_t length = arc == nullptr || arc->middle == kNoMiddle
+                                         ? segments[edges[v].segment].lengthCm
+                                         : self(u, arc->middle, self) + self(arc->middle, v, self);
+        hopLengths.emplace(key, length);
+        return length;
+    };
+
+    // One upward search, every node it settles handed to `settle` with its cost
+    // and length. The length is found at settling rather than carried through
+    // every relaxation, so only the few hundred settled nodes pay for a hop's
+    // unpacking; the parent is settled first, which is what makes its length
+    // final by then.
+    //
+    // The search ends when the queue does, or when its cheapest node costs
+    // `bound()` or more. A node of the core is settled and not expanded when
+    // `expandCore` is false.
+    struct Label
+    {
+        std::uint64_t cost;
+        std::uint64_t lengthCm;
+        std::uint32_t parent;
+        bool settled;
+    };
+    std::unordered_map<std::uint32_t, Label> labels;
+    std::priority_queue<Frontier, std::vector<Frontier>, std::greater<Frontier>> queue;
+
+    // Every uncontracted node carries the one rank above all contracted ones.
+    const auto inCore = [&](std::uint32_t node) {
+        return overlay.mRanks[node] == overlay.mRanks.size();
+    };
+
+    const auto climb = [&](bool goingUp, bool expandCore, const auto& bound, const auto& settle) {
+        const auto arcs = goingUp ? overlay.mUpArcs : overlay.mDownArcs;
+        const auto offsets = goingUp ? overlay.mUpOffsets : overlay.mDownOffsets;
+
+        while (!queue.empty())
+        {
+            const Frontier current = queue.top();
+            if (current.cost >= bound())
+            {
+                break;
+            }
+            queue.pop();
+            Label& label = labels.at(current.node);
+            if (label.settled || current.cost > label.cost)
+            {
+                continue;
+            }
+            label.settled = true;
+            ++table.settled;
+
+            // Seeds are their own parents and arrive with their length set.
+            if (label.parent != current.node)
+            {
+                const Label& parent = labels.at(label.parent);
+                // Forward, the hop is travelled parent -> node; backward the
+                // search runs against the traffic and it is node -> parent.
+                label.lengthCm = parent.lengthCm +
+                                 (goingUp ? hopLength(label.parent, current.node, hopLength)
+                                          : hopLength(current.node, label.parent, hopLength));
+            }
+            settle(current.node, label.cost, label.lengthCm);
+            if (!expandCore && inCore(current.node))
+            {
+                continue;
+            }
+
+            for (std::uint32_t i = offsets[current.node]; i < offsets[current.node + 1]; ++i)
+            {
+                const OverlayArc& arc = arcs[i];
+                const std::uint64_t candidate = current.cost + arc.costDs;
+                auto [entry, inserted] =
+                    labels.try_emplace(arc.target, Label { candidate, 0, current.node, false });
+                if (!inserted)
+                {
+                    if (entry->second.settled || candidate >= entry->second.cost)
+                    {
+                        continue;
+                    }
+                    entry->second.cost = candidate;
+                    entry->second.parent = current.node;
+                }
+                queue.push({ candidate, arc.target });
+            }
+        }
+        queue = {};
+        labels.clear();
+    };
+
+    const auto seed = [&](std::uint32_t node, std::uint64_t cost, std::uint64_t lengthCm) {
+        auto [entry, inserted] = labels.try_emplace(node, Label { cost, lengthCm, node, false });
+        if (!inserted)
+        {
+            if (cost >= entry->second.cost)
+            {
+                return;
+            }
+            entry->second = Label { cost, lengthCm, node, false };
+        }
+        queue.push({ cost, node });
+    };
+
+    // ---- backward: fill the buckets ----------------------------------------
+    //
+    // Flat and sorted by node rather than a bucket list per node: the table
+    // touches a few hundred nodes per destination out of millions, so an array
+    // indexed by node would be almost entirely empty, and one sort puts each
+    // node's entries side by side for the forward searches to find.
+    struct BucketEntry
+    {
+        std::uint32_t node;
+        std::uint32_t destination;
+        std::uint64_t cost;
+        std::uint64_t lengthCm;
+    };
+    std::vector<BucketEntry> buckets;
+
+    for (std::size_t j = 0; j < destinations.size(); ++j)
+    {
+        // Seeded as findRouteVia's backward search is: every edge arriving at
+        // the destination, at zero.
+        for (const std::uint32_t index : overlay.incomingEdges(destinations[j]))
+        {
+            seed(index, 0, 0);
+        }
+
+        // Stopped at the core. All of the core shares one rank, so its arcs
+        // go up both ways and a search that entered it would settle the whole
+        // of it: every destination's bucket would hold every core node, which
+        // on a country is the table's memory gone. Each core node reached is
+        // bucketed and not expanded; the forward search, which stores nothing,
+        // crosses the core instead.
+        climb(
+            false, false, [] { return kInfinity; },
+            [&](std::uint32_t node, std::uint64_t cost, std::uint64_t lengthCm) {
+                buckets.push_back({ node, static_cast<std::uint32_t>(j), cost, lengthCm });
+            });
+    }
+    table.buckets = buckets.size();
+
+    // Stable, so entries at one node stay in destination order and a tie
+    // between two meetings is broken the same way on every run.
+    std::stable_sort(buckets.begin(), buckets.end(),
+                     [](const BucketEntry& lhs, const BucketEntry& rhs) {
+                         return lhs.node < rhs.node;
+                     });
+
+    // ---- forward: scan them ------------------------------------------------
+    std::vector<std::uint64_t> best(destinations.size());
+    std::vector<std::uint64_t> bestLength(destinations.size());
+
+    // No meeting past a node can cost less than the node does, so once the
+    // cheapest node left costs as much as the worst cell of the row, the row is
+    // final. Until every destination has been met the bound is infinite and
+    // the search runs on through the core looking for it -- which for a
+    // destination that cannot be reached is all of the core, but in a search
+    // that keeps nothing afterwards. Found again only when a cell has improved.
+    std::uint64_t worst = 0;
+    bool improved = true;
+    const auto worstOfRow = [&] {
+        if (improved)
+        {
+            worst = best.empty() ? 0 : *std::max_element(best.begin(), best.end());
+            improved = false;
+        }
+        return worst;
+    };
+
+    for (std::size_t i = 0; i < sources.size(); ++i)
+    {
+        std::fill(best.begin(), best.end(), kInfinity);
+        for (std::size_t j = 0; j < destinations.size(); ++j)
+        {
+            // Already there, and nothing to search for.
+            if (sources[i] == destinations[j])
+            {
+                best[j] = 0;
+            }
+        }
+        improved = true;
+
+        // Seeded as findRouteVia's forward search is: every edge leaving the
+        // source, at that edge's own cost -- and its own length.
+        for (const EdgeRecord& edge : graph.edgesFrom(sources[i]))
+        {
+            const auto index = static_cast<std::uint32_t>(&edge - edges.data());
+            seed(index, edge.costDs, segments[edge.segment].lengthCm);
+        }
+        climb(true, true, worstOfRow,
+              [&](std::uint32_t node, std::uint64_t cost, std::uint64_t lengthCm) {
+                  auto at = std::lower_bound(buckets.begin(), buckets.end(), node,
+                                             [](const BucketEntry& entry, std::uint32_t wanted) {
+                                                 return entry.node < wanted;
+                                             });
+                  for (; at != buckets.end() && at->node == node; ++at)
+                  {
+                      const std::uint64_t total = cost + at->cost;
+                      if (total < best[at->destination])
+                      {
+                          best[at->destination] = total;
+                          bestLength[at->destination] = lengthCm + at->lengthCm;
+                          improved = true;
+                      }
+                  }
+              });
+
+        for (std::size_t j = 0; j < destinations.size(); ++j)
+        {
+            TableCell& cell = table.cells[i * destinations.size() + j];
+            if (sources[i] == destinations[j])
+            {
+                // findRouteVia's empty route: already there.
+                cell.reachable = true;
+            }
+            else if (best[j] != kInfinity)
+            {
+                cell.reachable = true;
+                cell.durationS = static_cast<double>(best[j]) / 10.0;
+                cell.distanceM = static_cast<double>(bestLength[j]) / 100.0;
+            }
+        }
+    }
+
+    return table;
+}
+
 } // namespace road_graph
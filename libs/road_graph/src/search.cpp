@@ -37,41 +37,82 @@ std::optional<double> boundedDistance(const Graph& graph, NodeIndex from, NodeIn
 std::optional<double> BoundedSearch::distance(const Graph& graph, NodeIndex from, NodeIndex to,
                                               double limitM)
 {
-    if (from == to)
+    distances(graph, from, std::span<const NodeIndex>(&to, 1), limitM, mOne);
+    return mOne.front();
+}
+
+void BoundedSearch::begin(const Graph& graph)
+{
+    if (mStamp.size() != graph.nodes().size())
     {
-        return 0.0;
+        mBest.assign(graph.nodes().size(), 0.0);
+        mStamp.assign(graph.nodes().size(), 0);
+        mGeneration = 0;
     }
-    if (from >= graph.nodes().size() || to >= graph.nodes().size())
+
+    // Stamp zero is "never visited", so a wrapped counter clears the stamps
+    // once every four billion searches rather than letting an old one match.
+    if (++mGeneration == 0)
     {
-        return std::nullopt;
+        std::fill(mStamp.begin(), mStamp.end(), 0);
+        mGeneration = 1;
     }
+    mQueue.clear();
+    mPending.clear();
+}
 
-    // Straight-line distance is a floor on the driving distance, so a pair that
-    // is already past the limit as the crow flies cannot possibly be under it
-    // by road. Checking that first is what makes this cheap in the common case
-    // of two candidates that are nowhere near each other.
-    const NodeRecord& a = graph.nodes()[from];
-    const NodeRecord& b = graph.nodes()[to];
-    if (distanceM(a.lat, a.lon, b.lat, b.lon) > limitM)
+void BoundedSearch::distances(const Graph& graph, NodeIndex from,
+                              std::span<const NodeIndex> targets, double limitM,
+                              std::vector<std::optional<double>>& out)
+{
+    out.assign(targets.size(), std::nullopt);
+    for (std::size_t i = 0; i < targets.size(); ++i)
     {
-        return std::nullopt;
+        if (targets[i] == from)
+        {
+            out[i] = 0.0;
+        }
     }
+    if (from >= graph.nodes().size())
+    {
+        return;
+    }
+    begin(graph);
 
-    // A plain Dijkstra with a hash map rather than a full distance array: the
-    // search is bounded to a few hundred metres, so it settles tens of nodes
-    // out of millions, and allocating an array per call would dwarf the search.
-    //
-    // CLEARED, not reconstructed. clear() on an unordered_map keeps its bucket
-    // array and on a vector keeps its buffer, which is the whole point of this
-    // object outliving the call.
-    mBest.clear();
-    mQueue.clear();
+    // Straight-line distance is a floor on the driving distance, so a target
+    // that is already past the limit as the crow flies cannot possibly be under
+    // it by road. Checking that first is what makes this cheap in the common
+    // case of candidates that are nowhere near each other -- if none is left,
+    // there is no search at all.
+    const NodeRecord& a = graph.nodes()[from];
+    for (std::size_t i = 0; i < targets.size(); ++i)
+    {
+        if (targets[i] == from || targets[i] >= graph.nodes().size())
+        {
+            continue;
+        }
+        const NodeRecord& b = graph.nodes()[targets[i]];
+        if (distanceM(a.lat, a.lon, b.lat, b.lon) <= limitM)
+        {
+            mPending.push_back(i);
+        }
+    }
+    if (mPending.empty())
+    {
+        return;
+    }
 
+    // A plain Dijkstra. The search is bounded to a few hundred metres, so it
+    // settles tens of nodes out of millions; the stamps are what let it touch
+    // only those.
     const auto greater = [](const std::pair<double, NodeIndex>& lhs,
-                            const std::pair<double, NodeIndex>& rhs) { return lhs.first > rhs.first; };
+                            const std::pair<double, NodeIndex>& rhs) {
+        return lhs.first > rhs.first;
+    };
 
     mQueue.emplace_back(0.0, from);
-    mBest.emplace(from, 0.0);
+    mBest[from] = 0.0;
+    mStamp[from] = mGeneration;
 
     while (!mQueue.empty())
     {
@@ -79,23 +120,38 @@ std::optional<double> BoundedSearch::distance(const Graph& graph, NodeIndex from
         const std::pair<double, NodeIndex> current = mQueue.back();
         mQueue.pop_back();
 
-        if (current.second == to)
-        {
-            return current.first;
-        }
         if (current.first > limitM)
         {
             // Every remaining frontier node is at least this far, so nothing
             // under the limit is left to find.
-            return std::nullopt;
+            return;
         }
-
-        const auto found = mBest.find(current.second);
-        if (found != mBest.end() && current.first > found->second)
+        if (current.first > mBest[current.second])
         {
             continue;
         }
 
+        // Settled. The first time a node leaves the heap its cost is final, so
+        // any target it is gets its answer now, and the search ends with the
+        // last of them rather than at the limit.
+        for (std::size_t p = 0; p < mPending.size();)
+        {
+            if (targets[mPending[p]] == current.second)
+            {
+                out[mPending[p]] = current.first;
+                mPending[p] = mPending.back();
+                mPending.pop_back();
+            }
+            else
+            {
+                ++p;
+            }
+        }
+        if (mPending.empty())
+        {
+            return;
+        }
+
         for (const EdgeRecord& edge : graph.edgesFrom(current.second))
         {
             const double next = current.first + lengthM(graph, edge);
@@ -103,17 +159,15 @@ std::optional<double> BoundedSearch::distance(const Graph& graph, NodeIndex from
             {
                 continue;
             }
-            auto [entry, inserted] = mBest.try_emplace(edge.target, next);
-            if (inserted || next < entry->second)
+            if (!visited(edge.target) || next < mBest[edge.target])
             {
-                entry->second = next;
+                mStamp[edge.target] = mGeneration;
+                mBest[edge.target] = next;
                 mQueue.emplace_back(next, edge.target);
                 std::push_heap(mQueue.begin(), mQueue.end(), greater);
             }
         }
     }
-
-    return std::nullopt;
 }
 
 std::optional<Route> findRoute(const Graph& graph, NodeIndex from, NodeIndex to,
@@ -32,6 +32,8 @@
 
 #include <cstdio>
 #include <filesystem>
+#include <fstream>
+#include <iterator>
 #include <optional>
 #include <string>
 #include <vector>
@@ -195,7 +197,7 @@ std::optional<Built> buildGrid(const std::string& tag, bool withRestriction)
 }
 
 void test_the_hierarchy_agrees_with_the_router(const std::string& tag, bool withRestriction,
-                                              double stopAtFraction)
+                                              double stopAtFraction, std::size_t threads = 1)
 {
     auto built = buildGrid(tag, withRestriction);
     if (!built)
@@ -214,6 +216,7 @@ void test_the_hierarchy_agrees_with_the_router(const std::string& tag, bool with
     road_graph::ContractionOptions options;
     options.stopAtFraction = stopAtFraction;
     options.progressEvery = 0;
+    options.threads = threads;
     auto stats = road_graph::buildOverlay(*graph, built->overlayPath, options);
     check(stats.has_value(), tag + ": the overlay builds");
     if (!stats)
@@ -299,6 +302,111 @@ void test_the_hierarchy_agrees_with_the_router(const std::string& tag, bool with
     std::filesystem::remove(built->overlayPath);
 }
 
+// The table is the same searches regrouped, so it is held to the same standard
+// as the hierarchy itself: every cell against the route the two-sided query
+// finds for that pair. A bucket read at the wrong end, or a forward search that
+// stopped once it had met something, comes back plausible and slightly long.
+void test_a_table_agrees_with_every_pair(const std::string& tag, bool withRestriction,
+                                         double stopAtFraction)
+{
+    auto built = buildGrid(tag, withRestriction);
+    if (!built)
+    {
+        check(false, tag + ": graph builds");
+        return;
+    }
+    auto graph = road_graph::Graph::open(built->graphPath);
+    if (!graph)
+    {
+        check(false, tag + ": graph opens");
+        return;
+    }
+
+    road_graph::ContractionOptions options;
+    options.stopAtFraction = stopAtFraction;
+    options.progressEvery = 0;
+    auto stats = road_graph::buildOverlay(*graph, built->overlayPath, options);
+    auto overlay = road_graph::Overlay::open(built->overlayPath, *graph);
+    check(stats.has_value() && overlay.has_value(), tag + ": the overlay builds and opens");
+    if (!overlay)
+    {
+        return;
+    }
+
+    // Every node as a source, and every node -- in another order, with one
+    // repeated -- as a destination, so a table that quietly assumed the two
+    // lists were the same, or distinct, would show it.
+    std::vector<road_graph::NodeIndex> sources;
+    for (road_graph::NodeIndex node = 0; node < graph->nodes().size(); ++node)
+    {
+        sources.push_back(node);
+    }
+    std::vector<road_graph::NodeIndex> destinations(sources.rbegin(), sources.rend());
+    destinations.push_back(sources[sources.size() / 2]);
+
+    const road_graph::Table table =
+        road_graph::findTableVia(*graph, *overlay, sources, destinations);
+    check(table.sources == sources.size() && table.destinations == destinations.size() &&
+              table.cells.size() == sources.size() * destinations.size(),
+          tag + ": the table is sources by destinations");
+
+    std::size_t reachable = 0;
+    std::size_t disagreements = 0;
+    for (std::size_t i = 0; i < sources.size(); ++i)
+    {
+        for (std::size_t j = 0; j < destinations.size(); ++j)
+        {
+            const road_graph::TableCell& cell = table.at(i, j);
+            const auto route =
+                road_graph::findRouteVia(*graph, *overlay, sources[i], destinations[j]);
+
+            // The duration exactly, and the distance to a metre: a grid is
+            // full of equal-cost paths, and two of them can differ by the
+            // centimetre the builder's geometry rounded to. Which one is a
+            // route's is a tie-break, not a fact about the road.
+            const bool agrees =
+                cell.reachable == route.has_value() &&
+                (!route || (std::abs(cell.durationS - route->durationS) <= 0.05 &&
+                            std::abs(cell.distanceM - route->distanceM) <= 1.0));
+            reachable += cell.reachable ? 1 : 0;
+            if (!agrees)
+            {
+                ++disagreements;
+                if (disagreements <= 3)
+                {
+                    SPDLOG_ERROR("{}: {} -> {}: table {} {:.1f}s {:.2f}m, route {} {:.1f}s {:.2f}m",
+                                 tag, sources[i], destinations[j], cell.reachable,
+                                 cell.durationS, cell.distanceM, route.has_value(),
+                                 route ? route->durationS : 0.0, route ? route->distanceM : 0.0);
+                }
+            }
+        }
+    }
+
+    check(reachable > table.cells.size() / 2, tag + ": most of the table is reachable");
+
+    // With nothing contracted every node is core, and a destination's search
+    // must stop where it starts: its seeds are all it may bucket. One that
+    // crossed the core would bucket all of it, for every destination.
+    if (stopAtFraction == 0.0)
+    {
+        std::size_t seeds = 0;
+        for (const road_graph::NodeIndex destination : destinations)
+        {
+            seeds += overlay->incomingEdges(destination).size();
+        }
+        check(table.buckets == seeds, tag + ": the destinations' searches stop at the core (" +
+                                          std::to_string(table.buckets) + " bucketed, " +
+                                          std::to_string(seeds) + " seeds)");
+    }
+    check(disagreements == 0, tag + ": every cell is the pair's own duration and distance (" +
+                                  std::to_string(disagreements) + " of " +
+                                  std::to_string(table.cells.size()) + " differ)");
+
+    std::filesystem::remove(built->graphPath);
+    std::filesystem::remove(built->overlayPath);
+}
+
 void test_an_overlay_from_another_graph_is_refused()
 {
     // The failure this prevents is silent and total. Every shortcut in an
@@ -341,6 +449,55 @@ void test_an_overlay_from_another_graph_is_refused()
     std::filesystem::remove(second->overlayPath);
 }
 
+// Above one thread contraction runs in rounds, and the hierarchy must not be
+// able to tell how many threads ran them. Not the same COSTS -- the comparison
+// above already demands those, of the queue and the rounds alike -- but the
+// same FILE: a build that changes with the machine it ran on cannot be compared
+// against itself after a change. One thread is the queue, which is a different
+// file and must say so.
+void test_the_overlay_does_not_depend_on_the_thread_count()
+{
+    auto built = buildGrid("ch_threads", true);
+    if (!built)
+    {
+        check(false, "the graph builds");
+        return;
+    }
+    auto graph = road_graph::Graph::open(built->graphPath);
+    if (!graph)
+    {
+        check(false, "the graph opens");
+        return;
+    }
+
+    const auto bytesAt = [&](std::size_t threads) {
+        road_graph::ContractionOptions options;
+        options.progressEvery = 0;
+        options.stopAtFraction = 1.0;
+        options.threads = threads;
+        auto stats = road_graph::buildOverlay(*graph, built->overlayPath, options);
+        check(stats.has_value() && stats->threads == threads,
+              "the overlay builds on " + std::to_string(threads) + " threads");
+        check(stats.has_value() && (stats->rounds == 0) == (threads == 1),
+              threads == 1 ? "one thread contracts from the queue"
+                           : "and " + std::to_string(threads) + " contract in rounds");
+
+        std::ifstream in(built->overlayPath, std::ios::binary);
+        return std::vector<char>((std::istreambuf_iterator<char>(in)),
+                                 std::istreambuf_iterator<char>());
+    };
+
+    check(!bytesAt(1).empty(), "the queue's overlay is written");
+
+    const std::vector<char> two = bytesAt(2);
+    check(!two.empty(), "an overlay from two threads is written");
+    check(bytesAt(3) == two, "and three threads write the same file");
+    check(bytesAt(8) == two, "and so do eight");
+
+    std::filesystem::remove(built->graphPath);
+    std::filesystem::remove(built->overlayPath);
+}
+
 } // namespace
 
 int main()
@@ -357,6 +514,18 @@ int main()
     // if the core is searchable at all, it is searchable at this size.
     test_the_hierarchy_agrees_with_the_router("half left in the core", false, 0.5);
     test_the_hierarchy_agrees_with_the_router("nothing contracted at all", false, 0.0);
+
+    // The same comparisons contracted in rounds: the witness searches of the
+    // larger rounds split across threads, and every round's shortcuts, which go
+    // to the chains of four owners at once.
+    test_the_hierarchy_agrees_with_the_router("fully contracted, 4 threads", false, 1.0, 4);
+    test_the_hierarchy_agrees_with_the_router("with a banned turn, 4 threads", true, 1.0, 4);
+    test_the_hierarchy_agrees_with_the_router("half left in the core, 4 threads", false, 0.5, 4);
+    test_the_overlay_does_not_depend_on_the_thread_count();
+    test_a_table_agrees_with_every_pair("table, fully contracted", false, 1.0);
+    test_a_table_agrees_with_every_pair("table, with a banned turn", true, 1.0);
+    test_a_table_agrees_with_every_pair("table, half left in the core", false, 0.5);
+    test_a_table_agrees_with_every_pair("table, nothing contracted at all", false, 0.0);
     test_an_overlay_from_another_graph_is_refused();
 
     if (failures != 0)
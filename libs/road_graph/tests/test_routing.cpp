@@ -567,7 +567,7 @@ void test_a_graph_with_no_speeds_at_all_is_still_searchable()
 
 void test_a_reused_search_gives_the_same_answers_as_fresh_ones()
 {
-    // BoundedSearch keeps its hash table and heap between calls. The whole
+    // BoundedSearch keeps its visited array and heap between calls. The whole
     // risk of that is state leaking from one query into the next, which would
     // show up as a distance that is right the first time and wrong after.
     const auto path = scratch("rg_reused_search.graph");
@@ -626,6 +626,64 @@ void test_a_reused_search_gives_the_same_answers_as_fresh_ones()
     std::filesystem::remove(path);
 }
 
+void test_one_search_answers_every_target_as_pairs_would()
+{
+    // The matcher's form: one search from each previous candidate, settling
+    // every current one. It must give exactly what one search per pair gave --
+    // including "nothing" for a target past the limit, on an island, or out of
+    // range -- or the transition scores move and the matcher picks other roads.
+    const auto path = scratch("rg_one_to_many.graph");
+
+    road_graph::Builder builder;
+    builder.add(link(1, nodeId(0, 0), nodeId(1, 0), 0, 0, 1, 0, "A"));
+    builder.add(link(2, nodeId(1, 0), nodeId(2, 0), 1, 0, 2, 0, "B"));
+    builder.add(link(3, nodeId(2, 0), nodeId(2, 1), 2, 0, 2, 1, "C"));
+    builder.add(link(4, nodeId(1, 0), nodeId(1, 1), 1, 0, 1, 1, "D"));
+    builder.add(link(5, nodeId(5, 5), nodeId(6, 5), 5, 5, 6, 5, "Island"));
+    check(builder.write(path, 0).has_value(), "the graph writes");
+
+    auto graph = road_graph::Graph::open(path);
+    if (!graph)
+    {
+        check(false, "graph opens");
+        return;
+    }
+
+    const road_graph::NodeIndex a = findNode(*graph, 0, 0);
+    const std::vector<road_graph::NodeIndex> targets {
+        findNode(*graph, 2, 1), findNode(*graph, 1, 0), a,
+        findNode(*graph, 5, 5), findNode(*graph, 1, 1), findNode(*graph, 2, 1),
+        static_cast<road_graph::NodeIndex>(graph->nodes().size() + 7),
+    };
+
+    road_graph::BoundedSearch search;
+    std::vector<std::optional<double>> many;
+    // A generous limit, then one that cuts through the middle of the targets: a
+    // grid step is about a hundred metres, so 150 reaches (1,0) and no further.
+    for (const double limit : { 10000.0, 150.0 })
+    {
+        search.distances(*graph, a, targets, limit, many);
+        check(many.size() == targets.size(), "one answer per target");
+
+        bool agree = many.size() == targets.size();
+        for (std::size_t i = 0; agree && i < targets.size(); ++i)
+        {
+            const auto pair = road_graph::boundedDistance(*graph, a, targets[i], limit);
+            agree = pair.has_value() == many[i].has_value() &&
+                    (!pair || std::abs(*pair - *many[i]) < 1e-9);
+        }
+        check(agree, "and each is what its own search found, limit " +
+                         std::to_string(static_cast<int>(limit)));
+    }
+
+    check(many[1].has_value() && !many[4].has_value(), "the tight limit keeps the near target");
+    check(many[2].has_value() && *many[2] == 0.0, "the start reaches itself at zero cost");
+    check(!many[3].has_value(), "the island is out of reach");
+    check(!many[6].has_value(), "and a node that does not exist is nothing, not a crash");
+
+    std::filesystem::remove(path);
+}
+
 } // namespace
 
 int main()
@@ -642,6 +700,7 @@ int main()
     test_no_route_between_disconnected_pieces();
     test_bounded_distance_gives_up_rather_than_expanding();
     test_a_reused_search_gives_the_same_answers_as_fresh_ones();
+    test_one_search_answers_every_target_as_pairs_would();
     test_a_graph_with_no_restrictions_allows_everything();
     test_the_fastest_speed_is_in_the_header();
     test_an_old_graph_without_the_field_still_resolves_a_speed();
@@ -1,8 +1,11 @@
 #include "bag_tool/verbs.h"
 
 #include "bag/queue.h"
+#include "bag/ring_queue.h"
 #include "bag/writer.h"
 
+#include "can_topic/frame_codec.h"
+
 #include "cli/interrupt.h"
 #include "cli/output.h"
 
@@ -13,6 +16,7 @@
 #include <nlohmann/json.hpp>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <string>
@@ -63,12 +67,21 @@ void addRecordOptions(cxxopts::Options& options)
             cxxopts::value<int>()->default_value("0"))
         ("chunk-size", "Uncompressed bytes buffered before a chunk is flushed.",
             cxxopts::value<std::uint64_t>()->default_value("4194304"))
+        ("compression-threads", "Compress chunks on this many threads, off the writer "
+            "thread. 0 compresses inline.",
+            cxxopts::value<std::uint64_t>()->default_value("0"))
         ("max-size", "Roll to a new part past this many bytes. 0 disables.",
             cxxopts::value<std::uint64_t>()->default_value("2147483648"))
         ("max-duration", "Roll to a new part past this many seconds. 0 disables.",
             cxxopts::value<double>()->default_value("0"))
         ("queue-depth", "Messages buffered between the bus and the writer thread.",
             cxxopts::value<std::uint64_t>()->default_value("8192"))
+        ("lock-free-queue", "Buffer through the lock-free ring rather than the locked queue. "
+            "Same bound and drop rule; for many busy RX threads.",
+            cxxopts::value<bool>()->default_value("false")->implicit_value("true"))
+        ("unbatch-can", "Record each frame of a CanFrameBatch as its own CanFrame message, "
+            "for tools that read only the per-frame shape.",
+            cxxopts::value<bool>()->default_value("false")->implicit_value("true"))
         ("d,duration", "Stop after this many seconds. 0 means until Ctrl-C.",
             cxxopts::value<double>()->default_value("0"))
         ("quiet", "Do not print the progress line.",
@@ -101,6 +114,8 @@ int runRecord(cli::Context& context)
     writer_options.chunk_bytes = context.uintOr("chunk-size", 4ull * 1024 * 1024);
     writer_options.max_part_bytes = context.uintOr("max-size", 2ull * 1024 * 1024 * 1024);
     writer_options.max_part_seconds = context.doubleOr("max-duration", 0.0);
+    writer_options.compression_threads =
+        static_cast<unsigned>(std::min<std::uint64_t>(context.uintOr("compression-threads", 0), 64));
     writer_options.recorder = "redline bag";
 
     if (writer_options.compression != "none" && writer_options.compression != "lz4" &&
@@ -126,7 +141,54 @@ int runRecord(cli::Context& context)
     // nothing" and "was not running" look identical once the bus is gone.
     pub_sub::TopicDirectory directory;
 
-    bag::MessageQueue queue(context.uintOr("queue-depth", 8192));
+    // Exactly one of these. The locked queue stays the default: it is the one
+    // with the longer record, and below a handful of busy RX threads it is not
+    // the bottleneck. The ring is for when it is -- see ring_queue.h.
+    const std::size_t queue_depth = context.uintOr("queue-depth", 8192);
+    std::unique_ptr<bag::MessageQueue> locked_queue;
+    std::unique_ptr<bag::RingQueue> ring_queue;
+    if (context.flag("lock-free-queue"))
+    {
+        ring_queue = std::make_unique<bag::RingQueue>(queue_depth);
+    }
+    else
+    {
+        locked_queue = std::make_unique<bag::MessageQueue>(queue_depth);
+    }
+
+    // Views in, so the ring path copies nothing but the payload. The locked
+    // path builds its QueuedMessage here, as the callbacks used to.
+    const auto enqueue = [&](std::string_view key, std::string_view schema,
+                             std::string_view origin_zid, std::span<const std::uint8_t> payload,
+                             std::uint64_t log_time_ns,
+                             std::optional<std::uint64_t> publish_time_ns)
+    {
+        if (ring_queue)
+        {
+            ring_queue->push(key, schema, origin_zid, payload, log_time_ns, publish_time_ns);
+            return;
+        }
+        bag::QueuedMessage message;
+        message.log_time_ns = log_time_ns;
+        message.key = std::string(key);
+        message.schema = std::string(schema);
+        message.origin_zid = std::string(origin_zid);
+        message.publish_time_ns = publish_time_ns;
+        message.payload.assign(payload.begin(), payload.end());
+        locked_queue->push(std::move(message));
+    };
+    const auto stopQueue = [&]
+    {
+        ring_queue ? ring_queue->stop() : locked_queue->stop();
+    };
+    const auto queueDepth = [&]
+    {
+        return ring_queue ? ring_queue->depth() : locked_queue->depth();
+    };
+    const auto queueDropped = [&]() -> std::uint64_t
+    {
+        return ring_queue ? ring_queue->dropped() : locked_queue->dropped();
+    };
 
     // The writer runs on its own thread. The zenoh callbacks below must not
     // block -- they run on zenoh RX threads, and stalling one stalls the session
@@ -136,7 +198,30 @@ int runRecord(cli::Context& context)
     std::thread writer_thread(
         [&]
         {
-            while (const auto message = queue.pop())
+            if (ring_queue)
+            {
+                // The payload view is good only inside the callback; write()
+                // is done with it by the time it returns.
+                while (ring_queue->pop(
+                    [&](const bag::RingMessage& message)
+                    {
+                        if (!writer.write(message.key, message.schema, message.payload,
+                                          message.log_time_ns, message.publish_time_ns,
+                                          message.origin_zid))
+                        {
+                            writer_failed = true;
+                        }
+                    }))
+                {
+                    if (writer_failed)
+                    {
+                        break;
+                    }
+                }
+                return;
+            }
+
+            while (const auto message = locked_queue->pop())
             {
                 if (!writer.write(message->key, message->schema, message->payload,
                                   message->log_time_ns, message->publish_time_ns,
@@ -151,35 +236,63 @@ int runRecord(cli::Context& context)
     std::atomic<std::uint64_t> received{0};
     std::atomic<std::uint64_t> bytes{0};
 
+    // Off by default, because a batch is already a perfectly good thing to
+    // record -- one message where there would have been dozens, which is the
+    // recorder's cost as much as the bridge's. This is for a recording that
+    // has to be read by something that only understands CanFrame.
+    const bool unbatch_can = context.flag("unbatch-can");
+
     std::vector<std::unique_ptr<pub_sub::RawSubscriber>> subscribers;
     for (const std::string& key : keys)
     {
         auto subscriber = std::make_unique<pub_sub::RawSubscriber>(
             key, pub_sub::RawSubscriber::InfoHandler(
-                     [&](const std::vector<std::uint8_t>& payload,
+                     [&](std::span<const std::uint8_t> payload,
                          const pub_sub::RawSubscriber::SampleInfo& info)
                      {
                          // Arrival time, taken here rather than on the writer
                          // thread: a queue that is backing up would otherwise
                          // fold its own latency into every log_time, and the
                          // recording's timing would slew under load.
-                         bag::QueuedMessage message;
-                         message.log_time_ns = wallClockNanos();
-                         message.key = std::string(info.keyexpr);
-                         message.schema = std::string(info.schema_name);
-                         message.origin_zid = std::string(info.origin_zid);
-                         message.publish_time_ns = info.publish_time_nanos;
-                         message.payload = payload;
+                         const std::uint64_t log_time_ns = wallClockNanos();
 
                          bytes += payload.size();
+
+                         if (unbatch_can && info.schema_name == can_topic::kBatchSchema)
+                         {
+                             // Every frame gets the batch's times: the per-frame
+                             // hardware timestamp is inside the payload, where
+                             // it always was.
+                             std::size_t unbatched = 0;
+                             const auto visited = can_topic::forEachFrame(
+                                 payload, info.schema_name,
+                                 [&](const helpers::CanFrame& frame, std::string_view channel)
+                                 {
+                                     ++unbatched;
+                                     ++received;
+                                     enqueue(info.keyexpr, can_topic::kFrameSchema,
+                                             info.origin_zid,
+                                             can_topic::encodeFrame(frame, channel),
+                                             log_time_ns, info.publish_time_nanos);
+                                 });
+                             if (visited.has_value() || unbatched != 0)
+                             {
+                                 return;
+                             }
+                             // Unreadable from the start: fall through and
+                             // record the bytes as they arrived, which is what a
+                             // recorder is for.
+                         }
+
                          ++received;
-                         queue.push(std::move(message));
+                         enqueue(info.keyexpr, info.schema_name, info.origin_zid, payload,
+                                 log_time_ns, info.publish_time_nanos);
                      }));
 
         if (!subscriber->isValid())
         {
             SPDLOG_ERROR("Could not subscribe to '{}'.", key);
-            queue.stop();
+            stopQueue();
             writer_thread.join();
             return cli::kFailure;
         }
@@ -224,7 +337,7 @@ int runRecord(cli::Context& context)
 
             cli::outPartial("\r{:>8.0f}s  {:>9} msgs  {:>7.0f}/s  {:>10}  queue {:>5}  drops {}",
                             elapsed, total, rate, humanBytes(static_cast<double>(bytes.load())),
-                            queue.depth(), queue.dropped());
+                            queueDepth(), queueDropped());
             cli::flush();
         }
     }
@@ -238,14 +351,28 @@ int runRecord(cli::Context& context)
     // drain. Stopping the queue first would discard whatever the callbacks were
     // still adding.
     subscribers.clear();
-    queue.stop();
+    stopQueue();
     writer_thread.join();
 
-    writer.noteDropped(queue.dropped());
+    writer.noteDropped(queueDropped());
 
     const bool closed = writer.close();
 
     const bag::bag_metadata_t& metadata = writer.metadata();
+    const bag::WriterStageStats stages = writer.stageStats();
+
+    // Each stage's own rate: bytes through it over the time it was busy. The
+    // one well below the incoming rate is the one to give threads -- or, if
+    // the writer thread stalled, the one it was waiting on.
+    const auto megabytesPerSecond = [](std::uint64_t bytes, double seconds)
+    {
+        return seconds > 0.0 ? static_cast<double>(bytes) / seconds / 1e6 : 0.0;
+    };
+    const double build_rate = megabytesPerSecond(stages.uncompressed_bytes, stages.build_seconds);
+    const double compress_rate = megabytesPerSecond(
+        stages.uncompressed_bytes,
+        stages.compress_seconds / std::max(1u, writer_options.compression_threads));
+    const double append_rate = megabytesPerSecond(stages.compressed_bytes, stages.append_seconds);
 
     if (context.json())
     {
@@ -255,6 +382,18 @@ int runRecord(cli::Context& context)
         summary["dropped"] = metadata.dropped_messages;
         summary["unstamped"] = metadata.unstamped_messages;
         summary["parts"] = metadata.parts.size();
+        if (stages.chunks > 0)
+        {
+            summary["stages"] = {
+                {"chunks", stages.chunks},
+                {"uncompressed_bytes", stages.uncompressed_bytes},
+                {"compressed_bytes", stages.compressed_bytes},
+                {"build_mb_per_s", build_rate},
+                {"compress_mb_per_s", compress_rate},
+                {"append_mb_per_s", append_rate},
+                {"stalled_s", stages.stalled_seconds},
+            };
+        }
         cli::out("{}", summary.dump(2));
     }
     else
@@ -262,13 +401,22 @@ int runRecord(cli::Context& context)
         cli::out("Wrote {} message(s) in {} part(s) to '{}'.", metadata.message_count,
                  metadata.parts.size(), *output);
 
+        if (stages.chunks > 0)
+        {
+            cli::out("Stages: build {:.0f} MB/s, compress {:.0f} MB/s on {} thread(s), append "
+                     "{:.0f} MB/s; writer stalled {:.1f} s over {} chunk(s).",
+                     build_rate, compress_rate, writer_options.compression_threads, append_rate,
+                     stages.stalled_seconds, stages.chunks);
+        }
+
         if (metadata.dropped_messages > 0)
         {
             // Loud, because a silently lossy recording is worse than none: a gap
             // in a trace reads as a publisher that stopped, which is a
             // completely different fault to chase.
             SPDLOG_WARN("{} message(s) were DROPPED -- the recorder could not keep up. Try a "
-                        "larger --queue-depth, --compression lz4, or a faster disk.",
+                        "larger --queue-depth, --compression-threads, --compression lz4, or a "
+                        "faster disk.",
                         metadata.dropped_messages);
         }
 
@@ -29,6 +29,7 @@
 #include "can/backend.h"
 #include "can/channel.h"
 #include "can_backends/registry.h"
+#include "can_topic/frame_codec.h"
 
 #include "can_bridge.capnp.h"
 #include "can_frame.capnp.h"
@@ -41,11 +42,13 @@
 #include <cxxopts.hpp>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <atomic>
 #include <csignal>
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 namespace
 {
@@ -84,6 +87,12 @@ public:
         {
             rxPublisher_ = std::make_unique<pub_sub::ZenohPublisher<::CanFrame>>(config_.rxKey);
         }
+        if (config_.publishRxBatch)
+        {
+            batchPublisher_
+                = std::make_unique<pub_sub::ZenohPublisher<::CanFrameBatch>>(config_.rxBatchKey);
+            pending_.reserve(config_.rxBatchMaxFrames);
+        }
 
         if (!config_.recordTrcPath.empty())
         {
@@ -133,7 +142,7 @@ public:
         // a channel with publish_rx off still pumps when it is being recorded.
         // Without this a `publish_rx: false` channel would produce a trace
         // containing only the frames the node transmitted.
-        if (config_.publishRx || recorder_)
+        if (config_.publishRx || config_.publishRxBatch || recorder_)
         {
             pumping_ = true;
             pump_ = std::thread([this] { pump(); });
@@ -238,13 +247,27 @@ private:
         // wakeup and taking them one at a time turns a burst into a backlog.
         std::array<helpers::CanFrame, 64> batch;
 
+        const auto latencyBudget = std::chrono::milliseconds(config_.rxBatchMaxLatencyMs);
+
         while (pumping_ && running)
         {
-            auto count = channel_->receive(batch, can::Duration { 100 });
+            // A batch that is part-filled and waiting on its latency budget
+            // must not sit out a whole idle receive: wait only as long as it
+            // has left.
+            can::Duration timeout { 100 };
+            if (!pending_.empty())
+            {
+                const auto waited = std::chrono::duration_cast<can::Duration>(
+                    std::chrono::steady_clock::now() - pendingSince_);
+                timeout = std::clamp(latencyBudget - waited, can::Duration { 1 }, timeout);
+            }
+
+            auto count = channel_->receive(batch, timeout);
             if (!count.has_value())
             {
                 note_error(can::to_string(count.error()));
                 SPDLOG_WARN("[{}] receive failed: {}", config_.name, count.error().message);
+                flush_batch();
                 std::this_thread::sleep_for(std::chrono::milliseconds(100));
                 continue;
             }
@@ -262,32 +285,49 @@ private:
                 {
                     publish(batch[i]);
                 }
+                if (batchPublisher_)
+                {
+                    if (pending_.empty())
+                    {
+                        pendingSince_ = std::chrono::steady_clock::now();
+                    }
+                    pending_.push_back(batch[i]);
+                    if (pending_.size() >= config_.rxBatchMaxFrames)
+                    {
+                        flush_batch();
+                    }
+                }
+            }
+
+            if (!pending_.empty()
+                && std::chrono::steady_clock::now() - pendingSince_ >= latencyBudget)
+            {
+                flush_batch();
             }
         }
+
+        // Whatever was waiting on its budget goes out rather than with the
+        // process.
+        flush_batch();
     }
 
     void publish(const helpers::CanFrame& frame)
     {
-        auto& fields = rxPublisher_->fields();
-        fields.setId(frame.id);
-        fields.setLen(frame.len);
-        fields.setExtended(frame.isExtended);
-        fields.setRtr(frame.isRTR);
-        fields.setFd(frame.isFD);
-        fields.setBrs(frame.isBRS);
-        fields.setEsi(frame.isESI);
-        fields.setError(frame.isError);
-        fields.setTimestampUs(frame.timestampUs);
-        fields.setChannel(config_.name);
-
-        const size_t n = std::min<size_t>(frame.data.size(), frame.len);
-        auto data = fields.initData(static_cast<unsigned>(n));
-        for (size_t i = 0; i < n; ++i)
+        can_topic::toMessage(frame, config_.name, rxPublisher_->fields());
+        rxPublisher_->put();
+    }
+
+    // One put for everything pending. Called only from the pump thread, which
+    // is the only thing that touches pending_ or the batch publisher.
+    void flush_batch()
+    {
+        if (pending_.empty())
         {
-            data.set(static_cast<unsigned>(i), frame.data[i]);
+            return;
         }
-
-        rxPublisher_->put();
+        can_topic::toBatch(pending_, config_.name, batchPublisher_->fields());
+        batchPublisher_->put();
+        pending_.clear();
     }
 
     void note_error(std::string message)
@@ -300,6 +340,11 @@ private:
     std::shared_ptr<can::Channel> channel_;
 
     std::unique_ptr<pub_sub::ZenohPublisher<::CanFrame>> rxPublisher_;
+    std::unique_ptr<pub_sub::ZenohPublisher<::CanFrameBatch>> batchPublisher_;
+    // Frames received but not yet put as a batch, and when the first of them
+    // arrived. Pump thread only.
+    std::vector<helpers::CanFrame> pending_;
+    std::chrono::steady_clock::time_point pendingSince_;
     std::unique_ptr<pub_sub::ZenohTypedSubscriber<::CanFrame>> txSubscriber_;
     std::unique_ptr<can_bridge::TrcRecorder> recorder_;
 
@@ -569,6 +614,7 @@ int main(int argc, char** argv)
         open.bitrate.dataSamplePointPermille = channelConfig.dataSamplePointPermille;
         open.listenOnly = channelConfig.listenOnly;
         open.rxQueueDepth = channelConfig.rxQueueDepth;
+        open.rxFilters = channelConfig.rxFilters;
         open.start = true;
 
         auto opened = registry.open(channelConfig.device, open);
@@ -589,6 +635,17 @@ int main(int argc, char** argv)
                     channelConfig.listenOnly ? ", listen-only" : "");
         SPDLOG_INFO("[{}]   rx -> '{}'{}", channelConfig.name, channelConfig.rxKey,
                     channelConfig.publishRx ? "" : " (not published)");
+        if (!channelConfig.rxFilters.empty())
+        {
+            SPDLOG_INFO("[{}]   rx filtered to {} identifier/mask pair(s)", channelConfig.name,
+                        channelConfig.rxFilters.size());
+        }
+        if (channelConfig.publishRxBatch)
+        {
+            SPDLOG_INFO("[{}]   rx -> '{}' in batches of up to {} frame(s), {} ms", channelConfig.name,
+                        channelConfig.rxBatchKey, channelConfig.rxBatchMaxFrames,
+                        channelConfig.rxBatchMaxLatencyMs);
+        }
         SPDLOG_INFO("[{}]   tx <- '{}'{}", channelConfig.name, channelConfig.txKey,
                     channelConfig.acceptTx ? "" : " (not accepted)");
 
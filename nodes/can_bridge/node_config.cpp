@@ -120,6 +120,65 @@ void reject_unknown_keys(const YAML::Node& node, const std::vector<std::string>&
     }
 }
 
+// `rx_filters`: a list of {id, mask, extended}. Only `id` is required; the
+// mask defaults to every bit of the identifier, so a bare id is an exact match.
+void read_rx_filters(const YAML::Node& parent, std::vector<can::RxFilter>& out,
+                     Context& context, const std::string& where)
+{
+    const YAML::Node list = parent["rx_filters"];
+    if (!list)
+    {
+        return;
+    }
+    if (!list.IsSequence())
+    {
+        context.fail(fmt::format("{}.rx_filters is a list of {{id, mask, extended}}", where));
+        return;
+    }
+    // The kernel's own ceiling, applied to every backend so that a config
+    // does not work on a virtual bus and then fail on the car.
+    if (list.size() > 512)
+    {
+        context.fail(fmt::format("{}.rx_filters has {} entries; at most 512", where,
+                                 list.size()));
+        return;
+    }
+
+    for (size_t i = 0; i < list.size(); ++i)
+    {
+        const YAML::Node node = list[i];
+        const std::string at = fmt::format("{}.rx_filters[{}]", where, i);
+        if (!node.IsMap() || !node["id"])
+        {
+            context.fail(fmt::format("{} needs at least an id", at));
+            continue;
+        }
+        reject_unknown_keys(node, { "id", "mask", "extended" }, context, at);
+
+        can::RxFilter filter;
+        read_bool(node, "extended", filter.extended, context, at);
+        const uint32_t widest = filter.extended ? 0x1FFFFFFFu : 0x7FFu;
+        filter.mask = widest;
+        read_uint(node, "id", filter.id, context, at);
+        read_uint(node, "mask", filter.mask, context, at);
+
+        // Bits past the format would never match anything, and a filter that
+        // matches nothing looks exactly like a dead bus.
+        if ((filter.id & ~widest) != 0)
+        {
+            context.fail(fmt::format("{}.id 0x{:X} does not fit an {}-bit identifier{}", at,
+                                     filter.id, filter.extended ? 29 : 11,
+                                     filter.extended ? "" : "; add extended: true for 29-bit"));
+        }
+        if ((filter.mask & ~widest) != 0)
+        {
+            context.fail(fmt::format("{}.mask 0x{:X} is wider than an {}-bit identifier", at,
+                                     filter.mask, filter.extended ? 29 : 11));
+        }
+        out.push_back(filter);
+    }
+}
+
 } // namespace
 
 bool parse_node_config(const std::string& yaml, NodeConfig& out)
@@ -199,7 +258,8 @@ bool parse_node_config(const std::string& yaml, NodeConfig& out)
                             { "name", "device", "bitrate", "data_bitrate", "sample_point_permille",
                               "data_sample_point_permille", "listen_only", "rx_key", "tx_key",
                               "rx_queue_depth", "publish_rx", "accept_tx", "record_trc",
-                              "record_trc_bus" },
+                              "record_trc_bus", "publish_rx_batch", "rx_batch_key",
+                              "rx_batch_max_frames", "rx_batch_max_latency_ms", "rx_filters" },
                             context, where);
 
         ChannelConfig channel;
@@ -214,8 +274,13 @@ bool parse_node_config(const std::string& yaml, NodeConfig& out)
         read_string(node, "rx_key", channel.rxKey);
         read_string(node, "tx_key", channel.txKey);
         read_uint(node, "rx_queue_depth", channel.rxQueueDepth, context, where);
+        read_rx_filters(node, channel.rxFilters, context, where);
         read_bool(node, "publish_rx", channel.publishRx, context, where);
         read_bool(node, "accept_tx", channel.acceptTx, context, where);
+        read_bool(node, "publish_rx_batch", channel.publishRxBatch, context, where);
+        read_string(node, "rx_batch_key", channel.rxBatchKey);
+        read_uint(node, "rx_batch_max_frames", channel.rxBatchMaxFrames, context, where);
+        read_uint(node, "rx_batch_max_latency_ms", channel.rxBatchMaxLatencyMs, context, where);
         read_string(node, "record_trc", channel.recordTrcPath);
         {
             uint32_t recordBus = channel.recordTrcBus;
@@ -262,6 +327,25 @@ bool parse_node_config(const std::string& yaml, NodeConfig& out)
         {
             channel.txKey = fmt::format("vehicle/{}/tx", channel.name);
         }
+        if (channel.rxBatchKey.empty())
+        {
+            channel.rxBatchKey = fmt::format("vehicle/{}/rx_batch", channel.name);
+        }
+
+        if (channel.rxBatchMaxFrames == 0)
+        {
+            context.fail(fmt::format("{}.rx_batch_max_frames is 0; a batch holds at least one "
+                                     "frame",
+                                     where));
+        }
+        // The receive loop wakes every 100 ms whatever happens, so a longer
+        // budget could not be honoured -- and a batch held that long is no
+        // longer live data.
+        if (channel.rxBatchMaxLatencyMs > 100)
+        {
+            context.fail(fmt::format("{}.rx_batch_max_latency_ms is {}; at most 100", where,
+                                     channel.rxBatchMaxLatencyMs));
+        }
 
         if (channel.bitrateBps == 0)
         {
@@ -293,6 +377,14 @@ bool parse_node_config(const std::string& yaml, NodeConfig& out)
             context.fail(fmt::format("{}.rx_key '{}' is published by more than one channel", where,
                                      channel.rxKey));
         }
+        // The same set, because a batch key colliding with anyone's per-frame
+        // key puts two schemas on one topic.
+        if (channel.publishRxBatch && !rxKeys.insert(channel.rxBatchKey).second)
+        {
+            context.fail(fmt::format("{}.rx_batch_key '{}' is already published, by this channel "
+                                     "or another",
+                                     where, channel.rxBatchKey));
+        }
         // Two recorders on one path would interleave their records into a file
         // whose offsets no longer describe either bus. Recording two buses into
         // one trace is a thing the format supports -- via the Bus column -- but
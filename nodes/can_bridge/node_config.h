@@ -15,6 +15,8 @@
 #ifndef CAN_BRIDGE_NODE_CONFIG_H
 #define CAN_BRIDGE_NODE_CONFIG_H
 
+#include "can/backend.h"
+
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -60,6 +62,13 @@ struct ChannelConfig
     // couple of seconds of one.
     uint32_t rxQueueDepth { 8192 };
 
+    // Receive only these identifiers; empty receives everything. On a
+    // socketcan: channel the kernel does the filtering, so a bus carrying
+    // hundreds of identifiers costs this process only the handful it wants.
+    // Everything downstream sees the filtered bus -- the rx topics, the
+    // batches and record_trc alike.
+    std::vector<can::RxFilter> rxFilters;
+
     // Publish received frames at all. Off for a channel that exists only to
     // transmit, where publishing would echo a diagnostic tool's own traffic
     // back at it.
@@ -68,6 +77,24 @@ struct ChannelConfig
     // statement than listenOnly: nothing can even ask.
     bool acceptTx { true };
 
+    // Also publish received frames as CanFrameBatch messages on `rxBatchKey`:
+    // what one receive() returns, in one put, instead of one put per frame. On
+    // a loaded bus that is thousands fewer messages a second for the bridge and
+    // for every subscriber. Off by default because nothing that predates the
+    // batch schema can read it; a channel whose consumers all can turns
+    // publishRx off and takes only the batches.
+    bool publishRxBatch { false };
+    // Defaults to vehicle/<name>/rx_batch. Never the same as rxKey: a batch on
+    // the per-frame topic would decode, wrongly, as a single empty frame.
+    std::string rxBatchKey;
+
+    // A batch is put as soon as it holds this many frames...
+    uint32_t rxBatchMaxFrames { 64 };
+    // ...or its oldest frame has waited this long. Zero puts every receive()'s
+    // worth straight away, which adds no latency at all and still batches
+    // whatever a burst delivers at once.
+    uint32_t rxBatchMaxLatencyMs { 0 };
+
     // Write everything seen on this channel -- received and transmitted -- to a
     // PCAN .trc file at this path, readable by PCAN-Explorer and PCAN-View.
     // Empty records nothing.
@@ -283,6 +283,154 @@ channels:
           "and 17 is past the end of it");
 }
 
+void test_rx_batch()
+{
+    can_bridge::NodeConfig config;
+    check(parses("channels:\n  - name: can0\n    device: \"virtual:a\"\n", config),
+          "a channel without batch settings parses");
+    check(config.channels.size() == 1 && !config.channels[0].publishRxBatch,
+          "batching is off unless asked for, since nothing that predates the schema can read it");
+    check(config.channels.size() == 1 && config.channels[0].rxBatchKey == "vehicle/can0/rx_batch",
+          "and its key defaults from the name like the others");
+
+    config = {};
+    check(parses(R"(
+channels:
+  - name: can0
+    device: "virtual:a"
+    publish_rx: false
+    publish_rx_batch: true
+    rx_batch_max_frames: 32
+    rx_batch_max_latency_ms: 5
+)",
+                 config),
+          "batch settings parse");
+    check(config.channels.size() == 1 && config.channels[0].publishRxBatch
+              && !config.channels[0].publishRx && config.channels[0].rxBatchMaxFrames == 32
+              && config.channels[0].rxBatchMaxLatencyMs == 5,
+          "and land on the channel, batches-only");
+
+    // A batch on the per-frame topic decodes, wrongly, as one empty frame in
+    // every subscriber that predates the batch schema.
+    config = {};
+    check(!parses(R"(
+channels:
+  - name: can0
+    device: "virtual:a"
+    publish_rx_batch: true
+    rx_batch_key: "vehicle/can0/rx"
+)",
+                  config),
+          "a batch key equal to the channel's own rx key is refused");
+
+    config = {};
+    check(!parses(R"(
+channels:
+  - name: a
+    device: "virtual:a"
+  - name: b
+    device: "virtual:a"
+    publish_rx_batch: true
+    rx_batch_key: "vehicle/a/rx"
+)",
+                  config),
+          "and so is one equal to another channel's");
+
+    config = {};
+    check(!parses(R"(
+channels:
+  - name: can0
+    device: "virtual:a"
+    publish_rx_batch: true
+    rx_batch_max_frames: 0
+)",
+                  config),
+          "a batch of zero frames is refused");
+
+    config = {};
+    check(!parses(R"(
+channels:
+  - name: can0
+    device: "virtual:a"
+    publish_rx_batch: true
+    rx_batch_max_latency_ms: 250
+)",
+                  config),
+          "a latency budget past the receive loop's 100 ms wakeup is refused");
+}
+
+void test_rx_filters()
+{
+    can_bridge::NodeConfig config;
+    check(parses("channels:\n  - name: can0\n    device: \"virtual:a\"\n", config),
+          "a channel without filters parses");
+    check(config.channels.size() == 1 && config.channels[0].rxFilters.empty(),
+          "and receives everything");
+
+    config = {};
+    check(parses(R"(
+channels:
+  - name: can0
+    device: "socketcan:can0"
+    rx_filters:
+      - id: 0x100
+        mask: 0x7F0
+      - { id: 0x123 }
+      - { id: 0x18FF0001, extended: true }
+)",
+                 config),
+          "filters parse, in hex");
+    if (config.channels.size() == 1 && config.channels[0].rxFilters.size() == 3)
+    {
+        const auto& filters = config.channels[0].rxFilters;
+        check(filters[0].id == 0x100 && filters[0].mask == 0x7F0 && !filters[0].extended,
+              "a masked 11-bit filter keeps its mask");
+        check(filters[1].id == 0x123 && filters[1].mask == 0x7FF,
+              "a bare id is an exact match on all 11 bits");
+        check(filters[2].id == 0x18FF0001 && filters[2].mask == 0x1FFFFFFF && filters[2].extended,
+              "and an extended one on all 29");
+    }
+    else
+    {
+        check(false, "all three filters land on the channel");
+    }
+
+    // A 29-bit id without `extended` would match nothing, which looks exactly
+    // like a dead bus -- so it is refused, with the fix in the message.
+    config = {};
+    check(!parses(R"(
+channels:
+  - name: can0
+    device: "virtual:a"
+    rx_filters:
+      - id: 0x18FF0001
+)",
+                  config),
+          "an identifier too wide for an 11-bit filter is refused");
+
+    config = {};
+    check(!parses(R"(
+channels:
+  - name: can0
+    device: "virtual:a"
+    rx_filters:
+      - { mask: 0x7F0 }
+)",
+                  config),
+          "a filter without an id is refused");
+
+    config = {};
+    check(!parses(R"(
+channels:
+  - name: can0
+    device: "virtual:a"
+    rx_filters:
+      - { id: 0x100, msk: 0x7F0 }
+)",
+                  config),
+          "and so is a misspelled key inside one");
+}
+
 void test_bad_values()
 {
     can_bridge::NodeConfig config;
@@ -384,6 +532,8 @@ int main()
     test_channels_are_required();
     test_duplicate_detection();
     test_trc_options();
+    test_rx_batch();
+    test_rx_filters();
     test_bad_values();
     test_top_level_settings();
 
@@ -857,17 +857,20 @@ std::unique_ptr<airplay::Receiver> startAirPlayReceiver(const SessionContext& ct
         // sets are cached and re-sent ahead of every keyframe because zenoh has
         // no retained messages: a widget that starts late would otherwise never
         // sync.
-        auto parameter_sets = std::make_shared<std::vector<uint8_t>>();
+        //
+        // Kept as the packet itself, which holds its buffer by handle: caching
+        // the parameter sets costs a reference count, not a copy.
+        auto parameter_sets = std::make_shared<airplay::VideoPacket>();
         receiver->setVideoHandler([&bridge, parameter_sets,
                                    &receiver_config](const airplay::VideoPacket& packet) {
             if (packet.is_config)
             {
                 // Publish the parameter sets as their own message (the widget
                 // caches them and prepends to the next access unit) and keep a
-                // copy so we can republish before every keyframe -- zenoh has no
+                // handle so we can republish before every keyframe -- zenoh has no
                 // retained messages, so a widget that starts or restarts later
                 // must see config again to sync.
-                *parameter_sets = packet.data;
+                *parameter_sets = packet;
 
                 VideoFrame config;
                 config.codec = toBridgeCodec(packet.codec);
@@ -881,15 +884,15 @@ std::unique_ptr<airplay::Receiver> startAirPlayReceiver(const SessionContext& ct
             }
 
             // Republish parameter sets immediately before each keyframe.
-            if (packet.keyframe && !parameter_sets->empty())
+            if (packet.keyframe && !parameter_sets->data.empty())
             {
                 VideoFrame config;
                 config.codec = toBridgeCodec(packet.codec);
                 config.is_config = true;
                 config.width_px = static_cast<uint16_t>(receiver_config.width);
                 config.height_px = static_cast<uint16_t>(receiver_config.height);
-                config.data = parameter_sets->data();
-                config.len = parameter_sets->size();
+                config.data = parameter_sets->data.data();
+                config.len = parameter_sets->data.size();
                 bridge.publishVideo(config);
             }
 
@@ -87,7 +87,7 @@ int runEcho(cli::Context& context)
     pub_sub::RawSubscriber subscriber(
         *key,
         pub_sub::RawSubscriber::InfoHandler(
-            [&](const std::vector<std::uint8_t>& payload,
+            [&](std::span<const std::uint8_t> payload,
                 const pub_sub::RawSubscriber::SampleInfo& info)
             {
                 // One message printed at a time: a wildcard subscription can
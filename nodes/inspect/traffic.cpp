@@ -184,7 +184,7 @@ TrafficMonitor::TrafficMonitor(const std::string& keyexpr) : impl_(std::make_uni
     impl_->subscriber = std::make_unique<pub_sub::RawSubscriber>(
         keyexpr,
         pub_sub::RawSubscriber::InfoHandler(
-            [impl](const std::vector<std::uint8_t>& payload,
+            [impl](std::span<const std::uint8_t> payload,
                    const pub_sub::RawSubscriber::SampleInfo& info)
             {
                 // Taken here rather than inside the lock: the clock read is the
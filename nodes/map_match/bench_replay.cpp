@@ -0,0 +1,288 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//
+// How long Matcher::update takes on a recorded drive, at each fix rate.
+//
+// NOT a test -- it asserts nothing and always exits 0. test_matcher is what
+// shows the matcher picks the right road; this shows what a fix costs on a
+// real graph with a real receiver's noise, which is the number that decides
+// whether the node keeps up with a BD992 streaming at 20 or 50 Hz.
+//
+// The capture is the raw bytes off the GSOF stream socket, as the bridge's
+// byte tap writes them. Each transmission's position, velocity and sigma make
+// one fix, timed by its GSOF 1; the drive is then resampled to each rate by
+// interpolating between those, so the same trace is replayed at 10 Hz with
+// ~10 m between fixes and at 50 Hz with ~2 m, which is exactly the difference
+// in how far each bounded search has to look.
+//
+//   map_match_bench_replay --graph socal.graph --gsof drive.bin
+//   map_match_bench_replay --graph socal.graph --gsof drive.bin --hz 10,20,50 --passes 50
+//
+// What each column means:
+//
+//   hz        the rate the drive was resampled to
+//   fixes     updates timed, over every pass
+//   matched   the share of them that found a road
+//   mean/p99  microseconds per update() call
+//   budget    the mean as a share of the interval between fixes at that rate
+//
+// The first pass at each rate is as much the graph's pages faulting in as it
+// is matching, which is what --passes is for.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <numbers>
+#include <optional>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "gsof/framer.h"
+#include "gsof/record_iterator.h"
+#include "gsof/transport.h"
+#include "road_graph/geometry.h"
+#include "road_graph/graph.h"
+
+#include "matcher.h"
+
+namespace
+{
+
+std::string argumentAfter(int argc, char** argv, const std::string& flag,
+                          const std::string& fallback)
+{
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (flag == argv[i])
+        {
+            return argv[i + 1];
+        }
+    }
+    return fallback;
+}
+
+// "10,20,50" -> {10, 20, 50}. Empty or unparseable means those three.
+std::vector<double> rates(const std::string& list)
+{
+    std::vector<double> out;
+    std::size_t at = 0;
+    while (at < list.size())
+    {
+        const std::size_t comma = std::min(list.find(',', at), list.size());
+        const double value = std::strtod(list.substr(at, comma - at).c_str(), nullptr);
+        if (value > 0.0)
+        {
+            out.push_back(value);
+        }
+        at = comma + 1;
+    }
+    if (out.empty())
+    {
+        out = { 10.0, 20.0, 50.0 };
+    }
+    return out;
+}
+
+// One transmission's worth of what the node would have matched, and when.
+struct TimedFix
+{
+    double seconds { 0.0 };
+    double latDeg { 0.0 };
+    double lonDeg { 0.0 };
+    map_match::Fix fix;
+};
+
+// The same mapping services.cpp makes from a fused epoch, done here straight
+// from the records so the bench needs neither capnp nor the bridge.
+std::vector<TimedFix> decode(std::span<const std::uint8_t> bytes)
+{
+    std::vector<TimedFix> out;
+
+    gsof::Framer framer;
+    gsof::PageAssembler assembler;
+    framer.push(bytes);
+
+    while (const auto packet = framer.next())
+    {
+        if (!packet->is(gsof::trimcomm::PacketType::GenOut))
+        {
+            continue;
+        }
+        const auto fed = assembler.feed(packet->data);
+        if (!fed || *fed != gsof::PageAssembler::Feed::Complete)
+        {
+            continue;
+        }
+
+        std::optional<double> seconds;
+        std::optional<gsof::LatLongHeight> position;
+        TimedFix timed;
+
+        gsof::RecordIterator it(assembler.payload());
+        while (!it.done())
+        {
+            const auto record = it.next();
+            if (!record)
+            {
+                break;
+            }
+            (void)gsof::visit_record(*record, [&](const auto& parsed) {
+                using Parsed = std::decay_t<decltype(parsed)>;
+                if constexpr (std::is_same_v<Parsed, gsof::PositionTime>)
+                {
+                    seconds = double(parsed.gpsWeek) * 604800.0 + double(parsed.gpsTimeMs) / 1e3;
+                }
+                else if constexpr (std::is_same_v<Parsed, gsof::LatLongHeight>)
+                {
+                    position = parsed;
+                }
+                else if constexpr (std::is_same_v<Parsed, gsof::Velocity>)
+                {
+                    if (parsed.isValid())
+                    {
+                        const double degrees = parsed.headingRad * 180.0 / std::numbers::pi;
+                        timed.fix.headingDeg = std::fmod(degrees + 360.0, 360.0);
+                        timed.fix.speedMps = parsed.horizontalSpeedMps;
+                    }
+                }
+                else if constexpr (std::is_same_v<Parsed, gsof::PositionSigma>)
+                {
+                    timed.fix.sigmaM = parsed.positionRms;
+                }
+            });
+        }
+
+        // A transmission without a position is not a fix, and one without a
+        // time cannot be placed on the resampled clock.
+        if (!position || !seconds || (!out.empty() && *seconds <= out.back().seconds))
+        {
+            continue;
+        }
+        timed.seconds = *seconds;
+        timed.latDeg = position->latitudeRad * 180.0 / std::numbers::pi;
+        timed.lonDeg = position->longitudeRad * 180.0 / std::numbers::pi;
+        out.push_back(timed);
+    }
+    return out;
+}
+
+// The drive at `hz`: position interpolated between the two recorded fixes
+// either side, everything else taken from the earlier one.
+std::vector<map_match::Fix> resample(const std::vector<TimedFix>& drive, double hz)
+{
+    std::vector<map_match::Fix> out;
+    if (drive.size() < 2)
+    {
+        return out;
+    }
+
+    std::size_t at = 0;
+    for (double t = drive.front().seconds; t <= drive.back().seconds; t += 1.0 / hz)
+    {
+        while (at + 2 < drive.size() && drive[at + 1].seconds < t)
+        {
+            ++at;
+        }
+        const TimedFix& a = drive[at];
+        const TimedFix& b = drive[at + 1];
+        const double f = std::clamp((t - a.seconds) / (b.seconds - a.seconds), 0.0, 1.0);
+
+        map_match::Fix fix = a.fix;
+        fix.lat = road_graph::fromDegrees(a.latDeg + (b.latDeg - a.latDeg) * f);
+        fix.lon = road_graph::fromDegrees(a.lonDeg + (b.lonDeg - a.lonDeg) * f);
+        out.push_back(fix);
+    }
+    return out;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    spdlog::set_pattern("%v");
+
+    const std::string graphPath = argumentAfter(argc, argv, "--graph", "");
+    const std::string capturePath = argumentAfter(argc, argv, "--gsof", "");
+    if (graphPath.empty() || capturePath.empty())
+    {
+        SPDLOG_ERROR("usage: map_match_bench_replay --graph <file> --gsof <capture> "
+                     "[--hz 10,20,50] [--passes 20]");
+        return 0;
+    }
+    const std::string passesText = argumentAfter(argc, argv, "--passes", "20");
+    const long passes = std::max(1L, std::strtol(passesText.c_str(), nullptr, 10));
+
+    auto graph = road_graph::Graph::open(graphPath);
+    if (!graph)
+    {
+        SPDLOG_ERROR("cannot open {}", graphPath);
+        return 0;
+    }
+
+    std::ifstream in(capturePath, std::ios::binary);
+    const std::vector<std::uint8_t> bytes((std::istreambuf_iterator<char>(in)),
+                                          std::istreambuf_iterator<char>());
+    const std::vector<TimedFix> drive = decode(bytes);
+    if (drive.size() < 2)
+    {
+        SPDLOG_ERROR("{}: {} timed fixes, need at least two", capturePath, drive.size());
+        return 0;
+    }
+
+    SPDLOG_INFO("{}: {} fixes over {:.1f} s; {}: {} segments", capturePath, drive.size(),
+                drive.back().seconds - drive.front().seconds, graphPath,
+                graph->segments().size());
+    SPDLOG_INFO("{:>6} {:>8} {:>8} {:>9} {:>9} {:>8}", "hz", "fixes", "matched", "mean us",
+                "p99 us", "budget");
+
+    for (const double hz : rates(argumentAfter(argc, argv, "--hz", "")))
+    {
+        const std::vector<map_match::Fix> fixes = resample(drive, hz);
+
+        map_match::Matcher matcher(*graph, {});
+        std::vector<double> micros;
+        micros.reserve(fixes.size() * static_cast<std::size_t>(passes));
+        std::uint64_t matched = 0;
+
+        for (long pass = 0; pass < passes; ++pass)
+        {
+            // The end of the drive is not where it starts; replaying straight
+            // on would be the jump services.cpp resets for.
+            matcher.reset();
+            for (const map_match::Fix& fix : fixes)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                const map_match::MatchResult result = matcher.update(fix);
+                const auto end = std::chrono::steady_clock::now();
+
+                micros.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+                matched += result.matched ? 1 : 0;
+            }
+        }
+        if (micros.empty())
+        {
+            continue;
+        }
+
+        double total = 0.0;
+        for (const double us : micros)
+        {
+            total += us;
+        }
+        const double mean = total / double(micros.size());
+        const auto p99 = micros.begin() + static_cast<std::ptrdiff_t>(micros.size() * 99 / 100);
+        std::nth_element(micros.begin(), p99, micros.end());
+
+        SPDLOG_INFO("{:>6.0f} {:>8} {:>7.1f}% {:>9.1f} {:>9.1f} {:>7.3f}%", hz, micros.size(),
+                    100.0 * double(matched) / double(micros.size()), mean, *p99,
+                    100.0 * mean / (1e6 / hz));
+    }
+    return 0;
+}
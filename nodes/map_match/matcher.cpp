@@ -108,65 +108,89 @@ MatchResult Matcher::update(const Fix& fix)
             road_graph::bearingDeltaDeg(*heading, match.bearingDeg) <= 90.0;
 
         candidate.logProbability = logEmission(match.distanceM, sigma);
+        next.push_back(candidate);
+    }
 
-        if (!mBeam.empty())
+    if (!mBeam.empty())
+    {
+        // Best transition into each candidate from any previous one. The
+        // alternative -- keeping every (previous, current) pair -- is the full
+        // Viterbi lattice, which for an online matcher that only ever reports
+        // the current best is more bookkeeping than answer.
+        mBestTransition.assign(next.size(), -1e9);
+
+        // Bounded hard. Two candidates that do not connect within a few times
+        // the distance travelled are not a plausible pair, and searching
+        // further to prove it would expand the city.
+        const double limit = std::max(200.0, travelledM * 4.0);
+
+        for (const Candidate& previous : mBeam)
         {
-            // Best transition from any previous candidate. The alternative --
-            // keeping every (previous, current) pair -- is the full Viterbi
-            // lattice, which for an online matcher that only ever reports the
-            // current best is more bookkeeping than answer.
-            double bestTransition = -1e9;
-            for (const Candidate& previous : mBeam)
+            // ONE search from this previous candidate, settling every current
+            // one on another road. Searching pair by pair expanded the same few
+            // hundred metres around `previous` once per candidate -- beamWidth
+            // times a dozen Dijkstras a fix, nearly all of them the same one.
+            const road_graph::SegmentRecord& from = mGraph.segments()[previous.segment];
+            mTargets.clear();
+            for (const Candidate& candidate : next)
+            {
+                if (candidate.segment != previous.segment)
+                {
+                    const road_graph::SegmentRecord& to = mGraph.segments()[candidate.segment];
+                    mTargets.push_back(candidate.forward ? to.fromNode : to.toNode);
+                }
+            }
+            if (!mTargets.empty())
+            {
+                mSearch.distances(mGraph, previous.forward ? from.toNode : from.fromNode,
+                                  mTargets, limit, mReached);
+            }
+
+            std::size_t target = 0;
+            for (std::size_t i = 0; i < next.size(); ++i)
             {
                 double onGraphM = 0.0;
-                if (previous.segment == candidate.segment)
+                if (previous.segment == next[i].segment)
                 {
                     // Same road: the distance is just how far along it we moved,
                     // and no search is needed. This is the overwhelmingly common
                     // case at 10 Hz, and short-circuiting it is what keeps the
                     // matcher cheap.
-                    onGraphM = std::fabs(static_cast<double>(candidate.offsetCm) -
+                    onGraphM = std::fabs(static_cast<double>(next[i].offsetCm) -
                                          static_cast<double>(previous.offsetCm)) /
                                100.0;
                 }
                 else
                 {
-                    const road_graph::SegmentRecord& from = mGraph.segments()[previous.segment];
-                    const road_graph::SegmentRecord& to = mGraph.segments()[candidate.segment];
-
-                    // Bounded hard. Two candidates that do not connect within a
-                    // few times the distance travelled are not a plausible pair,
-                    // and searching further to prove it would expand the city.
-                    const double limit = std::max(200.0, travelledM * 4.0);
-                    const auto distance = mSearch.distance(
-                        mGraph, previous.forward ? from.toNode : from.fromNode,
-                        candidate.forward ? to.fromNode : to.toNode, limit);
-                    if (!distance)
+                    const std::optional<double>& reached = mReached[target++];
+                    if (!reached)
                     {
                         continue;
                     }
-                    onGraphM = *distance;
+                    onGraphM = *reached;
                 }
 
                 const double detour = std::fabs(onGraphM - travelledM);
                 const double transition = -detour / mConfig.transitionBetaM;
-                bestTransition = std::max(bestTransition, previous.logProbability + transition);
+                mBestTransition[i] =
+                    std::max(mBestTransition[i], previous.logProbability + transition);
             }
+        }
 
-            if (bestTransition < -1e8)
+        for (std::size_t i = 0; i < next.size(); ++i)
+        {
+            if (mBestTransition[i] < -1e8)
             {
                 // Nothing in the beam can reach this candidate. Not impossible
                 // -- the beam may be stale -- so it keeps its emission score and
                 // is penalised rather than dropped.
-                candidate.logProbability -= 10.0;
+                next[i].logProbability -= 10.0;
             }
             else
             {
-                candidate.logProbability += bestTransition;
+                next[i].logProbability += mBestTransition[i];
             }
         }
-
-        next.push_back(candidate);
     }
 
     // Renormalise so the best candidate sits at zero. Without this the scores
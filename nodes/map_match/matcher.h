@@ -72,7 +72,7 @@ struct MatcherConfig
     // How far to look for candidates.
     double searchRadiusM { 50.0 };
     // How many to carry forward. Beyond a handful the extra candidates never
-    // win, and each one costs a bounded Dijkstra per fix.
+    // win, and each one costs a bounded search per fix.
     std::size_t beamWidth { 6 };
 
     // Floor and ceiling on the emission width. The floor stops an RTK-fixed
@@ -151,9 +151,16 @@ class Matcher
     MatcherConfig mConfig;
 
     // One reusable bounded-search context for the whole matcher. update()
-    // makes up to beamWidth^2 of these per fix; a fresh hash table each time
-    // was most of the cost of a fix. See road_graph::BoundedSearch.
+    // runs one search per beam candidate per fix, each settling every current
+    // candidate at once; a fresh visited set each time was most of the cost of
+    // a fix. See road_graph::BoundedSearch.
     road_graph::BoundedSearch mSearch;
+    // update()'s scratch, kept so a fix allocates nothing once the first few
+    // have sized it: one search's targets and answers, and the best transition
+    // found into each current candidate so far.
+    std::vector<road_graph::NodeIndex> mTargets;
+    std::vector<std::optional<double>> mReached;
+    std::vector<double> mBestTransition;
 
     std::vector<Candidate> mBeam;
     bool mHavePrevious { false };
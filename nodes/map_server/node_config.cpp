@@ -299,6 +299,8 @@ void parseServices(const YAML::Node& node, ServiceConfig& out, Context& context)
         readString(node, "nearest_key", out.nearestKey, context, "services");
         readString(node, "route_key", out.routeKey, context, "services");
         readString(node, "graph_info_key", out.graphInfoKey, context, "services");
+        readString(node, "table_key", out.tableKey, context, "services");
+        readUint(node, "table_max_cells", out.tableMaxCells, context, "services");
         readString(node, "track_catalog_key", out.trackCatalogKey, context, "services");
         readString(node, "track_detail_key", out.trackDetailKey, context, "services");
         readUint(node, "status_interval_ms", out.statusIntervalMs, context, "services");
@@ -311,9 +313,16 @@ void parseServices(const YAML::Node& node, ServiceConfig& out, Context& context)
     checkKey(out.nearestKey, "nearest_key", context);
     checkKey(out.routeKey, "route_key", context);
     checkKey(out.graphInfoKey, "graph_info_key", context);
+    checkKey(out.tableKey, "table_key", context);
     checkKey(out.trackCatalogKey, "track_catalog_key", context);
     checkKey(out.trackDetailKey, "track_detail_key", context);
 
+    if (out.tableMaxCells == 0)
+    {
+        context.fail("services.table_max_cells of 0 would refuse every table; omit it for the "
+                     "default");
+    }
+
     // Two services on one key both answer, and a client takes whichever reply
     // arrives first -- so a tile request would sometimes come back as a
     // catalog. That decodes against the wrong schema, which is silent: capnp
@@ -327,6 +336,7 @@ void parseServices(const YAML::Node& node, ServiceConfig& out, Context& context)
         { &out.nearestKey, "nearest_key" },
         { &out.routeKey, "route_key" },
         { &out.graphInfoKey, "graph_info_key" },
+        { &out.tableKey, "table_key" },
     };
 
     for (std::size_t i = 0; i < std::size(keys); ++i)
@@ -364,6 +374,65 @@ void parseAssets(const YAML::Node& node, AssetConfig& out, Context& context)
     }
 }
 
+void parseWorkers(const YAML::Node& node, WorkerConfig& out, Context& context)
+{
+    if (!node)
+    {
+        return;
+    }
+
+    if (!node.IsMap())
+    {
+        context.fail("workers must be a mapping");
+        return;
+    }
+
+    readUint(node, "threads", out.threads, context, "workers");
+    readUint(node, "tile_concurrency", out.tileConcurrency, context, "workers");
+    readUint(node, "tile_queue", out.tileQueue, context, "workers");
+    readUint(node, "route_concurrency", out.routeConcurrency, context, "workers");
+    readUint(node, "route_queue", out.routeQueue, context, "workers");
+    readUint(node, "table_concurrency", out.tableConcurrency, context, "workers");
+    readUint(node, "table_queue", out.tableQueue, context, "workers");
+
+    // A queue of 0 is legitimate -- run it now or say busy -- but a concurrency
+    // of 0 would say busy to everything, which is not what anyone means.
+    if (out.threads > 0 && out.tileConcurrency == 0)
+    {
+        context.fail("workers.tile_concurrency of 0 would refuse every tile request; "
+                     "set workers.threads to 0 to answer on zenoh's threads instead");
+    }
+    if (out.threads > 0 && out.routeConcurrency == 0)
+    {
+        context.fail("workers.route_concurrency of 0 would refuse every route request; "
+                     "set workers.threads to 0 to answer on zenoh's threads instead");
+    }
+    if (out.threads > 0 && out.tableConcurrency == 0)
+    {
+        context.fail("workers.table_concurrency of 0 would refuse every table request; "
+                     "set workers.threads to 0 to answer on zenoh's threads instead");
+    }
+}
+
+void parseTileCache(const YAML::Node& node, TileCacheConfig& out, Context& context)
+{
+    if (!node)
+    {
+        return;
+    }
+
+    if (!node.IsMap())
+    {
+        context.fail("tile_cache must be a mapping");
+        return;
+    }
+
+    // 0 is allowed and means off, unlike assets.max_bytes: an absent cache is
+    // a working server, where a zero asset ceiling is one that refuses
+    // everything.
+    readUint(node, "max_bytes", out.maxBytes, context, "tile_cache");
+}
+
 } // namespace
 
 bool parse_node_config(const std::string& yaml, NodeConfig& out)
@@ -392,6 +461,8 @@ bool parse_node_config(const std::string& yaml, NodeConfig& out)
     parseTracksets(root["tracksets"], out.tracksets, context);
     parseServices(root["services"], out.services, context);
     parseAssets(root["assets"], out.assets, context);
+    parseWorkers(root["workers"], out.workers, context);
+    parseTileCache(root["tile_cache"], out.tileCache, context);
 
     return context.ok;
 }
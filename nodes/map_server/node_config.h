@@ -59,6 +59,11 @@ struct ServiceConfig
     std::string nearestKey { "map/nearest" };
     std::string routeKey { "map/route" };
     std::string graphInfoKey { "map/graph" };
+    // Travel times between many points at once -- see MapTableRequest. Capped
+    // in cells rather than points, because sources x destinations is what the
+    // reply and the bucket scans grow with; the default is a 100 x 100 table.
+    std::string tableKey { "map/table" };
+    std::uint32_t tableMaxCells { 10000 };
 
     // The race-track services. Separate from the tile services because they
     // answer a different question about the same file: the catalogue is what
@@ -84,6 +89,45 @@ struct AssetConfig
     std::uint64_t maxBytes { 8U * 1024U * 1024U };
 };
 
+// Recently served tiles, kept in memory so the same tile asked for by several
+// clients at once is read from the archive once. See tile_cache.h.
+struct TileCacheConfig
+{
+    // Tile bytes plus a small per-entry overhead. 0 turns the cache off and
+    // every tile is read from the archive, as before it existed. A dense z14
+    // vector tile is ~80 kB, so the default holds several screens' worth for
+    // every client at once.
+    std::uint64_t maxBytes { 64U * 1024U * 1024U };
+};
+
+// Where the slow handlers run. Tile batches, routes and tables are answered on
+// a pool of this node's own threads rather than on zenoh's, so one long route
+// cannot hold up the tile replies -- and every subscriber delivery -- on the
+// session behind it. The other services stay on zenoh's threads: a catalog or a nearest
+// lookup is over before a hop to a worker would have been.
+//
+// Each of the three has its own ceiling on the pool, and a queue behind it; a
+// request that finds both full is answered "busy" at once rather than waiting
+// out the caller's timeout. See pub_sub/service_workers.h.
+struct WorkerConfig
+{
+    // 0 answers everything on zenoh's threads, as before the pool existed.
+    std::uint32_t threads { 4 };
+
+    std::uint32_t tileConcurrency { 3 };
+    std::uint32_t tileQueue { 32 };
+
+    // Lower than the tiles on purpose: a route is one user waiting, a tile
+    // batch is the map visibly filling in.
+    std::uint32_t routeConcurrency { 2 };
+    std::uint32_t routeQueue { 8 };
+
+    // Lower again: a table is one search per point, so a big one is the cost
+    // of many routes, and it is a tool waiting rather than a driver.
+    std::uint32_t tableConcurrency { 1 };
+    std::uint32_t tableQueue { 4 };
+};
+
 struct NodeConfig
 {
     std::vector<TilesetConfig> tilesets;
@@ -91,6 +135,8 @@ struct NodeConfig
     std::vector<TracksetConfig> tracksets;
     ServiceConfig services;
     AssetConfig assets;
+    WorkerConfig workers;
+    TileCacheConfig tileCache;
 };
 
 // Both report every problem they find before returning false, so a config with
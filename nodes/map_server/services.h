@@ -2,8 +2,9 @@
 //
 // The queryables, and the status topic.
 //
-// Every handler here runs on a zenoh query thread, and there is more than one
-// of them. Nothing in this class may assume otherwise: the archives are
+// Every handler here runs on a zenoh query thread or a worker -- tiles, routes and
+// tables go to mWorkers unless workers.threads is 0 -- and there is more than one of
+// either. Nothing in this class may assume otherwise: the archives are
 // internally locked, the counters are atomics, and the AssetStore is const
 // after construction.
 #ifndef MAP_SERVER_SERVICES_H
@@ -12,6 +13,7 @@
 #include <memory>
 #include <optional>
 
+#include "pub_sub/service_workers.h"
 #include "pub_sub/zenoh_publisher.h"
 #include "pub_sub/zenoh_service.h"
 
@@ -22,6 +24,7 @@
 #include "asset_store.h"
 #include "graphs.h"
 #include "node_config.h"
+#include "tile_cache.h"
 #include "tilesets.h"
 #include "tracksets.h"
 
@@ -40,6 +43,12 @@ class Services
 
   private:
     void handleTile(const MapTileRequest::Reader& request, MapTileResponse::Builder& response);
+
+    // One tile through the cache when there is one, straight from the archive
+    // when there is not. The same contract as mbtiles::Archive::tile()'s
+    // borrowing form either way, so handleTile does not care which.
+    mbtiles::Result<bool> readTile(Tileset& tileset, std::uint8_t z, std::uint32_t x,
+                                   std::uint32_t y, const mbtiles::Archive::TileSink& sink);
     void handleCatalog(const MapCatalogRequest::Reader& request,
                        MapCatalogResponse::Builder& response);
     void handleAsset(const MapAssetRequest::Reader& request, MapAssetResponse::Builder& response);
@@ -49,6 +58,7 @@ class Services
     void handleGraphInfo(const MapGraphInfoRequest::Reader& request,
                          MapGraphInfoResponse::Builder& response);
     void handleRoute(const MapRouteRequest::Reader& request, MapRouteResponse::Builder& response);
+    void handleTable(const MapTableRequest::Reader& request, MapTableResponse::Builder& response);
 
     // The race-track services. What tracks exist and where, and one track's
     // full-resolution geometry -- neither of which survives tiling, which is
@@ -63,10 +73,21 @@ class Services
     TracksetRegistry& mTracksets;
     AssetStore mAssets;
 
+    // Null when tile_cache.max_bytes is 0.
+    std::unique_ptr<TileCache> mTileCache;
+
+    // services.table_max_cells.
+    std::uint32_t mTableMaxCells { 0 };
+
     std::atomic<std::uint64_t> mAssetsServed { 0 };
     std::atomic<std::uint64_t> mAssetsMissing { 0 };
     std::atomic<std::uint64_t> mAssetsRejected { 0 };
 
+    // Null when workers.threads is 0. Declared before the services so it is
+    // destroyed after them: each one waits for its own work on the pool, and
+    // the pool must still be running while it does.
+    std::unique_ptr<pub_sub::ServiceWorkerPool> mWorkers;
+
     // Declared last, and destroyed first, so a query cannot arrive against a
     // handler whose captured state has already gone.
     std::optional<pub_sub::ZenohPublisher<::MapServerStatus>> mStatus;
@@ -77,6 +98,7 @@ class Services
     std::optional<pub_sub::ZenohService<::MapGraphInfoRequest, ::MapGraphInfoResponse>>
         mGraphInfoService;
     std::optional<pub_sub::ZenohService<::MapRouteRequest, ::MapRouteResponse>> mRouteService;
+    std::optional<pub_sub::ZenohService<::MapTableRequest, ::MapTableResponse>> mTableService;
     std::optional<pub_sub::ZenohService<::MapTrackCatalogRequest, ::MapTrackCatalogResponse>>
         mTrackCatalogService;
     std::optional<pub_sub::ZenohService<::MapTrackDetailRequest, ::MapTrackDetailResponse>>
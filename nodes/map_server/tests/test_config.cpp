@@ -60,6 +60,13 @@ void test_a_minimal_config_parses_with_defaults()
     check(config.services.statusKey == "map/status", "status_key defaults");
     check(config.assets.root.empty(), "an absent asset root leaves the asset service off");
     check(config.assets.maxBytes > 0, "max_bytes has a non-zero default");
+    check(config.workers.threads > 0, "the slow services are on the worker pool by default");
+    check(config.workers.routeConcurrency > 0 && config.workers.tileConcurrency > 0 &&
+              config.workers.tableConcurrency > 0,
+          "and all three have room to run");
+    check(config.services.tableKey == "map/table", "table_key defaults");
+    check(config.services.tableMaxCells > 0, "and so does the ceiling on a table");
+    check(config.tileCache.maxBytes > 0, "the tile cache is on by default");
 }
 
 void test_every_field_round_trips()
@@ -77,9 +84,21 @@ services:
   asset_key: nodes/map/asset
   status_key: nodes/map/status
   status_interval_ms: 2500
+  table_key: nodes/map/table
+  table_max_cells: 400
 assets:
   root: /maps/assets
   max_bytes: 1048576
+workers:
+  threads: 6
+  tile_concurrency: 4
+  tile_queue: 64
+  route_concurrency: 1
+  route_queue: 0
+  table_concurrency: 2
+  table_queue: 1
+tile_cache:
+  max_bytes: 0
 )",
                             config),
           "a full config parses");
@@ -87,8 +106,18 @@ assets:
     check(config.tilesets.size() == 2, "both tilesets are read");
     check(config.services.tileKey == "nodes/map/tile", "tile_key is read");
     check(config.services.statusIntervalMs == 2500, "status_interval_ms is read");
+    check(config.services.tableKey == "nodes/map/table" && config.services.tableMaxCells == 400,
+          "table_key and table_max_cells are read");
     check(config.assets.root == "/maps/assets", "the asset root is read");
     check(config.assets.maxBytes == 1048576, "max_bytes is read");
+    check(config.workers.threads == 6, "workers.threads is read");
+    check(config.workers.tileConcurrency == 4 && config.workers.tileQueue == 64,
+          "the tile limits are read");
+    check(config.workers.routeConcurrency == 1 && config.workers.routeQueue == 0,
+          "the route limits are read, and a queue of 0 is allowed");
+    check(config.workers.tableConcurrency == 2 && config.workers.tableQueue == 1,
+          "the table limits are read");
+    check(config.tileCache.maxBytes == 0, "tile_cache.max_bytes is read, and 0 is allowed");
 }
 
 void test_a_config_with_no_tilesets_is_refused()
@@ -161,6 +190,19 @@ services:
 )",
                              assetClash),
           "asset_key colliding with the default status_key is refused");
+
+    // A table request answered by the route service decodes as a route from
+    // (0, 0) to wherever the first source's bytes land.
+    NodeConfig tableClash;
+    check(!parse_node_config(R"(
+tilesets:
+  - name: socal
+    path: /maps/socal.mbtiles
+services:
+  table_key: map/route
+)",
+                             tableClash),
+          "table_key colliding with the default route_key is refused");
 }
 
 void test_illegal_zenoh_keys_are_refused()
@@ -212,6 +254,35 @@ assets:
           "assets.max_bytes of 0 is refused");
 }
 
+void test_a_zero_worker_concurrency_is_refused()
+{
+    // It would answer every route "busy", which reads as a server under load
+    // rather than a config mistake.
+    NodeConfig config;
+    check(!parse_node_config(R"(
+tilesets:
+  - name: socal
+    path: /maps/socal.mbtiles
+workers:
+  route_concurrency: 0
+)",
+                             config),
+          "workers.route_concurrency of 0 is refused");
+
+    // With no pool the limits mean nothing, so they are not held against it.
+    NodeConfig noPool;
+    check(parse_node_config(R"(
+tilesets:
+  - name: socal
+    path: /maps/socal.mbtiles
+workers:
+  threads: 0
+  route_concurrency: 0
+)",
+                            noPool),
+          "threads: 0 answers on zenoh's threads and ignores the limits");
+}
+
 void test_malformed_yaml_is_refused_not_ignored()
 {
     NodeConfig config;
@@ -263,6 +334,7 @@ int main()
     test_illegal_zenoh_keys_are_refused();
     test_an_empty_key_is_refused();
     test_a_zero_asset_ceiling_is_refused();
+    test_a_zero_worker_concurrency_is_refused();
     test_malformed_yaml_is_refused_not_ignored();
     test_every_problem_is_reported_not_just_the_first();
 
@@ -0,0 +1,254 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//
+// The tile cache in front of the archives.
+//
+// What is worth pinning is everything a cache can get wrong while still
+// returning the right bytes: a budget that is not held grows the server until
+// the kernel steps in; evicting the wrong end keeps the tiles nobody is looking
+// at; and single flight that does not work looks exactly like a cache that
+// does, except that the burst after every pan still reaches SQLite once per
+// client. So the loads here count themselves, and the counts are the checks.
+//
+// No archive and no bus: the loads stand in for Archive::tile().
+
+#include "tile_cache.h"
+#include "tilesets.h"
+
+#include <spdlog/spdlog.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+int failures = 0;
+
+void check(bool condition, const std::string& what)
+{
+    if (!condition)
+    {
+        SPDLOG_ERROR("FAIL: {}", what);
+        ++failures;
+    }
+}
+
+using map_server::CachedTile;
+using map_server::TileCache;
+using map_server::TileKey;
+
+// A load that answers with `bytes` bytes and counts how often it ran.
+TileCache::Load counted(std::atomic<int>& calls, std::size_t bytes, bool present = true)
+{
+    return [&calls, bytes, present]() -> mbtiles::Result<TileCache::Answer> {
+        calls.fetch_add(1);
+        auto tile = std::make_shared<CachedTile>();
+        tile->present = present;
+        tile->encoding = mbtiles::Encoding::Gzip;
+        tile->data.assign(present ? bytes : 0, 0xab);
+        return tile;
+    };
+}
+
+void test_a_second_ask_is_a_hit()
+{
+    map_server::Tileset socal;
+    TileCache cache(1 << 20);
+    std::atomic<int> calls { 0 };
+
+    const TileKey key { &socal, 14, 2828, 6562 };
+    const auto first = cache.get(key, counted(calls, 1000));
+    const auto second = cache.get(key, counted(calls, 1000));
+
+    check(first.source == TileCache::Source::Miss, "the first ask reads the archive");
+    check(second.source == TileCache::Source::Hit, "the second is answered from the cache");
+    check(calls.load() == 1, "and the archive was read once");
+    check(second.tile && (*second.tile)->data.size() == 1000 &&
+              (*second.tile)->encoding == mbtiles::Encoding::Gzip,
+          "the cached answer is the one that was read, encoding and all");
+}
+
+void test_absence_is_cached_too()
+{
+    // Most of the pyramid is empty, so "nothing there" is the commonest answer
+    // a client gets and the one most worth not asking SQLite for twice.
+    map_server::Tileset socal;
+    TileCache cache(1 << 20);
+    std::atomic<int> calls { 0 };
+
+    const TileKey key { &socal, 14, 1, 1 };
+    cache.get(key, counted(calls, 0, false));
+    const auto again = cache.get(key, counted(calls, 0, false));
+
+    check(again.source == TileCache::Source::Hit && calls.load() == 1,
+          "an absent tile is remembered as absent");
+    check(again.tile && !(*again.tile)->present, "and comes back as absent, not as empty");
+    check(cache.stats().bytes == TileCache::kEntryOverheadBytes,
+          "it is charged the entry overhead, so misses cannot grow without bound");
+}
+
+void test_tilesets_do_not_share_entries()
+{
+    map_server::Tileset socal;
+    map_server::Tileset tracks;
+    TileCache cache(1 << 20);
+    std::atomic<int> calls { 0 };
+
+    cache.get(TileKey { &socal, 10, 5, 5 }, counted(calls, 100));
+    const auto other = cache.get(TileKey { &tracks, 10, 5, 5 }, counted(calls, 100));
+
+    check(other.source == TileCache::Source::Miss && calls.load() == 2,
+          "one coordinate in two tilesets is two tiles");
+}
+
+void test_the_budget_holds_and_the_oldest_goes()
+{
+    map_server::Tileset socal;
+    const std::uint64_t each = 1000 + TileCache::kEntryOverheadBytes;
+    TileCache cache(3 * each);
+    std::atomic<int> calls { 0 };
+
+    const TileKey a { &socal, 12, 0, 0 };
+    const TileKey b { &socal, 12, 0, 1 };
+    const TileKey c { &socal, 12, 0, 2 };
+    const TileKey d { &socal, 12, 0, 3 };
+
+    cache.get(a, counted(calls, 1000));
+    cache.get(b, counted(calls, 1000));
+    cache.get(c, counted(calls, 1000));
+
+    // Touch `a`, so `b` is now the least recently used.
+    cache.get(a, counted(calls, 1000));
+    cache.get(d, counted(calls, 1000));
+
+    const TileCache::Stats stats = cache.stats();
+    check(stats.bytes <= stats.maxBytes, "the byte budget holds");
+    check(stats.entries == 3 && stats.evictions == 1, "one tile made way for the fourth");
+
+    calls.store(0);
+    check(cache.get(a, counted(calls, 1000)).source == TileCache::Source::Hit,
+          "the tile asked for again survived");
+    check(cache.get(b, counted(calls, 1000)).source == TileCache::Source::Miss,
+          "the least recently used one was evicted");
+
+    TileCache small(500);
+    std::atomic<int> bigCalls { 0 };
+    const TileKey big { &socal, 14, 0, 0 };
+    small.get(big, counted(bigCalls, 4000));
+    const auto twice = small.get(big, counted(bigCalls, 4000));
+    check(twice.tile && (*twice.tile)->data.size() == 4000,
+          "a tile bigger than the budget is still answered");
+    check(small.stats().entries == 0 && small.stats().bytes == 0, "but is not kept");
+}
+
+void test_errors_are_shared_but_not_cached()
+{
+    map_server::Tileset socal;
+    TileCache cache(1 << 20);
+    std::atomic<int> calls { 0 };
+    const TileKey key { &socal, 8, 1, 1 };
+
+    const auto failing = [&calls]() -> mbtiles::Result<TileCache::Answer> {
+        calls.fetch_add(1);
+        return mbtiles::query_error("disk went away");
+    };
+    const auto first = cache.get(key, failing);
+    check(!first.tile && first.tile.error().kind == mbtiles::Error::Kind::Query,
+          "an archive error comes back as an error");
+
+    const auto recovered = cache.get(key, counted(calls, 10));
+    check(recovered.source == TileCache::Source::Miss && recovered.tile,
+          "the next ask tries the archive again rather than repeating the failure");
+    check(calls.load() == 2, "which is a second read");
+
+    const auto throwing = []() -> mbtiles::Result<TileCache::Answer> {
+        throw std::runtime_error("sqlite exploded");
+    };
+    const auto thrown = cache.get(TileKey { &socal, 8, 2, 2 }, throwing);
+    check(!thrown.tile, "a load that throws is an error, not a hang");
+}
+
+void test_a_burst_for_one_tile_is_one_read()
+{
+    // The case the class exists for: several clients, one tile, one moment.
+    map_server::Tileset socal;
+    TileCache cache(1 << 20);
+    std::atomic<int> calls { 0 };
+    std::atomic<bool> go { false };
+    const TileKey key { &socal, 14, 2828, 6562 };
+
+    // Slow enough that every thread arrives while the first is still reading.
+    const TileCache::Load slow = [&calls]() -> mbtiles::Result<TileCache::Answer> {
+        calls.fetch_add(1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        auto tile = std::make_shared<CachedTile>();
+        tile->present = true;
+        tile->data.assign(81958, 0x1f);
+        return tile;
+    };
+
+    constexpr int kClients = 8;
+    std::vector<TileCache::Source> sources(kClients);
+    std::vector<std::size_t> sizes(kClients, 0);
+    std::vector<std::thread> clients;
+    for (int i = 0; i < kClients; ++i)
+    {
+        clients.emplace_back([&, i]() {
+            while (!go.load())
+            {
+            }
+            const auto lookup = cache.get(key, slow);
+            sources[static_cast<std::size_t>(i)] = lookup.source;
+            sizes[static_cast<std::size_t>(i)] = lookup.tile ? (*lookup.tile)->data.size() : 0;
+        });
+    }
+    go.store(true);
+    for (std::thread& client : clients)
+    {
+        client.join();
+    }
+
+    int misses = 0;
+    int shared = 0;
+    bool allAnswered = true;
+    for (int i = 0; i < kClients; ++i)
+    {
+        misses += sources[static_cast<std::size_t>(i)] == TileCache::Source::Miss ? 1 : 0;
+        shared += sources[static_cast<std::size_t>(i)] == TileCache::Source::Shared ? 1 : 0;
+        allAnswered = allAnswered && sizes[static_cast<std::size_t>(i)] == 81958;
+    }
+
+    check(calls.load() == 1, "eight concurrent asks for one tile read the archive once");
+    check(misses == 1, "exactly one of them did the reading");
+    check(shared > 0, "the others waited on that read rather than starting their own");
+    check(allAnswered, "and every one of them got the whole tile");
+}
+
+} // namespace
+
+int main()
+{
+    spdlog::set_level(spdlog::level::info);
+    spdlog::set_pattern("[%^%l%$] %v");
+
+    test_a_second_ask_is_a_hit();
+    test_absence_is_cached_too();
+    test_tilesets_do_not_share_entries();
+    test_the_budget_holds_and_the_oldest_goes();
+    test_errors_are_shared_but_not_cached();
+    test_a_burst_for_one_tile_is_one_read();
+
+    if (failures != 0)
+    {
+        SPDLOG_ERROR("{} check(s) failed", failures);
+        return 1;
+    }
+
+    SPDLOG_INFO("all tile cache checks passed");
+    return 0;
+}
@@ -0,0 +1,106 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "tile_cache.h"
+
+#include <exception>
+#include <functional>
+#include <utility>
+
+namespace map_server
+{
+
+std::size_t TileCache::KeyHash::operator()(const TileKey& key) const
+{
+    // x and y are below 2^22 and z below 32, so the three pack into one 64-bit
+    // value without overlapping; the tileset is mixed in on top.
+    const std::uint64_t packed = (static_cast<std::uint64_t>(key.z) << 58) ^
+                                 (static_cast<std::uint64_t>(key.x) << 29) ^ key.y;
+    return std::hash<std::uint64_t> {}(packed) ^
+           (std::hash<const void*> {}(key.tileset) * 0x9e3779b97f4a7c15ULL);
+}
+
+TileCache::TileCache(std::uint64_t maxBytes) : mMaxBytes(maxBytes)
+{
+}
+
+TileCache::Lookup TileCache::get(const TileKey& key, const Load& load)
+{
+    std::shared_ptr<Flight> flight;
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+
+        if (const auto found = mIndex.find(key); found != mIndex.end())
+        {
+            mLru.splice(mLru.begin(), mLru, found->second);
+            return Lookup { found->second->tile, Source::Hit };
+        }
+
+        if (const auto running = mFlights.find(key); running != mFlights.end())
+        {
+            const std::shared_ptr<Flight> shared = running->second;
+            mSettled.wait(lock, [&shared]() { return shared->done; });
+            return Lookup { shared->result, Source::Shared };
+        }
+
+        flight = std::make_shared<Flight>();
+        mFlights.emplace(key, flight);
+    }
+
+    // Unlocked: this is the SQLite read the whole class exists to do less of,
+    // and other tiles must not queue behind it.
+    mbtiles::Result<Answer> result { Answer() };
+    try
+    {
+        result = load();
+    }
+    catch (const std::exception& e)
+    {
+        // The flight must settle whatever happens, or every waiter on this
+        // tile waits forever.
+        result = mbtiles::query_error(std::string("reading the tile threw: ") + e.what());
+    }
+
+    {
+        const std::lock_guard<std::mutex> guard(mMutex);
+        if (result && *result)
+        {
+            insert(key, *result);
+        }
+        flight->result = result;
+        flight->done = true;
+        mFlights.erase(key);
+    }
+    mSettled.notify_all();
+
+    return Lookup { std::move(result), Source::Miss };
+}
+
+void TileCache::insert(const TileKey& key, const Answer& tile)
+{
+    const std::uint64_t cost = tile->data.size() + kEntryOverheadBytes;
+    if (cost > mMaxBytes)
+    {
+        return;
+    }
+
+    while (mBytes + cost > mMaxBytes && !mLru.empty())
+    {
+        const Entry& oldest = mLru.back();
+        mBytes -= oldest.cost;
+        mIndex.erase(oldest.key);
+        mLru.pop_back();
+        ++mEvictions;
+    }
+
+    mLru.push_front(Entry { key, tile, cost });
+    mIndex.emplace(key, mLru.begin());
+    mBytes += cost;
+}
+
+TileCache::Stats TileCache::stats() const
+{
+    const std::lock_guard<std::mutex> guard(mMutex);
+    return Stats { mBytes, mMaxBytes, mIndex.size(), mEvictions };
+}
+
+} // namespace map_server
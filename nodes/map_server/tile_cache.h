@@ -0,0 +1,153 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//
+// Recently served tiles, in front of the archives.
+//
+// After every pan, every client with a map on screen asks for the tiles under
+// its viewport -- two dashboard windows, the editor and scope's map panel all
+// asking for the same ones within a few milliseconds of each other. Each of
+// those was a SQLite step and a copy of the blob out of it, once per client,
+// for bytes that had not changed since the archive was built.
+//
+// Two things, in one lock:
+//
+//   * a byte-bounded LRU of tile answers, absent tiles included. Most of the
+//     pyramid is empty, so "nothing there" is the commonest answer and just as
+//     worth remembering; it is charged a fixed overhead rather than nothing so
+//     a flood of misses cannot grow the cache without bound.
+//
+//   * single flight. A request for a tile another thread is already reading
+//     waits for that read and shares its answer, rather than racing it to the
+//     archive -- which is exactly the shape of the burst above, and the case a
+//     plain cache does nothing for: every one of those requests is a miss.
+//
+// Errors are handed to every waiter but never cached. An archive that failed a
+// query may succeed on the next one, and a cached failure would outlive the
+// problem that caused it.
+#ifndef MAP_SERVER_TILE_CACHE_H
+#define MAP_SERVER_TILE_CACHE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "mbtiles/archive.h"
+
+namespace map_server
+{
+
+struct Tileset;
+
+struct TileKey
+{
+    const Tileset* tileset { nullptr };
+    std::uint8_t z { 0 };
+    std::uint32_t x { 0 };
+    std::uint32_t y { 0 };
+
+    bool operator==(const TileKey&) const = default;
+};
+
+// One archive answer, as it was read. Immutable once cached, and shared by
+// pointer, so a reader copying it into a reply holds no lock while it does.
+struct CachedTile
+{
+    // False for "the archive has no tile there".
+    bool present { false };
+    mbtiles::Encoding encoding { mbtiles::Encoding::Identity };
+    std::vector<std::uint8_t> data;
+};
+
+class TileCache
+{
+  public:
+    // What a tile costs against the budget beyond its bytes: the entry, its
+    // index node and the shared_ptr's control block, roughly.
+    static constexpr std::uint64_t kEntryOverheadBytes = 128;
+
+    // How an answer was come by, for the counters.
+    enum class Source
+    {
+        // Already cached.
+        Hit,
+        // Read from the archive by this call.
+        Miss,
+        // Another call was already reading it; this one waited and shared.
+        Shared,
+    };
+
+    using Answer = std::shared_ptr<const CachedTile>;
+    using Load = std::function<mbtiles::Result<Answer>()>;
+
+    struct Lookup
+    {
+        mbtiles::Result<Answer> tile;
+        Source source { Source::Miss };
+    };
+
+    struct Stats
+    {
+        std::uint64_t bytes { 0 };
+        std::uint64_t maxBytes { 0 };
+        std::uint64_t entries { 0 };
+        std::uint64_t evictions { 0 };
+    };
+
+    // `maxBytes` must be non-zero; a node with no cache has no TileCache.
+    explicit TileCache(std::uint64_t maxBytes);
+
+    TileCache(const TileCache&) = delete;
+    TileCache& operator=(const TileCache&) = delete;
+
+    // The answer for `key`: from the cache, from a read already in flight, or
+    // from `load`, which runs on this thread with no lock held. A tile bigger
+    // than the whole budget is answered and not kept.
+    Lookup get(const TileKey& key, const Load& load);
+
+    Stats stats() const;
+
+  private:
+    struct KeyHash
+    {
+        std::size_t operator()(const TileKey& key) const;
+    };
+
+    struct Entry
+    {
+        TileKey key;
+        Answer tile;
+        std::uint64_t cost { 0 };
+    };
+
+    // Filled in by whichever call is reading; `done` under mMutex.
+    struct Flight
+    {
+        bool done { false };
+        mbtiles::Result<Answer> result { Answer() };
+    };
+
+    // Under mMutex.
+    void insert(const TileKey& key, const Answer& tile);
+
+    const std::uint64_t mMaxBytes;
+
+    mutable std::mutex mMutex;
+    std::condition_variable mSettled;
+
+    // Most recently used at the front.
+    std::list<Entry> mLru;
+    std::unordered_map<TileKey, std::list<Entry>::iterator, KeyHash> mIndex;
+    std::unordered_map<TileKey, std::shared_ptr<Flight>, KeyHash> mFlights;
+
+    std::uint64_t mBytes { 0 };
+    std::uint64_t mEvictions { 0 };
+};
+
+} // namespace map_server
+
+#endif // MAP_SERVER_TILE_CACHE_H
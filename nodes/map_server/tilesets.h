@@ -37,6 +37,13 @@ struct Tileset
     std::atomic<std::uint64_t> served { 0 };
     std::atomic<std::uint64_t> missing { 0 };
     std::atomic<std::uint64_t> bytes { 0 };
+
+    // How each in-range tile was answered: from the tile cache, by reading the
+    // archive, or by waiting on a read another request had already started.
+    // All zero when the cache is off. See tile_cache.h.
+    std::atomic<std::uint64_t> cacheHits { 0 };
+    std::atomic<std::uint64_t> cacheMisses { 0 };
+    std::atomic<std::uint64_t> cacheShared { 0 };
 };
 
 // Whether a coordinate is one this archive could hold, and if not, why not.
@@ -2,8 +2,7 @@
 
 #include "pub_sub/node_identity.h"
 #include "pub_sub/zenoh_publisher.h"
-#include "pub_sub/zenoh_subscriber.h"
-#include "can_frame.capnp.h"
+#include "can_topic/frame_subscriber.h"
 #include "megasquirt.capnp.h"
 
 #include <span>
@@ -68,6 +67,7 @@ int main(int argc, char** argv)
 
     cxxopts::Options options("megasquirt", "Megasquirt dash node");
     options.add_options()
+        ("s,source", "Zenoh key to subscribe to CAN frames on, per-frame or batched", cxxopts::value<std::string>()->default_value("vehicle/can0/rx"))
         ("h,help", "Print usage");
 
     auto result = options.parse(argc, argv);
@@ -98,24 +98,17 @@ int main(int argc, char** argv)
         publish_dash(db, dash_pub);
     });
 
-    pub_sub::ZenohTypedSubscriber<CanFrame> can_subscriber(
-        "vehicle/can0/rx",
-        [&parser](CanFrame::Reader frame)
+    const std::string can_key = result["source"].as<std::string>();
+    SPDLOG_INFO("Subscribing to CAN frames on key '{}'", can_key);
+    can_topic::FrameSubscriber can_subscriber(
+        can_key,
+        [&parser](const helpers::CanFrame& frame, std::string_view)
         {
-            uint32_t id = frame.getId();
-            uint8_t len = frame.getLen();
-            auto dataList = frame.getData();
-
-            std::array<uint8_t, 8u> bytes{};
-            const size_t n = std::min<size_t>(8u, std::min<size_t>(len, dataList.size()));
-            for (size_t i = 0; i < n; ++i)
-            {
-                bytes[i] = static_cast<uint8_t>(dataList[i]);
-            }
-            // The real length, not the padded buffer: a frame shorter than the
+            // The real length, not a padded buffer: a frame shorter than the
             // message it claims to be must be rejected, not decoded as though
-            // the padding were readings.
-            parser.handle_can_frame(id, std::span<const uint8_t>(bytes.data(), n));
+            // the padding were readings. Classic CAN only, so at most eight.
+            const auto payload = frame.data_span();
+            parser.handle_can_frame(frame.id, payload.first(std::min<size_t>(payload.size(), 8u)));
         });
 
     for (;;)
@@ -4,8 +4,7 @@
 #include "racegrade_tc8_configure.capnp.h"
 #include "racegrade_tc8_signals.capnp.h"
 #include "dbc_motec_e888_rev1_parser.h"
-#include "pub_sub/zenoh_subscriber.h"
-#include "can_frame.capnp.h"
+#include "can_topic/frame_subscriber.h"
 
 #include <span>
 #include <cxxopts.hpp>
@@ -13,6 +12,7 @@
 #include "core/core.h"
 #include <zenoh.hxx>
 
+#include <algorithm>
 #include <array>
 #include <thread>
 #include <chrono>
@@ -82,6 +82,7 @@ int main(int argc, char** argv)
     // the program that owns the options.
     cxxopts::Options options("racegrade_tc8", "RaceGrade TC8 node");
     options.add_options()
+        ("s,source", "Zenoh key to subscribe to CAN frames on, per-frame or batched", cxxopts::value<std::string>()->default_value("vehicle/can0/rx"))
         ("debug", "Enable debug logging.",
             cxxopts::value<bool>()->default_value("false")->implicit_value("true"))
         ("h,help", "Print usage");
@@ -131,25 +132,18 @@ int main(int argc, char** argv)
     pub_sub::ZenohService<RaceGradeTc8ConfigureRequest, RaceGradeTc8ConfigureResponse> service(
         keyexpr, handle_service_request);
 
+    const std::string can_key = args["source"].as<std::string>();
+    SPDLOG_INFO("Subscribing to CAN frames on key '{}'", can_key);
     // Subscribe to CAN frames and feed parser using typed subscriber
-    pub_sub::ZenohTypedSubscriber<CanFrame> can_subscriber(
-        "vehicle/can0/rx",
-        [&parser](CanFrame::Reader frame)
+    can_topic::FrameSubscriber can_subscriber(
+        can_key,
+        [&parser](const helpers::CanFrame& frame, std::string_view)
         {
-            uint32_t id = frame.getId();
-            uint8_t len = frame.getLen();
-            auto dataList = frame.getData();
-
-            std::array<uint8_t, 8u> bytes{};
-            const size_t n = std::min<size_t>(8u, std::min<size_t>(len, dataList.size()));
-            for (size_t i = 0; i < n; ++i)
-            {
-                bytes[i] = static_cast<uint8_t>(dataList[i]);
-            }
-            // The real length, not the padded buffer: a frame shorter than the
+            // The real length, not a padded buffer: a frame shorter than the
             // message it claims to be must be rejected, not decoded as though
-            // the padding were readings.
-            parser.handle_can_frame(id, std::span<const uint8_t>(bytes.data(), n));
+            // the padding were readings. Classic CAN only, so at most eight.
+            const auto payload = frame.data_span();
+            parser.handle_can_frame(frame.id, payload.first(std::min<size_t>(payload.size(), 8u)));
         });
 
     // Keep the process alive; Ctrl+C to exit
@@ -0,0 +1,156 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//
+// What decimating one trace costs per frame, by how much of the history is in
+// view.
+//
+// NOT a test -- it asserts nothing and always exits 0. It exists because the
+// claim the min/max pyramid in SampleHistory makes -- a frame costs about the
+// same zoomed all the way out as zoomed in -- is a claim about time, and only a
+// measurement shows it. test_decimate is what shows the answers are right.
+//
+// One history at the time-series panel's retention cap, filled with a 1 kHz
+// signal, decimated over windows from one second to the whole of it:
+//
+//   scope_bench_decimate
+//   scope_bench_decimate --columns 3840 --frames 500
+//
+// What each column means:
+//
+//   walk      a frame through the per-sample walk decimateMinMax() did before
+//             the pyramid, kept here as the baseline
+//   pyramid   a frame through decimateMinMax() as it is
+//
+// `walk` grows in proportion to the span. `pyramid` should stop growing once
+// the window holds a few buckets per column: past that the only span-dependent
+// work is splitting the buckets that straddle a column boundary, a step per
+// level per column. A `pyramid` that tracks `walk` means the level choice is
+// reading buckets finer than a column needs.
+
+#include "scope/decimate.h"
+#include "scope/sample_ring.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+// The same cap time_series_panel.cpp retains per signal.
+constexpr std::size_t kHistoryPoints = 600000;
+constexpr double kRateHz = 1000.0;
+
+// decimateMinMax() as it was: every sample in the window, one at a time.
+std::size_t walk(const scope::SampleHistory& history, double t_begin, double t_end,
+                 std::size_t columns, std::vector<scope::ColumnStats>& out)
+{
+    out.assign(columns, scope::ColumnStats{});
+    const double span = t_end - t_begin;
+
+    std::size_t filled = 0;
+    for (std::size_t i = history.lowerBound(t_begin); i < history.size(); ++i)
+    {
+        const scope::Sample& sample = history[i];
+        if (sample.t > t_end)
+        {
+            break;
+        }
+        const double position = (sample.t - t_begin) / span * static_cast<double>(columns);
+        const std::size_t column =
+            position > 0.0 ? std::min(static_cast<std::size_t>(position), columns - 1) : 0;
+
+        scope::ColumnStats& stats = out[column];
+        if (!stats.has_data)
+        {
+            stats = {true, sample.v, sample.v, sample.v, sample.v};
+            ++filled;
+            continue;
+        }
+        stats.min = std::min(stats.min, sample.v);
+        stats.max = std::max(stats.max, sample.v);
+        stats.last = sample.v;
+    }
+    return filled;
+}
+
+// Mean microseconds per frame over `frames` frames. The window slides by a
+// fraction of a column each frame, as it does during playback, so bucket
+// alignment against the column grid is not the same every time.
+template <typename Decimate>
+double timeFrames(const Decimate& decimate, double t_end, double span, std::size_t columns,
+                  int frames, std::size_t& sink)
+{
+    std::vector<scope::ColumnStats> out;
+    const double step = span / static_cast<double>(columns) / 7.0;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        const double end = t_end - step * static_cast<double>(frame % 7);
+        sink += decimate(end - span, end, columns, out);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::micro>(elapsed).count() / frames;
+}
+
+std::string argumentAfter(int argc, char** argv, const std::string& flag,
+                          const std::string& fallback)
+{
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (flag == argv[i])
+        {
+            return argv[i + 1];
+        }
+    }
+    return fallback;
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    const auto columns = static_cast<std::size_t>(
+        std::max(1, std::atoi(argumentAfter(argc, argv, "--columns", "1920").c_str())));
+    const int frames = std::max(1, std::atoi(argumentAfter(argc, argv, "--frames", "200").c_str()));
+
+    scope::SampleHistory history(kHistoryPoints);
+    for (std::size_t i = 0; i < kHistoryPoints; ++i)
+    {
+        // A slow wave with a spike every few thousand samples: what a plot is
+        // opened to find, and what the pyramid must not lose.
+        const double t = static_cast<double>(i) / kRateHz;
+        const double spike = (i % 4099 == 0) ? 50.0 : 0.0;
+        history.append({t, std::sin(t * 0.5) * 10.0 + spike});
+    }
+    const double t_end = history.newest().t;
+
+    SPDLOG_INFO("{} samples at {} Hz, {} columns, {} frames per span", kHistoryPoints, kRateHz,
+                columns, frames);
+
+    std::size_t sink = 0;
+    for (const double span : {1.0, 10.0, 60.0, 300.0, 600.0})
+    {
+        const double walked = timeFrames(
+            [&](double b, double e, std::size_t c, std::vector<scope::ColumnStats>& out)
+            { return walk(history, b, e, c, out); },
+            t_end, span, columns, frames, sink);
+        const double pyramid = timeFrames(
+            [&](double b, double e, std::size_t c, std::vector<scope::ColumnStats>& out)
+            { return scope::decimateMinMax(history, b, e, c, out); },
+            t_end, span, columns, frames, sink);
+
+        SPDLOG_INFO("  span {:6.0f} s  {:7} samples   walk {:9.1f} us   pyramid {:7.1f} us", span,
+                    static_cast<std::size_t>(span * kRateHz), walked, pyramid);
+    }
+
+    // Keeps the optimiser from deciding the frames were never looked at.
+    SPDLOG_DEBUG("{}", sink);
+    return 0;
+}
@@ -24,53 +24,101 @@ std::size_t decimateMinMax(const SampleHistory& history,
 
     const double span = t_end - t_begin;
 
-    // Start at the first sample inside the window rather than at the beginning
-    // of the history. This is the whole reason the history supports a binary
-    // search, and it is what makes the cost depend on the window rather than on
-    // how much is retained.
-    const std::size_t start = history.lowerBound(t_begin);
+    // Only the samples inside the window are looked at. This is the whole
+    // reason the history supports a binary search, and it is what makes the
+    // cost depend on the window rather than on how much is retained.
+    const std::size_t begin = history.lowerBound(t_begin);
+    const std::size_t end = history.upperBound(t_end);
 
-    std::size_t filled = 0;
-    for (std::size_t i = start; i < history.size(); ++i)
-    {
-        const Sample& sample = history[i];
-        if (sample.t > t_end)
-        {
-            // Times are non-decreasing, so the first sample past the right edge
-            // means every later one is too.
-            break;
-        }
-
-        // The clamp matters at both ends. A sample exactly at t_end would index
-        // one past the last column, and floating-point error near a boundary
-        // can land just outside either way -- dropping the newest sample off
-        // the right edge of every frame is exactly the kind of fault that looks
-        // like the data rather than like a bug.
-        const double position = (sample.t - t_begin) / span * static_cast<double>(columns);
+    // The clamp matters at both ends. A sample exactly at t_end would index one
+    // past the last column, and floating-point error near a boundary can land
+    // just outside either way -- dropping the newest sample off the right edge
+    // of every frame is exactly the kind of fault that looks like the data
+    // rather than like a bug.
+    //
+    // It is also monotonic in t, and that is what makes reading the pyramid
+    // exact: a run of samples whose first and last land in the same column
+    // lies entirely in it.
+    const auto columnOf = [&](double t) {
+        const double position = (t - t_begin) / span * static_cast<double>(columns);
         std::size_t column = 0;
         if (position > 0.0)
         {
             column = static_cast<std::size_t>(position);
             column = std::min(column, columns - 1);
         }
+        return column;
+    };
 
+    std::size_t filled = 0;
+    const auto merge = [&](std::size_t column, double min, double max, double first, double last) {
         ColumnStats& stats = out[column];
         if (!stats.has_data)
         {
-            stats.has_data = true;
-            stats.min = sample.v;
-            stats.max = sample.v;
-            stats.first = sample.v;
-            stats.last = sample.v;
+            stats = {true, min, max, first, last};
             ++filled;
-            continue;
+            return;
         }
 
-        stats.min = std::min(stats.min, sample.v);
-        stats.max = std::max(stats.max, sample.v);
-        // Samples arrive in time order, so the last one seen for a column is
-        // the latest one in it.
-        stats.last = sample.v;
+        stats.min = std::min(stats.min, min);
+        stats.max = std::max(stats.max, max);
+        // Runs are merged in time order, so the last one seen for a column
+        // holds the latest sample in it.
+        stats.last = last;
+    };
+
+    // The coarsest level that still puts at least one bucket in each column.
+    // Any coarser and most buckets would straddle a column boundary and have
+    // to be split; any finer and there is simply more of them to read. Below
+    // the first level the window is at most a few samples per column, and
+    // walking them is cheaper than asking.
+    unsigned top = 0;
+    for (std::size_t per_column = (end - begin) / columns; per_column > 1; per_column >>= 1)
+    {
+        ++top;
+    }
+    top = std::min(top, history.maxSummaryLevel());
+
+    std::size_t i = begin;
+    while (i < end)
+    {
+        // The largest bucket that starts here, fits in the window and falls in
+        // one column. Where a bucket straddles a boundary the next level down
+        // is tried, so the split costs a handful of steps per column rather
+        // than a walk of the bucket.
+        unsigned level = std::min(top, history.summaryAlignment(i));
+        for (; level >= SampleHistory::kFirstSummaryLevel; --level)
+        {
+            const std::size_t width = std::size_t{1} << level;
+            if (end - i < width)
+            {
+                continue;
+            }
+            const SampleHistory::Extent& bucket = history.summary(i, level);
+            const std::size_t column = columnOf(bucket.t_first);
+            if (column != columnOf(bucket.t_last))
+            {
+                continue;
+            }
+
+            merge(column, bucket.min, bucket.max, bucket.first, bucket.last);
+            i += width;
+            break;
+        }
+
+        if (level < SampleHistory::kFirstSummaryLevel)
+        {
+            // No bucket to read here, and none until the next one starts, so
+            // walk the samples up to it without asking again at each.
+            const bool walk_all = top < SampleHistory::kFirstSummaryLevel;
+            do
+            {
+                const Sample& sample = history[i];
+                merge(columnOf(sample.t), sample.v, sample.v, sample.v, sample.v);
+                ++i;
+            } while (i < end &&
+                     (walk_all || history.summaryAlignment(i) < SampleHistory::kFirstSummaryLevel));
+        }
     }
 
     return filled;
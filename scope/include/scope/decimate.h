@@ -32,8 +32,10 @@ struct ColumnStats
 //
 // This is what keeps a plot cheap regardless of how much is retained: the work
 // per frame is bounded by the width of the widget, not by the number of
-// samples. A window holding a million points costs one binary search plus a
-// walk of only the points actually inside it.
+// samples. A window holding a million points costs two binary searches plus a
+// walk of the history's min/max pyramid at the coarsest level that still puts a
+// bucket in every column -- a few thousand steps at any zoom, where walking the
+// points themselves grew with the span. The result is identical to walking them.
 //
 // `out` is resized to `columns` and fully overwritten, so a caller can keep one
 // vector across frames and never allocate. Returns how many columns got data,
@@ -15,10 +15,10 @@ namespace scope
 // A DataSource over the live zenoh bus.
 //
 // One subscription per distinct key, however many signals are bound to it. Ten
-// fields of one MoTeC topic on screen means one subscription and ten
-// expressions evaluated per sample, not ten subscriptions each decoding the
-// same message. That is what pub_sub::RawSubscriber and the standalone
-// ExpressionEvaluator exist for.
+// fields of one MoTeC topic on screen means one subscription, one decode and
+// ten expressions evaluated per sample, not ten subscriptions each decoding the
+// same message. That is what pub_sub::RawSubscriber and
+// pub_sub::ExpressionEvaluatorSet exist for.
 //
 // TIMESTAMPS. Samples are stamped with std::chrono::steady_clock on arrival,
 // as seconds since this object was constructed.
@@ -5,6 +5,7 @@
 
 #include "bag/reader.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <functional>
 #include <memory>
@@ -31,15 +32,46 @@ class RecordedProvider
 
     // Visit every message with `t0_ns <= log_time <= t1_ns`, in log_time order.
     //
-    // Called once per bound signal, on a background thread, never per frame.
-    // That is a requirement rather than an observation: BagReader::forEach
-    // constructs and opens an mcap::McapReader per part per call, and on a part
-    // with no summary it falls back to scanning the whole data section. Driven
-    // from a slider it would re-open files thirty times a second and re-scan a
-    // torn recording every one of them.
+    // Called once per batch of bound signals, on a background thread, never per
+    // frame. That is a requirement rather than an observation: even with
+    // BagFileProvider's cached reader, a window it has not seen is chunks to
+    // decompress, and on a part with no summary BagReader falls back to
+    // scanning the whole data section -- uncached, every call. Driven from a
+    // slider it would re-scan a torn recording thirty times a second.
     virtual void forEach(std::uint64_t t0_ns, std::uint64_t t1_ns,
                          const std::function<void(const bag::BagMessage&)>& visit) = 0;
 
+    // forEach(), for the messages on `topics` only. Every pass in
+    // RecordedSource knows which topics it decodes, and says so here, because
+    // a provider that can find a topic without reading past the others should
+    // get the chance. The default cannot, and filters forEach().
+    virtual void forEachOnTopics(std::uint64_t t0_ns, std::uint64_t t1_ns,
+                                 const std::vector<std::string>& topics,
+                                 const std::function<void(const bag::BagMessage&)>& visit)
+    {
+        forEach(t0_ns, t1_ns,
+                [&](const bag::BagMessage& message)
+                {
+                    if (std::find(topics.begin(), topics.end(), message.key) != topics.end())
+                    {
+                        visit(message);
+                    }
+                });
+    }
+
+    // Closed [t0_ns, t1_ns] ranges that tile the recording in time order and
+    // may be handed to forEach() from several threads AT ONCE, one range per
+    // call. Every message falls in exactly one of them.
+    //
+    // The default is empty, which means forEach() is not safe to call
+    // concurrently -- or there is nothing to gain -- and a decode reads the
+    // recording in one call. A provider says yes only when each call has its
+    // own file handles and decompression buffers, or shares them under a lock.
+    virtual std::vector<std::pair<std::uint64_t, std::uint64_t>> concurrentRanges() const
+    {
+        return {};
+    }
+
     // What the recording contains, from its index -- not by reading messages.
     virtual std::vector<TopicInfo> topics() const = 0;
 
@@ -90,9 +122,28 @@ class BagFileProvider : public RecordedProvider
 
     void forEach(std::uint64_t t0_ns, std::uint64_t t1_ns,
                  const std::function<void(const bag::BagMessage&)>& visit) override;
+
+    // Through BagReader's topic overload, which opens only the chunks the
+    // topics' message indexes place them in. Binding one 1 Hz signal in a
+    // recording with video on it decompresses the signal's chunks, not the
+    // video's.
+    void forEachOnTopics(std::uint64_t t0_ns, std::uint64_t t1_ns,
+                         const std::vector<std::string>& topics,
+                         const std::function<void(const bag::BagMessage&)>& visit) override;
+
     std::vector<TopicInfo> topics() const override;
     std::pair<std::uint64_t, std::uint64_t> spanNanos() const override;
 
+    // One range per part, split at each part's first log_time. Parts are
+    // separate MCAP files, so reading two at once shares nothing but the
+    // reader's chunk cache -- and each one's chunk decompression, which is
+    // most of what a decode pass costs, lands on its own core.
+    //
+    // Empty for a single part, and for a recording with a part whose time
+    // range the index does not know (a torn part with no message count): a
+    // range boundary cannot be drawn through a part nobody can place.
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> concurrentRanges() const override;
+
     // From the PART INDEX in metadata.yaml, opening no file at all. Each part
     // carries a message_count and a [t_begin, t_end], so its count is spread
     // uniformly across the buckets its own span overlaps.
@@ -116,13 +167,21 @@ class BagFileProvider : public RecordedProvider
 // from the live one to everything above it.
 //
 // DECODE ONCE PER SIGNAL, NOT ONCE PER SCRUB TICK. This is the load-bearing
-// decision and the reason the class is shaped the way it is. bind() starts a
-// single pass over the whole recording on a background thread, evaluating that
+// decision and the reason the class is shaped the way it is. bind() queues a
+// pass over the whole recording on a background thread, evaluating that
 // signal's expression into a flat std::vector<Sample> held here. Seeking is
 // then a slice out of that vector. The cost is modest -- four hours of a 25 Hz
 // signal is 360k samples, under 6 MB -- and the alternative is re-reading and
 // re-decoding the file on every frame of a drag.
 //
+// AND ONE PASS PER BATCH, NOT PER SIGNAL. Every signal bound while a pass is
+// queued or running joins the next one, which evaluates all of their
+// expressions against each message of their topic. Loading a 40-signal
+// workspace reads the recording once or twice rather than forty times. Where
+// the provider allows it (concurrentRanges) the pass is split across threads,
+// so it scales with the recording's size and the machine's cores rather than
+// with the number of traces.
+//
 // The pass is asynchronous, so bind() returns a usable handle before any data
 // exists. A trace is simply empty until its decode finishes, which is the same
 // state a live signal is in before its publisher says anything, and every panel
@@ -2,6 +2,7 @@
 #define SCOPE_SAMPLE_RING_H_
 
 #include <atomic>
+#include <bit>
 #include <cstddef>
 #include <cstdint>
 #include <span>
@@ -86,9 +87,43 @@ class StagingRing
 // two things a deque makes awkward: a binary search for the first sample in the
 // visible window, and a tight index walk from there. Logical index 0 is the
 // oldest retained sample.
+//
+// ALONGSIDE THE SAMPLES, A MIN/MAX PYRAMID. Level L holds the value extent of
+// every run of 2^L samples, aligned to the count of samples appended since the
+// last clear() rather than to the ring's storage, so neither wrapping nor
+// trimming moves a bucket. Without it a plot zoomed out over a long recording
+// walks every sample in the window on every frame -- 600k of them for a
+// full-retention trace -- and the frame time grows with the span instead of
+// with the widget. decimateMinMax() reads whole buckets wherever one falls
+// inside a single pixel column.
+//
+// Kept up on append() at amortised O(1): a bucket is computed once, when its
+// last sample arrives, from the two halves below it. Only COMPLETE buckets
+// whose samples are all still retained are ever read, which is what lets a
+// trim or an overwrite leave stale entries behind without invalidating them.
+// Levels start at kFirstSummaryLevel because the finest ones cost the most
+// memory and save the least walking; as it is, the pyramid adds about half
+// again to the history's footprint.
 class SampleHistory
 {
   public:
+    // One bucket: the value range of its samples, plus the times and values at
+    // either end. The ends are copies of samples the history holds, but reading
+    // them from there would be two scattered loads per bucket out of a
+    // multi-megabyte ring, and that -- not the arithmetic -- is what a
+    // zoomed-out frame would spend its time on.
+    struct Extent
+    {
+        double t_first = 0.0;
+        double t_last = 0.0;
+        double min = 0.0;
+        double max = 0.0;
+        double first = 0.0;
+        double last = 0.0;
+    };
+
+    static constexpr unsigned kFirstSummaryLevel = 4;
+
     explicit SampleHistory(std::size_t capacity);
 
     // Overwrites the oldest sample when full. That is the right behaviour here,
@@ -101,9 +136,14 @@ class SampleHistory
     std::size_t capacity() const { return slots_.size(); }
 
     // `index` is logical: 0 is the oldest retained sample, size()-1 the newest.
+    //
+    // A compare rather than a modulo: head_ and `index` are both below the
+    // capacity, so the sum wraps at most once, and a division per sample is a
+    // real share of a decimation walk.
     const Sample& operator[](std::size_t index) const
     {
-        return slots_[(head_ + index) % slots_.size()];
+        const std::size_t slot = head_ + index;
+        return slots_[slot < slots_.size() ? slot : slot - slots_.size()];
     }
 
     const Sample& oldest() const { return (*this)[0]; }
@@ -115,15 +155,57 @@ class SampleHistory
     // replays in order.
     std::size_t lowerBound(double t_min) const;
 
+    // Index of the first sample with t > `t_max`, or size(). Same precondition.
+    std::size_t upperBound(double t_max) const;
+
+    // The coarsest pyramid level kept, or 0 when the capacity is too small to
+    // have any -- in which case there is nothing to read and a caller walks
+    // samples.
+    unsigned maxSummaryLevel() const
+    {
+        return summary_.empty()
+                   ? 0
+                   : kFirstSummaryLevel + static_cast<unsigned>(summary_.size()) - 1;
+    }
+
+    // The coarsest level with a bucket starting at logical `index` -- any level
+    // at or below it has one too. Not clamped to maxSummaryLevel().
+    unsigned summaryAlignment(std::size_t index) const
+    {
+        return static_cast<unsigned>(std::countr_zero(first_seq_ + index));
+    }
+
+    // The extent of samples [index, index + 2^level). A bucket must start at
+    // `index` (summaryAlignment), the whole of it must be retained, and `level`
+    // must lie in [kFirstSummaryLevel, maxSummaryLevel()].
+    const Extent& summary(std::size_t index, unsigned level) const
+    {
+        const std::vector<Extent>& row = summary_[level - kFirstSummaryLevel];
+        return row[((first_seq_ + index) >> level) & (row.size() - 1)];
+    }
+
     // Drops everything older than `t_min`. O(number dropped).
     void trimOlderThan(double t_min);
 
     void clear();
 
   private:
+    // Fills in every bucket that the sample at sequence `seq` completes.
+    void summarise(std::uint64_t seq);
+
     std::vector<Sample> slots_;
     std::size_t head_ = 0;  // Index of the oldest sample.
     std::size_t size_ = 0;
+
+    // Samples appended since the last clear() before the oldest retained one:
+    // the sequence number of logical index 0, and what buckets are aligned to.
+    std::uint64_t first_seq_ = 0;
+
+    // summary_[L - kFirstSummaryLevel] is level L, itself a ring indexed by
+    // bucket number. At least two spare entries, so the newest bucket never
+    // reuses a slot whose bucket is still entirely retained, and a power of two
+    // so the index is a mask rather than a division.
+    std::vector<std::vector<Extent>> summary_;
 };
 
 // A bound signal's data: the lock-free hand-off from the producer, plus the
@@ -1,6 +1,6 @@
 #include "scope/live_zenoh_source.h"
 
-#include "pub_sub/expression_evaluator.h"
+#include "pub_sub/expression_binding_list.h"
 #include "pub_sub/raw_subscriber.h"
 #include "pub_sub/topic_directory.h"
 
@@ -8,6 +8,8 @@
 #include <spdlog/spdlog.h>
 
 #include <algorithm>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <utility>
 
@@ -26,11 +28,15 @@ namespace
 struct Binding
 {
     SignalHandle handle = kInvalidSignal;
-    std::unique_ptr<pub_sub::ExpressionEvaluator> evaluator;
+    pub_sub::schema_type_t schema_type{};
+    std::string expression;
     std::shared_ptr<SignalBuffer> buffer;
 };
 
-using BindingList = std::vector<std::shared_ptr<Binding>>;
+// Every numeric binding on a key, one evaluator set per schema among them. See
+// the header for why, and for the lock that lets zenoh run this key's callback
+// on more than one thread.
+using BindingList = pub_sub::ExpressionBindingList<Binding>;
 
 // A whole topic bound as bytes: no expression, no decode, just the payload and
 // whatever the consumer's classifier makes of it.
@@ -224,12 +230,26 @@ SignalHandle LiveZenohSource::bind(const SignalKey& key, std::shared_ptr<SignalB
         return kInvalidSignal;
     }
 
-    auto evaluator = std::make_unique<pub_sub::ExpressionEvaluator>(
-        key.schema_type, key.value_expression, key.zenoh_key);
+    auto binding = std::make_shared<Binding>();
+    binding->handle = impl_->next_handle;
+    binding->schema_type = key.schema_type;
+    binding->expression = key.value_expression;
+    binding->buffer = std::move(into);
+
+    // Compiled into the key's sets BEFORE anything is subscribed, so a bad
+    // expression is a definite no rather than a handle that never produces
+    // anything, and leaves no subscription behind. The set has already logged
+    // which of the several possible reasons it was.
+    std::vector<std::shared_ptr<Binding>> bindings;
+    const auto existing = impl_->by_key.find(key.zenoh_key);
+    if (existing != impl_->by_key.end())
+    {
+        bindings = existing->second->snapshot()->all();
+    }
+    bindings.push_back(binding);
 
-    // A definite no rather than a handle that never produces anything. The
-    // evaluator has already logged which of the several possible reasons it was.
-    if (!evaluator->isValid())
+    std::shared_ptr<const BindingList> updated = BindingList::build(bindings, key.zenoh_key);
+    if (!updated)
     {
         return kInvalidSignal;
     }
@@ -240,13 +260,7 @@ SignalHandle LiveZenohSource::bind(const SignalKey& key, std::shared_ptr<SignalB
         return kInvalidSignal;
     }
 
-    auto binding = std::make_shared<Binding>();
-    binding->handle = impl_->next_handle++;
-    binding->evaluator = std::move(evaluator);
-    binding->buffer = std::move(into);
-
-    auto updated = std::make_shared<BindingList>(*subscription->snapshot());
-    updated->push_back(binding);
+    ++impl_->next_handle;
     subscription->publish(std::move(updated));
 
     impl_->handle_keys.emplace(binding->handle, key.zenoh_key);
@@ -307,11 +321,10 @@ KeySubscription* LiveZenohSource::Impl::ensureSubscription(const std::string& ke
 
         subscription->subscriber = std::make_unique<pub_sub::RawSubscriber>(
             key,
-            [raw, t0_copy](const std::vector<std::uint8_t>& payload, std::string_view schema_name) {
-                // One decode per bound signal rather than one per subscription,
-                // because each expression may read different fields. Still one
-                // *subscription* per key, which is the win: the wire traffic
-                // and the zenoh-side bookkeeping are paid once.
+            [raw, t0_copy](std::span<const std::uint8_t> payload, std::string_view schema_name) {
+                // One subscription per key, and one decode per sample per
+                // schema bound on it: each group's set reads the union of its
+                // expressions' fields once and evaluates all of them over it.
                 const std::shared_ptr<const BindingList> bindings = raw->snapshot();
                 const std::shared_ptr<const RawBindingList> raw_bindings = raw->snapshotRaw();
 
@@ -346,7 +359,7 @@ KeySubscription* LiveZenohSource::Impl::ensureSubscription(const std::string& ke
 
                         RawMessage message;
                         message.t = t;
-                        message.payload = payload;
+                        message.payload.assign(payload.begin(), payload.end());
                         if (binding->classify)
                         {
                             message.flags = binding->classify(message.payload);
@@ -360,24 +373,13 @@ KeySubscription* LiveZenohSource::Impl::ensureSubscription(const std::string& ke
                     return;
                 }
 
-                for (const std::shared_ptr<Binding>& binding : *bindings)
-                {
-                    // Latched inside the evaluator: one encoding comparison on
-                    // the first sample, a predicted branch thereafter. Worth it
-                    // because decoding against the wrong schema is silent --
-                    // field offsets land on different bytes and you get a
-                    // plausible number, not an error.
-                    binding->evaluator->checkPublishedSchema(schema_name);
-
-                    // nullopt means this sample was unusable. Dropping it
-                    // leaves a gap in the line, which is honest; substituting
-                    // zero would draw a spike that never happened.
-                    if (const std::optional<double> value =
-                            binding->evaluator->evaluateToDouble(payload))
-                    {
-                        binding->buffer->push(Sample{t, *value});
-                    }
-                }
+                // nullopt means this sample was unusable for that signal, and
+                // the list skips it. Dropping it leaves a gap in the line, which
+                // is honest; substituting zero would draw a spike that never
+                // happened.
+                bindings->evaluate(payload, schema_name,
+                                   [t](const Binding& binding, double value)
+                                   { binding.buffer->push(Sample{t, value}); });
             });
 
         if (!subscription->subscriber->isValid())
@@ -416,12 +418,18 @@ void LiveZenohSource::release(SignalHandle handle)
     {
         KeySubscription* const subscription = found->second.get();
 
-        auto updated = std::make_shared<BindingList>(*subscription->snapshot());
-        updated->erase(std::remove_if(updated->begin(), updated->end(),
-                                      [handle](const std::shared_ptr<Binding>& binding)
-                                      { return binding->handle == handle; }),
-                       updated->end());
-        subscription->publish(std::move(updated));
+        std::vector<std::shared_ptr<Binding>> remaining = subscription->snapshot()->all();
+        remaining.erase(std::remove_if(remaining.begin(), remaining.end(),
+                                       [handle](const std::shared_ptr<Binding>& binding)
+                                       { return binding->handle == handle; }),
+                        remaining.end());
+
+        // Every survivor compiled when it was bound, so this recompiles what
+        // is known to compile.
+        if (std::shared_ptr<const BindingList> updated = BindingList::build(remaining, key))
+        {
+            subscription->publish(std::move(updated));
+        }
 
         // Only when NOTHING is bound here any more, raw included. This used to
         // drop the subscription as soon as the numeric list emptied, which was
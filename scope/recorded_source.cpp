@@ -6,12 +6,15 @@
 #include <spdlog/spdlog.h>
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <deque>
+#include <exception>
 #include <limits>
 #include <map>
 #include <mutex>
+#include <optional>
 #include <span>
 #include <thread>
 
@@ -23,12 +26,19 @@ namespace
 
 constexpr double kNanosPerSecond = 1e9;
 
+// Threads a decode pass may add beside the worker. See Impl::decode().
+constexpr std::size_t kMaxDecodeHelpers = 7;
+
 }  // namespace
 
 // ------------------------------------------------------------- BagFileProvider
 
+// Cached, because this reader is asked the same questions over and over: every
+// bind, rebind and zoom re-reads a window much like the last one, and
+// uncached each of them would re-open the parts and re-decompress every chunk
+// in it.
 BagFileProvider::BagFileProvider(const std::string& directory) :
-    reader_(std::make_unique<bag::BagReader>(directory))
+    reader_(std::make_unique<bag::BagReader>(directory, bag::ReaderOptions{.cached = true}))
 {
 }
 
@@ -60,6 +70,23 @@ void BagFileProvider::forEach(std::uint64_t t0_ns, std::uint64_t t1_ns,
                      });
 }
 
+void BagFileProvider::forEachOnTopics(std::uint64_t t0_ns, std::uint64_t t1_ns,
+                                      const std::vector<std::string>& topics,
+                                      const std::function<void(const bag::BagMessage&)>& visit)
+{
+    if (!reader_->isValid())
+    {
+        return;
+    }
+
+    reader_->forEach(t0_ns, t1_ns, topics,
+                     [&visit](const bag::BagMessage& message)
+                     {
+                         visit(message);
+                         return true;
+                     });
+}
+
 std::vector<TopicInfo> BagFileProvider::topics() const
 {
     std::vector<TopicInfo> out;
@@ -99,6 +126,50 @@ std::pair<std::uint64_t, std::uint64_t> BagFileProvider::spanNanos() const
     return {reader_->metadata().t_begin_ns, reader_->metadata().t_end_ns};
 }
 
+std::vector<std::pair<std::uint64_t, std::uint64_t>> BagFileProvider::concurrentRanges() const
+{
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> ranges;
+    if (!reader_->isValid())
+    {
+        return ranges;
+    }
+
+    const std::vector<bag::bag_part_t>& parts = reader_->metadata().parts;
+    for (const bag::bag_part_t& part : parts)
+    {
+        if (part.message_count == 0)
+        {
+            // Empty, or torn before its count was written. Either way its
+            // t_begin_ns says nothing, and a boundary drawn from it could cut
+            // a neighbour in half.
+            return {};
+        }
+    }
+
+    // Split at each part's first message. Open-ended at both extremes so the
+    // tiling cannot miss a message stamped outside what the index recorded.
+    std::uint64_t from = 0;
+    for (std::size_t i = 1; i < parts.size(); ++i)
+    {
+        const std::uint64_t next = parts[i].t_begin_ns;
+        if (next <= from)
+        {
+            // Starts where the previous range does: no boundary to draw, and
+            // the two are read as one.
+            continue;
+        }
+        ranges.emplace_back(from, next - 1);
+        from = next;
+    }
+    ranges.emplace_back(from, std::numeric_limits<std::uint64_t>::max());
+
+    if (ranges.size() < 2)
+    {
+        ranges.clear();
+    }
+    return ranges;
+}
+
 bool BagFileProvider::density(std::uint64_t t0_ns, std::uint64_t t1_ns, std::size_t buckets,
                               std::vector<std::uint32_t>& out)
 {
@@ -172,10 +243,6 @@ struct RecordedBinding
     // is handed and yields a plausible wrong number rather than an error.
     std::string expected_schema;
 
-    // exprtk binds field slots into its symbol table BY ADDRESS, so this is
-    // non-movable and has to be held indirectly.
-    std::unique_ptr<pub_sub::ExpressionEvaluator> evaluator;
-
     // The whole recording, decoded once. Written by the worker thread before
     // `ready` is set, read by the GUI thread after -- so the flag is the
     // hand-off and nothing needs a lock around the vector itself.
@@ -277,15 +344,17 @@ struct RecordedSource::Impl
     std::map<SignalHandle, std::shared_ptr<RecordedRawBinding>> raw_bindings;
 
     // ONE worker thread, not one per bind. RecordedProvider is not thread-safe
-    // -- BagFileProvider holds an mcap reader with its own decompression buffers
-    // -- so decodes are serialized by construction rather than by a lock nobody
-    // would remember to take. The raw work joins the same thread for the same
-    // reason: a second one would touch the same reader.
+    // in general -- a provider may hold one reader with its own decompression
+    // buffers -- so passes are serialized by construction rather than by a lock
+    // nobody would remember to take. The raw work joins the same thread for the
+    // same reason. The one exception is inside a decode pass, and only over the
+    // ranges the provider itself declares safe (concurrentRanges).
     struct Job
     {
         enum class Kind
         {
-            // Decode one signal's expression over the whole recording.
+            // Decode one signal's expression over the whole recording. Every
+            // one queued is taken by the same pass -- see run().
             DecodeSignal,
 
             // Build one raw stream's payload-free index over the whole recording.
@@ -320,57 +389,225 @@ struct RecordedSource::Impl
                    : 0.0;
     }
 
-    // The full decode pass for one signal. Runs on the worker thread.
-    void decode(const std::shared_ptr<RecordedBinding>& binding)
+    // The full decode pass for a batch of signals. Runs on the worker thread.
+    //
+    // Grouped by topic, so a message is matched against its key once however
+    // many signals read it, and every signal on that topic evaluates its
+    // expression against the same decode of the same payload view. Nothing is
+    // copied or decoded per signal.
+    void decode(const std::vector<std::shared_ptr<RecordedBinding>>& signals)
     {
-        std::vector<Sample> decoded;
+        // Clipped to the recording, so each range still means "this part of
+        // what spanNanos() reported" to a provider that draws its boundaries
+        // open-ended.
+        std::vector<std::pair<std::uint64_t, std::uint64_t>> ranges;
+        for (const auto& [from, to] : provider->concurrentRanges())
+        {
+            const std::uint64_t lo = std::max(from, t_begin_ns);
+            const std::uint64_t hi = std::min(to, t_end_ns);
+            if (lo <= hi)
+            {
+                ranges.emplace_back(lo, hi);
+            }
+        }
+        if (ranges.size() < 2)
+        {
+            ranges.assign(1, {t_begin_ns, t_end_ns});
+        }
 
-        provider->forEach(
-            t_begin_ns, t_end_ns,
-            [&](const bag::BagMessage& message)
+        // decoded[range][signal]. Each range fills its own row, so the threads
+        // share nothing until the rows are joined -- in range order, which is
+        // time order, which keeps every signal's vector non-decreasing.
+        std::vector<std::vector<std::vector<Sample>>> decoded(
+            ranges.size(), std::vector<std::vector<Sample>>(signals.size()));
+        std::atomic<std::size_t> next_range{0};
+
+        const auto decodeRanges = [&]()
+        {
+            // Topic -> the schemas its signals decode against -> the signals.
+            // One evaluator set per (topic, schema), so every signal reading a
+            // topic shares one capnp decode per message however many there are.
+            //
+            // exprtk evaluates through a symbol table bound to ONE set of field
+            // slots, so a set cannot be shared between threads: each thread
+            // compiles its own from the expressions bind() already validated.
+            // Identical configuration, identical results.
+            struct Group
             {
-                if (message.key != binding->key.zenoh_key)
+                std::string expected_schema;
+                std::vector<std::size_t> signals;
+                std::unique_ptr<pub_sub::ExpressionEvaluatorSet> evaluators;
+                std::vector<std::optional<double>> results;
+            };
+
+            // Heterogeneous lookup, so the per-message find takes the reader's
+            // string_view as it is.
+            std::map<std::string, std::vector<Group>, std::less<>> by_topic;
+            for (std::size_t i = 0; i < signals.size(); ++i)
+            {
+                std::vector<Group>& groups = by_topic[signals[i]->key.zenoh_key];
+                const auto group = std::find_if(
+                    groups.begin(), groups.end(), [&](const Group& candidate)
+                    { return candidate.expected_schema == signals[i]->expected_schema; });
+                if (group == groups.end())
                 {
-                    return;
+                    groups.push_back(Group{signals[i]->expected_schema, {i}, nullptr, {}});
+                }
+                else
+                {
+                    group->signals.push_back(i);
                 }
+            }
 
-                // Recorded with a different schema than the binding expects.
-                // Skipped rather than decoded: capnp will happily read these
-                // bytes against the wrong schema and produce a number.
-                if (!message.schema.empty() && message.schema != binding->expected_schema)
+            std::vector<std::string> topics;
+            for (auto& [topic, groups] : by_topic)
+            {
+                topics.push_back(topic);
+                for (Group& group : groups)
                 {
-                    return;
+                    std::vector<std::string> expressions;
+                    for (const std::size_t i : group.signals)
+                    {
+                        expressions.push_back(signals[i]->key.value_expression);
+                    }
+                    group.evaluators = std::make_unique<pub_sub::ExpressionEvaluatorSet>(
+                        signals[group.signals.front()]->key.schema_type, expressions, topic);
+                    group.results.resize(group.signals.size());
                 }
+            }
+
+            for (std::size_t r = next_range++; r < ranges.size(); r = next_range++)
+            {
+                std::vector<std::vector<Sample>>& out = decoded[r];
+                provider->forEachOnTopics(
+                    ranges[r].first, ranges[r].second, topics,
+                    [&](const bag::BagMessage& message)
+                    {
+                        const auto topic = by_topic.find(message.key);
+                        if (topic == by_topic.end())
+                        {
+                            return;
+                        }
+
+                        // log_time, not publish_time. log_time is the
+                        // recorder's own clock and is monotone; publish_time is
+                        // the publisher's wall clock and can step backwards
+                        // when NTP disciplines it, or be plainly wrong on a
+                        // unit that booted with a dead RTC. An axis that jumps
+                        // backwards mid-trace is worse than one measured from a
+                        // slightly delayed origin -- and it would break
+                        // SampleHistory's ordering precondition outright.
+                        const double t = static_cast<double>(message.log_time_ns - t_begin_ns) /
+                                         kNanosPerSecond;
+
+                        for (Group& group : topic->second)
+                        {
+                            // Recorded with a different schema than the binding
+                            // expects. Skipped rather than decoded: capnp will
+                            // happily read these bytes against the wrong schema
+                            // and produce a number.
+                            if (!message.schema.empty() &&
+                                message.schema != group.expected_schema)
+                            {
+                                continue;
+                            }
+
+                            // A span, so nothing is copied. nullopt drops the
+                            // sample rather than pushing zero: a gap in the line
+                            // is honest, a spike that never happened is not.
+                            group.evaluators->evaluateToDouble(message.payload, group.results);
+                            for (std::size_t k = 0; k < group.signals.size(); ++k)
+                            {
+                                if (group.results[k])
+                                {
+                                    out[group.signals[k]].push_back(Sample{t, *group.results[k]});
+                                }
+                            }
+                        }
+                    });
+            }
+        };
 
-                // log_time, not publish_time. log_time is the recorder's own
-                // clock and is monotone; publish_time is the publisher's wall
-                // clock and can step backwards when NTP disciplines it, or be
-                // plainly wrong on a unit that booted with a dead RTC. An axis
-                // that jumps backwards mid-trace is worse than one measured
-                // from a slightly delayed origin -- and it would break
-                // SampleHistory's ordering precondition outright.
-                const double t =
-                    static_cast<double>(message.log_time_ns - t_begin_ns) / kNanosPerSecond;
-
-                // A span, so nothing is copied. nullopt drops the sample rather
-                // than pushing zero: a gap in the line is honest, a spike that
-                // never happened is not.
-                if (const std::optional<double> value =
-                        binding->evaluator->evaluateToDouble(message.payload))
+        // The worker counts as one of the threads, and the rest are capped:
+        // past a few, the parts are decompressing faster than the disk can
+        // hand them over.
+        const std::size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+        const std::size_t helpers =
+            std::min({ranges.size() - 1, hardware - 1, kMaxDecodeHelpers});
+
+        // An exception escaping a helper's thread function would call
+        // std::terminate, and one escaping this thread's share would destroy
+        // joinable threads, which does the same. So every share catches, the
+        // first failure is kept, the ranges nobody has started are given up,
+        // and it is rethrown once everything has been joined.
+        std::exception_ptr failure;
+        std::mutex failure_mutex;
+        const auto decodeRangesCaught = [&]()
+        {
+            try
+            {
+                decodeRanges();
+            }
+            catch (...)
+            {
+                next_range = ranges.size();
+                const std::lock_guard<std::mutex> guard(failure_mutex);
+                if (!failure)
                 {
-                    decoded.push_back(Sample{t, *value});
+                    failure = std::current_exception();
                 }
-            });
+            }
+        };
 
-        const std::lock_guard<std::mutex> guard(mutex);
-        binding->samples = std::move(decoded);
-        binding->ready = true;
+        std::vector<std::thread> threads;
+        threads.reserve(helpers);
+        for (std::size_t i = 0; i < helpers; ++i)
+        {
+            threads.emplace_back(decodeRangesCaught);
+        }
+        decodeRangesCaught();
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        if (failure)
+        {
+            std::rethrow_exception(failure);
+        }
+
+        std::vector<std::vector<Sample>> joined(signals.size());
+        for (std::size_t i = 0; i < signals.size(); ++i)
+        {
+            if (ranges.size() == 1)
+            {
+                joined[i] = std::move(decoded[0][i]);
+                continue;
+            }
+            std::size_t total = 0;
+            for (const std::vector<std::vector<Sample>>& row : decoded)
+            {
+                total += row[i].size();
+            }
+            joined[i].reserve(total);
+            for (const std::vector<std::vector<Sample>>& row : decoded)
+            {
+                joined[i].insert(joined[i].end(), row[i].begin(), row[i].end());
+            }
+        }
 
-        // Cleared so the next refill rebuilds the window from scratch. The
-        // buffer is empty at this point and `filled_to` describes a vector that
-        // did not exist when it was last set.
-        binding->filled = false;
-        binding->filled_to = 0;
+        const std::lock_guard<std::mutex> guard(mutex);
+        for (std::size_t i = 0; i < signals.size(); ++i)
+        {
+            RecordedBinding& binding = *signals[i];
+            binding.samples = std::move(joined[i]);
+            binding.ready = true;
+
+            // Cleared so the next refill rebuilds the window from scratch. The
+            // buffer is empty at this point and `filled_to` describes a vector
+            // that did not exist when it was last set.
+            binding.filled = false;
+            binding.filled_to = 0;
+        }
     }
 
     // One pass over the recording building the payload-free index. Runs on the
@@ -379,34 +616,35 @@ struct RecordedSource::Impl
     {
         std::vector<RecordedRawBinding::IndexEntry> built;
 
-        provider->forEach(t_begin_ns, t_end_ns,
-                          [&](const bag::BagMessage& message)
-                          {
-                              if (message.key != binding->zenoh_key)
-                              {
-                                  return;
-                              }
-
-                              // Same rule as the numeric path: a message
-                              // recorded under a different schema is skipped
-                              // rather than handed over. A decoder fed the wrong
-                              // stream produces a plausible mess, not an error.
-                              if (!message.schema.empty() &&
-                                  message.schema != binding->expected_schema)
-                              {
-                                  return;
-                              }
-
-                              RecordedRawBinding::IndexEntry entry;
-                              entry.t = static_cast<double>(message.log_time_ns - t_begin_ns) /
-                                        kNanosPerSecond;
-                              entry.bytes = static_cast<std::uint32_t>(message.payload.size());
-                              if (binding->classify)
-                              {
-                                  entry.flags = binding->classify(message.payload);
-                              }
-                              built.push_back(entry);
-                          });
+        provider->forEachOnTopics(
+            t_begin_ns, t_end_ns, {binding->zenoh_key},
+            [&](const bag::BagMessage& message)
+            {
+                if (message.key != binding->zenoh_key)
+                {
+                    return;
+                }
+
+                // Same rule as the numeric path: a message
+                // recorded under a different schema is skipped
+                // rather than handed over. A decoder fed the wrong
+                // stream produces a plausible mess, not an error.
+                if (!message.schema.empty() &&
+                    message.schema != binding->expected_schema)
+                {
+                    return;
+                }
+
+                RecordedRawBinding::IndexEntry entry;
+                entry.t = static_cast<double>(message.log_time_ns - t_begin_ns) /
+                          kNanosPerSecond;
+                entry.bytes = static_cast<std::uint32_t>(message.payload.size());
+                if (binding->classify)
+                {
+                    entry.flags = binding->classify(message.payload);
+                }
+                built.push_back(entry);
+            });
 
         const std::lock_guard<std::mutex> guard(mutex);
         binding->index = std::move(built);
@@ -497,29 +735,30 @@ struct RecordedSource::Impl
         std::vector<RawMessage> loaded;
         std::uint64_t bytes = 0;
 
-        provider->forEach(from_ns, to_ns,
-                          [&](const bag::BagMessage& message)
-                          {
-                              if (message.key != key)
-                              {
-                                  return;
-                              }
-                              if (!message.schema.empty() && message.schema != schema)
-                              {
-                                  return;
-                              }
-
-                              RawMessage out;
-                              out.t = static_cast<double>(message.log_time_ns - t_begin_ns) /
-                                      kNanosPerSecond;
-                              out.payload.assign(message.payload.begin(), message.payload.end());
-                              if (classify)
-                              {
-                                  out.flags = classify(out.payload);
-                              }
-                              bytes += out.payload.size();
-                              loaded.push_back(std::move(out));
-                          });
+        provider->forEachOnTopics(
+            from_ns, to_ns, {key},
+            [&](const bag::BagMessage& message)
+            {
+                if (message.key != key)
+                {
+                    return;
+                }
+                if (!message.schema.empty() && message.schema != schema)
+                {
+                    return;
+                }
+
+                RawMessage out;
+                out.t = static_cast<double>(message.log_time_ns - t_begin_ns) /
+                        kNanosPerSecond;
+                out.payload.assign(message.payload.begin(), message.payload.end());
+                if (classify)
+                {
+                    out.flags = classify(out.payload);
+                }
+                bytes += out.payload.size();
+                loaded.push_back(std::move(out));
+            });
 
         const std::lock_guard<std::mutex> guard(mutex);
 
@@ -583,6 +822,7 @@ struct RecordedSource::Impl
 
     void run()
     {
+        std::vector<std::shared_ptr<RecordedBinding>> batch;
         for (;;)
         {
             Job job;
@@ -595,12 +835,33 @@ struct RecordedSource::Impl
                 }
                 job = queue.front();
                 queue.pop_front();
+
+                // Every other signal waiting to be decoded joins this pass.
+                // They were bound together -- a workspace loading, a panel
+                // adding its traces -- and a pass costs the same for one
+                // signal as for forty.
+                if (job.kind == Job::Kind::DecodeSignal)
+                {
+                    batch.assign(1, job.signal);
+                    for (auto it = queue.begin(); it != queue.end();)
+                    {
+                        if (it->kind == Job::Kind::DecodeSignal)
+                        {
+                            batch.push_back(it->signal);
+                            it = queue.erase(it);
+                        }
+                        else
+                        {
+                            ++it;
+                        }
+                    }
+                }
             }
 
             switch (job.kind)
             {
                 case Job::Kind::DecodeSignal:
-                    decode(job.signal);
+                    decode(batch);
                     break;
 
                 case Job::Kind::IndexRaw:
@@ -612,12 +873,14 @@ struct RecordedSource::Impl
                     break;
             }
 
-            // Only the whole-recording passes are counted -- see `pending`.
+            // Only the whole-recording passes are counted -- see `pending` --
+            // and a decode counts once for every signal it took.
             if (job.kind != Job::Kind::LoadWindow)
             {
                 const std::lock_guard<std::mutex> guard(mutex);
-                --pending;
+                pending -= job.kind == Job::Kind::DecodeSignal ? batch.size() : 1;
             }
+            batch.clear();
         }
     }
 
@@ -921,12 +1184,12 @@ SignalHandle RecordedSource::bind(const SignalKey& key, std::shared_ptr<SignalBu
         return kInvalidSignal;
     }
 
-    auto evaluator = std::make_unique<pub_sub::ExpressionEvaluator>(
-        key.schema_type, key.value_expression, key.zenoh_key);
-
     // Checked here rather than on the worker, so a bad expression is a definite
     // no immediately instead of a handle whose decode quietly produces nothing.
-    if (!evaluator->isValid())
+    // Only checked: the decode pass compiles each topic's expressions together
+    // into one ExpressionEvaluatorSet per thread, and keeps nothing from this.
+    if (!pub_sub::ExpressionEvaluator(key.schema_type, key.value_expression, key.zenoh_key)
+             .isValid())
     {
         return kInvalidSignal;
     }
@@ -934,7 +1197,6 @@ SignalHandle RecordedSource::bind(const SignalKey& key, std::shared_ptr<SignalBu
     auto binding = std::make_shared<RecordedBinding>();
     binding->key = key;
     binding->buffer = std::move(into);
-    binding->evaluator = std::move(evaluator);
     binding->expected_schema =
         std::string(reflection::enum_traits<pub_sub::schema_type_t>::to_string(key.schema_type));
 
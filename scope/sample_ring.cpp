@@ -67,20 +67,85 @@ std::size_t StagingRing::drain(std::vector<Sample>& out)
 
 SampleHistory::SampleHistory(std::size_t capacity) : slots_(std::max<std::size_t>(capacity, 1))
 {
+    // Up to the largest bucket that fits in the capacity at all. A bucket
+    // bigger than that could never be wholly retained, so it would never be
+    // read.
+    for (unsigned level = kFirstSummaryLevel; (std::size_t{1} << level) <= slots_.size(); ++level)
+    {
+        summary_.emplace_back(std::bit_ceil((slots_.size() >> level) + 2));
+    }
 }
 
 void SampleHistory::append(const Sample& sample)
 {
+    const std::uint64_t seq = first_seq_ + size_;
+
     if (size_ < slots_.size())
     {
         slots_[(head_ + size_) % slots_.size()] = sample;
         ++size_;
-        return;
     }
+    else
+    {
+        // Full: overwrite the oldest and move the window along.
+        slots_[head_] = sample;
+        head_ = (head_ + 1) % slots_.size();
+        ++first_seq_;
+    }
+
+    summarise(seq);
+}
+
+void SampleHistory::summarise(std::uint64_t seq)
+{
+    for (unsigned level = kFirstSummaryLevel; level <= maxSummaryLevel(); ++level)
+    {
+        const std::uint64_t width = std::uint64_t{1} << level;
+        if (((seq + 1) & (width - 1)) != 0)
+        {
+            // Not the last sample of this bucket, and so not of any coarser
+            // one either.
+            return;
+        }
+
+        const std::uint64_t start = seq + 1 - width;
+        if (start < first_seq_)
+        {
+            // Part of the bucket was trimmed before it completed. It can never
+            // be read, and neither can any bucket containing it.
+            return;
+        }
+
+        const auto index = static_cast<std::size_t>(start - first_seq_);
+        Extent extent;
+        if (level == kFirstSummaryLevel)
+        {
+            const Sample& first = (*this)[index];
+            extent = {first.t, first.t, first.v, first.v, first.v, first.v};
+            for (std::size_t i = index + 1; i < index + width; ++i)
+            {
+                extent.min = std::min(extent.min, (*this)[i].v);
+                extent.max = std::max(extent.max, (*this)[i].v);
+            }
+            const Sample& last = (*this)[index + width - 1];
+            extent.t_last = last.t;
+            extent.last = last.v;
+        }
+        else
+        {
+            const Extent& low = summary(index, level - 1);
+            const Extent& high = summary(index + width / 2, level - 1);
+            extent = {low.t_first,
+                      high.t_last,
+                      std::min(low.min, high.min),
+                      std::max(low.max, high.max),
+                      low.first,
+                      high.last};
+        }
 
-    // Full: overwrite the oldest and move the window along.
-    slots_[head_] = sample;
-    head_ = (head_ + 1) % slots_.size();
+        std::vector<Extent>& row = summary_[level - kFirstSummaryLevel];
+        row[(start >> level) & (row.size() - 1)] = extent;
+    }
 }
 
 std::size_t SampleHistory::lowerBound(double t_min) const
@@ -105,6 +170,25 @@ std::size_t SampleHistory::lowerBound(double t_min) const
     return low;
 }
 
+std::size_t SampleHistory::upperBound(double t_max) const
+{
+    std::size_t low = 0;
+    std::size_t high = size_;
+    while (low < high)
+    {
+        const std::size_t mid = low + (high - low) / 2;
+        if ((*this)[mid].t <= t_max)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return low;
+}
+
 void SampleHistory::trimOlderThan(double t_min)
 {
     const std::size_t drop = lowerBound(t_min);
@@ -114,12 +198,17 @@ void SampleHistory::trimOlderThan(double t_min)
     }
     head_ = (head_ + drop) % slots_.size();
     size_ -= drop;
+    first_seq_ += drop;
 }
 
 void SampleHistory::clear()
 {
+    // The pyramid is left as it is. A bucket is only read once it is complete,
+    // and completing it after this overwrites whatever the old sequence left in
+    // its slot.
     head_ = 0;
     size_ = 0;
+    first_seq_ = 0;
 }
 
 // ----------------------------------------------------------------- SignalBuffer
@@ -57,7 +57,7 @@ ScopeRecorder::ScopeRecorder(std::size_t max_bytes, double max_seconds) :
 
     impl_->subscriber = std::make_unique<pub_sub::RawSubscriber>(
         "**", pub_sub::RawSubscriber::InfoHandler(
-                  [impl](const std::vector<std::uint8_t>& payload,
+                  [impl](std::span<const std::uint8_t> payload,
                          const pub_sub::RawSubscriber::SampleInfo& info)
                   {
                       // Taken HERE, not on whatever thread reads the buffer
@@ -71,7 +71,7 @@ ScopeRecorder::ScopeRecorder(std::size_t max_bytes, double max_seconds) :
                       message.schema = std::string(info.schema_name);
                       message.origin_zid = std::string(info.origin_zid);
                       message.publish_time_ns = info.publish_time_nanos;
-                      message.payload = payload;
+                      message.payload.assign(payload.begin(), payload.end());
 
                       ++impl->received;
 
@@ -20,6 +20,7 @@
 #include "scope/sample_ring.h"
 
 #include <algorithm>
+#include <cstddef>
 #include <cstdio>
 #include <limits>
 #include <random>
@@ -172,6 +173,100 @@ void testAgainstTheReferenceOverRandomData()
     expect(true, "decimation matches the brute-force reference over 200 random windows");
 }
 
+// The random windows above are a few hundred samples over up to 400 columns,
+// which is almost never enough for decimateMinMax() to read the pyramid at all.
+// These are long: tens of thousands of samples per column at the widest, over a
+// history that has wrapped, been trimmed mid-bucket, and been cleared -- the
+// three things that move logical indices away from the sequence numbers buckets
+// are aligned to.
+void testThePyramidMatchesTheReferenceOverLongWindows()
+{
+    std::mt19937 rng(20261016);
+    std::uniform_real_distribution<double> value_dist(-1000.0, 1000.0);
+    std::uniform_real_distribution<double> step_dist(0.0, 0.002);
+
+    constexpr std::size_t kCapacity = 100000;
+    scope::SampleHistory history(kCapacity);
+    std::vector<scope::Sample> retained;
+    std::vector<scope::ColumnStats> fast;
+
+    double t = 0.0;
+    for (int round = 0; round < 12; ++round)
+    {
+        if (round == 6)
+        {
+            history.clear();
+            retained.clear();
+        }
+
+        const std::size_t count = 20000 + (rng() % 50000);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            // Zero steps included: equal timestamps are what put a bucket's
+            // first and last sample exactly on a column boundary.
+            const scope::Sample sample{t, value_dist(rng)};
+            t += step_dist(rng);
+            history.append(sample);
+            retained.push_back(sample);
+        }
+        if (retained.size() > kCapacity)
+        {
+            retained.erase(retained.begin(),
+                           retained.end() - static_cast<std::ptrdiff_t>(kCapacity));
+        }
+
+        if (round % 3 == 1)
+        {
+            // An odd count, so what is left starts in the middle of a bucket.
+            const double cut = retained[retained.size() / 3 + 1].t;
+            history.trimOlderThan(cut);
+            retained.erase(std::remove_if(retained.begin(), retained.end(),
+                                          [cut](const scope::Sample& s) { return s.t < cut; }),
+                           retained.end());
+        }
+
+        if (history.size() != retained.size())
+        {
+            expect(false, "the model of the retained history tracks the real one");
+            return;
+        }
+
+        for (int window = 0; window < 20; ++window)
+        {
+            const double first_t = retained.front().t;
+            const double last_t = retained.back().t;
+            std::uniform_real_distribution<double> begin_dist(first_t - 1.0, last_t);
+            const double t_begin = begin_dist(rng);
+            const double t_end =
+                t_begin + std::uniform_real_distribution<double>(0.01, last_t - first_t + 2.0)(rng);
+            const std::size_t columns = 1 + (rng() % 2000);
+
+            const std::size_t filled =
+                scope::decimateMinMax(history, t_begin, t_end, columns, fast);
+            const std::vector<scope::ColumnStats> slow =
+                reference(retained, t_begin, t_end, columns);
+
+            std::size_t expected_filled = 0;
+            for (std::size_t i = 0; i < slow.size(); ++i)
+            {
+                expected_filled += slow[i].has_data ? 1 : 0;
+                if (!same(fast[i], slow[i]))
+                {
+                    expect(false, "a pyramid-read window matches the brute-force reference");
+                    return;
+                }
+            }
+            if (filled != expected_filled)
+            {
+                expect(false, "a pyramid-read window reports the right filled count");
+                return;
+            }
+        }
+    }
+
+    expect(true, "pyramid reads match the reference across wraps, trims and a clear");
+}
+
 // --------------------------------------------------------------- degenerate in
 
 void testZeroColumnsProducesNothing()
@@ -354,6 +449,7 @@ void testWorksOnAWrappedHistory()
 int main()
 {
     testAgainstTheReferenceOverRandomData();
+    testThePyramidMatchesTheReferenceOverLongWindows();
 
     testZeroColumnsProducesNothing();
     testAnEmptyHistoryProducesNoData();
@@ -32,6 +32,7 @@
 #include <chrono>
 #include <cmath>
 #include <functional>
+#include <limits>
 #include <span>
 #include <cstdio>
 #include <string>
@@ -349,6 +350,143 @@ void testBindDecodesOnceForTheWholeRecording()
     source.release(handle);
 }
 
+void testManySignalsShareOnePass()
+{
+    // A workspace binds all of its traces at once. One pass per signal read a
+    // 40-signal workspace's recording forty times over; they now join whichever
+    // pass is queued, so the count is one, or two when the worker had already
+    // started on the first signal before the rest arrived.
+    auto owned = std::make_unique<StubProvider>(100, 100'000'000ull);
+    StubProvider* const provider = owned.get();
+    scope::RecordedSource source(std::move(owned));
+
+    constexpr int kSignals = 40;
+    std::vector<std::shared_ptr<scope::SignalBuffer>> buffers;
+    for (int i = 0; i < kSignals; ++i)
+    {
+        scope::SignalKey key = rpmKey();
+        key.value_expression = "rpm + " + std::to_string(i);
+        buffers.push_back(std::make_shared<scope::SignalBuffer>(30.0, 100000, 4096));
+        expect(source.bind(key, buffers.back()) != scope::kInvalidSignal, "a valid signal binds");
+    }
+    expect(waitForDecode(source), "the decodes finish");
+
+    expect(provider->passes <= 2, "forty signals cost at most two passes (" +
+                                      std::to_string(provider->passes.load()) + ")");
+
+    // Every signal got its OWN expression's values, not a neighbour's.
+    source.seek(5.0);
+    bool all_right = true;
+    for (int i = 0; i < kSignals; ++i)
+    {
+        const scope::SampleHistory& history = buffers[static_cast<std::size_t>(i)]->history();
+        all_right = all_right && !history.empty() &&
+                    history.newest().v == 1050.0 + static_cast<double>(i);
+    }
+    expect(all_right, "each signal in a shared pass is evaluated with its own expression");
+}
+
+// The stub recording again, remembering which topics each pass asked for.
+class TopicRecordingProvider : public StubProvider
+{
+  public:
+    using StubProvider::StubProvider;
+
+    void forEachOnTopics(std::uint64_t t0_ns, std::uint64_t t1_ns,
+                         const std::vector<std::string>& topics,
+                         const std::function<void(const bag::BagMessage&)>& visit) override
+    {
+        asked.push_back(topics);
+        StubProvider::forEachOnTopics(t0_ns, t1_ns, topics, visit);
+    }
+
+    std::vector<std::vector<std::string>> asked;
+};
+
+// A decode names the topics it reads, so BagFileProvider can open only the
+// chunks they are in. A pass that asked for everything would still produce the
+// right samples -- from every video chunk in the recording.
+void testADecodeNamesItsTopics()
+{
+    auto owned = std::make_unique<TopicRecordingProvider>(100, 100'000'000ull);
+    TopicRecordingProvider* const provider = owned.get();
+    scope::RecordedSource source(std::move(owned));
+
+    auto buffer = std::make_shared<scope::SignalBuffer>(30.0, 100000, 4096);
+    expect(source.bind(rpmKey(), buffer) != scope::kInvalidSignal, "a valid signal binds");
+    expect(waitForDecode(source), "the decode finishes");
+
+    expect(provider->asked.size() == 1 &&
+               provider->asked.front() == std::vector<std::string>{"vehicle/engine/rpm"},
+           "the pass asks for the bound topic and nothing else");
+
+    source.seek(5.0);
+    expect(!buffer->history().empty() && buffer->history().newest().v == 1050.0,
+           "and decodes the same samples as an unfiltered pass");
+}
+
+// The stub recording again, declaring itself readable in four concurrent
+// ranges -- the shape BagFileProvider gives a recording rolled into parts.
+class PartitionedProvider : public StubProvider
+{
+  public:
+    using StubProvider::StubProvider;
+
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> concurrentRanges() const override
+    {
+        // Boundaries land exactly on message times, so an off-by-one in the
+        // tiling duplicates or drops a sample rather than passing by chance.
+        const std::uint64_t step = 100'000'000ull;
+        return {{0, kBase + 24 * step - 1},
+                {kBase + 24 * step, kBase + 50 * step - 1},
+                {kBase + 50 * step, kBase + 77 * step - 1},
+                {kBase + 77 * step, std::numeric_limits<std::uint64_t>::max()}};
+    }
+};
+
+void testAPartitionedDecodeIsWholeAndOrdered()
+{
+    auto owned = std::make_unique<PartitionedProvider>(100, 100'000'000ull);
+    StubProvider* const provider = owned.get();
+    scope::RecordedSource source(std::move(owned));
+
+    auto rpm = std::make_shared<scope::SignalBuffer>(0.0, 100000, 4096);
+    scope::SignalKey doubled = rpmKey();
+    doubled.value_expression = "rpm * 2";
+    auto twice = std::make_shared<scope::SignalBuffer>(0.0, 100000, 4096);
+
+    source.bind(rpmKey(), rpm);
+    source.bind(doubled, twice);
+    expect(waitForDecode(source), "the decode finishes");
+    expect(provider->passes >= 4, "each range is read by its own call (" +
+                                      std::to_string(provider->passes.load()) + ")");
+
+    // Zero retention means no time limit, so the seek to the end loads the
+    // whole recording and every sample can be checked.
+    source.seek(source.caps().t_end);
+
+    const auto exact = [](const scope::SampleHistory& history, double scale) {
+        if (history.size() != 100)
+        {
+            return false;
+        }
+        for (std::size_t i = 0; i < history.size(); ++i)
+        {
+            if (history[i].v != scale * static_cast<double>(1000 + i))
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+    expect(exact(rpm->history(), 1.0),
+           "every message is decoded exactly once, in order, across range boundaries (" +
+               std::to_string(rpm->history().size()) + " samples)");
+    expect(exact(twice->history(), 2.0),
+           "and a second signal on the same topic gets its own values from the same pass");
+    expect(isOrdered(rpm->history()), "the joined ranges are time-ordered");
+}
+
 void testABadExpressionIsRefusedImmediately()
 {
     scope::RecordedSource source(std::make_unique<StubProvider>(10, 100'000'000ull));
@@ -784,6 +922,9 @@ int main()
     testTopicsComeFromTheIndex();
 
     testBindDecodesOnceForTheWholeRecording();
+    testManySignalsShareOnePass();
+    testADecodeNamesItsTopics();
+    testAPartitionedDecodeIsWholeAndOrdered();
     testABadExpressionIsRefusedImmediately();
 
     testSeekFillsTheWindow();
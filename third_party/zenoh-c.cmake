@@ -190,12 +190,17 @@ FetchContent_Declare(
     OVERRIDE_FIND_PACKAGE
 )
 
-# SHARED MEMORY, FOR THE MAP PATH AND NOTHING ELSE SO FAR. zenoh 1.10 can move
-# a large payload between two processes on one host through an SHM pool instead
-# of the socket, and since 1.10 it does so WITHOUT any application code: the
-# `shared-memory` cargo feature plus `transport/shared_memory/transport_optimization`
-# is the whole mechanism. The explicit ShmProvider API is a different thing,
-# needs the unstable API as well, and is not used here.
+# SHARED MEMORY. zenoh 1.10 can move a large payload between two processes on
+# one host through an SHM pool instead of the socket, and since 1.10 it does so
+# WITHOUT any application code: the `shared-memory` cargo feature plus
+# `transport/shared_memory/transport_optimization` is the whole mechanism.
+#
+# That mechanism copies, though: a payload built on the heap is copied into the
+# transport's pool on put(). The explicit ShmProvider API removes that copy by
+# letting the publisher build the message in the pool to begin with, which is
+# what pub_sub::detail::PayloadBuffer does for large payloads. It needs the
+# unstable API as well, hence ZENOHC_BUILD_WITH_UNSTABLE_API below. Without it
+# PayloadBuffer compiles down to the heap path and everything still works.
 #
 # MEASURED, two processes on one host, real map_server answering a real 64-tile
 # MapTileRequest:
@@ -212,6 +217,9 @@ FetchContent_Declare(
 # Costs: libzenohc.a grows ~16 MB -> ~19 MB, and each session that actually uses
 # the optimization maps a 16 MB pool.
 set(ZENOHC_BUILD_WITH_SHARED_MEMORY ON CACHE BOOL "" FORCE)
+# For PosixShmProvider, ZShmMut and Bytes(ZShmMut&&). See zenoh-cpp.cmake for why
+# this is the knob that works and Z_FEATURE_UNSTABLE_API is not.
+set(ZENOHC_BUILD_WITH_UNSTABLE_API ON CACHE BOOL "" FORCE)
 
 # Configure zenoh-c options
 set(BUILD_SHARED_LIBS OFF CACHE BOOL "" FORCE)
@@ -32,11 +32,11 @@ set(ZENOHCXX_INSTALL OFF CACHE BOOL "" FORCE)
 #
 # which adds `--features=unstable` to the cargo invocation; the Rust build then
 # writes `#define Z_FEATURE_UNSTABLE_API` into zenoh_configure.h, where both
-# zenoh-c and zenoh-cpp pick it up. Left off deliberately: nothing here needs it
-# (MatchingStatus and declare_background_matching_listener are stable as of
-# zenoh-cpp 1.10), turning it on rebuilds the Rust library from scratch, and the
-# zero-copy payload access we would want it for is available from the stable
-# Bytes::slice_iter().
+# zenoh-c and zenoh-cpp pick it up. It was left off for a long time -- nothing
+# needed it, and the zero-copy payload access we might have wanted it for is
+# available from the stable Bytes::slice_iter(). It is on now for one thing: the
+# SHM provider that pub_sub::detail::PayloadBuffer allocates large outgoing
+# payloads from, which zenoh-cpp only declares under Z_FEATURE_UNSTABLE_API.
 FetchContent_MakeAvailable(zenoh-cpp)
 
 # Copy zenoh-cpp license
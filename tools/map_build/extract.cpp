@@ -17,6 +17,7 @@
 
 #include "osm/blob.h"
 #include "osm/block.h"
+#include "osm/block_pipeline.h"
 #include "map_build/rings.h"
 #include "map_rules/labels.h"
 #include "osm/node_store.h"
@@ -123,6 +124,15 @@ struct Bounds
     }
 };
 
+// One line per pass: how fast the file went by, and on how many threads. The
+// number to compare across machines is blobs/s; the seconds include whatever
+// the ordered stage did, which in pass 3 is most of it.
+void logPass(int pass, const osm::PipelineStats& read)
+{
+    SPDLOG_INFO("[extract] pass {}: {} blobs, {} decoded, {:.1f} s on {} threads ({:.0f} blobs/s)",
+                pass, read.blobs, read.decoded, read.seconds, read.threads, read.blobsPerSecond());
+}
+
 // WHERE TO PUT A LABEL for a shape.
 //
 // The area-weighted centroid, which is the cheap answer and is right for the
@@ -255,6 +265,9 @@ osm::Result<ExtractStats> extract(const ExtractOptions& options, const SegmentSi
                     header->writingProgram);
     }
 
+    osm::PipelineOptions pipeline;
+    pipeline.threads = options.threads;
+
     osm::NodeStore store;
     osm::OrderCheck order;
     TagScratch scratch;
@@ -292,67 +305,43 @@ osm::Result<ExtractStats> extract(const ExtractOptions& options, const SegmentSi
     std::unordered_map<std::int64_t, std::uint8_t> boundaryWays;
 
     // ---- Pass 1: what the ways reference ---------------------------------
+    //
+    // Marking runs on the workers -- it is most of the pass and NodeStore takes
+    // it from several at once. The order check and the relation bookkeeping
+    // depend on file order and stay on this thread.
     {
-        osm::BlobIterator it(file.bytes());
-        while (!it.done())
-        {
-            auto blob = it.next();
-            if (!blob)
-            {
-                return std::unexpected(blob.error());
-            }
-            if (blob->kind != osm::BlobKind::Data)
+        const auto markNodes = [&store](const osm::Block& block, std::size_t) -> osm::Result<void> {
+            for (const osm::Way& way : block.ways())
             {
-                continue;
+                store.markReferenced(block.refs(way));
             }
-            if (auto ok = osm::inflateBlob(*blob, buffer); !ok)
+            for (const osm::Relation& relation : block.relations())
             {
-                return std::unexpected(ok.error());
-            }
-
-            // Node blocks are most of a sorted file and pass 1 has no use for
-            // them; peeking steps over one for the cost of parsing its group
-            // headers.
-            auto contents = osm::peekDataBlock(buffer, blob->offset);
-            if (!contents)
-            {
-                return std::unexpected(contents.error());
-            }
-            if (!contents->hasWays && !contents->hasRelations)
-            {
-                continue;
-            }
-
-            auto block = osm::decodeDataBlock(buffer, blob->offset);
-            if (!block)
-            {
-                return std::unexpected(block.error());
+                for (const osm::Member& member : block.members(relation))
+                {
+                    if (member.type == osm::MemberType::Node)
+                    {
+                        store.markReferenced(member.ref);
+                    }
+                }
             }
-
-            for (const osm::Way& way : block->ways())
+            return {};
+        };
+        const auto readBlock = [&](const osm::Block& block,
+                                   std::size_t offset) -> osm::Result<void> {
+            for (const osm::Way& way : block.ways())
             {
-                if (auto ok = order.way(way.id, blob->offset); !ok)
+                if (auto ok = order.way(way.id, offset); !ok)
                 {
                     return std::unexpected(ok.error());
                 }
-                for (const std::int64_t ref : block->refs(way))
-                {
-                    store.markReferenced(ref);
-                }
             }
-            for (const osm::Relation& relation : block->relations())
+            for (const osm::Relation& relation : block.relations())
             {
-                if (auto ok = order.relation(relation.id, blob->offset); !ok)
+                if (auto ok = order.relation(relation.id, offset); !ok)
                 {
                     return std::unexpected(ok.error());
                 }
-                for (const osm::Member& member : block->members(relation))
-                {
-                    if (member.type == osm::MemberType::Node)
-                    {
-                        store.markReferenced(member.ref);
-                    }
-                }
 
                 // WHICH WAYS PASS 3 WILL HAVE TO HOLD ON TO.
                 //
@@ -362,7 +351,7 @@ osm::Result<ExtractStats> extract(const ExtractOptions& options, const SegmentSi
                 // is long gone. Keeping every way would cost gigabytes, so this
                 // pass works out the few that are actually needed and pass 3
                 // keeps only those.
-                const map_rules::TagView relationTags = scratch.view(*block, relation);
+                const map_rules::TagView relationTags = scratch.view(block, relation);
                 const auto type = relationTags.get("type");
                 if (!type.has_value())
                 {
@@ -403,7 +392,7 @@ osm::Result<ExtractStats> extract(const ExtractOptions& options, const SegmentSi
                     continue;
                 }
 
-                for (const osm::Member& member : block->members(relation))
+                for (const osm::Member& member : block.members(relation))
                 {
                     if (member.type == osm::MemberType::Way)
                     {
@@ -426,7 +415,22 @@ osm::Result<ExtractStats> extract(const ExtractOptions& options, const SegmentSi
                     }
                 }
             }
+            return {};
+        };
+
+        // Node blocks are most of a sorted file and pass 1 has no use for them;
+        // peeking steps over one for the cost of parsing its group headers.
+        auto read = osm::readDataBlocks(
+            file.bytes(), pipeline,
+            [](const osm::BlockContents& contents) {
+                return contents.hasWays || contents.hasRelations;
+            },
+            markNodes, readBlock);
+        if (!read)
+        {
+            return std::unexpected(read.error());
         }
+        logPass(1, *read);
     }
 
     if (auto ok = store.finalise(); !ok)
@@ -451,42 +455,11 @@ osm::Result<ExtractStats> extract(const ExtractOptions& options, const SegmentSi
         // sight and the map never grows past the referenced count.
         rankOf.reserve(static_cast<std::size_t>(stats.referencedNodes));
 
-        osm::BlobIterator it(file.bytes());
-        while (!it.done())
-        {
-            auto blob = it.next();
-            if (!blob)
-            {
-                return std::unexpected(blob.error());
-            }
-            if (blob->kind != osm::BlobKind::Data)
-            {
-                continue;
-            }
-            if (auto ok = osm::inflateBlob(*blob, buffer); !ok)
-            {
-                return std::unexpected(ok.error());
-            }
-            auto contents = osm::peekDataBlock(buffer, blob->offset);
-            if (!contents)
-            {
-                return std::unexpected(contents.error());
-            }
-            if (!contents->hasWays)
+        const auto countUses = [&](const osm::Block& block, std::size_t) -> osm::Result<void> {
+            for (const osm::Way& way : block.ways())
             {
-                continue;
-            }
-
-            auto block = osm::decodeDataBlock(buffer, blob->offset);
-            if (!block)
-            {
-                return std::unexpected(block.error());
-            }
-
-            for (const osm::Way& way : block->ways())
-            {
-                const map_rules::TagView tags = scratch.view(*block, way);
-                const auto refs = block->refs(way);
+                const map_rules::TagView tags = scratch.view(block, way);
+                const auto refs = block.refs(way);
                 const bool closed = refs.size() > 2 && refs.front() == refs.back();
                 const auto classification = map_rules::classify(tags, { closed });
                 if (!classification.routable())
@@ -513,7 +486,18 @@ osm::Result<ExtractStats> extract(const ExtractOptions& options, const SegmentSi
                     }
                 }
             }
+            return {};
+        };
+
+        auto read = osm::readDataBlocks(
+            file.bytes(), pipeline,
+            [](const osm::BlockContents& contents) { return contents.hasWays; }, nullptr,
+            countUses);
+        if (!read)
+        {
+            return std::unexpected(read.error());
         }
+        logPass(2, *read);
 
         for (const std::uint8_t count : uses)
         {
@@ -746,37 +730,53 @@ osm::Result<ExtractStats> extract(const ExtractOptions& options, const SegmentSi
         // cost far more than the occasional regrowth.
         std::vector<osm::Coord> wayGeometry;
 
-        osm::BlobIterator third(file.bytes());
-        while (!third.done())
-        {
-            auto blob = third.next();
-            if (!blob)
-            {
-                return std::unexpected(blob.error());
-            }
-            if (blob->kind != osm::BlobKind::Data)
+        // Filling the store is the one piece of this pass that is per-block
+        // work, so it runs on the workers: ranks are disjoint and NodeStore
+        // takes it from several at once. It is only safe because the way that
+        // reads a coordinate cannot overtake the node block that writes it --
+        // `ordered` sees a block only once every earlier block's `parallel`
+        // stage has finished -- and because a node block AFTER the ways is
+        // refused below, where a sequential fill would have quietly missed it
+        // and this one would quietly not.
+        osm::OrderCheck nodeOrder;
+        const auto fillNodes = [&store](const osm::Block& block, std::size_t) -> osm::Result<void> {
+            store.set(block.nodes());
+            return {};
+        };
+        const auto readBlock = [&](const osm::Block& block,
+                                   std::size_t offset) -> osm::Result<void> {
+            for (const osm::Node& node : block.nodes())
             {
-                continue;
+                if (auto ok = nodeOrder.node(node.id, offset); !ok)
+                {
+                    return std::unexpected(ok.error());
+                }
             }
-            if (auto ok = osm::inflateBlob(*blob, buffer); !ok)
+            // Only the first way and relation: pass 1 checked the rest, and all
+            // this needs of them is that the nodes are over.
+            if (!block.ways().empty())
             {
-                return std::unexpected(ok.error());
+                if (auto ok = nodeOrder.way(block.ways().front().id, offset); !ok)
+                {
+                    return std::unexpected(ok.error());
+                }
             }
-
-            auto block = osm::decodeDataBlock(buffer, blob->offset);
-            if (!block)
+            if (!block.relations().empty())
             {
-                return std::unexpected(block.error());
+                if (auto ok = nodeOrder.relation(block.relations().front().id, offset); !ok)
+                {
+                    return std::unexpected(ok.error());
+                }
             }
 
             ++stats.blocks;
-            stats.nodes += block->nodes().size();
-            stats.ways += block->ways().size();
-            stats.relations += block->relations().size();
+            stats.nodes += block.nodes().size();
+            stats.ways += block.ways().size();
+            stats.relations += block.relations().size();
 
-            for (const osm::Relation& relation : block->relations())
+            for (const osm::Relation& relation : block.relations())
             {
-                const map_rules::TagView tags = scratch.view(*block, relation);
+                const map_rules::TagView tags = scratch.view(block, relation);
 
                 const auto type = tags.get("type");
                 if (!type.has_value())
@@ -803,7 +803,7 @@ osm::Result<ExtractStats> extract(const ExtractOptions& options, const SegmentSi
                     }
 
                     std::vector<RingArc> arcs;
-                    for (const osm::Member& member : block->members(relation))
+                    for (const osm::Member& member : block.members(relation))
                     {
                         if (member.type != osm::MemberType::Way)
                         {
@@ -821,7 +821,7 @@ osm::Result<ExtractStats> extract(const ExtractOptions& options, const SegmentSi
                         arc.firstNode = found->second.firstNode;
                         arc.lastNode = found->second.lastNode;
                         arc.geometry = found->second.geometry;
-                        const std::string_view role = block->string(member.roleIndex);
+                        const std::string_view role = block.string(member.roleIndex);
                         // An empty role means outer, which is what the old
                         // style used and what a great deal of data still says.
                         arc.inner = role == "inner";
@@ -910,7 +910,7 @@ osm::Result<ExtractStats> extract(const ExtractOptions& options, const SegmentSi
                         level = static_cast<std::uint8_t>(parsed);
                     }
 
-                    for (const osm::Member& member : block->members(relation))
+                    for (const osm::Member& member : block.members(relation))
                     {
                         if (member.type != osm::MemberType::Way)
                         {
@@ -953,9 +953,9 @@ osm::Result<ExtractStats> extract(const ExtractOptions& options, const SegmentSi
                 bool viaWay = false;
                 bool complete = true;
 
-                for (const osm::Member& member : block->members(relation))
+                for (const osm::Member& member : block.members(relation))
                 {
-                    const std::string_view role = block->string(member.roleIndex);
+                    const std::string_view role = block.string(member.roleIndex);
                     if (role == "from" && member.type == osm::MemberType::Way)
                     {
                         out.fromWayId = member.ref;
@@ -1007,9 +1007,8 @@ osm::Result<ExtractStats> extract(const ExtractOptions& options, const SegmentSi
                             stats.segments);
             }
 
-            for (const osm::Node& node : block->nodes())
+            for (const osm::Node& node : block.nodes())
             {
-                store.set(node.id, node.lat, node.lon);
                 bounds.grow(node.lat, node.lon);
 
                 // LABELS. Places are the only thing here a node has a monopoly
@@ -1024,7 +1023,7 @@ osm::Result<ExtractStats> extract(const ExtractOptions& options, const SegmentSi
                     continue;
                 }
 
-                const map_rules::TagView nodeTags = scratch.view(*block, node);
+                const map_rules::TagView nodeTags = scratch.view(block, node);
                 emitLabels(nodeTags, node.id, node.lat, node.lon);
 
                 const auto place = map_rules::classifyPlace(nodeTags);
@@ -1051,10 +1050,10 @@ osm::Result<ExtractStats> extract(const ExtractOptions& options, const SegmentSi
                 ++stats.renderClasses[map_rules::to_string(map_rules::RenderClass::Place)];
             }
 
-            for (const osm::Way& way : block->ways())
+            for (const osm::Way& way : block.ways())
             {
-                const map_rules::TagView tags = scratch.view(*block, way);
-                const auto refs = block->refs(way);
+                const map_rules::TagView tags = scratch.view(block, way);
+                const auto refs = block.refs(way);
                 if (refs.size() < 2)
                 {
                     continue;
@@ -1242,7 +1241,15 @@ osm::Result<ExtractStats> extract(const ExtractOptions& options, const SegmentSi
                     start = i;
                 }
             }
+            return {};
+        };
+
+        auto third = osm::readDataBlocks(file.bytes(), pipeline, nullptr, fillNodes, readBlock);
+        if (!third)
+        {
+            return std::unexpected(third.error());
         }
+        logPass(3, *third);
 
         if (bounds.valid())
         {
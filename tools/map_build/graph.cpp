@@ -19,6 +19,8 @@ void addGraphOptions(cxxopts::Options& options)
         "o,output", "Graph file to write.", cxxopts::value<std::string>())(
         "built-at", "Unix seconds to stamp into the header. 0 uses the wall clock.",
         cxxopts::value<std::uint64_t>()->default_value("0"))(
+        "threads", "Threads decoding the PBF. 0 is one per core.",
+        cxxopts::value<std::uint64_t>()->default_value("0"))(
         "quiet", "No progress lines.", cxxopts::value<bool>()->default_value("false"));
 }
 
@@ -34,6 +36,7 @@ int runGraph(cli::Context& context)
     ExtractOptions options;
     options.input = *input;
     options.progressEvery = context.flag("quiet") ? 0 : 2000;
+    options.threads = static_cast<std::size_t>(context.uintOr("threads", 0));
 
     road_graph::Builder builder;
 
@@ -19,9 +19,16 @@
 //
 // A fourth would be needed if the coordinate array did not fit in memory -- see
 // the spill note in osm/node_store.h. It does, so there are three.
+//
+// Each pass reads through osm::readDataBlocks: blocks are inflated and decoded
+// on every core, node marking (1) and coordinate filling (3) run there too, and
+// everything else -- the order checks, the junction numbering, every sink call
+// -- sees the blocks one at a time in file order, exactly as a single-threaded
+// reader would. Nothing downstream of a sink needs to be thread-safe.
 #ifndef MAP_BUILD_EXTRACT_H
 #define MAP_BUILD_EXTRACT_H
 
+#include <cstddef>
 #include <cstdint>
 #include <filesystem>
 #include <functional>
@@ -114,6 +121,9 @@ struct ExtractOptions
     std::filesystem::path input;
     // Progress every N blocks. Zero is silent.
     std::uint32_t progressEvery { 2000 };
+    // Threads inflating and decoding blocks. Zero is one per core. The output
+    // is the same at any count -- see osm/block_pipeline.h for why.
+    std::size_t threads { 0 };
 };
 
 // One DRAWN way, whole.
@@ -23,9 +23,17 @@
 //   is the cheap answer and is what is used; the alternative -- walking the
 //   line and emitting only the tiles it really crosses -- saves work on long
 //   diagonal features and costs more than it saves on everything else.
+//
+// Each zoom is built IN PARALLEL, a square of tiles at a time. A feature is
+// handed to every square its bounding box touches, a worker builds, encodes and
+// gzips the tiles of one square, and the squares reach the writer in a fixed
+// order -- by square, then by tile -- whatever order the workers finish in. So
+// the archive is byte-for-byte the same at any thread count, and only the
+// squares in flight are ever in memory rather than a whole zoom of tiles.
 #ifndef MAP_BUILD_TILER_H
 #define MAP_BUILD_TILER_H
 
+#include <cstddef>
 #include <cstdint>
 #include <deque>
 #include <map>
@@ -72,6 +80,10 @@ struct TileOptions
 
     // Progress line every N tiles. Zero is silent.
     std::uint32_t progressEvery { 5000 };
+
+    // Workers building tiles. Zero is one per core. The archive does not
+    // depend on it.
+    std::size_t threads { 0 };
 };
 
 struct TileStats
@@ -86,6 +98,10 @@ struct TileStats
     // smaller than a pixel, a road shorter than a tile unit. Expected to be
     // large at low zoom and near zero at z14.
     std::uint64_t droppedTooSmall { 0 };
+    // Features dropped because their box spans more than 4096 tiles at this
+    // zoom -- a coastline or a state boundary, which nobody sees move between
+    // one tile and the next. Zero at low zoom, and small at any.
+    std::uint64_t droppedTooWide { 0 };
 
     std::map<std::uint8_t, std::uint64_t> tilesPerZoom;
 };
@@ -104,6 +120,13 @@ class Tiler
                                      std::int32_t south, std::int32_t east, std::int32_t north);
 
   private:
+    // One square of tiles at one zoom and the features that may touch it, and
+    // what a worker made of it. Defined in tiler.cpp; see write().
+    struct Bucket;
+    struct BuiltBucket;
+
+    mbtiles::Result<BuiltBucket> build(const Bucket& bucket, const TileOptions& options) const;
+
     struct Prepared
     {
         // Web Mercator, normalised to [0,1] so a zoom is one multiply. The
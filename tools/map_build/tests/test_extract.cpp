@@ -105,12 +105,13 @@ struct Extracted
     bool ok { false };
 };
 
-Extracted run(const std::filesystem::path& path)
+Extracted run(const std::filesystem::path& path, std::size_t threads = 0)
 {
     Extracted out;
     map_build::ExtractOptions options;
     options.input = path;
     options.progressEvery = 0;
+    options.threads = threads;
 
     auto stats = map_build::extract(
         options,
@@ -554,6 +555,90 @@ void test_an_only_restriction_keeps_its_sense()
 
 } // namespace
 
+void test_the_output_does_not_depend_on_the_thread_count()
+{
+    // Blocks are decoded on a pool, so the one thing that must not leak out of
+    // it is the order they finished in. Segment ids are numbered as ways are
+    // read; a pass that consumed blocks as they came off the workers would
+    // number them differently on every run.
+    const std::vector<std::string> strings { "", "highway", "residential" };
+
+    std::vector<osm_test::DenseNodeSpec> nodes;
+    std::vector<osm_test::WaySpec> ways;
+    for (int road = 0; road < 8; ++road)
+    {
+        osm_test::WaySpec way { 500 + road, {}, { { 1, 2 } } };
+        for (int i = 0; i < 5; ++i)
+        {
+            const int id = 1000 + road * 10 + i;
+            nodes.push_back({ id, kLat + i * 1000, kLon + road * 1000, {} });
+            way.refs.push_back(id);
+        }
+        // Each road ends where the next one starts its middle, so there are
+        // junctions to split at.
+        if (road + 1 < 8)
+        {
+            way.refs.push_back(1000 + (road + 1) * 10 + 2);
+        }
+        ways.push_back(way);
+    }
+
+    const auto path = writePbf("map_build_threads.pbf", makeFile(nodes, ways, strings));
+    const auto serial = run(path, 1);
+    const auto parallel = run(path, 4);
+    check(serial.ok && parallel.ok, "the file extracts at one thread and at four");
+
+    bool same = serial.segments.size() == parallel.segments.size() && !serial.segments.empty();
+    for (std::size_t i = 0; same && i < serial.segments.size(); ++i)
+    {
+        const auto& a = serial.segments[i];
+        const auto& b = parallel.segments[i];
+        same = a.id == b.id && a.fromNodeId == b.fromNodeId && a.toNodeId == b.toNodeId &&
+               a.geometry == b.geometry;
+    }
+    check(same, "and yields the same segments, in the same order, with the same ids");
+    check(serial.stats.junctions == parallel.stats.junctions &&
+              serial.stats.resolvedNodes == parallel.stats.resolvedNodes,
+          "and the same counts");
+
+    std::filesystem::remove(path);
+}
+
+void test_nodes_after_the_ways_are_refused()
+{
+    // Pass 3 fills coordinates on the workers, which is only the same as
+    // filling them in order if no node comes after a way that needs it. A file
+    // like that is unsorted, and it is refused rather than read two ways.
+    const std::vector<std::string> strings { "", "highway", "residential" };
+
+    osm_test::HeaderBlockSpec header;
+    Bytes file = osm_test::framed("OSMHeader", osm_test::zlibBlob(osm_test::headerBlock(header)));
+
+    osm_test::PrimitiveBlockSpec wayBlock;
+    wayBlock.strings = strings;
+    osm_test::GroupSpec wayGroup;
+    wayGroup.ways = { { 500, { 100, 101 }, { { 1, 2 } } } };
+    wayBlock.groups.push_back(wayGroup);
+    const Bytes wayBytes =
+        osm_test::framed("OSMData", osm_test::zlibBlob(osm_test::primitiveBlock(wayBlock)));
+    file.insert(file.end(), wayBytes.begin(), wayBytes.end());
+
+    osm_test::PrimitiveBlockSpec nodeBlock;
+    nodeBlock.strings = strings;
+    osm_test::GroupSpec nodeGroup;
+    nodeGroup.dense = { { 100, kLat, kLon, {} }, { 101, kLat + 1000, kLon, {} } };
+    nodeBlock.groups.push_back(nodeGroup);
+    const Bytes nodeBytes =
+        osm_test::framed("OSMData", osm_test::zlibBlob(osm_test::primitiveBlock(nodeBlock)));
+    file.insert(file.end(), nodeBytes.begin(), nodeBytes.end());
+
+    const auto path = writePbf("map_build_nodes_last.pbf", file);
+    const auto result = run(path);
+    check(!result.ok, "a node block after the ways fails the extract");
+
+    std::filesystem::remove(path);
+}
+
 int main()
 {
     spdlog::set_level(spdlog::level::info);
@@ -569,6 +654,8 @@ int main()
     test_a_turn_restriction_relation_is_extracted();
     test_a_via_way_restriction_is_counted_rather_than_guessed();
     test_an_only_restriction_keeps_its_sense();
+    test_the_output_does_not_depend_on_the_thread_count();
+    test_nodes_after_the_ways_are_refused();
 
     if (failures != 0)
     {
@@ -22,9 +22,15 @@
 #include <algorithm>
 #include <cmath>
 #include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <span>
 #include <string_view>
 #include <variant>
 #include <string>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 #include <spdlog/spdlog.h>
@@ -34,6 +40,7 @@
 #include "mbtiles/writer.h"
 #include "mvt/decode.h"
 #include "mvt/gzip.h"
+#include "tiler_serial_tiles.h"
 
 namespace
 {
@@ -1564,6 +1571,342 @@ void test_simplification_drops_collinear_points()
     std::filesystem::remove(path);
 }
 
+// Tiles are built a square at a time on every core, and written in order. The
+// archive must not be able to tell: the same features at one thread and at
+// four have to produce the same FILE, byte for byte -- not merely the same
+// tiles, since a writer fed in a different order lays out a different file and
+// a cache keyed on its hash would see a new map.
+void test_the_archive_does_not_depend_on_the_thread_count()
+{
+    map_rules::RoadClassification service;
+    service.renderClass = map_rules::RenderClass::Service;
+    service.routeClass = map_rules::RouteClass::Service;
+    service.access = map_rules::kAccessMotorcar;
+    service.minZoom = 12;
+
+    map_build::Tiler tiler;
+    // A grid of short roads half a degree across: thirty-odd tiles a side at
+    // z14, so several buckets each way, with every road owned by one of them.
+    std::int64_t id = 1;
+    for (int row = 0; row < 12; ++row)
+    {
+        for (int column = 0; column < 12; ++column)
+        {
+            const std::int32_t lat = kIrvineLat + row * 450000;
+            const std::int32_t lon = kIrvineLon + column * 450000;
+            tiler.add(lineAt(id++, lat, lon, 6, 8000, "Grid road",
+                             (row + column) % 2 == 0 ? motorway() : service));
+
+            map_build::DrawInput label;
+            label.osmWayId = id++;
+            label.isPoint = true;
+            label.name = "Place";
+            label.place.kind = map_rules::PlaceKind::Town;
+            label.place.minZoom = 10;
+            label.place.labelRank = 4;
+            label.classification.renderClass = map_rules::RenderClass::Place;
+            label.classification.minZoom = 10;
+            label.geometry = { lat + 200000, lon + 200000 };
+            tiler.add(std::move(label));
+        }
+    }
+    // And roads long enough to cross bucket edges, which every bucket they
+    // touch builds its own share of.
+    for (int i = 0; i < 4; ++i)
+    {
+        tiler.add(lineAt(id++, kIrvineLat + i * 1000000, kIrvineLon, 40, 140000, "Long road",
+                         motorway()));
+    }
+
+    const auto build = [&](std::size_t threads, const std::string& name) {
+        const auto path = scratch(name);
+        std::filesystem::remove(path);
+        auto writer = mbtiles::Writer::create(path);
+        if (!writer)
+        {
+            check(false, "archive created");
+            return std::make_pair(std::vector<char> {}, map_build::TileStats {});
+        }
+
+        map_build::TileOptions options;
+        options.minZoom = 10;
+        options.maxZoom = 14;
+        options.progressEvery = 0;
+        options.threads = threads;
+        auto stats = tiler.write(*writer, options, "test", kIrvineLon, kIrvineLat,
+                                 kIrvineLon + 6000000, kIrvineLat + 6000000);
+        check(stats.has_value(), "the pyramid builds at " + std::to_string(threads) + " threads");
+        check(writer->finish().has_value(), "and the archive closes");
+
+        std::ifstream in(path, std::ios::binary);
+        std::vector<char> bytes((std::istreambuf_iterator<char>(in)),
+                                std::istreambuf_iterator<char>());
+        std::filesystem::remove(path);
+        return std::make_pair(std::move(bytes), stats ? *stats : map_build::TileStats {});
+    };
+
+    const auto [serial, serialStats] = build(1, "tiler_threads_1.mbtiles");
+    const auto [parallel, parallelStats] = build(4, "tiler_threads_4.mbtiles");
+
+    check(serialStats.tiles > 100, "the pyramid spans many buckets");
+    check(!serial.empty() && serial == parallel, "and the archive is the same file at 1 and 4");
+    check(serialStats.tiles == parallelStats.tiles && serialStats.bytes == parallelStats.bytes &&
+              serialStats.emptyTiles == parallelStats.emptyTiles &&
+              serialStats.mergedLines == parallelStats.mergedLines &&
+              serialStats.droppedTooSmall == parallelStats.droppedTooSmall &&
+              serialStats.tilesPerZoom == parallelStats.tilesPerZoom,
+          "with the same counts");
+}
+
+
+// A fixed stream of numbers for the fixture below. Not <random>: the engines
+// are specified but the distributions are not, so the same seed draws different
+// roads on different standard libraries, and the table this is checked against
+// was written once.
+struct Lcg
+{
+    std::uint64_t state;
+
+    std::int32_t next(std::int32_t bound)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return static_cast<std::int32_t>((state >> 33) % static_cast<std::uint64_t>(bound));
+    }
+};
+
+// The features tiler_serial_tiles.h was cut from, by the serial tiler this one
+// replaced. Changing anything here means regenerating that table.
+//
+// A sixth of a degree around the anchor, z12-z14: eight tiles a side at z14,
+// straddling a bucket edge each way. Inside it, random-walk roads of two
+// classes and three names (so some merge below z13), lakes with and without an
+// island, and places. Plus the two features the early drop in write() has to
+// agree with build() about:
+//
+//   * a lake with a second outer ring two degrees away and a centimetre
+//     across. Its unsimplified box spans far more than 4096 tiles at z13 and
+//     z14, but simplifying removes the speck and what is left is drawn.
+//   * a road a degree and a half across, drawn only at z14, where it is too
+//     wide to draw at all.
+void addSerialFixture(map_build::Tiler& tiler)
+{
+    map_rules::RoadClassification service;
+    service.renderClass = map_rules::RenderClass::Service;
+    service.routeClass = map_rules::RouteClass::Service;
+    service.access = map_rules::kAccessMotorcar;
+    service.minZoom = 12;
+
+    const auto ring = [](std::int32_t lat, std::int32_t lon, std::int32_t radius, int points,
+                         Lcg& lcg) {
+        std::vector<std::int32_t> out;
+        for (int i = 0; i < points; ++i)
+        {
+            const double angle = 2.0 * M_PI * i / points;
+            const double r = radius * (0.7 + (0.6 * lcg.next(1000) / 1000.0));
+            out.push_back(lat + static_cast<std::int32_t>(r * std::sin(angle)));
+            out.push_back(lon + static_cast<std::int32_t>(r * std::cos(angle)));
+        }
+        return out;
+    };
+
+    Lcg lcg { 21 };
+    constexpr std::int32_t kSpan = 1600000;
+    const char* const names[] = { "Main Street", "Oak Avenue", "" };
+    std::int64_t id = 1;
+
+    for (int i = 0; i < 40; ++i)
+    {
+        map_build::DrawInput road;
+        road.osmWayId = id++;
+        road.classification = i % 3 == 0 ? motorway() : service;
+        road.name = names[i % 3];
+        std::int32_t lat = kIrvineLat - (kSpan / 2) + lcg.next(kSpan);
+        std::int32_t lon = kIrvineLon - (kSpan / 2) + lcg.next(kSpan);
+        const std::int32_t stride = i % 5 == 0 ? 240000 : 30000;
+        const int points = 2 + lcg.next(20);
+        for (int k = 0; k < points; ++k)
+        {
+            road.geometry.push_back(lat);
+            road.geometry.push_back(lon);
+            lat += lcg.next(2 * stride) - stride;
+            lon += lcg.next(2 * stride) - stride;
+        }
+        tiler.add(std::move(road));
+    }
+
+    for (int i = 0; i < 6; ++i)
+    {
+        map_build::DrawInput lake;
+        lake.osmWayId = id++;
+        lake.classification = water();
+        lake.closed = true;
+        const std::int32_t lat = kIrvineLat - (kSpan / 2) + lcg.next(kSpan);
+        const std::int32_t lon = kIrvineLon - (kSpan / 2) + lcg.next(kSpan);
+        const std::int32_t radius = 15000 + (5000 * i);
+        lake.geometry = ring(lat, lon, radius, 12 + i, lcg);
+        if (i % 2 == 1)
+        {
+            lake.innerRings.push_back(ring(lat, lon, radius / 4, 6, lcg));
+        }
+        tiler.add(std::move(lake));
+    }
+
+    map_build::DrawInput speck;
+    speck.osmWayId = id++;
+    speck.classification = water();
+    speck.closed = true;
+    speck.geometry = ring(kIrvineLat, kIrvineLon + 200000, 30000, 10, lcg);
+    speck.outerRings.push_back(ring(kIrvineLat + 20000000, kIrvineLon + 20000000, 2, 5, lcg));
+    tiler.add(std::move(speck));
+
+    map_build::DrawInput wide = lineAt(id++, kIrvineLat - 7500000, kIrvineLon - 7500000, 2,
+                                       15000000, "Too wide", motorway());
+    wide.classification.minZoom = 14;
+    tiler.add(std::move(wide));
+
+    for (int i = 0; i < 8; ++i)
+    {
+        map_build::DrawInput place;
+        place.osmWayId = id++;
+        place.isPoint = true;
+        place.name = "Place " + std::to_string(i);
+        place.place.kind = map_rules::PlaceKind::Town;
+        place.place.minZoom = 12;
+        place.place.labelRank = 4;
+        place.classification.renderClass = map_rules::RenderClass::Place;
+        place.classification.minZoom = 12;
+        place.geometry = { kIrvineLat - (kSpan / 2) + lcg.next(kSpan),
+                           kIrvineLon - (kSpan / 2) + lcg.next(kSpan) };
+        tiler.add(std::move(place));
+    }
+}
+
+// The XYZ tile a coordinate in 1e-7 degrees falls in.
+std::pair<std::uint32_t, std::uint32_t> tileAt(std::uint8_t z, std::int32_t lat, std::int32_t lon)
+{
+    const double side = static_cast<double>(1U << z);
+    const double latRad = lat * 1e-7 * M_PI / 180.0;
+    const double x = (lon * 1e-7 + 180.0) / 360.0 * side;
+    const double y = (1.0 - std::log(std::tan(latRad) + 1.0 / std::cos(latRad)) / M_PI) / 2.0 * side;
+    return { static_cast<std::uint32_t>(x), static_cast<std::uint32_t>(y) };
+}
+
+std::uint64_t fnv1a(std::span<const std::uint8_t> bytes)
+{
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const std::uint8_t byte : bytes)
+    {
+        hash ^= byte;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// The thread-count test above holds the new tiler to itself. This holds it to
+// the serial tiler it replaced: every (z, x, y) that tiler wrote for the
+// fixture, decoded, against the bytes it wrote there -- and nothing anywhere
+// else. Compared tile by tile rather than as a file, because the serial tiler
+// wrote in hash-map order and no other writer can reproduce that.
+void test_every_tile_matches_the_serial_tiler()
+{
+    map_build::Tiler tiler;
+    addSerialFixture(tiler);
+
+    const auto path = scratch("tiler_serial.mbtiles");
+    std::filesystem::remove(path);
+    auto writer = mbtiles::Writer::create(path);
+    if (!writer)
+    {
+        check(false, "archive created");
+        return;
+    }
+    map_build::TileOptions options;
+    options.minZoom = 12;
+    options.maxZoom = 14;
+    options.progressEvery = 0;
+    options.threads = 3;
+    const auto stats = tiler.write(*writer, options, "test", kIrvineLon - 800000,
+                                   kIrvineLat - 800000, kIrvineLon + 800000, kIrvineLat + 800000);
+    check(stats.has_value(), "the pyramid builds");
+    check(writer->finish().has_value(), "and the archive closes");
+    if (!stats)
+    {
+        return;
+    }
+
+    // What the serial tiler counted as one number, this one counts as two.
+    check(stats->tiles == kSerialTileCount && stats->mergedLines == kSerialMergedLines &&
+              stats->droppedTooSmall + stats->droppedTooWide == kSerialDropped,
+          "the counts add up to the serial tiler's");
+    check(stats->droppedTooWide >= 1, "and the road too wide for z14 is counted as such");
+
+    auto archive = mbtiles::Archive::open(path);
+    check(archive.has_value(), "the archive opens");
+    if (!archive)
+    {
+        return;
+    }
+
+    std::map<std::tuple<std::uint8_t, std::uint32_t, std::uint32_t>, const SerialTile*> expected;
+    for (const SerialTile& tile : kSerialTiles)
+    {
+        expected[{ tile.z, tile.x, tile.y }] = &tile;
+    }
+
+    // Every tile the fixture could reach, which is the whole sixth of a degree
+    // and the speck's corner of the map -- not only the ones in the table, or a
+    // tile the serial tiler never wrote would go unnoticed.
+    std::size_t matched = 0;
+    for (std::uint8_t z = options.minZoom; z <= options.maxZoom; ++z)
+    {
+        // South-west corner to north-east; y counts southward.
+        const auto [x0, y1] = tileAt(z, kIrvineLat - 1000000, kIrvineLon - 1000000);
+        const auto [x1, y0] = tileAt(z, kIrvineLat + 21000000, kIrvineLon + 21000000);
+        for (std::uint32_t x = x0; x <= x1; ++x)
+        {
+            for (std::uint32_t y = y0; y <= y1; ++y)
+            {
+                const std::string where = std::to_string(z) + "/" + std::to_string(x) + "/" +
+                                          std::to_string(y);
+                const auto found = expected.find({ z, x, y });
+                const auto stored = archive->tile(z, x, y);
+                if (!stored || !*stored)
+                {
+                    check(found == expected.end(), "tile " + where + " is written, as it was");
+                    continue;
+                }
+                if (found == expected.end())
+                {
+                    check(false, "tile " + where + " was not written by the serial tiler");
+                    continue;
+                }
+
+                const auto inflated = mvt::inflateIfCompressed((*stored)->data);
+                const auto decoded = inflated ? mvt::decode(*inflated) : mvt::Result<mvt::Tile> {};
+                if (!inflated || !decoded)
+                {
+                    check(false, "tile " + where + " decodes");
+                    continue;
+                }
+                std::size_t features = 0;
+                for (const mvt::Layer& layer : decoded->layers)
+                {
+                    features += layer.features.size();
+                }
+                const SerialTile& serial = *found->second;
+                check(decoded->layers.size() == serial.layers && features == serial.features,
+                      "tile " + where + " carries the serial tiler's layers and features");
+                check(inflated->size() == serial.bytes && fnv1a(*inflated) == serial.hash,
+                      "tile " + where + " is the serial tiler's tile, byte for byte");
+                ++matched;
+            }
+        }
+    }
+    check(matched == std::size(kSerialTiles), "and every tile it wrote is found");
+
+    std::filesystem::remove(path);
+}
+
 } // namespace
 
 int main()
@@ -1591,6 +1934,8 @@ int main()
     test_geometry_extends_past_the_tile_edge();
     test_an_area_stays_an_area_through_clipping();
     test_simplification_drops_collinear_points();
+    test_the_archive_does_not_depend_on_the_thread_count();
+    test_every_tile_matches_the_serial_tiler();
 
     spdlog::set_level(spdlog::level::info);
     if (failures != 0)
@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//
+// What the serial tiler wrote for test_tiler.cpp's addSerialFixture(), tile by
+// tile: the oracle test_every_tile_matches_the_serial_tiler holds the
+// parallel tiler to.
+//
+// Cut from Tiler::write() as it was before tiles were built a square at a time
+// -- one thread, one hash map of tiles per zoom -- over the fixture at z12-z14,
+// reading every tile back out of the archive, inflating it, and decoding it.
+// The serial tiler is gone, so this cannot be regenerated from it. A change
+// that alters tiles ON PURPOSE regenerates it from the current tiler at one
+// thread, and says in its commit which tiles moved and why.
+#ifndef MAP_BUILD_TESTS_TILER_SERIAL_TILES_H
+#define MAP_BUILD_TESTS_TILER_SERIAL_TILES_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace
+{
+
+struct SerialTile
+{
+    std::uint8_t z;
+    std::uint32_t x;
+    // XYZ, as Archive::tile() takes it -- not the archive's flipped row.
+    std::uint32_t y;
+    std::size_t layers;
+    std::size_t features;
+    // The inflated tile, and its FNV-1a.
+    std::size_t bytes;
+    std::uint64_t hash;
+};
+
+// TileStats as the serial tiler reported them. It had one drop counter, for
+// features too small and too wide alike.
+constexpr std::uint64_t kSerialTileCount = 105;
+constexpr std::uint64_t kSerialMergedLines = 31;
+constexpr std::uint64_t kSerialDropped = 1;
+
+// z, x, y, layers, features, bytes, hash.
+constexpr SerialTile kSerialTiles[] = {
+    { 12, 705, 1640, 1, 1, 117, 0xd5cbf8229de4987fULL },
+    { 12, 706, 1639, 2, 5, 496, 0xf512af712cbae306ULL },
+    { 12, 706, 1640, 3, 6, 776, 0x60d223944587fc2cULL },
+    { 12, 706, 1641, 3, 4, 411, 0x50d5f53456c9a992ULL },
+    { 12, 707, 1639, 2, 4, 363, 0x64978e357fd16069ULL },
+    { 12, 707, 1640, 3, 6, 801, 0x14940d29763b6711ULL },
+    { 12, 707, 1641, 3, 6, 664, 0x6791b54455f2920eULL },
+    { 12, 708, 1640, 1, 2, 207, 0xd4c0d168201ee71bULL },
+    { 12, 708, 1641, 1, 1, 100, 0x5444da1b424fae19ULL },
+    { 13, 1411, 3280, 1, 1, 114, 0x345554957aea4874ULL },
+    { 13, 1411, 3281, 1, 1, 105, 0x649795db40a81be5ULL },
+    { 13, 1412, 3279, 1, 4, 326, 0xecaa131fb099b618ULL },
+    { 13, 1412, 3280, 2, 4, 377, 0xccc517c4ed8d00acULL },
+    { 13, 1412, 3281, 2, 5, 361, 0x636538f9effa0f14ULL },
+    { 13, 1412, 3282, 3, 3, 273, 0x3eab2f24e7a17feaULL },
+    { 13, 1413, 3278, 1, 1, 91, 0x15a94fb35924360cULL },
+    { 13, 1413, 3279, 2, 6, 427, 0x328f0c8650b399bdULL },
+    { 13, 1413, 3280, 1, 7, 393, 0xf1c1589971524754ULL },
+    { 13, 1413, 3281, 2, 5, 335, 0xfb201d7ec98011f3ULL },
+    { 13, 1413, 3282, 1, 4, 224, 0xefaed74287c42c36ULL },
+    { 13, 1413, 3283, 1, 1, 83, 0x577f76c58047a41aULL },
+    { 13, 1414, 3279, 1, 3, 212, 0xc796e747794c4584ULL },
+    { 13, 1414, 3280, 2, 9, 551, 0xfd14c2a84a6e0377ULL },
+    { 13, 1414, 3281, 3, 6, 391, 0xea5009e7042ffab7ULL },
+    { 13, 1414, 3282, 3, 6, 487, 0x3729bb78f256fba0ULL },
+    { 13, 1414, 3283, 1, 3, 252, 0xa92b2cb65a07493cULL },
+    { 13, 1415, 3278, 2, 3, 230, 0x7d2208176abab2e9ULL },
+    { 13, 1415, 3279, 2, 4, 319, 0xd91b145e488a00b6ULL },
+    { 13, 1415, 3280, 2, 8, 465, 0xe5e9992a615fffc2ULL },
+    { 13, 1415, 3281, 1, 4, 267, 0x5e83265946fa848eULL },
+    { 13, 1415, 3282, 1, 3, 268, 0xbd5a427b0f15ffbfULL },
+    { 13, 1415, 3283, 1, 2, 172, 0xa827d2c939311793ULL },
+    { 13, 1416, 3280, 1, 2, 180, 0x2bf65424f3f8d2abULL },
+    { 13, 1416, 3281, 1, 2, 199, 0xb96d05024e2d7b99ULL },
+    { 13, 1416, 3282, 1, 1, 100, 0x8072420bedf30338ULL },
+    { 14, 2823, 6560, 1, 1, 105, 0x09f86c56c9d41e00ULL },
+    { 14, 2823, 6561, 1, 1, 110, 0x2793bf17866e8baaULL },
+    { 14, 2823, 6562, 1, 1, 105, 0x5c36e23294c18f98ULL },
+    { 14, 2824, 6559, 1, 2, 142, 0x66dafb334d7cdc0fULL },
+    { 14, 2824, 6560, 1, 1, 104, 0x47f46d0655bec504ULL },
+    { 14, 2824, 6561, 1, 2, 204, 0xb6cf7a43791492f0ULL },
+    { 14, 2824, 6562, 2, 4, 301, 0x10d37f877132375cULL },
+    { 14, 2825, 6558, 1, 3, 236, 0x9177838e76e4ed20ULL },
+    { 14, 2825, 6559, 1, 3, 232, 0xa7b157f09366d675ULL },
+    { 14, 2825, 6560, 2, 2, 210, 0x4ed4a0ba77f4ed23ULL },
+    { 14, 2825, 6561, 2, 4, 329, 0x3f6448db6bb0df2cULL },
+    { 14, 2825, 6562, 1, 2, 126, 0xf5ba3591bd156ec3ULL },
+    { 14, 2825, 6563, 1, 1, 95, 0xde55221b64c8e724ULL },
+    { 14, 2825, 6564, 3, 3, 209, 0xeebda2eed95521ccULL },
+    { 14, 2825, 6565, 1, 1, 113, 0xcaf44e20a4a61b0fULL },
+    { 14, 2826, 6558, 1, 2, 205, 0x658f0011a1f59305ULL },
+    { 14, 2826, 6559, 1, 2, 164, 0xb93e0fc3d62627cdULL },
+    { 14, 2826, 6560, 1, 2, 178, 0x31e739c220d156eeULL },
+    { 14, 2826, 6561, 1, 5, 286, 0x933e6bd43eabc935ULL },
+    { 14, 2826, 6562, 2, 4, 273, 0xc73a4fb1d6f9d568ULL },
+    { 14, 2826, 6563, 1, 1, 132, 0xa0c023483d138d26ULL },
+    { 14, 2826, 6565, 1, 2, 157, 0x36668df73304d3d8ULL },
+    { 14, 2827, 6557, 1, 1, 91, 0xf9ad723217b033dfULL },
+    { 14, 2827, 6558, 2, 2, 215, 0xedb8b7eb25419538ULL },
+    { 14, 2827, 6559, 2, 2, 163, 0x11d552b89d565aaeULL },
+    { 14, 2827, 6560, 1, 2, 192, 0xa0515347b40572d9ULL },
+    { 14, 2827, 6561, 1, 4, 189, 0x2a8c486846738751ULL },
+    { 14, 2827, 6562, 1, 1, 63, 0xcebbda02000e50daULL },
+    { 14, 2827, 6563, 1, 1, 133, 0x2221b189e38ad8b8ULL },
+    { 14, 2827, 6565, 1, 2, 146, 0x31bc724280d4cef5ULL },
+    { 14, 2827, 6566, 1, 1, 84, 0x58f5df0b6472fdffULL },
+    { 14, 2828, 6559, 1, 1, 67, 0xd6b5fbf751c7f338ULL },
+    { 14, 2828, 6560, 1, 3, 183, 0x701cc9a47b82feedULL },
+    { 14, 2828, 6561, 1, 2, 103, 0x94a73019b5ceec42ULL },
+    { 14, 2828, 6562, 2, 2, 104, 0x67f468a3c6817578ULL },
+    { 14, 2828, 6565, 2, 2, 237, 0x91c7116304f2c5d1ULL },
+    { 14, 2828, 6566, 1, 1, 104, 0x6c0f01769fa870fdULL },
+    { 14, 2829, 6558, 1, 2, 161, 0x10667b9ade962899ULL },
+    { 14, 2829, 6559, 1, 2, 166, 0xdececee4ba3210e4ULL },
+    { 14, 2829, 6560, 1, 6, 399, 0x51a97243b71d6b4fULL },
+    { 14, 2829, 6561, 2, 5, 310, 0xc1bf8a1b21a169fcULL },
+    { 14, 2829, 6562, 2, 4, 240, 0x46a9d7a107e8a725ULL },
+    { 14, 2829, 6563, 2, 3, 258, 0x40c1c21654c8165dULL },
+    { 14, 2829, 6565, 2, 4, 350, 0x071b2377f0d3f139ULL },
+    { 14, 2829, 6566, 1, 2, 193, 0x2a54d1e4a25d1154ULL },
+    { 14, 2830, 6557, 1, 2, 170, 0x9aa9b560b4d725deULL },
+    { 14, 2830, 6558, 1, 2, 173, 0xc654f275fa9bd761ULL },
+    { 14, 2830, 6559, 1, 1, 113, 0x247537e0ddf470e0ULL },
+    { 14, 2830, 6560, 2, 7, 390, 0xb54eed0281a40784ULL },
+    { 14, 2830, 6561, 2, 5, 290, 0x2b0e0107aea23542ULL },
+    { 14, 2830, 6562, 1, 4, 235, 0x3b5426d4d7638cb0ULL },
+    { 14, 2830, 6564, 1, 1, 89, 0x906e678373f4bfe5ULL },
+    { 14, 2830, 6565, 1, 2, 224, 0xb6e63b98c0e14d6eULL },
+    { 14, 2830, 6566, 1, 1, 119, 0xa2c17814b69d404cULL },
+    { 14, 2831, 6557, 2, 2, 167, 0x5a15119e75430a8dULL },
+    { 14, 2831, 6558, 2, 2, 145, 0x8cde9a82058a8075ULL },
+    { 14, 2831, 6559, 1, 3, 237, 0xf2f44348ab4d327eULL },
+    { 14, 2831, 6560, 1, 2, 148, 0x20ddc9afb3b439a0ULL },
+    { 14, 2831, 6561, 1, 2, 176, 0xc35096c2c64ee320ULL },
+    { 14, 2831, 6562, 1, 4, 245, 0xe211458bb295c594ULL },
+    { 14, 2831, 6563, 1, 1, 124, 0x6ed47a815dedcd5dULL },
+    { 14, 2831, 6566, 1, 1, 97, 0x858b3bf2a4e72b05ULL },
+    { 14, 2832, 6560, 1, 1, 104, 0x1901cddf9062d451ULL },
+    { 14, 2832, 6561, 1, 1, 124, 0xabc5e9e527250213ULL },
+    { 14, 2832, 6562, 1, 2, 162, 0xb93f4ce0d9a08b3dULL },
+    { 14, 2832, 6563, 1, 2, 173, 0x7b4e9232c31e2a71ULL },
+    { 14, 2832, 6564, 1, 1, 100, 0x7667d79d63e7d473ULL },
+    { 14, 2833, 6561, 1, 2, 152, 0xd0786a683b7d1bb4ULL },
+    { 14, 2833, 6562, 1, 2, 160, 0xff65fc44ce10565eULL },
+    { 14, 2833, 6563, 1, 2, 155, 0x37cd75d315037027ULL },
+};
+
+} // namespace
+
+#endif // MAP_BUILD_TESTS_TILER_SERIAL_TILES_H
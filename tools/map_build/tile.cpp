@@ -22,6 +22,8 @@ void addTileOptions(cxxopts::Options& options)
         cxxopts::value<std::string>()->default_value("map"))(
         "min-zoom", "Lowest zoom to build.", cxxopts::value<std::uint64_t>()->default_value("0"))(
         "max-zoom", "Highest zoom to build.", cxxopts::value<std::uint64_t>()->default_value("14"))(
+        "threads", "Threads decoding the PBF and building tiles. 0 is one per core.",
+        cxxopts::value<std::uint64_t>()->default_value("0"))(
         "quiet", "No progress lines.", cxxopts::value<bool>()->default_value("false"));
 }
 
@@ -37,6 +39,7 @@ int runTile(cli::Context& context)
     ExtractOptions extractOptions;
     extractOptions.input = *input;
     extractOptions.progressEvery = context.flag("quiet") ? 0 : 2000;
+    extractOptions.threads = static_cast<std::size_t>(context.uintOr("threads", 0));
 
     Tiler tiler;
 
@@ -61,6 +64,7 @@ int runTile(cli::Context& context)
     tileOptions.minZoom = static_cast<std::uint8_t>(context.uintOr("min-zoom", 0));
     tileOptions.maxZoom = static_cast<std::uint8_t>(context.uintOr("max-zoom", 14));
     tileOptions.progressEvery = context.flag("quiet") ? 0 : 5000;
+    tileOptions.threads = extractOptions.threads;
 
     auto writer = mbtiles::Writer::create(*output);
     if (!writer)
@@ -104,8 +108,8 @@ int runTile(cli::Context& context)
     cli::out("features   {}\n", tiled->features);
     cli::out("tiles      {}\n", tiled->tiles);
     cli::out("size       {} MB\n", bytes / (1024 * 1024));
-    cli::out("dropped    {} features too small or too spread out for their zoom\n",
-             tiled->droppedTooSmall);
+    cli::out("dropped    {} features too small for their zoom, {} too wide\n",
+             tiled->droppedTooSmall, tiled->droppedTooWide);
     cli::out("\ntiles per zoom:\n");
     for (const auto& [zoom, count] : tiled->tilesPerZoom)
     {
@@ -3,8 +3,12 @@
 
 #include <algorithm>
 #include <cmath>
+#include <condition_variable>
 #include <map>
+#include <mutex>
 #include <numbers>
+#include <optional>
+#include <thread>
 #include <unordered_map>
 
 #include <nlohmann/json.hpp>
@@ -419,15 +423,7 @@ struct TileKey
     std::uint32_t x;
     std::uint32_t y;
 
-    friend bool operator==(const TileKey&, const TileKey&) = default;
-};
-
-struct TileKeyHash
-{
-    std::size_t operator()(const TileKey& key) const
-    {
-        return (static_cast<std::size_t>(key.x) << 32) ^ key.y;
-    }
+    friend auto operator<=>(const TileKey&, const TileKey&) = default;
 };
 
 // One layer under construction, with its own key/value dictionaries.
@@ -475,6 +471,136 @@ struct LayerBuilder
     }
 };
 
+
+// What a layer turned out to contain, accumulated as it is written.
+//
+// The FIELD LIST is gathered rather than declared, because the answer is a
+// property of the data and not of the code: `ref` exists in transportation
+// only because some road in this extract had one, and advertising a field no
+// feature carries sends a style looking for something no tile will ever
+// have. It also means a new attribute reaches the metadata by being written,
+// with no second place to update -- which is the failure this replaced, a
+// hardcoded triple of class/name/ref that quietly omitted everything else.
+struct LayerSummary
+{
+    std::uint8_t minZoom = 255;
+    std::uint8_t maxZoom = 0;
+    std::map<std::string, const char*> fields;
+
+    void note(const std::string& key, const char* type) { fields[key] = type; }
+
+    // Folded in bucket order, so a key noted twice ends with the same type at
+    // any thread count.
+    void merge(const LayerSummary& other)
+    {
+        minZoom = std::min(minZoom, other.minZoom);
+        maxZoom = std::max(maxZoom, other.maxZoom);
+        for (const auto& [key, type] : other.fields)
+        {
+            fields[key] = type;
+        }
+    }
+};
+
+// A feature's extent in world coordinates, every ring included.
+struct WorldBox
+{
+    double minX { 1.0 };
+    double minY { 1.0 };
+    double maxX { 0.0 };
+    double maxY { 0.0 };
+};
+
+// Buckets are squares of 2^kBucketShift tiles a side: 64 tiles at z14 is a
+// few kilometres, small enough that a city spreads over dozens of them and
+// large enough that a road is rarely in more than one. Below z3 the whole
+// zoom is one bucket, which is fine -- there are at most 64 tiles in it.
+constexpr std::uint8_t kBucketShift = 3;
+
+// The most tiles one feature's box may span at a zoom before it is dropped as
+// too wide to draw there -- see TileStats::droppedTooWide.
+constexpr std::uint64_t kMaxTilesPerFeature = 4096;
+
+// Run `produce(i)` for every i below `count` on `threads` workers, and hand
+// each result to `consume` on THIS thread, in index order.
+//
+// At most `window` results exist at once, so a slow consumer stalls the
+// workers instead of letting them build the whole zoom ahead of it -- which
+// would put back exactly the memory bucketing exists to save. The first
+// error `consume` returns stops the run; the workers finish what they hold
+// and it is dropped.
+template <typename T, typename Produce, typename Consume>
+mbtiles::Result<void> runInOrder(std::size_t count, std::size_t threads, std::size_t window,
+                                 const Produce& produce, const Consume& consume)
+{
+    std::mutex mutex;
+    // A result landed, for the consumer; a slot came free, for the workers.
+    std::condition_variable landed;
+    std::condition_variable freed;
+    std::vector<std::optional<T>> slots(window);
+    std::size_t next = 0;
+    std::size_t consumed = 0;
+    bool stopping = false;
+
+    const auto work = [&] {
+        while (true)
+        {
+            std::size_t index = 0;
+            {
+                std::unique_lock lock(mutex);
+                freed.wait(lock, [&] {
+                    return stopping || next >= count || next < consumed + window;
+                });
+                if (stopping || next >= count)
+                {
+                    return;
+                }
+                index = next++;
+            }
+
+            T result = produce(index);
+            {
+                std::lock_guard lock(mutex);
+                slots[index % window] = std::move(result);
+            }
+            landed.notify_one();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i)
+    {
+        workers.emplace_back(work);
+    }
+
+    mbtiles::Result<void> outcome;
+    for (std::size_t i = 0; i < count && outcome; ++i)
+    {
+        std::optional<T> result;
+        {
+            std::unique_lock lock(mutex);
+            landed.wait(lock, [&] { return slots[i % window].has_value(); });
+            result = std::move(slots[i % window]);
+            slots[i % window].reset();
+            ++consumed;
+        }
+        freed.notify_all();
+        outcome = consume(std::move(*result));
+    }
+
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    freed.notify_all();
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    return outcome;
+}
+
 } // namespace
 
 const char* layerFor(map_rules::RenderClass value)
@@ -637,87 +763,336 @@ void Tiler::add(DrawInput&& feature)
     mFeatures.push_back(std::move(prepared));
 }
 
-mbtiles::Result<TileStats> Tiler::write(mbtiles::Writer& writer, const TileOptions& options,
-                                        const std::string& name, std::int32_t west,
-                                        std::int32_t south, std::int32_t east, std::int32_t north)
+struct Tiler::Bucket
 {
-    TileStats stats;
-    stats.features = mFeatures.size();
-
-    // What the `json` metadata column will say. Filled in as features survive
-    // into tiles, never from the layer table up front -- see the note at the
-    // point it is written.
-    // What a layer turned out to contain, accumulated as it is written.
-    //
-    // The FIELD LIST is gathered rather than declared, because the answer is a
-    // property of the data and not of the code: `ref` exists in transportation
-    // only because some road in this extract had one, and advertising a field no
-    // feature carries sends a style looking for something no tile will ever
-    // have. It also means a new attribute reaches the metadata by being written,
-    // with no second place to update -- which is the failure this replaced, a
-    // hardcoded triple of class/name/ref that quietly omitted everything else.
-    struct LayerSummary
+    std::uint8_t z { 0 };
+    // The tiles it covers, inclusive.
+    std::uint32_t x0 { 0 };
+    std::uint32_t y0 { 0 };
+    std::uint32_t x1 { 0 };
+    std::uint32_t y1 { 0 };
+    // Indices into mFeatures, ascending -- the order the serial build took
+    // them in, and so the order features land in each tile.
+    std::vector<std::uint32_t> features;
+    // Parallel to `features`: whether this is the one bucket that counts it.
+    std::vector<std::uint8_t> home;
+
+    bool holds(std::uint32_t x, std::uint32_t y) const
     {
-        std::uint8_t minZoom = 255;
-        std::uint8_t maxZoom = 0;
-        std::map<std::string, const char*> fields;
+        return x >= x0 && x <= x1 && y >= y0 && y <= y1;
+    }
+};
 
-        void note(const std::string& key, const char* type) { fields[key] = type; }
+struct Tiler::BuiltBucket
+{
+    struct Encoded
+    {
+        std::uint32_t x { 0 };
+        std::uint32_t y { 0 };
+        std::vector<std::uint8_t> data;
     };
+
+    // Gzipped, in (x, y) order.
+    std::vector<Encoded> tiles;
+    // Only mergedLines, emptyTiles and the two drop counts are kept here; the rest
+    // is counted as the tiles are written.
+    TileStats stats;
     std::map<std::string, LayerSummary> summaries;
+};
 
-    for (std::uint8_t z = options.minZoom; z <= options.maxZoom; ++z)
-    {
-        const double side = static_cast<double>(1U << z);
-        const double extent = static_cast<double>(options.extent);
+mbtiles::Result<Tiler::BuiltBucket> Tiler::build(const Bucket& bucket,
+                                                  const TileOptions& options) const
+{
+    BuiltBucket built;
+
+    const std::uint8_t z = bucket.z;
+    const double side = static_cast<double>(1U << z);
+    const double extent = static_cast<double>(options.extent);
 
-        // Half a tile unit, in world coordinates. Simplifying to finer than the
-        // grid the tile is quantised to buys nothing at all.
-        const double tolerance = 0.5 / (side * extent);
+    // Half a tile unit, in world coordinates. Simplifying to finer than the
+    // grid the tile is quantised to buys nothing at all.
+    const double tolerance = 0.5 / (side * extent);
 
-        std::unordered_map<TileKey, std::map<std::string, LayerBuilder>, TileKeyHash> tiles;
+    // Ordered by (x, y), which is the order they are written in. A hash map
+    // here would write them in whatever order its buckets fell.
+    std::map<TileKey, std::map<std::string, LayerBuilder>> tiles;
+
+    std::vector<double> simplified;
+    std::vector<std::vector<double>> simplifiedRings;
+    std::vector<std::uint8_t> simplifiedInner;
+    std::vector<std::vector<double>> parts;
+    std::vector<std::uint8_t> partIsInner;
+
+    for (std::size_t n = 0; n < bucket.features.size(); ++n)
+    {
+        const Prepared& feature = mFeatures[bucket.features[n]];
+        // Per-feature counts are kept by ONE bucket, or a road drawn across
+        // three of them would be dropped three times.
+        const bool home = bucket.home[n] != 0;
 
-        std::vector<double> simplified;
-        std::vector<std::vector<double>> simplifiedRings;
-        std::vector<std::uint8_t> simplifiedInner;
-        std::vector<std::vector<double>> parts;
-        std::vector<std::uint8_t> partIsInner;
+        const char* layerName =
+            feature.layer[0] == '\0' ? layerFor(feature.renderClass) : feature.layer;
 
-        for (const Prepared& feature : mFeatures)
+        if (feature.isPoint)
         {
-            if (z < feature.minZoom)
+            // A LABEL. Neither simplified nor clipped, and emitted into
+            // exactly one tile -- the one it falls in.
+            //
+            // Not duplicated into the neighbours the way a renderer's own
+            // label buffer would: dashboard/widgets/map/labels.cpp gathers
+            // candidates across every visible tile before placing any of
+            // them, so a second copy would compete with the first for the
+            // same spot and one of the two would always lose.
+            const double px = feature.worldXY[0][0];
+            const double py = feature.worldXY[0][1];
+            const auto tx = static_cast<std::uint32_t>(
+                std::clamp<std::int64_t>(static_cast<std::int64_t>(std::floor(px * side)), 0,
+                                         static_cast<std::int64_t>(side) - 1));
+            const auto ty = static_cast<std::uint32_t>(
+                std::clamp<std::int64_t>(static_cast<std::int64_t>(std::floor(py * side)), 0,
+                                         static_cast<std::int64_t>(side) - 1));
+            if (!bucket.holds(tx, ty))
             {
-                // The clutter dial, applied at build time. A style can only ever
-                // be STRICTER than this: nothing can draw what the tile does not
-                // carry.
                 continue;
             }
 
-            const char* layerName =
-                feature.layer[0] == '\0' ? layerFor(feature.renderClass) : feature.layer;
-            if (layerName[0] == '\0')
+            auto& layers = tiles[TileKey { tx, ty }];
+            LayerBuilder& builder = layers[layerName];
+            if (builder.layer.name.empty())
+            {
+                builder.layer.name = layerName;
+                builder.layer.version = 2;
+                builder.layer.extent = options.extent;
+            }
+
+            mvt::Feature out;
+            out.type = mvt::GeomType::Point;
+            out.hasId = true;
+            out.id = static_cast<std::uint64_t>(feature.osmWayId);
+
+            if (!feature.name.empty())
+            {
+                out.tags.push_back(builder.key("name"));
+                out.tags.push_back(builder.value(feature.name));
+
+                // BOTH spellings, and the duplication is deliberate.
+                // dashboard/widgets/map/labels.cpp reads `name:latin`,
+                // because the archive tilemaker produced emitted only that
+                // and reading `name` returned an empty string for every
+                // place -- a map with no labels and no error anywhere.
+                // Writing both means the widget needs no change to read our
+                // tiles, and a future reader that asks for `name` is right
+                // too. It costs one varint pair per label.
+                out.tags.push_back(builder.key("name:latin"));
+                out.tags.push_back(builder.value(feature.name));
+            }
+
+            // A place says what it is with its kind; every other label
+            // layer carries a className instead. Both land on `class`,
+            // because that is the one attribute every style reads.
+            const char* pointClass = feature.placeKind != map_rules::PlaceKind::None
+                                         ? map_rules::to_string(feature.placeKind)
+                                         : feature.className;
+            if (pointClass[0] != '\0')
+            {
+                out.tags.push_back(builder.key("class"));
+                out.tags.push_back(builder.value(pointClass));
+            }
+            if (feature.labelRank != 255)
+            {
+                out.tags.push_back(builder.key("rank"));
+                out.tags.push_back(builder.number(feature.labelRank));
+            }
+            if (feature.population != 0)
+            {
+                out.tags.push_back(builder.key("population"));
+                out.tags.push_back(builder.number(feature.population));
+            }
+            for (const auto& [key, value] : feature.attributes)
+            {
+                out.tags.push_back(builder.key(key));
+                out.tags.push_back(builder.value(value));
+            }
+
+            out.rings.push_back({ mvt::Point {
+                static_cast<std::int32_t>(std::llround((px * side - tx) * extent)),
+                static_cast<std::int32_t>(std::llround((py * side - ty) * extent)) } });
+
+            builder.layer.features.push_back(std::move(out));
+
+            LayerSummary& summary = built.summaries[layerName];
+            summary.minZoom = std::min(summary.minZoom, z);
+            summary.maxZoom = std::max(summary.maxZoom, z);
+            if (pointClass[0] != '\0')
+            {
+                summary.note("class", "String");
+            }
+            if (!feature.name.empty())
+            {
+                summary.note("name", "String");
+                summary.note("name:latin", "String");
+            }
+            if (feature.labelRank != 255)
+            {
+                summary.note("rank", "Number");
+            }
+            if (feature.population != 0)
+            {
+                summary.note("population", "Number");
+            }
+            for (const auto& [key, value] : feature.attributes)
+            {
+                (void)value;
+                summary.note(key, "String");
+            }
+            continue;
+        }
+
+        // Every ring simplified, and every ring kept or dropped on its own
+        // merits. A hole too small to draw is dropped while its outer ring
+        // survives, which is right: the alternative is a lake with a
+        // one-pixel island stamped out of it.
+        simplifiedRings.clear();
+        simplifiedInner.clear();
+        for (std::size_t r = 0; r < feature.worldXY.size(); ++r)
+        {
+            simplify(feature.worldXY[r], tolerance, simplified);
+            // Four values is two points, the shortest line. A polygon needs
+            // three points, or it is a ring with no inside.
+            if (simplified.size() < (feature.isArea ? 6u : 4u))
             {
                 continue;
             }
+            simplifiedRings.push_back(simplified);
+            simplifiedInner.push_back(feature.ringIsInner[r]);
+        }
+        // An area whose FIRST surviving ring is a hole has lost its outside;
+        // there is nothing left to fill.
+        if (simplifiedRings.empty() || (feature.isArea && simplifiedInner[0] != 0))
+        {
+            if (home)
+            {
+                ++built.stats.droppedTooSmall;
+            }
+            continue;
+        }
 
-            if (feature.isPoint)
+        // Bounding box -> tile range. The cheap answer, and the right one:
+        // walking the line to find only the tiles it really crosses saves
+        // work on long diagonals and costs more everywhere else.
+        double minX = simplifiedRings[0][0];
+        double maxX = simplifiedRings[0][0];
+        double minY = simplifiedRings[0][1];
+        double maxY = simplifiedRings[0][1];
+        for (const std::vector<double>& ring : simplifiedRings)
+        {
+            for (std::size_t i = 0; i + 1 < ring.size(); i += 2)
             {
-                // A LABEL. Neither simplified nor clipped, and emitted into
-                // exactly one tile -- the one it falls in.
-                //
-                // Not duplicated into the neighbours the way a renderer's own
-                // label buffer would: dashboard/widgets/map/labels.cpp gathers
-                // candidates across every visible tile before placing any of
-                // them, so a second copy would compete with the first for the
-                // same spot and one of the two would always lose.
-                const double px = feature.worldXY[0][0];
-                const double py = feature.worldXY[0][1];
-                const auto tx = static_cast<std::uint32_t>(
-                    std::clamp<std::int64_t>(static_cast<std::int64_t>(std::floor(px * side)), 0,
-                                             static_cast<std::int64_t>(side) - 1));
-                const auto ty = static_cast<std::uint32_t>(
-                    std::clamp<std::int64_t>(static_cast<std::int64_t>(std::floor(py * side)), 0,
-                                             static_cast<std::int64_t>(side) - 1));
+                minX = std::min(minX, ring[i]);
+                maxX = std::max(maxX, ring[i]);
+                minY = std::min(minY, ring[i + 1]);
+                maxY = std::max(maxY, ring[i + 1]);
+            }
+        }
+
+        // GENERALIZATION: drop what is smaller than the grid it would be
+        // drawn on.
+        //
+        // Simplification thins a shape's points but never removes the shape
+        // itself, so without this every cul-de-sac and back garden in the
+        // region is carried at every zoom -- at z9 that was an eight-fold
+        // size increase over the tiles this replaced, for detail occupying
+        // well under one pixel.
+        //
+        // The threshold is expressed in TILE UNITS so it means the same
+        // thing at every zoom: a feature whose whole bounding box is
+        // narrower than `minExtent` units cannot be told from a dot.
+        // Applied to the bounding box rather than to area, so that a long
+        // thin road survives while a small compact blob does not.
+        const double boxUnits =
+            std::max(maxX - minX, maxY - minY) * side * extent;
+        if (boxUnits < options.minExtent)
+        {
+            if (home)
+            {
+                ++built.stats.droppedTooSmall;
+            }
+            continue;
+        }
+
+        const auto clampTile = [&](double v) {
+            const auto t = static_cast<std::int64_t>(std::floor(v * side));
+            return static_cast<std::uint32_t>(
+                std::clamp<std::int64_t>(t, 0, static_cast<std::int64_t>(side) - 1));
+        };
+
+        const std::uint32_t x0 = clampTile(minX);
+        const std::uint32_t x1 = clampTile(maxX);
+        const std::uint32_t y0 = clampTile(minY);
+        const std::uint32_t y1 = clampTile(maxY);
+
+        // A feature spanning a huge tile range at high zoom is a coastline
+        // or a boundary; emitting it into ten thousand tiles would dominate
+        // the build for something nobody can see moving.
+        if ((static_cast<std::uint64_t>(x1 - x0) + 1) * (y1 - y0 + 1) > kMaxTilesPerFeature)
+        {
+            if (home)
+            {
+                ++built.stats.droppedTooWide;
+            }
+            continue;
+        }
+
+        // Only this bucket's share. The rest of the range is some other
+        // bucket's, which is handed the same feature and makes the same
+        // decisions about it up to here.
+        const std::uint32_t bx1 = std::min(x1, bucket.x1);
+        const std::uint32_t by1 = std::min(y1, bucket.y1);
+        for (std::uint32_t tx = std::max(x0, bucket.x0); tx <= bx1; ++tx)
+        {
+            for (std::uint32_t ty = std::max(y0, bucket.y0); ty <= by1; ++ty)
+            {
+                // The tile's own rectangle, in world coordinates, grown by
+                // the buffer. Without the buffer every line stops dead at
+                // the boundary and the renderer's joins leave a seam.
+                const double bufferWorld = options.buffer / (side * extent);
+                const Rect rect { tx / side - bufferWorld, ty / side - bufferWorld,
+                                  (tx + 1) / side + bufferWorld,
+                                  (ty + 1) / side + bufferWorld };
+
+                parts.clear();
+                partIsInner.clear();
+                if (feature.isArea)
+                {
+                    for (std::size_t r = 0; r < simplifiedRings.size(); ++r)
+                    {
+                        auto clipped = clipPolygon(simplifiedRings[r], rect);
+                        if (clipped.size() >= 6)
+                        {
+                            parts.push_back(std::move(clipped));
+                            partIsInner.push_back(simplifiedInner[r]);
+                        }
+                    }
+                    // A hole that survived while its outer ring was clipped
+                    // away would be filled as if it were the shape.
+                    if (!parts.empty() && partIsInner[0] != 0)
+                    {
+                        parts.clear();
+                    }
+                }
+                else
+                {
+                    for (const std::vector<double>& ring : simplifiedRings)
+                    {
+                        clipLine(ring, rect, parts);
+                    }
+                    partIsInner.assign(parts.size(), 0);
+                }
+
+                if (parts.empty())
+                {
+                    continue;
+                }
 
                 auto& layers = tiles[TileKey { tx, ty }];
                 LayerBuilder& builder = layers[layerName];
@@ -729,509 +1104,449 @@ mbtiles::Result<TileStats> Tiler::write(mbtiles::Writer& writer, const TileOptio
                 }
 
                 mvt::Feature out;
-                out.type = mvt::GeomType::Point;
-                out.hasId = true;
-                out.id = static_cast<std::uint64_t>(feature.osmWayId);
+                out.type = feature.isArea ? mvt::GeomType::Polygon : mvt::GeomType::LineString;
 
-                if (!feature.name.empty())
+                // THE SOURCE OSM WAY ID, stamped into the tile.
+                //
+                // This is what lets a client recolour the road it is on, or
+                // draw a route by highlighting the features it already has,
+                // instead of overlaying a full-precision polyline that
+                // visibly diverges from the simplified geometry at low zoom.
+                // It costs a varint per feature.
+                //
+                // A WAY ID AND NOT A SEGMENT ID, deliberately, and the two
+                // are not interchangeable. The tiler draws the whole way
+                // unsplit, while the graph splits it at every junction, so
+                // one drawn feature covers many segments and no single
+                // segment id describes it. The graph's WayIndex section is
+                // the join in that direction, and SegmentId carries the way
+                // id in its high bits for the other -- so nothing is lost
+                // by stamping the coarser of the two.
+                if (feature.osmWayId != 0)
                 {
-                    out.tags.push_back(builder.key("name"));
-                    out.tags.push_back(builder.value(feature.name));
-
-                    // BOTH spellings, and the duplication is deliberate.
-                    // dashboard/widgets/map/labels.cpp reads `name:latin`,
-                    // because the archive tilemaker produced emitted only that
-                    // and reading `name` returned an empty string for every
-                    // place -- a map with no labels and no error anywhere.
-                    // Writing both means the widget needs no change to read our
-                    // tiles, and a future reader that asks for `name` is right
-                    // too. It costs one varint pair per label.
-                    out.tags.push_back(builder.key("name:latin"));
-                    out.tags.push_back(builder.value(feature.name));
+                    out.hasId = true;
+                    out.id = static_cast<std::uint64_t>(feature.osmWayId);
                 }
 
-                // A place says what it is with its kind; every other label
-                // layer carries a className instead. Both land on `class`,
-                // because that is the one attribute every style reads.
-                const char* pointClass = feature.placeKind != map_rules::PlaceKind::None
-                                             ? map_rules::to_string(feature.placeKind)
-                                             : feature.className;
-                if (pointClass[0] != '\0')
-                {
-                    out.tags.push_back(builder.key("class"));
-                    out.tags.push_back(builder.value(pointClass));
-                }
-                if (feature.labelRank != 255)
-                {
-                    out.tags.push_back(builder.key("rank"));
-                    out.tags.push_back(builder.number(feature.labelRank));
-                }
-                if (feature.population != 0)
-                {
-                    out.tags.push_back(builder.key("population"));
-                    out.tags.push_back(builder.number(feature.population));
-                }
-                for (const auto& [key, value] : feature.attributes)
+                // A CLASS NAME WINS OVER THE RENDER CLASS, and the order
+                // matters: a runway is carried with a road's render class so
+                // it simplifies and clips like a line, but its class is
+                // "runway" and not "service". Roads set no class name and so
+                // fall through to the enum, where the render class IS the
+                // road class.
+                const char* roadClass = feature.className;
+                if (roadClass[0] == '\0')
                 {
-                    out.tags.push_back(builder.key(key));
-                    out.tags.push_back(builder.value(value));
+                    roadClass = roadClassFor(feature.renderClass);
                 }
-
-                out.rings.push_back({ mvt::Point {
-                    static_cast<std::int32_t>(std::llround((px * side - tx) * extent)),
-                    static_cast<std::int32_t>(std::llround((py * side - ty) * extent)) } });
-
-                builder.layer.features.push_back(std::move(out));
-
-                LayerSummary& summary = summaries[layerName];
-                summary.minZoom = std::min(summary.minZoom, z);
-                summary.maxZoom = std::max(summary.maxZoom, z);
-                if (pointClass[0] != '\0')
+                if (roadClass[0] != '\0')
                 {
-                    summary.note("class", "String");
+                    out.tags.push_back(builder.key("class"));
+                    out.tags.push_back(builder.value(roadClass));
                 }
                 if (!feature.name.empty())
                 {
-                    summary.note("name", "String");
-                    summary.note("name:latin", "String");
+                    out.tags.push_back(builder.key("name"));
+                    out.tags.push_back(builder.value(feature.name));
+                    // Both spellings, for the same reason the label layer
+                    // writes both -- see the point path above.
+                    out.tags.push_back(builder.key("name:latin"));
+                    out.tags.push_back(builder.value(feature.name));
                 }
-                if (feature.labelRank != 255)
+                if (!feature.ref.empty())
                 {
-                    summary.note("rank", "Number");
+                    out.tags.push_back(builder.key("ref"));
+                    out.tags.push_back(builder.value(feature.ref));
                 }
-                if (feature.population != 0)
+                if (feature.adminLevel != 0)
                 {
-                    summary.note("population", "Number");
+                    out.tags.push_back(builder.key("admin_level"));
+                    out.tags.push_back(builder.number(feature.adminLevel));
                 }
-                for (const auto& [key, value] : feature.attributes)
+                // The posted limit, where OSM records one.
+                //
+                // ONLY AT AND ABOVE THE MERGE THRESHOLD, and that is the
+                // whole subtlety. Below it, mergeLines() folds line features
+                // that share byte-identical tags into one multi-part
+                // feature, and that is what keeps low-zoom tiles small.
+                // A per-road speed splits roads that would otherwise merge,
+                // so writing it everywhere would inflate exactly the tiles
+                // generalization exists to shrink -- to buy an attribute
+                // that means nothing at continental zoom anyway.
+                //
+                // `hasPosted` and not `postedKph != 0`: absence of the key
+                // has to mean "not tagged", which is a different fact from
+                // a limit of zero and is the one a consumer must not guess.
+                if (feature.hasPosted && z >= options.mergeBelowZoom)
                 {
-                    (void)value;
-                    summary.note(key, "String");
+                    out.tags.push_back(builder.key("maxspeed"));
+                    out.tags.push_back(builder.number(feature.postedKph));
                 }
-                continue;
-            }
-
-            // Every ring simplified, and every ring kept or dropped on its own
-            // merits. A hole too small to draw is dropped while its outer ring
-            // survives, which is right: the alternative is a lake with a
-            // one-pixel island stamped out of it.
-            simplifiedRings.clear();
-            simplifiedInner.clear();
-            for (std::size_t r = 0; r < feature.worldXY.size(); ++r)
-            {
-                simplify(feature.worldXY[r], tolerance, simplified);
-                // Four values is two points, the shortest line. A polygon needs
-                // three points, or it is a ring with no inside.
-                if (simplified.size() < (feature.isArea ? 6u : 4u))
+                // Grade separation, and the rest of the per-road detail.
+                //
+                // All of it behind the same merge threshold as `maxspeed`,
+                // and for the same reason: mergeLines() folds features with
+                // byte-identical tags into one, so a per-road attribute
+                // splits roads that would otherwise merge and inflates the
+                // low-zoom tiles generalization exists to shrink. None of
+                // this means anything at continental zoom anyway -- an
+                // overpass is a few pixels of a grey smear.
+                if (z >= options.mergeBelowZoom)
                 {
-                    continue;
+                    // `brunnel`, spelled the way OpenMapTiles spells it,
+                    // because the whole schema is built to that vocabulary
+                    // and the widget's style names follow it. Absent means
+                    // at grade, which is the overwhelming majority -- a key
+                    // written on every road would cost more than it says.
+                    if (feature.isBridge)
+                    {
+                        out.tags.push_back(builder.key("brunnel"));
+                        out.tags.push_back(builder.value("bridge"));
+                    }
+                    else if (feature.isTunnel)
+                    {
+                        out.tags.push_back(builder.key("brunnel"));
+                        out.tags.push_back(builder.value("tunnel"));
+                    }
+                    // OSM's own `layer`, which is what stacks one bridge
+                    // over another. Zero is the default and is not written.
+                    if (feature.osmLayer != 0)
+                    {
+                        out.tags.push_back(builder.key("layer"));
+                        out.tags.push_back(builder.number(feature.osmLayer));
+                    }
+                    if (feature.laneCount != 0)
+                    {
+                        out.tags.push_back(builder.key("lanes"));
+                        out.tags.push_back(builder.number(feature.laneCount));
+                    }
+                    // 1 forward, -1 backward, absent for two-way. The same
+                    // encoding OpenMapTiles uses, and the reason -1 exists
+                    // rather than a second key is that a way's direction is
+                    // its geometry's direction.
+                    if (feature.onewayForward != feature.onewayBackward)
+                    {
+                        out.tags.push_back(builder.key("oneway"));
+                        out.tags.push_back(builder.number(feature.onewayForward ? 1 : -1));
+                    }
                 }
-                simplifiedRings.push_back(simplified);
-                simplifiedInner.push_back(feature.ringIsInner[r]);
-            }
-            // An area whose FIRST surviving ring is a hole has lost its outside;
-            // there is nothing left to fill.
-            if (simplifiedRings.empty() || (feature.isArea && simplifiedInner[0] != 0))
-            {
-                ++stats.droppedTooSmall;
-                continue;
-            }
-
-            // Bounding box -> tile range. The cheap answer, and the right one:
-            // walking the line to find only the tiles it really crosses saves
-            // work on long diagonals and costs more everywhere else.
-            double minX = simplifiedRings[0][0];
-            double maxX = simplifiedRings[0][0];
-            double minY = simplifiedRings[0][1];
-            double maxY = simplifiedRings[0][1];
-            for (const std::vector<double>& ring : simplifiedRings)
-            {
-                for (std::size_t i = 0; i + 1 < ring.size(); i += 2)
+                for (const auto& [key, value] : feature.attributes)
                 {
-                    minX = std::min(minX, ring[i]);
-                    maxX = std::max(maxX, ring[i]);
-                    minY = std::min(minY, ring[i + 1]);
-                    maxY = std::max(maxY, ring[i + 1]);
+                    out.tags.push_back(builder.key(key));
+                    out.tags.push_back(builder.value(value));
                 }
-            }
 
-            // GENERALIZATION: drop what is smaller than the grid it would be
-            // drawn on.
-            //
-            // Simplification thins a shape's points but never removes the shape
-            // itself, so without this every cul-de-sac and back garden in the
-            // region is carried at every zoom -- at z9 that was an eight-fold
-            // size increase over the tiles this replaced, for detail occupying
-            // well under one pixel.
-            //
-            // The threshold is expressed in TILE UNITS so it means the same
-            // thing at every zoom: a feature whose whole bounding box is
-            // narrower than `minExtent` units cannot be told from a dot.
-            // Applied to the bounding box rather than to area, so that a long
-            // thin road survives while a small compact blob does not.
-            const double boxUnits =
-                std::max(maxX - minX, maxY - minY) * side * extent;
-            if (boxUnits < options.minExtent)
-            {
-                ++stats.droppedTooSmall;
-                continue;
-            }
-
-            const auto clampTile = [&](double v) {
-                const auto t = static_cast<std::int64_t>(std::floor(v * side));
-                return static_cast<std::uint32_t>(
-                    std::clamp<std::int64_t>(t, 0, static_cast<std::int64_t>(side) - 1));
-            };
-
-            const std::uint32_t x0 = clampTile(minX);
-            const std::uint32_t x1 = clampTile(maxX);
-            const std::uint32_t y0 = clampTile(minY);
-            const std::uint32_t y1 = clampTile(maxY);
-
-            // A feature spanning a huge tile range at high zoom is a coastline
-            // or a boundary; emitting it into ten thousand tiles would dominate
-            // the build for something nobody can see moving.
-            if ((static_cast<std::uint64_t>(x1 - x0) + 1) * (y1 - y0 + 1) > 4096)
-            {
-                ++stats.droppedTooSmall;
-                continue;
-            }
-
-            for (std::uint32_t tx = x0; tx <= x1; ++tx)
-            {
-                for (std::uint32_t ty = y0; ty <= y1; ++ty)
+                for (std::size_t p = 0; p < parts.size(); ++p)
                 {
-                    // The tile's own rectangle, in world coordinates, grown by
-                    // the buffer. Without the buffer every line stops dead at
-                    // the boundary and the renderer's joins leave a seam.
-                    const double bufferWorld = options.buffer / (side * extent);
-                    const Rect rect { tx / side - bufferWorld, ty / side - bufferWorld,
-                                      (tx + 1) / side + bufferWorld,
-                                      (ty + 1) / side + bufferWorld };
-
-                    parts.clear();
-                    partIsInner.clear();
-                    if (feature.isArea)
-                    {
-                        for (std::size_t r = 0; r < simplifiedRings.size(); ++r)
-                        {
-                            auto clipped = clipPolygon(simplifiedRings[r], rect);
-                            if (clipped.size() >= 6)
-                            {
-                                parts.push_back(std::move(clipped));
-                                partIsInner.push_back(simplifiedInner[r]);
-                            }
-                        }
-                        // A hole that survived while its outer ring was clipped
-                        // away would be filled as if it were the shape.
-                        if (!parts.empty() && partIsInner[0] != 0)
-                        {
-                            parts.clear();
-                        }
-                    }
-                    else
+                    const std::vector<double>& part = parts[p];
+                    std::vector<mvt::Point> ring;
+                    ring.reserve(part.size() / 2);
+                    for (std::size_t i = 0; i + 1 < part.size(); i += 2)
                     {
-                        for (const std::vector<double>& ring : simplifiedRings)
-                        {
-                            clipLine(ring, rect, parts);
-                        }
-                        partIsInner.assign(parts.size(), 0);
+                        // World -> tile-local. Rounded rather than
+                        // truncated: truncation biases every coordinate
+                        // half a unit towards the tile origin, which over a
+                        // whole pyramid reads as a systematic offset.
+                        ring.push_back(mvt::Point {
+                            static_cast<std::int32_t>(
+                                std::llround((part[i] * side - tx) * extent)),
+                            static_cast<std::int32_t>(
+                                std::llround((part[i + 1] * side - ty) * extent)) });
                     }
-
-                    if (parts.empty())
+                    // A LINE needs two points; a RING needs three. The
+                    // encoder enforces this too, and does so as the last
+                    // line of defence for the whole tile -- see the note in
+                    // mvt/encode.cpp. Here it merely avoids building
+                    // geometry that would be thrown away.
+                    const std::size_t needed = feature.isArea ? 3 : 2;
+                    if (ring.size() < needed)
                     {
                         continue;
                     }
 
-                    auto& layers = tiles[TileKey { tx, ty }];
-                    LayerBuilder& builder = layers[layerName];
-                    if (builder.layer.name.empty())
-                    {
-                        builder.layer.name = layerName;
-                        builder.layer.version = 2;
-                        builder.layer.extent = options.extent;
-                    }
-
-                    mvt::Feature out;
-                    out.type = feature.isArea ? mvt::GeomType::Polygon : mvt::GeomType::LineString;
-
-                    // THE SOURCE OSM WAY ID, stamped into the tile.
+                    // WINDING IS SET HERE, AND ONLY HERE.
+                    //
+                    // The vector tile format carries no flag for a hole:
+                    // the only thing separating an island from the lake
+                    // around it is which way its ring turns. An exterior
+                    // ring must have positive area in tile coordinates
+                    // (mvt::isExteriorRing), an interior ring negative.
                     //
-                    // This is what lets a client recolour the road it is on, or
-                    // draw a route by highlighting the features it already has,
-                    // instead of overlaying a full-precision polyline that
-                    // visibly diverges from the simplified geometry at low zoom.
-                    // It costs a varint per feature.
+                    // The roles come from the relation, and they have been
+                    // carried this far as roles precisely so this decision
+                    // happens after projection -- Web Mercator's y grows
+                    // southward, so a ring's sign flips somewhere between
+                    // latitude and the tile, and deciding earlier means
+                    // deciding twice.
                     //
-                    // A WAY ID AND NOT A SEGMENT ID, deliberately, and the two
-                    // are not interchangeable. The tiler draws the whole way
-                    // unsplit, while the graph splits it at every junction, so
-                    // one drawn feature covers many segments and no single
-                    // segment id describes it. The graph's WayIndex section is
-                    // the join in that direction, and SegmentId carries the way
-                    // id in its high bits for the other -- so nothing is lost
-                    // by stamping the coarser of the two.
-                    if (feature.osmWayId != 0)
+                    // Get it backwards and the renderer fills the island and
+                    // punches out the lake.
+                    if (feature.isArea)
                     {
-                        out.hasId = true;
-                        out.id = static_cast<std::uint64_t>(feature.osmWayId);
+                        const bool wantExterior = partIsInner[p] == 0;
+                        if (mvt::isExteriorRing(ring) != wantExterior)
+                        {
+                            std::reverse(ring.begin(), ring.end());
+                        }
                     }
 
-                    // A CLASS NAME WINS OVER THE RENDER CLASS, and the order
-                    // matters: a runway is carried with a road's render class so
-                    // it simplifies and clips like a line, but its class is
-                    // "runway" and not "service". Roads set no class name and so
-                    // fall through to the enum, where the render class IS the
-                    // road class.
-                    const char* roadClass = feature.className;
-                    if (roadClass[0] == '\0')
-                    {
-                        roadClass = roadClassFor(feature.renderClass);
-                    }
+                    out.rings.push_back(std::move(ring));
+                }
+
+                if (!out.rings.empty())
+                {
+                    // Which layers exist, and over which zooms, is not
+                    // knowable until the pyramid is built -- a layer whose
+                    // every feature was clipped away or simplified to
+                    // nothing must not be advertised. So it is recorded
+                    // here, where a feature actually survived into a tile,
+                    // and written out as `json` at the end.
+                    LayerSummary& summary = built.summaries[layerName];
+                    summary.minZoom = std::min(summary.minZoom, z);
+                    summary.maxZoom = std::max(summary.maxZoom, z);
                     if (roadClass[0] != '\0')
                     {
-                        out.tags.push_back(builder.key("class"));
-                        out.tags.push_back(builder.value(roadClass));
+                        summary.note("class", "String");
                     }
                     if (!feature.name.empty())
                     {
-                        out.tags.push_back(builder.key("name"));
-                        out.tags.push_back(builder.value(feature.name));
-                        // Both spellings, for the same reason the label layer
-                        // writes both -- see the point path above.
-                        out.tags.push_back(builder.key("name:latin"));
-                        out.tags.push_back(builder.value(feature.name));
+                        summary.note("name", "String");
+                        summary.note("name:latin", "String");
                     }
                     if (!feature.ref.empty())
                     {
-                        out.tags.push_back(builder.key("ref"));
-                        out.tags.push_back(builder.value(feature.ref));
+                        summary.note("ref", "String");
                     }
                     if (feature.adminLevel != 0)
                     {
-                        out.tags.push_back(builder.key("admin_level"));
-                        out.tags.push_back(builder.number(feature.adminLevel));
-                    }
-                    // The posted limit, where OSM records one.
-                    //
-                    // ONLY AT AND ABOVE THE MERGE THRESHOLD, and that is the
-                    // whole subtlety. Below it, mergeLines() folds line features
-                    // that share byte-identical tags into one multi-part
-                    // feature, and that is what keeps low-zoom tiles small.
-                    // A per-road speed splits roads that would otherwise merge,
-                    // so writing it everywhere would inflate exactly the tiles
-                    // generalization exists to shrink -- to buy an attribute
-                    // that means nothing at continental zoom anyway.
-                    //
-                    // `hasPosted` and not `postedKph != 0`: absence of the key
-                    // has to mean "not tagged", which is a different fact from
-                    // a limit of zero and is the one a consumer must not guess.
-                    if (feature.hasPosted && z >= options.mergeBelowZoom)
-                    {
-                        out.tags.push_back(builder.key("maxspeed"));
-                        out.tags.push_back(builder.number(feature.postedKph));
-                    }
-                    // Grade separation, and the rest of the per-road detail.
-                    //
-                    // All of it behind the same merge threshold as `maxspeed`,
-                    // and for the same reason: mergeLines() folds features with
-                    // byte-identical tags into one, so a per-road attribute
-                    // splits roads that would otherwise merge and inflates the
-                    // low-zoom tiles generalization exists to shrink. None of
-                    // this means anything at continental zoom anyway -- an
-                    // overpass is a few pixels of a grey smear.
-                    if (z >= options.mergeBelowZoom)
-                    {
-                        // `brunnel`, spelled the way OpenMapTiles spells it,
-                        // because the whole schema is built to that vocabulary
-                        // and the widget's style names follow it. Absent means
-                        // at grade, which is the overwhelming majority -- a key
-                        // written on every road would cost more than it says.
-                        if (feature.isBridge)
-                        {
-                            out.tags.push_back(builder.key("brunnel"));
-                            out.tags.push_back(builder.value("bridge"));
-                        }
-                        else if (feature.isTunnel)
-                        {
-                            out.tags.push_back(builder.key("brunnel"));
-                            out.tags.push_back(builder.value("tunnel"));
-                        }
-                        // OSM's own `layer`, which is what stacks one bridge
-                        // over another. Zero is the default and is not written.
-                        if (feature.osmLayer != 0)
-                        {
-                            out.tags.push_back(builder.key("layer"));
-                            out.tags.push_back(builder.number(feature.osmLayer));
-                        }
-                        if (feature.laneCount != 0)
-                        {
-                            out.tags.push_back(builder.key("lanes"));
-                            out.tags.push_back(builder.number(feature.laneCount));
-                        }
-                        // 1 forward, -1 backward, absent for two-way. The same
-                        // encoding OpenMapTiles uses, and the reason -1 exists
-                        // rather than a second key is that a way's direction is
-                        // its geometry's direction.
-                        if (feature.onewayForward != feature.onewayBackward)
-                        {
-                            out.tags.push_back(builder.key("oneway"));
-                            out.tags.push_back(builder.number(feature.onewayForward ? 1 : -1));
-                        }
+                        summary.note("admin_level", "Number");
                     }
                     for (const auto& [key, value] : feature.attributes)
                     {
-                        out.tags.push_back(builder.key(key));
-                        out.tags.push_back(builder.value(value));
+                        (void)value;
+                        summary.note(key, "String");
                     }
 
-                    for (std::size_t p = 0; p < parts.size(); ++p)
-                    {
-                        const std::vector<double>& part = parts[p];
-                        std::vector<mvt::Point> ring;
-                        ring.reserve(part.size() / 2);
-                        for (std::size_t i = 0; i + 1 < part.size(); i += 2)
-                        {
-                            // World -> tile-local. Rounded rather than
-                            // truncated: truncation biases every coordinate
-                            // half a unit towards the tile origin, which over a
-                            // whole pyramid reads as a systematic offset.
-                            ring.push_back(mvt::Point {
-                                static_cast<std::int32_t>(
-                                    std::llround((part[i] * side - tx) * extent)),
-                                static_cast<std::int32_t>(
-                                    std::llround((part[i + 1] * side - ty) * extent)) });
-                        }
-                        // A LINE needs two points; a RING needs three. The
-                        // encoder enforces this too, and does so as the last
-                        // line of defence for the whole tile -- see the note in
-                        // mvt/encode.cpp. Here it merely avoids building
-                        // geometry that would be thrown away.
-                        const std::size_t needed = feature.isArea ? 3 : 2;
-                        if (ring.size() < needed)
-                        {
-                            continue;
-                        }
+                    builder.layer.features.push_back(std::move(out));
+                }
+            }
+        }
+    }
 
-                        // WINDING IS SET HERE, AND ONLY HERE.
-                        //
-                        // The vector tile format carries no flag for a hole:
-                        // the only thing separating an island from the lake
-                        // around it is which way its ring turns. An exterior
-                        // ring must have positive area in tile coordinates
-                        // (mvt::isExteriorRing), an interior ring negative.
-                        //
-                        // The roles come from the relation, and they have been
-                        // carried this far as roles precisely so this decision
-                        // happens after projection -- Web Mercator's y grows
-                        // southward, so a ring's sign flips somewhere between
-                        // latitude and the tile, and deciding earlier means
-                        // deciding twice.
-                        //
-                        // Get it backwards and the renderer fills the island and
-                        // punches out the lake.
-                        if (feature.isArea)
-                        {
-                            const bool wantExterior = partIsInner[p] == 0;
-                            if (mvt::isExteriorRing(ring) != wantExterior)
-                            {
-                                std::reverse(ring.begin(), ring.end());
-                            }
-                        }
+    for (auto& [key, layers] : tiles)
+    {
+        mvt::Tile tile;
+        for (auto& [layerName, builder] : layers)
+        {
+            if (!builder.layer.features.empty())
+            {
+                mergeLines(builder.layer, z, options.mergeBelowZoom, built.stats);
+                tile.layers.push_back(std::move(builder.layer));
+            }
+        }
+        if (tile.layers.empty())
+        {
+            ++built.stats.emptyTiles;
+            continue;
+        }
 
-                        out.rings.push_back(std::move(ring));
-                    }
+        auto encoded = mvt::encode(tile);
+        if (!encoded)
+        {
+            return mbtiles::query_error("tile " + std::to_string(z) + "/" +
+                                            std::to_string(key.x) + "/" +
+                                            std::to_string(key.y) + ": " +
+                                            mvt::to_string(encoded.error()),
+                                        0);
+        }
 
-                    if (!out.rings.empty())
-                    {
-                        // Which layers exist, and over which zooms, is not
-                        // knowable until the pyramid is built -- a layer whose
-                        // every feature was clipped away or simplified to
-                        // nothing must not be advertised. So it is recorded
-                        // here, where a feature actually survived into a tile,
-                        // and written out as `json` at the end.
-                        LayerSummary& summary = summaries[layerName];
-                        summary.minZoom = std::min(summary.minZoom, z);
-                        summary.maxZoom = std::max(summary.maxZoom, z);
-                        if (roadClass[0] != '\0')
-                        {
-                            summary.note("class", "String");
-                        }
-                        if (!feature.name.empty())
-                        {
-                            summary.note("name", "String");
-                            summary.note("name:latin", "String");
-                        }
-                        if (!feature.ref.empty())
-                        {
-                            summary.note("ref", "String");
-                        }
-                        if (feature.adminLevel != 0)
-                        {
-                            summary.note("admin_level", "Number");
-                        }
-                        for (const auto& [key, value] : feature.attributes)
-                        {
-                            (void)value;
-                            summary.note(key, "String");
-                        }
+        auto compressed = mvt::gzipCompress(*encoded);
+        if (!compressed)
+        {
+            return mbtiles::query_error("gzip failed", 0);
+        }
 
-                        builder.layer.features.push_back(std::move(out));
-                    }
-                }
+        built.tiles.push_back({ key.x, key.y, std::move(*compressed) });
+    }
+
+    return built;
+}
+
+mbtiles::Result<TileStats> Tiler::write(mbtiles::Writer& writer, const TileOptions& options,
+                                        const std::string& name, std::int32_t west,
+                                        std::int32_t south, std::int32_t east, std::int32_t north)
+{
+    TileStats stats;
+    stats.features = mFeatures.size();
+
+    // What the `json` metadata column will say. Filled in as features survive
+    // into tiles, never from the layer table up front -- see the note at the
+    // point it is written.
+    std::map<std::string, LayerSummary> summaries;
+
+    const std::size_t threads =
+        options.threads != 0 ? options.threads
+                             : std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+
+    // Every feature's extent, once. Binning needs it at every zoom and the
+    // geometry does not change between them.
+    std::vector<WorldBox> boxes;
+    boxes.reserve(mFeatures.size());
+    for (const Prepared& feature : mFeatures)
+    {
+        WorldBox box;
+        for (const std::vector<double>& ring : feature.worldXY)
+        {
+            for (std::size_t i = 0; i + 1 < ring.size(); i += 2)
+            {
+                box.minX = std::min(box.minX, ring[i]);
+                box.maxX = std::max(box.maxX, ring[i]);
+                box.minY = std::min(box.minY, ring[i + 1]);
+                box.maxY = std::max(box.maxY, ring[i + 1]);
             }
         }
+        boxes.push_back(box);
+    }
 
-        for (auto& [key, layers] : tiles)
+    for (std::uint8_t z = options.minZoom; z <= options.maxZoom; ++z)
+    {
+        const double side = static_cast<double>(1U << z);
+        const std::uint8_t shift = std::min(z, kBucketShift);
+        const auto clampTile = [&](double v) {
+            const auto t = static_cast<std::int64_t>(std::floor(v * side));
+            return static_cast<std::uint32_t>(
+                std::clamp<std::int64_t>(t, 0, static_cast<std::int64_t>(side) - 1));
+        };
+
+        // BINNING. Every feature goes to each bucket its UNSIMPLIFIED box
+        // touches. Simplification only ever keeps a subset of the points, so
+        // the box build() works from is inside this one and no tile is missed.
+        std::map<TileKey, Bucket> bins;
+        for (std::size_t index = 0; index < mFeatures.size(); ++index)
         {
-            mvt::Tile tile;
-            for (auto& [layerName, builder] : layers)
+            const Prepared& feature = mFeatures[index];
+            if (z < feature.minZoom)
             {
-                if (!builder.layer.features.empty())
-                {
-                    mergeLines(builder.layer, z, options.mergeBelowZoom, stats);
-                    tile.layers.push_back(std::move(builder.layer));
-                }
+                // The clutter dial, applied at build time. A style can only ever
+                // be STRICTER than this: nothing can draw what the tile does not
+                // carry.
+                continue;
             }
-            if (tile.layers.empty())
+
+            const char* layerName =
+                feature.layer[0] == '\0' ? layerFor(feature.renderClass) : feature.layer;
+            if (layerName[0] == '\0')
             {
-                ++stats.emptyTiles;
                 continue;
             }
 
-            auto encoded = mvt::encode(tile);
-            if (!encoded)
+            const WorldBox& box = boxes[index];
+            if (box.minX > box.maxX)
             {
-                return mbtiles::query_error("tile " + std::to_string(z) + "/" +
-                                                std::to_string(key.x) + "/" +
-                                                std::to_string(key.y) + ": " +
-                                                mvt::to_string(encoded.error()),
-                                            0);
+                // No coordinates at all. build() would find nothing left after
+                // simplifying and drop it, so drop it here.
+                ++stats.droppedTooSmall;
+                continue;
             }
-
-            auto compressed = mvt::gzipCompress(*encoded);
-            if (!compressed)
+            const std::uint32_t x0 = clampTile(box.minX);
+            const std::uint32_t x1 = clampTile(box.maxX);
+            const std::uint32_t y0 = clampTile(box.minY);
+            const std::uint32_t y1 = clampTile(box.maxY);
+
+            // Too wide to be drawn whatever simplification does to it, so
+            // dropped here rather than handed to a thousand buckets that would
+            // each simplify it only to drop it -- the one thing here that would
+            // cost more than the serial build did.
+            //
+            // build() drops anything whose SIMPLIFIED box spans over 4096
+            // tiles, and this has to agree with it exactly. For one ring it
+            // does: every point simplification drops lies within half a tile
+            // unit of a segment it keeps, so the simplified box is at most
+            // that much smaller each way, and a box two tiles narrower than
+            // this one is still over. With several rings it does not -- an
+            // outer ring that simplifies away takes its share of the box with
+            // it, and what is left may well be drawn -- so those go to the
+            // buckets and build() decides.
+            if (!feature.isPoint && feature.worldXY.size() == 1)
             {
-                return mbtiles::query_error("gzip failed", 0);
+                const std::uint64_t innerW = x1 - x0 + 1 > 2 ? x1 - x0 - 1 : 0;
+                const std::uint64_t innerH = y1 - y0 + 1 > 2 ? y1 - y0 - 1 : 0;
+                if (innerW * innerH > kMaxTilesPerFeature)
+                {
+                    ++stats.droppedTooWide;
+                    continue;
+                }
             }
 
-            if (auto ok = writer.put(z, key.x, key.y, *compressed); !ok)
+            for (std::uint32_t bx = x0 >> shift; bx <= x1 >> shift; ++bx)
             {
-                return std::unexpected(ok.error());
+                for (std::uint32_t by = y0 >> shift; by <= y1 >> shift; ++by)
+                {
+                    Bucket& bucket = bins[TileKey { bx, by }];
+                    bucket.features.push_back(static_cast<std::uint32_t>(index));
+                    bucket.home.push_back(bx == x0 >> shift && by == y0 >> shift ? 1 : 0);
+                }
             }
+        }
 
-            ++stats.tiles;
-            ++stats.tilesPerZoom[z];
-            stats.bytes += compressed->size();
+        std::vector<Bucket> buckets;
+        buckets.reserve(bins.size());
+        const std::uint32_t lastTile = static_cast<std::uint32_t>(side) - 1;
+        for (auto& [key, bucket] : bins)
+        {
+            bucket.z = z;
+            bucket.x0 = key.x << shift;
+            bucket.y0 = key.y << shift;
+            bucket.x1 = std::min(bucket.x0 + (1U << shift) - 1, lastTile);
+            bucket.y1 = std::min(bucket.y0 + (1U << shift) - 1, lastTile);
+            buckets.push_back(std::move(bucket));
+        }
+        bins.clear();
 
-            if (options.progressEvery != 0 && stats.tiles % options.progressEvery == 0)
-            {
-                SPDLOG_INFO("[tile] z{} -- {} tiles, {} MB", z, stats.tiles,
-                            stats.bytes / (1024 * 1024));
-            }
+        auto done = runInOrder<mbtiles::Result<BuiltBucket>>(
+            buckets.size(), threads, threads * 4,
+            [&](std::size_t i) { return build(buckets[i], options); },
+            [&](mbtiles::Result<BuiltBucket>&& built) -> mbtiles::Result<void> {
+                if (!built)
+                {
+                    return std::unexpected(built.error());
+                }
+
+                for (const BuiltBucket::Encoded& tile : built->tiles)
+                {
+                    if (auto ok = writer.put(z, tile.x, tile.y, tile.data); !ok)
+                    {
+                        return std::unexpected(ok.error());
+                    }
+
+                    ++stats.tiles;
+                    ++stats.tilesPerZoom[z];
+                    stats.bytes += tile.data.size();
+
+                    if (options.progressEvery != 0 && stats.tiles % options.progressEvery == 0)
+                    {
+                        SPDLOG_INFO("[tile] z{} -- {} tiles, {} MB", z, stats.tiles,
+                                    stats.bytes / (1024 * 1024));
+                    }
+                }
+
+                stats.mergedLines += built->stats.mergedLines;
+                stats.emptyTiles += built->stats.emptyTiles;
+                stats.droppedTooSmall += built->stats.droppedTooSmall;
+                stats.droppedTooWide += built->stats.droppedTooWide;
+                for (const auto& [layerName, summary] : built->summaries)
+                {
+                    summaries[layerName].merge(summary);
+                }
+                return {};
+            });
+        if (!done)
+        {
+            return std::unexpected(done.error());
         }
 
-        SPDLOG_INFO("[tile] z{} done: {} tiles", z, stats.tilesPerZoom[z]);
+        SPDLOG_INFO("[tile] z{} done: {} tiles in {} buckets", z, stats.tilesPerZoom[z],
+                    buckets.size());
     }
 
     // Metadata. `format`, `minzoom` and `maxzoom` are what every client reads
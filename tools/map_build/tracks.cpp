@@ -770,8 +770,8 @@ int runTracks(cli::Context& context)
              suppressed);
     cli::out("features   {}\n", tiled.features);
     cli::out("tiles      {}\n", tiled.tiles);
-    cli::out("dropped    {} features too small or too spread out for their zoom\n",
-             tiled.droppedTooSmall);
+    cli::out("dropped    {} features too small for their zoom, {} too wide\n",
+             tiled.droppedTooSmall, tiled.droppedTooWide);
     cli::out("bounds     {:.4f},{:.4f},{:.4f},{:.4f}\n", all.west, all.south, all.east, all.north);
     cli::out("build id   {}\n", catalogue->buildId());
     cli::out("catalogue  {} tracks, {} with a centreline\n", catalogue->tracks().size(),
@@ -14,6 +14,8 @@ namespace map_build
 void addVerifyOptions(cxxopts::Options& options)
 {
     options.add_options()("i,input", "OSM PBF to read.", cxxopts::value<std::string>())(
+        "threads", "Threads decoding the PBF. 0 is one per core.",
+        cxxopts::value<std::uint64_t>()->default_value("0"))(
         "quiet", "No progress lines.", cxxopts::value<bool>()->default_value("false"));
 }
 
@@ -35,6 +37,7 @@ int runVerify(cli::Context& context)
     // print zeros for exactly the things this exists to check -- and look like
     // a clean run.
     options.progressEvery = context.flag("quiet") ? 0 : 2000;
+    options.threads = static_cast<std::size_t>(context.uintOr("threads", 0));
 
     const auto started = std::chrono::steady_clock::now();
     auto stats = extract(